@@ -0,0 +1,976 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "FLAC/all.h"
+#include "private/bitreader.h"
+#include "private/bitwriter.h"
+#include "private/crc.h"
+#include "private/dispatch.h"
+#include "private/frame_header.h"
+#include "private/lpc.h"
+#include "private/md5.h"
+
+// 分阶段的性能测试：在确定的合成语料上分别测比特读取、Rice、LPC、CRC、MD5、帧同步搜索
+// 和端到端的编码/解码(含推模式)，这样某一步变慢不会被其它步骤的波动盖住
+//
+//   flac-bench [-t seconds] [-c case] [-s stage] [-p] [-w dir]
+//
+// MB/s按每一步读入的数据计：bitread/rice/crc是比特流，decode、push和sync是FLAC文件，
+// 其余是PCM(每个样本(bps+7)/8字节)；samples/s把所有声道的样本都算上。
+// 每一步重复到至少-t秒，取最快的一次；第一次的结果会和原信号比对。
+//
+// 退出码：0正常，1有一步结果不对，2参数错误
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BENCH_BLOCKSIZE 4096u
+#define BENCH_BLOCKS 64u
+#define BENCH_RICE_PARTITIONS 16u
+#define BENCH_LPC_ORDER 8u
+#define BENCH_PUSH_CHUNK 1500u   /* bytes per push, about one network packet */
+
+typedef enum {
+    SIGNAL_SWEEP,   /* log sine sweep with 1 LSB of dither */
+    SIGNAL_MUSIC,   /* decaying harmonic notes, panned, with a -60 dB noise floor */
+    SIGNAL_NOISE,   /* full scale white noise, nothing to predict */
+    SIGNAL_PINK,    /* pink noise, partly shared between the channels */
+    SIGNAL_SPARSE,  /* digital silence with a few short clicks */
+    SIGNAL_ALTERNATING  /* full scale at the Nyquist frequency, starting low; at 192k-16-1 the stream ends in a 0xff */
+} SignalType;
+
+static const char * const SignalTypeString[] = {
+    "sweep", "music", "noise", "pink", "sparse", "alternating"
+};
+
+typedef struct {
+    SignalType signal;
+    unsigned sample_rate;
+    unsigned bits_per_sample;
+    unsigned channels;
+} Case;
+
+static const Case cases_[] = {
+    { SIGNAL_SWEEP,    8000,  8, 1 },
+    { SIGNAL_MUSIC,   22050, 12, 1 },
+    { SIGNAL_MUSIC,   44100, 16, 2 },
+    { SIGNAL_NOISE,   44100, 16, 2 },
+    { SIGNAL_SPARSE,  48000, 16, 2 },
+    { SIGNAL_PINK,    48000, 20, 2 },
+    { SIGNAL_ALTERNATING, 192000, 16, 1 },
+    { SIGNAL_MUSIC,   96000, 24, 2 },
+    { SIGNAL_SWEEP,  192000, 24, 2 },
+    { SIGNAL_MUSIC,   48000, 24, 6 },
+    { SIGNAL_PINK,    48000, 16, FLAC__MAX_CHANNELS },
+    { SIGNAL_MUSIC,   96000, FLAC__MAX_BITS_PER_SAMPLE, 2 },
+    { SIGNAL_NOISE,   48000, FLAC__MAX_BITS_PER_SAMPLE, FLAC__MAX_CHANNELS }
+};
+
+/* the predictor of one block of one channel; order 0 means the block is Rice coded as it is */
+typedef struct {
+    FLAC__int32 qlp_coeff[BENCH_LPC_ORDER];
+    unsigned order;
+    int quantization;
+    FLAC__bool narrow_residual;    /* FLAC__lpc_compute_residual_from_qlp_coefficients_table[] can be used */
+    FLAC__bool narrow_restore;     /* FLAC__lpc_restore_signal() can be used */
+} Predictor;
+
+typedef struct {
+    const Case *spec;
+    std::string name;
+    unsigned samples;               /* per channel */
+    size_t pcm_bytes;
+    FLAC__int32 *signal[FLAC__MAX_CHANNELS];
+    FLAC__int32 *residual[FLAC__MAX_CHANNELS];
+    FLAC__int32 *output[FLAC__MAX_CHANNELS];
+    std::vector<FLAC__int32> storage;
+    std::vector<Predictor> predictors;              /* [channel * BENCH_BLOCKS + block] */
+    std::vector<unsigned> rice_parameters;          /* [(channel * BENCH_BLOCKS + block) * BENCH_RICE_PARTITIONS + partition] */
+    std::vector<FLAC__byte> verbatim;               /* every sample in bits_per_sample bits */
+    std::vector<FLAC__byte> rice;                   /* every residual, Rice coded */
+    std::vector<FLAC__byte> encoded;                /* the whole stream, compression level 5 */
+    FLAC__BitReader *reader;
+    const FLAC__Dispatch *dispatch;                 /* the same kernels the decoder picks */
+} CaseData;
+
+typedef enum {
+    INPUT_PCM,
+    INPUT_VERBATIM,
+    INPUT_RICE,
+    INPUT_ENCODED
+} StageInput;
+
+typedef FLAC__bool (*StageFunction)(CaseData *data, FLAC__bool check);
+
+typedef struct {
+    const char *name;
+    StageFunction run;
+    StageInput input;
+} Stage;
+
+typedef struct {
+    double seconds;
+    double bytes;
+    double samples;
+} Total;
+
+/*
+ * The encoder's output in memory. It can seek, so the encoder fills in
+ * the STREAMINFO total and MD5 at the end and the stream is a complete
+ * file, which -w writes out as it is.
+ */
+typedef struct {
+    std::vector<FLAC__byte> *bytes;
+    size_t position;
+} MemoryOutput;
+
+/* what the push stage's frame callback has seen */
+typedef struct {
+    const CaseData *data;
+    FLAC__uint64 position;
+    FLAC__bool check;
+    FLAC__bool ok;
+} PushState;
+
+/***********************************************************************
+ *
+ * Private class method prototypes
+ *
+ ***********************************************************************/
+
+static void usage_(void);
+static double now_(void);
+static FLAC__uint64 seed_(unsigned case_index, unsigned stream);
+static double uniform_(FLAC__uint64 *state);
+static void generate_(const Case *spec, unsigned case_index, unsigned samples, FLAC__int32 * const signal[]);
+static std::string case_name_(const Case *spec);
+static FLAC__bool prepare_(CaseData *data, unsigned case_index);
+static void prepare_predictor_(const FLAC__int32 *signal, unsigned bits_per_sample, Predictor *predictor, FLAC__int32 residual[]);
+static unsigned rice_parameter_(const FLAC__int32 residual[], unsigned n);
+static FLAC__bool encode_(CaseData *data, std::vector<FLAC__byte> *encoded);
+static size_t write_callback_(const void *ptr, size_t size, size_t nmemb, FLAC__IOHandle handle);
+static int seek_callback_(FLAC__IOHandle handle, FLAC__int64 offset, int whence);
+static FLAC__int64 tell_callback_(FLAC__IOHandle handle);
+static FLAC__bool read_callback_(FLAC__byte buffer[], size_t *bytes, void *client_data);
+static void release_(CaseData *data);
+static FLAC__bool stage_bitread_(CaseData *data, FLAC__bool check);
+static FLAC__bool stage_rice_(CaseData *data, FLAC__bool check);
+static FLAC__bool stage_lpc_analysis_(CaseData *data, FLAC__bool check);
+static FLAC__bool stage_lpc_residual_(CaseData *data, FLAC__bool check);
+static FLAC__bool stage_lpc_restore_(CaseData *data, FLAC__bool check);
+static FLAC__bool stage_crc8_(CaseData *data, FLAC__bool check);
+static FLAC__bool stage_crc16_(CaseData *data, FLAC__bool check);
+static FLAC__bool stage_crc32_(CaseData *data, FLAC__bool check);
+static FLAC__bool stage_md5_(CaseData *data, FLAC__bool check);
+static FLAC__bool stage_encode_(CaseData *data, FLAC__bool check);
+static FLAC__bool stage_decode_(CaseData *data, FLAC__bool check);
+static FLAC__bool stage_push_(CaseData *data, FLAC__bool check);
+static FLAC__bool push_callback_(const FLAC__StreamDecoder *decoder, const FLAC__FrameHeader *header, const FLAC__int32 * const buffer[], void *client_data);
+static FLAC__bool stage_sync_(CaseData *data, FLAC__bool check);
+
+/***********************************************************************
+ *
+ * Private class data
+ *
+ ***********************************************************************/
+
+static const Stage stages_[] = {
+    { "bitread",      stage_bitread_,      INPUT_VERBATIM },
+    { "rice",         stage_rice_,         INPUT_RICE },
+    { "lpc-analysis", stage_lpc_analysis_, INPUT_PCM },
+    { "lpc-residual", stage_lpc_residual_, INPUT_PCM },
+    { "lpc-restore",  stage_lpc_restore_,  INPUT_PCM },
+    { "crc8",         stage_crc8_,         INPUT_VERBATIM },
+    { "crc16",        stage_crc16_,        INPUT_VERBATIM },
+    { "crc32",        stage_crc32_,        INPUT_VERBATIM },
+    { "md5",          stage_md5_,          INPUT_PCM },
+    { "encode",       stage_encode_,       INPUT_PCM },
+    { "decode",       stage_decode_,       INPUT_ENCODED },
+    { "push",         stage_push_,         INPUT_ENCODED },
+    { "sync",         stage_sync_,         INPUT_ENCODED }
+};
+
+#define BENCH_STAGES (sizeof(stages_) / sizeof(stages_[0]))
+
+/* keeps the compiler from dropping work whose result nobody looks at */
+static volatile FLAC__uint32 sink_;
+
+/***********************************************************************
+ *
+ * main
+ *
+ ***********************************************************************/
+
+int main(int argc, char **argv)
+{
+    const char *case_filter = 0, *stage_filter = 0, *write_dir = 0;
+    FLAC__bool parseable = false, failed = false;
+    double min_seconds = 0.2;
+    Total totals[BENCH_STAGES];
+    unsigned c, s;
+    int arg;
+
+    for (arg = 1; arg < argc; arg++) {
+        if (strcmp(argv[arg], "-t") == 0 && arg + 1 < argc)
+            min_seconds = atof(argv[++arg]);
+        else if (strcmp(argv[arg], "-c") == 0 && arg + 1 < argc)
+            case_filter = argv[++arg];
+        else if (strcmp(argv[arg], "-s") == 0 && arg + 1 < argc)
+            stage_filter = argv[++arg];
+        else if (strcmp(argv[arg], "-w") == 0 && arg + 1 < argc)
+            write_dir = argv[++arg];
+        else if (strcmp(argv[arg], "-p") == 0)
+            parseable = true;
+        else {
+            usage_();
+            return 2;
+        }
+    }
+    if (min_seconds < 0.0) {
+        usage_();
+        return 2;
+    }
+
+    memset(totals, 0, sizeof(totals));
+    if (parseable)
+        printf("case,stage,bytes,samples,seconds,mb_per_second,samples_per_second\n");
+    else {
+        printf("kernels: %s\n", FLAC__DispatchLevelString[FLAC__dispatch()->level]);
+        printf("%-22s %-13s %10s %14s\n", "case", "stage", "MB/s", "Msamples/s");
+    }
+
+    for (c = 0; c < sizeof(cases_) / sizeof(cases_[0]); c++) {
+        CaseData data;
+
+        if (case_filter != 0 && strstr(case_name_(&cases_[c]).c_str(), case_filter) == 0)
+            continue;
+        if (!prepare_(&data, c)) {
+            fprintf(stderr, "flac-bench: %s: out of memory or cannot encode\n", data.name.c_str());
+            release_(&data);
+            return 1;
+        }
+
+        if (write_dir != 0) {
+            const std::string filename = std::string(write_dir) + "/" + data.name + ".flac";
+            FILE *f = fopen(filename.c_str(), "wb");
+            if (f == 0 || fwrite(data.encoded.data(), 1, data.encoded.size(), f) != data.encoded.size()) {
+                fprintf(stderr, "flac-bench: cannot write %s\n", filename.c_str());
+                if (f != 0)
+                    fclose(f);
+                release_(&data);
+                return 1;
+            }
+            fclose(f);
+        }
+
+        for (s = 0; s < BENCH_STAGES; s++) {
+            const Stage *stage = &stages_[s];
+            const double samples = (double)data.samples * data.spec->channels;
+            double bytes, best = 0.0, start, elapsed, spent = 0.0;
+            unsigned rep;
+
+            if (stage_filter != 0 && strstr(stage->name, stage_filter) == 0)
+                continue;
+
+            switch (stage->input) {
+                case INPUT_VERBATIM: bytes = (double)data.verbatim.size(); break;
+                case INPUT_RICE: bytes = (double)data.rice.size(); break;
+                case INPUT_ENCODED: bytes = (double)data.encoded.size(); break;
+                default: bytes = (double)data.pcm_bytes; break;
+            }
+
+            for (rep = 0; rep == 0 || spent < min_seconds; rep++) {
+                start = now_();
+                if (!stage->run(&data, /*check=*/rep == 0)) {
+                    fprintf(stderr, "flac-bench: %s: %s gave the wrong result\n", data.name.c_str(), stage->name);
+                    failed = true;
+                    break;
+                }
+                elapsed = now_() - start;
+                spent += elapsed;
+                if (rep == 0 || elapsed < best)
+                    best = elapsed;
+            }
+            if (best <= 0.0)
+                continue;
+
+            totals[s].seconds += best;
+            totals[s].bytes += bytes;
+            totals[s].samples += samples;
+            if (parseable)
+                printf("%s,%s,%.0f,%.0f,%.9f,%.3f,%.0f\n", data.name.c_str(), stage->name, bytes, samples, best, bytes / best / 1e6, samples / best);
+            else
+                printf("%-22s %-13s %10.1f %14.2f\n", data.name.c_str(), stage->name, bytes / best / 1e6, samples / best / 1e6);
+            fflush(stdout);
+        }
+        release_(&data);
+    }
+
+    /* every stage over the whole corpus, the number to watch for regressions */
+    for (s = 0; s < BENCH_STAGES; s++) {
+        if (totals[s].seconds <= 0.0)
+            continue;
+        if (parseable)
+            printf("total,%s,%.0f,%.0f,%.9f,%.3f,%.0f\n", stages_[s].name, totals[s].bytes, totals[s].samples, totals[s].seconds, totals[s].bytes / totals[s].seconds / 1e6, totals[s].samples / totals[s].seconds);
+        else
+            printf("%-22s %-13s %10.1f %14.2f\n", "total", stages_[s].name, totals[s].bytes / totals[s].seconds / 1e6, totals[s].samples / totals[s].seconds / 1e6);
+    }
+    return failed ? 1 : 0;
+}
+
+/***********************************************************************
+ *
+ * Private class methods
+ *
+ ***********************************************************************/
+
+void usage_(void)
+{
+    fprintf(stderr,
+        "usage: flac-bench [-t seconds] [-c case] [-s stage] [-p] [-w dir]\n"
+        "  -t seconds  repeat every stage for at least this long and keep the best run (default 0.2)\n"
+        "  -c case     only the cases whose name contains this, e.g. -c 24-2\n"
+        "  -s stage    only the stages whose name contains this, e.g. -s lpc\n"
+        "  -p          print comma separated values\n"
+        "  -w dir      also write the corpus to dir, one .flac file per case\n"
+        "FLAC_CPU_LEVEL=generic|sse2|ssse3|sse4.1|avx2|avx512 caps the kernels the stages run\n");
+}
+
+double now_(void)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* splitmix64 of the case and stream numbers, so a case is the same whatever else runs */
+FLAC__uint64 seed_(unsigned case_index, unsigned stream)
+{
+    FLAC__uint64 z = ((FLAC__uint64)case_index << 32 | stream) + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/* xorshift64*, [0, 1) */
+double uniform_(FLAC__uint64 *state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return (double)((*state * 0x2545F4914F6CDD1Dull) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+void generate_(const Case *spec, unsigned case_index, unsigned samples, FLAC__int32 * const signal[])
+{
+    const double full_scale = (double)(((FLAC__uint64)1 << (spec->bits_per_sample - 1)) - 1);
+    const double rate = (double)spec->sample_rate;
+    const unsigned note_length = spec->sample_rate / 4;
+    FLAC__uint64 common = seed_(case_index, 0), state[FLAC__MAX_CHANNELS];
+    double pink[FLAC__MAX_CHANNELS][3];
+    double phase = 0.0, frequency = 0.0, envelope = 0.0, click = 0.0;
+    unsigned i, c, click_left = 0;
+
+    for (c = 0; c < spec->channels; c++) {
+        state[c] = seed_(case_index, c + 1);
+        pink[c][0] = pink[c][1] = pink[c][2] = 0.0;
+    }
+
+    for (i = 0; i < samples; i++) {
+        double shared = 0.0;
+
+        switch (spec->signal) {
+            case SIGNAL_SWEEP:
+                frequency = 20.0 * pow(rate * 0.45 / 20.0, (double)i / samples);
+                phase += 2.0 * M_PI * frequency / rate;
+                shared = 0.7 * sin(phase);
+                break;
+            case SIGNAL_MUSIC:
+                if (i % note_length == 0) {
+                    frequency = 110.0 * pow(2.0, (double)(unsigned)(uniform_(&common) * 36.0) / 12.0);
+                    envelope = 1.0;
+                }
+                envelope *= 1.0 - 3.0 / rate;
+                phase += 2.0 * M_PI * frequency / rate;
+                shared = envelope * 0.25 * (sin(phase) + 0.5 * sin(2.0 * phase) + 0.25 * sin(3.0 * phase) + 0.125 * sin(5.0 * phase));
+                break;
+            case SIGNAL_SPARSE:
+                if (click_left == 0 && uniform_(&common) < 4.0 / rate) {
+                    click_left = spec->sample_rate / 500;
+                    click = 0.2 + 0.7 * uniform_(&common);
+                    phase = 0.0;
+                }
+                if (click_left > 0) {
+                    click_left--;
+                    phase += 2.0 * M_PI * 3000.0 / rate;
+                    shared = click * sin(phase) * (double)click_left / (spec->sample_rate / 500);
+                }
+                break;
+            case SIGNAL_NOISE:
+            case SIGNAL_ALTERNATING:
+                break;
+            case SIGNAL_PINK:
+                shared = uniform_(&common) * 2.0 - 1.0;
+                break;
+        }
+
+        for (c = 0; c < spec->channels; c++) {
+            const double gain = 1.0 - 0.08 * c;
+            double x, white;
+            FLAC__int64 sample;
+
+            switch (spec->signal) {
+                case SIGNAL_SWEEP:
+                    x = shared * gain * full_scale + (uniform_(&state[c]) * 2.0 - 1.0);
+                    break;
+                case SIGNAL_MUSIC:
+                    x = (shared * gain + 0.001 * (uniform_(&state[c]) * 2.0 - 1.0)) * full_scale;
+                    break;
+                case SIGNAL_NOISE:
+                    x = 0.9 * (uniform_(&state[c]) * 2.0 - 1.0) * full_scale;
+                    break;
+                case SIGNAL_PINK:
+                    /* Paul Kellet's economy filter */
+                    white = 0.5 * shared + 0.5 * (uniform_(&state[c]) * 2.0 - 1.0);
+                    pink[c][0] = 0.99765 * pink[c][0] + white * 0.0990460;
+                    pink[c][1] = 0.96300 * pink[c][1] + white * 0.2965164;
+                    pink[c][2] = 0.57000 * pink[c][2] + white * 1.0526913;
+                    x = 0.2 * (pink[c][0] + pink[c][1] + pink[c][2] + white * 0.1848) * full_scale;
+                    break;
+                case SIGNAL_ALTERNATING:
+                    x = (i & 1) ? full_scale : -full_scale - 1.0;
+                    break;
+                default:
+                    x = shared * gain * full_scale;
+                    break;
+            }
+            sample = (FLAC__int64)floor(x + 0.5);
+            if (sample > (FLAC__int64)full_scale)
+                sample = (FLAC__int64)full_scale;
+            else if (sample < -(FLAC__int64)full_scale - 1)
+                sample = -(FLAC__int64)full_scale - 1;
+            signal[c][i] = (FLAC__int32)sample;
+        }
+    }
+}
+
+/* e.g. music-44k-16-2 */
+std::string case_name_(const Case *spec)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%s-%uk-%u-%u", SignalTypeString[spec->signal], (spec->sample_rate + 500) / 1000, spec->bits_per_sample, spec->channels);
+    return name;
+}
+
+FLAC__bool prepare_(CaseData *data, unsigned case_index)
+{
+    const Case *spec = &cases_[case_index];
+    FLAC__BitWriter *bw;
+    const FLAC__byte *buffer;
+    size_t bytes;
+    unsigned c, b, p, i;
+
+    data->spec = spec;
+    data->name = case_name_(spec);
+    data->samples = BENCH_BLOCKSIZE * BENCH_BLOCKS;
+    data->pcm_bytes = (size_t)data->samples * spec->channels * ((spec->bits_per_sample + 7) / 8);
+    data->reader = 0;
+
+    data->dispatch = FLAC__dispatch();
+
+    data->storage.assign((size_t)data->samples * spec->channels * 3, 0);
+    for (c = 0; c < spec->channels; c++) {
+        data->signal[c] = data->storage.data() + (size_t)data->samples * (3 * c);
+        data->residual[c] = data->signal[c] + data->samples;
+        data->output[c] = data->residual[c] + data->samples;
+    }
+    generate_(spec, case_index, data->samples, data->signal);
+
+    data->predictors.resize((size_t)spec->channels * BENCH_BLOCKS);
+    data->rice_parameters.resize(data->predictors.size() * BENCH_RICE_PARTITIONS);
+    for (c = 0; c < spec->channels; c++) {
+        for (b = 0; b < BENCH_BLOCKS; b++) {
+            const FLAC__int32 *signal = data->signal[c] + b * BENCH_BLOCKSIZE;
+            FLAC__int32 *residual = data->residual[c] + b * BENCH_BLOCKSIZE;
+            Predictor *predictor = &data->predictors[c * BENCH_BLOCKS + b];
+
+            prepare_predictor_(signal, spec->bits_per_sample, predictor, residual);
+            for (i = 0; i < predictor->order; i++)
+                residual[i] = 0;
+            for (p = 0; p < BENCH_RICE_PARTITIONS; p++) {
+                const unsigned start = p == 0 ? predictor->order : p * (BENCH_BLOCKSIZE / BENCH_RICE_PARTITIONS);
+                data->rice_parameters[(c * BENCH_BLOCKS + b) * BENCH_RICE_PARTITIONS + p] = rice_parameter_(residual + start, (p + 1) * (BENCH_BLOCKSIZE / BENCH_RICE_PARTITIONS) - start);
+            }
+        }
+    }
+
+    bw = FLAC__bitwriter_new();
+    if (bw == 0 || !FLAC__bitwriter_init(bw, data->pcm_bytes + 1024)) {
+        FLAC__bitwriter_delete(bw);
+        return false;
+    }
+    for (c = 0; c < spec->channels; c++)
+        for (i = 0; i < data->samples; i++)
+            if (!FLAC__bitwriter_write_raw_uint32(bw, (FLAC__uint32)data->signal[c][i] & (0xffffffffu >> (32 - spec->bits_per_sample)), spec->bits_per_sample))
+                break;
+    if (!FLAC__bitwriter_zero_pad_to_byte_boundary(bw) || !FLAC__bitwriter_get_buffer(bw, &buffer, &bytes)) {
+        FLAC__bitwriter_delete(bw);
+        return false;
+    }
+    data->verbatim.assign(buffer, buffer + bytes);
+
+    FLAC__bitwriter_clear(bw);
+    for (c = 0; c < spec->channels; c++) {
+        for (b = 0; b < BENCH_BLOCKS; b++) {
+            const unsigned order = data->predictors[c * BENCH_BLOCKS + b].order;
+            for (p = 0; p < BENCH_RICE_PARTITIONS; p++) {
+                const unsigned start = b * BENCH_BLOCKSIZE + (p == 0 ? order : p * (BENCH_BLOCKSIZE / BENCH_RICE_PARTITIONS));
+                const unsigned end = b * BENCH_BLOCKSIZE + (p + 1) * (BENCH_BLOCKSIZE / BENCH_RICE_PARTITIONS);
+                if (!FLAC__bitwriter_write_rice_signed_block(bw, data->residual[c] + start, end - start, data->rice_parameters[(c * BENCH_BLOCKS + b) * BENCH_RICE_PARTITIONS + p]))
+                    break;
+            }
+        }
+    }
+    if (!FLAC__bitwriter_zero_pad_to_byte_boundary(bw) || !FLAC__bitwriter_get_buffer(bw, &buffer, &bytes)) {
+        FLAC__bitwriter_delete(bw);
+        return false;
+    }
+    data->rice.assign(buffer, buffer + bytes);
+    FLAC__bitwriter_delete(bw);
+
+    data->reader = FLAC__bitreader_new();
+    if (data->reader == 0 || !FLAC__bitreader_init(data->reader, read_callback_, /*client_data=*/0))
+        return false;
+
+    return encode_(data, &data->encoded);
+}
+
+/* what a simple encoder would do: Hann window, fixed order, and a 32-bit residual whenever it fits */
+void prepare_predictor_(const FLAC__int32 *signal, unsigned bits_per_sample, Predictor *predictor, FLAC__int32 residual[])
+{
+    FLAC__real window[BENCH_BLOCKSIZE], windowed[BENCH_BLOCKSIZE];
+    double autoc[BENCH_LPC_ORDER + 1], lp_coeff[FLAC__MAX_LPC_ORDER][FLAC__MAX_LPC_ORDER], error[FLAC__MAX_LPC_ORDER];
+    const unsigned precision = bits_per_sample <= 16 ? 12 : FLAC__MAX_QLP_COEFF_PRECISION;
+    unsigned i, order = BENCH_LPC_ORDER;
+
+    memset(predictor, 0, sizeof(*predictor));
+    for (i = 0; i < BENCH_BLOCKSIZE; i++)
+        window[i] = (FLAC__real)(0.5 - 0.5 * cos(2.0 * M_PI * i / (BENCH_BLOCKSIZE - 1)));
+    FLAC__lpc_window_data(signal, window, windowed, BENCH_BLOCKSIZE);
+    FLAC__dispatch()->lpc_compute_autocorrelation(windowed, BENCH_BLOCKSIZE, BENCH_LPC_ORDER + 1, autoc);
+    if (autoc[0] != 0.0) {
+        FLAC__lpc_compute_lp_coefficients(autoc, &order, lp_coeff, error);
+        if (FLAC__lpc_quantize_coefficients(lp_coeff[order - 1], order, precision, predictor->qlp_coeff, &predictor->quantization) == 0) {
+            predictor->order = order;
+            predictor->narrow_restore = FLAC__lpc_max_prediction_before_shift_bps(bits_per_sample, predictor->qlp_coeff, order) <= 32;
+            predictor->narrow_residual = predictor->narrow_restore && FLAC__lpc_max_residual_bps(bits_per_sample, predictor->qlp_coeff, order, predictor->quantization) <= 32;
+            if (predictor->narrow_residual)
+                FLAC__lpc_compute_residual_from_qlp_coefficients(signal + order, BENCH_BLOCKSIZE - order, predictor->qlp_coeff, order, predictor->quantization, residual + order);
+            else if (!FLAC__lpc_compute_residual_from_qlp_coefficients_limit_residual(signal + order, BENCH_BLOCKSIZE - order, predictor->qlp_coeff, order, predictor->quantization, residual + order))
+                predictor->order = 0;
+        }
+    }
+    if (predictor->order == 0)
+        memcpy(residual, signal, sizeof(FLAC__int32) * BENCH_BLOCKSIZE);
+}
+
+/* the parameter the mean of the folded residual asks for */
+unsigned rice_parameter_(const FLAC__int32 residual[], unsigned n)
+{
+    FLAC__uint64 sum = 0;
+    unsigned i, parameter = 0;
+
+    for (i = 0; i < n; i++)
+        sum += ((FLAC__uint32)residual[i] << 1) ^ (FLAC__uint32)(residual[i] >> 31);
+    while (parameter < FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2_ESCAPE_PARAMETER - 1 && ((FLAC__uint64)n << (parameter + 1)) < sum)
+        parameter++;
+    return parameter;
+}
+
+FLAC__bool encode_(CaseData *data, std::vector<FLAC__byte> *encoded)
+{
+    FLAC__StreamEncoder *encoder = FLAC__stream_encoder_new();
+    FLAC__IOCallbacks callbacks;
+    MemoryOutput output;
+    FLAC__bool ok;
+
+    if (encoder == 0)
+        return false;
+    memset(&callbacks, 0, sizeof(callbacks));
+    callbacks.write = write_callback_;
+    callbacks.seek = seek_callback_;
+    callbacks.tell = tell_callback_;
+    encoded->clear();
+    output.bytes = encoded;
+    output.position = 0;
+
+    ok =
+        FLAC__stream_encoder_set_channels(encoder, data->spec->channels) &&
+        FLAC__stream_encoder_set_bits_per_sample(encoder, data->spec->bits_per_sample) &&
+        FLAC__stream_encoder_set_sample_rate(encoder, data->spec->sample_rate) &&
+        FLAC__stream_encoder_set_compression_level(encoder, 5) &&
+        FLAC__stream_encoder_init(encoder, &output, callbacks) == FLAC__STREAM_ENCODER_INIT_STATUS_OK;
+    ok = ok && FLAC__stream_encoder_process(encoder, data->signal, data->samples);
+    ok = FLAC__stream_encoder_finish(encoder) && ok;
+    FLAC__stream_encoder_delete(encoder);
+    return ok;
+}
+
+size_t write_callback_(const void *ptr, size_t size, size_t nmemb, FLAC__IOHandle handle)
+{
+    MemoryOutput *output = (MemoryOutput*)handle;
+    const size_t bytes = size * nmemb;
+
+    if (output->position + bytes > output->bytes->size())
+        output->bytes->resize(output->position + bytes);
+    memcpy(output->bytes->data() + output->position, ptr, bytes);
+    output->position += bytes;
+    return nmemb;
+}
+
+int seek_callback_(FLAC__IOHandle handle, FLAC__int64 offset, int whence)
+{
+    MemoryOutput *output = (MemoryOutput*)handle;
+    FLAC__int64 position;
+
+    switch (whence) {
+        case SEEK_SET: position = offset; break;
+        case SEEK_CUR: position = (FLAC__int64)output->position + offset; break;
+        case SEEK_END: position = (FLAC__int64)output->bytes->size() + offset; break;
+        default: return -1;
+    }
+    if (position < 0 || (FLAC__uint64)position > output->bytes->size())
+        return -1;
+    output->position = (size_t)position;
+    return 0;
+}
+
+FLAC__int64 tell_callback_(FLAC__IOHandle handle)
+{
+    return (FLAC__int64)((MemoryOutput*)handle)->position;
+}
+
+/* everything is in memory, running out of it is the end of the stream */
+FLAC__bool read_callback_(FLAC__byte buffer[], size_t *bytes, void *client_data)
+{
+    (void)buffer, (void)client_data;
+    *bytes = 0;
+    return false;
+}
+
+void release_(CaseData *data)
+{
+    if (data->reader != 0)
+        FLAC__bitreader_delete(data->reader);
+    data->reader = 0;
+}
+
+FLAC__bool stage_bitread_(CaseData *data, FLAC__bool check)
+{
+    const unsigned bits_per_sample = data->spec->bits_per_sample;
+    const unsigned shift = 32 - bits_per_sample;
+    FLAC__uint32 x, sum = 0;
+    unsigned c, i;
+
+    FLAC__bitreader_clear(data->reader);
+    FLAC__bitreader_set_source(data->reader, data->verbatim.data(), data->verbatim.size());
+    for (c = 0; c < data->spec->channels; c++) {
+        for (i = 0; i < data->samples; i++) {
+            if (!FLAC__bitreader_read_raw_uint32(data->reader, &x, bits_per_sample))
+                return false;
+            if (check && (FLAC__int32)(x << shift) >> shift != data->signal[c][i])
+                return false;
+            sum += x;
+        }
+    }
+    sink_ = sum;
+    return true;
+}
+
+FLAC__bool stage_rice_(CaseData *data, FLAC__bool check)
+{
+    unsigned c, b, p, i;
+
+    FLAC__bitreader_clear(data->reader);
+    FLAC__bitreader_set_source(data->reader, data->rice.data(), data->rice.size());
+    for (c = 0; c < data->spec->channels; c++) {
+        for (b = 0; b < BENCH_BLOCKS; b++) {
+            const unsigned order = data->predictors[c * BENCH_BLOCKS + b].order;
+            for (p = 0; p < BENCH_RICE_PARTITIONS; p++) {
+                const unsigned start = b * BENCH_BLOCKSIZE + (p == 0 ? order : p * (BENCH_BLOCKSIZE / BENCH_RICE_PARTITIONS));
+                const unsigned end = b * BENCH_BLOCKSIZE + (p + 1) * (BENCH_BLOCKSIZE / BENCH_RICE_PARTITIONS);
+                if (!data->dispatch->bitreader_read_rice_signed_block(data->reader, data->output[c] + start, end - start, data->rice_parameters[(c * BENCH_BLOCKS + b) * BENCH_RICE_PARTITIONS + p]))
+                    return false;
+                if (check) {
+                    for (i = start; i < end; i++)
+                        if (data->output[c][i] != data->residual[c][i])
+                            return false;
+                }
+            }
+        }
+    }
+    sink_ = (FLAC__uint32)data->output[0][data->samples - 1];
+    return true;
+}
+
+FLAC__bool stage_lpc_analysis_(CaseData *data, FLAC__bool check)
+{
+    FLAC__real window[BENCH_BLOCKSIZE], windowed[BENCH_BLOCKSIZE];
+    double autoc[BENCH_LPC_ORDER + 1], lp_coeff[FLAC__MAX_LPC_ORDER][FLAC__MAX_LPC_ORDER], error[FLAC__MAX_LPC_ORDER];
+    FLAC__int32 qlp_coeff[FLAC__MAX_LPC_ORDER];
+    const unsigned precision = data->spec->bits_per_sample <= 16 ? 12 : FLAC__MAX_QLP_COEFF_PRECISION;
+    FLAC__uint32 sum = 0;
+    unsigned c, b, i, order;
+    int quantization;
+
+    (void)check;
+    for (i = 0; i < BENCH_BLOCKSIZE; i++)
+        window[i] = (FLAC__real)(0.5 - 0.5 * cos(2.0 * M_PI * i / (BENCH_BLOCKSIZE - 1)));
+    for (c = 0; c < data->spec->channels; c++) {
+        for (b = 0; b < BENCH_BLOCKS; b++) {
+            FLAC__lpc_window_data(data->signal[c] + b * BENCH_BLOCKSIZE, window, windowed, BENCH_BLOCKSIZE);
+            data->dispatch->lpc_compute_autocorrelation(windowed, BENCH_BLOCKSIZE, BENCH_LPC_ORDER + 1, autoc);
+            if (autoc[0] == 0.0)
+                continue;
+            order = BENCH_LPC_ORDER;
+            FLAC__lpc_compute_lp_coefficients(autoc, &order, lp_coeff, error);
+            if (FLAC__lpc_quantize_coefficients(lp_coeff[order - 1], order, precision, qlp_coeff, &quantization) == 0)
+                sum += (FLAC__uint32)qlp_coeff[0];
+        }
+    }
+    sink_ = sum;
+    return true;
+}
+
+FLAC__bool stage_lpc_residual_(CaseData *data, FLAC__bool check)
+{
+    unsigned c, b, i;
+
+    for (c = 0; c < data->spec->channels; c++) {
+        for (b = 0; b < BENCH_BLOCKS; b++) {
+            const Predictor *predictor = &data->predictors[c * BENCH_BLOCKS + b];
+            const unsigned order = predictor->order;
+            const FLAC__int32 *signal = data->signal[c] + b * BENCH_BLOCKSIZE;
+            FLAC__int32 *residual = data->output[c] + b * BENCH_BLOCKSIZE;
+
+            if (order == 0)
+                continue;
+            if (!predictor->narrow_residual) {
+                if (!FLAC__lpc_compute_residual_from_qlp_coefficients_limit_residual(signal + order, BENCH_BLOCKSIZE - order, predictor->qlp_coeff, order, predictor->quantization, residual + order))
+                    return false;
+            }
+            else
+                FLAC__lpc_compute_residual_from_qlp_coefficients_table[order](signal + order, BENCH_BLOCKSIZE - order, predictor->qlp_coeff, predictor->quantization, residual + order);
+            if (check) {
+                for (i = order; i < BENCH_BLOCKSIZE; i++)
+                    if (residual[i] != data->residual[c][b * BENCH_BLOCKSIZE + i])
+                        return false;
+            }
+        }
+    }
+    sink_ = (FLAC__uint32)data->output[0][data->samples - 1];
+    return true;
+}
+
+FLAC__bool stage_lpc_restore_(CaseData *data, FLAC__bool check)
+{
+    unsigned c, b, i;
+
+    for (c = 0; c < data->spec->channels; c++) {
+        for (b = 0; b < BENCH_BLOCKS; b++) {
+            const Predictor *predictor = &data->predictors[c * BENCH_BLOCKS + b];
+            const unsigned order = predictor->order;
+            const FLAC__int32 *residual = data->residual[c] + b * BENCH_BLOCKSIZE;
+            FLAC__int32 *out = data->output[c] + b * BENCH_BLOCKSIZE;
+
+            if (order == 0)
+                continue;
+            for (i = 0; i < order; i++)
+                out[i] = data->signal[c][b * BENCH_BLOCKSIZE + i];
+            if (predictor->narrow_restore)
+                data->dispatch->lpc_restore_signal(residual + order, BENCH_BLOCKSIZE - order, predictor->qlp_coeff, order, predictor->quantization, out + order);
+            else
+                data->dispatch->lpc_restore_signal_wide(residual + order, BENCH_BLOCKSIZE - order, predictor->qlp_coeff, order, predictor->quantization, out + order);
+            if (check) {
+                for (i = order; i < BENCH_BLOCKSIZE; i++)
+                    if (out[i] != data->signal[c][b * BENCH_BLOCKSIZE + i])
+                        return false;
+            }
+        }
+    }
+    sink_ = (FLAC__uint32)data->output[0][data->samples - 1];
+    return true;
+}
+
+FLAC__bool stage_crc8_(CaseData *data, FLAC__bool check)
+{
+    (void)check;
+    sink_ = FLAC__crc8(data->verbatim.data(), (unsigned)data->verbatim.size());
+    return true;
+}
+
+FLAC__bool stage_crc16_(CaseData *data, FLAC__bool check)
+{
+    (void)check;
+    sink_ = data->dispatch->crc16_update_block(data->verbatim.data(), data->verbatim.size(), 0);
+    return true;
+}
+
+FLAC__bool stage_crc32_(CaseData *data, FLAC__bool check)
+{
+    (void)check;
+    sink_ = data->dispatch->crc32_update_block(data->verbatim.data(), data->verbatim.size(), 0);
+    return true;
+}
+
+/* a frame's worth at a time, as the decoder feeds it */
+FLAC__bool stage_md5_(CaseData *data, FLAC__bool check)
+{
+    const FLAC__int32 *signal[FLAC__MAX_CHANNELS];
+    FLAC__MD5Context ctx;
+    FLAC__byte digest[16];
+    unsigned c, b;
+
+    (void)check;
+    FLAC__MD5Init(&ctx);
+    for (b = 0; b < BENCH_BLOCKS; b++) {
+        for (c = 0; c < data->spec->channels; c++)
+            signal[c] = data->signal[c] + b * BENCH_BLOCKSIZE;
+        if (!FLAC__MD5Accumulate(&ctx, signal, data->spec->channels, BENCH_BLOCKSIZE, (data->spec->bits_per_sample + 7) / 8)) {
+            FLAC__MD5Final(digest, &ctx);
+            return false;
+        }
+    }
+    FLAC__MD5Final(digest, &ctx);
+    sink_ = digest[0];
+    return true;
+}
+
+FLAC__bool stage_encode_(CaseData *data, FLAC__bool check)
+{
+    std::vector<FLAC__byte> encoded;
+
+    encoded.reserve(data->encoded.size());
+    if (!encode_(data, &encoded))
+        return false;
+    return !check || encoded == data->encoded;
+}
+
+FLAC__bool stage_decode_(CaseData *data, FLAC__bool check)
+{
+    FLAC__StreamDecoder *decoder = FLAC__stream_decoder_new();
+    FLAC__int32 *buffer[FLAC__MAX_CHANNELS];
+    FLAC__FrameHeader header;
+    FLAC__uint64 position = 0;
+    FLAC__bool ok;
+    unsigned c, i;
+
+    if (decoder == 0)
+        return false;
+    for (c = 0; c < data->spec->channels; c++)
+        buffer[c] = data->output[c];
+
+    ok =
+        FLAC__stream_decoder_init_memory(decoder, data->encoded.data(), data->encoded.size()) == FLAC__STREAM_DECODER_INIT_STATUS_OK &&
+        FLAC__stream_decoder_process_until_end_of_metadata(decoder);
+    while (ok && FLAC__stream_decoder_decode_frame(decoder, buffer, data->samples, &header)) {
+        if (position + header.blocksize > data->samples) {
+            ok = false;
+            break;
+        }
+        if (check) {
+            for (c = 0; c < data->spec->channels; c++)
+                for (i = 0; i < header.blocksize; i++)
+                    if (buffer[c][i] != data->signal[c][position + i])
+                        ok = false;
+        }
+        position += header.blocksize;
+    }
+    FLAC__stream_decoder_delete(decoder);
+    return ok && position == data->samples;
+}
+
+/* the stream a packet at a time, as from a socket; every sample has to come out by the end */
+FLAC__bool stage_push_(CaseData *data, FLAC__bool check)
+{
+    FLAC__StreamDecoder *decoder = FLAC__stream_decoder_new();
+    PushState state;
+    size_t p, n;
+    FLAC__bool ok;
+
+    if (decoder == 0)
+        return false;
+    state.data = data;
+    state.position = 0;
+    state.check = check;
+    state.ok = true;
+
+    ok = FLAC__stream_decoder_init_push(decoder, push_callback_, &state) == FLAC__STREAM_DECODER_INIT_STATUS_OK;
+    for (p = 0; ok && p < data->encoded.size(); p += n) {
+        n = data->encoded.size() - p < BENCH_PUSH_CHUNK ? data->encoded.size() - p : BENCH_PUSH_CHUNK;
+        ok = FLAC__stream_decoder_push(decoder, data->encoded.data() + p, n);
+    }
+    ok = ok && FLAC__stream_decoder_push_end_of_stream(decoder);
+    FLAC__stream_decoder_delete(decoder);
+    return ok && state.ok && state.position == data->samples;
+}
+
+FLAC__bool push_callback_(const FLAC__StreamDecoder *decoder, const FLAC__FrameHeader *header, const FLAC__int32 * const buffer[], void *client_data)
+{
+    PushState *state = (PushState*)client_data;
+    const CaseData *data = state->data;
+    unsigned c, i;
+
+    (void)decoder;
+    if (state->position + header->blocksize > data->samples) {
+        state->ok = false;
+        return false;
+    }
+    if (state->check) {
+        for (c = 0; c < data->spec->channels; c++)
+            for (i = 0; i < header->blocksize; i++)
+                if (buffer[c][i] != data->signal[c][state->position + i])
+                    state->ok = false;
+    }
+    state->position += header->blocksize;
+    return true;
+}
+
+/*
+ * Every frame header in the stream, found the way resync and the
+ * parallel decoder find them: the sync search, then a header parse with
+ * its CRC-8 for each candidate. The check holds the search against the
+ * C version at every candidate.
+ */
+FLAC__bool stage_sync_(CaseData *data, FLAC__bool check)
+{
+    const FLAC__byte *b = data->encoded.data();
+    const size_t bytes = data->encoded.size();
+    FLAC__StreamMetadata_StreamInfo stream_info;
+    FLAC__FrameHeader header;
+    unsigned header_length, frames = 0;
+    size_t p, next;
+
+    memset(&stream_info, 0, sizeof(stream_info));
+    stream_info.min_blocksize = stream_info.max_blocksize = BENCH_BLOCKSIZE;
+    stream_info.sample_rate = data->spec->sample_rate;
+    stream_info.channels = data->spec->channels;
+    stream_info.bits_per_sample = data->spec->bits_per_sample;
+    stream_info.total_samples = data->samples;
+
+    for (p = 0; p < bytes; p = next + 1) {
+        next = p + data->dispatch->frame_header_find_sync(b + p, bytes - p);
+        if (check && next != p + FLAC__frame_header_find_sync(b + p, bytes - p))
+            return false;
+        if (next == bytes)
+            break;
+        if (FLAC__frame_header_parse(b + next, bytes - next, &stream_info, &header, &header_length) == FLAC__FRAME_HEADER_PARSE_OK)
+            frames++;
+    }
+    sink_ = frames;
+    /* a sync code in the audio can pass for a header, a frame can't be missed */
+    return !check || frames >= (data->samples + BENCH_BLOCKSIZE - 1) / BENCH_BLOCKSIZE;
+}
@@ -0,0 +1,48 @@
+#include <stdint.h>
+#include "FLAC/stream_decoder.h"
+#include "fuzz_io.h"
+
+// 原生FLAC流的解码：第一个字节选入口，其余是流
+//   bit0  0从内存解码(FLAC__stream_decoder_init_memory)，1走读回调
+//   bit1  1输出交错的PCM，位深由bit2..3选(8/16/24/32)
+
+static FLAC__int32 output_[FLAC__MAX_CHANNELS][FLAC__MAX_BLOCK_SIZE];
+static FLAC__byte pcm_[FLAC__MAX_CHANNELS * FLAC__MAX_BLOCK_SIZE * 4];
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    FLAC__int32 * const buffer[FLAC__MAX_CHANNELS] = { output_[0], output_[1], output_[2], output_[3], output_[4], output_[5], output_[6], output_[7] };
+    FLAC__StreamDecoder *decoder;
+    FLAC__StreamDecoderInitStatus status;
+    FuzzStream stream;
+    FLAC__byte mode;
+
+    if (size < 1)
+        return 0;
+    mode = data[0];
+    data++;
+    size--;
+
+    decoder = FLAC__stream_decoder_new();
+    if (decoder == 0)
+        return 0;
+    fuzz_stream_init_(&stream, data, size);
+    if (mode & 1)
+        status = FLAC__stream_decoder_init(decoder, &stream, fuzz_callbacks_());
+    else
+        status = FLAC__stream_decoder_init_memory(decoder, data, size);
+    if (status == FLAC__STREAM_DECODER_INIT_STATUS_OK) {
+        if (mode & 2) {
+            const unsigned bits_per_sample = 8 * (((mode >> 2) & 3) + 1);
+            while (FLAC__stream_decoder_decode_frame_interleaved(decoder, bits_per_sample, pcm_, FLAC__MAX_BLOCK_SIZE, 0))
+                ;
+        }
+        else {
+            while (FLAC__stream_decoder_decode_frame(decoder, buffer, FLAC__MAX_BLOCK_SIZE, 0))
+                ;
+        }
+    }
+    FLAC__stream_decoder_finish(decoder);
+    FLAC__stream_decoder_delete(decoder);
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include <stdint.h>
+#include <string.h>
+#include "FLAC/stream_decoder.h"
+
+// 没有metadata的帧(FLAC__stream_decoder_init_memory_frames)：第一个字节的
+// bit0为1时，接下来的12个字节按STREAMINFO各字段的位宽拼出传入的stream info，
+// 否则传NULL；其余是帧
+
+#define STREAM_INFO_BYTES 12u
+
+static FLAC__int32 output_[FLAC__MAX_CHANNELS][FLAC__MAX_BLOCK_SIZE];
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    FLAC__int32 * const buffer[FLAC__MAX_CHANNELS] = { output_[0], output_[1], output_[2], output_[3], output_[4], output_[5], output_[6], output_[7] };
+    FLAC__StreamMetadata_StreamInfo stream_info;
+    FLAC__StreamDecoder *decoder;
+    FLAC__bool have_stream_info;
+
+    if (size < 1)
+        return 0;
+    have_stream_info = data[0] & 1;
+    data++;
+    size--;
+
+    memset(&stream_info, 0, sizeof(stream_info));
+    if (have_stream_info) {
+        if (size < STREAM_INFO_BYTES)
+            return 0;
+        stream_info.min_blocksize = ((unsigned)data[0] << 8) | data[1];
+        stream_info.max_blocksize = ((unsigned)data[2] << 8) | data[3];
+        stream_info.sample_rate = ((unsigned)data[4] << 12) | ((unsigned)data[5] << 4) | (data[6] >> 4);
+        stream_info.channels = ((data[6] >> 1) & 7) + 1;
+        stream_info.bits_per_sample = (((unsigned)(data[6] & 1) << 4) | (data[7] >> 4)) + 1;
+        stream_info.total_samples = ((FLAC__uint64)(data[7] & 15) << 32) | ((FLAC__uint64)data[8] << 24) | ((FLAC__uint64)data[9] << 16) | ((FLAC__uint64)data[10] << 8) | data[11];
+        data += STREAM_INFO_BYTES;
+        size -= STREAM_INFO_BYTES;
+    }
+
+    decoder = FLAC__stream_decoder_new();
+    if (decoder == 0)
+        return 0;
+    if (FLAC__stream_decoder_init_memory_frames(decoder, have_stream_info ? &stream_info : 0, data, size) == FLAC__STREAM_DECODER_INIT_STATUS_OK) {
+        while (FLAC__stream_decoder_decode_frame(decoder, buffer, FLAC__MAX_BLOCK_SIZE, 0))
+            ;
+    }
+    FLAC__stream_decoder_finish(decoder);
+    FLAC__stream_decoder_delete(decoder);
+    return 0;
+}
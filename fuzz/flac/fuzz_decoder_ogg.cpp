@@ -0,0 +1,38 @@
+#include <stdint.h>
+#include "FLAC/stream_decoder.h"
+#include "fuzz_io.h"
+
+// Ogg FLAC的解码：第一个字节的bit0选入口，0从内存解码，1走读回调
+
+static FLAC__int32 output_[FLAC__MAX_CHANNELS][FLAC__MAX_BLOCK_SIZE];
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    FLAC__int32 * const buffer[FLAC__MAX_CHANNELS] = { output_[0], output_[1], output_[2], output_[3], output_[4], output_[5], output_[6], output_[7] };
+    FLAC__StreamDecoder *decoder;
+    FLAC__StreamDecoderInitStatus status;
+    FuzzStream stream;
+    FLAC__byte mode;
+
+    if (size < 1)
+        return 0;
+    mode = data[0];
+    data++;
+    size--;
+
+    decoder = FLAC__stream_decoder_new();
+    if (decoder == 0)
+        return 0;
+    fuzz_stream_init_(&stream, data, size);
+    if (mode & 1)
+        status = FLAC__stream_decoder_init_ogg(decoder, &stream, fuzz_callbacks_());
+    else
+        status = FLAC__stream_decoder_init_ogg_memory(decoder, data, size);
+    if (status == FLAC__STREAM_DECODER_INIT_STATUS_OK) {
+        while (FLAC__stream_decoder_decode_frame(decoder, buffer, FLAC__MAX_BLOCK_SIZE, 0))
+            ;
+    }
+    FLAC__stream_decoder_finish(decoder);
+    FLAC__stream_decoder_delete(decoder);
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <stdint.h>
+#include "FLAC/stream_decoder.h"
+
+// 推模式的解码：第一个字节定每次推入的字节数(1..256)，其余是流，
+// 这样帧和metadata会在各种位置被切开
+
+static FLAC__bool frame_callback_(const FLAC__StreamDecoder *decoder, const FLAC__FrameHeader *header, const FLAC__int32 * const buffer[], void *client_data)
+{
+    volatile FLAC__uint32 sum = 0;
+    unsigned channel;
+
+    (void)decoder;
+    (void)client_data;
+
+    /* touch every sample, so a short buffer shows up under the address sanitizer */
+    for (channel = 0; channel < header->channels; channel++)
+        sum += (FLAC__uint32)buffer[channel][0] + (FLAC__uint32)buffer[channel][header->blocksize - 1];
+    return true;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    FLAC__StreamDecoder *decoder;
+    size_t chunk, n;
+
+    if (size < 1)
+        return 0;
+    chunk = (size_t)data[0] + 1;
+    data++;
+    size--;
+
+    decoder = FLAC__stream_decoder_new();
+    if (decoder == 0)
+        return 0;
+    if (FLAC__stream_decoder_init_push(decoder, frame_callback_, 0) == FLAC__STREAM_DECODER_INIT_STATUS_OK) {
+        for ( ; size > 0; data += n, size -= n) {
+            n = size < chunk ? size : chunk;
+            if (!FLAC__stream_decoder_push(decoder, data, n))
+                break;
+        }
+        if (size == 0)
+            (void)FLAC__stream_decoder_push_end_of_stream(decoder);
+    }
+    FLAC__stream_decoder_finish(decoder);
+    FLAC__stream_decoder_delete(decoder);
+    return 0;
+}
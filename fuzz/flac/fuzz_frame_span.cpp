@@ -0,0 +1,31 @@
+#include <stdint.h>
+#include "FLAC/mapped_file.h"
+#include "FLAC/stream_decoder.h"
+
+// 帧的切分(FLAC__FrameSpanIterator)：把输入切成帧，每一帧再单独解码一遍，
+// 和并行解码切块的用法一样
+
+static FLAC__int32 output_[FLAC__MAX_CHANNELS][FLAC__MAX_BLOCK_SIZE];
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    FLAC__int32 * const buffer[FLAC__MAX_CHANNELS] = { output_[0], output_[1], output_[2], output_[3], output_[4], output_[5], output_[6], output_[7] };
+    FLAC__FrameSpanIterator *iterator;
+    FLAC__StreamDecoder *decoder;
+    FLAC__FrameSpan span;
+
+    iterator = FLAC__frame_span_iterator_new();
+    decoder = FLAC__stream_decoder_new();
+    if (iterator != 0 && decoder != 0 && FLAC__frame_span_iterator_init(iterator, data, size)) {
+        while (FLAC__frame_span_iterator_next(iterator, &span)) {
+            if (FLAC__stream_decoder_init_memory_frames(decoder, FLAC__frame_span_iterator_get_stream_info(iterator), span.data, span.bytes) == FLAC__STREAM_DECODER_INIT_STATUS_OK)
+                (void)FLAC__stream_decoder_decode_frame(decoder, buffer, FLAC__MAX_BLOCK_SIZE, 0);
+            FLAC__stream_decoder_finish(decoder);
+        }
+    }
+    if (decoder != 0)
+        FLAC__stream_decoder_delete(decoder);
+    if (iterator != 0)
+        FLAC__frame_span_iterator_delete(iterator);
+    return 0;
+}
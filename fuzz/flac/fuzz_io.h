@@ -0,0 +1,73 @@
+#ifndef FLAC__FUZZ__FUZZ_IO_H
+#define FLAC__FUZZ__FUZZ_IO_H
+
+#include <stdint.h>
+#include <stdio.h>      // for SEEK_SET
+#include <string.h>
+#include "FLAC/callback.h"
+
+// 把fuzzer给的输入当成一个文件，供走I/O回调的入口使用
+
+typedef struct {
+    const FLAC__byte *data;
+    size_t bytes;
+    size_t position;
+} FuzzStream;
+
+static inline size_t fuzz_read_(void *ptr, size_t size, size_t nmemb, FLAC__IOHandle handle)
+{
+    FuzzStream *stream = (FuzzStream*)handle;
+    size_t n;
+
+    if (size == 0)
+        return 0;
+    n = (stream->bytes - stream->position) / size;
+    if (n > nmemb)
+        n = nmemb;
+    memcpy(ptr, stream->data + stream->position, n * size);
+    stream->position += n * size;
+    return n;
+}
+
+static inline int fuzz_seek_(FLAC__IOHandle handle, FLAC__int64 offset, int whence)
+{
+    FuzzStream *stream = (FuzzStream*)handle;
+    FLAC__int64 base = whence == SEEK_SET ? 0 : whence == SEEK_CUR ? (FLAC__int64)stream->position : (FLAC__int64)stream->bytes;
+
+    if (offset < -base || base + offset > (FLAC__int64)stream->bytes)
+        return -1;
+    stream->position = (size_t)(base + offset);
+    return 0;
+}
+
+static inline FLAC__int64 fuzz_tell_(FLAC__IOHandle handle)
+{
+    return (FLAC__int64)((FuzzStream*)handle)->position;
+}
+
+static inline FLAC__int64 fuzz_eof_(FLAC__IOHandle handle)
+{
+    FuzzStream *stream = (FuzzStream*)handle;
+    return stream->position >= stream->bytes;
+}
+
+static inline FLAC__IOCallbacks fuzz_callbacks_(void)
+{
+    FLAC__IOCallbacks callbacks;
+
+    memset(&callbacks, 0, sizeof(callbacks));
+    callbacks.read = fuzz_read_;
+    callbacks.seek = fuzz_seek_;
+    callbacks.tell = fuzz_tell_;
+    callbacks.eof = fuzz_eof_;
+    return callbacks;
+}
+
+static inline void fuzz_stream_init_(FuzzStream *stream, const uint8_t *data, size_t bytes)
+{
+    stream->data = data;
+    stream->bytes = bytes;
+    stream->position = 0;
+}
+
+#endif // !FLAC__FUZZ__FUZZ_IO_H
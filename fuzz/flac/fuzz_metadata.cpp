@@ -0,0 +1,37 @@
+#include <stdint.h>
+#include "FLAC/metadata.h"
+#include "fuzz_io.h"
+
+// metadata的对象模型：读出所有块，每个块的内容整块取一次、分段读一次，
+// PICTURE块再解析一次
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    FLAC__MetadataBlockInfo info;
+    FLAC__MetadataPicture picture;
+    FLAC__Metadata *metadata;
+    FuzzStream stream;
+    FLAC__byte head[16];
+    unsigned i, n;
+
+    metadata = FLAC__metadata_new();
+    if (metadata == 0)
+        return 0;
+    fuzz_stream_init_(&stream, data, size);
+    if (FLAC__metadata_read_stream(metadata, &stream, fuzz_callbacks_()) == FLAC__METADATA_OK) {
+        (void)FLAC__metadata_get_stream_info(metadata);
+        (void)FLAC__metadata_get_audio_offset(metadata);
+        for (i = 0; i < FLAC__metadata_get_num_blocks(metadata); i++) {
+            if (!FLAC__metadata_get_block_info(metadata, i, &info))
+                continue;
+            if (FLAC__metadata_get_block_data(metadata, i) != 0)
+                FLAC__metadata_release_block_data(metadata, i);
+            n = info.length < sizeof(head) ? info.length : (unsigned)sizeof(head);
+            (void)FLAC__metadata_read_block(metadata, i, info.length - n, head, n);
+            (void)FLAC__metadata_get_picture(metadata, i, &picture);
+        }
+        (void)FLAC__metadata_find_block(metadata, FLAC__METADATA_TYPE_VORBIS_COMMENT, 0);
+    }
+    FLAC__metadata_delete(metadata);
+    return 0;
+}
@@ -0,0 +1,37 @@
+#include <stdint.h>
+#include "FLAC/parallel_decoder.h"
+
+// 多线程解码(FLAC__parallel_decoder_decode_memory)：第一个字节选线程数(1或2)和输出位深
+
+static FLAC__bool write_(const FLAC__StreamMetadata_StreamInfo *stream_info, const FLAC__byte pcm[], size_t samples, void *client_data)
+{
+    const unsigned bits_per_sample = *(const unsigned*)client_data != 0 ? *(const unsigned*)client_data : stream_info->bits_per_sample;
+    volatile FLAC__byte sum = 0;
+
+    /* the last byte of the PCM, so a short buffer shows up */
+    if (samples > 0)
+        sum += pcm[samples * stream_info->channels * ((bits_per_sample + 7) / 8) - 1];
+    return true;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static const unsigned bits_per_sample[4] = { 0, 8, 16, 24 };
+    FLAC__ParallelDecoder *decoder;
+    uint8_t mode;
+
+    if (size < 1)
+        return 0;
+    mode = data[0];
+    data++;
+    size--;
+
+    decoder = FLAC__parallel_decoder_new();
+    if (decoder == 0)
+        return 0;
+    (void)FLAC__parallel_decoder_set_num_threads(decoder, 1 + (mode & 1));
+    (void)FLAC__parallel_decoder_set_bits_per_sample(decoder, bits_per_sample[(mode >> 1) & 3]);
+    (void)FLAC__parallel_decoder_decode_memory(decoder, data, size, write_, (void*)&bits_per_sample[(mode >> 1) & 3], /*result=*/0);
+    FLAC__parallel_decoder_delete(decoder);
+    return 0;
+}
@@ -0,0 +1,31 @@
+#include <stdint.h>
+#include "FLAC/scan.h"
+#include "fuzz_io.h"
+
+// 只读metadata的扫描(FLAC__scanner_scan_stream)，标签逐条看一遍
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    FLAC__ScanResult result;
+    FLAC__Scanner *scanner;
+    FuzzStream stream;
+    volatile unsigned sum = 0;
+    unsigned i;
+
+    scanner = FLAC__scanner_new();
+    if (scanner == 0)
+        return 0;
+    fuzz_stream_init_(&stream, data, size);
+    if (FLAC__scanner_scan_stream(scanner, &stream, fuzz_callbacks_(), &result)) {
+        for (i = 0; i < result.vendor_string_length; i++)
+            sum += (unsigned char)result.vendor_string[i];
+        for (i = 0; i < result.num_comments; i++) {
+            if (result.comments[i].length > 0)
+                sum += (unsigned char)result.comments[i].entry[result.comments[i].length - 1];
+        }
+        for (i = 0; i < result.num_pictures; i++)
+            sum += result.pictures[i].length;
+    }
+    FLAC__scanner_delete(scanner);
+    return 0;
+}
@@ -0,0 +1,44 @@
+#include <stdint.h>
+#include "FLAC/seek_index.h"
+#include "FLAC/stream_decoder.h"
+
+// 建seek索引(FLAC__seek_index_build_memory)，再用它在流里跳几次：
+// 跳到开头、中间、最后一个样本和流的外面
+
+static FLAC__int32 output_[FLAC__MAX_CHANNELS][FLAC__MAX_BLOCK_SIZE];
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    FLAC__int32 * const buffer[FLAC__MAX_CHANNELS] = { output_[0], output_[1], output_[2], output_[3], output_[4], output_[5], output_[6], output_[7] };
+    const FLAC__StreamMetadata_StreamInfo *stream_info;
+    FLAC__StreamMetadata_SeekPoint point;
+    FLAC__StreamDecoder *decoder;
+    FLAC__SeekIndex *index;
+    FLAC__uint64 targets[4];
+    size_t num_points;
+    unsigned i;
+
+    index = FLAC__seek_index_new();
+    decoder = FLAC__stream_decoder_new();
+    if (index != 0 && decoder != 0 && FLAC__seek_index_build_memory(index, data, size)) {
+        (void)FLAC__seek_index_get_points(index, &num_points);
+        stream_info = FLAC__seek_index_get_stream_info(index);
+        targets[0] = 0;
+        targets[1] = stream_info != 0 ? stream_info->total_samples / 2 : 4096;
+        targets[2] = stream_info != 0 && stream_info->total_samples > 0 ? stream_info->total_samples - 1 : 0;
+        targets[3] = (FLAC__uint64)1 << 48;
+        if (FLAC__stream_decoder_init_memory(decoder, data, size) == FLAC__STREAM_DECODER_INIT_STATUS_OK) {
+            for (i = 0; i < sizeof(targets) / sizeof(targets[0]); i++) {
+                (void)FLAC__seek_index_lookup(index, targets[i], &point);
+                if (FLAC__stream_decoder_seek_absolute(decoder, index, targets[i]))
+                    (void)FLAC__stream_decoder_decode_frame(decoder, buffer, FLAC__MAX_BLOCK_SIZE, 0);
+            }
+        }
+        FLAC__stream_decoder_finish(decoder);
+    }
+    if (decoder != 0)
+        FLAC__stream_decoder_delete(decoder);
+    if (index != 0)
+        FLAC__seek_index_delete(index);
+    return 0;
+}
@@ -0,0 +1,12 @@
+#include <stdint.h>
+#include "FLAC/verify.h"
+
+// 完整性检查(FLAC__verify_memory)：解码所有帧并算MD5
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    FLAC__VerifyResult result;
+
+    (void)FLAC__verify_memory(data, size, &result);
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+// 没有libFuzzer时(比如用gcc)链接这个main：把命令行上的每个文件当成一个输入
+// 跑一遍，用来重放fuzzer找到的崩溃，或者在sanitizer下跑一遍语料
+//
+//   fuzz_decoder crash-1234 corpus/*
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+int main(int argc, char **argv)
+{
+    std::vector<uint8_t> input;
+    FILE *f;
+    long length;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        f = fopen(argv[i], "rb");
+        if (f == 0) {
+            fprintf(stderr, "%s: cannot open\n", argv[i]);
+            return 1;
+        }
+        if (fseek(f, 0, SEEK_END) != 0 || (length = ftell(f)) < 0 || fseek(f, 0, SEEK_SET) != 0) {
+            fprintf(stderr, "%s: cannot read\n", argv[i]);
+            fclose(f);
+            return 1;
+        }
+        input.resize((size_t)length);
+        if (length > 0 && fread(input.data(), 1, (size_t)length, f) != (size_t)length) {
+            fprintf(stderr, "%s: cannot read\n", argv[i]);
+            fclose(f);
+            return 1;
+        }
+        fclose(f);
+        /* an empty vector's data() may be NULL; libFuzzer never passes NULL */
+        input.push_back(0);
+        LLVMFuzzerTestOneInput(input.data(), (size_t)length);
+    }
+    return 0;
+}
@@ -6,6 +6,15 @@
 #include "assert.h"
 #include "callback.h"
 #include "format.h"
+#include "mapped_file.h"
+#include "metadata.h"
+#include "parallel_decoder.h"
+#include "recompress.h"
+#include "scan.h"
+#include "seek_index.h"
+#include "stream_decoder.h"
+#include "stream_encoder.h"
+#include "verify.h"
 
 
 #endif // !FLAC__ALL_H
\ No newline at end of file
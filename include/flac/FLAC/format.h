@@ -264,6 +264,381 @@ extern FLAC_API const unsigned FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2_PAR
 // 后面的5
 extern FLAC_API const unsigned FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_RAW_LEN;    /** == 5 (bits) */
 
+/** == (1<<FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_PARAMETER_LEN)-1 */
+// 参数全1表示escape,后面跟5位的raw_bits
+extern FLAC_API const unsigned FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_ESCAPE_PARAMETER;
+
+/** == (1<<FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2_PARAMETER_LEN)-1 */
+extern FLAC_API const unsigned FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2_ESCAPE_PARAMETER;
+
+/** Header for the entropy coding method. */
+typedef struct {
+    FLAC__EntropyCodingMethodType type;
+    union {
+        FLAC__EntropyCodingMethod_PartitionedRice partitioned_rice;
+    } data;
+} FLAC__EntropyCodingMethod;
+
+// RESIDUAL
+// <2> Residual coding method
+extern FLAC_API const unsigned FLAC__ENTROPY_CODING_METHOD_TYPE_LEN; /**< == 2 (bits) */
+
+
+/** An enumeration of the available subframe types. */
+// SUBFRAME_HEADER
+// <6> Subframe type:
+        // 000000 : SUBFRAME_CONSTANT
+        // 000001 : SUBFRAME_VERBATIM
+        // 00001x : reserved
+        // 0001xx : reserved
+        // 001xxx : if(xxx <= 4) SUBFRAME_FIXED, xxx=order ; else reserved
+        // 01xxxx : reserved
+        // 1xxxxx : SUBFRAME_LPC, xxxxx=order-1
+typedef enum {
+    FLAC__SUBFRAME_TYPE_CONSTANT = 0,   /**< constant signal */
+    FLAC__SUBFRAME_TYPE_VERBATIM = 1,   /**< uncompressed signal */
+    FLAC__SUBFRAME_TYPE_FIXED = 2,      /**< fixed polynomial prediction */
+    FLAC__SUBFRAME_TYPE_LPC = 3         /**< linear prediction */
+} FLAC__SubframeType;
+
+/**
+ * Maps a FLAC__SubframeType to a C string.
+ * 
+ * Using a FLAC__SubframeType as the index to this array will
+ * give the string equivalent. The contents should not be modified.
+ */
+extern FLAC_API const char * const FLAC__SubframeTypeString[];
+
+/** CONSTANT subframe. */
+// 33位的side声道也能放得下
+typedef struct {
+    FLAC__int64 value;
+} FLAC__Subframe_Constant;
+
+/** VERBATIM subframe. */
+typedef struct {
+    const FLAC__int32 *data;    /**< A pointer to verbatim signal. */
+} FLAC__Subframe_Verbatim;
+
+/** FIXED subframe. */
+typedef struct {
+    /** The residual coding method. */
+    FLAC__EntropyCodingMethod entropy_coding_method;
+
+    /** The polynomial order. */
+    unsigned order;
+
+    /** Warmup samples to prime the predictor, length == order. */
+    FLAC__int64 warmup[FLAC__MAX_FIXED_ORDER];
+
+    /** The residual signal, length == (blocksize minus order) samples. */
+    const FLAC__int32 *residual;
+} FLAC__Subframe_Fixed;
+
+/** LPC subframe. */
+typedef struct {
+    /** The residual coding method. */
+    FLAC__EntropyCodingMethod entropy_coding_method;
+
+    /** The FIR order. */
+    unsigned order;
+
+    /** Quantized FIR filter coefficient precision in bits. */
+    unsigned qlp_coeff_precision;
+
+    /** The qlp coeff shift needed. */
+    int quantization_level;
+
+    /** FIR filter coefficients. */
+    FLAC__int32 qlp_coeff[FLAC__MAX_LPC_ORDER];
+
+    /** Warmup samples to prime the predictor, length == order. */
+    FLAC__int64 warmup[FLAC__MAX_LPC_ORDER];
+
+    /** The residual signal, length == (blocksize minus order) samples. */
+    const FLAC__int32 *residual;
+} FLAC__Subframe_LPC;
+
+// SUBFRAME_LPC
+// <4> (Quantized linear predictor coefficients' precision in bits)-1 (1111 = invalid).
+extern FLAC_API const unsigned FLAC__SUBFRAME_LPC_QLP_COEFF_PRECISION_LEN; /**< == 4 (bits) */
+// <5> Quantized linear predictor coefficient shift needed in bits (NOTE: this number is signed two's-complement).
+extern FLAC_API const unsigned FLAC__SUBFRAME_LPC_QLP_SHIFT_LEN; /**< == 5 (bits) */
+
+/** FLAC subframe structure. */
+typedef struct {
+    FLAC__SubframeType type;
+    union {
+        FLAC__Subframe_Constant constant;
+        FLAC__Subframe_Fixed fixed;
+        FLAC__Subframe_LPC lpc;
+        FLAC__Subframe_Verbatim verbatim;
+    } data;
+    unsigned wasted_bits;
+} FLAC__Subframe;
+
+// SUBFRAME_HEADER
+// <1> Zero bit padding, to prevent sync-fooling string of 1s
+// <6> Subframe type
+// <1+k> 'Wasted bits-per-sample' flag
+extern FLAC_API const unsigned FLAC__SUBFRAME_ZERO_PAD_LEN; /**< == 1 (bit) */
+extern FLAC_API const unsigned FLAC__SUBFRAME_TYPE_LEN; /**< == 6 (bits) */
+extern FLAC_API const unsigned FLAC__SUBFRAME_WASTED_BITS_FLAG_LEN; /**< == 1 (bit) */
+
+extern FLAC_API const unsigned FLAC__SUBFRAME_TYPE_CONSTANT_BYTE_ALIGNED_MASK; /**< = 0x00 */
+extern FLAC_API const unsigned FLAC__SUBFRAME_TYPE_VERBATIM_BYTE_ALIGNED_MASK; /**< = 0x02 */
+extern FLAC_API const unsigned FLAC__SUBFRAME_TYPE_FIXED_BYTE_ALIGNED_MASK; /**< = 0x10 */
+extern FLAC_API const unsigned FLAC__SUBFRAME_TYPE_LPC_BYTE_ALIGNED_MASK; /**< = 0x40 */
+
+
+/********************************************************************
+ * 
+ * Frame structures
+ * 
+ ********************************************************************/
+
+/** An enumeration of the available channel assignments. */
+// <4> Channel assignment
+        // 0000-0111 : (number of independent channels)-1.
+        // 1000 : left/side stereo: channel 0 is the left channel, channel 1 is the side(difference) channel
+        // 1001 : right/side stereo: channel 0 is the side(difference) channel, channel 1 is the right channel
+        // 1010 : mid/side stereo: channel 0 is the mid(average) channel, channel 1 is the side(difference) channel
+        // 1011-1111 : reserved
+typedef enum {
+    FLAC__CHANNEL_ASSIGNMENT_INDEPENDENT = 0, /**< independent channels */
+    FLAC__CHANNEL_ASSIGNMENT_LEFT_SIDE = 1, /**< left+side stereo */
+    FLAC__CHANNEL_ASSIGNMENT_RIGHT_SIDE = 2, /**< right+side stereo */
+    FLAC__CHANNEL_ASSIGNMENT_MID_SIDE = 3 /**< mid+side stereo */
+} FLAC__ChannelAssignment;
+
+/**
+ * Maps a FLAC__ChannelAssignment to a C string.
+ * 
+ * Using a FLAC__ChannelAssignment as the index to this array will
+ * give the string equivalent. The contents should not be modified.
+ */
+extern FLAC_API const char * const FLAC__ChannelAssignmentString[];
+
+/** An enumeration of the possible frame numbering methods. */
+// <1> Blocking strategy:
+        // 0 : fixed-blocksize stream; frame header encodes the frame number
+        // 1 : variable-blocksize stream; frame header encodes the sample number
+typedef enum {
+    FLAC__FRAME_NUMBER_TYPE_FRAME_NUMBER, /**< number contains the frame number */
+    FLAC__FRAME_NUMBER_TYPE_SAMPLE_NUMBER /**< number contains the sample number of first sample in frame */
+} FLAC__FrameNumberType;
+
+/**
+ * Maps a FLAC__FrameNumberType to a C string.
+ * 
+ * Using a FLAC__FrameNumberType as the index to this array will
+ * give the string equivalent. The contents should not be modified.
+ */
+extern FLAC_API const char * const FLAC__FrameNumberTypeString[];
+
+/** FLAC frame header structure. */
+typedef struct {
+    /** The number of samples per subframe. */
+    unsigned blocksize;
+
+    /** The sample rate in Hz. */
+    unsigned sample_rate;
+
+    /** The number of channels (== number of subframes). */
+    unsigned channels;
+
+    /** The channel assignment for the frame. */
+    FLAC__ChannelAssignment channel_assignment;
+
+    /** The sample resolution. */
+    unsigned bits_per_sample;
+
+    /** The numbering scheme used for the frame.  As a convenience, the
+     * decoder will always convert a frame number to a sample number because
+     * the rules are complex. */
+    FLAC__FrameNumberType number_type;
+
+    /** The frame number or sample number of first sample in frame;
+     * use the number_type value to determine which to use. */
+    union {
+        FLAC__uint32 frame_number;
+        FLAC__uint64 sample_number;
+    } number;
+
+    /** CRC-8 (polynomial = x^8 + x^2 + x^1 + x^0, initialized with 0)
+     * of the raw frame header bytes, meaning everything before the CRC byte
+     * including the sync code.
+     */
+    FLAC__uint8 crc;
+} FLAC__FrameHeader;
+
+// FRAME_HEADER
+// <14> Sync code '11111111111110'
+extern FLAC_API const unsigned FLAC__FRAME_HEADER_SYNC; /**< == 0x3ffe; the frame header sync code */
+extern FLAC_API const unsigned FLAC__FRAME_HEADER_SYNC_LEN; /**< == 14 (bits) */
+extern FLAC_API const unsigned FLAC__FRAME_HEADER_RESERVED_LEN; /**< == 1 (bits) */
+extern FLAC_API const unsigned FLAC__FRAME_HEADER_BLOCKING_STRATEGY_LEN; /**< == 1 (bits) */
+extern FLAC_API const unsigned FLAC__FRAME_HEADER_BLOCK_SIZE_LEN; /**< == 4 (bits) */
+extern FLAC_API const unsigned FLAC__FRAME_HEADER_SAMPLE_RATE_LEN; /**< == 4 (bits) */
+extern FLAC_API const unsigned FLAC__FRAME_HEADER_CHANNEL_ASSIGNMENT_LEN; /**< == 4 (bits) */
+extern FLAC_API const unsigned FLAC__FRAME_HEADER_BITS_PER_SAMPLE_LEN; /**< == 3 (bits) */
+extern FLAC_API const unsigned FLAC__FRAME_HEADER_ZERO_PAD_LEN; /**< == 1 (bit) */
+extern FLAC_API const unsigned FLAC__FRAME_HEADER_CRC_LEN; /**< == 8 (bits) */
+
+/** The longest possible frame header, in bytes: 2 sync/strategy + 2 fixed
+ * fields + 7 UTF-8 coded sample number + 2 blocksize + 2 sample rate + 1 CRC. */
+#define FLAC__FRAME_HEADER_MAX_LENGTH (16u)
+
+/** FLAC frame footer structure. */
+typedef struct {
+    /** CRC-16 (polynomial = x^16 + x^15 + x^2 + x^0, initialized with
+     * 0) of the bytes before the crc, back to and including the frame header
+     * sync code.
+     */
+    FLAC__uint16 crc;
+} FLAC__FrameFooter;
+
+// FRAME_FOOTER
+// <16> CRC-16 (polynomial = x^16 + x^15 + x^2 + x^0, initialized with 0) of everything before the crc
+extern FLAC_API const unsigned FLAC__FRAME_FOOTER_CRC_LEN; /**< == 16 (bits) */
+
+/** FLAC frame structure. */
+typedef struct {
+    FLAC__FrameHeader header;
+    FLAC__Subframe subframes[FLAC__MAX_CHANNELS];
+    FLAC__FrameFooter footer;
+} FLAC__Frame;
+
+
+/********************************************************************
+ * 
+ * Meta-data structures
+ * 
+ ********************************************************************/
+
+/** An enumeration of the available metadata block types. */
+typedef enum {
+    FLAC__METADATA_TYPE_STREAMINFO = 0,     /**< STREAMINFO block */
+    FLAC__METADATA_TYPE_PADDING = 1,        /**< PADDING block */
+    FLAC__METADATA_TYPE_APPLICATION = 2,    /**< APPLICATION block */
+    FLAC__METADATA_TYPE_SEEKTABLE = 3,      /**< SEEKTABLE block */
+    FLAC__METADATA_TYPE_VORBIS_COMMENT = 4, /**< VORBISCOMMENT block (a.k.a. FLAC tags) */
+    FLAC__METADATA_TYPE_CUESHEET = 5,       /**< CUESHEET block */
+    FLAC__METADATA_TYPE_PICTURE = 6,        /**< PICTURE block */
+    FLAC__METADATA_TYPE_UNDEFINED = 7,      /**< marker to denote beginning of undefined type range; this number will increase as new metadata types are added */
+    FLAC__MAX_METADATA_TYPE = FLAC__MAX_METADATA_TYPE_CODE /**< No type will ever be greater than this. There is not enough room in the protocol block. */
+} FLAC__MetadataType;
+
+/**
+ * Maps a FLAC__MetadataType to a C string.
+ * 
+ * Using a FLAC__MetadataType as the index to this array will
+ * give the string equivalent. The contents should not be modified.
+ */
+extern FLAC_API const char * const FLAC__MetadataTypeString[];
+
+/** FLAC STREAMINFO structure. */
+// METADATA_BLOCK_STREAMINFO
+// <16> The minimum block size (in samples) used in the stream.
+// <16> The maximum block size (in samples) used in the stream.
+// <24> The minimum frame size (in bytes) used in the stream. May be 0 to imply the value is not known.
+// <24> The maximum frame size (in bytes) used in the stream. May be 0 to imply the value is not known.
+// <20> Sample rate in Hz.
+// <3> (number of channels)-1.
+// <5> (bits per sample)-1.
+// <36> Total samples in stream. A value of zero here means the number of total samples is unknown.
+// <128> MD5 signature of the unencoded audio data.
+typedef struct {
+    unsigned min_blocksize, max_blocksize;
+    unsigned min_framesize, max_framesize;
+    unsigned sample_rate;
+    unsigned channels;
+    unsigned bits_per_sample;
+    FLAC__uint64 total_samples;
+    FLAC__byte md5sum[16];
+} FLAC__StreamMetadata_StreamInfo;
+
+extern FLAC_API const unsigned FLAC__STREAM_METADATA_STREAMINFO_MIN_BLOCK_SIZE_LEN; /**< == 16 (bits) */
+extern FLAC_API const unsigned FLAC__STREAM_METADATA_STREAMINFO_MAX_BLOCK_SIZE_LEN; /**< == 16 (bits) */
+extern FLAC_API const unsigned FLAC__STREAM_METADATA_STREAMINFO_MIN_FRAME_SIZE_LEN; /**< == 24 (bits) */
+extern FLAC_API const unsigned FLAC__STREAM_METADATA_STREAMINFO_MAX_FRAME_SIZE_LEN; /**< == 24 (bits) */
+extern FLAC_API const unsigned FLAC__STREAM_METADATA_STREAMINFO_SAMPLE_RATE_LEN; /**< == 20 (bits) */
+extern FLAC_API const unsigned FLAC__STREAM_METADATA_STREAMINFO_CHANNELS_LEN; /**< == 3 (bits) */
+extern FLAC_API const unsigned FLAC__STREAM_METADATA_STREAMINFO_BITS_PER_SAMPLE_LEN; /**< == 5 (bits) */
+extern FLAC_API const unsigned FLAC__STREAM_METADATA_STREAMINFO_TOTAL_SAMPLES_LEN; /**< == 36 (bits) */
+extern FLAC_API const unsigned FLAC__STREAM_METADATA_STREAMINFO_MD5SUM_LEN; /**< == 128 (bits) */
+
+/** The total stream length of the STREAMINFO block in bytes. */
+#define FLAC__STREAM_METADATA_STREAMINFO_LENGTH (34u)
+
+/** FLAC SEEKPOINT structure. */
+// METADATA_BLOCK_SEEKTABLE is a run of SEEKPOINTs, as many as fit in the block length.
+// <64> Sample number of the first sample in the target frame, or 0xFFFFFFFFFFFFFFFF for a placeholder point.
+// <64> Offset (in bytes) from the first byte of the first frame header to the first byte of the target frame's header.
+// <16> Number of samples in the target frame.
+typedef struct {
+    FLAC__uint64 sample_number;
+    FLAC__uint64 stream_offset;
+    unsigned frame_samples;
+} FLAC__StreamMetadata_SeekPoint;
+
+extern FLAC_API const unsigned FLAC__STREAM_METADATA_SEEKPOINT_SAMPLE_NUMBER_LEN; /**< == 64 (bits) */
+extern FLAC_API const unsigned FLAC__STREAM_METADATA_SEEKPOINT_STREAM_OFFSET_LEN; /**< == 64 (bits) */
+extern FLAC_API const unsigned FLAC__STREAM_METADATA_SEEKPOINT_FRAME_SAMPLES_LEN; /**< == 16 (bits) */
+
+/** The total stream length of a seek point in bytes. */
+#define FLAC__STREAM_METADATA_SEEKPOINT_LENGTH (18u)
+
+/** The value used in the sample_number field of a placeholder point. */
+extern FLAC_API const FLAC__uint64 FLAC__STREAM_METADATA_SEEKPOINT_PLACEHOLDER;
+
+// METADATA_BLOCK_HEADER
+// <1> Last-metadata-block flag: '1' if this block is the last metadata block before the audio blocks, '0' otherwise.
+// <7> BLOCK_TYPE
+// <24> Length (in bytes) of metadata to follow (does not include the size of the METADATA_BLOCK_HEADER)
+extern FLAC_API const unsigned FLAC__STREAM_METADATA_IS_LAST_LEN; /**< == 1 (bit) */
+extern FLAC_API const unsigned FLAC__STREAM_METADATA_TYPE_LEN; /**< == 7 (bits) */
+extern FLAC_API const unsigned FLAC__STREAM_METADATA_LENGTH_LEN; /**< == 24 (bits) */
+
+/** The total stream length of a metadata block header in bytes. */
+#define FLAC__STREAM_METADATA_HEADER_LENGTH (4u)
+
+
+/********************************************************************
+ * 
+ * Format validation functions
+ * 
+ ********************************************************************/
+
+/**
+ * Tests that a sample rate is valid for FLAC.
+ * 
+ * param sample_rate    The sample rate to test for compliance.
+ * retval FLAC__bool    true if the given sample rate conforms to the specification, else false.
+ */
+FLAC_API FLAC__bool FLAC__format_sample_rate_is_valid(unsigned sample_rate);
+
+/**
+ * Tests that a blocksize at the given sample rate is valid for the FLAC subset.
+ * 
+ * param blocksize      The blocksize to test for compliance.
+ * param sample_rate    The sample rate is needed, since the valid subset
+ *                      blocksize depends on the sample rate.
+ * retval FLAC__bool    true if the given blocksize conforms to the specification for the
+ *                      subset at the given sample rate, else false.
+ */
+FLAC_API FLAC__bool FLAC__format_blocksize_is_subset(unsigned blocksize, unsigned sample_rate);
+
+/**
+ * Tests that a sample rate is valid for the FLAC subset. The subset rules
+ * for valid sample rates are slightly more complex since the rate has to
+ * be expressible completely in the frame header.
+ * 
+ * param sample_rate    The sample rate to test for compliance.
+ * retval FLAC__bool    true if the given sample rate conforms to the specification for the subset, else false.
+ */
+FLAC_API FLAC__bool FLAC__format_sample_rate_is_subset(unsigned sample_rate);
+
 
 #ifdef __cplusplus
 }
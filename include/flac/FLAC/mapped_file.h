@@ -0,0 +1,178 @@
+#ifndef FLAC__MAPPED_FILE_H
+#define FLAC__MAPPED_FILE_H
+
+#include "export.h"
+#include "format.h"
+#include <stddef.h>     // for size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * This module provides read-only memory-mapped access to FLAC files, an
+ * alternative to pulling them through FLAC__IOCallbacks when the data is
+ * on a local disk.
+ *
+ * A FLAC__MappedFile maps the whole file and tells the kernel how it is
+ * going to be read (madvise). The mapping can be decoded with
+ * FLAC__stream_decoder_init_memory(), which reads the frames straight
+ * out of it, or walked frame by frame with a FLAC__FrameSpanIterator,
+ * which hands out the byte range of every frame without copying or
+ * decoding anything; that is all bulk verification (CRCs, MD5 of the
+ * encoded data, splitting work between threads) needs.
+ *
+ * The basic usage is:
+ *  - FLAC__mapped_file_open() the file
+ *  - pass FLAC__mapped_file_get_data() and FLAC__mapped_file_get_size()
+ *    to a decoder or a frame span iterator
+ *  - FLAC__mapped_file_close() it once they are finished
+ */
+
+/** How the mapping is going to be read; decides the madvise hints. */
+typedef enum {
+    /** Front to back, once: MADV_SEQUENTIAL and MADV_WILLNEED, so the
+     * kernel starts reading ahead right away and can drop pages behind
+     * the reader. */
+    FLAC__MAPPED_FILE_ACCESS_SEQUENTIAL = 0,
+
+    /** Seeking around: MADV_RANDOM, no read-ahead. */
+    FLAC__MAPPED_FILE_ACCESS_RANDOM
+} FLAC__MappedFileAccess;
+
+/**
+ * The opaque structure definition for the mapped file type.
+ */
+struct FLAC__MappedFile;
+typedef struct FLAC__MappedFile FLAC__MappedFile;
+
+/**
+ * Map a file read-only.
+ *
+ * param filename   The file to map.
+ * param access     How the mapping is going to be read.
+ * retval FLAC__MappedFile*
+ *      NULL if the file could not be opened or mapped (check errno), else
+ *      the new instance. An empty file gives an instance with no data.
+ */
+FLAC_API FLAC__MappedFile *FLAC__mapped_file_open(const char *filename, FLAC__MappedFileAccess access);
+
+/**
+ * Unmap the file and free the instance. Decoders and iterators reading
+ * from the mapping must be finished first.
+ *
+ * param file   A mapped file, or NULL.
+ */
+FLAC_API void FLAC__mapped_file_close(FLAC__MappedFile *file);
+
+/**
+ * The start of the mapping.
+ *
+ * param file   A mapped file.
+ * retval const FLAC__byte*     The file's contents, NULL for an empty file.
+ */
+FLAC_API const FLAC__byte *FLAC__mapped_file_get_data(const FLAC__MappedFile *file);
+
+/**
+ * The size of the mapping.
+ *
+ * param file   A mapped file.
+ * retval size_t    The size of the file in bytes.
+ */
+FLAC_API size_t FLAC__mapped_file_get_size(const FLAC__MappedFile *file);
+
+/**
+ * Ask the kernel to start reading part of the file in (MADV_WILLNEED),
+ * e.g. the next few frames before a random access. The range is clipped
+ * to the file.
+ *
+ * param file   A mapped file.
+ * param offset The first byte of the range.
+ * param length The size of the range in bytes.
+ * retval FLAC__bool    false if the kernel rejected the hint.
+ */
+FLAC_API FLAC__bool FLAC__mapped_file_prefetch(const FLAC__MappedFile *file, FLAC__uint64 offset, FLAC__uint64 length);
+
+
+/** The bytes of one frame, pointing into the iterated memory. */
+typedef struct {
+    /** The first byte of the frame, the start of the sync code. */
+    const FLAC__byte *data;
+
+    /** The size of the frame including the CRC-16 footer. */
+    size_t bytes;
+
+    /** The offset of the frame from the start of the iterated memory. */
+    FLAC__uint64 offset;
+
+    /** The parsed frame header; a frame number is converted to a sample
+     * number the same way the decoder does it. */
+    FLAC__FrameHeader header;
+
+    /** true if the frame's CRC-16 checks out. If it does not, the frame
+     * is damaged and the span ends where the next valid frame header
+     * was found. */
+    FLAC__bool crc_ok;
+} FLAC__FrameSpan;
+
+/**
+ * The opaque structure definition for the frame span iterator type.
+ */
+struct FLAC__FrameSpanIterator;
+typedef struct FLAC__FrameSpanIterator FLAC__FrameSpanIterator;
+
+/**
+ * Create a new frame span iterator instance.
+ *
+ * retval FLAC__FrameSpanIterator*  NULL if there was an error allocating memory, else the new instance.
+ */
+FLAC_API FLAC__FrameSpanIterator *FLAC__frame_span_iterator_new(void);
+
+/**
+ * Free an iterator instance.
+ *
+ * param iterator   A pointer to an existing iterator.
+ */
+FLAC_API void FLAC__frame_span_iterator_delete(FLAC__FrameSpanIterator *iterator);
+
+/**
+ * Start iterating over the frames of a FLAC stream in memory. An ID3v2
+ * tag, the "fLaC" marker and the metadata blocks are skipped, keeping
+ * STREAMINFO; data without the marker is taken to be bare frames.
+ *
+ * A frame ends where the next frame header starts, provided the CRC-16
+ * of the bytes in between checks out, so a sync code that happens to
+ * appear inside a frame does not split it. Nothing is decoded.
+ *
+ * param iterator   An existing iterator.
+ * param data       The stream; it must stay valid while iterating.
+ * param bytes      The size of the stream in bytes.
+ * retval FLAC__bool    false if the stream starts with "fLaC" but its
+ *                      metadata is cut off, else true.
+ */
+FLAC_API FLAC__bool FLAC__frame_span_iterator_init(FLAC__FrameSpanIterator *iterator, const FLAC__byte *data, size_t bytes);
+
+/**
+ * Get the STREAMINFO found by FLAC__frame_span_iterator_init().
+ *
+ * param iterator   An initialized iterator.
+ * retval const FLAC__StreamMetadata_StreamInfo*
+ *      The stream info, or NULL if the stream has no STREAMINFO block.
+ */
+FLAC_API const FLAC__StreamMetadata_StreamInfo *FLAC__frame_span_iterator_get_stream_info(const FLAC__FrameSpanIterator *iterator);
+
+/**
+ * Move to the next frame. Bytes between frames that do not start a valid
+ * frame header (garbage, damaged headers) are stepped over.
+ *
+ * param iterator   An initialized iterator.
+ * param span       Receives the next frame.
+ * retval FLAC__bool    false if there are no more frames.
+ */
+FLAC_API FLAC__bool FLAC__frame_span_iterator_next(FLAC__FrameSpanIterator *iterator, FLAC__FrameSpan *span);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !FLAC__MAPPED_FILE_H
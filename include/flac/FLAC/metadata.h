@@ -0,0 +1,353 @@
+#ifndef FLAC__METADATA_H
+#define FLAC__METADATA_H
+
+#include "export.h"
+#include "callback.h"
+#include "format.h"
+#include "mapped_file.h"
+#include <stddef.h>     // for size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * This module is an object model of a FLAC file's metadata blocks for
+ * taggers and the like, which keep the metadata of many files around
+ * but rarely look at the artwork.
+ *
+ * Reading the metadata walks the block headers and keeps, for every
+ * block, its type and where its body is in the file. Only the bodies of
+ * small blocks (STREAMINFO, VORBIS_COMMENT, SEEKTABLE, CUESHEET up to
+ * FLAC__METADATA_EAGER_MAX_LENGTH bytes) are read right away. PICTURE,
+ * PADDING and APPLICATION blocks, and anything larger, stay a descriptor
+ * until their bytes are asked for:
+ *  - FLAC__metadata_get_picture() reads the fields of a PICTURE block up
+ *    to the picture data, and tells where the data is
+ *  - FLAC__metadata_read_block() copies any range of a body into the
+ *    caller's buffer with a ranged read
+ *  - FLAC__metadata_get_block_data() hands out the whole body: a slice
+ *    of the mapping if the metadata was read from a FLAC__MappedFile,
+ *    else a copy that is kept until FLAC__metadata_release_block_data()
+ * So a file with several MB of artwork costs a few hundred bytes of
+ * memory until the artwork is actually wanted.
+ *
+ * The tags of a file read with FLAC__metadata_read_file() can be changed
+ * with FLAC__metadata_set_vorbis_comment() and FLAC__metadata_write().
+ * The write is done in place when the new VORBIS_COMMENT fits where the
+ * old one and the PADDING next to it are, or in another run of PADDING
+ * (the old block then becomes padding); only these few KB are written.
+ * Otherwise the file is rewritten into a temporary file next to it, which
+ * is then renamed over it. The rewrite copies the audio and any blocks it
+ * keeps with copy_file_range() (or sendfile() where that is not
+ * supported), so their bytes never pass through user space and on file
+ * systems that share extents they are not even copied, and it leaves
+ * FLAC__metadata_set_rewrite_padding() bytes of PADDING so that the next
+ * write fits in place.
+ *
+ * The basic usage is:
+ *  - create an instance with FLAC__metadata_new()
+ *  - read a file with FLAC__metadata_read_file(), a mapping with
+ *    FLAC__metadata_read_mapped_file() or a stream with
+ *    FLAC__metadata_read_stream(); the source has to stay available,
+ *    the lazy blocks are read from it later
+ *  - look at the blocks
+ *  - to retag, FLAC__metadata_set_vorbis_comment() and
+ *    FLAC__metadata_write()
+ *  - FLAC__metadata_delete() it
+ */
+
+/** Blocks up to this length are read with the headers, unless they are PICTURE, PADDING or APPLICATION. */
+#define FLAC__METADATA_EAGER_MAX_LENGTH (65536u)
+
+/** The PADDING FLAC__metadata_write() leaves when it has to rewrite the file, unless set otherwise. */
+#define FLAC__METADATA_DEFAULT_REWRITE_PADDING (8192u)
+
+/** What became of reading the metadata. */
+typedef enum {
+    /** The metadata was read up to the first audio frame. */
+    FLAC__METADATA_OK = 0,
+
+    /** The file is not a native FLAC stream, or it has no STREAMINFO. */
+    FLAC__METADATA_NOT_FLAC,
+
+    /** The file ends inside its metadata. */
+    FLAC__METADATA_TRUNCATED,
+
+    /** The file could not be opened, read or seeked. */
+    FLAC__METADATA_IO_ERROR,
+
+    /** Memory allocation failed. */
+    FLAC__METADATA_MEMORY_ALLOCATION_ERROR,
+
+    /** FLAC__metadata_write() was called on metadata that was not read
+     * from a regular file with FLAC__metadata_read_file(). */
+    FLAC__METADATA_NOT_A_FILE
+} FLAC__MetadataStatus;
+
+/**
+ * Maps a FLAC__MetadataStatus to a C string.
+ *
+ * Using a FLAC__MetadataStatus as the index to this array
+ * will give the string equivalent. The contents should not be modified.
+ */
+extern FLAC_API const char * const FLAC__MetadataStatusString[];
+
+/** Where a block is and whether its body is in memory. */
+typedef struct {
+    /** A FLAC__MetadataType, or a reserved type up to FLAC__MAX_METADATA_TYPE. */
+    unsigned type;
+
+    /** true for the last block before the audio. */
+    FLAC__bool is_last;
+
+    /** The offset of the body, the first byte after the 4-byte block header. */
+    FLAC__uint64 offset;
+
+    /** The length of the body in bytes. */
+    unsigned length;
+
+    /** true if the body is in memory (or in the mapping) right now. */
+    FLAC__bool loaded;
+} FLAC__MetadataBlockInfo;
+
+/**
+ * The fields of a PICTURE block. The strings belong to the metadata
+ * instance; they are NUL-terminated, and cut at the first NUL if they
+ * hold one.
+ */
+typedef struct {
+    /** The picture type of the ID3v2 APIC frame, e.g. 3 for the front cover. */
+    FLAC__uint32 type;
+
+    /** The MIME type, printable ASCII; "-->" means the data is a URL. */
+    const char *mime_type;
+
+    /** The description, UTF-8. */
+    const char *description;
+
+    FLAC__uint32 width;
+    FLAC__uint32 height;
+
+    /** Bits per pixel. */
+    FLAC__uint32 depth;
+
+    /** The number of colors of an indexed picture, 0 otherwise. */
+    FLAC__uint32 colors;
+
+    /** The length of the picture data in bytes. */
+    FLAC__uint32 data_length;
+
+    /** The offset of the picture data in the file. */
+    FLAC__uint64 data_offset;
+} FLAC__MetadataPicture;
+
+/**
+ * The opaque structure definition for the metadata type.
+ */
+struct FLAC__Metadata;
+typedef struct FLAC__Metadata FLAC__Metadata;
+
+/**
+ * Create a new metadata instance, holding no blocks.
+ *
+ * retval FLAC__Metadata*   NULL if there was an error allocating memory, else the new instance.
+ */
+FLAC_API FLAC__Metadata *FLAC__metadata_new(void);
+
+/**
+ * Free a metadata instance, with the blocks it loaded, and close the file
+ * FLAC__metadata_read_file() opened.
+ *
+ * param metadata   A pointer to an existing instance, or NULL.
+ */
+FLAC_API void FLAC__metadata_delete(FLAC__Metadata *metadata);
+
+/**
+ * Read the metadata of a file. The file is kept open for the lazy blocks
+ * until the next read or FLAC__metadata_delete(). An ID3v2 tag in front
+ * of the "fLaC" marker is skipped.
+ *
+ * param metadata   An existing instance; what it held before is dropped.
+ * param filename   The file to read.
+ * retval FLAC__MetadataStatus  FLAC__METADATA_OK on success. On failure
+ *                  the instance holds no blocks.
+ */
+FLAC_API FLAC__MetadataStatus FLAC__metadata_read_file(FLAC__Metadata *metadata, const char *filename);
+
+/**
+ * Read the metadata of a mapped file. Nothing is copied: the bodies of
+ * all blocks are slices of the mapping, which must stay mapped while the
+ * instance uses it.
+ *
+ * param metadata   An existing instance; what it held before is dropped.
+ * param file       The mapping.
+ * retval FLAC__MetadataStatus  FLAC__METADATA_OK on success.
+ */
+FLAC_API FLAC__MetadataStatus FLAC__metadata_read_mapped_file(FLAC__Metadata *metadata, const FLAC__MappedFile *file);
+
+/**
+ * Read the metadata of a stream, from its current position. callbacks.read
+ * and callbacks.seek are required. The offsets are relative to where the
+ * stream was when the read started, which callbacks.tell tells if it is
+ * set; without it the stream has to be at its start. The stream has to
+ * stay open, the lazy blocks are read from it later with SEEK_SET seeks.
+ *
+ * param metadata   An existing instance; what it held before is dropped.
+ * param handle     The stream.
+ * param callbacks  How to read and seek it.
+ * retval FLAC__MetadataStatus  FLAC__METADATA_OK on success.
+ */
+FLAC_API FLAC__MetadataStatus FLAC__metadata_read_stream(FLAC__Metadata *metadata, FLAC__IOHandle handle, FLAC__IOCallbacks callbacks);
+
+/**
+ * Get the STREAMINFO.
+ *
+ * param metadata   An instance that read a stream successfully.
+ * retval const FLAC__StreamMetadata_StreamInfo*    NULL if there is none.
+ */
+FLAC_API const FLAC__StreamMetadata_StreamInfo *FLAC__metadata_get_stream_info(const FLAC__Metadata *metadata);
+
+/**
+ * Get the offset of the first byte after the metadata, i.e. of the first
+ * frame.
+ *
+ * param metadata   An instance that read a stream successfully.
+ * retval FLAC__uint64  The offset.
+ */
+FLAC_API FLAC__uint64 FLAC__metadata_get_audio_offset(const FLAC__Metadata *metadata);
+
+/**
+ * Get the number of blocks.
+ *
+ * param metadata   An existing instance.
+ * retval unsigned  The number of blocks, in file order.
+ */
+FLAC_API unsigned FLAC__metadata_get_num_blocks(const FLAC__Metadata *metadata);
+
+/**
+ * Find the next block of a type.
+ *
+ * param metadata   An existing instance.
+ * param type       The type to look for.
+ * param start      The index to start looking at, 0 for the first.
+ * retval int       The index of the block, or -1 if there is none.
+ */
+FLAC_API int FLAC__metadata_find_block(const FLAC__Metadata *metadata, unsigned type, unsigned start);
+
+/**
+ * Describe a block.
+ *
+ * param metadata   An existing instance.
+ * param index      The block.
+ * param info       Receives the description.
+ * retval FLAC__bool    false if index is out of range.
+ */
+FLAC_API FLAC__bool FLAC__metadata_get_block_info(const FLAC__Metadata *metadata, unsigned index, FLAC__MetadataBlockInfo *info);
+
+/**
+ * Get the body of a block, loading it if it is lazy. The body stays valid
+ * until FLAC__metadata_release_block_data() on the block, the next read or
+ * FLAC__metadata_delete().
+ *
+ * param metadata   An existing instance.
+ * param index      The block.
+ * retval const FLAC__byte*
+ *      The body, or NULL if index is out of range or the body could not
+ *      be read or allocated. A block of length 0 gives a non-NULL pointer
+ *      that must not be dereferenced.
+ */
+FLAC_API const FLAC__byte *FLAC__metadata_get_block_data(FLAC__Metadata *metadata, unsigned index);
+
+/**
+ * Drop the loaded body of a lazy block, e.g. once the artwork has been
+ * handed on. Small blocks that were read with the headers, and blocks of
+ * a mapped file, are left alone.
+ *
+ * param metadata   An existing instance.
+ * param index      The block.
+ */
+FLAC_API void FLAC__metadata_release_block_data(FLAC__Metadata *metadata, unsigned index);
+
+/**
+ * Copy part of a block's body into a buffer, reading just that range if
+ * the body is not loaded. Nothing is kept.
+ *
+ * param metadata   An existing instance.
+ * param index      The block.
+ * param offset     Where in the body to start.
+ * param buffer     Receives the bytes.
+ * param bytes      How many to copy.
+ * retval FLAC__bool    false if the range is not inside the body or
+ *                      could not be read.
+ */
+FLAC_API FLAC__bool FLAC__metadata_read_block(FLAC__Metadata *metadata, unsigned index, unsigned offset, void *buffer, size_t bytes);
+
+/**
+ * Parse a PICTURE block up to its picture data, which is not read. The
+ * data can then be had with FLAC__metadata_read_block() from offset
+ * picture->data_offset - the block's offset, or as part of
+ * FLAC__metadata_get_block_data(). The strings stay valid as long as the
+ * block does.
+ *
+ * param metadata   An existing instance.
+ * param index      A PICTURE block.
+ * param picture    Receives the fields.
+ * retval FLAC__bool    false if the block is not a PICTURE, is malformed
+ *                      or could not be read.
+ */
+FLAC_API FLAC__bool FLAC__metadata_get_picture(FLAC__Metadata *metadata, unsigned index, FLAC__MetadataPicture *picture);
+
+/**
+ * Set the tags FLAC__metadata_write() is to write. They replace all the
+ * tags of the file; the VORBIS_COMMENT block is added if there is none.
+ * Nothing is written yet, and the next read drops the change.
+ *
+ * param metadata       An instance that read a stream successfully.
+ * param vendor_string  The vendor string, or NULL to keep the file's.
+ * param entries        The tags, "NAME=value" in UTF-8, NUL-terminated.
+ * param num_entries    The number of tags.
+ * retval FLAC__bool    false if the block would be longer than a block
+ *                      can be, or on a memory allocation error.
+ */
+FLAC_API FLAC__bool FLAC__metadata_set_vorbis_comment(FLAC__Metadata *metadata, const char *vendor_string, const char * const entries[], unsigned num_entries);
+
+/**
+ * Set how much PADDING FLAC__metadata_write() leaves when it has to
+ * rewrite the file. The default is FLAC__METADATA_DEFAULT_REWRITE_PADDING.
+ *
+ * param metadata   An existing instance.
+ * param value      The length of the PADDING body, 0 for none; up to
+ *                  2^24-1.
+ * retval FLAC__bool    false if value is out of range, else true.
+ */
+FLAC_API FLAC__bool FLAC__metadata_set_rewrite_padding(FLAC__Metadata *metadata, unsigned value);
+
+/**
+ * Write the tags set with FLAC__metadata_set_vorbis_comment() to the file
+ * the metadata was read from, in place if they fit and by a rewrite
+ * otherwise; see the module description. The file must not have changed
+ * since it was read. Afterwards the metadata is read again from the
+ * written file, so the blocks describe what is on disk.
+ *
+ * A rewrite replaces the file atomically and keeps its permission bits,
+ * but not its owner, links or extended attributes. A write in place is
+ * not atomic: a crash in the middle of it can leave the block headers it
+ * was writing broken. Neither syncs the file in place; the rewrite syncs
+ * the temporary file before the rename.
+ *
+ * param metadata   An instance that read a file with FLAC__metadata_read_file().
+ * param rewritten  If not NULL, set to true if the file was rewritten,
+ *                  false if it was written in place or not at all.
+ * retval FLAC__MetadataStatus
+ *      FLAC__METADATA_OK if the tags were written, or if none were set.
+ *      On an error before the file was changed the metadata is kept as
+ *      it was; else it is read again, or holds no blocks if that fails.
+ */
+FLAC_API FLAC__MetadataStatus FLAC__metadata_write(FLAC__Metadata *metadata, FLAC__bool *rewritten);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !FLAC__METADATA_H
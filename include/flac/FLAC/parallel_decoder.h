@@ -0,0 +1,177 @@
+#ifndef FLAC__PARALLEL_DECODER_H
+#define FLAC__PARALLEL_DECODER_H
+
+#include "export.h"
+#include "format.h"
+#include <stddef.h>     // for size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * This module decodes one native FLAC stream on several cores. Frames
+ * do not depend on each other, so a long recording can be cut into
+ * byte ranges of whole frames that are decoded side by side.
+ *
+ * A FLAC__ParallelDecoder cuts the stream without walking it frame by
+ * frame: the calling thread jumps ahead by a stride of bytes and looks
+ * for the next frame sync code from there. A candidate only counts as a
+ * frame start if its header parses and passes its CRC-8, and the frame
+ * behind it runs up to the next such header with a good CRC-16, so a
+ * sync code inside the audio data does not split anything. The sample
+ * numbers in the headers on either side of a range tell how much audio
+ * it holds; the stride shrinks when that is more than a segment should
+ * hold (silence compresses very well) and grows back when it is less.
+ *
+ * Worker threads decode the ranges into interleaved PCM, see
+ * FLAC__stream_decoder_interleave(), and the calling thread hands the
+ * PCM to the write callback in stream order. The number of ranges in
+ * flight is bounded, so the memory does not grow with the length of the
+ * stream. For an intact stream the PCM is exactly what decoding it from
+ * start to end gives.
+ *
+ * The basic usage is:
+ *  - create a decoder with FLAC__parallel_decoder_new()
+ *  - optionally set the number of threads and the output resolution
+ *  - FLAC__parallel_decoder_decode_file() or
+ *    FLAC__parallel_decoder_decode_memory() with a write callback
+ *  - FLAC__parallel_decoder_delete() it
+ */
+
+/** The largest number of worker threads FLAC__parallel_decoder_set_num_threads() accepts. */
+#define FLAC__PARALLEL_DECODER_MAX_THREADS (64u)
+
+/** How a stream was decoded. */
+typedef enum {
+    /** Every frame decoded. */
+    FLAC__PARALLEL_DECODE_OK = 0,
+
+    /** Some frames were damaged and dropped, there were bytes between
+     * frames that are not frames, or the frames do not add up to the
+     * STREAMINFO total samples; everything that decoded was written. */
+    FLAC__PARALLEL_DECODE_FRAME_ERROR,
+
+    /** The stream is not a native FLAC stream, or its metadata is cut
+     * off or has no STREAMINFO. */
+    FLAC__PARALLEL_DECODE_NOT_FLAC,
+
+    /** The file could not be opened or mapped. */
+    FLAC__PARALLEL_DECODE_IO_ERROR,
+
+    /** The write callback returned false. */
+    FLAC__PARALLEL_DECODE_ABORTED,
+
+    /** Memory allocation failed, or the threads could not be started. */
+    FLAC__PARALLEL_DECODE_MEMORY_ALLOCATION_ERROR
+} FLAC__ParallelDecodeStatus;
+
+/**
+ * Maps a FLAC__ParallelDecodeStatus to a C string.
+ *
+ * Using a FLAC__ParallelDecodeStatus as the index to this array
+ * will give the string equivalent. The contents should not be modified.
+ */
+extern FLAC_API const char * const FLAC__ParallelDecodeStatusString[];
+
+/** What came of decoding one stream. */
+typedef struct {
+    FLAC__ParallelDecodeStatus status;
+
+    /** The number of samples (per channel) written. */
+    FLAC__uint64 samples;
+
+    /** The number of frames that failed a CRC or did not decode. */
+    FLAC__uint64 bad_frames;
+} FLAC__ParallelDecodeResult;
+
+/**
+ * The opaque structure definition for the parallel decoder type.
+ */
+struct FLAC__ParallelDecoder;
+typedef struct FLAC__ParallelDecoder FLAC__ParallelDecoder;
+
+/**
+ * Signature for the write callback. It is called on the thread that
+ * called FLAC__parallel_decoder_decode_file() or
+ * FLAC__parallel_decoder_decode_memory(), with the decoded audio in
+ * stream order, a range of frames at a time.
+ *
+ * param stream_info    The stream's STREAMINFO.
+ * param pcm            'samples' samples of each of stream_info->channels
+ *                      channels, interleaved little-endian signed PCM at
+ *                      the output resolution.
+ * param samples        The number of samples per channel.
+ * param client_data    The callee's client data.
+ * retval FLAC__bool    false to stop decoding.
+ */
+typedef FLAC__bool (*FLAC__ParallelDecoderWriteCallback)(const FLAC__StreamMetadata_StreamInfo *stream_info, const FLAC__byte pcm[], size_t samples, void *client_data);
+
+/**
+ * Create a new parallel decoder instance, set to one worker per
+ * hardware thread and the stream's own resolution.
+ *
+ * retval FLAC__ParallelDecoder*    NULL if there was an error allocating memory, else the new instance.
+ */
+FLAC_API FLAC__ParallelDecoder *FLAC__parallel_decoder_new(void);
+
+/**
+ * Free a parallel decoder instance.
+ *
+ * param decoder    A pointer to an existing decoder, or NULL.
+ */
+FLAC_API void FLAC__parallel_decoder_delete(FLAC__ParallelDecoder *decoder);
+
+/**
+ * Set the number of threads that decode. 1 decodes on the calling
+ * thread; above 1, that many worker threads are started for each
+ * stream and the calling thread only cuts the stream and writes. 0
+ * means one worker per hardware thread.
+ *
+ * param decoder    A decoder instance to set.
+ * param value      See above.
+ * retval FLAC__bool    false if value is above FLAC__PARALLEL_DECODER_MAX_THREADS, else true.
+ */
+FLAC_API FLAC__bool FLAC__parallel_decoder_set_num_threads(FLAC__ParallelDecoder *decoder, unsigned value);
+
+/**
+ * Set the resolution of the PCM handed to the write callback; the
+ * samples are scaled as by FLAC__stream_decoder_interleave().
+ *
+ * param decoder    A decoder instance to set.
+ * param value      FLAC__MIN_BITS_PER_SAMPLE to FLAC__MAX_BITS_PER_SAMPLE,
+ *                  or 0 for the stream's bits-per-sample.
+ * retval FLAC__bool    false if value is out of range, else true.
+ */
+FLAC_API FLAC__bool FLAC__parallel_decoder_set_bits_per_sample(FLAC__ParallelDecoder *decoder, unsigned value);
+
+/**
+ * Decode a FLAC file, mapped with FLAC__mapped_file_open().
+ *
+ * param decoder        A decoder instance.
+ * param filename       The file to decode.
+ * param callback       The write callback.
+ * param client_data    Passed back to the callback.
+ * param result         If not NULL, receives what came of it.
+ * retval FLAC__bool    true if the status is FLAC__PARALLEL_DECODE_OK.
+ */
+FLAC_API FLAC__bool FLAC__parallel_decoder_decode_file(FLAC__ParallelDecoder *decoder, const char *filename, FLAC__ParallelDecoderWriteCallback callback, void *client_data, FLAC__ParallelDecodeResult *result);
+
+/**
+ * Decode a FLAC stream in memory.
+ *
+ * param decoder        A decoder instance.
+ * param data           The stream.
+ * param bytes          The size of the stream in bytes.
+ * param callback       The write callback.
+ * param client_data    Passed back to the callback.
+ * param result         If not NULL, receives what came of it.
+ * retval FLAC__bool    true if the status is FLAC__PARALLEL_DECODE_OK.
+ */
+FLAC_API FLAC__bool FLAC__parallel_decoder_decode_memory(FLAC__ParallelDecoder *decoder, const FLAC__byte *data, size_t bytes, FLAC__ParallelDecoderWriteCallback callback, void *client_data, FLAC__ParallelDecodeResult *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !FLAC__PARALLEL_DECODER_H
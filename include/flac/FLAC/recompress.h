@@ -0,0 +1,160 @@
+#ifndef FLAC__RECOMPRESS_H
+#define FLAC__RECOMPRESS_H
+
+#include "export.h"
+#include "callback.h"
+#include "format.h"
+#include <stddef.h>     // for size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * This module rewrites a native FLAC stream smaller without encoding
+ * it again. Most of an encoder's time goes into the analysis: windows,
+ * autocorrelation, LPC orders and coefficient precisions. A stream made
+ * at a low effort already carries a predictor for every subframe, and
+ * what a low effort mostly gives away is in the residual coding: few
+ * partition orders tried, and Rice parameters estimated from partition
+ * sums instead of counted.
+ *
+ * A FLAC__Recompressor decodes each frame and keeps its subframes as
+ * they were coded, see FLAC__stream_decoder_get_frame(): the same
+ * predictors, warmup samples, wasted bits, channel assignment and frame
+ * header. Only the residual is coded again, with the partition order,
+ * the Rice parameters and escapes chosen by their exact cost. A frame
+ * that does not come out smaller is copied as it was, so the stream
+ * never grows; the decoded audio is the same bit for bit.
+ *
+ * The metadata is copied as it is. The frame sizes in STREAMINFO and the
+ * offsets in SEEKTABLE are updated at the end if the output can seek
+ * back; otherwise the seek points are written as placeholders.
+ *
+ * The block layout stays as it is: splitting or merging blocks needs
+ * new predictors, which is the encoder's job.
+ *
+ * The basic usage is:
+ *  - create a recompressor with FLAC__recompressor_new()
+ *  - optionally set the largest partition order to try
+ *  - FLAC__recompressor_recompress_file() or
+ *    FLAC__recompressor_recompress_memory()
+ *  - FLAC__recompressor_delete() it
+ */
+
+/** How a stream was recompressed. */
+typedef enum {
+    /** Every frame was rewritten or copied. */
+    FLAC__RECOMPRESS_OK = 0,
+
+    /** A frame did not decode, or there are bytes between or after the
+     * frames that are not frames. Damaged streams are not rewritten; the
+     * output is incomplete. */
+    FLAC__RECOMPRESS_FRAME_ERROR,
+
+    /** The stream is not a native FLAC stream, or its metadata is cut
+     * off or has no STREAMINFO. */
+    FLAC__RECOMPRESS_NOT_FLAC,
+
+    /** A file could not be opened, mapped or written, the output is the
+     * input, or a callback failed. */
+    FLAC__RECOMPRESS_IO_ERROR,
+
+    /** Memory allocation failed. */
+    FLAC__RECOMPRESS_MEMORY_ALLOCATION_ERROR
+} FLAC__RecompressStatus;
+
+/**
+ * Maps a FLAC__RecompressStatus to a C string.
+ *
+ * Using a FLAC__RecompressStatus as the index to this array
+ * will give the string equivalent. The contents should not be modified.
+ */
+extern FLAC_API const char * const FLAC__RecompressStatusString[];
+
+/** What came of recompressing one stream. */
+typedef struct {
+    FLAC__RecompressStatus status;
+
+    /** The number of frames written. */
+    FLAC__uint64 frames;
+
+    /** Of those, the number copied as they were because recoding did not
+     * make them smaller. */
+    FLAC__uint64 frames_kept;
+
+    /** The size of the input stream in bytes. */
+    FLAC__uint64 bytes_in;
+
+    /** The number of bytes written. */
+    FLAC__uint64 bytes_out;
+} FLAC__RecompressResult;
+
+/**
+ * The opaque structure definition for the recompressor type.
+ */
+struct FLAC__Recompressor;
+typedef struct FLAC__Recompressor FLAC__Recompressor;
+
+/**
+ * Create a new recompressor instance, set to partition orders up to
+ * FLAC__SUBSET_MAX_RICE_PARTITION_ORDER.
+ *
+ * retval FLAC__Recompressor*    NULL if there was an error allocating memory, else the new instance.
+ */
+FLAC_API FLAC__Recompressor *FLAC__recompressor_new(void);
+
+/**
+ * Free a recompressor instance.
+ *
+ * param recompressor    A pointer to an existing recompressor, or NULL.
+ */
+FLAC_API void FLAC__recompressor_delete(FLAC__Recompressor *recompressor);
+
+/**
+ * Set the largest residual partition order to try. Every order up to
+ * this one that the blocksize and predictor order allow is costed
+ * exactly; above FLAC__SUBSET_MAX_RICE_PARTITION_ORDER the stream is no
+ * longer in the streamable subset. The Rice parameters go up to 30
+ * (the extended coding) only where the stream's bits-per-sample is
+ * above 16 or the frame used the extended coding already.
+ *
+ * param recompressor    A recompressor instance to set.
+ * param value           0 to FLAC__MAX_RICE_PARTITION_ORDER.
+ * retval FLAC__bool    false if value is out of range, else true.
+ */
+FLAC_API FLAC__bool FLAC__recompressor_set_max_residual_partition_order(FLAC__Recompressor *recompressor, unsigned value);
+
+/**
+ * Recompress a FLAC file, mapped with FLAC__mapped_file_open(), into a
+ * new file. The output file is created or truncated; it must not be the
+ * input.
+ *
+ * param recompressor    A recompressor instance.
+ * param input           The file to read.
+ * param output          The file to write.
+ * param result          If not NULL, receives what came of it.
+ * retval FLAC__bool    true if the status is FLAC__RECOMPRESS_OK.
+ */
+FLAC_API FLAC__bool FLAC__recompressor_recompress_file(FLAC__Recompressor *recompressor, const char *input, const char *output, FLAC__RecompressResult *result);
+
+/**
+ * Recompress a FLAC stream in memory through a set of callbacks.
+ *
+ * param recompressor    A recompressor instance.
+ * param data            The stream.
+ * param bytes           The size of the stream in bytes.
+ * param handle          The handle to the output, passed back to every callback.
+ * param callbacks       Write is required. If seek and tell are set as
+ *                       well, STREAMINFO and SEEKTABLE are updated at the
+ *                       end, as FLAC__stream_encoder_finish() does.
+ * param result          If not NULL, receives what came of it.
+ * retval FLAC__bool    true if the status is FLAC__RECOMPRESS_OK.
+ */
+FLAC_API FLAC__bool FLAC__recompressor_recompress_memory(FLAC__Recompressor *recompressor, const FLAC__byte *data, size_t bytes, FLAC__IOHandle handle, FLAC__IOCallbacks callbacks, FLAC__RecompressResult *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !FLAC__RECOMPRESS_H
@@ -0,0 +1,235 @@
+#ifndef FLAC__SCAN_H
+#define FLAC__SCAN_H
+
+#include "export.h"
+#include "callback.h"
+#include "format.h"
+#include <stddef.h>     // for size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * This module reads the metadata of FLAC files and nothing else: the
+ * STREAMINFO, the tags in the VORBIS_COMMENT block and where the
+ * PICTURE blocks are, stopping at the first audio frame. It is built for
+ * reindexing large libraries, where reading any more of a file than its
+ * metadata is what makes a scan slow.
+ *
+ * The file is read in reads of FLAC__SCAN_READ_SIZE bytes at the offsets
+ * the metadata needs. The first read usually holds the marker,
+ * STREAMINFO and the tags; blocks that are not needed (PICTURE, PADDING,
+ * SEEKTABLE, ...) are stepped over with a seek instead of being read, so
+ * a large embedded picture costs nothing. The only other read is for
+ * whatever comes after them, or for tags that do not fit in the first
+ * read.
+ *
+ * FLAC__scanner_scan_files() keeps many files in flight at once. On
+ * Linux it queues the opens, reads and closes on an io_uring, so the
+ * calling thread never blocks on a single file and the disk sees a deep
+ * queue; where io_uring is not available (older kernels, a seccomp
+ * filter) it falls back to open() and pread() on the calling thread.
+ *
+ * The basic usage is:
+ *  - create a scanner with FLAC__scanner_new()
+ *  - FLAC__scanner_scan_files() with the file names and a callback, or
+ *    FLAC__scanner_scan_file() / FLAC__scanner_scan_stream() for one
+ *  - FLAC__scanner_delete() it
+ */
+
+/** The size of the reads the scanner makes. */
+#define FLAC__SCAN_READ_SIZE (4096u)
+
+/** The largest number of files FLAC__scanner_set_queue_depth() lets be in flight. */
+#define FLAC__SCANNER_MAX_QUEUE_DEPTH (4096u)
+
+/** What became of a file. */
+typedef enum {
+    /** The metadata was read up to the first audio frame. */
+    FLAC__SCAN_OK = 0,
+
+    /** The file is not a native FLAC stream, or it has no STREAMINFO. */
+    FLAC__SCAN_NOT_FLAC,
+
+    /** The file ends inside its metadata. */
+    FLAC__SCAN_TRUNCATED,
+
+    /** The file could not be opened or read. */
+    FLAC__SCAN_IO_ERROR,
+
+    /** Memory allocation failed. */
+    FLAC__SCAN_MEMORY_ALLOCATION_ERROR
+} FLAC__ScanStatus;
+
+/**
+ * Maps a FLAC__ScanStatus to a C string.
+ *
+ * Using a FLAC__ScanStatus as the index to this array
+ * will give the string equivalent. The contents should not be modified.
+ */
+extern FLAC_API const char * const FLAC__ScanStatusString[];
+
+/** Where a metadata block's body is in the file. */
+typedef struct {
+    /** The offset of the first byte after the block's 4-byte header. */
+    FLAC__uint64 offset;
+
+    /** The length of the body in bytes. */
+    unsigned length;
+} FLAC__ScanBlock;
+
+/** One VORBIS_COMMENT entry, "NAME=value" in UTF-8, not NUL-terminated. */
+typedef struct {
+    const char *entry;
+    unsigned length;
+} FLAC__ScanComment;
+
+/**
+ * What was found in one file. The strings and arrays belong to the
+ * scanner; see the scan functions for how long they stay valid.
+ */
+typedef struct {
+    FLAC__ScanStatus status;
+
+    /** Valid if status is FLAC__SCAN_OK. */
+    FLAC__StreamMetadata_StreamInfo stream_info;
+
+    /** The offset of the first byte after the metadata, i.e. of the
+     * first frame, if status is FLAC__SCAN_OK. */
+    FLAC__uint64 audio_offset;
+
+    /** How many bytes were read from the file. */
+    FLAC__uint64 bytes_read;
+
+    /** The number of metadata blocks seen. */
+    unsigned num_blocks;
+
+    /** true if the file has a VORBIS_COMMENT block. A block that is
+     * malformed gives the entries up to where it goes wrong. */
+    FLAC__bool has_vorbis_comment;
+    FLAC__ScanBlock vorbis_comment;
+    const char *vendor_string;
+    unsigned vendor_string_length;
+    unsigned num_comments;
+    const FLAC__ScanComment *comments;
+
+    /** The PICTURE blocks, in file order; only where they are, nothing of
+     * them is read. */
+    unsigned num_pictures;
+    const FLAC__ScanBlock *pictures;
+} FLAC__ScanResult;
+
+
+/**
+ * The opaque structure definition for the scanner type.
+ */
+struct FLAC__Scanner;
+typedef struct FLAC__Scanner FLAC__Scanner;
+
+/**
+ * Signature for the callback that FLAC__scanner_scan_files() calls as
+ * soon as a file is finished. Files finish in whatever order their reads
+ * complete. The callback is called on the calling thread; 'result' and
+ * everything it points to are only valid until it returns.
+ *
+ * param filename       The name of the file, as given.
+ * param file_index     Its position in the list.
+ * param result         What was found.
+ * param client_data    The callee's client data passed to
+ *                      FLAC__scanner_scan_files().
+ */
+typedef void (*FLAC__ScannerCallback)(const char *filename, size_t file_index, const FLAC__ScanResult *result, void *client_data);
+
+/**
+ * Create a new scanner instance, with a queue depth of 64 and io_uring
+ * allowed.
+ *
+ * retval FLAC__Scanner*    NULL if there was an error allocating memory, else the new instance.
+ */
+FLAC_API FLAC__Scanner *FLAC__scanner_new(void);
+
+/**
+ * Free a scanner instance.
+ *
+ * param scanner    A pointer to an existing scanner, or NULL.
+ */
+FLAC_API void FLAC__scanner_delete(FLAC__Scanner *scanner);
+
+/**
+ * Set how many files FLAC__scanner_scan_files() keeps in flight. Each
+ * one holds a read buffer of FLAC__SCAN_READ_SIZE bytes, more if its
+ * tags are larger. Without io_uring the files are scanned one at a time
+ * and this only has to be valid.
+ *
+ * param scanner    A scanner instance to set.
+ * param value      1 to FLAC__SCANNER_MAX_QUEUE_DEPTH.
+ * retval FLAC__bool    false if value is out of range, else true.
+ */
+FLAC_API FLAC__bool FLAC__scanner_set_queue_depth(FLAC__Scanner *scanner, unsigned value);
+
+/**
+ * Allow or forbid FLAC__scanner_scan_files() to use io_uring. With
+ * false it always takes the open() and pread() path.
+ *
+ * param scanner    A scanner instance to set.
+ * param value      See above.
+ * retval FLAC__bool    true.
+ */
+FLAC_API FLAC__bool FLAC__scanner_set_use_io_uring(FLAC__Scanner *scanner, FLAC__bool value);
+
+/**
+ * Tell whether the last FLAC__scanner_scan_files() ran on an io_uring.
+ *
+ * param scanner    A scanner instance.
+ * retval FLAC__bool    true if it did.
+ */
+FLAC_API FLAC__bool FLAC__scanner_used_io_uring(const FLAC__Scanner *scanner);
+
+/**
+ * Scan a stream read through callbacks, from its current position.
+ * Only callbacks.read is required. If callbacks.seek is set, blocks that
+ * are not needed are skipped with seeks relative to the current position
+ * (SEEK_CUR); otherwise they are read and thrown away. The offsets in
+ * the result are relative to where the stream was when the scan started.
+ * The stream is left somewhere inside or after the metadata.
+ *
+ * 'result' points into the scanner until the next scan with it or until
+ * it is deleted.
+ *
+ * param scanner    A scanner instance.
+ * param handle     The stream.
+ * param callbacks  How to read it.
+ * param result     Receives what was found.
+ * retval FLAC__bool    true if result->status is FLAC__SCAN_OK.
+ */
+FLAC_API FLAC__bool FLAC__scanner_scan_stream(FLAC__Scanner *scanner, FLAC__IOHandle handle, FLAC__IOCallbacks callbacks, FLAC__ScanResult *result);
+
+/**
+ * Scan one file on the calling thread with pread(). 'result' points into
+ * the scanner until the next scan with it or until it is deleted.
+ *
+ * param scanner    A scanner instance.
+ * param filename   The file to scan.
+ * param result     Receives what was found.
+ * retval FLAC__bool    true if result->status is FLAC__SCAN_OK.
+ */
+FLAC_API FLAC__bool FLAC__scanner_scan_file(FLAC__Scanner *scanner, const char *filename, FLAC__ScanResult *result);
+
+/**
+ * Scan a list of files, up to the queue depth at a time.
+ *
+ * param scanner        A scanner instance.
+ * param filenames      The files to scan.
+ * param num_files      The number of files.
+ * param callback       Called for every finished file, may be NULL.
+ * param client_data    Passed back to the callback.
+ * retval FLAC__bool    true if every file is FLAC__SCAN_OK.
+ */
+FLAC_API FLAC__bool FLAC__scanner_scan_files(FLAC__Scanner *scanner, const char * const filenames[], size_t num_files, FLAC__ScannerCallback callback, void *client_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !FLAC__SCAN_H
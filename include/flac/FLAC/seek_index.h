@@ -0,0 +1,168 @@
+#ifndef FLAC__SEEK_INDEX_H
+#define FLAC__SEEK_INDEX_H
+
+#include "export.h"
+#include "callback.h"
+#include "format.h"
+#include <stddef.h>     // for size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * This module builds and keeps a seek index for a FLAC stream: a sorted
+ * list of seek points (sample number, frame offset, frame size) that
+ * FLAC__stream_decoder_seek_absolute() uses to jump to any sample
+ * without decoding from the start.
+ *
+ * If the stream carries a SEEKTABLE block with usable points, those are
+ * the index. Otherwise the frames are found in a single pass that only
+ * parses frame headers and checks CRCs, nothing is decoded, and every
+ * frame becomes a seek point; a seek then lands on the very frame that
+ * holds the sample. Offsets are relative to the first byte after the
+ * metadata, like SEEKTABLE offsets.
+ *
+ * Building an index reads the whole stream, so it can be saved to a
+ * small file next to the FLAC file and loaded next time;
+ * FLAC__seek_index_open() does all of that for a file on disk.
+ *
+ * The basic usage is:
+ *  - create an index with FLAC__seek_index_new()
+ *  - FLAC__seek_index_open() the FLAC file, or build it from a stream
+ *    with FLAC__seek_index_build() or FLAC__seek_index_build_memory()
+ *  - pass it to FLAC__stream_decoder_seek_absolute() as often as needed
+ *  - FLAC__seek_index_delete() it
+ */
+
+/** The suffix of the file FLAC__seek_index_open() keeps the index in,
+ * appended to the name of the FLAC file. */
+#define FLAC__SEEK_INDEX_FILE_SUFFIX ".seekidx"
+
+/**
+ * The opaque structure definition for the seek index type.
+ */
+struct FLAC__SeekIndex;
+typedef struct FLAC__SeekIndex FLAC__SeekIndex;
+
+/**
+ * Create a new, empty seek index.
+ *
+ * retval FLAC__SeekIndex*  NULL if there was an error allocating memory, else the new instance.
+ */
+FLAC_API FLAC__SeekIndex *FLAC__seek_index_new(void);
+
+/**
+ * Free a seek index instance.
+ *
+ * param index  A pointer to an existing index, or NULL.
+ */
+FLAC_API void FLAC__seek_index_delete(FLAC__SeekIndex *index);
+
+/**
+ * Build the index from a stream read through callbacks, starting at the
+ * current position of the handle, which should be the start of the
+ * stream (an ID3v2 tag is skipped). The read callback is required; if
+ * seek is set, metadata blocks are seeked over. The handle is left
+ * wherever reading stopped.
+ *
+ * param index      An existing index; its previous contents are dropped.
+ * param handle     The handle to the data source.
+ * param callbacks  The I/O callbacks.
+ * retval FLAC__bool    false if the read callback is missing, the
+ *                      metadata is cut off, or memory ran out.
+ */
+FLAC_API FLAC__bool FLAC__seek_index_build(FLAC__SeekIndex *index, FLAC__IOHandle handle, FLAC__IOCallbacks callbacks);
+
+/**
+ * Build the index from a stream in memory, e.g. a file mapped with
+ * FLAC__mapped_file_open(). Same as FLAC__seek_index_build() without
+ * copying the data.
+ *
+ * param index  An existing index; its previous contents are dropped.
+ * param data   The stream.
+ * param bytes  The size of the stream in bytes.
+ * retval FLAC__bool    false if the metadata is cut off or memory ran out.
+ */
+FLAC_API FLAC__bool FLAC__seek_index_build_memory(FLAC__SeekIndex *index, const FLAC__byte *data, size_t bytes);
+
+/**
+ * Write the index to a file. The file is written under a unique
+ * temporary name next to it and renamed into place, so readers never see
+ * half an index and concurrent saves do not mix; the last rename wins.
+ * A file that is replaced keeps its permissions.
+ *
+ * param index      A built index.
+ * param filename   The file to write.
+ * retval FLAC__bool    false if the file could not be written.
+ */
+FLAC_API FLAC__bool FLAC__seek_index_save(const FLAC__SeekIndex *index, const char *filename);
+
+/**
+ * Read an index written by FLAC__seek_index_save(). Nothing checks that
+ * it still belongs to the stream; see FLAC__seek_index_open().
+ *
+ * param index      An existing index; replaced only on success.
+ * param filename   The file to read.
+ * retval FLAC__bool    false if the file could not be read, is not an
+ *                      index or is damaged.
+ */
+FLAC_API FLAC__bool FLAC__seek_index_load(FLAC__SeekIndex *index, const char *filename);
+
+/**
+ * Get the index of a FLAC file, reusing the one saved next to it. The
+ * file "<filename>" FLAC__SEEK_INDEX_FILE_SUFFIX is loaded if it matches
+ * the file (same size, same metadata length, same STREAMINFO); otherwise
+ * the index is built from the file and saved there. Not being able to
+ * save it (e.g. a read-only directory) is not an error.
+ *
+ * param index      An existing index.
+ * param filename   The FLAC file.
+ * retval FLAC__bool    false if the FLAC file could not be read or
+ *                      the index could not be built.
+ */
+FLAC_API FLAC__bool FLAC__seek_index_open(FLAC__SeekIndex *index, const char *filename);
+
+/**
+ * Get the STREAMINFO of the indexed stream.
+ *
+ * param index  A built index.
+ * retval const FLAC__StreamMetadata_StreamInfo*
+ *      The stream info, or NULL if the stream has no STREAMINFO block.
+ */
+FLAC_API const FLAC__StreamMetadata_StreamInfo *FLAC__seek_index_get_stream_info(const FLAC__SeekIndex *index);
+
+/**
+ * Get the offset of the first frame, i.e. the first byte after the
+ * metadata, from the start of the indexed stream.
+ *
+ * param index  A built index.
+ * retval FLAC__uint64  The offset in bytes.
+ */
+FLAC_API FLAC__uint64 FLAC__seek_index_get_first_frame_offset(const FLAC__SeekIndex *index);
+
+/**
+ * Get the seek points, sorted by sample number.
+ *
+ * param index      A built index.
+ * param num_points Receives the number of points.
+ * retval const FLAC__StreamMetadata_SeekPoint*     The points.
+ */
+FLAC_API const FLAC__StreamMetadata_SeekPoint *FLAC__seek_index_get_points(const FLAC__SeekIndex *index, size_t *num_points);
+
+/**
+ * Find the seek point to start decoding from to reach a sample: the last
+ * point at or before it. This is a binary search.
+ *
+ * param index  A built index.
+ * param sample The target sample number.
+ * param point  Receives the seek point.
+ * retval FLAC__bool    false if there is no point at or before 'sample'.
+ */
+FLAC_API FLAC__bool FLAC__seek_index_lookup(const FLAC__SeekIndex *index, FLAC__uint64 sample, FLAC__StreamMetadata_SeekPoint *point);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !FLAC__SEEK_INDEX_H
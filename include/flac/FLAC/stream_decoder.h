@@ -0,0 +1,582 @@
+#ifndef FLAC__STREAM_DECODER_H
+#define FLAC__STREAM_DECODER_H
+
+#include "export.h"
+#include "callback.h"
+#include "format.h"
+#include "seek_index.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * This module describes the stream decoder, which pulls a native FLAC
+ * stream through a set of FLAC__IOCallbacks and decodes it one frame at
+ * a time.
+ *
+ * The decoder never owns the decoded audio. The client passes in one
+ * FLAC__int32 buffer per channel on every call to
+ * FLAC__stream_decoder_decode_frame() and the subframes are restored
+ * straight into them. All working memory (bit buffer, residual and
+ * partition scratch) is allocated once, when STREAMINFO is read, so
+ * decoding a frame never touches the heap.
+ *
+ * The basic usage is:
+ *  - create a decoder with FLAC__stream_decoder_new()
+ *  - optionally set an error callback
+ *  - call FLAC__stream_decoder_init() with the handle and callbacks
+ *  - call FLAC__stream_decoder_process_until_end_of_metadata() and size
+ *    the channel buffers from FLAC__stream_decoder_get_stream_info()
+ *  - call FLAC__stream_decoder_decode_frame() until it returns false
+ *  - call FLAC__stream_decoder_finish(), then either re-init or delete
+ *
+ * Of the callbacks, read is required. If eof is set it is used to detect
+ * the end of the stream, otherwise a short read of zero bytes is. If seek
+ * and tell are set, metadata blocks the decoder does not need (PICTURE,
+ * PADDING, ...) are skipped with a seek instead of being read, and the
+ * decode position is reported as an absolute stream offset. With seek
+ * and a FLAC__SeekIndex, FLAC__stream_decoder_seek_absolute() jumps to
+ * any sample.
+ *
+ * For live streams the decoder can also be driven the other way round:
+ * after FLAC__stream_decoder_init_push() the client hands over the bytes
+ * as they come in, in chunks of any size, with FLAC__stream_decoder_push(),
+ * and every frame is decoded and passed to a frame callback from inside
+ * the push that delivers its last byte. See FLAC__stream_decoder_push()
+ * for how the end of a frame is found without waiting for the next one;
+ * FLAC__stream_decoder_push_end_of_stream() deals with what is left over
+ * when the stream ends.
+ *
+ * Ogg FLAC is decoded with FLAC__stream_decoder_init_ogg() or
+ * FLAC__stream_decoder_init_ogg_memory() instead of the native inits;
+ * everything after that is the same.
+ *
+ * For playback or writing WAV, FLAC__stream_decoder_decode_frame_interleaved()
+ * returns interleaved little-endian PCM at any resolution instead, and
+ * FLAC__stream_decoder_interleave() converts frames decoded the other ways.
+ */
+
+/**
+ * State values for a FLAC__StreamDecoder
+ *
+ * The decoder's state can be obtained by calling FLAC__stream_decoder_get_state().
+ */
+typedef enum {
+    /** The decoder is ready to search for metadata. */
+    FLAC__STREAM_DECODER_SEARCH_FOR_METADATA = 0,
+
+    /** The decoder is ready to or is in the process of reading metadata. */
+    FLAC__STREAM_DECODER_READ_METADATA,
+
+    /** The decoder is ready to or is in the process of searching for the
+     * frame sync code. */
+    FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC,
+
+    /** The decoder is ready to or is in the process of reading a frame. */
+    FLAC__STREAM_DECODER_READ_FRAME,
+
+    /** The decoder has reached the end of the stream. */
+    FLAC__STREAM_DECODER_END_OF_STREAM,
+
+    /** An error occurred while seeking. Decoding can only continue
+     * after another FLAC__stream_decoder_seek_absolute() succeeds. */
+    FLAC__STREAM_DECODER_SEEK_ERROR,
+
+    /** The decoder was aborted, e.g. because a frame did not fit into the
+     * caller's buffers or the read callback failed. */
+    FLAC__STREAM_DECODER_ABORTED,
+
+    /** An error occurred allocating memory. The decoder is in an invalid
+     * state and can no longer be used. */
+    FLAC__STREAM_DECODER_MEMORY_ALLOCATION_ERROR,
+
+    /** The decoder is in the uninitialized state; one of the
+     * FLAC__stream_decoder_init() routines must be called before samples
+     * can be processed.
+     */
+    FLAC__STREAM_DECODER_UNINITIALIZED
+} FLAC__StreamDecoderState;
+
+/**
+ * Maps a FLAC__StreamDecoderState to a C string.
+ *
+ * Using a FLAC__StreamDecoderState as the index to this array
+ * will give the string equivalent. The contents should not be modified.
+ */
+extern FLAC_API const char * const FLAC__StreamDecoderStateString[];
+
+/** Possible return values for the FLAC__stream_decoder_init() function. */
+typedef enum {
+    /** Initialization was successful. */
+    FLAC__STREAM_DECODER_INIT_STATUS_OK = 0,
+
+    /** A required callback was not supplied. */
+    FLAC__STREAM_DECODER_INIT_STATUS_INVALID_CALLBACKS,
+
+    /** An error occurred allocating memory. */
+    FLAC__STREAM_DECODER_INIT_STATUS_MEMORY_ALLOCATION_ERROR,
+
+    /** FLAC__stream_decoder_init() was called when the decoder was
+     * already initialized, usually because
+     * FLAC__stream_decoder_finish() was not called.
+     */
+    FLAC__STREAM_DECODER_INIT_STATUS_ALREADY_INITIALIZED
+} FLAC__StreamDecoderInitStatus;
+
+/**
+ * Maps a FLAC__StreamDecoderInitStatus to a C string.
+ *
+ * Using a FLAC__StreamDecoderInitStatus as the index to this array
+ * will give the string equivalent. The contents should not be modified.
+ */
+extern FLAC_API const char * const FLAC__StreamDecoderInitStatusString[];
+
+/** Possible values passed back to the FLAC__StreamDecoder error callback.
+ * FLAC__STREAM_DECODER_ERROR_STATUS_LOST_SYNC is the generic catch-all
+ * for all the others; the decoder always resynchronizes on the next frame
+ * sync code after reporting one of them.
+ */
+typedef enum {
+    /** An error in the stream caused the decoder to lose synchronization. */
+    FLAC__STREAM_DECODER_ERROR_STATUS_LOST_SYNC,
+
+    /** The decoder encountered a corrupted frame header. */
+    FLAC__STREAM_DECODER_ERROR_STATUS_BAD_HEADER,
+
+    /** The frame's data did not match the CRC in the footer. */
+    FLAC__STREAM_DECODER_ERROR_STATUS_FRAME_CRC_MISMATCH,
+
+    /** The decoder encountered reserved fields in use in the stream. */
+    FLAC__STREAM_DECODER_ERROR_STATUS_UNPARSEABLE_STREAM
+} FLAC__StreamDecoderErrorStatus;
+
+/**
+ * Maps a FLAC__StreamDecoderErrorStatus to a C string.
+ *
+ * Using a FLAC__StreamDecoderErrorStatus as the index to this array
+ * will give the string equivalent. The contents should not be modified.
+ */
+extern FLAC_API const char * const FLAC__StreamDecoderErrorStatusString[];
+
+
+/***********************************************************************
+ *
+ * class FLAC__StreamDecoder
+ *
+ ***********************************************************************/
+
+/**
+ * The opaque structure definition for the stream decoder type.
+ * See the module documentation above for usage.
+ */
+struct FLAC__StreamDecoder;
+typedef struct FLAC__StreamDecoder FLAC__StreamDecoder;
+
+/**
+ * Signature for the error callback.
+ *
+ * A frame that fails its header CRC-8, its footer CRC-16 or that cannot
+ * be parsed is reported here and then dropped; it is never written to
+ * the client's buffers.
+ *
+ * param decoder    The decoder instance calling the callback.
+ * param status     The error encountered by the decoder.
+ * param client_data    The callee's client data set through
+ *                      FLAC__stream_decoder_set_error_callback().
+ */
+typedef void (*FLAC__StreamDecoderErrorCallback)(const FLAC__StreamDecoder *decoder, FLAC__StreamDecoderErrorStatus status, void *client_data);
+
+/**
+ * Signature for the frame callback of a push decoder, called once for
+ * every frame that decodes, in stream order.
+ *
+ * param decoder    The decoder instance calling the callback.
+ * param header     The frame's header; a frame number is converted to
+ *                  a sample number.
+ * param buffer     One array of header->blocksize samples per channel,
+ *                  owned by the decoder and only valid during the call.
+ * param client_data    The callee's client data passed to
+ *                      FLAC__stream_decoder_init_push().
+ * retval FLAC__bool    false to stop decoding; the push returns false
+ *                      and the decoder is left in FLAC__STREAM_DECODER_ABORTED.
+ */
+typedef FLAC__bool (*FLAC__StreamDecoderFrameCallback)(const FLAC__StreamDecoder *decoder, const FLAC__FrameHeader *header, const FLAC__int32 * const buffer[], void *client_data);
+
+
+/***********************************************************************
+ *
+ * Class constructor/destructor
+ *
+ ***********************************************************************/
+
+/**
+ * Create a new stream decoder instance. The instance is created with
+ * default settings; see the individual FLAC__stream_decoder_set_*()
+ * functions for each setting's default.
+ *
+ * retval FLAC__StreamDecoder*  NULL if there was an error allocating memory, else the new instance.
+ */
+FLAC_API FLAC__StreamDecoder *FLAC__stream_decoder_new(void);
+
+/**
+ * Free a decoder instance. Deletes the object pointed to by decoder.
+ *
+ * param decoder    A pointer to an existing decoder.
+ */
+FLAC_API void FLAC__stream_decoder_delete(FLAC__StreamDecoder *decoder);
+
+
+/***********************************************************************
+ *
+ * Public class method prototypes
+ *
+ ***********************************************************************/
+
+/**
+ * Set the error callback. Default is none.
+ *
+ * param decoder    A decoder instance to set.
+ * param callback   The error callback, or NULL.
+ * param client_data    Passed back to the callback.
+ * retval FLAC__bool    false if the decoder is already initialized, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_decoder_set_error_callback(FLAC__StreamDecoder *decoder, FLAC__StreamDecoderErrorCallback callback, void *client_data);
+
+/**
+ * Get the current decoder state.
+ *
+ * param decoder    A decoder instance to query.
+ * retval FLAC__StreamDecoderState  The current decoder state.
+ */
+FLAC_API FLAC__StreamDecoderState FLAC__stream_decoder_get_state(const FLAC__StreamDecoder *decoder);
+
+/**
+ * Get the current decoder state as a C string.
+ *
+ * param decoder    A decoder instance to query.
+ * retval const char*   The decoder state as a C string. Do not modify the contents.
+ */
+FLAC_API const char *FLAC__stream_decoder_get_resolved_state_string(const FLAC__StreamDecoder *decoder);
+
+/**
+ * Get the STREAMINFO of the stream being decoded. This is only valid
+ * after FLAC__stream_decoder_process_until_end_of_metadata() has
+ * returned true.
+ *
+ * param decoder    A decoder instance to query.
+ * retval const FLAC__StreamMetadata_StreamInfo*
+ *      The stream info, or NULL if the stream has no STREAMINFO block (yet).
+ */
+FLAC_API const FLAC__StreamMetadata_StreamInfo *FLAC__stream_decoder_get_stream_info(const FLAC__StreamDecoder *decoder);
+
+/**
+ * Returns the absolute stream position of the next byte the decoder
+ * will consume, i.e. the position just past the last decoded frame.
+ * The position is relative to where the handle was when
+ * FLAC__stream_decoder_init() was called, unless a tell callback was
+ * given, in which case it is the absolute offset.
+ *
+ * param decoder    A decoder instance to query.
+ * param position   Address at which to return the position.
+ * retval FLAC__bool    false if the decoder is not initialized, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_decoder_get_decode_position(const FLAC__StreamDecoder *decoder, FLAC__uint64 *position);
+
+/**
+ * Get the last frame decoded, as it was coded: the channel assignment,
+ * and for each subframe its type, wasted bits, predictor, warmup
+ * samples, entropy coding method and residual. This is what
+ * re-encoding a frame without analysing it again starts from, see
+ * FLAC/recompress.h. The frame number is converted to a sample number.
+ *
+ * The warmup samples and constant values are after the wasted bits
+ * were shifted out. VERBATIM subframes keep no data; their samples are
+ * only in the decoded output.
+ *
+ * param decoder    A decoder instance to query.
+ * retval const FLAC__Frame*
+ *      The frame returned by the last FLAC__stream_decoder_decode_frame()
+ *      or passed to the running frame callback; the residuals are valid
+ *      until the next frame is decoded. Undefined before the first frame.
+ */
+FLAC_API const FLAC__Frame *FLAC__stream_decoder_get_frame(const FLAC__StreamDecoder *decoder);
+
+/**
+ * Initialize the decoder instance to decode native FLAC streams.
+ *
+ * param decoder    An uninitialized decoder instance.
+ * param handle     The handle to the data source, passed back to every callback.
+ * param callbacks  A set of callbacks to use for I/O. The read callback
+ *                  is required; eof, seek and tell are optional; write and
+ *                  close are not used by the decoder.
+ * retval FLAC__StreamDecoderInitStatus
+ *      FLAC__STREAM_DECODER_INIT_STATUS_OK if initialization was successful;
+ *      see FLAC__StreamDecoderInitStatus for the meanings of other return values.
+ */
+FLAC_API FLAC__StreamDecoderInitStatus FLAC__stream_decoder_init(FLAC__StreamDecoder *decoder, FLAC__IOHandle handle, FLAC__IOCallbacks callbacks);
+
+/**
+ * Initialize the decoder instance to decode a native FLAC stream held
+ * in memory, typically a file mapped with FLAC__mapped_file_open().
+ * Frames are decoded straight out of 'data'; no read callback is
+ * involved and the bytes are not staged in a read buffer first. Blocks
+ * the decoder does not need are skipped by moving past them, so their
+ * pages are never touched.
+ *
+ * The decode position is the offset into 'data'.
+ *
+ * param decoder    An uninitialized decoder instance.
+ * param data       The stream. It must stay valid until
+ *                  FLAC__stream_decoder_finish() is called.
+ * param bytes      The size of the stream in bytes.
+ * retval FLAC__StreamDecoderInitStatus
+ *      FLAC__STREAM_DECODER_INIT_STATUS_OK if initialization was successful;
+ *      FLAC__STREAM_DECODER_INIT_STATUS_INVALID_CALLBACKS if 'data' is NULL
+ *      but 'bytes' is not 0.
+ */
+FLAC_API FLAC__StreamDecoderInitStatus FLAC__stream_decoder_init_memory(FLAC__StreamDecoder *decoder, const FLAC__byte *data, size_t bytes);
+
+/**
+ * Like FLAC__stream_decoder_init_memory(), for a run of frames cut out
+ * of a stream, e.g. the spans handed out by a FLAC__FrameSpanIterator.
+ * There is no metadata to read; 'stream_info' stands in for the
+ * STREAMINFO block, so that frames which take the sample rate, the
+ * bits-per-sample or the frame number scale from it decode the same as
+ * in the whole stream.
+ *
+ * param decoder        An uninitialized decoder instance.
+ * param stream_info    The STREAMINFO of the stream the frames come
+ *                      from, copied; NULL if there is none.
+ * param data           The frames. They must stay valid until
+ *                      FLAC__stream_decoder_finish() is called.
+ * param bytes          The size of the frames in bytes.
+ * retval FLAC__StreamDecoderInitStatus
+ *      FLAC__STREAM_DECODER_INIT_STATUS_OK if initialization was successful;
+ *      see FLAC__stream_decoder_init_memory() for the others.
+ */
+FLAC_API FLAC__StreamDecoderInitStatus FLAC__stream_decoder_init_memory_frames(FLAC__StreamDecoder *decoder, const FLAC__StreamMetadata_StreamInfo *stream_info, const FLAC__byte *data, size_t bytes);
+
+/**
+ * Initialize the decoder instance to decode an Ogg FLAC stream through
+ * the callbacks. Pages are read into a buffer of the decoder's and their
+ * CRC-32 is checked; the bodies of the FLAC stream's pages are then
+ * decoded straight out of that buffer, with no copy to put the packets
+ * back together: the packets of an Ogg FLAC stream, end to end, are the
+ * native stream. The first logical stream that starts with an Ogg FLAC
+ * mapping header is decoded, up to its end-of-stream page; pages of
+ * other logical streams are skipped. A page that fails its CRC is
+ * dropped, and the frame it was part of is reported as damaged.
+ *
+ * The decode position is the offset into the native stream, not into
+ * the Ogg file. FLAC__stream_decoder_seek_absolute() fails on an Ogg
+ * decoder.
+ *
+ * param decoder    An uninitialized decoder instance.
+ * param handle     The handle to the data source, passed back to every callback.
+ * param callbacks  As for FLAC__stream_decoder_init(); seek and tell are
+ *                  not used.
+ * retval FLAC__StreamDecoderInitStatus
+ *      FLAC__STREAM_DECODER_INIT_STATUS_OK if initialization was successful;
+ *      see FLAC__StreamDecoderInitStatus for the meanings of other return values.
+ */
+FLAC_API FLAC__StreamDecoderInitStatus FLAC__stream_decoder_init_ogg(FLAC__StreamDecoder *decoder, FLAC__IOHandle handle, FLAC__IOCallbacks callbacks);
+
+/**
+ * Like FLAC__stream_decoder_init_ogg(), for an Ogg FLAC stream held in
+ * memory, e.g. a file mapped with FLAC__mapped_file_open(). The page
+ * bodies are decoded where they are in 'data', nothing is copied.
+ *
+ * param decoder    An uninitialized decoder instance.
+ * param data       The stream. It must stay valid until
+ *                  FLAC__stream_decoder_finish() is called.
+ * param bytes      The size of the stream in bytes.
+ * retval FLAC__StreamDecoderInitStatus
+ *      FLAC__STREAM_DECODER_INIT_STATUS_OK if initialization was successful;
+ *      FLAC__STREAM_DECODER_INIT_STATUS_INVALID_CALLBACKS if 'data' is NULL
+ *      but 'bytes' is not 0.
+ */
+FLAC_API FLAC__StreamDecoderInitStatus FLAC__stream_decoder_init_ogg_memory(FLAC__StreamDecoder *decoder, const FLAC__byte *data, size_t bytes);
+
+/**
+ * Initialize the decoder instance to decode a native FLAC stream pushed
+ * in with FLAC__stream_decoder_push(). The stream may start with the
+ * "fLaC" marker and metadata, optionally behind an ID3v2 tag, or
+ * directly with a frame, e.g. when joining a live stream midway.
+ *
+ * FLAC__stream_decoder_decode_frame(),
+ * FLAC__stream_decoder_process_until_end_of_metadata() and
+ * FLAC__stream_decoder_seek_absolute() fail on a push decoder.
+ *
+ * param decoder    An uninitialized decoder instance.
+ * param callback   The frame callback.
+ * param client_data    Passed back to the frame callback.
+ * retval FLAC__StreamDecoderInitStatus
+ *      FLAC__STREAM_DECODER_INIT_STATUS_OK if initialization was successful;
+ *      FLAC__STREAM_DECODER_INIT_STATUS_INVALID_CALLBACKS if 'callback' is NULL.
+ */
+FLAC_API FLAC__StreamDecoderInitStatus FLAC__stream_decoder_init_push(FLAC__StreamDecoder *decoder, FLAC__StreamDecoderFrameCallback callback, void *client_data);
+
+/**
+ * Feed the next bytes of the stream to a push decoder. Every frame whose
+ * last byte is in 'data' is decoded and passed to the frame callback
+ * before this returns.
+ *
+ * A frame's CRC-16 covers the whole frame, footer included, so the CRC
+ * run over a frame comes out 0 exactly where it ends. The decoder keeps
+ * that CRC running over the bytes as they arrive, each byte once, and
+ * decodes the frame as soon as it comes out 0; a CRC of 0 that is not
+ * the end (about one in 65536 bytes) only costs a decode attempt that
+ * runs out of data. A frame that is damaged never gets there: it is
+ * dropped, and reported as a CRC mismatch, when it fails to decode up
+ * to the next frame header or runs past the largest size it can have.
+ *
+ * Only the frame being assembled is kept between pushes, never more;
+ * when the previous push left nothing over, the frames in 'data' are
+ * decoded in place without being copied. Metadata blocks other than
+ * STREAMINFO are dropped as they arrive, however large.
+ *
+ * param decoder    A decoder initialized with FLAC__stream_decoder_init_push().
+ * param data       The next bytes of the stream, copied if needed.
+ * param bytes      The number of bytes; 0 does nothing.
+ * retval FLAC__bool    false if the decoder is not a push decoder, on a
+ *                      fatal error (e.g. memory allocation) or if the
+ *                      frame callback returned false; check the decoder state.
+ */
+FLAC_API FLAC__bool FLAC__stream_decoder_push(FLAC__StreamDecoder *decoder, const FLAC__byte *data, size_t bytes);
+
+/**
+ * Tell a push decoder that the stream has ended. An intact last frame
+ * has been passed to the frame callback by the push that delivered its
+ * last byte already; what is still held is a frame that was cut off or
+ * damaged, or bytes that are not a frame. A frame that decodes up to
+ * the end of the data is passed to the frame callback, anything else is
+ * reported to the error callback and dropped. Afterwards the decoder is
+ * in the FLAC__STREAM_DECODER_END_OF_STREAM state and takes no more
+ * pushes; call FLAC__stream_decoder_finish() to start over.
+ *
+ * param decoder    A decoder initialized with FLAC__stream_decoder_init_push().
+ * retval FLAC__bool    false if the decoder is not a push decoder, is
+ *                      past the end of the stream already, on a fatal
+ *                      error or if the frame callback returned false.
+ */
+FLAC_API FLAC__bool FLAC__stream_decoder_push_end_of_stream(FLAC__StreamDecoder *decoder);
+
+/**
+ * Finish the decoding process. The handle is not closed; the caller
+ * owns it. The decoder's working buffers, one block sized from
+ * STREAMINFO, are kept so that the instance can be re-initialized for
+ * the next stream without allocating again; the block only grows when a
+ * stream needs more than any before it.
+ *
+ * param decoder    An uninitialized or initialized decoder instance.
+ * retval FLAC__bool    true on success.
+ */
+FLAC_API FLAC__bool FLAC__stream_decoder_finish(FLAC__StreamDecoder *decoder);
+
+/**
+ * Decode until the end of the metadata. STREAMINFO is parsed, all other
+ * metadata blocks are skipped. Afterwards the decoder state is
+ * FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC.
+ *
+ * param decoder    An initialized decoder instance.
+ * retval FLAC__bool    false if a fatal error occurred or the end of the
+ *                      stream was reached; check the decoder state.
+ */
+FLAC_API FLAC__bool FLAC__stream_decoder_process_until_end_of_metadata(FLAC__StreamDecoder *decoder);
+
+/**
+ * Decode the next audio frame into the caller's buffers. If the metadata
+ * has not been read yet it is read first. Frames that fail to decode are
+ * reported through the error callback and skipped.
+ *
+ * param decoder    An initialized decoder instance.
+ * param buffer     An array of pointers, one per channel, each pointing
+ *                  to room for at least 'capacity' samples. The samples
+ *                  are signed and right-justified at the stream's
+ *                  bits-per-sample.
+ * param capacity   The number of samples each channel buffer can hold;
+ *                  the STREAMINFO max_blocksize is always enough.
+ * param header     If not NULL, receives the header of the decoded frame.
+ *                  A frame number is always converted to a sample number.
+ * retval FLAC__bool    true if a frame was decoded, false at the end of the
+ *                      stream or on a fatal error; check the decoder state.
+ */
+FLAC_API FLAC__bool FLAC__stream_decoder_decode_frame(FLAC__StreamDecoder *decoder, FLAC__int32 * const buffer[], unsigned capacity, FLAC__FrameHeader *header);
+
+/**
+ * Decode the next audio frame like FLAC__stream_decoder_decode_frame(),
+ * but into interleaved little-endian PCM, see
+ * FLAC__stream_decoder_interleave(). The frame is decoded into the
+ * decoder's own channel buffers, allocated on the first call, and
+ * interleaved from there.
+ *
+ * param decoder    An initialized decoder instance, not a push decoder.
+ * param bits_per_sample  The output sample resolution,
+ *                  FLAC__MIN_BITS_PER_SAMPLE to FLAC__MAX_BITS_PER_SAMPLE.
+ * param pcm        Room for at least capacity * channels samples of
+ *                  (bits_per_sample + 7) / 8 bytes each.
+ * param capacity   The number of samples per channel 'pcm' can hold;
+ *                  the STREAMINFO max_blocksize is always enough.
+ * param header     If not NULL, receives the header of the decoded frame.
+ * retval FLAC__bool    true if a frame was decoded, false if
+ *                      bits_per_sample is out of range, at the end of the
+ *                      stream or on a fatal error; check the decoder state.
+ */
+FLAC_API FLAC__bool FLAC__stream_decoder_decode_frame_interleaved(FLAC__StreamDecoder *decoder, unsigned bits_per_sample, FLAC__byte pcm[], unsigned capacity, FLAC__FrameHeader *header);
+
+/**
+ * Convert a decoded frame, one buffer per channel, to interleaved
+ * little-endian signed PCM: header->blocksize samples of each of
+ * header->channels channels, each sample in the fewest whole bytes that
+ * hold bits_per_sample. The samples are scaled from the frame's
+ * bits-per-sample: shifted left when bits_per_sample is larger, shifted
+ * right (the low bits dropped, without dither) when it is smaller. So a
+ * 20-bit stream converted at 24 bits comes out the way WAV stores 20 bits
+ * in 3 bytes, and at 16 bits as plain 16-bit PCM. Mono and stereo go
+ * through SIMD kernels on CPUs that have them.
+ *
+ * This is what FLAC__stream_decoder_decode_frame_interleaved() does after
+ * decoding; it is meant for the buffers of FLAC__stream_decoder_decode_frame()
+ * and of a push decoder's frame callback.
+ *
+ * param decoder    An initialized decoder instance; only its choice of
+ *                  kernels is used.
+ * param buffer     The decoded channels, as in FLAC__StreamDecoderFrameCallback.
+ * param header     The header of the frame.
+ * param bits_per_sample  The output sample resolution,
+ *                  FLAC__MIN_BITS_PER_SAMPLE to FLAC__MAX_BITS_PER_SAMPLE.
+ * param pcm        Receives header->blocksize * header->channels samples.
+ * retval FLAC__bool    false if bits_per_sample is out of range, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_decoder_interleave(const FLAC__StreamDecoder *decoder, const FLAC__int32 * const buffer[], const FLAC__FrameHeader *header, unsigned bits_per_sample, FLAC__byte pcm[]);
+
+/**
+ * Seek to a sample. The decoder jumps to the seek point the index gives
+ * for the sample (a binary search), and the next call to
+ * FLAC__stream_decoder_decode_frame() returns the frame holding the
+ * sample with the samples before it dropped: the returned header's
+ * sample number is 'sample' and its blocksize what is left of the frame.
+ * With an index built by scanning, that is the only frame decoded;
+ * with a sparse SEEKTABLE the frames in between are decoded and dropped.
+ *
+ * The stream is repositioned with the seek callback, relative to the
+ * current position, so a tell callback is not needed. The index must
+ * have been built from the same stream.
+ *
+ * param decoder    An initialized decoder instance. If the metadata has
+ *                  not been read yet it is read first.
+ * param index      The stream's seek index.
+ * param sample     The target sample number.
+ * retval FLAC__bool    false if the sample is past the end of the stream
+ *                      or there is no seek callback, leaving the decoder
+ *                      as it was, or if the seek failed, leaving it in
+ *                      FLAC__STREAM_DECODER_SEEK_ERROR.
+ */
+FLAC_API FLAC__bool FLAC__stream_decoder_seek_absolute(FLAC__StreamDecoder *decoder, const FLAC__SeekIndex *index, FLAC__uint64 sample);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !FLAC__STREAM_DECODER_H
@@ -0,0 +1,560 @@
+#ifndef FLAC__STREAM_ENCODER_H
+#define FLAC__STREAM_ENCODER_H
+
+#include "export.h"
+#include "callback.h"
+#include "format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * This module describes the stream encoder, which compresses PCM into a
+ * native FLAC stream and pushes the result through a set of
+ * FLAC__IOCallbacks.
+ *
+ * The input is cut into fixed-size blocks (FLAC__MIN_BLOCK_SIZE to
+ * FLAC__MAX_BLOCK_SIZE samples, only the last one can be shorter) and
+ * every block becomes one frame, or with
+ * FLAC__stream_encoder_set_variable_blocksize() one or more frames of
+ * their own sizes. Frames do not depend on each other, so
+ * with FLAC__stream_encoder_set_num_threads() the blocks are handed to a
+ * pool of worker threads. The finished frames come back to an in-order
+ * writer that emits them through the write callback on the thread that
+ * calls FLAC__stream_encoder_process() or FLAC__stream_encoder_finish().
+ * The frame search is a pure function of the block, so the output is
+ * byte-identical whatever the number of threads.
+ *
+ * The basic usage is:
+ *  - create an encoder with FLAC__stream_encoder_new()
+ *  - set at least the channels, bits-per-sample and sample rate, and
+ *    optionally the compression settings and the number of threads
+ *  - call FLAC__stream_encoder_init() with the handle and callbacks
+ *  - feed the audio with FLAC__stream_encoder_process() or
+ *    FLAC__stream_encoder_process_interleaved()
+ *  - call FLAC__stream_encoder_finish(), then either re-init or delete
+ *
+ * Of the callbacks, write is required. If seek and tell are set as well,
+ * FLAC__stream_encoder_finish() goes back and fills in the STREAMINFO
+ * fields only known at the end (total samples, frame sizes, MD5);
+ * otherwise STREAMINFO keeps the total samples estimate and an all-zero
+ * MD5, which decoders treat as unknown.
+ */
+
+/** The largest number of worker threads FLAC__stream_encoder_set_num_threads() accepts. */
+#define FLAC__STREAM_ENCODER_MAX_THREADS (64u)
+
+/** The largest value FLAC__stream_encoder_set_search_effort() accepts. */
+#define FLAC__STREAM_ENCODER_MAX_SEARCH_EFFORT (3u)
+
+/**
+ * State values for a FLAC__StreamEncoder
+ *
+ * The encoder's state can be obtained by calling FLAC__stream_encoder_get_state().
+ */
+typedef enum {
+    /** The encoder is in the normal OK state and samples can be processed. */
+    FLAC__STREAM_ENCODER_OK = 0,
+
+    /** The encoder is in the uninitialized state; FLAC__stream_encoder_init()
+     * must be called before samples can be processed. */
+    FLAC__STREAM_ENCODER_UNINITIALIZED,
+
+    /** The write callback returned an error, i.e. wrote fewer bytes than
+     * it was given. */
+    FLAC__STREAM_ENCODER_CLIENT_ERROR,
+
+    /** An error occurred while assembling a frame. */
+    FLAC__STREAM_ENCODER_FRAMING_ERROR,
+
+    /** Memory allocation failed. */
+    FLAC__STREAM_ENCODER_MEMORY_ALLOCATION_ERROR
+} FLAC__StreamEncoderState;
+
+/**
+ * Maps a FLAC__StreamEncoderState to a C string.
+ *
+ * Using a FLAC__StreamEncoderState as the index to this array
+ * will give the string equivalent. The contents should not be modified.
+ */
+extern FLAC_API const char * const FLAC__StreamEncoderStateString[];
+
+/** Possible return values for the FLAC__stream_encoder_init() function. */
+typedef enum {
+    /** Initialization was successful. */
+    FLAC__STREAM_ENCODER_INIT_STATUS_OK = 0,
+
+    /** General failure to set up encoder, e.g. the worker threads could
+     * not be started. */
+    FLAC__STREAM_ENCODER_INIT_STATUS_ENCODER_ERROR,
+
+    /** A required callback was not supplied. */
+    FLAC__STREAM_ENCODER_INIT_STATUS_INVALID_CALLBACKS,
+
+    /** The encoder has an invalid setting for number of channels. */
+    FLAC__STREAM_ENCODER_INIT_STATUS_INVALID_NUMBER_OF_CHANNELS,
+
+    /** The encoder has an invalid setting for bits-per-sample. */
+    FLAC__STREAM_ENCODER_INIT_STATUS_INVALID_BITS_PER_SAMPLE,
+
+    /** The encoder has an invalid setting for the input sample rate. */
+    FLAC__STREAM_ENCODER_INIT_STATUS_INVALID_SAMPLE_RATE,
+
+    /** The encoder has an invalid setting for the block size. */
+    FLAC__STREAM_ENCODER_INIT_STATUS_INVALID_BLOCK_SIZE,
+
+    /** The encoder has an invalid setting for the maximum LPC order. */
+    FLAC__STREAM_ENCODER_INIT_STATUS_INVALID_MAX_LPC_ORDER,
+
+    /** The encoder has an invalid setting for the precision of the quantized linear predictor coefficients. */
+    FLAC__STREAM_ENCODER_INIT_STATUS_INVALID_QLP_COEFF_PRECISION,
+
+    /** The specified block size is less than the maximum LPC order. */
+    FLAC__STREAM_ENCODER_INIT_STATUS_BLOCK_SIZE_TOO_SMALL_FOR_LPC_ORDER,
+
+    /** The encoder is set to the streamable subset but the other settings
+     * would leave it; see FLAC__stream_encoder_set_streamable_subset(). */
+    FLAC__STREAM_ENCODER_INIT_STATUS_NOT_STREAMABLE,
+
+    /** Memory allocation failed. */
+    FLAC__STREAM_ENCODER_INIT_STATUS_MEMORY_ALLOCATION_ERROR,
+
+    /** FLAC__stream_encoder_init() was called when the encoder was
+     * already initialized, usually because
+     * FLAC__stream_encoder_finish() was not called.
+     */
+    FLAC__STREAM_ENCODER_INIT_STATUS_ALREADY_INITIALIZED
+} FLAC__StreamEncoderInitStatus;
+
+/**
+ * Maps a FLAC__StreamEncoderInitStatus to a C string.
+ *
+ * Using a FLAC__StreamEncoderInitStatus as the index to this array
+ * will give the string equivalent. The contents should not be modified.
+ */
+extern FLAC_API const char * const FLAC__StreamEncoderInitStatusString[];
+
+
+/***********************************************************************
+ *
+ * class FLAC__StreamEncoder
+ *
+ ***********************************************************************/
+
+/**
+ * The opaque structure definition for the stream encoder type.
+ * See the module documentation above for usage.
+ */
+struct FLAC__StreamEncoder;
+typedef struct FLAC__StreamEncoder FLAC__StreamEncoder;
+
+
+/***********************************************************************
+ *
+ * Class constructor/destructor
+ *
+ ***********************************************************************/
+
+/**
+ * Create a new stream encoder instance. The instance is created with
+ * default settings; see the individual FLAC__stream_encoder_set_*()
+ * functions for each setting's default.
+ *
+ * retval FLAC__StreamEncoder*  NULL if there was an error allocating memory, else the new instance.
+ */
+FLAC_API FLAC__StreamEncoder *FLAC__stream_encoder_new(void);
+
+/**
+ * Free an encoder instance. Deletes the object pointed to by encoder.
+ * An initialized encoder is finished first.
+ *
+ * param encoder    A pointer to an existing encoder.
+ */
+FLAC_API void FLAC__stream_encoder_delete(FLAC__StreamEncoder *encoder);
+
+
+/***********************************************************************
+ *
+ * Public class method prototypes
+ *
+ ***********************************************************************/
+
+/**
+ * Set the number of threads that compress frames. 1 encodes every
+ * frame on the calling thread; above 1, that many worker threads are
+ * started by FLAC__stream_encoder_init() and the calling thread only
+ * buffers input and writes finished frames. 0 means one worker per
+ * hardware thread. Default is 1.
+ *
+ * param encoder    An encoder instance to set.
+ * param value      See above.
+ * retval FLAC__bool    false if the encoder is already initialized or
+ *                      value is above FLAC__STREAM_ENCODER_MAX_THREADS, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_set_num_threads(FLAC__StreamEncoder *encoder, unsigned value);
+
+/**
+ * Set the number of channels to be encoded. Default is 2.
+ *
+ * param encoder    An encoder instance to set.
+ * param value      1 to FLAC__MAX_CHANNELS.
+ * retval FLAC__bool    false if the encoder is already initialized, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_set_channels(FLAC__StreamEncoder *encoder, unsigned value);
+
+/**
+ * Set the sample resolution of the input to be encoded. Default is 16.
+ *
+ * param encoder    An encoder instance to set.
+ * param value      FLAC__MIN_BITS_PER_SAMPLE to FLAC__MAX_BITS_PER_SAMPLE.
+ * retval FLAC__bool    false if the encoder is already initialized, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_set_bits_per_sample(FLAC__StreamEncoder *encoder, unsigned value);
+
+/**
+ * Set the sample rate (in Hz) of the input to be encoded. Default is 44100.
+ *
+ * param encoder    An encoder instance to set.
+ * param value      See FLAC__format_sample_rate_is_valid().
+ * retval FLAC__bool    false if the encoder is already initialized, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_set_sample_rate(FLAC__StreamEncoder *encoder, unsigned value);
+
+/**
+ * Set the compression level, which is a shorthand for the block size
+ * and the other compression settings below. Later calls to the
+ * individual setters override the level's choice.
+ *
+ * <pre>
+ * level  blocksize  mid-side  max_lpc_order  partition order  exhaustive  search effort
+ *   0      1152      false         0             0..3          false          0
+ *   1      1152      true          0             0..3          false          0
+ *   2      1152      true          0             0..3          false          0
+ *   3      4096      false         6             0..4          false          0
+ *   4      4096      true          8             0..4          false          0
+ *   5      4096      true          8             0..5          false          0
+ *   6      4096      true          8             0..6          false          1
+ *   7      4096      true         12             0..6          false          2
+ *   8      4096      true         12             0..6          true           3
+ * </pre>
+ *
+ * Levels above 8 are treated as 8. Default is 5.
+ *
+ * param encoder    An encoder instance to set.
+ * param value      The compression level.
+ * retval FLAC__bool    false if the encoder is already initialized, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_set_compression_level(FLAC__StreamEncoder *encoder, unsigned value);
+
+/**
+ * Set the block size in samples per channel.
+ *
+ * param encoder    An encoder instance to set.
+ * param value      FLAC__MIN_BLOCK_SIZE to FLAC__MAX_BLOCK_SIZE.
+ * retval FLAC__bool    false if the encoder is already initialized, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_set_blocksize(FLAC__StreamEncoder *encoder, unsigned value);
+
+/**
+ * Set to true to give every frame the block size that suits it. The
+ * input is still cut into blocks of FLAC__stream_encoder_set_blocksize()
+ * samples, which becomes the largest frame, but a block is split where
+ * the level of the signal jumps, e.g. at a drum hit, so the predictor of
+ * the quiet part before it is not spoilt by the loud part after it.
+ *
+ * A fast detector measures the block in sixteenths (at least
+ * FLAC__MIN_BLOCK_SIZE samples each) and looks for neighbours whose
+ * levels are far apart. A block without such a transient is one frame
+ * as usual, which costs only the measurement. Otherwise up to four of the
+ * strongest transients are candidate split points, and a dynamic
+ * programming search compresses every frame between two of them (at
+ * most 15 trial frames) and keeps the split that comes out smallest;
+ * not splitting is one of the candidates. On percussive material this
+ * gains a few percent, at up to several times the encoding time of the
+ * blocks that have transients.
+ *
+ * The frames then carry their first sample number instead of a frame
+ * number, and STREAMINFO gets the smallest and largest block sizes that
+ * were used (if the output can seek back to it; until then the bounds).
+ * Default is false.
+ *
+ * param encoder    An encoder instance to set.
+ * param value      See above.
+ * retval FLAC__bool    false if the encoder is already initialized, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_set_variable_blocksize(FLAC__StreamEncoder *encoder, FLAC__bool value);
+
+/**
+ * Set to true to try left/side, right/side and mid/side coding for
+ * stereo input and keep whichever is smallest. Only used for 2-channel
+ * input of less than 32 bits-per-sample. At search effort 0 (see
+ * FLAC__stream_encoder_set_search_effort()) the assignment is picked
+ * from a quick estimate of all four signals and only its two are
+ * compressed; above that, or with the exhaustive model search, all four
+ * are compressed.
+ *
+ * param encoder    An encoder instance to set.
+ * param value      Flag value (see above).
+ * retval FLAC__bool    false if the encoder is already initialized, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_set_do_mid_side_stereo(FLAC__StreamEncoder *encoder, FLAC__bool value);
+
+/**
+ * Set the maximum LPC order, or 0 to use only the fixed predictors.
+ *
+ * param encoder    An encoder instance to set.
+ * param value      0 to FLAC__MAX_LPC_ORDER.
+ * retval FLAC__bool    false if the encoder is already initialized, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_set_max_lpc_order(FLAC__StreamEncoder *encoder, unsigned value);
+
+/**
+ * Set the precision, in bits, of the quantized linear predictor
+ * coefficients, or 0 to let the encoder select it based on the
+ * blocksize and bits-per-sample. Default is 0.
+ *
+ * param encoder    An encoder instance to set.
+ * param value      0, or FLAC__MIN_QLP_COEFF_PRECISION to FLAC__MAX_QLP_COEFF_PRECISION.
+ * retval FLAC__bool    false if the encoder is already initialized, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_set_qlp_coeff_precision(FLAC__StreamEncoder *encoder, unsigned value);
+
+/**
+ * Set to true to search every quantized coefficient precision for each
+ * LPC order tried. Default is false.
+ *
+ * param encoder    An encoder instance to set.
+ * param value      See above.
+ * retval FLAC__bool    false if the encoder is already initialized, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_set_do_qlp_coeff_prec_search(FLAC__StreamEncoder *encoder, FLAC__bool value);
+
+/**
+ * Set to false to use only the estimated best fixed and LPC orders, or
+ * to true to encode every order and keep the smallest. Default is false.
+ *
+ * param encoder    An encoder instance to set.
+ * param value      See above.
+ * retval FLAC__bool    false if the encoder is already initialized, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_set_do_exhaustive_model_search(FLAC__StreamEncoder *encoder, FLAC__bool value);
+
+/**
+ * Set how hard the encoder searches for the predictor when the
+ * exhaustive model search is off. Every LPC order's prediction error is
+ * known before any residual is computed, and gives an estimate of the
+ * order's size; the search starts at the order with the best estimate
+ * and walks to neighbouring orders, then to neighbouring coefficient
+ * precisions, while the real size keeps going down.
+ *
+ * <pre>
+ * effort  orders                       precisions              fixed orders        stereo
+ *   0     the estimate only            the default only        the estimate only   the estimate only
+ *   1     stop after 1 that is worse   the default only        the estimate only   all
+ *   2     stop after 2 that are worse  stop after 1 worse      all                 all
+ *   3     stop after 3 that are worse  stop after 2 worse      all                 all
+ * </pre>
+ *
+ * Effort 3 usually gets within a fraction of a percent of the
+ * exhaustive search, trying a handful of the candidates. With
+ * FLAC__stream_encoder_set_do_qlp_coeff_prec_search() every precision is
+ * tried at the order found instead. Default is from the compression level.
+ *
+ * param encoder    An encoder instance to set.
+ * param value      0 to FLAC__STREAM_ENCODER_MAX_SEARCH_EFFORT.
+ * retval FLAC__bool    false if the encoder is already initialized or
+ *                      value is above FLAC__STREAM_ENCODER_MAX_SEARCH_EFFORT, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_set_search_effort(FLAC__StreamEncoder *encoder, unsigned value);
+
+/**
+ * Set the minimum partition order to search when coding the residual.
+ *
+ * param encoder    An encoder instance to set.
+ * param value      0 to FLAC__MAX_RICE_PARTITION_ORDER.
+ * retval FLAC__bool    false if the encoder is already initialized, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_set_min_residual_partition_order(FLAC__StreamEncoder *encoder, unsigned value);
+
+/**
+ * Set the maximum partition order to search when coding the residual.
+ *
+ * param encoder    An encoder instance to set.
+ * param value      0 to FLAC__MAX_RICE_PARTITION_ORDER.
+ * retval FLAC__bool    false if the encoder is already initialized, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_set_max_residual_partition_order(FLAC__StreamEncoder *encoder, unsigned value);
+
+/**
+ * Set an estimate of the total samples that will be encoded. It is
+ * written into STREAMINFO at init and only corrected at the end if the
+ * output is seekable. Default is 0 (unknown).
+ *
+ * param encoder    An encoder instance to set.
+ * param value      The estimate, in samples per channel.
+ * retval FLAC__bool    false if the encoder is already initialized, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_set_total_samples_estimate(FLAC__StreamEncoder *encoder, FLAC__uint64 value);
+
+/**
+ * Set to false to skip the MD5 signature of the input. The MD5 is the
+ * only part of encoding that has to run serially; with many threads it
+ * can limit throughput. Default is true.
+ *
+ * param encoder    An encoder instance to set.
+ * param value      See above.
+ * retval FLAC__bool    false if the encoder is already initialized, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_set_do_md5(FLAC__StreamEncoder *encoder, FLAC__bool value);
+
+/**
+ * Set to true to keep the stream within the streamable subset, which
+ * every decoder must be able to play from any frame without looking at
+ * STREAMINFO. FLAC__stream_encoder_init() then fails with
+ * FLAC__STREAM_ENCODER_INIT_STATUS_NOT_STREAMABLE if a setting is
+ * outside it:
+ *  - the sample rate and bits-per-sample must be codable in the frame
+ *    header (bits-per-sample 8, 12, 16, 20, 24 or 32);
+ *  - the block size at most FLAC__SUBSET_MAX_BLOCK_SIZE_48000Hz up to
+ *    48kHz, 16384 above;
+ *  - the maximum LPC order at most FLAC__SUBSET_MAX_LPC_ORDER_48000HZ
+ *    up to 48kHz;
+ *  - the maximum residual partition order at most
+ *    FLAC__SUBSET_MAX_RICE_PARTITION_ORDER.
+ * Up to 48kHz the frame search is then a build of its own, compiled for
+ * these limits: the LPC residual runs through kernels unrolled for each
+ * order and the search bounds are constants, which takes the range
+ * checks out of the per-frame path. The compression levels are all in
+ * the subset. Default is false.
+ *
+ * param encoder    An encoder instance to set.
+ * param value      See above.
+ * retval FLAC__bool    false if the encoder is already initialized, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_set_streamable_subset(FLAC__StreamEncoder *encoder, FLAC__bool value);
+
+/**
+ * Set the serial number of the Ogg logical stream written by
+ * FLAC__stream_encoder_init_ogg(). Streams that are to be multiplexed
+ * or chained need different ones. Default is 0.
+ *
+ * param encoder    An encoder instance to set.
+ * param value      See above.
+ * retval FLAC__bool    false if the encoder is already initialized, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_set_ogg_serial_number(FLAC__StreamEncoder *encoder, long value);
+
+/**
+ * Get the current encoder state.
+ *
+ * param encoder    An encoder instance to query.
+ * retval FLAC__StreamEncoderState  The current encoder state.
+ */
+FLAC_API FLAC__StreamEncoderState FLAC__stream_encoder_get_state(const FLAC__StreamEncoder *encoder);
+
+/**
+ * Get the current encoder state as a C string.
+ *
+ * param encoder    An encoder instance to query.
+ * retval const char*   The encoder state as a C string. Do not modify the contents.
+ */
+FLAC_API const char *FLAC__stream_encoder_get_resolved_state_string(const FLAC__StreamEncoder *encoder);
+
+/**
+ * Get the number of frame-compressing threads, with 0 resolved to the
+ * hardware concurrency once the encoder is initialized.
+ *
+ * param encoder    An encoder instance to query.
+ * retval unsigned  See above.
+ */
+FLAC_API unsigned FLAC__stream_encoder_get_num_threads(const FLAC__StreamEncoder *encoder);
+
+/**
+ * Get the STREAMINFO of the stream. After FLAC__stream_encoder_finish()
+ * it holds the final totals, frame sizes and MD5 of the last stream.
+ *
+ * param encoder    An encoder instance to query.
+ * retval const FLAC__StreamMetadata_StreamInfo*   The stream info.
+ */
+FLAC_API const FLAC__StreamMetadata_StreamInfo *FLAC__stream_encoder_get_stream_info(const FLAC__StreamEncoder *encoder);
+
+/**
+ * Initialize the encoder instance to encode a native FLAC stream. The
+ * "fLaC" signature and STREAMINFO are written before this returns.
+ *
+ * param encoder    An uninitialized encoder instance.
+ * param handle     The handle to the output, passed back to every callback.
+ * param callbacks  A set of callbacks to use for I/O. The write callback
+ *                  is required; seek and tell are optional (see the
+ *                  module documentation); read, eof and close are not used.
+ * retval FLAC__StreamEncoderInitStatus
+ *      FLAC__STREAM_ENCODER_INIT_STATUS_OK if initialization was successful;
+ *      see FLAC__StreamEncoderInitStatus for the meanings of other return values.
+ */
+FLAC_API FLAC__StreamEncoderInitStatus FLAC__stream_encoder_init(FLAC__StreamEncoder *encoder, FLAC__IOHandle handle, FLAC__IOCallbacks callbacks);
+
+/**
+ * Initialize the encoder instance to encode an Ogg FLAC stream: the
+ * mapping header and STREAMINFO alone on the first page, a VORBIS_COMMENT
+ * with only the vendor string alone on the second, then one frame
+ * per packet, about 4kB of frames to a page, each page's granule
+ * position the number of samples up to the last frame that ends on it.
+ * With seek and tell, STREAMINFO is updated at the end as for a native
+ * stream; the first page is rewritten with it and its new CRC.
+ *
+ * param encoder    An uninitialized encoder instance.
+ * param handle     The handle to the output, passed back to every callback.
+ * param callbacks  As for FLAC__stream_encoder_init().
+ * retval FLAC__StreamEncoderInitStatus
+ *      FLAC__STREAM_ENCODER_INIT_STATUS_OK if initialization was successful;
+ *      see FLAC__StreamEncoderInitStatus for the meanings of other return values.
+ */
+FLAC_API FLAC__StreamEncoderInitStatus FLAC__stream_encoder_init_ogg(FLAC__StreamEncoder *encoder, FLAC__IOHandle handle, FLAC__IOCallbacks callbacks);
+
+/**
+ * Finish the encoding process. The last, possibly short, block is
+ * encoded, every frame still in flight is written, the worker threads
+ * are stopped and, if the output is seekable, STREAMINFO is updated.
+ * The handle is not closed; the caller owns it. The working buffers are
+ * kept in one block for the next stream, which only allocates if it
+ * needs more (a larger blocksize, more channels or threads).
+ *
+ * param encoder    An uninitialized or initialized encoder instance.
+ * retval FLAC__bool    false if an error occurred while finishing the
+ *                      stream, else true.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_finish(FLAC__StreamEncoder *encoder);
+
+/**
+ * Submit data for encoding, one array per channel. The samples are
+ * copied, so the buffers can be reused as soon as this returns.
+ *
+ * param encoder    An initialized encoder instance in the OK state.
+ * param buffer     An array of pointers to each channel's signal. The
+ *                  samples are signed and right-justified at the
+ *                  bits-per-sample set for the encoder.
+ * param samples    The number of samples in one channel.
+ * retval FLAC__bool    true if successful, else false; in this case, check
+ *                      the encoder state with FLAC__stream_encoder_get_state()
+ *                      to see what went wrong.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_process(FLAC__StreamEncoder *encoder, const FLAC__int32 * const buffer[], unsigned samples);
+
+/**
+ * Submit data for encoding, with the channels interleaved.
+ *
+ * param encoder    An initialized encoder instance in the OK state.
+ * param buffer     An array of channels * samples interleaved samples.
+ * param samples    The number of samples in one channel.
+ * retval FLAC__bool    true if successful, else false; in this case, check
+ *                      the encoder state with FLAC__stream_encoder_get_state()
+ *                      to see what went wrong.
+ */
+FLAC_API FLAC__bool FLAC__stream_encoder_process_interleaved(FLAC__StreamEncoder *encoder, const FLAC__int32 buffer[], unsigned samples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !FLAC__STREAM_ENCODER_H
@@ -0,0 +1,183 @@
+#ifndef FLAC__VERIFY_H
+#define FLAC__VERIFY_H
+
+#include "export.h"
+#include "format.h"
+#include <stddef.h>     // for size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * This module checks FLAC files for damage: every frame's header CRC-8
+ * and footer CRC-16, and the MD5 of the decoded audio against the one in
+ * STREAMINFO. It is the same check as decoding the file with MD5
+ * checking, built to get through a large number of files quickly.
+ *
+ * A FLAC__Verifier runs the check as a pipeline:
+ *  - the calling thread maps the files one after the other, walks their
+ *    frames with the CRCs only (this is also what pulls the pages in
+ *    from disk) and cuts each file into segments of whole frames
+ *  - worker threads decode the segments, any segment of any file, and
+ *    lay out the samples the way the MD5 wants them
+ *  - the MD5 of a file has to see its segments in order; whichever
+ *    worker finishes the oldest segment of a file hashes it, so files
+ *    are hashed in parallel with each other and with the decoding
+ * The number of segments in flight is bounded, so the memory does not
+ * grow with the size or the number of the files.
+ *
+ * The basic usage is:
+ *  - create a verifier with FLAC__verifier_new()
+ *  - optionally set the number of threads
+ *  - FLAC__verifier_verify_files() with the file names
+ *  - FLAC__verifier_delete() it
+ * FLAC__verify_file() and FLAC__verify_memory() check a single stream on
+ * the calling thread.
+ */
+
+/** The largest number of worker threads FLAC__verifier_set_num_threads() accepts. */
+#define FLAC__VERIFIER_MAX_THREADS (64u)
+
+/** The verdict on a file. */
+typedef enum {
+    /** Every frame checks out and so does the MD5, if STREAMINFO has one. */
+    FLAC__VERIFY_OK = 0,
+
+    /** At least one frame failed its CRC-8 or CRC-16 or did not decode. */
+    FLAC__VERIFY_FRAME_ERROR,
+
+    /** The frames are fine but the MD5 of the audio is not the one in STREAMINFO. */
+    FLAC__VERIFY_MD5_MISMATCH,
+
+    /** The frames are fine but do not add up to the STREAMINFO total
+     * samples, e.g. the file was cut off on a frame boundary. */
+    FLAC__VERIFY_SAMPLE_COUNT_MISMATCH,
+
+    /** The file is not a native FLAC stream, or its metadata is cut off
+     * or has no STREAMINFO. */
+    FLAC__VERIFY_NOT_FLAC,
+
+    /** The file could not be opened or mapped. */
+    FLAC__VERIFY_IO_ERROR,
+
+    /** Memory allocation failed. */
+    FLAC__VERIFY_MEMORY_ALLOCATION_ERROR
+} FLAC__VerifyStatus;
+
+/**
+ * Maps a FLAC__VerifyStatus to a C string.
+ *
+ * Using a FLAC__VerifyStatus as the index to this array
+ * will give the string equivalent. The contents should not be modified.
+ */
+extern FLAC_API const char * const FLAC__VerifyStatusString[];
+
+/** What was found in one file. */
+typedef struct {
+    FLAC__VerifyStatus status;
+
+    /** The number of frames found, damaged ones included. */
+    FLAC__uint64 frames;
+
+    /** The number of frames that failed a CRC or did not decode. */
+    FLAC__uint64 bad_frames;
+
+    /** The number of samples (per channel) in the frames that decoded. */
+    FLAC__uint64 samples;
+
+    /** The size of the file in bytes. */
+    FLAC__uint64 bytes;
+
+    /** false if STREAMINFO has no MD5 (all zero), so the audio could only
+     * be checked against the frame CRCs. */
+    FLAC__bool md5_checked;
+} FLAC__VerifyResult;
+
+/**
+ * Check a FLAC file on the calling thread.
+ *
+ * param filename   The file to check.
+ * param result     Receives the verdict.
+ * retval FLAC__bool    true if result->status is FLAC__VERIFY_OK.
+ */
+FLAC_API FLAC__bool FLAC__verify_file(const char *filename, FLAC__VerifyResult *result);
+
+/**
+ * Check a FLAC stream in memory on the calling thread. result->bytes is
+ * 'bytes'.
+ *
+ * param data   The stream.
+ * param bytes  The size of the stream in bytes.
+ * param result Receives the verdict.
+ * retval FLAC__bool    true if result->status is FLAC__VERIFY_OK.
+ */
+FLAC_API FLAC__bool FLAC__verify_memory(const FLAC__byte *data, size_t bytes, FLAC__VerifyResult *result);
+
+
+/**
+ * The opaque structure definition for the verifier type.
+ */
+struct FLAC__Verifier;
+typedef struct FLAC__Verifier FLAC__Verifier;
+
+/**
+ * Signature for the callback that FLAC__verifier_verify_files() calls
+ * as soon as a file is finished. Files finish roughly, not exactly, in
+ * the order they were given, and the callback is called from whichever
+ * thread finished the file, one call at a time.
+ *
+ * param filename       The name of the file, as given.
+ * param file_index     Its position in the list.
+ * param result         What was found.
+ * param client_data    The callee's client data passed to
+ *                      FLAC__verifier_verify_files().
+ */
+typedef void (*FLAC__VerifierCallback)(const char *filename, size_t file_index, const FLAC__VerifyResult *result, void *client_data);
+
+/**
+ * Create a new verifier instance, set to one worker per hardware
+ * thread.
+ *
+ * retval FLAC__Verifier*   NULL if there was an error allocating memory, else the new instance.
+ */
+FLAC_API FLAC__Verifier *FLAC__verifier_new(void);
+
+/**
+ * Free a verifier instance.
+ *
+ * param verifier   A pointer to an existing verifier, or NULL.
+ */
+FLAC_API void FLAC__verifier_delete(FLAC__Verifier *verifier);
+
+/**
+ * Set the number of threads that decode and hash. 1 does everything on
+ * the calling thread; above 1, that many worker threads are started for
+ * each FLAC__verifier_verify_files() and the calling thread only reads
+ * and splits the files. 0 means one worker per hardware thread.
+ *
+ * param verifier   A verifier instance to set.
+ * param value      See above.
+ * retval FLAC__bool    false if value is above FLAC__VERIFIER_MAX_THREADS, else true.
+ */
+FLAC_API FLAC__bool FLAC__verifier_set_num_threads(FLAC__Verifier *verifier, unsigned value);
+
+/**
+ * Check a list of FLAC files.
+ *
+ * param verifier       A verifier instance.
+ * param filenames      The files to check.
+ * param num_files      The number of files.
+ * param results        If not NULL, receives 'num_files' results in the
+ *                      order of 'filenames'.
+ * param callback       If not NULL, called for every finished file.
+ * param client_data    Passed back to the callback.
+ * retval FLAC__bool    true if every file is FLAC__VERIFY_OK.
+ */
+FLAC_API FLAC__bool FLAC__verifier_verify_files(FLAC__Verifier *verifier, const char * const filenames[], size_t num_files, FLAC__VerifyResult results[], FLAC__VerifierCallback callback, void *client_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !FLAC__VERIFY_H
@@ -0,0 +1,65 @@
+#include <stdlib.h>
+#include "FLAC/assert.h"
+#include "private/arena.h"
+
+static size_t align_(size_t bytes)
+{
+    return (bytes + FLAC__ARENA_ALIGNMENT - 1) & ~(size_t)(FLAC__ARENA_ALIGNMENT - 1);
+}
+
+void FLAC__arena_init(FLAC__Arena *arena)
+{
+    arena->allocation = 0;
+    arena->block = 0;
+    arena->capacity = 0;
+    arena->used = 0;
+    arena->counting = false;
+}
+
+void FLAC__arena_free(FLAC__Arena *arena)
+{
+    free(arena->allocation);
+    FLAC__arena_init(arena);
+}
+
+void FLAC__arena_begin_count(FLAC__Arena *arena)
+{
+    arena->counting = true;
+    arena->used = 0;
+}
+
+FLAC__bool FLAC__arena_reserve(FLAC__Arena *arena, size_t bytes)
+{
+    void *allocation;
+
+    FLAC_ASSERT(arena->counting);
+
+    if (bytes > arena->capacity) {
+        /* malloc() only promises 16-byte alignment, so over-allocate and round the start up */
+        allocation = malloc(bytes + FLAC__ARENA_ALIGNMENT - 1);
+        if (allocation == 0)
+            return false;
+        free(arena->allocation);
+        arena->allocation = allocation;
+        arena->block = (FLAC__byte*)align_((size_t)allocation);
+        arena->capacity = bytes;
+    }
+    arena->counting = false;
+    arena->used = 0;
+    return true;
+}
+
+void *FLAC__arena_carve(FLAC__Arena *arena, size_t bytes)
+{
+    FLAC__byte *p;
+
+    bytes = align_(bytes);
+    if (arena->counting) {
+        arena->used += bytes;
+        return 0;
+    }
+    FLAC_ASSERT(arena->used + bytes <= arena->capacity);
+    p = arena->block + arena->used;
+    arena->used += bytes;
+    return p;
+}
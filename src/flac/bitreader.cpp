@@ -0,0 +1,940 @@
+#include <stdlib.h>
+#include <string.h>
+#include "private/bitreader.h"
+#include "private/crc.h"
+#include "private/macros.h"
+#include "FLAC/assert.h"
+
+// 按字(word)读取数据，每个字在buffer中已经转换成主机字节序，
+// 高位对应码流中先出现的bit。
+// 字长64位：一次clz可以数出更长的unary前缀，refill和CRC的次数也减半。
+
+typedef FLAC__uint64 brword;
+#define FLAC__BYTES_PER_WORD 8u
+#define FLAC__BITS_PER_WORD 64u
+#define FLAC__WORD_ALL_ONES ((FLAC__uint64)FLAC__U64L(0xffffffffffffffff))
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define SWAP_BE_WORD_TO_HOST(x) (x)
+#elif defined(__GNUC__)
+#define SWAP_BE_WORD_TO_HOST(x) __builtin_bswap64(x)
+#else
+static inline brword SWAP_BE_WORD_TO_HOST(brword x)
+{
+    x = ((x << 8) & FLAC__U64L(0xff00ff00ff00ff00)) | ((x >> 8) & FLAC__U64L(0x00ff00ff00ff00ff));
+    x = ((x << 16) & FLAC__U64L(0xffff0000ffff0000)) | ((x >> 16) & FLAC__U64L(0x0000ffff0000ffff));
+    return (x << 32) | (x >> 32);
+}
+#endif
+
+/* 'word' must not be 0 */
+#if defined(__GNUC__)
+#define COUNT_ZERO_MSBS(word) ((unsigned)__builtin_clzll(word))
+#else
+static inline unsigned COUNT_ZERO_MSBS(brword word)
+{
+    unsigned n = 0;
+    while (!(word & FLAC__U64L(0x8000000000000000))) {
+        word <<= 1;
+        n++;
+    }
+    return n;
+}
+#endif
+
+/* forces a body into each of its callers, so it is compiled again for the instruction set of every one of them */
+#if defined(__GNUC__)
+#define ALWAYS_INLINE inline __attribute__((__always_inline__))
+#else
+#define ALWAYS_INLINE inline
+#endif
+
+/**
+ * This should be at least twice as large as the largest number of words
+ * required to represent any 'number' (in any encoding) you are going to
+ * read. With FLAC this is on the order of maybe a few hundred bits.
+ * If the buffer is smaller than that, the decoder won't be able to read
+ * in a whole number that is in a variable length encoding (e.g. Rice).
+ * But to be practical it should be at least 1K bytes.
+ *
+ * Increase this number to decrease the number of read callbacks, at the
+ * expense of using more memory. The buffer is allocated once in
+ * FLAC__bitreader_init() and then reused for the whole stream.
+ */
+// 单位是word, 1024 * 8 = 8KB
+static const unsigned FLAC__BITREADER_DEFAULT_CAPACITY = 65536u / FLAC__BITS_PER_WORD;
+
+struct FLAC__BitReader {
+    /* any partially-consumed word at the head will stay right-justified as bits are consumed from the left */
+    /* any incomplete word at the tail will be left-justified, and bytes from the read callback are added on the right */
+    brword *buffer;
+    unsigned capacity; /* in words */
+    unsigned words; /* # of completed words in buffer */
+    unsigned bytes; /* # of bytes in incomplete word at buffer[words] */
+    unsigned consumed_words; /* #words ... */
+    unsigned consumed_bits; /* ... + (#bits of head word) already consumed from the front of buffer */
+    unsigned read_crc16; /* the running frame CRC */
+    unsigned crc16_align; /* the number of bits in the current consumed word that should not be CRC'd */
+    FLAC__BitReaderReadCallback read_callback;
+    void *client_data;
+    /* memory the buffer is refilled from before the read callback is asked */
+    const FLAC__byte *source;
+    size_t source_bytes;
+};
+
+static inline void crc16_update_word_(FLAC__BitReader *br, brword word)
+{
+    unsigned crc = br->read_crc16;
+
+    if (br->crc16_align == 0) {
+        br->read_crc16 = FLAC__CRC16_UPDATE_WORD64(word, crc);
+        return;
+    }
+
+    for ( ; br->crc16_align < FLAC__BITS_PER_WORD; br->crc16_align += 8)
+        crc = FLAC__CRC16_UPDATE((unsigned)((word >> (FLAC__BITS_PER_WORD - 8 - br->crc16_align)) & 0xff), crc);
+
+    br->read_crc16 = crc;
+    br->crc16_align = 0;
+}
+
+/*
+ * Refills from the memory source. As long as the tail of the buffer is
+ * word aligned, which it is until the source runs out, whole words are
+ * loaded and swapped in one pass, so the bytes are only touched once.
+ */
+static void bitreader_read_from_source_(FLAC__BitReader *br, size_t bytes)
+{
+    const FLAC__byte *source = br->source;
+    unsigned start, end;
+
+    br->source += bytes;
+    br->source_bytes -= bytes;
+
+    if (br->bytes == 0) {
+        brword *target = br->buffer + br->words;
+        brword word;
+
+        for ( ; bytes >= FLAC__BYTES_PER_WORD; bytes -= FLAC__BYTES_PER_WORD, source += FLAC__BYTES_PER_WORD) {
+            memcpy(&word, source, FLAC__BYTES_PER_WORD);
+            *target++ = SWAP_BE_WORD_TO_HOST(word);
+            br->words++;
+        }
+        if (bytes == 0)
+            return;
+        /* the last few bytes of the source become the partial tail word */
+        word = 0;
+        memcpy(&word, source, bytes);
+        *target = SWAP_BE_WORD_TO_HOST(word);
+        br->bytes = (unsigned)bytes;
+        return;
+    }
+
+    /* same as a read from the client, see bitreader_read_from_client_() */
+    br->buffer[br->words] = SWAP_BE_WORD_TO_HOST(br->buffer[br->words]);
+    memcpy(((FLAC__byte*)(br->buffer + br->words)) + br->bytes, source, bytes);
+    end = (br->words * FLAC__BYTES_PER_WORD + br->bytes + (unsigned)bytes + (FLAC__BYTES_PER_WORD - 1)) / FLAC__BYTES_PER_WORD;
+    for (start = br->words; start < end; start++)
+        br->buffer[start] = SWAP_BE_WORD_TO_HOST(br->buffer[start]);
+    end = br->words * FLAC__BYTES_PER_WORD + br->bytes + (unsigned)bytes;
+    br->words = end / FLAC__BYTES_PER_WORD;
+    br->bytes = end % FLAC__BYTES_PER_WORD;
+    if (br->bytes)
+        br->buffer[br->words] &= FLAC__WORD_ALL_ONES << ((FLAC__BYTES_PER_WORD - br->bytes) * 8);
+}
+
+static FLAC__bool bitreader_read_from_client_(FLAC__BitReader *br)
+{
+    unsigned start, end;
+    size_t bytes;
+    FLAC__byte *target;
+
+    /* first shift the unconsumed buffer data toward the front as much as possible */
+    if (br->consumed_words > 0) {
+        start = br->consumed_words;
+        end = br->words + (br->bytes ? 1 : 0);
+        memmove(br->buffer, br->buffer + start, FLAC__BYTES_PER_WORD * (end - start));
+
+        br->words -= start;
+        br->consumed_words = 0;
+    }
+
+    /*
+     * set the target for reading, taking into account word alignment and endianness
+     */
+    bytes = (br->capacity - br->words) * FLAC__BYTES_PER_WORD - br->bytes;
+    if (bytes == 0)
+        return false; /* no space left, buffer is too small; see note for FLAC__BITREADER_DEFAULT_CAPACITY  */
+    target = ((FLAC__byte*)(br->buffer + br->words)) + br->bytes;
+
+    if (br->source_bytes > 0) {
+        bitreader_read_from_source_(br, flac_min(bytes, br->source_bytes));
+        return true;
+    }
+
+    /* before reading, if the existing reader looks like this (say brword is 32 bits wide)
+     *   bitstream :  11 22 33 44 55            br->words=1 br->bytes=1 (partial tail word is left-justified)
+     *   buffer[BE]:  11 22 33 44 55 ?? ?? ??   (shown laid out as bytes sequentially in memory)
+     *   buffer[LE]:  44 33 22 11 ?? ?? ?? 55   (?? being don't-care)
+     *                               ^^-------target, bytes=3
+     * on LE machines, have to byteswap the odd tail word so nothing is
+     * overwritten:
+     */
+    if (br->bytes)
+        br->buffer[br->words] = SWAP_BE_WORD_TO_HOST(br->buffer[br->words]);
+
+    /* now it looks like:
+     *   bitstream :  11 22 33 44 55            br->words=1 br->bytes=1
+     *   buffer[BE]:  11 22 33 44 55 ?? ?? ??
+     *   buffer[LE]:  44 33 22 11 55 ?? ?? ??
+     *                               ^^-------target, bytes=3
+     */
+
+    /* read in the data; note that the callback may return a smaller number of bytes */
+    if (!br->read_callback(target, &bytes, br->client_data)) {
+        /* swap the tail word back, what is buffered can still be read after a FLAC__bitreader_reserve() that came up short */
+        if (br->bytes)
+            br->buffer[br->words] = SWAP_BE_WORD_TO_HOST(br->buffer[br->words]);
+        return false;
+    }
+
+    /* after reading bytes 66 77 88 99 AA BB CC DD EE FF from the client:
+     *   bitstream :  11 22 33 44 55 66 77 88 99 AA BB CC DD EE FF
+     *   buffer[BE]:  11 22 33 44 55 66 77 88 99 AA BB CC DD EE FF ??
+     *   buffer[LE]:  44 33 22 11 55 66 77 88 99 AA BB CC DD EE FF ??
+     * now have to byteswap on LE machines:
+     */
+    end = (br->words * FLAC__BYTES_PER_WORD + br->bytes + (unsigned)bytes + (FLAC__BYTES_PER_WORD - 1)) / FLAC__BYTES_PER_WORD;
+    for (start = br->words; start < end; start++)
+        br->buffer[start] = SWAP_BE_WORD_TO_HOST(br->buffer[start]);
+
+    /* now it looks like:
+     *   bitstream :  11 22 33 44 55 66 77 88 99 AA BB CC DD EE FF
+     *   buffer[BE]:  11 22 33 44 55 66 77 88 99 AA BB CC DD EE FF ??
+     *   buffer[LE]:  44 33 22 11 88 77 66 55 CC BB AA 99 ?? FF EE DD
+     * finally we'll update the reader values:
+     */
+    end = br->words * FLAC__BYTES_PER_WORD + br->bytes + (unsigned)bytes;
+    br->words = end / FLAC__BYTES_PER_WORD;
+    br->bytes = end % FLAC__BYTES_PER_WORD;
+
+    /* the don't-care bits of a partial tail word must read as zero */
+    if (br->bytes)
+        br->buffer[br->words] &= FLAC__WORD_ALL_ONES << ((FLAC__BYTES_PER_WORD - br->bytes) * 8);
+
+    return true;
+}
+
+static inline unsigned bits_buffered_(const FLAC__BitReader *br)
+{
+    return (br->words - br->consumed_words) * FLAC__BITS_PER_WORD + br->bytes * 8 - br->consumed_bits;
+}
+
+/*
+ * The read itself, once the caller knows the bits are buffered; 1 <= bits
+ * <= 32. A partial tail word is never left by a read, since the bits it
+ * holds are all there is, so only the read that finishes a whole word
+ * touches the next one.
+ */
+static ALWAYS_INLINE FLAC__uint32 read_raw_uint32_unchecked_(FLAC__BitReader *br, unsigned bits)
+{
+    const unsigned n = FLAC__BITS_PER_WORD - br->consumed_bits;
+    const brword word = br->buffer[br->consumed_words];
+    FLAC__uint32 val;
+
+    FLAC_ASSERT(bits >= 1 && bits <= 32);
+    FLAC_ASSERT(bits_buffered_(br) >= bits);
+
+    if (bits < n) {
+        val = (FLAC__uint32)((word << br->consumed_bits) >> (FLAC__BITS_PER_WORD - bits));
+        br->consumed_bits += bits;
+        return val;
+    }
+    /* n <= bits <= 32 here, so the remaining bits of the head word fit in val */
+    val = (FLAC__uint32)(word & (FLAC__WORD_ALL_ONES >> br->consumed_bits));
+    bits -= n;
+    crc16_update_word_(br, word);
+    br->consumed_words++;
+    br->consumed_bits = bits;
+    if (bits) /* fewer than 32 left, all of them in the next word */
+        val = (val << bits) | (FLAC__uint32)(br->buffer[br->consumed_words] >> (FLAC__BITS_PER_WORD - bits));
+    return val;
+}
+
+/***********************************************************************
+ *
+ * Class constructor/destructor
+ *
+ ***********************************************************************/
+
+FLAC__BitReader *FLAC__bitreader_new(void)
+{
+    FLAC__BitReader *br = (FLAC__BitReader*)calloc(1, sizeof(FLAC__BitReader));
+
+    /* calloc() implies:
+        memset(br, 0, sizeof(FLAC__BitReader));
+        br->buffer = 0;
+        br->capacity = 0;
+        br->words = br->bytes = 0;
+        br->consumed_words = br->consumed_bits = 0;
+        br->read_callback = 0;
+        br->client_data = 0;
+        br->source = 0;
+        br->source_bytes = 0;
+    */
+    return br;
+}
+
+void FLAC__bitreader_delete(FLAC__BitReader *br)
+{
+    FLAC_ASSERT(0 != br);
+
+    FLAC__bitreader_free(br);
+    free(br);
+}
+
+/***********************************************************************
+ *
+ * Public class methods
+ *
+ ***********************************************************************/
+
+FLAC__bool FLAC__bitreader_init(FLAC__BitReader *br, FLAC__BitReaderReadCallback rcb, void *cd)
+{
+    FLAC_ASSERT(0 != br);
+
+    br->words = br->bytes = 0;
+    br->consumed_words = br->consumed_bits = 0;
+    /* a reader that is re-initialized for the next stream keeps its buffer */
+    if (br->buffer == 0) {
+        br->capacity = FLAC__BITREADER_DEFAULT_CAPACITY;
+        br->buffer = (brword*)malloc(sizeof(brword) * br->capacity);
+        if (br->buffer == 0)
+            return false;
+    }
+    br->read_callback = rcb;
+    br->client_data = cd;
+    br->source = 0;
+    br->source_bytes = 0;
+
+    return true;
+}
+
+void FLAC__bitreader_free(FLAC__BitReader *br)
+{
+    FLAC_ASSERT(0 != br);
+
+    if (0 != br->buffer)
+        free(br->buffer);
+    br->buffer = 0;
+    br->capacity = 0;
+    br->words = br->bytes = 0;
+    br->consumed_words = br->consumed_bits = 0;
+    br->read_callback = 0;
+    br->client_data = 0;
+    br->source = 0;
+    br->source_bytes = 0;
+}
+
+FLAC__bool FLAC__bitreader_clear(FLAC__BitReader *br)
+{
+    br->words = br->bytes = 0;
+    br->consumed_words = br->consumed_bits = 0;
+    return true;
+}
+
+void FLAC__bitreader_set_source(FLAC__BitReader *br, const FLAC__byte *data, size_t bytes)
+{
+    FLAC_ASSERT(0 != br);
+    FLAC_ASSERT(0 != data || bytes == 0);
+
+    br->source = data;
+    br->source_bytes = bytes;
+}
+
+size_t FLAC__bitreader_get_source_bytes_left(const FLAC__BitReader *br)
+{
+    return br->source_bytes;
+}
+
+void FLAC__bitreader_reset_read_crc16(FLAC__BitReader *br, FLAC__uint16 seed)
+{
+    FLAC_ASSERT(0 != br);
+    FLAC_ASSERT(0 != br->buffer);
+    FLAC_ASSERT((br->consumed_bits & 7) == 0);
+
+    br->read_crc16 = (unsigned)seed;
+    br->crc16_align = br->consumed_bits;
+}
+
+FLAC__uint16 FLAC__bitreader_get_read_crc16(FLAC__BitReader *br)
+{
+    FLAC_ASSERT(0 != br);
+    FLAC_ASSERT(0 != br->buffer);
+    FLAC_ASSERT((br->consumed_bits & 7) == 0);
+    FLAC_ASSERT(br->crc16_align <= br->consumed_bits);
+
+    /* CRC any tail bytes in a partially-consumed word */
+    if (br->consumed_bits) {
+        const brword tail = br->buffer[br->consumed_words];
+        for ( ; br->crc16_align < br->consumed_bits; br->crc16_align += 8)
+            br->read_crc16 = FLAC__CRC16_UPDATE((unsigned)((tail >> (FLAC__BITS_PER_WORD - 8 - br->crc16_align)) & 0xff), br->read_crc16);
+    }
+    return (FLAC__uint16)br->read_crc16;
+}
+
+FLAC__bool FLAC__bitreader_is_consumed_byte_aligned(const FLAC__BitReader *br)
+{
+    return ((br->consumed_bits & 7) == 0);
+}
+
+unsigned FLAC__bitreader_bits_left_for_byte_alignment(const FLAC__BitReader *br)
+{
+    return 8 - (br->consumed_bits & 7);
+}
+
+unsigned FLAC__bitreader_get_input_bits_unconsumed(const FLAC__BitReader *br)
+{
+    return bits_buffered_(br);
+}
+
+FLAC__bool FLAC__bitreader_reserve(FLAC__BitReader *br, unsigned bits)
+{
+    /* the data starts in the first word once the consumed words are shifted out, plus a word for a partial tail */
+    const unsigned words = (br->consumed_bits + bits + FLAC__BITS_PER_WORD - 1) / FLAC__BITS_PER_WORD + 1;
+
+    FLAC_ASSERT(0 != br);
+    FLAC_ASSERT(0 != br->buffer);
+
+    if (bits_buffered_(br) >= bits)
+        return true;
+    if (words > br->capacity) {
+        brword *buffer = (brword*)realloc(br->buffer, sizeof(brword) * words);
+        if (buffer == 0)
+            return false;
+        br->buffer = buffer;
+        br->capacity = words;
+    }
+    while (bits_buffered_(br) < bits) {
+        if (!bitreader_read_from_client_(br))
+            return false;
+    }
+    return true;
+}
+
+FLAC__bool FLAC__bitreader_read_raw_uint32(FLAC__BitReader *br, FLAC__uint32 *val, unsigned bits)
+{
+    FLAC_ASSERT(0 != br);
+    FLAC_ASSERT(0 != br->buffer);
+
+    FLAC_ASSERT(bits <= 32);
+    FLAC_ASSERT((br->capacity * FLAC__BITS_PER_WORD) * 2 >= bits);
+    FLAC_ASSERT(br->consumed_words <= br->words);
+
+    if (bits == 0) { /* OPT: investigate if this can ever happen, maybe change to assertion */
+        *val = 0;
+        return true;
+    }
+
+    while (bits_buffered_(br) < bits) {
+        if (!bitreader_read_from_client_(br))
+            return false;
+    }
+    *val = read_raw_uint32_unchecked_(br, bits);
+    return true;
+}
+
+FLAC__bool FLAC__bitreader_read_raw_int32(FLAC__BitReader *br, FLAC__int32 *val, unsigned bits)
+{
+    FLAC__uint32 uval, mask;
+    /* OPT: inline raw uint32 code here, or make into a macro if possible in the .h file */
+    if (bits < 1 || !FLAC__bitreader_read_raw_uint32(br, &uval, bits))
+        return false;
+    /* sign-extend *val assuming it is currently bits wide. */
+    /* From: https://graphics.stanford.edu/~seander/bithacks.html#FixedSignExtend */
+    mask = 1u << (bits - 1);
+    *val = (FLAC__int32)((uval ^ mask) - mask);
+    return true;
+}
+
+FLAC__bool FLAC__bitreader_read_raw_uint64(FLAC__BitReader *br, FLAC__uint64 *val, unsigned bits)
+{
+    FLAC__uint32 hi, lo;
+
+    if (bits > 32) {
+        if (!FLAC__bitreader_read_raw_uint32(br, &hi, bits - 32))
+            return false;
+        if (!FLAC__bitreader_read_raw_uint32(br, &lo, 32))
+            return false;
+        *val = hi;
+        *val <<= 32;
+        *val |= lo;
+    }
+    else {
+        if (!FLAC__bitreader_read_raw_uint32(br, &lo, bits))
+            return false;
+        *val = lo;
+    }
+    return true;
+}
+
+FLAC__bool FLAC__bitreader_read_raw_int64(FLAC__BitReader *br, FLAC__int64 *val, unsigned bits)
+{
+    FLAC__uint64 uval, mask;
+    /* OPT: inline raw uint64 code here, or make into a macro if possible in the .h file */
+    if (bits < 1 || !FLAC__bitreader_read_raw_uint64(br, &uval, bits))
+        return false;
+    /* sign-extend *val assuming it is currently bits wide. */
+    mask = ((FLAC__uint64)1) << (bits - 1);
+    *val = (FLAC__int64)((uval ^ mask) - mask);
+    return true;
+}
+
+/*
+ * The block reads make sure of the whole block once, refilling as often
+ * as it takes, and then read every value without looking again.
+ */
+FLAC__bool FLAC__bitreader_read_raw_int32_block(FLAC__BitReader *br, FLAC__int32 vals[], unsigned nvals, unsigned bits)
+{
+    const FLAC__uint32 mask = 1u << (bits - 1);
+    unsigned i;
+
+    FLAC_ASSERT(bits >= 1 && bits <= 32);
+
+    if (!FLAC__bitreader_reserve(br, nvals * bits))
+        return false;
+    for (i = 0; i < nvals; i++)
+        vals[i] = (FLAC__int32)((read_raw_uint32_unchecked_(br, bits) ^ mask) - mask);
+    return true;
+}
+
+FLAC__bool FLAC__bitreader_read_raw_int64_block(FLAC__BitReader *br, FLAC__int64 vals[], unsigned nvals, unsigned bits)
+{
+    const FLAC__uint64 mask = ((FLAC__uint64)1) << (bits - 1);
+    FLAC__uint64 uval;
+    unsigned i;
+
+    FLAC_ASSERT(bits >= 1 && bits <= 64);
+
+    if (!FLAC__bitreader_reserve(br, nvals * bits))
+        return false;
+    for (i = 0; i < nvals; i++) {
+        if (bits > 32) {
+            uval = (FLAC__uint64)read_raw_uint32_unchecked_(br, bits - 32) << 32;
+            uval |= read_raw_uint32_unchecked_(br, 32);
+        }
+        else
+            uval = read_raw_uint32_unchecked_(br, bits);
+        vals[i] = (FLAC__int64)((uval ^ mask) - mask);
+    }
+    return true;
+}
+
+FLAC__bool FLAC__bitreader_skip_bits_no_crc(FLAC__BitReader *br, unsigned bits)
+{
+    /*
+     * OPT: a faster implementation is possible but probably not that useful
+     * since this is only called a couple of times in the metadata readers.
+     */
+    FLAC_ASSERT(0 != br);
+    FLAC_ASSERT(0 != br->buffer);
+
+    if (bits > 0) {
+        const unsigned n = br->consumed_bits & 7;
+        unsigned m;
+        FLAC__uint32 x;
+
+        if (n != 0) {
+            m = flac_min(8 - n, bits);
+            if (!FLAC__bitreader_read_raw_uint32(br, &x, m))
+                return false;
+            bits -= m;
+        }
+        m = bits / 8;
+        if (m > 0) {
+            if (!FLAC__bitreader_skip_byte_block_aligned_no_crc(br, m))
+                return false;
+            bits %= 8;
+        }
+        if (bits > 0) {
+            if (!FLAC__bitreader_read_raw_uint32(br, &x, bits))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+FLAC__bool FLAC__bitreader_skip_byte_block_aligned_no_crc(FLAC__BitReader *br, unsigned nvals)
+{
+    FLAC__uint32 x;
+
+    FLAC_ASSERT(0 != br);
+    FLAC_ASSERT(0 != br->buffer);
+    FLAC_ASSERT(FLAC__bitreader_is_consumed_byte_aligned(br));
+
+    /* step 1: skip over partial head word to get word aligned */
+    while (nvals && br->consumed_bits) { /* i.e. run until we read 'nvals' bytes or we hit the end of the head word */
+        if (!FLAC__bitreader_read_raw_uint32(br, &x, 8))
+            return false;
+        nvals--;
+    }
+    if (0 == nvals)
+        return true;
+    /* step 2: skip whole words in chunks */
+    while (nvals >= FLAC__BYTES_PER_WORD) {
+        if (br->consumed_words < br->words) {
+            br->consumed_words++;
+            nvals -= FLAC__BYTES_PER_WORD;
+        }
+        else if (!bitreader_read_from_client_(br))
+            return false;
+    }
+    /* step 3: skip any remainder from partial tail bytes */
+    while (nvals) {
+        if (!FLAC__bitreader_read_raw_uint32(br, &x, 8))
+            return false;
+        nvals--;
+    }
+
+    return true;
+}
+
+FLAC__bool FLAC__bitreader_read_byte_block_aligned_no_crc(FLAC__BitReader *br, FLAC__byte *val, unsigned nvals)
+{
+    FLAC__uint32 x;
+
+    FLAC_ASSERT(0 != br);
+    FLAC_ASSERT(0 != br->buffer);
+    FLAC_ASSERT(FLAC__bitreader_is_consumed_byte_aligned(br));
+
+    /* step 1: read from partial head word to get word aligned */
+    while (nvals && br->consumed_bits) { /* i.e. run until we read 'nvals' bytes or we hit the end of the head word */
+        if (!FLAC__bitreader_read_raw_uint32(br, &x, 8))
+            return false;
+        *val++ = (FLAC__byte)x;
+        nvals--;
+    }
+    if (0 == nvals)
+        return true;
+    /* step 2: read whole words in chunks */
+    while (nvals >= FLAC__BYTES_PER_WORD) {
+        if (br->consumed_words < br->words) {
+            const brword word = br->buffer[br->consumed_words++];
+            val[0] = (FLAC__byte)(word >> 56);
+            val[1] = (FLAC__byte)(word >> 48);
+            val[2] = (FLAC__byte)(word >> 40);
+            val[3] = (FLAC__byte)(word >> 32);
+            val[4] = (FLAC__byte)(word >> 24);
+            val[5] = (FLAC__byte)(word >> 16);
+            val[6] = (FLAC__byte)(word >> 8);
+            val[7] = (FLAC__byte)word;
+            val += FLAC__BYTES_PER_WORD;
+            nvals -= FLAC__BYTES_PER_WORD;
+        }
+        else if (!bitreader_read_from_client_(br))
+            return false;
+    }
+    /* step 3: read any remainder from partial tail bytes */
+    while (nvals) {
+        if (!FLAC__bitreader_read_raw_uint32(br, &x, 8))
+            return false;
+        *val++ = (FLAC__byte)x;
+        nvals--;
+    }
+
+    return true;
+}
+
+FLAC__bool FLAC__bitreader_read_unary_unsigned(FLAC__BitReader *br, unsigned *val)
+{
+    unsigned i;
+
+    FLAC_ASSERT(0 != br);
+    FLAC_ASSERT(0 != br->buffer);
+
+    *val = 0;
+    while (1) {
+        while (br->consumed_words < br->words) { /* if we've not consumed up to a partial tail word... */
+            brword b = br->buffer[br->consumed_words] << br->consumed_bits;
+            if (b) {
+                i = COUNT_ZERO_MSBS(b);
+                *val += i;
+                i++;
+                br->consumed_bits += i;
+                if (br->consumed_bits >= FLAC__BITS_PER_WORD) { /* faster way of testing if(br->consumed_bits == FLAC__BITS_PER_WORD) */
+                    crc16_update_word_(br, br->buffer[br->consumed_words]);
+                    br->consumed_words++;
+                    br->consumed_bits = 0;
+                }
+                return true;
+            }
+            else {
+                *val += FLAC__BITS_PER_WORD - br->consumed_bits;
+                crc16_update_word_(br, br->buffer[br->consumed_words]);
+                br->consumed_words++;
+                br->consumed_bits = 0;
+                /* didn't find stop bit yet, have to keep going... */
+            }
+        }
+        /* at this point we've eaten up all the whole words; have to try
+         * reading through any tail bytes before calling the read callback.
+         * this is a repeat of the above logic adjusted for the fact we
+         * don't have a whole word.  note though if the client is feeding
+         * us data a byte at a time (unlikely), br->consumed_bits may not
+         * be zero.
+         */
+        if (br->bytes * 8 > br->consumed_bits) {
+            const unsigned end = br->bytes * 8;
+            brword b = (br->buffer[br->consumed_words] & (FLAC__WORD_ALL_ONES << (FLAC__BITS_PER_WORD - end))) << br->consumed_bits;
+            if (b) {
+                i = COUNT_ZERO_MSBS(b);
+                *val += i;
+                i++;
+                br->consumed_bits += i;
+                FLAC_ASSERT(br->consumed_bits < FLAC__BITS_PER_WORD);
+                return true;
+            }
+            else {
+                *val += end - br->consumed_bits;
+                br->consumed_bits = end;
+                FLAC_ASSERT(br->consumed_bits < FLAC__BITS_PER_WORD);
+                /* didn't find stop bit yet, have to keep going... */
+            }
+        }
+        if (!bitreader_read_from_client_(br))
+            return false;
+    }
+}
+
+FLAC__bool FLAC__bitreader_read_rice_signed(FLAC__BitReader *br, int *val, unsigned parameter)
+{
+    FLAC__uint32 lsbs = 0, msbs = 0;
+    unsigned uval;
+
+    FLAC_ASSERT(0 != br);
+    FLAC_ASSERT(0 != br->buffer);
+    FLAC_ASSERT(parameter <= 31);
+
+    /* read the unary MSBs and end bit */
+    if (!FLAC__bitreader_read_unary_unsigned(br, &msbs))
+        return false;
+
+    /* read the binary LSBs */
+    if (!FLAC__bitreader_read_raw_uint32(br, &lsbs, parameter))
+        return false;
+
+    /* compose the value */
+    uval = (msbs << parameter) | lsbs;
+    if (uval & 1)
+        *val = -((int)(uval >> 1)) - 1;
+    else
+        *val = (int)(uval >> 1);
+
+    return true;
+}
+
+/*
+ * Decodes a whole partition. While the buffer holds two complete words
+ * past the current position, the next 64 bits of the stream are kept
+ * left-justified in 'peek' and codewords are peeled off the top of it,
+ * clz for the unary part and a shift for the binary part. 'peek' is only
+ * rebuilt from the buffer when the next codeword runs past the bits it
+ * still holds, so the loop-carried work per value is a clz and a shift.
+ * Near the end of the buffered data, and for the rare codeword that does
+ * not fit in 64 bits, it drops to FLAC__bitreader_read_rice_signed().
+ *
+ * The body is shared by FLAC__bitreader_read_rice_signed_block() and its
+ * BMI2 build, where the clz becomes an LZCNT and the variable shifts
+ * become SHLX/SHRX, which leave the flags alone and take any register
+ * for the count.
+ */
+static ALWAYS_INLINE FLAC__bool read_rice_signed_block_(FLAC__BitReader *br, int vals[], unsigned nvals, unsigned parameter)
+{
+    int *end = vals + nvals;
+
+    FLAC_ASSERT(0 != br);
+    FLAC_ASSERT(0 != br->buffer);
+    FLAC_ASSERT(parameter < 32);
+
+    while (vals < end) {
+        if (br->consumed_words + 1 < br->words) {
+            unsigned cwords = br->consumed_words;
+            unsigned cbits = br->consumed_bits;
+            brword peek = (br->buffer[cwords] << cbits) | ((br->buffer[cwords + 1] >> 1) >> (FLAC__BITS_PER_WORD - 1 - cbits));
+            unsigned valid = FLAC__BITS_PER_WORD;
+
+            while (vals < end) {
+                const unsigned msbs = peek ? COUNT_ZERO_MSBS(peek) : FLAC__BITS_PER_WORD;
+                const unsigned len = msbs + 1 + parameter;
+                unsigned uval;
+
+                if (len >= valid) {
+                    /* move the window up to the current position, or give up on it */
+                    cbits += FLAC__BITS_PER_WORD - valid;
+                    if (cbits >= FLAC__BITS_PER_WORD) {
+                        crc16_update_word_(br, br->buffer[cwords]);
+                        cwords++;
+                        cbits -= FLAC__BITS_PER_WORD;
+                    }
+                    if (valid == FLAC__BITS_PER_WORD || cwords + 1 >= br->words)
+                        break;
+                    peek = (br->buffer[cwords] << cbits) | ((br->buffer[cwords + 1] >> 1) >> (FLAC__BITS_PER_WORD - 1 - cbits));
+                    valid = FLAC__BITS_PER_WORD;
+                    continue;
+                }
+
+                /* len < 64, so none of the shifts can be out of range */
+                uval = (msbs << parameter) | (unsigned)(((peek << (msbs + 1)) >> 1) >> (FLAC__BITS_PER_WORD - 1 - parameter));
+                *vals++ = (int)(uval >> 1) ^ -(int)(uval & 1);
+                peek <<= len;
+                valid -= len;
+            }
+            if (vals == end) {
+                cbits += FLAC__BITS_PER_WORD - valid;
+                if (cbits >= FLAC__BITS_PER_WORD) {
+                    crc16_update_word_(br, br->buffer[cwords]);
+                    cwords++;
+                    cbits -= FLAC__BITS_PER_WORD;
+                }
+            }
+            br->consumed_words = cwords;
+            br->consumed_bits = cbits;
+            if (vals == end)
+                break;
+        }
+
+        /* near the end of the buffered data, or an unusually long codeword */
+        if (!FLAC__bitreader_read_rice_signed(br, vals, parameter))
+            return false;
+        vals++;
+    }
+    return true;
+}
+
+FLAC__bool FLAC__bitreader_read_rice_signed_block(FLAC__BitReader *br, int vals[], unsigned nvals, unsigned parameter)
+{
+    return read_rice_signed_block_(br, vals, nvals, parameter);
+}
+
+#ifdef FLAC__BMI2_SUPPORTED
+FLAC__SSE_TARGET("bmi2,lzcnt")
+FLAC__bool FLAC__bitreader_read_rice_signed_block_bmi2(FLAC__BitReader *br, int vals[], unsigned nvals, unsigned parameter)
+{
+    return read_rice_signed_block_(br, vals, nvals, parameter);
+}
+#endif
+
+/* on return, if *val == 0xffffffff then the utf-8 sequence was invalid, but the return value will be true */
+FLAC__bool FLAC__bitreader_read_utf8_uint32(FLAC__BitReader *br, FLAC__uint32 *val, FLAC__byte *raw, unsigned *rawlen)
+{
+    FLAC__uint32 v = 0;
+    FLAC__uint32 x;
+    unsigned i;
+
+    if (!FLAC__bitreader_read_raw_uint32(br, &x, 8))
+        return false;
+    if (raw)
+        raw[(*rawlen)++] = (FLAC__byte)x;
+    if (!(x & 0x80)) { /* 0xxxxxxx */
+        v = x;
+        i = 0;
+    }
+    else if (x & 0xC0 && !(x & 0x20)) { /* 110xxxxx */
+        v = x & 0x1F;
+        i = 1;
+    }
+    else if (x & 0xE0 && !(x & 0x10)) { /* 1110xxxx */
+        v = x & 0x0F;
+        i = 2;
+    }
+    else if (x & 0xF0 && !(x & 0x08)) { /* 11110xxx */
+        v = x & 0x07;
+        i = 3;
+    }
+    else if (x & 0xF8 && !(x & 0x04)) { /* 111110xx */
+        v = x & 0x03;
+        i = 4;
+    }
+    else if (x & 0xFC && !(x & 0x02)) { /* 1111110x */
+        v = x & 0x01;
+        i = 5;
+    }
+    else {
+        *val = 0xffffffff;
+        return true;
+    }
+    for ( ; i; i--) {
+        if (!FLAC__bitreader_read_raw_uint32(br, &x, 8))
+            return false;
+        if (raw)
+            raw[(*rawlen)++] = (FLAC__byte)x;
+        if (!(x & 0x80) || (x & 0x40)) { /* 10xxxxxx */
+            *val = 0xffffffff;
+            return true;
+        }
+        v <<= 6;
+        v |= (x & 0x3F);
+    }
+    *val = v;
+    return true;
+}
+
+/* on return, if *val == 0xffffffffffffffff then the utf-8 sequence was invalid, but the return value will be true */
+FLAC__bool FLAC__bitreader_read_utf8_uint64(FLAC__BitReader *br, FLAC__uint64 *val, FLAC__byte *raw, unsigned *rawlen)
+{
+    FLAC__uint64 v = 0;
+    FLAC__uint32 x;
+    unsigned i;
+
+    if (!FLAC__bitreader_read_raw_uint32(br, &x, 8))
+        return false;
+    if (raw)
+        raw[(*rawlen)++] = (FLAC__byte)x;
+    if (!(x & 0x80)) { /* 0xxxxxxx */
+        v = x;
+        i = 0;
+    }
+    else if (x & 0xC0 && !(x & 0x20)) { /* 110xxxxx */
+        v = x & 0x1F;
+        i = 1;
+    }
+    else if (x & 0xE0 && !(x & 0x10)) { /* 1110xxxx */
+        v = x & 0x0F;
+        i = 2;
+    }
+    else if (x & 0xF0 && !(x & 0x08)) { /* 11110xxx */
+        v = x & 0x07;
+        i = 3;
+    }
+    else if (x & 0xF8 && !(x & 0x04)) { /* 111110xx */
+        v = x & 0x03;
+        i = 4;
+    }
+    else if (x & 0xFC && !(x & 0x02)) { /* 1111110x */
+        v = x & 0x01;
+        i = 5;
+    }
+    else if (x & 0xFE && !(x & 0x01)) { /* 11111110 */
+        v = 0;
+        i = 6;
+    }
+    else {
+        *val = FLAC__U64L(0xffffffffffffffff);
+        return true;
+    }
+    for ( ; i; i--) {
+        if (!FLAC__bitreader_read_raw_uint32(br, &x, 8))
+            return false;
+        if (raw)
+            raw[(*rawlen)++] = (FLAC__byte)x;
+        if (!(x & 0x80) || (x & 0x40)) { /* 10xxxxxx */
+            *val = FLAC__U64L(0xffffffffffffffff);
+            return true;
+        }
+        v <<= 6;
+        v |= (x & 0x3F);
+    }
+    *val = v;
+    return true;
+}
@@ -0,0 +1,439 @@
+#include <stdlib.h>
+#include <string.h>
+#include "private/bitwriter.h"
+#include "private/crc.h"
+#include "private/macros.h"
+#include "FLAC/assert.h"
+
+// 按字(word)写入数据: bit先在64位的accum里攒满，再以大端字节序存进buffer，
+// 这样buffer本身就是码流，FLAC__bitwriter_get_buffer()可以直接交出去。
+
+typedef FLAC__uint64 bwword;
+#define FLAC__BYTES_PER_WORD 8u
+#define FLAC__BITS_PER_WORD 64u
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define SWAP_BE_WORD_TO_HOST(x) (x)
+#elif defined(__GNUC__)
+#define SWAP_BE_WORD_TO_HOST(x) __builtin_bswap64(x)
+#else
+static inline bwword SWAP_BE_WORD_TO_HOST(bwword x)
+{
+    x = ((x << 8) & FLAC__U64L(0xff00ff00ff00ff00)) | ((x >> 8) & FLAC__U64L(0x00ff00ff00ff00ff));
+    x = ((x << 16) & FLAC__U64L(0xffff0000ffff0000)) | ((x >> 16) & FLAC__U64L(0x0000ffff0000ffff));
+    return (x << 32) | (x >> 32);
+}
+#endif
+
+/**
+ * The default capacity when FLAC__bitwriter_init() is given no size hint.
+ * The buffer grows in FLAC__BITWRITER_DEFAULT_INCREMENT steps (rounded up
+ * to what the write needs) and never shrinks, so a writer that is reused
+ * frame after frame stops allocating once it has seen the largest frame.
+ */
+// 单位是word
+static const unsigned FLAC__BITWRITER_DEFAULT_CAPACITY = 32768u / FLAC__BITS_PER_WORD;
+static const unsigned FLAC__BITWRITER_DEFAULT_INCREMENT = 4096u / FLAC__BITS_PER_WORD;
+
+struct FLAC__BitWriter {
+    bwword *buffer; /* completed words, stored big-endian */
+    bwword accum; /* accumulator; bits are right-justified; when full, accum is appended to buffer */
+    unsigned capacity; /* capacity of buffer in words */
+    unsigned words; /* # of complete words in buffer */
+    unsigned bits; /* # of used bits in accum */
+};
+
+/* * WATCHOUT: The current implementation only grows the buffer. */
+static FLAC__bool bitwriter_grow_(FLAC__BitWriter *bw, unsigned bits_to_add)
+{
+    unsigned new_capacity;
+    bwword *new_buffer;
+
+    FLAC_ASSERT(0 != bw);
+    FLAC_ASSERT(0 != bw->buffer);
+
+    /* calculate total words needed to store 'bits_to_add' additional bits;
+     * one more word is kept spare for FLAC__bitwriter_get_buffer() to
+     * flush the accumulator into */
+    new_capacity = bw->words + ((bw->bits + bits_to_add + FLAC__BITS_PER_WORD - 1) / FLAC__BITS_PER_WORD) + 1;
+
+    /* it's possible (due to pessimism in the growth estimation that
+     * leads to this call) that we don't actually need to grow
+     */
+    if (bw->capacity >= new_capacity)
+        return true;
+
+    /* round up capacity increase to the nearest FLAC__BITWRITER_DEFAULT_INCREMENT */
+    if ((new_capacity - bw->capacity) % FLAC__BITWRITER_DEFAULT_INCREMENT)
+        new_capacity += FLAC__BITWRITER_DEFAULT_INCREMENT - ((new_capacity - bw->capacity) % FLAC__BITWRITER_DEFAULT_INCREMENT);
+
+    new_buffer = (bwword*)realloc(bw->buffer, sizeof(bwword) * new_capacity);
+    if (new_buffer == 0)
+        return false;
+    bw->buffer = new_buffer;
+    bw->capacity = new_capacity;
+    return true;
+}
+
+/* makes sure 'bits' more bits fit without growing in the middle of a write */
+static inline FLAC__bool bitwriter_reserve_(FLAC__BitWriter *bw, unsigned bits)
+{
+    if (bw->capacity <= bw->words + (bw->bits + bits) / FLAC__BITS_PER_WORD + 1)
+        return bitwriter_grow_(bw, bits);
+    return true;
+}
+
+/* 'val' must fit in 'bits' bits and 'bits' must be 1 to 32; space must be reserved */
+static inline void bitwriter_put_(FLAC__BitWriter *bw, FLAC__uint32 val, unsigned bits)
+{
+    unsigned left = FLAC__BITS_PER_WORD - bw->bits;
+
+    if (bits < left) {
+        bw->accum <<= bits;
+        bw->accum |= val;
+        bw->bits += bits;
+    }
+    else {
+        /* the accumulator has at least 33 bits in it, so 'left' is below 32
+         * and the shift is defined; the high bits left in accum after the
+         * store are shifted out again before the next one */
+        bw->accum <<= left;
+        bw->accum |= val >> (bw->bits = bits - left);
+        bw->buffer[bw->words++] = SWAP_BE_WORD_TO_HOST(bw->accum);
+        bw->accum = val;
+    }
+}
+
+/***********************************************************************
+ *
+ * Class constructor/destructor
+ *
+ ***********************************************************************/
+
+FLAC__BitWriter *FLAC__bitwriter_new(void)
+{
+    FLAC__BitWriter *bw = (FLAC__BitWriter*)calloc(1, sizeof(FLAC__BitWriter));
+    /* note that calloc() sets all members to 0 for us */
+    return bw;
+}
+
+void FLAC__bitwriter_delete(FLAC__BitWriter *bw)
+{
+    FLAC_ASSERT(0 != bw);
+
+    FLAC__bitwriter_free(bw);
+    free(bw);
+}
+
+/***********************************************************************
+ *
+ * Public class methods
+ *
+ ***********************************************************************/
+
+FLAC__bool FLAC__bitwriter_init(FLAC__BitWriter *bw, size_t bytes)
+{
+    unsigned capacity;
+
+    FLAC_ASSERT(0 != bw);
+
+    bw->words = bw->bits = 0;
+    bw->accum = 0;
+
+    capacity = bytes ? (unsigned)((bytes + FLAC__BYTES_PER_WORD - 1) / FLAC__BYTES_PER_WORD) + 1 : FLAC__BITWRITER_DEFAULT_CAPACITY;
+    /* a re-init only ever grows the buffer */
+    if (bw->buffer != 0 && bw->capacity >= capacity)
+        return true;
+    free(bw->buffer);
+    bw->buffer = (bwword*)malloc(sizeof(bwword) * capacity);
+    if (bw->buffer == 0) {
+        bw->capacity = 0;
+        return false;
+    }
+    bw->capacity = capacity;
+    return true;
+}
+
+void FLAC__bitwriter_free(FLAC__BitWriter *bw)
+{
+    FLAC_ASSERT(0 != bw);
+
+    free(bw->buffer);
+    bw->buffer = 0;
+    bw->capacity = 0;
+    bw->words = bw->bits = 0;
+    bw->accum = 0;
+}
+
+void FLAC__bitwriter_clear(FLAC__BitWriter *bw)
+{
+    bw->words = bw->bits = 0;
+    bw->accum = 0;
+}
+
+FLAC__bool FLAC__bitwriter_get_write_crc8(FLAC__BitWriter *bw, FLAC__byte *crc)
+{
+    const FLAC__byte *buffer;
+    size_t bytes;
+
+    FLAC_ASSERT((bw->bits & 7) == 0); /* assert that we're byte-aligned */
+
+    if (!FLAC__bitwriter_get_buffer(bw, &buffer, &bytes))
+        return false;
+
+    *crc = FLAC__crc8(buffer, (unsigned)bytes);
+    return true;
+}
+
+FLAC__bool FLAC__bitwriter_get_write_crc16(FLAC__BitWriter *bw, FLAC__uint16 *crc)
+{
+    const FLAC__byte *buffer;
+    size_t bytes;
+
+    FLAC_ASSERT((bw->bits & 7) == 0); /* assert that we're byte-aligned */
+
+    if (!FLAC__bitwriter_get_buffer(bw, &buffer, &bytes))
+        return false;
+
+    *crc = (FLAC__uint16)FLAC__crc16(buffer, (unsigned)bytes);
+    return true;
+}
+
+FLAC__bool FLAC__bitwriter_is_byte_aligned(const FLAC__BitWriter *bw)
+{
+    return ((bw->bits & 7) == 0);
+}
+
+unsigned FLAC__bitwriter_get_input_bits_unconsumed(const FLAC__BitWriter *bw)
+{
+    return bw->words * FLAC__BITS_PER_WORD + bw->bits;
+}
+
+FLAC__bool FLAC__bitwriter_get_buffer(FLAC__BitWriter *bw, const FLAC__byte **buffer, size_t *bytes)
+{
+    FLAC_ASSERT((bw->bits & 7) == 0);
+    /* double protection */
+    if (bw->bits & 7)
+        return false;
+    /* if we have bits in the accumulator we have to flush those to the buffer first */
+    if (bw->bits) {
+        FLAC_ASSERT(bw->words < bw->capacity);
+        /* the spare word is not counted in bw->words, so later writes carry on from accum */
+        bw->buffer[bw->words] = SWAP_BE_WORD_TO_HOST(bw->accum << (FLAC__BITS_PER_WORD - bw->bits));
+    }
+    /* now we can just return what we have */
+    *buffer = (const FLAC__byte*)bw->buffer;
+    *bytes = (FLAC__BYTES_PER_WORD * bw->words) + (bw->bits >> 3);
+    return true;
+}
+
+FLAC__bool FLAC__bitwriter_write_zeroes(FLAC__BitWriter *bw, unsigned bits)
+{
+    unsigned n;
+
+    FLAC_ASSERT(0 != bw);
+    FLAC_ASSERT(0 != bw->buffer);
+
+    if (bits == 0)
+        return true;
+    if (!bitwriter_reserve_(bw, bits))
+        return false;
+    while (bits > 0) {
+        n = flac_min(32u, bits);
+        bitwriter_put_(bw, 0, n);
+        bits -= n;
+    }
+    return true;
+}
+
+FLAC__bool FLAC__bitwriter_write_raw_uint32(FLAC__BitWriter *bw, FLAC__uint32 val, unsigned bits)
+{
+    FLAC_ASSERT(0 != bw);
+    FLAC_ASSERT(0 != bw->buffer);
+    FLAC_ASSERT(bits <= 32);
+
+    if (bits == 0)
+        return true;
+    FLAC_ASSERT(bits == 32 || (val >> bits) == 0);
+    if (!bitwriter_reserve_(bw, bits))
+        return false;
+    bitwriter_put_(bw, val, bits);
+    return true;
+}
+
+FLAC__bool FLAC__bitwriter_write_raw_int32(FLAC__BitWriter *bw, FLAC__int32 val, unsigned bits)
+{
+    /* zero-out unused bits */
+    if (bits < 32)
+        val &= (~(0xffffffff << bits));
+
+    return FLAC__bitwriter_write_raw_uint32(bw, (FLAC__uint32)val, bits);
+}
+
+FLAC__bool FLAC__bitwriter_write_raw_uint64(FLAC__BitWriter *bw, FLAC__uint64 val, unsigned bits)
+{
+    /* this could be a little faster but it's not used for much */
+    if (bits > 32) {
+        return
+            FLAC__bitwriter_write_raw_uint32(bw, (FLAC__uint32)(val >> 32), bits - 32) &&
+            FLAC__bitwriter_write_raw_uint32(bw, (FLAC__uint32)val, 32);
+    }
+    else
+        return FLAC__bitwriter_write_raw_uint32(bw, (FLAC__uint32)val, bits);
+}
+
+FLAC__bool FLAC__bitwriter_write_raw_int64(FLAC__BitWriter *bw, FLAC__int64 val, unsigned bits)
+{
+    FLAC__uint64 uval = (FLAC__uint64)val;
+
+    /* zero-out unused bits */
+    if (bits < 64)
+        uval &= (~(FLAC__U64L(0xffffffffffffffff) << bits));
+
+    return FLAC__bitwriter_write_raw_uint64(bw, uval, bits);
+}
+
+FLAC__bool FLAC__bitwriter_write_byte_block(FLAC__BitWriter *bw, const FLAC__byte vals[], unsigned nvals)
+{
+    unsigned i;
+
+    if (!bitwriter_reserve_(bw, nvals * 8))
+        return false;
+    for (i = 0; i < nvals; i++)
+        bitwriter_put_(bw, (FLAC__uint32)(vals[i]), 8);
+    return true;
+}
+
+FLAC__bool FLAC__bitwriter_write_unary_unsigned(FLAC__BitWriter *bw, unsigned val)
+{
+    if (val < 32)
+        return FLAC__bitwriter_write_raw_uint32(bw, 1, ++val);
+    else
+        return
+            FLAC__bitwriter_write_zeroes(bw, val) &&
+            FLAC__bitwriter_write_raw_uint32(bw, 1, 1);
+}
+
+FLAC__bool FLAC__bitwriter_write_rice_signed_block(FLAC__BitWriter *bw, const FLAC__int32 *vals, unsigned nvals, unsigned parameter)
+{
+    const FLAC__uint32 mask1 = (FLAC__uint32)0xffffffff << parameter; /* we val|=mask1 to set the stop bit above it... */
+    const FLAC__uint32 mask2 = (FLAC__uint32)0xffffffff >> (31 - parameter); /* ...then mask off the bits above the stop bit with val&=mask2 */
+    FLAC__uint32 uval;
+    unsigned msbs, lsbits, total_bits;
+    const FLAC__int32 *end = vals + nvals;
+
+    FLAC_ASSERT(0 != bw);
+    FLAC_ASSERT(0 != bw->buffer);
+    FLAC_ASSERT(parameter < 31);
+
+    /* the common case is that the whole code fits in one 32-bit put, so
+     * space is reserved for one maximal short code at a time and only
+     * the rare long unary runs go through the general path */
+    lsbits = 1 + parameter;
+
+    for ( ; vals < end; vals++) {
+        /* fold signed to unsigned; actual formula is: negative(v)? -2v-1 : 2v */
+        uval = ((FLAC__uint32)*vals << 1) ^ (FLAC__uint32)(*vals >> 31);
+
+        msbs = uval >> parameter;
+        total_bits = lsbits + msbs;
+
+        if (total_bits <= 32) {
+            if (bw->capacity <= bw->words + 2 && !bitwriter_grow_(bw, 64))
+                return false;
+            /* the msbs zeroes are the leading zeroes of the 'total_bits'-wide field */
+            bitwriter_put_(bw, (uval | mask1) & mask2, total_bits);
+        }
+        else {
+            /* write the unary msbs, then the stop bit and the binary lsbs */
+            if (!FLAC__bitwriter_write_zeroes(bw, msbs))
+                return false;
+            if (!FLAC__bitwriter_write_raw_uint32(bw, (uval | mask1) & mask2, lsbits))
+                return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Writes the UTF-8-like coding the frame header uses for frame and
+ * sample numbers; 'val' must fit in 31 bits.
+ */
+FLAC__bool FLAC__bitwriter_write_utf8_uint32(FLAC__BitWriter *bw, FLAC__uint32 val)
+{
+    FLAC__bool ok = 1;
+
+    FLAC_ASSERT(0 != bw);
+    FLAC_ASSERT(0 != bw->buffer);
+    FLAC_ASSERT(!(val & 0x80000000)); /* this version only handles 31 bits */
+
+    if (val < 0x80) {
+        return FLAC__bitwriter_write_raw_uint32(bw, val, 8);
+    }
+    else if (val < 0x800) {
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, 0xC0 | (val >> 6), 8);
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, 0x80 | (val & 0x3F), 8);
+    }
+    else if (val < 0x10000) {
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, 0xE0 | (val >> 12), 8);
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, 0x80 | ((val >> 6) & 0x3F), 8);
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, 0x80 | (val & 0x3F), 8);
+    }
+    else if (val < 0x200000) {
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, 0xF0 | (val >> 18), 8);
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, 0x80 | ((val >> 12) & 0x3F), 8);
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, 0x80 | ((val >> 6) & 0x3F), 8);
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, 0x80 | (val & 0x3F), 8);
+    }
+    else if (val < 0x4000000) {
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, 0xF8 | (val >> 24), 8);
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, 0x80 | ((val >> 18) & 0x3F), 8);
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, 0x80 | ((val >> 12) & 0x3F), 8);
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, 0x80 | ((val >> 6) & 0x3F), 8);
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, 0x80 | (val & 0x3F), 8);
+    }
+    else {
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, 0xFC | (val >> 30), 8);
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, 0x80 | ((val >> 24) & 0x3F), 8);
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, 0x80 | ((val >> 18) & 0x3F), 8);
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, 0x80 | ((val >> 12) & 0x3F), 8);
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, 0x80 | ((val >> 6) & 0x3F), 8);
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, 0x80 | (val & 0x3F), 8);
+    }
+
+    return ok;
+}
+
+/* 'val' must fit in 36 bits */
+FLAC__bool FLAC__bitwriter_write_utf8_uint64(FLAC__BitWriter *bw, FLAC__uint64 val)
+{
+    FLAC__bool ok = 1;
+
+    FLAC_ASSERT(0 != bw);
+    FLAC_ASSERT(0 != bw->buffer);
+    FLAC_ASSERT(!(val & FLAC__U64L(0xFFFFFFF000000000))); /* this version only handles 36 bits */
+
+    if (val < 0x80000000) {
+        return FLAC__bitwriter_write_utf8_uint32(bw, (FLAC__uint32)val);
+    }
+    else {
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, 0xFE, 8);
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, (FLAC__uint32)(0x80 | ((val >> 30) & 0x3F)), 8);
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, (FLAC__uint32)(0x80 | ((val >> 24) & 0x3F)), 8);
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, (FLAC__uint32)(0x80 | ((val >> 18) & 0x3F)), 8);
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, (FLAC__uint32)(0x80 | ((val >> 12) & 0x3F)), 8);
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, (FLAC__uint32)(0x80 | ((val >> 6) & 0x3F)), 8);
+        ok &= FLAC__bitwriter_write_raw_uint32(bw, (FLAC__uint32)(0x80 | (val & 0x3F)), 8);
+    }
+
+    return ok;
+}
+
+FLAC__bool FLAC__bitwriter_zero_pad_to_byte_boundary(FLAC__BitWriter *bw)
+{
+    /* 0-pad to byte boundary */
+    if (bw->bits & 7u)
+        return FLAC__bitwriter_write_zeroes(bw, 8 - (bw->bits & 7u));
+    else
+        return true;
+}
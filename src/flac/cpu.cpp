@@ -0,0 +1,94 @@
+#include <string.h>
+#include "private/cpu.h"
+
+#if FLAC__HAS_X86INTRIN
+#include <cpuid.h>
+#endif
+
+// 用CPUID检测指令集，解码器和编码器据此选择SIMD函数
+
+#if FLAC__HAS_X86INTRIN
+
+/* these are flags in EDX of CPUID AX=00000001 */
+static const unsigned FLAC__CPUINFO_X86_CPUID_SSE2 = 0x04000000;
+/* these are flags in ECX of CPUID AX=00000001 */
+static const unsigned FLAC__CPUINFO_X86_CPUID_SSSE3 = 0x00000200;
+static const unsigned FLAC__CPUINFO_X86_CPUID_FMA = 0x00001000;
+static const unsigned FLAC__CPUINFO_X86_CPUID_SSE41 = 0x00080000;
+static const unsigned FLAC__CPUINFO_X86_CPUID_SSE42 = 0x00100000;
+static const unsigned FLAC__CPUINFO_X86_CPUID_OSXSAVE = 0x08000000;
+static const unsigned FLAC__CPUINFO_X86_CPUID_AVX = 0x10000000;
+/* these are flags in EBX of CPUID AX=00000007 */
+static const unsigned FLAC__CPUINFO_X86_CPUID_AVX2 = 0x00000020;
+static const unsigned FLAC__CPUINFO_X86_CPUID_BMI2 = 0x00000100;
+static const unsigned FLAC__CPUINFO_X86_CPUID_AVX512F = 0x00010000;
+/* these are flags in ECX of CPUID AX=80000001 */
+static const unsigned FLAC__CPUINFO_X86_CPUID_LZCNT = 0x00000020;
+
+/* XCR0, the register state the OS saves on a context switch */
+static FLAC__uint32 x86_xcr0_(void)
+{
+    FLAC__uint32 lo, hi;
+    __asm__ __volatile__ ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    (void)hi;
+    return lo;
+}
+
+static void x86_cpu_info_(FLAC__CPUInfo_x86 *info)
+{
+    unsigned max_leaf, vendor_ebx, vendor_ecx, vendor_edx;
+    unsigned eax, ebx, ecx, edx;
+    unsigned leaf7_ebx = 0;
+    FLAC__uint32 xcr0;
+
+    if (!__get_cpuid(0, &max_leaf, &vendor_ebx, &vendor_ecx, &vendor_edx))
+        return;
+    info->intel = vendor_ebx == 0x756E6547 && vendor_edx == 0x49656E69 && vendor_ecx == 0x6C65746E; /* "GenuineIntel" */
+
+    if (max_leaf < 1)
+        return;
+    __cpuid(1, eax, ebx, ecx, edx);
+    info->sse2 = (edx & FLAC__CPUINFO_X86_CPUID_SSE2) != 0;
+    info->ssse3 = (ecx & FLAC__CPUINFO_X86_CPUID_SSSE3) != 0;
+    info->sse41 = (ecx & FLAC__CPUINFO_X86_CPUID_SSE41) != 0;
+    info->sse42 = (ecx & FLAC__CPUINFO_X86_CPUID_SSE42) != 0;
+
+    /* bits 1 and 2: XMM and YMM; bits 5 to 7: the opmask registers and both halves of ZMM */
+    if ((ecx & FLAC__CPUINFO_X86_CPUID_OSXSAVE) && (ecx & FLAC__CPUINFO_X86_CPUID_AVX) && ((xcr0 = x86_xcr0_()) & 0x6) == 0x6) {
+        info->avx = true;
+        info->fma = (ecx & FLAC__CPUINFO_X86_CPUID_FMA) != 0;
+        if (max_leaf >= 7) {
+            __cpuid_count(7, 0, eax, leaf7_ebx, ecx, edx);
+            info->avx2 = (leaf7_ebx & FLAC__CPUINFO_X86_CPUID_AVX2) != 0;
+            info->avx512f = (leaf7_ebx & FLAC__CPUINFO_X86_CPUID_AVX512F) != 0 && (xcr0 & 0xe0) == 0xe0;
+        }
+    }
+    else if (max_leaf >= 7)
+        __cpuid_count(7, 0, eax, leaf7_ebx, ecx, edx);
+
+    info->bmi2 = (leaf7_ebx & FLAC__CPUINFO_X86_CPUID_BMI2) != 0;
+    if (__get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx))
+        info->lzcnt = (ecx & FLAC__CPUINFO_X86_CPUID_LZCNT) != 0;
+}
+
+#endif
+
+void FLAC__cpu_info(FLAC__CPUInfo *info)
+{
+    memset(info, 0, sizeof(*info));
+
+#if defined FLAC__CPU_X86_64
+    info->type = FLAC__CPUINFO_TYPE_X86_64;
+#elif defined FLAC__CPU_IA32
+    info->type = FLAC__CPUINFO_TYPE_IA32;
+#else
+    info->type = FLAC__CPUINFO_TYPE_UNKNOWN;
+#endif
+
+#if FLAC__HAS_X86INTRIN
+    x86_cpu_info_(&info->x86);
+    info->use_asm = true;
+#else
+    info->use_asm = false;
+#endif
+}
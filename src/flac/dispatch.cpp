@@ -0,0 +1,156 @@
+#include <stdlib.h>
+#include <string.h>
+#include "private/crc.h"
+#include "private/dispatch.h"
+
+/***********************************************************************
+ *
+ * Private class method prototypes
+ *
+ ***********************************************************************/
+
+static FLAC__DispatchLevel level_of_(const FLAC__CPUInfo *info);
+static void cap_level_(FLAC__CPUInfo *info, FLAC__DispatchLevel level);
+static void fill_(FLAC__Dispatch *dispatch);
+
+/***********************************************************************
+ *
+ * Public static class data
+ *
+ ***********************************************************************/
+
+const char * const FLAC__DispatchLevelString[] = {
+    "generic",
+    "sse2",
+    "ssse3",
+    "sse4.1",
+    "avx2",
+    "avx512"
+};
+
+/***********************************************************************
+ *
+ * Public class methods
+ *
+ ***********************************************************************/
+
+const FLAC__Dispatch *FLAC__dispatch(void)
+{
+    /* a function-local static is initialized exactly once, even with several threads getting here first */
+    static const FLAC__Dispatch dispatch = [] {
+        FLAC__Dispatch d;
+        fill_(&d);
+        return d;
+    }();
+    return &dispatch;
+}
+
+/***********************************************************************
+ *
+ * Private class methods
+ *
+ ***********************************************************************/
+
+FLAC__DispatchLevel level_of_(const FLAC__CPUInfo *info)
+{
+    if (!info->use_asm || !info->x86.sse2)
+        return FLAC__DISPATCH_GENERIC;
+    if (info->x86.avx512f)
+        return FLAC__DISPATCH_AVX512;
+    if (info->x86.avx2)
+        return FLAC__DISPATCH_AVX2;
+    if (info->x86.sse41)
+        return FLAC__DISPATCH_SSE4_1;
+    if (info->x86.ssse3)
+        return FLAC__DISPATCH_SSSE3;
+    return FLAC__DISPATCH_SSE2;
+}
+
+/* clears every feature above 'level' */
+void cap_level_(FLAC__CPUInfo *info, FLAC__DispatchLevel level)
+{
+    if (level < FLAC__DISPATCH_AVX512)
+        info->x86.avx512f = false;
+    if (level < FLAC__DISPATCH_AVX2) {
+        info->x86.avx = false;
+        info->x86.avx2 = false;
+        info->x86.fma = false;
+        info->x86.bmi2 = false;
+        info->x86.lzcnt = false;
+    }
+    if (level < FLAC__DISPATCH_SSE4_1) {
+        info->x86.sse41 = false;
+        info->x86.sse42 = false;
+    }
+    if (level < FLAC__DISPATCH_SSSE3)
+        info->x86.ssse3 = false;
+    if (level < FLAC__DISPATCH_SSE2) {
+        info->x86.sse2 = false;
+        info->use_asm = false;
+    }
+}
+
+void fill_(FLAC__Dispatch *dispatch)
+{
+    const char *env = getenv("FLAC_CPU_LEVEL");
+    unsigned i;
+
+    FLAC__cpu_info(&dispatch->cpuinfo);
+    if (env != 0) {
+        for (i = 0; i <= FLAC__DISPATCH_AVX512; i++) {
+            if (strcmp(env, FLAC__DispatchLevelString[i]) == 0) {
+                cap_level_(&dispatch->cpuinfo, (FLAC__DispatchLevel)i);
+                break;
+            }
+        }
+    }
+    dispatch->level = level_of_(&dispatch->cpuinfo);
+
+    /* first default to the non-asm routines */
+    dispatch->bitreader_read_rice_signed_block = FLAC__bitreader_read_rice_signed_block;
+    dispatch->lpc_restore_signal = FLAC__lpc_restore_signal;
+    dispatch->lpc_restore_signal_wide = FLAC__lpc_restore_signal_wide;
+    dispatch->lpc_compute_autocorrelation = FLAC__lpc_compute_autocorrelation;
+    dispatch->lpc_compute_residual = FLAC__lpc_compute_residual_from_qlp_coefficients_table;
+    dispatch->frame_header_find_sync = FLAC__frame_header_find_sync;
+    dispatch->crc8 = FLAC__crc8;
+    dispatch->crc16_update_block = FLAC__crc16_update_block;
+    dispatch->crc32_update_block = FLAC__crc32_update_block;
+    dispatch->stereo_decorrelate = FLAC__stereo_decorrelate;
+    dispatch->stereo_restore = FLAC__stereo_restore_table;
+    dispatch->pcm_interleave = FLAC__pcm_interleave_table;
+
+    /* now override with asm where appropriate */
+    if (!dispatch->cpuinfo.use_asm)
+        return;
+#ifdef FLAC__SSE2_SUPPORTED
+    if (dispatch->cpuinfo.x86.sse2)
+        dispatch->frame_header_find_sync = FLAC__frame_header_find_sync_intrin_sse2;
+#endif
+#ifdef FLAC__SSE4_1_SUPPORTED
+    if (dispatch->cpuinfo.x86.sse41) {
+        dispatch->lpc_restore_signal = FLAC__lpc_restore_signal_intrin_sse41;
+        dispatch->lpc_restore_signal_wide = FLAC__lpc_restore_signal_wide_intrin_sse41;
+        dispatch->stereo_decorrelate = FLAC__stereo_decorrelate_intrin_sse41;
+        dispatch->stereo_restore = FLAC__stereo_restore_intrin_sse41_table;
+        dispatch->pcm_interleave = FLAC__pcm_interleave_intrin_sse41_table;
+    }
+#endif
+#ifdef FLAC__AVX2_SUPPORTED
+    if (dispatch->cpuinfo.x86.avx2) {
+        dispatch->lpc_restore_signal = FLAC__lpc_restore_signal_intrin_avx2;
+        dispatch->lpc_restore_signal_wide = FLAC__lpc_restore_signal_wide_intrin_avx2;
+        dispatch->frame_header_find_sync = FLAC__frame_header_find_sync_intrin_avx2;
+        dispatch->stereo_decorrelate = FLAC__stereo_decorrelate_intrin_avx2;
+        dispatch->stereo_restore = FLAC__stereo_restore_intrin_avx2_table;
+    }
+#endif
+#ifdef FLAC__BMI2_SUPPORTED
+    if (dispatch->cpuinfo.x86.bmi2 && dispatch->cpuinfo.x86.lzcnt)
+        dispatch->bitreader_read_rice_signed_block = FLAC__bitreader_read_rice_signed_block_bmi2;
+#endif
+#ifdef FLAC__AVX512_SUPPORTED
+    if (dispatch->cpuinfo.x86.avx512f)
+        dispatch->stereo_restore = FLAC__stereo_restore_intrin_avx512_table;
+#endif
+}
@@ -0,0 +1,211 @@
+#include <math.h>
+#include "private/fixed.h"
+#include "FLAC/assert.h"
+#include "private/macros.h"
+
+/*
+ * The prediction of each order, as a template so that every kernel below
+ * is compiled with its order (and its intermediate type) fixed and the
+ * inner loops have no branches besides the loop condition.
+ *
+ * 'history' points at the sample being predicted; T is the type the
+ * prediction is computed in.
+ */
+template <unsigned Order> struct FixedPrediction;
+
+template <> struct FixedPrediction<0> {
+    template <typename T, typename S> static inline T predict(const S *) { return 0; }
+};
+
+template <> struct FixedPrediction<1> {
+    template <typename T, typename S> static inline T predict(const S *history)
+    {
+        return (T)history[-1];
+    }
+};
+
+template <> struct FixedPrediction<2> {
+    template <typename T, typename S> static inline T predict(const S *history)
+    {
+        return 2 * (T)history[-1] - (T)history[-2];
+    }
+};
+
+template <> struct FixedPrediction<3> {
+    template <typename T, typename S> static inline T predict(const S *history)
+    {
+        return 3 * (T)history[-1] - 3 * (T)history[-2] + (T)history[-3];
+    }
+};
+
+template <> struct FixedPrediction<4> {
+    template <typename T, typename S> static inline T predict(const S *history)
+    {
+        return 4 * (T)history[-1] - 6 * (T)history[-2] + 4 * (T)history[-3] - (T)history[-4];
+    }
+};
+
+/*
+ * S is the sample type, T the type the prediction is computed in. The
+ * restore kernels whose sums can run out of T compute in unsigned types:
+ * a damaged frame can carry any residual, and the sums then wrap around
+ * instead of overflowing; the frame is thrown away at its CRC check.
+ */
+template <unsigned Order, typename T, typename S>
+static void restore_signal_(const FLAC__int32 residual[], unsigned data_len, S data[])
+{
+    int i, idata_len = (int)data_len;
+
+    for (i = 0; i < idata_len; i++)
+        data[i] = (S)((T)residual[i] + FixedPrediction<Order>::template predict<T>(data + i));
+}
+
+template <unsigned Order, typename T, typename S>
+static void compute_residual_(const S data[], unsigned data_len, FLAC__int32 residual[])
+{
+    int i, idata_len = (int)data_len;
+
+    for (i = 0; i < idata_len; i++)
+        residual[i] = (FLAC__int32)((T)data[i] - FixedPrediction<Order>::template predict<T>(data + i));
+}
+
+const FLAC__FixedRestoreSignalFunction FLAC__fixed_restore_signal_table[FLAC__MAX_FIXED_ORDER + 1] = {
+    restore_signal_<0, FLAC__uint32, FLAC__int32>,
+    restore_signal_<1, FLAC__uint32, FLAC__int32>,
+    restore_signal_<2, FLAC__uint32, FLAC__int32>,
+    restore_signal_<3, FLAC__uint32, FLAC__int32>,
+    restore_signal_<4, FLAC__uint32, FLAC__int32>
+};
+
+const FLAC__FixedRestoreSignalFunction FLAC__fixed_restore_signal_wide_table[FLAC__MAX_FIXED_ORDER + 1] = {
+    restore_signal_<0, FLAC__int64, FLAC__int32>,
+    restore_signal_<1, FLAC__int64, FLAC__int32>,
+    restore_signal_<2, FLAC__int64, FLAC__int32>,
+    restore_signal_<3, FLAC__int64, FLAC__int32>,
+    restore_signal_<4, FLAC__int64, FLAC__int32>
+};
+
+const FLAC__FixedRestoreSignal33bitFunction FLAC__fixed_restore_signal_wide_33bit_table[FLAC__MAX_FIXED_ORDER + 1] = {
+    restore_signal_<0, FLAC__uint64, FLAC__int64>,
+    restore_signal_<1, FLAC__uint64, FLAC__int64>,
+    restore_signal_<2, FLAC__uint64, FLAC__int64>,
+    restore_signal_<3, FLAC__uint64, FLAC__int64>,
+    restore_signal_<4, FLAC__uint64, FLAC__int64>
+};
+
+const FLAC__FixedComputeResidualFunction FLAC__fixed_compute_residual_table[FLAC__MAX_FIXED_ORDER + 1] = {
+    compute_residual_<0, FLAC__int32, FLAC__int32>,
+    compute_residual_<1, FLAC__int32, FLAC__int32>,
+    compute_residual_<2, FLAC__int32, FLAC__int32>,
+    compute_residual_<3, FLAC__int32, FLAC__int32>,
+    compute_residual_<4, FLAC__int32, FLAC__int32>
+};
+
+const FLAC__FixedComputeResidualFunction FLAC__fixed_compute_residual_wide_table[FLAC__MAX_FIXED_ORDER + 1] = {
+    compute_residual_<0, FLAC__int64, FLAC__int32>,
+    compute_residual_<1, FLAC__int64, FLAC__int32>,
+    compute_residual_<2, FLAC__int64, FLAC__int32>,
+    compute_residual_<3, FLAC__int64, FLAC__int32>,
+    compute_residual_<4, FLAC__int64, FLAC__int32>
+};
+
+const FLAC__FixedComputeResidual33bitFunction FLAC__fixed_compute_residual_wide_33bit_table[FLAC__MAX_FIXED_ORDER + 1] = {
+    compute_residual_<0, FLAC__int64, FLAC__int64>,
+    compute_residual_<1, FLAC__int64, FLAC__int64>,
+    compute_residual_<2, FLAC__int64, FLAC__int64>,
+    compute_residual_<3, FLAC__int64, FLAC__int64>,
+    compute_residual_<4, FLAC__int64, FLAC__int64>
+};
+
+#ifndef M_LN2
+/* math.h in VC++ doesn't seem to have this (how Microsoft is that?) */
+#define M_LN2 0.69314718055994530942
+#endif
+
+static inline FLAC__uint64 local_abs_(FLAC__int64 x)
+{
+    return (FLAC__uint64)(x < 0 ? -x : x);
+}
+
+unsigned FLAC__fixed_compute_best_predictor(const FLAC__int32 data[], unsigned data_len, float residual_bits_per_sample[FLAC__MAX_FIXED_ORDER + 1])
+{
+    FLAC__int64 last_error_0 = data[-1];
+    FLAC__int64 last_error_1 = (FLAC__int64)data[-1] - data[-2];
+    FLAC__int64 last_error_2 = last_error_1 - ((FLAC__int64)data[-2] - data[-3]);
+    FLAC__int64 last_error_3 = last_error_2 - ((FLAC__int64)data[-2] - 2 * (FLAC__int64)data[-3] + data[-4]);
+    FLAC__int64 error, save;
+    FLAC__uint64 total_error_0 = 0, total_error_1 = 0, total_error_2 = 0, total_error_3 = 0, total_error_4 = 0;
+    FLAC__uint64 total_error[FLAC__MAX_FIXED_ORDER + 1];
+    unsigned i, order;
+
+    /* each order's error is the difference of the previous order's errors */
+    for (i = 0; i < data_len; i++) {
+        error  = data[i]     ; total_error_0 += local_abs_(error);                      save = error;
+        error -= last_error_0; total_error_1 += local_abs_(error); last_error_0 = save; save = error;
+        error -= last_error_1; total_error_2 += local_abs_(error); last_error_1 = save; save = error;
+        error -= last_error_2; total_error_3 += local_abs_(error); last_error_2 = save; save = error;
+        error -= last_error_3; total_error_4 += local_abs_(error); last_error_3 = save;
+    }
+
+    /* prefer the lower order on ties, it needs fewer warmup samples */
+    if (total_error_0 <= flac_min(flac_min(flac_min(total_error_1, total_error_2), total_error_3), total_error_4))
+        order = 0;
+    else if (total_error_1 <= flac_min(flac_min(total_error_2, total_error_3), total_error_4))
+        order = 1;
+    else if (total_error_2 <= flac_min(total_error_3, total_error_4))
+        order = 2;
+    else if (total_error_3 <= total_error_4)
+        order = 3;
+    else
+        order = 4;
+
+    /* Estimate the expected number of bits per residual signal sample.
+     * 'total_error*' is linearly related to the variance of the residual
+     * signal, so we use it directly to compute E(|x|)
+     */
+    total_error[0] = total_error_0;
+    total_error[1] = total_error_1;
+    total_error[2] = total_error_2;
+    total_error[3] = total_error_3;
+    total_error[4] = total_error_4;
+    for (i = 0; i <= FLAC__MAX_FIXED_ORDER; i++)
+        residual_bits_per_sample[i] = (float)((total_error[i] > 0) ? log(M_LN2 * (double)total_error[i] / (double)data_len) / M_LN2 : 0.0);
+
+    return order;
+}
+
+void FLAC__fixed_compute_residual(const FLAC__int32 data[], unsigned data_len, unsigned order, FLAC__int32 residual[])
+{
+    FLAC_ASSERT(order <= FLAC__MAX_FIXED_ORDER);
+    FLAC__fixed_compute_residual_table[order](data, data_len, residual);
+}
+
+void FLAC__fixed_compute_residual_wide(const FLAC__int32 data[], unsigned data_len, unsigned order, FLAC__int32 residual[])
+{
+    FLAC_ASSERT(order <= FLAC__MAX_FIXED_ORDER);
+    FLAC__fixed_compute_residual_wide_table[order](data, data_len, residual);
+}
+
+void FLAC__fixed_compute_residual_wide_33bit(const FLAC__int64 data[], unsigned data_len, unsigned order, FLAC__int32 residual[])
+{
+    FLAC_ASSERT(order <= FLAC__MAX_FIXED_ORDER);
+    FLAC__fixed_compute_residual_wide_33bit_table[order](data, data_len, residual);
+}
+
+void FLAC__fixed_restore_signal(const FLAC__int32 residual[], unsigned data_len, unsigned order, FLAC__int32 data[])
+{
+    FLAC_ASSERT(order <= FLAC__MAX_FIXED_ORDER);
+    FLAC__fixed_restore_signal_table[order](residual, data_len, data);
+}
+
+void FLAC__fixed_restore_signal_wide(const FLAC__int32 residual[], unsigned data_len, unsigned order, FLAC__int32 data[])
+{
+    FLAC_ASSERT(order <= FLAC__MAX_FIXED_ORDER);
+    FLAC__fixed_restore_signal_wide_table[order](residual, data_len, data);
+}
+
+void FLAC__fixed_restore_signal_wide_33bit(const FLAC__int32 residual[], unsigned data_len, unsigned order, FLAC__int64 data[])
+{
+    FLAC_ASSERT(order <= FLAC__MAX_FIXED_ORDER);
+    FLAC__fixed_restore_signal_wide_33bit_table[order](residual, data_len, data);
+}
@@ -0,0 +1,294 @@
+#include <stdlib.h>
+#include <string.h>
+#include "FLAC/assert.h"
+#include "FLAC/format.h"
+#include "private/format.h"
+#include "private/macros.h"
+
+// format.h中声明的常量都在这里定义
+
+#ifndef VERSION
+#define VERSION "1.3.2"
+#endif
+
+FLAC_API const char *FLAC__VERSION_STRING = VERSION;
+
+FLAC_API const char *FLAC__VENDOR_STRING = "reference libFLAC " VERSION " 20170101";
+
+FLAC_API const FLAC__byte FLACT__STREAM_SYNC_STRING[4] = { 'f', 'L', 'a', 'C' };
+FLAC_API const unsigned FLAC__STREAM_SYNC = 0x664C6143;
+FLAC_API const unsigned FLAC__STREAM_SYNC_LEN = 32; /* bits */
+
+FLAC_API const unsigned FLAC__STREAM_METADATA_STREAMINFO_MIN_BLOCK_SIZE_LEN = 16; /* bits */
+FLAC_API const unsigned FLAC__STREAM_METADATA_STREAMINFO_MAX_BLOCK_SIZE_LEN = 16; /* bits */
+FLAC_API const unsigned FLAC__STREAM_METADATA_STREAMINFO_MIN_FRAME_SIZE_LEN = 24; /* bits */
+FLAC_API const unsigned FLAC__STREAM_METADATA_STREAMINFO_MAX_FRAME_SIZE_LEN = 24; /* bits */
+FLAC_API const unsigned FLAC__STREAM_METADATA_STREAMINFO_SAMPLE_RATE_LEN = 20; /* bits */
+FLAC_API const unsigned FLAC__STREAM_METADATA_STREAMINFO_CHANNELS_LEN = 3; /* bits */
+FLAC_API const unsigned FLAC__STREAM_METADATA_STREAMINFO_BITS_PER_SAMPLE_LEN = 5; /* bits */
+FLAC_API const unsigned FLAC__STREAM_METADATA_STREAMINFO_TOTAL_SAMPLES_LEN = 36; /* bits */
+FLAC_API const unsigned FLAC__STREAM_METADATA_STREAMINFO_MD5SUM_LEN = 128; /* bits */
+
+FLAC_API const unsigned FLAC__STREAM_METADATA_SEEKPOINT_SAMPLE_NUMBER_LEN = 64; /* bits */
+FLAC_API const unsigned FLAC__STREAM_METADATA_SEEKPOINT_STREAM_OFFSET_LEN = 64; /* bits */
+FLAC_API const unsigned FLAC__STREAM_METADATA_SEEKPOINT_FRAME_SAMPLES_LEN = 16; /* bits */
+
+FLAC_API const FLAC__uint64 FLAC__STREAM_METADATA_SEEKPOINT_PLACEHOLDER = 0xffffffffffffffffull;
+
+FLAC_API const unsigned FLAC__STREAM_METADATA_IS_LAST_LEN = 1; /* bits */
+FLAC_API const unsigned FLAC__STREAM_METADATA_TYPE_LEN = 7; /* bits */
+FLAC_API const unsigned FLAC__STREAM_METADATA_LENGTH_LEN = 24; /* bits */
+
+FLAC_API const unsigned FLAC__FRAME_HEADER_SYNC = 0x3ffe;
+FLAC_API const unsigned FLAC__FRAME_HEADER_SYNC_LEN = 14; /* bits */
+FLAC_API const unsigned FLAC__FRAME_HEADER_RESERVED_LEN = 1; /* bits */
+FLAC_API const unsigned FLAC__FRAME_HEADER_BLOCKING_STRATEGY_LEN = 1; /* bits */
+FLAC_API const unsigned FLAC__FRAME_HEADER_BLOCK_SIZE_LEN = 4; /* bits */
+FLAC_API const unsigned FLAC__FRAME_HEADER_SAMPLE_RATE_LEN = 4; /* bits */
+FLAC_API const unsigned FLAC__FRAME_HEADER_CHANNEL_ASSIGNMENT_LEN = 4; /* bits */
+FLAC_API const unsigned FLAC__FRAME_HEADER_BITS_PER_SAMPLE_LEN = 3; /* bits */
+FLAC_API const unsigned FLAC__FRAME_HEADER_ZERO_PAD_LEN = 1; /* bits */
+FLAC_API const unsigned FLAC__FRAME_HEADER_CRC_LEN = 8; /* bits */
+
+FLAC_API const unsigned FLAC__FRAME_FOOTER_CRC_LEN = 16; /* bits */
+
+FLAC_API const unsigned FLAC__ENTROPY_CODING_METHOD_TYPE_LEN = 2; /* bits */
+FLAC_API const unsigned FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_ORDER_LEN = 4; /* bits */
+FLAC_API const unsigned FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_PARAMETER_LEN = 4; /* bits */
+FLAC_API const unsigned FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2_PARAMETER_LEN = 5; /* bits */
+FLAC_API const unsigned FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_RAW_LEN = 5; /* bits */
+
+FLAC_API const unsigned FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_ESCAPE_PARAMETER = 15; /* == (1<<FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_PARAMETER_LEN)-1 */
+FLAC_API const unsigned FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2_ESCAPE_PARAMETER = 31; /* == (1<<FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2_PARAMETER_LEN)-1 */
+
+FLAC_API const char * const FLAC__EntropyCodingMethodTypeString[] = {
+    "PARTITIONED_RICE",
+    "PARTITIONED_RICE2"
+};
+
+FLAC_API const unsigned FLAC__SUBFRAME_LPC_QLP_COEFF_PRECISION_LEN = 4; /* bits */
+FLAC_API const unsigned FLAC__SUBFRAME_LPC_QLP_SHIFT_LEN = 5; /* bits */
+
+FLAC_API const unsigned FLAC__SUBFRAME_ZERO_PAD_LEN = 1; /* bits */
+FLAC_API const unsigned FLAC__SUBFRAME_TYPE_LEN = 6; /* bits */
+FLAC_API const unsigned FLAC__SUBFRAME_WASTED_BITS_FLAG_LEN = 1; /* bits */
+
+FLAC_API const unsigned FLAC__SUBFRAME_TYPE_CONSTANT_BYTE_ALIGNED_MASK = 0x00;
+FLAC_API const unsigned FLAC__SUBFRAME_TYPE_VERBATIM_BYTE_ALIGNED_MASK = 0x02;
+FLAC_API const unsigned FLAC__SUBFRAME_TYPE_FIXED_BYTE_ALIGNED_MASK = 0x10;
+FLAC_API const unsigned FLAC__SUBFRAME_TYPE_LPC_BYTE_ALIGNED_MASK = 0x40;
+
+FLAC_API const char * const FLAC__SubframeTypeString[] = {
+    "CONSTANT",
+    "VERBATIM",
+    "FIXED",
+    "LPC"
+};
+
+FLAC_API const char * const FLAC__ChannelAssignmentString[] = {
+    "INDEPENDENT",
+    "LEFT_SIDE",
+    "RIGHT_SIDE",
+    "MID_SIDE"
+};
+
+FLAC_API const char * const FLAC__FrameNumberTypeString[] = {
+    "FRAME_NUMBER_TYPE_FRAME_NUMBER",
+    "FRAME_NUMBER_TYPE_SAMPLE_NUMBER"
+};
+
+FLAC_API const char * const FLAC__MetadataTypeString[] = {
+    "STREAMINFO",
+    "PADDING",
+    "APPLICATION",
+    "SEEKTABLE",
+    "VORBIS_COMMENT",
+    "CUESHEET",
+    "PICTURE"
+};
+
+// Ogg容器由stream_decoder/stream_encoder的*_ogg初始化函数支持，不依赖libogg
+FLAC_API int FLAC_API_SUPPORTS_OGG_FLAC = 1;
+
+FLAC_API FLAC__bool FLAC__format_sample_rate_is_valid(unsigned sample_rate)
+{
+    if (sample_rate == 0 || sample_rate > FLAC__MAX_SAMPLE_RATE) {
+        return false;
+    }
+    else
+        return true;
+}
+
+FLAC_API FLAC__bool FLAC__format_blocksize_is_subset(unsigned blocksize, unsigned sample_rate)
+{
+    if (blocksize > 16384)
+        return false;
+    else if (sample_rate <= 48000 && blocksize > FLAC__SUBSET_MAX_BLOCK_SIZE_48000Hz)
+        return false;
+    else
+        return true;
+}
+
+FLAC_API FLAC__bool FLAC__format_sample_rate_is_subset(unsigned sample_rate)
+{
+    if (
+        !FLAC__format_sample_rate_is_valid(sample_rate) ||
+        (
+            sample_rate >= (1u << 16) &&
+            !(sample_rate % 1000 == 0 && sample_rate / 1000 < (1u << 8)) &&
+            !(sample_rate % 10 == 0 && sample_rate / 10 < (1u << 16))
+        )
+    ) {
+        return false;
+    }
+    else
+        return true;
+}
+
+/*
+ * These routines are private to libFLAC
+ */
+unsigned FLAC__format_get_max_rice_partition_order_from_blocksize(unsigned blocksize)
+{
+    unsigned max_rice_partition_order = 0;
+
+    while (!(blocksize & 1)) {
+        max_rice_partition_order++;
+        blocksize >>= 1;
+    }
+    return flac_min(FLAC__MAX_RICE_PARTITION_ORDER, max_rice_partition_order);
+}
+
+unsigned FLAC__format_get_max_rice_partition_order_from_blocksize_limited_max_and_predictor_order(unsigned limit, unsigned blocksize, unsigned predictor_order)
+{
+    unsigned max_rice_partition_order = flac_min(limit, FLAC__format_get_max_rice_partition_order_from_blocksize(blocksize));
+
+    while (max_rice_partition_order > 0 && (blocksize >> max_rice_partition_order) <= predictor_order)
+        max_rice_partition_order--;
+
+    FLAC_ASSERT(
+        (max_rice_partition_order == 0 && blocksize >= predictor_order) ||
+        (max_rice_partition_order > 0 && blocksize >> max_rice_partition_order > predictor_order)
+    );
+
+    return max_rice_partition_order;
+}
+
+void FLAC__format_entropy_coding_method_partitioned_rice_contents_init(FLAC__EntropyCodingMethod_PartitionedRiceContents *object)
+{
+    FLAC_ASSERT(0 != object);
+
+    object->parameters = 0;
+    object->raw_bits = 0;
+    object->capacity_by_order = 0;
+}
+
+void FLAC__format_entropy_coding_method_partitioned_rice_contents_clear(FLAC__EntropyCodingMethod_PartitionedRiceContents *object)
+{
+    FLAC_ASSERT(0 != object);
+
+    free(object->parameters);
+    free(object->raw_bits);
+    FLAC__format_entropy_coding_method_partitioned_rice_contents_init(object);
+}
+
+FLAC__bool FLAC__format_entropy_coding_method_partitioned_rice_contents_ensure_size(FLAC__EntropyCodingMethod_PartitionedRiceContents *object, unsigned max_partition_order)
+{
+    unsigned *parameters, *raw_bits;
+
+    FLAC_ASSERT(0 != object);
+
+    if (object->parameters != 0 && object->capacity_by_order >= max_partition_order)
+        return true;
+
+    parameters = (unsigned*)realloc(object->parameters, sizeof(unsigned) * (1u << max_partition_order));
+    if (parameters == 0)
+        return false;
+    object->parameters = parameters;
+    raw_bits = (unsigned*)realloc(object->raw_bits, sizeof(unsigned) * (1u << max_partition_order));
+    if (raw_bits == 0)
+        return false;
+    object->raw_bits = raw_bits;
+    memset(object->raw_bits, 0, sizeof(unsigned) * (1u << max_partition_order));
+    object->capacity_by_order = max_partition_order;
+
+    return true;
+}
+
+void FLAC__format_unpack_streaminfo(const FLAC__byte data[], FLAC__StreamMetadata_StreamInfo *info)
+{
+    const FLAC__byte *b = data;
+
+    FLAC_ASSERT(0 != data);
+    FLAC_ASSERT(0 != info);
+
+    info->min_blocksize = ((unsigned)b[0] << 8) | b[1];
+    info->max_blocksize = ((unsigned)b[2] << 8) | b[3];
+    info->min_framesize = ((unsigned)b[4] << 16) | ((unsigned)b[5] << 8) | b[6];
+    info->max_framesize = ((unsigned)b[7] << 16) | ((unsigned)b[8] << 8) | b[9];
+    info->sample_rate = ((unsigned)b[10] << 12) | ((unsigned)b[11] << 4) | (b[12] >> 4);
+    info->channels = ((b[12] >> 1) & 7) + 1;
+    info->bits_per_sample = (((unsigned)(b[12] & 1) << 4) | (b[13] >> 4)) + 1;
+    info->total_samples =
+        ((FLAC__uint64)(b[13] & 0x0f) << 32) |
+        ((FLAC__uint64)b[14] << 24) | ((FLAC__uint64)b[15] << 16) | ((FLAC__uint64)b[16] << 8) | (FLAC__uint64)b[17];
+    memcpy(info->md5sum, b + 18, 16);
+}
+
+/* what FLAC__format_metadata_walk() looks for next */
+#define FLAC__METADATA_WALK_STEP_ID3V2 (0u)
+#define FLAC__METADATA_WALK_STEP_MARKER (1u)
+#define FLAC__METADATA_WALK_STEP_BLOCK (2u)
+
+void FLAC__format_metadata_walk_init(FLAC__MetadataWalk *walk)
+{
+    FLAC_ASSERT(0 != walk);
+
+    memset(walk, 0, sizeof(*walk));
+    walk->step = FLAC__METADATA_WALK_STEP_ID3V2;
+}
+
+FLAC__MetadataWalkStatus FLAC__format_metadata_walk(FLAC__MetadataWalk *walk, const FLAC__byte *data, size_t bytes, FLAC__bool eof)
+{
+    FLAC_ASSERT(0 != walk);
+    FLAC_ASSERT(0 != data || bytes == 0);
+
+    switch (walk->step) {
+        case FLAC__METADATA_WALK_STEP_ID3V2:
+            /* only what could still turn out to be a tag waits for more */
+            if (bytes < FLAC__ID3V2_HEADER_LENGTH && !eof && (bytes == 0 || memcmp(data, "ID3", flac_min(bytes, (size_t)3)) == 0)) {
+                walk->need = FLAC__ID3V2_HEADER_LENGTH;
+                return FLAC__METADATA_WALK_NEED_MORE;
+            }
+            walk->step = FLAC__METADATA_WALK_STEP_MARKER;
+            if (bytes >= FLAC__ID3V2_HEADER_LENGTH && memcmp(data, "ID3", 3) == 0) {
+                walk->skip = FLAC__ID3V2_HEADER_LENGTH + (((size_t)(data[6] & 0x7f) << 21) | ((size_t)(data[7] & 0x7f) << 14) | ((size_t)(data[8] & 0x7f) << 7) | (size_t)(data[9] & 0x7f));
+                return FLAC__METADATA_WALK_ID3V2;
+            }
+            /* fall through */
+
+        case FLAC__METADATA_WALK_STEP_MARKER:
+            if (bytes < FLAC__STREAM_SYNC_LENGTH && !eof && (bytes == 0 || memcmp(data, FLACT__STREAM_SYNC_STRING, bytes) == 0)) {
+                walk->need = FLAC__STREAM_SYNC_LENGTH;
+                return FLAC__METADATA_WALK_NEED_MORE;
+            }
+            if (bytes < FLAC__STREAM_SYNC_LENGTH || memcmp(data, FLACT__STREAM_SYNC_STRING, FLAC__STREAM_SYNC_LENGTH) != 0)
+                return FLAC__METADATA_WALK_NO_MARKER;
+            walk->step = FLAC__METADATA_WALK_STEP_BLOCK;
+            walk->skip = FLAC__STREAM_SYNC_LENGTH;
+            return FLAC__METADATA_WALK_MARKER;
+
+        default:
+            if (bytes < FLAC__STREAM_METADATA_HEADER_LENGTH) {
+                if (eof)
+                    return FLAC__METADATA_WALK_TRUNCATED;
+                walk->need = FLAC__STREAM_METADATA_HEADER_LENGTH;
+                return FLAC__METADATA_WALK_NEED_MORE;
+            }
+            walk->is_last = (data[0] & 0x80) ? true : false;
+            walk->type = data[0] & 0x7f;
+            walk->length = ((unsigned)data[1] << 16) | ((unsigned)data[2] << 8) | (unsigned)data[3];
+            walk->skip = FLAC__STREAM_METADATA_HEADER_LENGTH + (size_t)walk->length;
+            return FLAC__METADATA_WALK_BLOCK;
+    }
+}
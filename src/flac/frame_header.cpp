@@ -0,0 +1,343 @@
+#include <string.h>
+#include "FLAC/assert.h"
+#include "private/crc.h"
+#include "private/dispatch.h"
+#include "private/frame_header.h"
+#include "private/macros.h"
+
+/*
+ * Reads the UTF-8-like coded frame/sample number; returns the number of
+ * bytes used, 0 if the code is invalid, or -1 if it runs past 'bytes'.
+ * Fixed-blocksize frame numbers are limited to 31 bits (6 bytes).
+ */
+static int read_utf8_(const FLAC__byte *data, size_t bytes, unsigned max_length, FLAC__uint64 *val)
+{
+    FLAC__uint64 v;
+    unsigned x, i, length;
+
+    if (bytes == 0)
+        return -1;
+    x = data[0];
+    if (!(x & 0x80)) { /* 0xxxxxxx */
+        v = x;
+        length = 1;
+    }
+    else if (x & 0xC0 && !(x & 0x20)) { /* 110xxxxx */
+        v = x & 0x1F;
+        length = 2;
+    }
+    else if (x & 0xE0 && !(x & 0x10)) { /* 1110xxxx */
+        v = x & 0x0F;
+        length = 3;
+    }
+    else if (x & 0xF0 && !(x & 0x08)) { /* 11110xxx */
+        v = x & 0x07;
+        length = 4;
+    }
+    else if (x & 0xF8 && !(x & 0x04)) { /* 111110xx */
+        v = x & 0x03;
+        length = 5;
+    }
+    else if (x & 0xFC && !(x & 0x02)) { /* 1111110x */
+        v = x & 0x01;
+        length = 6;
+    }
+    else if (x & 0xFE && !(x & 0x01)) { /* 11111110 */
+        v = 0;
+        length = 7;
+    }
+    else
+        return 0;
+
+    if (length > max_length)
+        return 0;
+    if (length > bytes)
+        return -1;
+    for (i = 1; i < length; i++) {
+        x = data[i];
+        if (!(x & 0x80) || (x & 0x40)) /* 10xxxxxx */
+            return 0;
+        v <<= 6;
+        v |= (x & 0x3F);
+    }
+    *val = v;
+    return (int)length;
+}
+
+size_t FLAC__frame_header_max_frame_bytes(const FLAC__FrameHeader *header, const FLAC__StreamMetadata_StreamInfo *stream_info)
+{
+    size_t max_bytes =
+        FLAC__FRAME_HEADER_MAX_LENGTH +
+        header->channels * (((size_t)(header->bits_per_sample + 1) * header->blocksize + 7) / 8 + 8) +
+        FLAC__FRAME_FOOTER_CRC_LEN / 8;
+
+    if (stream_info != 0 && stream_info->max_framesize > max_bytes)
+        max_bytes = stream_info->max_framesize;
+    return max_bytes;
+}
+
+FLAC__FrameHeaderParseStatus FLAC__frame_header_parse(const FLAC__byte *data, size_t bytes, const FLAC__StreamMetadata_StreamInfo *stream_info, FLAC__FrameHeader *header, unsigned *header_length)
+{
+    unsigned x, length, blocksize_hint = 0, sample_rate_hint = 0;
+    FLAC__uint64 xx;
+    int n;
+
+    FLAC_ASSERT(0 != data);
+    FLAC_ASSERT(0 != header);
+    FLAC_ASSERT(0 != header_length);
+
+    if (bytes < 4)
+        return FLAC__FRAME_HEADER_PARSE_TRUNCATED;
+    /* the sync code with the reserved bit clear, and no sync code inside */
+    if (!FLAC__frame_header_is_sync(data) || data[2] == 0xff || data[3] == 0xff)
+        return FLAC__FRAME_HEADER_PARSE_INVALID;
+
+    // <4> Block size in inter-channel samples
+    x = data[2] >> 4;
+    if (x == 0)
+        return FLAC__FRAME_HEADER_PARSE_INVALID;
+    else if (x == 1)
+        header->blocksize = 192;
+    else if (x <= 5)
+        header->blocksize = 576 << (x - 2);
+    else if (x <= 7)
+        blocksize_hint = x;
+    else
+        header->blocksize = 256 << (x - 8);
+
+    // <4> Sample rate
+    switch (x = data[2] & 0x0f) {
+        case 0:
+            if (stream_info == 0)
+                return FLAC__FRAME_HEADER_PARSE_INVALID;
+            header->sample_rate = stream_info->sample_rate;
+            break;
+        case 1: header->sample_rate = 88200; break;
+        case 2: header->sample_rate = 176400; break;
+        case 3: header->sample_rate = 192000; break;
+        case 4: header->sample_rate = 8000; break;
+        case 5: header->sample_rate = 16000; break;
+        case 6: header->sample_rate = 22050; break;
+        case 7: header->sample_rate = 24000; break;
+        case 8: header->sample_rate = 32000; break;
+        case 9: header->sample_rate = 44100; break;
+        case 10: header->sample_rate = 48000; break;
+        case 11: header->sample_rate = 96000; break;
+        case 12:
+        case 13:
+        case 14:
+            sample_rate_hint = x;
+            break;
+        default:
+            return FLAC__FRAME_HEADER_PARSE_INVALID;
+    }
+
+    // <4> Channel assignment
+    x = (unsigned)(data[3] >> 4);
+    if (x & 8) {
+        header->channels = 2;
+        switch (x & 7) {
+            case 0:
+                header->channel_assignment = FLAC__CHANNEL_ASSIGNMENT_LEFT_SIDE;
+                break;
+            case 1:
+                header->channel_assignment = FLAC__CHANNEL_ASSIGNMENT_RIGHT_SIDE;
+                break;
+            case 2:
+                header->channel_assignment = FLAC__CHANNEL_ASSIGNMENT_MID_SIDE;
+                break;
+            default:
+                return FLAC__FRAME_HEADER_PARSE_INVALID;
+        }
+    }
+    else {
+        header->channels = x + 1;
+        header->channel_assignment = FLAC__CHANNEL_ASSIGNMENT_INDEPENDENT;
+    }
+    if (stream_info != 0 && header->channels != stream_info->channels)
+        return FLAC__FRAME_HEADER_PARSE_INVALID;
+
+    // <3> Sample size in bits
+    switch (x = (unsigned)(data[3] & 0x0e) >> 1) {
+        case 0:
+            if (stream_info == 0)
+                return FLAC__FRAME_HEADER_PARSE_INVALID;
+            header->bits_per_sample = stream_info->bits_per_sample;
+            break;
+        case 1: header->bits_per_sample = 8; break;
+        case 2: header->bits_per_sample = 12; break;
+        case 4: header->bits_per_sample = 16; break;
+        case 5: header->bits_per_sample = 20; break;
+        case 6: header->bits_per_sample = 24; break;
+        case 7: header->bits_per_sample = 32; break;
+        default:
+            return FLAC__FRAME_HEADER_PARSE_INVALID;
+    }
+
+    /* reserved bit */
+    if (data[3] & 0x01)
+        return FLAC__FRAME_HEADER_PARSE_INVALID;
+
+    length = 4;
+    if (data[1] & 0x01) { /* variable blocksize: the sample number, up to 36 bits */
+        n = read_utf8_(data + length, bytes - length, 7, &xx);
+        header->number_type = FLAC__FRAME_NUMBER_TYPE_SAMPLE_NUMBER;
+        header->number.sample_number = xx;
+    }
+    else { /* fixed blocksize: the frame number, up to 31 bits */
+        n = read_utf8_(data + length, bytes - length, 6, &xx);
+        header->number_type = FLAC__FRAME_NUMBER_TYPE_FRAME_NUMBER;
+        header->number.frame_number = (FLAC__uint32)xx;
+    }
+    if (n < 0)
+        return FLAC__FRAME_HEADER_PARSE_TRUNCATED;
+    if (n == 0)
+        return FLAC__FRAME_HEADER_PARSE_INVALID;
+    length += (unsigned)n;
+
+    if (blocksize_hint) {
+        if (length + (blocksize_hint == 7 ? 2 : 1) > bytes)
+            return FLAC__FRAME_HEADER_PARSE_TRUNCATED;
+        x = data[length++];
+        if (blocksize_hint == 7)
+            x = (x << 8) | data[length++];
+        header->blocksize = x + 1;
+        if (header->blocksize > FLAC__MAX_BLOCK_SIZE)
+            return FLAC__FRAME_HEADER_PARSE_INVALID;
+    }
+
+    if (sample_rate_hint) {
+        if (length + (sample_rate_hint == 12 ? 1 : 2) > bytes)
+            return FLAC__FRAME_HEADER_PARSE_TRUNCATED;
+        x = data[length++];
+        if (sample_rate_hint != 12)
+            x = (x << 8) | data[length++];
+        if (sample_rate_hint == 12)
+            header->sample_rate = x * 1000;
+        else if (sample_rate_hint == 13)
+            header->sample_rate = x;
+        else
+            header->sample_rate = x * 10;
+    }
+
+    /* the CRC-8 byte */
+    if (length + 1 > bytes)
+        return FLAC__FRAME_HEADER_PARSE_TRUNCATED;
+    if (FLAC__dispatch()->crc8(data, length) != data[length])
+        return FLAC__FRAME_HEADER_PARSE_INVALID;
+    header->crc = data[length++];
+
+    *header_length = length;
+    return FLAC__FRAME_HEADER_PARSE_OK;
+}
+
+FLAC__uint64 FLAC__frame_header_get_sample_number(const FLAC__FrameHeader *header, const FLAC__StreamMetadata_StreamInfo *stream_info)
+{
+    if (header->number_type == FLAC__FRAME_NUMBER_TYPE_SAMPLE_NUMBER)
+        return header->number.sample_number;
+    if (stream_info != 0 && stream_info->min_blocksize == stream_info->max_blocksize)
+        return (FLAC__uint64)stream_info->min_blocksize * (FLAC__uint64)header->number.frame_number;
+    return (FLAC__uint64)header->blocksize * (FLAC__uint64)header->number.frame_number;
+}
+
+size_t FLAC__frame_header_find_sync(const FLAC__byte *data, size_t bytes)
+{
+    const FLAC__byte *b;
+    size_t p;
+
+    for (p = 0; p + 1 < bytes; p++) {
+        if ((b = (const FLAC__byte*)memchr(data + p, 0xff, bytes - p - 1)) == 0)
+            break;
+        p = (size_t)(b - data);
+        if (FLAC__frame_header_is_sync(b))
+            return p;
+    }
+    return bytes;
+}
+
+FLAC__FrameSearchStatus FLAC__frame_header_find_frame(const FLAC__byte *data, size_t bytes, FLAC__bool final, const FLAC__StreamMetadata_StreamInfo *stream_info, FLAC__FrameLocation *frame)
+{
+    FLAC__FrameHeader next_header;
+    FLAC__FrameHeaderParseStatus status;
+    unsigned header_length, next_header_length, crc;
+    size_t start, limit, resync, p, gap_end, next;
+    const FLAC__Dispatch *dispatch = FLAC__dispatch();
+
+    FLAC_ASSERT(0 != data || bytes == 0);
+    FLAC_ASSERT(0 != frame);
+
+    /* find the next valid frame header */
+    for (p = 0; ; p++) {
+        p += dispatch->frame_header_find_sync(data + p, bytes - p);
+        if (p + 1 >= bytes) {
+            /* a 0xff in the last byte may be the start of a sync code */
+            frame->start = bytes > 0 ? bytes - 1 : 0;
+            return final ? FLAC__FRAME_SEARCH_END : FLAC__FRAME_SEARCH_NEED_MORE;
+        }
+        status = FLAC__frame_header_parse(data + p, bytes - p, stream_info, &frame->header, &header_length);
+        if (status == FLAC__FRAME_HEADER_PARSE_OK)
+            break;
+        if (status == FLAC__FRAME_HEADER_PARSE_TRUNCATED) {
+            frame->start = p;
+            return final ? FLAC__FRAME_SEARCH_END : FLAC__FRAME_SEARCH_NEED_MORE;
+        }
+    }
+    start = p;
+
+    /*
+     * Walk the frame accumulating its CRC-16. The CRC of a whole frame,
+     * footer included, is 0, so the frame ends at the first valid frame
+     * header reached with a CRC of 0. The first valid header on the way
+     * is remembered in case the frame turns out to be damaged; a frame
+     * bigger than the bound is still allowed as long as no other header
+     * has turned up yet.
+     */
+    limit = start + FLAC__frame_header_max_frame_bytes(&frame->header, stream_info);
+    resync = 0;
+    crc = dispatch->crc16_update_block(data + start, header_length, 0);
+    for (p = start + header_length; p < bytes; ) {
+        if (data[p] == 0xff && (crc == 0 || resync == 0) && p + 1 < bytes && FLAC__frame_header_is_sync(data + p) &&
+            FLAC__frame_header_parse(data + p, bytes - p, stream_info, &next_header, &next_header_length) == FLAC__FRAME_HEADER_PARSE_OK) {
+            if (crc == 0) {
+                frame->start = start;
+                frame->end = p;
+                frame->crc_ok = true;
+                return FLAC__FRAME_SEARCH_FOUND;
+            }
+            resync = p;
+        }
+        /* past the bound, give up on a clean end once there is somewhere to resync */
+        if (p >= limit && resync != 0)
+            break;
+        crc = FLAC__CRC16_UPDATE(data[p], crc);
+        p++;
+        /*
+         * nothing can happen before the next sync code (or the bound), so
+         * run the CRC over the gap in one go; a sync code may start on the
+         * last byte before the bound
+         */
+        gap_end = resync != 0 ? flac_min(limit, bytes) : bytes;
+        FLAC_ASSERT(p <= gap_end);
+        next = p + dispatch->frame_header_find_sync(data + p, flac_min(gap_end + 1, bytes) - p);
+        gap_end = flac_min(next, gap_end);
+        crc = dispatch->crc16_update_block(data + p, gap_end - p, crc);
+        p = gap_end;
+    }
+
+    if (p == bytes && !final) {
+        frame->start = start;
+        return FLAC__FRAME_SEARCH_NEED_MORE;
+    }
+
+    frame->start = start;
+    if (p == bytes && crc == 0) {
+        /* the last frame runs to the end of the data */
+        frame->end = p;
+        frame->crc_ok = true;
+    }
+    else {
+        frame->end = resync ? resync : p;
+        frame->crc_ok = false;
+    }
+    return FLAC__FRAME_SEARCH_FOUND;
+}
@@ -0,0 +1,39 @@
+#include "private/cpu.h"
+
+#ifdef FLAC__AVX2_SUPPORTED
+
+#include <immintrin.h> /* AVX2 */
+#include "private/frame_header.h"
+#include "FLAC/assert.h"
+
+/*
+ * Same as frame_header_intrin_sse2.cpp with 32-byte vectors, 64 bytes
+ * per step.
+ */
+
+FLAC__SSE_TARGET("avx2")
+size_t FLAC__frame_header_find_sync_intrin_avx2(const FLAC__byte *data, size_t bytes)
+{
+    const __m256i ff = _mm256_set1_epi8((char)0xff);
+    const __m256i fe = _mm256_set1_epi8((char)0xfe);
+    const __m256i f8 = _mm256_set1_epi8((char)0xf8);
+    size_t p;
+
+    FLAC_ASSERT(0 != data || bytes == 0);
+
+    for (p = 0; p + 65 <= bytes; p += 64) {
+        const __m256i first0 = _mm256_loadu_si256((const __m256i*)(data + p));
+        const __m256i first1 = _mm256_loadu_si256((const __m256i*)(data + p + 32));
+        const __m256i second0 = _mm256_loadu_si256((const __m256i*)(data + p + 1));
+        const __m256i second1 = _mm256_loadu_si256((const __m256i*)(data + p + 33));
+        const __m256i sync0 = _mm256_and_si256(_mm256_cmpeq_epi8(first0, ff), _mm256_cmpeq_epi8(_mm256_and_si256(second0, fe), f8));
+        const __m256i sync1 = _mm256_and_si256(_mm256_cmpeq_epi8(first1, ff), _mm256_cmpeq_epi8(_mm256_and_si256(second1, fe), f8));
+        const FLAC__uint64 mask = (FLAC__uint64)(FLAC__uint32)_mm256_movemask_epi8(sync0) | (FLAC__uint64)(FLAC__uint32)_mm256_movemask_epi8(sync1) << 32;
+
+        if (mask != 0)
+            return p + (unsigned)__builtin_ctzll(mask);
+    }
+    return p + FLAC__frame_header_find_sync(data + p, bytes - p);
+}
+
+#endif /* FLAC__AVX2_SUPPORTED */
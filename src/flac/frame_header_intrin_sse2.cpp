@@ -0,0 +1,45 @@
+#include "private/cpu.h"
+
+#ifdef FLAC__SSE2_SUPPORTED
+
+#include <emmintrin.h> /* SSE2 */
+#include "private/frame_header.h"
+#include "FLAC/assert.h"
+
+/*
+ * A sync code starts at byte i if byte i is 0xff and byte i+1, with its
+ * last bit cleared, is 0xf8. Comparing a vector with 0xff, and the
+ * vector loaded one byte further on (masked) with 0xf8, gives the two
+ * halves for 16 positions at once; the first set bit of their AND is
+ * the first sync code. Two vectors are tested per step, so there is one
+ * branch per 32 bytes whatever the data holds, instead of a stop at
+ * every 0xff as with memchr(). What is left once a step and the byte
+ * looked ahead no longer fit goes through the C version.
+ */
+
+FLAC__SSE_TARGET("sse2")
+size_t FLAC__frame_header_find_sync_intrin_sse2(const FLAC__byte *data, size_t bytes)
+{
+    const __m128i ff = _mm_set1_epi8((char)0xff);
+    const __m128i fe = _mm_set1_epi8((char)0xfe);
+    const __m128i f8 = _mm_set1_epi8((char)0xf8);
+    size_t p;
+
+    FLAC_ASSERT(0 != data || bytes == 0);
+
+    for (p = 0; p + 33 <= bytes; p += 32) {
+        const __m128i first0 = _mm_loadu_si128((const __m128i*)(data + p));
+        const __m128i first1 = _mm_loadu_si128((const __m128i*)(data + p + 16));
+        const __m128i second0 = _mm_loadu_si128((const __m128i*)(data + p + 1));
+        const __m128i second1 = _mm_loadu_si128((const __m128i*)(data + p + 17));
+        const __m128i sync0 = _mm_and_si128(_mm_cmpeq_epi8(first0, ff), _mm_cmpeq_epi8(_mm_and_si128(second0, fe), f8));
+        const __m128i sync1 = _mm_and_si128(_mm_cmpeq_epi8(first1, ff), _mm_cmpeq_epi8(_mm_and_si128(second1, fe), f8));
+        const unsigned mask = (unsigned)_mm_movemask_epi8(sync0) | (unsigned)_mm_movemask_epi8(sync1) << 16;
+
+        if (mask != 0)
+            return p + (unsigned)__builtin_ctz(mask);
+    }
+    return p + FLAC__frame_header_find_sync(data + p, bytes - p);
+}
+
+#endif /* FLAC__SSE2_SUPPORTED */
@@ -0,0 +1,50 @@
+#ifndef FLAC__PRIVATE__ARENA_H
+#define FLAC__PRIVATE__ARENA_H
+
+#include <stddef.h>     // for size_t
+#include "FLAC/ordinals.h"
+
+/**
+ * One aligned block that a decoder or an encoder carves all of its
+ * working buffers out of, so setting up for a stream is a single
+ * allocation and a stream that fits the block is none at all.
+ *
+ * The buffers are laid out by a function that carves them one after the
+ * other. The same function sizes the block: an arena without a block
+ * only counts, carving returns NULL and adds up the size. So the usual
+ * pattern is
+ *  - FLAC__arena_begin_count(), run the layout
+ *  - FLAC__arena_reserve() with the count, run the layout again
+ * The block is only freed by FLAC__arena_free(); reserving again drops
+ * everything carved before and reuses the block if it is large enough.
+ */
+
+/* every buffer starts on a cache line, which is also enough for any vector load */
+#define FLAC__ARENA_ALIGNMENT (64u)
+
+typedef struct {
+    void *allocation; /* what malloc() returned */
+    FLAC__byte *block; /* the aligned start, NULL while counting */
+    size_t capacity;
+    size_t used;
+    FLAC__bool counting;
+} FLAC__Arena;
+
+void FLAC__arena_init(FLAC__Arena *arena);
+void FLAC__arena_free(FLAC__Arena *arena);
+
+/* Starts a counting pass; the block is kept. */
+void FLAC__arena_begin_count(FLAC__Arena *arena);
+
+/*
+ * Ends the counting pass and makes room for 'bytes' (what was counted),
+ * growing the block if needed. On failure the arena stays in the
+ * counting state and the old block, and what was carved out of it, is
+ * left alone.
+ */
+FLAC__bool FLAC__arena_reserve(FLAC__Arena *arena, size_t bytes);
+
+/* The next 'bytes' of the block, aligned; NULL while counting. */
+void *FLAC__arena_carve(FLAC__Arena *arena, size_t bytes);
+
+#endif // !FLAC__PRIVATE__ARENA_H
@@ -0,0 +1,90 @@
+#ifndef FLAC__PRIVATE__BITREADER_H
+#define FLAC__PRIVATE__BITREADER_H
+
+#include <stddef.h>     // for size_t
+#include "FLAC/ordinals.h"
+#include "private/cpu.h"
+
+/**
+ * opaque structure definition
+ */
+struct FLAC__BitReader;
+typedef struct FLAC__BitReader FLAC__BitReader;
+
+/**
+ * The read callback fills buffer[] with up to *bytes bytes and sets *bytes
+ * to the number actually read. It returns false when no more data can be
+ * delivered (end of stream or read error).
+ */
+typedef FLAC__bool (*FLAC__BitReaderReadCallback)(FLAC__byte buffer[], size_t *bytes, void *client_data);
+
+/**
+ * construction, deletion, initialization, etc functions
+ */
+FLAC__BitReader *FLAC__bitreader_new(void);
+void FLAC__bitreader_delete(FLAC__BitReader *br);
+FLAC__bool FLAC__bitreader_init(FLAC__BitReader *br, FLAC__BitReaderReadCallback rcb, void *cd);
+void FLAC__bitreader_free(FLAC__BitReader *br); /* does not 'free(br)' */
+FLAC__bool FLAC__bitreader_clear(FLAC__BitReader *br);
+
+/**
+ * Lets the reader take its input straight from memory: words are
+ * byte-swapped out of 'data' into the bit buffer as they are needed,
+ * without going through the read callback. The read callback is only
+ * consulted once the memory is used up, e.g. to signal the end of the
+ * stream. 'data' must stay valid while the reader uses it.
+ */
+void FLAC__bitreader_set_source(FLAC__BitReader *br, const FLAC__byte *data, size_t bytes);
+size_t FLAC__bitreader_get_source_bytes_left(const FLAC__BitReader *br);
+
+/**
+ * CRC functions
+ */
+// 从frame的sync开始累计CRC-16，读到footer时取出比较
+void FLAC__bitreader_reset_read_crc16(FLAC__BitReader *br, FLAC__uint16 seed);
+FLAC__uint16 FLAC__bitreader_get_read_crc16(FLAC__BitReader *br);
+
+/**
+ * info functions
+ */
+FLAC__bool FLAC__bitreader_is_consumed_byte_aligned(const FLAC__BitReader *br);
+unsigned FLAC__bitreader_bits_left_for_byte_alignment(const FLAC__BitReader *br);
+unsigned FLAC__bitreader_get_input_bits_unconsumed(const FLAC__BitReader *br);
+
+/**
+ * Buffers 'bits' bits ahead of the read position in one go, growing the
+ * buffer when it is too small to hold them. The decoder does this once
+ * per frame, for the largest the frame can be, so the reads inside the
+ * frame find their bits in the buffer and don't call back for more.
+ * Returns false if the stream ends first; what did come in stays
+ * buffered and the reads go on as before.
+ */
+FLAC__bool FLAC__bitreader_reserve(FLAC__BitReader *br, unsigned bits);
+
+/**
+ * read functions
+ *
+ * The _no_crc block functions are meant for metadata, which lives outside
+ * of any frame, so they make no promise about the running CRC-16.
+ */
+FLAC__bool FLAC__bitreader_read_raw_uint32(FLAC__BitReader *br, FLAC__uint32 *val, unsigned bits);
+FLAC__bool FLAC__bitreader_read_raw_int32(FLAC__BitReader *br, FLAC__int32 *val, unsigned bits);
+FLAC__bool FLAC__bitreader_read_raw_uint64(FLAC__BitReader *br, FLAC__uint64 *val, unsigned bits);
+FLAC__bool FLAC__bitreader_read_raw_int64(FLAC__BitReader *br, FLAC__int64 *val, unsigned bits);
+/* 'nvals' sign-extended values of 'bits' bits, checked for as a whole instead of one by one */
+FLAC__bool FLAC__bitreader_read_raw_int32_block(FLAC__BitReader *br, FLAC__int32 vals[], unsigned nvals, unsigned bits);
+FLAC__bool FLAC__bitreader_read_raw_int64_block(FLAC__BitReader *br, FLAC__int64 vals[], unsigned nvals, unsigned bits);
+FLAC__bool FLAC__bitreader_skip_bits_no_crc(FLAC__BitReader *br, unsigned bits);
+FLAC__bool FLAC__bitreader_skip_byte_block_aligned_no_crc(FLAC__BitReader *br, unsigned nvals);
+FLAC__bool FLAC__bitreader_read_byte_block_aligned_no_crc(FLAC__BitReader *br, FLAC__byte *val, unsigned nvals);
+FLAC__bool FLAC__bitreader_read_unary_unsigned(FLAC__BitReader *br, unsigned *val);
+FLAC__bool FLAC__bitreader_read_rice_signed(FLAC__BitReader *br, int *val, unsigned parameter);
+FLAC__bool FLAC__bitreader_read_rice_signed_block(FLAC__BitReader *br, int vals[], unsigned nvals, unsigned parameter);
+#ifdef FLAC__BMI2_SUPPORTED
+/* the same, for CPUs with BMI2 and LZCNT */
+FLAC__bool FLAC__bitreader_read_rice_signed_block_bmi2(FLAC__BitReader *br, int vals[], unsigned nvals, unsigned parameter);
+#endif
+FLAC__bool FLAC__bitreader_read_utf8_uint32(FLAC__BitReader *br, FLAC__uint32 *val, FLAC__byte *raw, unsigned *rawlen);
+FLAC__bool FLAC__bitreader_read_utf8_uint64(FLAC__BitReader *br, FLAC__uint64 *val, FLAC__byte *raw, unsigned *rawlen);
+
+#endif // !FLAC__PRIVATE__BITREADER_H
@@ -0,0 +1,62 @@
+#ifndef FLAC__PRIVATE__CPU_H
+#define FLAC__PRIVATE__CPU_H
+
+#include "FLAC/ordinals.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FLAC__CPU_X86_64
+#elif defined(__i386__) || defined(_M_IX86)
+#define FLAC__CPU_IA32
+#endif
+
+/**
+ * The SIMD kernels are written with intrinsics and compiled per function
+ * with a target attribute, so the library itself is still built for the
+ * baseline instruction set and the kernels are only called after
+ * FLAC__cpu_info() has confirmed the CPU (and the OS) support them.
+ */
+#if (defined FLAC__CPU_IA32 || defined FLAC__CPU_X86_64) && defined(__GNUC__)
+#define FLAC__HAS_X86INTRIN 1
+#define FLAC__SSE_TARGET(x) __attribute__ ((__target__ (x)))
+#define FLAC__SSE2_SUPPORTED 1
+#define FLAC__SSE4_1_SUPPORTED 1
+#define FLAC__AVX2_SUPPORTED 1
+#define FLAC__AVX512_SUPPORTED 1
+#define FLAC__BMI2_SUPPORTED 1
+#else
+#define FLAC__HAS_X86INTRIN 0
+#endif
+
+typedef enum {
+    FLAC__CPUINFO_TYPE_IA32,
+    FLAC__CPUINFO_TYPE_X86_64,
+    FLAC__CPUINFO_TYPE_UNKNOWN
+} FLAC__CPUInfo_Type;
+
+typedef struct {
+    FLAC__bool intel;
+
+    FLAC__bool sse2;
+    FLAC__bool ssse3;
+    FLAC__bool sse41;
+    FLAC__bool sse42;
+    /* the AVX flags are only set if the OS also saves the YMM state */
+    FLAC__bool avx;
+    FLAC__bool avx2;
+    FLAC__bool fma;
+    /* only set if the OS also saves the ZMM and opmask state */
+    FLAC__bool avx512f;
+    /* the scalar bit manipulation sets, which need no OS support */
+    FLAC__bool bmi2;
+    FLAC__bool lzcnt;
+} FLAC__CPUInfo_x86;
+
+typedef struct {
+    FLAC__bool use_asm;
+    FLAC__CPUInfo_Type type;
+    FLAC__CPUInfo_x86 x86;
+} FLAC__CPUInfo;
+
+void FLAC__cpu_info(FLAC__CPUInfo *info);
+
+#endif // !FLAC__PRIVATE__CPU_H
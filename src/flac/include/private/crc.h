@@ -0,0 +1,56 @@
+#ifndef FLAC__PRIVATE__CRC_H
+#define FLAC__PRIVATE__CRC_H
+
+#include "FLAC/ordinals.h"
+#include <stddef.h>     // for size_t
+
+/**
+ * 8 bit CRC generator, MSB shifted first
+ * polynomial = x^8 + x^2 + x^1 + x^0
+ * init = 0
+ */
+// 用于FRAME_HEADER的校验
+extern FLAC__byte const FLAC__crc8_table[256];
+#define FLAC__CRC8_UPDATE(data, crc) (crc) = FLAC__crc8_table[(crc) ^ (data)];
+void FLAC__crc8_update(const FLAC__byte data, FLAC__uint8 *crc);
+void FLAC__crc8_update_block(const FLAC__byte *data, unsigned len, FLAC__uint8 *crc);
+FLAC__uint8 FLAC__crc8(const FLAC__byte *data, unsigned len);
+
+/**
+ * 16 bit CRC generator, MSB shifted first
+ * polynomial = x^16 + x^15 + x^2 + x^0
+ * init = 0
+ */
+// 用于FRAME_FOOTER的校验，覆盖整个frame
+// 第k张表是一个字节后面再跟k个零字节的CRC，一次可以处理8个字节(slicing-by-8)
+extern FLAC__uint16 const FLAC__crc16_table[8][256];
+
+#define FLAC__CRC16_UPDATE(data, crc) ((((crc)<<8) & 0xffff) ^ FLAC__crc16_table[0][((crc)>>8) ^ (data)])
+
+/* Feeds 8 bytes at once, most significant byte of 'word' first; the result is the same as 8 FLAC__CRC16_UPDATE()s. */
+#define FLAC__CRC16_UPDATE_WORD64(word, crc) ( \
+    FLAC__crc16_table[7][(unsigned)((word) >> 56) ^ ((crc) >> 8)] ^ \
+    FLAC__crc16_table[6][(unsigned)((word) >> 48 & 0xff) ^ ((crc) & 0xff)] ^ \
+    FLAC__crc16_table[5][(unsigned)((word) >> 40 & 0xff)] ^ \
+    FLAC__crc16_table[4][(unsigned)((word) >> 32 & 0xff)] ^ \
+    FLAC__crc16_table[3][(unsigned)((word) >> 24 & 0xff)] ^ \
+    FLAC__crc16_table[2][(unsigned)((word) >> 16 & 0xff)] ^ \
+    FLAC__crc16_table[1][(unsigned)((word) >> 8 & 0xff)] ^ \
+    FLAC__crc16_table[0][(unsigned)((word) & 0xff)])
+
+unsigned FLAC__crc16_update_block(const FLAC__byte *data, size_t len, unsigned crc);
+unsigned FLAC__crc16(const FLAC__byte *data, unsigned len);
+
+/**
+ * 32 bit CRC generator, MSB shifted first
+ * polynomial = x^32 + x^26 + x^23 + x^22 + x^16 + x^12 + x^11 + x^10 + x^8 + x^7 + x^5 + x^4 + x^2 + x^1 + x^0
+ * init = 0, no final xor
+ */
+// 用于Ogg页的校验，和CRC-16一样按slicing-by-8查表
+extern FLAC__uint32 const FLAC__crc32_table[8][256];
+
+#define FLAC__CRC32_UPDATE(data, crc) (((crc) << 8) ^ FLAC__crc32_table[0][((crc) >> 24) ^ (data)])
+
+FLAC__uint32 FLAC__crc32_update_block(const FLAC__byte *data, size_t len, FLAC__uint32 crc);
+
+#endif // !FLAC__PRIVATE__CRC_H
@@ -0,0 +1,86 @@
+#ifndef FLAC__PRIVATE__DISPATCH_H
+#define FLAC__PRIVATE__DISPATCH_H
+
+#include <stddef.h>     // for size_t
+#include "FLAC/format.h"
+#include "private/bitreader.h"
+#include "private/cpu.h"
+#include "private/float.h"
+#include "private/frame_header.h"
+#include "private/lpc.h"
+#include "private/pcm.h"
+#include "private/stereo.h"
+
+// 启动时检测一次CPU，为每类kernel选好最快的实现，解码器和编码器都从这张表里取
+
+/**
+ * The instruction set levels the kernels are picked by, each one
+ * including the ones below it. A level without kernels of its own
+ * runs the ones of the highest level below it that has them: SSSE3
+ * runs the SSE2 frame sync search and the portable C for the rest.
+ */
+typedef enum {
+    FLAC__DISPATCH_GENERIC = 0,
+    FLAC__DISPATCH_SSE2,
+    FLAC__DISPATCH_SSSE3,
+    FLAC__DISPATCH_SSE4_1,
+    FLAC__DISPATCH_AVX2, /* also BMI2 and LZCNT, which every AVX2 CPU has */
+    FLAC__DISPATCH_AVX512
+} FLAC__DispatchLevel;
+
+/* the names FLAC_CPU_LEVEL takes, indexed by FLAC__DispatchLevel */
+extern const char * const FLAC__DispatchLevelString[];
+
+/**
+ * The kernels for this machine. Entries only the portable code
+ * implements so far (the CRCs, the autocorrelation, the residual) are
+ * still in the table, so callers never pick a kernel themselves and a
+ * SIMD version only has to be added here.
+ */
+typedef struct {
+    /* what the kernels were picked by, with FLAC_CPU_LEVEL applied */
+    FLAC__CPUInfo cpuinfo;
+    FLAC__DispatchLevel level;
+
+    /* bit reader and Rice */
+    FLAC__bool (*bitreader_read_rice_signed_block)(FLAC__BitReader *br, int vals[], unsigned nvals, unsigned parameter);
+
+    /* LPC; the 32-bit restore is only safe when the prediction cannot overflow */
+    void (*lpc_restore_signal)(const FLAC__int32 residual[], unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int32 data[]);
+    void (*lpc_restore_signal_wide)(const FLAC__int32 residual[], unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int32 data[]);
+    void (*lpc_compute_autocorrelation)(const FLAC__real data[], unsigned data_len, unsigned lag, double autoc[]);
+    /* indexed by order, see FLAC__lpc_compute_residual_from_qlp_coefficients_table */
+    const FLAC__LpcComputeResidualFunction *lpc_compute_residual;
+
+    /* frame sync search, for resync and for cutting a stream into ranges of frames */
+    FLAC__FrameSyncFindFunction frame_header_find_sync;
+
+    /* CRC */
+    FLAC__uint8 (*crc8)(const FLAC__byte *data, unsigned len);
+    unsigned (*crc16_update_block)(const FLAC__byte *data, size_t len, unsigned crc);
+    FLAC__uint32 (*crc32_update_block)(const FLAC__byte *data, size_t len, FLAC__uint32 crc);
+
+    /* conversion; stereo_decorrelate is only exact up to FLAC__STEREO_MAX_SIMD_DECORRELATE_BPS */
+    FLAC__StereoDecorrelateFunction stereo_decorrelate;
+    /* indexed by the channel assignment */
+    const FLAC__StereoRestoreFunction *stereo_restore;
+    /* indexed by the bytes per output sample minus one */
+    const FLAC__PcmInterleaveFunction *pcm_interleave;
+} FLAC__Dispatch;
+
+/**
+ * The kernels for this machine. The CPU is probed and the table filled
+ * on the first call, once per process and safely from any thread; every
+ * later call returns the same table.
+ *
+ * The environment variable FLAC_CPU_LEVEL, read on that first call,
+ * caps the level at one of the FLAC__DispatchLevelString names, so each
+ * path can be tested on one machine. It can only take features away: a
+ * level above what the CPU has, or a name that is not known, leaves the
+ * detected level alone.
+ *
+ * retval const FLAC__Dispatch*  The table, never NULL.
+ */
+const FLAC__Dispatch *FLAC__dispatch(void);
+
+#endif // !FLAC__PRIVATE__DISPATCH_H
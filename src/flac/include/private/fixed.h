@@ -0,0 +1,99 @@
+#ifndef FLAC__PRIVATE__FIXED_H
+#define FLAC__PRIVATE__FIXED_H
+
+#include "FLAC/format.h"
+
+// SUBFRAME_FIXED的预测系数是固定的多项式
+//   order 0: s[n] = e[n]
+//   order 1: s[n] = e[n] + s[n-1]
+//   order 2: s[n] = e[n] + 2s[n-1] - s[n-2]
+//   order 3: s[n] = e[n] + 3s[n-1] - 3s[n-2] + s[n-3]
+//   order 4: s[n] = e[n] + 4s[n-1] - 6s[n-2] + 4s[n-3] - s[n-4]
+
+/**
+ * Kernels for one predictor order, without the order argument. There is
+ * one per order and sample width, each compiled with the order as a
+ * constant, and they are reached through the tables below, indexed by
+ * order (0 to FLAC__MAX_FIXED_ORDER).
+ *
+ * The three widths are:
+ *  - plain: 32-bit intermediates, for subframes where
+ *    (bits-per-sample + order) is 32 or less (31 or less when computing
+ *    the residual, which can be one bit wider than the prediction);
+ *  - _wide: 64-bit intermediates for the rest of the 32-bit signals;
+ *  - _wide_33bit: 64-bit samples, for the side channel of a 32-bit
+ *    stereo stream.
+ *
+ * As with the functions further down, data[-order] through data[-1] are
+ * the warmup samples and index 0 is the first predicted sample.
+ */
+typedef void (*FLAC__FixedRestoreSignalFunction)(const FLAC__int32 residual[], unsigned data_len, FLAC__int32 data[]);
+typedef void (*FLAC__FixedRestoreSignal33bitFunction)(const FLAC__int32 residual[], unsigned data_len, FLAC__int64 data[]);
+typedef void (*FLAC__FixedComputeResidualFunction)(const FLAC__int32 data[], unsigned data_len, FLAC__int32 residual[]);
+typedef void (*FLAC__FixedComputeResidual33bitFunction)(const FLAC__int64 data[], unsigned data_len, FLAC__int32 residual[]);
+
+extern const FLAC__FixedRestoreSignalFunction FLAC__fixed_restore_signal_table[FLAC__MAX_FIXED_ORDER + 1];
+extern const FLAC__FixedRestoreSignalFunction FLAC__fixed_restore_signal_wide_table[FLAC__MAX_FIXED_ORDER + 1];
+extern const FLAC__FixedRestoreSignal33bitFunction FLAC__fixed_restore_signal_wide_33bit_table[FLAC__MAX_FIXED_ORDER + 1];
+
+extern const FLAC__FixedComputeResidualFunction FLAC__fixed_compute_residual_table[FLAC__MAX_FIXED_ORDER + 1];
+extern const FLAC__FixedComputeResidualFunction FLAC__fixed_compute_residual_wide_table[FLAC__MAX_FIXED_ORDER + 1];
+extern const FLAC__FixedComputeResidual33bitFunction FLAC__fixed_compute_residual_wide_33bit_table[FLAC__MAX_FIXED_ORDER + 1];
+
+/**
+ * Compute the best fixed predictor and the expected bits-per-sample
+ * of the residual signal for each order. The _wide() version is not
+ * needed: the errors are summed in 64 bits, which covers any signal up
+ * to 32 bits-per-sample.
+ * 
+ * param data[]     An array of the signal to be encoded; data[-4]
+ *                  through data[-1] must be valid samples.
+ * param data_len   The number of samples, not counting data[-4..-1].
+ * param residual_bits_per_sample[] Receives the expected bits-per-sample
+ *                  of the residual for each order.
+ * retval unsigned  The order with the smallest total absolute residual.
+ */
+// 编码端: 用各阶残差绝对值之和估计每阶的码率，选出最好的阶数
+unsigned FLAC__fixed_compute_best_predictor(const FLAC__int32 data[], unsigned data_len, float residual_bits_per_sample[FLAC__MAX_FIXED_ORDER + 1]);
+
+/**
+ * Compute the residual signal obtained from subtracting the predicted
+ * signal from the original.
+ * 
+ * param data[]     The original signal; data[-order] through data[-1]
+ *                  are the warmup samples.
+ * param data_len   The length of the original data, not counting the
+ *                  warmup samples.
+ * param order      The predictor order.
+ * param residual[] The residual signal.
+ */
+void FLAC__fixed_compute_residual(const FLAC__int32 data[], unsigned data_len, unsigned order, FLAC__int32 residual[]);
+void FLAC__fixed_compute_residual_wide(const FLAC__int32 data[], unsigned data_len, unsigned order, FLAC__int32 residual[]);
+void FLAC__fixed_compute_residual_wide_33bit(const FLAC__int64 data[], unsigned data_len, unsigned order, FLAC__int32 residual[]);
+
+/**
+ * Restore the original signal by summing the residual and the
+ * predictor, using order 'order' fixed polynomial prediction.
+ * 
+ * param residual   The residual signal.
+ * param data_len   The length of the residual data.
+ * param order      The predictor order.
+ * param data[]     The input signal; data[-order] through data[-1] must be
+ *                  the warmup samples, the restored signal is written to
+ *                  data[0] through data[data_len-1].
+ */
+void FLAC__fixed_restore_signal(const FLAC__int32 residual[], unsigned data_len, unsigned order, FLAC__int32 data[]);
+
+/**
+ * Same as FLAC__fixed_restore_signal() but with 64-bit intermediates, for
+ * subframes where (bits-per-sample + order) exceeds 32.
+ */
+void FLAC__fixed_restore_signal_wide(const FLAC__int32 residual[], unsigned data_len, unsigned order, FLAC__int32 data[]);
+
+/**
+ * Same as FLAC__fixed_restore_signal_wide() but for the 33-bit side
+ * channel of a 32-bit stereo stream.
+ */
+void FLAC__fixed_restore_signal_wide_33bit(const FLAC__int32 residual[], unsigned data_len, unsigned order, FLAC__int64 data[]);
+
+#endif // !FLAC__PRIVATE__FIXED_H
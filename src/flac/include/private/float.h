@@ -0,0 +1,14 @@
+#ifndef FLAC__PRIVATE__FLOAT_H
+#define FLAC__PRIVATE__FLOAT_H
+
+#include "FLAC/ordinals.h"
+
+/*
+ * The floating point type used by the encoder's LPC analysis for
+ * windows and windowed signals. The autocorrelation and the LP
+ * coefficients are always computed in double.
+ */
+// 只用于编码端的分析，解码完全是整数运算
+typedef float FLAC__real;
+
+#endif // !FLAC__PRIVATE__FLOAT_H
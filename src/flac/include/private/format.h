@@ -0,0 +1,76 @@
+#ifndef FLAC__PRIVATE__FORMAT_H
+#define FLAC__PRIVATE__FORMAT_H
+
+#include "FLAC/format.h"
+
+// format相关的内部函数，不对外导出
+
+/*
+ * The largest partition order a block can be split with: the blocksize
+ * must divide evenly by 2^order, and with a predictor every partition
+ * has to hold more samples than the predictor order (the first partition
+ * loses the warmup samples).
+ */
+unsigned FLAC__format_get_max_rice_partition_order_from_blocksize(unsigned blocksize);
+unsigned FLAC__format_get_max_rice_partition_order_from_blocksize_limited_max_and_predictor_order(unsigned limit, unsigned blocksize, unsigned predictor_order);
+
+void FLAC__format_entropy_coding_method_partitioned_rice_contents_init(FLAC__EntropyCodingMethod_PartitionedRiceContents *object);
+void FLAC__format_entropy_coding_method_partitioned_rice_contents_clear(FLAC__EntropyCodingMethod_PartitionedRiceContents *object);
+// 保证parameters/raw_bits至少有2^max_partition_order个元素
+FLAC__bool FLAC__format_entropy_coding_method_partitioned_rice_contents_ensure_size(FLAC__EntropyCodingMethod_PartitionedRiceContents *object, unsigned max_partition_order);
+
+/*
+ * Unpacks the FLAC__STREAM_METADATA_STREAMINFO_LENGTH bytes of a
+ * STREAMINFO block body, for code that reads metadata straight out of
+ * memory instead of through a decoder.
+ */
+void FLAC__format_unpack_streaminfo(const FLAC__byte data[], FLAC__StreamMetadata_StreamInfo *info);
+
+/*
+ * The walk over what comes before the frames of a native FLAC stream:
+ * an ID3v2 tag, if there is one, the "fLaC" marker and the metadata
+ * block headers. It keeps no pointers and never looks past the bytes it
+ * is given, so the same walk runs over a mapping, a read buffer or
+ * pushed bytes. Every call is given the bytes at the caller's position
+ * and says what is there and how far to move on; the caller reads or
+ * skips the block bodies itself.
+ */
+/* "ID3", version, flags, then a 28-bit synchsafe size of what follows the 10-byte header; the most the walk needs at once */
+#define FLAC__ID3V2_HEADER_LENGTH (10u)
+
+typedef enum {
+    /* at least walk->need bytes are wanted at the position; pass 'eof' if there are no more */
+    FLAC__METADATA_WALK_NEED_MORE = 0,
+
+    /* an ID3v2 tag; move on walk->skip bytes, which may be past the end of the stream */
+    FLAC__METADATA_WALK_ID3V2,
+
+    /* the "fLaC" marker; move on walk->skip bytes */
+    FLAC__METADATA_WALK_MARKER,
+
+    /* a block header: walk->type, walk->is_last and walk->length; the body
+     * follows the header, move on walk->skip bytes past both. The walk is
+     * over after the block that is_last. Until the caller moves on, the
+     * same header is returned again. */
+    FLAC__METADATA_WALK_BLOCK,
+
+    /* no marker where it should be: bare frames, or not FLAC at all */
+    FLAC__METADATA_WALK_NO_MARKER,
+
+    /* the stream ends inside a block header */
+    FLAC__METADATA_WALK_TRUNCATED
+} FLAC__MetadataWalkStatus;
+
+typedef struct {
+    unsigned step; /* what comes next, the walk's own */
+    size_t need;
+    size_t skip;
+    unsigned type;
+    FLAC__bool is_last;
+    unsigned length;
+} FLAC__MetadataWalk;
+
+void FLAC__format_metadata_walk_init(FLAC__MetadataWalk *walk);
+FLAC__MetadataWalkStatus FLAC__format_metadata_walk(FLAC__MetadataWalk *walk, const FLAC__byte *data, size_t bytes, FLAC__bool eof);
+
+#endif // !FLAC__PRIVATE__FORMAT_H
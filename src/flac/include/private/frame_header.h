@@ -0,0 +1,102 @@
+#ifndef FLAC__PRIVATE__FRAME_HEADER_H
+#define FLAC__PRIVATE__FRAME_HEADER_H
+
+#include <stddef.h>     // for size_t
+#include "FLAC/format.h"
+#include "private/cpu.h"
+
+/**
+ * Parsing a frame header straight out of memory, for the code that
+ * walks a stream without a decoder (frame span iterator, seek index,
+ * sync scanners). The rules are the decoder's: a header with reserved
+ * values, a sync code inside it, a bad UTF-8 number or a CRC-8 mismatch
+ * is invalid.
+ */
+typedef enum {
+    FLAC__FRAME_HEADER_PARSE_OK = 0,
+    FLAC__FRAME_HEADER_PARSE_TRUNCATED, /* the header runs past the end of the data */
+    FLAC__FRAME_HEADER_PARSE_INVALID
+} FLAC__FrameHeaderParseStatus;
+
+/**
+ * Parses the frame header at data[0], which should be the first sync
+ * byte. 'stream_info' may be NULL; without it the sample rate and
+ * bits-per-sample codes that refer to STREAMINFO are invalid, with it a
+ * channel count that does not match is.
+ *
+ * The number is left as coded: a frame number for fixed-blocksize
+ * streams, see FLAC__frame_header_get_sample_number().
+ *
+ * On success *header_length is the size of the header including the
+ * CRC-8 byte, i.e. the offset of the first subframe.
+ */
+FLAC__FrameHeaderParseStatus FLAC__frame_header_parse(const FLAC__byte *data, size_t bytes, const FLAC__StreamMetadata_StreamInfo *stream_info, FLAC__FrameHeader *header, unsigned *header_length);
+
+// 和解码器一样：固定块长的流用STREAMINFO的块长换算，否则只能假设不是最后一帧
+FLAC__uint64 FLAC__frame_header_get_sample_number(const FLAC__FrameHeader *header, const FLAC__StreamMetadata_StreamInfo *stream_info);
+
+/**
+ * How far to look for the end of a frame before calling it damaged: the
+ * size of the frame coded verbatim (the side channel can be a bit
+ * wider), or STREAMINFO's max_framesize if that is larger.
+ */
+size_t FLAC__frame_header_max_frame_bytes(const FLAC__FrameHeader *header, const FLAC__StreamMetadata_StreamInfo *stream_info);
+
+typedef enum {
+    FLAC__FRAME_SEARCH_FOUND = 0,
+    FLAC__FRAME_SEARCH_NEED_MORE, /* the data ends before the frame does; only when not 'final' */
+    FLAC__FRAME_SEARCH_END /* no more frame headers */
+} FLAC__FrameSearchStatus;
+
+/** Where FLAC__frame_header_find_frame() found a frame, relative to 'data'. */
+typedef struct {
+    size_t start, end;
+    FLAC__FrameHeader header; /* the number as coded */
+    FLAC__bool crc_ok;
+} FLAC__FrameLocation;
+
+/**
+ * Finds the next frame at or after data[0]. Bytes that do not start a
+ * valid header are stepped over. The frame ends at the first valid
+ * header reached with a running CRC-16 of 0; if the CRC never comes out
+ * right the frame is damaged and ends at the next valid header.
+ *
+ * With 'final' false the data is a window onto a longer stream: when the
+ * end of the frame (or its header) cannot be told yet the result is
+ * FLAC__FRAME_SEARCH_NEED_MORE and frame->start is where to search again
+ * once more data has been appended; everything before it can be dropped.
+ */
+FLAC__FrameSearchStatus FLAC__frame_header_find_frame(const FLAC__byte *data, size_t bytes, FLAC__bool final, const FLAC__StreamMetadata_StreamInfo *stream_info, FLAC__FrameLocation *frame);
+
+/**
+ * Returns the offset of the first frame sync code (0xfff8 or 0xfff9) in
+ * data[0..bytes-1], or 'bytes' if there is none; a 0xff in the last byte
+ * is not reported. Only the 15 bits are matched, the caller still has to
+ * parse the header behind it to tell a frame from a sync code inside the
+ * audio data.
+ *
+ * The SIMD versions compare a vector of bytes against 0xff and the
+ * vector one byte on against 0xf8 with the last bit masked, so they go
+ * through the data at memory speed instead of stopping at every 0xff.
+ * Use the one in FLAC__dispatch().
+ */
+typedef size_t (*FLAC__FrameSyncFindFunction)(const FLAC__byte *data, size_t bytes);
+
+size_t FLAC__frame_header_find_sync(const FLAC__byte *data, size_t bytes);
+#ifdef FLAC__SSE2_SUPPORTED
+size_t FLAC__frame_header_find_sync_intrin_sse2(const FLAC__byte *data, size_t bytes);
+#endif
+#ifdef FLAC__AVX2_SUPPORTED
+size_t FLAC__frame_header_find_sync_intrin_avx2(const FLAC__byte *data, size_t bytes);
+#endif
+
+/**
+ * true if data[0..1] holds a frame sync code with the reserved bit clear
+ * (0xfff8 or 0xfff9); 'data' must have at least two bytes.
+ */
+static inline FLAC__bool FLAC__frame_header_is_sync(const FLAC__byte *data)
+{
+    return data[0] == 0xff && (data[1] >> 1) == 0x7c;
+}
+
+#endif // !FLAC__PRIVATE__FRAME_HEADER_H
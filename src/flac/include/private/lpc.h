@@ -0,0 +1,166 @@
+#ifndef FLAC__PRIVATE__LPC_H
+#define FLAC__PRIVATE__LPC_H
+
+#include "FLAC/format.h"
+#include "private/cpu.h"
+#include "private/float.h"
+
+/*
+ * 编码端: 加窗 -> 自相关 -> Levinson-Durbin求LP系数 -> 量化 -> 计算残差
+ */
+
+/**
+ * Apply a window to the data.
+ * 
+ * param in[]       The input signal.
+ * param window[]   The window, data_len values.
+ * param out[]      The windowed signal.
+ * param data_len   The number of samples.
+ */
+void FLAC__lpc_window_data(const FLAC__int32 in[], const FLAC__real window[], FLAC__real out[], unsigned data_len);
+
+/**
+ * Compute the autocorrelation for lags between 0 and lag-1.
+ * Assumes data[] outside of [0,data_len-1] == 0.
+ * Asserts that lag > 0.
+ * 
+ * param data[]     An array containing the data for which the
+ *                  autocorrelation must be computed.
+ * param data_len   The number of samples.
+ * param lag        The number of lags to compute, i.e. max order + 1.
+ * param autoc[]    Receives the autocorrelation, lag values.
+ */
+void FLAC__lpc_compute_autocorrelation(const FLAC__real data[], unsigned data_len, unsigned lag, double autoc[]);
+
+/**
+ * Computes LP coefficients for orders 1..max_order with the
+ * Levinson-Durbin recursion.
+ * Do not call if autoc[0] == 0.0. This means the signal is zero
+ * and there is no point in calculating a predictor.
+ * 
+ * param autoc[]    An array containing the autocorrelation values.
+ * param max_order  Pointer to the max order; lowered if the prediction
+ *                  error reaches zero before max_order is reached.
+ * param lp_coeff[][] Receives the LP coefficients; the coefficients of
+ *                  order o are in lp_coeff[o-1][0..o-1].
+ * param error[]    Receives the prediction error of each order, in
+ *                  error[0..max_order-1].
+ */
+void FLAC__lpc_compute_lp_coefficients(const double autoc[], unsigned *max_order, double lp_coeff[][FLAC__MAX_LPC_ORDER], double error[]);
+
+/**
+ * Quantizes the LP coefficients.
+ * 
+ * param lp_coeff[]     The LP coefficients for the given order.
+ * param order          The order of the LP filter.
+ * param precision      The bits of precision of the quantized coefficients,
+ *                      FLAC__MIN_QLP_COEFF_PRECISION to FLAC__MAX_QLP_COEFF_PRECISION.
+ * param qlp_coeff[]    Receives the quantized coefficients.
+ * param shift          Receives the quantization shift.
+ * retval int
+ *      0 - ok
+ *      1 - cannot quantize, the shift would be below the format's limit
+ *      2 - all coefficients are zero, which is bad; the caller should
+ *          fall back to a fixed predictor
+ */
+int FLAC__lpc_quantize_coefficients(const double lp_coeff[], unsigned order, unsigned precision, FLAC__int32 qlp_coeff[], int *shift);
+
+/**
+ * Compute the residual signal obtained from subtracting the predicted
+ * signal from the original.
+ * 
+ * param data       The original signal; data[-order] through data[-1]
+ *                  are the warmup samples.
+ * param data_len   The length of the original data, not counting the warmup samples.
+ * param qlp_coeff  The quantized LP coefficients.
+ * param order      The order of the LP filter.
+ * param lp_quantization    The quantization shift of the predictor.
+ * param residual[] The residual signal.
+ */
+// 32位累加，条件同FLAC__lpc_restore_signal()
+void FLAC__lpc_compute_residual_from_qlp_coefficients(const FLAC__int32 *data, unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int32 residual[]);
+// 64位累加；残差超出32位时返回false，这组系数不能用
+FLAC__bool FLAC__lpc_compute_residual_from_qlp_coefficients_limit_residual(const FLAC__int32 *data, unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int32 residual[]);
+
+/**
+ * The 32-bit FLAC__lpc_compute_residual_from_qlp_coefficients() compiled
+ * once per order, with the loop over the coefficients unrolled, indexed
+ * by order (1 to FLAC__SUBSET_MAX_LPC_ORDER_48000HZ; entry 0 is NULL).
+ * The output is the same as the generic function's. The orders stop at
+ * the streamable subset's limit: those are all the orders a subset
+ * encoder ever uses, and past them the loop is long enough that
+ * unrolling it gains little.
+ */
+typedef void (*FLAC__LpcComputeResidualFunction)(const FLAC__int32 *data, unsigned data_len, const FLAC__int32 qlp_coeff[], int lp_quantization, FLAC__int32 residual[]);
+
+extern const FLAC__LpcComputeResidualFunction FLAC__lpc_compute_residual_from_qlp_coefficients_table[FLAC__SUBSET_MAX_LPC_ORDER_48000HZ + 1];
+
+/**
+ * Compute the expected number of bits per residual signal sample
+ * based on the LP error (which is related to the residual variance).
+ */
+double FLAC__lpc_compute_expected_bits_per_residual_sample(double lpc_error, unsigned total_samples);
+
+/**
+ * Compute the best order from the array of signal errors returned
+ * during coefficient computation.
+ * 
+ * param lpc_error[]    The error of each order, max_order values.
+ * param max_order      The largest order to consider.
+ * param total_samples  The number of samples in the block.
+ * param overhead_bits_per_order    The bits each extra order costs in the
+ *                      subframe header (a warmup sample plus a coefficient).
+ * retval unsigned      The best order, 1..max_order.
+ */
+unsigned FLAC__lpc_compute_best_order(const double lpc_error[], unsigned max_order, unsigned total_samples, unsigned overhead_bits_per_order);
+
+/**
+ * Restore the original signal by summing the residual and the
+ * predictor.
+ * 
+ * param residual       The residual signal.
+ * param data_len       The length of the residual data.
+ * param qlp_coeff      The quantized LP coefficients.
+ * param order          The order of the LP filter.
+ * param lp_quantization    The quantization shift of the predictor.
+ * param data[]         The input signal; data[-order] through data[-1] must
+ *                      be the warmup samples, the restored signal is written
+ *                      to data[0] through data[data_len-1].
+ */
+// 32位累加，只有在FLAC__lpc_max_prediction_before_shift_bps() <= 32时才能用
+void FLAC__lpc_restore_signal(const FLAC__int32 residual[], unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int32 data[]);
+// 64位累加
+void FLAC__lpc_restore_signal_wide(const FLAC__int32 residual[], unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int32 data[]);
+// 32-bit立体声的side声道有33位
+void FLAC__lpc_restore_signal_wide_33bit(const FLAC__int32 residual[], unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int64 data[]);
+
+// SIMD版本，输出和上面的C版本逐位相同；调用前要用FLAC__cpu_info()确认CPU支持
+#ifdef FLAC__SSE4_1_SUPPORTED
+void FLAC__lpc_restore_signal_intrin_sse41(const FLAC__int32 residual[], unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int32 data[]);
+void FLAC__lpc_restore_signal_wide_intrin_sse41(const FLAC__int32 residual[], unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int32 data[]);
+#endif
+#ifdef FLAC__AVX2_SUPPORTED
+void FLAC__lpc_restore_signal_intrin_avx2(const FLAC__int32 residual[], unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int32 data[]);
+void FLAC__lpc_restore_signal_wide_intrin_avx2(const FLAC__int32 residual[], unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int32 data[]);
+#endif
+
+/**
+ * Compute the number of bits the prediction can occupy before the
+ * quantization shift is applied, i.e. subframe_bps plus the log2 of the
+ * sum of the absolute values of the coefficients. If the result is 32 or
+ * less, the 32-bit accumulator path can be used without overflow.
+ * 
+ * param subframe_bps   The bits-per-sample of the subframe's signal.
+ * param qlp_coeff      The quantized LP coefficients.
+ * param order          The order of the LP filter.
+ * retval unsigned      The number of bits needed by the accumulator.
+ */
+unsigned FLAC__lpc_max_prediction_before_shift_bps(unsigned subframe_bps, const FLAC__int32 qlp_coeff[], unsigned order);
+
+/**
+ * Compute the number of bits a residual of this predictor can occupy,
+ * i.e. the prediction bits after the shift plus one.
+ */
+unsigned FLAC__lpc_max_residual_bps(unsigned subframe_bps, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization);
+
+#endif // !FLAC__PRIVATE__LPC_H
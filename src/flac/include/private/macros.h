@@ -0,0 +1,15 @@
+#ifndef FLAC__PRIVATE__MACROS_H
+#define FLAC__PRIVATE__MACROS_H
+
+// 一些通用的宏定义
+
+#define flac_max(a, b) ((a) > (b) ? (a) : (b))
+#define flac_min(a, b) ((a) < (b) ? (a) : (b))
+
+#if defined(_MSC_VER)
+#define FLAC__U64L(x) x
+#else
+#define FLAC__U64L(x) x##ULL
+#endif
+
+#endif // !FLAC__PRIVATE__MACROS_H
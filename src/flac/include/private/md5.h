@@ -0,0 +1,40 @@
+#ifndef FLAC__PRIVATE__MD5_H
+#define FLAC__PRIVATE__MD5_H
+
+#include <stddef.h>     // for size_t
+#include "FLAC/ordinals.h"
+
+/**
+ * This is the header file for the MD5 message-digest algorithm (RFC 1321)
+ * as used for the STREAMINFO signature: the digest of the unencoded
+ * audio, samples interleaved, little-endian, each sample taking the
+ * least number of whole bytes that holds bits-per-sample.
+ */
+typedef struct {
+    FLAC__uint32 in[16];
+    FLAC__uint32 buf[4];
+    FLAC__uint32 bytes[2];
+    /* staging area for FLAC__MD5Accumulate(), grown on demand */
+    FLAC__byte *internal_buf;
+    size_t capacity;
+} FLAC__MD5Context;
+
+void FLAC__MD5Init(FLAC__MD5Context *ctx);
+void FLAC__MD5Update(FLAC__MD5Context *ctx, const FLAC__byte *buf, size_t len);
+// 输出16字节的摘要，并释放internal_buf
+void FLAC__MD5Final(FLAC__byte digest[16], FLAC__MD5Context *ctx);
+
+/**
+ * Feeds 'samples' samples of each of 'channels' channels, given as one
+ * array per channel, in the STREAMINFO byte layout.
+ */
+FLAC__bool FLAC__MD5Accumulate(FLAC__MD5Context *ctx, const FLAC__int32 * const signal[], unsigned channels, unsigned samples, unsigned bytes_per_sample);
+
+/**
+ * The byte layout step of FLAC__MD5Accumulate() on its own, so the audio
+ * can be laid out in one thread and FLAC__MD5Update()d in another. 'buf'
+ * takes channels * samples * bytes_per_sample bytes.
+ */
+void FLAC__MD5FormatInput(FLAC__byte *buf, const FLAC__int32 * const signal[], unsigned channels, unsigned samples, unsigned bytes_per_sample);
+
+#endif // !FLAC__PRIVATE__MD5_H
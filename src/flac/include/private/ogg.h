@@ -0,0 +1,113 @@
+#ifndef FLAC__PRIVATE__OGG_H
+#define FLAC__PRIVATE__OGG_H
+
+#include <stddef.h>     // for size_t
+#include "FLAC/ordinals.h"
+
+/**
+ * Ogg pages (RFC 3533) and the Ogg FLAC mapping, without libogg.
+ *
+ * In Ogg FLAC the first packet is a 9-byte mapping header (0x7F "FLAC",
+ * version 1.0, the number of header packets that follow) and then the
+ * native "fLaC" marker and STREAMINFO block; every further header
+ * packet is one metadata block, VORBIS_COMMENT first, and every audio
+ * packet one frame. So the packets of a stream, put back to back with
+ * the mapping header cut off the first one, are exactly the native
+ * stream, and a page body can be handed to the decoder as it is,
+ * whichever packets start or end in it.
+ */
+
+#define FLAC__OGG_PAGE_HEADER_LENGTH (27u) /* up to and including the segment count */
+#define FLAC__OGG_MAX_SEGMENTS (255u)
+#define FLAC__OGG_MAX_PAGE_BYTES (FLAC__OGG_PAGE_HEADER_LENGTH + FLAC__OGG_MAX_SEGMENTS + FLAC__OGG_MAX_SEGMENTS * 255u)
+
+/* header_type flags */
+#define FLAC__OGG_PAGE_CONTINUED (0x01u) /* the page starts with the rest of a packet */
+#define FLAC__OGG_PAGE_BOS (0x02u)
+#define FLAC__OGG_PAGE_EOS (0x04u)
+
+#define FLAC__OGG_MAPPING_HEADER_LENGTH (9u)
+#define FLAC__OGG_MAPPING_VERSION_MAJOR (1u)
+#define FLAC__OGG_MAPPING_VERSION_MINOR (0u)
+
+/* a granule position of -1: no packet ends on the page */
+#define FLAC__OGG_NO_GRANULE ((FLAC__uint64)(FLAC__int64)-1)
+
+typedef struct {
+    unsigned flags;
+    FLAC__uint64 granule_position;
+    FLAC__uint32 serial_number;
+    FLAC__uint32 sequence_number;
+    unsigned segments;
+    const FLAC__byte *lacing;
+    const FLAC__byte *body;
+    size_t body_bytes;
+    size_t length; /* the whole page, header included */
+} FLAC__OggPage;
+
+typedef enum {
+    FLAC__OGG_PAGE_PARSE_OK = 0,
+    FLAC__OGG_PAGE_PARSE_TRUNCATED, /* the page runs past the end of the data */
+    FLAC__OGG_PAGE_PARSE_INVALID /* no capture pattern, an unknown version or a CRC mismatch */
+} FLAC__OggPageParseStatus;
+
+/**
+ * Parses the page at data[0]. The page's pointers point into 'data'.
+ */
+FLAC__OggPageParseStatus FLAC__ogg_page_parse(const FLAC__byte *data, size_t bytes, FLAC__OggPage *page);
+
+/**
+ * The offset of the next "OggS" at or after data[0]; if there is none,
+ * the offset of the last 3 bytes, which may be the start of one.
+ */
+size_t FLAC__ogg_find_capture_pattern(const FLAC__byte *data, size_t bytes);
+
+/**
+ * true if 'packet' is an Ogg FLAC mapping header (version 1.x); the
+ * native stream starts at packet + FLAC__OGG_MAPPING_HEADER_LENGTH.
+ */
+FLAC__bool FLAC__ogg_is_mapping_header(const FLAC__byte *packet, size_t bytes);
+
+/**
+ * Puts the CRC-32 of the page into header[22..25]. The header, lacing
+ * values included, and the body may live apart.
+ */
+void FLAC__ogg_page_set_checksum(FLAC__byte *header, size_t header_bytes, const FLAC__byte *body, size_t body_bytes);
+
+/**
+ * Packs packets into pages. A page is written once it holds at least
+ * FLAC__OGG_MUXER_PAGE_TARGET bytes and the next packet comes in, or
+ * runs out of segments; packets larger than that continue on the next
+ * page. The header and the body of a page are passed separately.
+ */
+#define FLAC__OGG_MUXER_PAGE_TARGET (4096u)
+
+typedef FLAC__bool (*FLAC__OggMuxerWriteFunction)(const FLAC__byte *header, size_t header_bytes, const FLAC__byte *body, size_t body_bytes, void *client_data);
+
+typedef struct {
+    FLAC__uint32 serial_number;
+    FLAC__uint32 sequence_number;
+    FLAC__uint64 granule_position; /* of the last packet that ends on the page */
+    unsigned flags; /* for the page being filled */
+    FLAC__byte header[FLAC__OGG_PAGE_HEADER_LENGTH + FLAC__OGG_MAX_SEGMENTS];
+    unsigned segments;
+    FLAC__byte *body; /* FLAC__OGG_MAX_SEGMENTS * 255 bytes */
+    size_t body_bytes;
+} FLAC__OggMuxer;
+
+FLAC__bool FLAC__ogg_muxer_init(FLAC__OggMuxer *muxer, FLAC__uint32 serial_number);
+void FLAC__ogg_muxer_free(FLAC__OggMuxer *muxer);
+
+/**
+ * Adds a packet; 'granule_position' is the position after it (for FLAC,
+ * the samples up to and including the frame).
+ */
+FLAC__bool FLAC__ogg_muxer_packet(FLAC__OggMuxer *muxer, const FLAC__byte *packet, size_t bytes, FLAC__uint64 granule_position, FLAC__OggMuxerWriteFunction write, void *client_data);
+
+/**
+ * Writes the page being filled, even if it is empty, with the EOS flag
+ * if 'eos'.
+ */
+FLAC__bool FLAC__ogg_muxer_flush(FLAC__OggMuxer *muxer, FLAC__bool eos, FLAC__OggMuxerWriteFunction write, void *client_data);
+
+#endif // !FLAC__PRIVATE__OGG_H
@@ -0,0 +1,33 @@
+#ifndef FLAC__PRIVATE__PCM_H
+#define FLAC__PRIVATE__PCM_H
+
+#include "FLAC/ordinals.h"
+#include "private/cpu.h"
+
+// 平面(每个声道一个数组)的样本 -> 交错的小端PCM
+
+/**
+ * Interleave planar samples into little-endian PCM, each sample in
+ * (bits-per-sample + 7) / 8 bytes. The kernels are indexed by that byte
+ * count minus one.
+ *
+ * Every sample is shifted first: left by 'shift' if it is positive,
+ * right (arithmetically, dropping the low bits) by -shift if it is
+ * negative. Only the low bytes of the result are stored, with no
+ * saturation, so every kernel gives the same bytes for any input.
+ *
+ * param buffer[]   One array per channel, 'samples' samples each.
+ * param channels   The number of channels, 1 to FLAC__MAX_CHANNELS.
+ * param samples    The number of samples per channel.
+ * param shift      The output bits-per-sample minus the input's.
+ * param pcm[]      Receives channels * samples samples.
+ */
+typedef void (*FLAC__PcmInterleaveFunction)(const FLAC__int32 * const buffer[], unsigned channels, unsigned samples, int shift, FLAC__byte pcm[]);
+
+extern const FLAC__PcmInterleaveFunction FLAC__pcm_interleave_table[4];
+#ifdef FLAC__SSE4_1_SUPPORTED
+/* mono and stereo are interleaved 16 output samples at a time, more channels go to the C kernels */
+extern const FLAC__PcmInterleaveFunction FLAC__pcm_interleave_intrin_sse41_table[4];
+#endif
+
+#endif // !FLAC__PRIVATE__PCM_H
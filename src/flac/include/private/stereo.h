@@ -0,0 +1,96 @@
+#ifndef FLAC__PRIVATE__STEREO_H
+#define FLAC__PRIVATE__STEREO_H
+
+#include "FLAC/format.h"
+#include "private/cpu.h"
+
+// 立体声去相关：
+//   left/side:  L, S = L - R
+//   right/side: S, R
+//   mid/side:   M = (L + R) >> 1, S；M丢掉的最低位和S的最低位相同
+
+/*
+ * The order of the sums FLAC__StereoDecorrelateFunction returns. They
+ * are the signals the channel assignments are made of.
+ */
+typedef enum {
+    FLAC__STEREO_SIGNAL_LEFT = 0,
+    FLAC__STEREO_SIGNAL_RIGHT,
+    FLAC__STEREO_SIGNAL_MID,
+    FLAC__STEREO_SIGNAL_SIDE,
+    FLAC__STEREO_SIGNALS
+} FLAC__StereoSignal;
+
+/*
+ * The SIMD decorrelation kernels compute the differences of the side
+ * signal in 32-bit lanes, which is exact up to this many bits-per-sample
+ * of the input.
+ */
+#define FLAC__STEREO_MAX_SIMD_DECORRELATE_BPS (30u)
+
+/**
+ * Compute the mid and side signals of a stereo block and, in the same
+ * pass, estimate how well each of the four signals compresses: the sum
+ * of the absolute values of its order 1 fixed residual, i.e. of the
+ * differences between consecutive samples. Going by the residual of a
+ * single low order picks about as well as the best of the fixed orders.
+ * The input must be below 32 bits-per-sample, so both outputs fit in 32
+ * bits.
+ *
+ * param left[]     The left channel, data_len samples.
+ * param right[]    The right channel, data_len samples.
+ * param data_len   The number of samples.
+ * param mid[]      Receives the mid signal.
+ * param side[]     Receives the side signal.
+ * param abs_residual_sum[] Receives the sums, indexed by FLAC__StereoSignal.
+ */
+typedef void (*FLAC__StereoDecorrelateFunction)(const FLAC__int32 left[], const FLAC__int32 right[], unsigned data_len, FLAC__int32 mid[], FLAC__int32 side[], FLAC__uint64 abs_residual_sum[FLAC__STEREO_SIGNALS]);
+
+void FLAC__stereo_decorrelate(const FLAC__int32 left[], const FLAC__int32 right[], unsigned data_len, FLAC__int32 mid[], FLAC__int32 side[], FLAC__uint64 abs_residual_sum[FLAC__STEREO_SIGNALS]);
+#ifdef FLAC__SSE4_1_SUPPORTED
+void FLAC__stereo_decorrelate_intrin_sse41(const FLAC__int32 left[], const FLAC__int32 right[], unsigned data_len, FLAC__int32 mid[], FLAC__int32 side[], FLAC__uint64 abs_residual_sum[FLAC__STEREO_SIGNALS]);
+#endif
+#ifdef FLAC__AVX2_SUPPORTED
+void FLAC__stereo_decorrelate_intrin_avx2(const FLAC__int32 left[], const FLAC__int32 right[], unsigned data_len, FLAC__int32 mid[], FLAC__int32 side[], FLAC__uint64 abs_residual_sum[FLAC__STEREO_SIGNALS]);
+#endif
+
+/**
+ * Pick the channel assignment whose two signals are estimated to take
+ * the fewest bits, from the sums FLAC__StereoDecorrelateFunction
+ * computed. Ties go to the lower assignment.
+ *
+ * param abs_residual_sum[] The sums, indexed by FLAC__StereoSignal.
+ * param data_len   The number of samples they were computed over.
+ * retval FLAC__ChannelAssignment  The estimated best assignment.
+ */
+FLAC__ChannelAssignment FLAC__stereo_estimate_channel_assignment(const FLAC__uint64 abs_residual_sum[FLAC__STEREO_SIGNALS], unsigned data_len);
+
+/**
+ * Undo the channel coding of a decoded stereo frame in place, for side
+ * signals that fit in 32 bits (i.e. below 32 bits-per-sample). The
+ * kernels are indexed by FLAC__ChannelAssignment; the entry for
+ * FLAC__CHANNEL_ASSIGNMENT_INDEPENDENT is NULL.
+ *
+ * channel0 and channel1 hold the two subframes in the order they are in
+ * the frame, i.e. left and side, side and right or mid and side, and
+ * receive left and right. The arithmetic wraps around in 32 bits, so a
+ * damaged frame gives the same samples on every CPU.
+ *
+ * param channel0[] The first subframe, data_len samples.
+ * param channel1[] The second subframe, data_len samples.
+ * param data_len   The number of samples.
+ */
+typedef void (*FLAC__StereoRestoreFunction)(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len);
+
+extern const FLAC__StereoRestoreFunction FLAC__stereo_restore_table[4];
+#ifdef FLAC__SSE4_1_SUPPORTED
+extern const FLAC__StereoRestoreFunction FLAC__stereo_restore_intrin_sse41_table[4];
+#endif
+#ifdef FLAC__AVX2_SUPPORTED
+extern const FLAC__StereoRestoreFunction FLAC__stereo_restore_intrin_avx2_table[4];
+#endif
+#ifdef FLAC__AVX512_SUPPORTED
+extern const FLAC__StereoRestoreFunction FLAC__stereo_restore_intrin_avx512_table[4];
+#endif
+
+#endif // !FLAC__PRIVATE__STEREO_H
@@ -0,0 +1,20 @@
+#ifndef FLAC__PRIVATE__STREAM_ENCODER_FRAMING_H
+#define FLAC__PRIVATE__STREAM_ENCODER_FRAMING_H
+
+#include "FLAC/format.h"
+#include "private/bitwriter.h"
+
+// 把STREAMINFO、帧头和各种subframe按格式写进bitwriter
+
+FLAC__bool FLAC__add_metadata_block_streaminfo(const FLAC__StreamMetadata_StreamInfo *stream_info, FLAC__bool is_last, FLAC__BitWriter *bw);
+// 只有厂商字符串、没有注释的VORBIS_COMMENT；Ogg FLAC要求它是第二个头包
+FLAC__bool FLAC__add_metadata_block_vorbis_comment(const char *vendor_string, FLAC__bool is_last, FLAC__BitWriter *bw);
+// 只写STREAMINFO的34字节内容，不带块头；编码结束回填时用
+FLAC__bool FLAC__add_streaminfo_body(const FLAC__StreamMetadata_StreamInfo *stream_info, FLAC__BitWriter *bw);
+FLAC__bool FLAC__frame_add_header(const FLAC__FrameHeader *header, FLAC__BitWriter *bw);
+FLAC__bool FLAC__subframe_add_constant(const FLAC__Subframe_Constant *subframe, unsigned subframe_bps, unsigned wasted_bits, FLAC__BitWriter *bw);
+FLAC__bool FLAC__subframe_add_fixed(const FLAC__Subframe_Fixed *subframe, unsigned residual_samples, unsigned subframe_bps, unsigned wasted_bits, FLAC__BitWriter *bw);
+FLAC__bool FLAC__subframe_add_lpc(const FLAC__Subframe_LPC *subframe, unsigned residual_samples, unsigned subframe_bps, unsigned wasted_bits, FLAC__BitWriter *bw);
+FLAC__bool FLAC__subframe_add_verbatim(const FLAC__Subframe_Verbatim *subframe, unsigned samples, unsigned subframe_bps, unsigned wasted_bits, FLAC__BitWriter *bw);
+
+#endif // !FLAC__PRIVATE__STREAM_ENCODER_FRAMING_H
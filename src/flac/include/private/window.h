@@ -0,0 +1,19 @@
+#ifndef FLAC__PRIVATE__WINDOW_H
+#define FLAC__PRIVATE__WINDOW_H
+
+#include "FLAC/ordinals.h"
+#include "private/float.h"
+
+/*
+ * Apodization windows for the encoder's LPC analysis.
+ *
+ * param window     The window data, L values are written.
+ * param L          The window length.
+ * param p          The tukey taper: the fraction of the window that is
+ *                  cosine-tapered, 0 gives a rectangle and 1 a Hann window.
+ */
+void FLAC__window_rectangle(FLAC__real *window, const FLAC__int32 L);
+void FLAC__window_hann(FLAC__real *window, const FLAC__int32 L);
+void FLAC__window_tukey(FLAC__real *window, const FLAC__int32 L, const FLAC__real p);
+
+#endif // !FLAC__PRIVATE__WINDOW_H
@@ -0,0 +1,389 @@
+#include <math.h>
+#include "private/lpc.h"
+#include "FLAC/assert.h"
+
+#ifndef M_LN2
+/* math.h in VC++ doesn't seem to have this (how Microsoft is that?) */
+#define M_LN2 0.69314718055994530942
+#endif
+
+// 编码端: LPC分析
+
+void FLAC__lpc_window_data(const FLAC__int32 in[], const FLAC__real window[], FLAC__real out[], unsigned data_len)
+{
+    unsigned i;
+
+    for (i = 0; i < data_len; i++)
+        out[i] = in[i] * window[i];
+}
+
+void FLAC__lpc_compute_autocorrelation(const FLAC__real data[], unsigned data_len, unsigned lag, double autoc[])
+{
+    /* a readable, but slower, version */
+    double d;
+    unsigned sample, coeff;
+
+    FLAC_ASSERT(lag > 0);
+    FLAC_ASSERT(lag <= data_len);
+
+    for (coeff = 0; coeff < lag; coeff++) {
+        d = 0.0;
+        for (sample = coeff; sample < data_len; sample++)
+            d += (double)data[sample] * (double)data[sample - coeff];
+        autoc[coeff] = d;
+    }
+}
+
+void FLAC__lpc_compute_lp_coefficients(const double autoc[], unsigned *max_order, double lp_coeff[][FLAC__MAX_LPC_ORDER], double error[])
+{
+    unsigned i, j;
+    double r, err, lpc[FLAC__MAX_LPC_ORDER];
+
+    FLAC_ASSERT(0 != max_order);
+    FLAC_ASSERT(0 < *max_order);
+    FLAC_ASSERT(*max_order <= FLAC__MAX_LPC_ORDER);
+    FLAC_ASSERT(autoc[0] != 0.0);
+
+    err = autoc[0];
+
+    for (i = 0; i < *max_order; i++) {
+        /* Sum up this iteration's reflection coefficient. */
+        r = -autoc[i + 1];
+        for (j = 0; j < i; j++)
+            r -= lpc[j] * autoc[i - j];
+        r /= err;
+
+        /* Update LPC coefficients and total error. */
+        lpc[i] = r;
+        for (j = 0; j < (i >> 1); j++) {
+            double tmp = lpc[j];
+            lpc[j] += r * lpc[i - 1 - j];
+            lpc[i - 1 - j] += r * tmp;
+        }
+        if (i & 1)
+            lpc[j] += lpc[j] * r;
+
+        err *= (1.0 - r * r);
+
+        /* save this order */
+        for (j = 0; j <= i; j++)
+            lp_coeff[i][j] = -lpc[j]; /* negate FIR filter coeff to get predictor coeff */
+        error[i] = err;
+
+        /* the predictor is already perfect, higher orders cannot do better */
+        if (err == 0.0) {
+            *max_order = i + 1;
+            return;
+        }
+    }
+}
+
+int FLAC__lpc_quantize_coefficients(const double lp_coeff[], unsigned order, unsigned precision, FLAC__int32 qlp_coeff[], int *shift)
+{
+    unsigned i;
+    double cmax;
+    FLAC__int32 qmax, qmin;
+
+    FLAC_ASSERT(precision > 0);
+    FLAC_ASSERT(precision >= FLAC__MIN_QLP_COEFF_PRECISION);
+
+    /* drop one bit for the sign; from here on out we consider only |lp_coeff[i]| */
+    precision--;
+    qmax = 1 << precision;
+    qmin = -qmax;
+    qmax--;
+
+    /* calc cmax = max( |lp_coeff[i]| ) */
+    cmax = 0.0;
+    for (i = 0; i < order; i++) {
+        const double d = fabs(lp_coeff[i]);
+        if (d > cmax)
+            cmax = d;
+    }
+
+    if (cmax <= 0.0) {
+        /* => coefficients are all 0, which means our constant-detect didn't work */
+        return 2;
+    }
+    else {
+        const int max_shiftlimit = (1 << (FLAC__SUBFRAME_LPC_QLP_SHIFT_LEN - 1)) - 1;
+        const int min_shiftlimit = -max_shiftlimit - 1;
+        int log2cmax;
+
+        (void)frexp(cmax, &log2cmax);
+        log2cmax--;
+        *shift = (int)precision - log2cmax - 1;
+
+        if (*shift > max_shiftlimit)
+            *shift = max_shiftlimit;
+        else if (*shift < min_shiftlimit)
+            return 1;
+    }
+
+    if (*shift >= 0) {
+        double error = 0.0;
+        FLAC__int32 q;
+        /* carry the rounding error of each coefficient into the next one */
+        for (i = 0; i < order; i++) {
+            error += lp_coeff[i] * (1 << *shift);
+            q = (FLAC__int32)lround(error);
+            if (q > qmax)
+                q = qmax;
+            else if (q < qmin)
+                q = qmin;
+            error -= q;
+            qlp_coeff[i] = q;
+        }
+    }
+    /* negative shift is very rare but due to design flaw, negative shift is
+     * not allowed in the decoder, so it must be handled specially by scaling
+     * down coeffs
+     */
+    else {
+        const int nshift = -(*shift);
+        double error = 0.0;
+        FLAC__int32 q;
+        for (i = 0; i < order; i++) {
+            error += lp_coeff[i] / (1 << nshift);
+            q = (FLAC__int32)lround(error);
+            if (q > qmax)
+                q = qmax;
+            else if (q < qmin)
+                q = qmin;
+            error -= q;
+            qlp_coeff[i] = q;
+        }
+        *shift = 0;
+    }
+
+    return 0;
+}
+
+void FLAC__lpc_compute_residual_from_qlp_coefficients(const FLAC__int32 *data, unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int32 residual[])
+{
+    int i, j;
+    FLAC__int32 sum;
+    const FLAC__int32 *history;
+
+    FLAC_ASSERT(order > 0);
+    FLAC_ASSERT(order <= FLAC__MAX_LPC_ORDER);
+
+    for (i = 0; i < (int)data_len; i++) {
+        sum = 0;
+        history = data + i;
+        for (j = 0; j < (int)order; j++)
+            sum += qlp_coeff[j] * (*(--history));
+        residual[i] = data[i] - (sum >> lp_quantization);
+    }
+}
+
+/*
+ * The prediction of a given order, unrolled at compile time the same
+ * way as FixedPrediction in fixed.cpp: qlp_coeff[0] goes with the newest
+ * sample, history[-1].
+ */
+template <unsigned Order> struct LpcPrediction {
+    static inline FLAC__int32 predict(const FLAC__int32 qlp_coeff[], const FLAC__int32 *history)
+    {
+        return LpcPrediction<Order - 1>::predict(qlp_coeff, history) + qlp_coeff[Order - 1] * history[-(int)Order];
+    }
+};
+
+template <> struct LpcPrediction<0> {
+    static inline FLAC__int32 predict(const FLAC__int32 *, const FLAC__int32 *) { return 0; }
+};
+
+template <unsigned Order>
+static void compute_residual_(const FLAC__int32 *data, unsigned data_len, const FLAC__int32 qlp_coeff[], int lp_quantization, FLAC__int32 residual[])
+{
+    FLAC__int32 coeff[Order];
+    int i, idata_len = (int)data_len;
+    unsigned j;
+
+    /* a local copy, so the compiler knows the residual stores can't change the coefficients */
+    for (j = 0; j < Order; j++)
+        coeff[j] = qlp_coeff[j];
+
+    for (i = 0; i < idata_len; i++)
+        residual[i] = data[i] - (LpcPrediction<Order>::predict(coeff, data + i) >> lp_quantization);
+}
+
+const FLAC__LpcComputeResidualFunction FLAC__lpc_compute_residual_from_qlp_coefficients_table[FLAC__SUBSET_MAX_LPC_ORDER_48000HZ + 1] = {
+    0,
+    compute_residual_<1>,
+    compute_residual_<2>,
+    compute_residual_<3>,
+    compute_residual_<4>,
+    compute_residual_<5>,
+    compute_residual_<6>,
+    compute_residual_<7>,
+    compute_residual_<8>,
+    compute_residual_<9>,
+    compute_residual_<10>,
+    compute_residual_<11>,
+    compute_residual_<12>
+};
+
+FLAC__bool FLAC__lpc_compute_residual_from_qlp_coefficients_limit_residual(const FLAC__int32 *data, unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int32 residual[])
+{
+    int i, j;
+    FLAC__int64 sum, residual_to_check;
+    const FLAC__int32 *history;
+
+    FLAC_ASSERT(order > 0);
+    FLAC_ASSERT(order <= FLAC__MAX_LPC_ORDER);
+
+    for (i = 0; i < (int)data_len; i++) {
+        sum = 0;
+        history = data + i;
+        for (j = 0; j < (int)order; j++)
+            sum += (FLAC__int64)qlp_coeff[j] * (FLAC__int64)(*(--history));
+        residual_to_check = data[i] - (sum >> lp_quantization);
+        /* the residual must fit in 32 bits to be Rice coded */
+        if (residual_to_check <= INT32_MIN || residual_to_check > INT32_MAX)
+            return false;
+        residual[i] = (FLAC__int32)residual_to_check;
+    }
+    return true;
+}
+
+double FLAC__lpc_compute_expected_bits_per_residual_sample(double lpc_error, unsigned total_samples)
+{
+    double error_scale;
+
+    FLAC_ASSERT(total_samples > 0);
+
+    error_scale = 0.5 / (double)total_samples;
+
+    if (lpc_error > 0.0) {
+        double bps = (double)0.5 * log(error_scale * lpc_error) / M_LN2;
+        if (bps >= 0.0)
+            return bps;
+        else
+            return 0.0;
+    }
+    else if (lpc_error < 0.0) { /* error should not be negative but can happen due to inadequate floating-point resolution */
+        return 1e32;
+    }
+    else {
+        return 0.0;
+    }
+}
+
+unsigned FLAC__lpc_compute_best_order(const double lpc_error[], unsigned max_order, unsigned total_samples, unsigned overhead_bits_per_order)
+{
+    unsigned order, indx, best_index; /* 'index' the index into lpc_error; index==order-1 since lpc_error[0] is for order==1, lpc_error[1] is for order==2, etc */
+    double bits, best_bits;
+
+    FLAC_ASSERT(max_order > 0);
+    FLAC_ASSERT(total_samples > 0);
+
+    best_index = 0;
+    best_bits = (unsigned)(-1);
+
+    for (indx = 0, order = 1; indx < max_order; indx++, order++) {
+        bits = FLAC__lpc_compute_expected_bits_per_residual_sample(lpc_error[indx], total_samples) * (double)(total_samples - order) + (double)(order * overhead_bits_per_order);
+        if (bits < best_bits) {
+            best_index = indx;
+            best_bits = bits;
+        }
+    }
+
+    return best_index + 1; /* +1 since indx of lpc_error[] is order-1 */
+}
+
+// 解码端: 由残差和量化的LPC系数恢复信号
+
+/*
+ * The sums are unsigned where a damaged frame could make them overflow;
+ * they wrap around instead, and the frame fails its CRC afterwards.
+ */
+void FLAC__lpc_restore_signal(const FLAC__int32 residual[], unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int32 data[])
+{
+    int i, j;
+    FLAC__uint32 sum;
+    const FLAC__int32 *history;
+
+    FLAC_ASSERT(order > 0);
+    FLAC_ASSERT(order <= FLAC__MAX_LPC_ORDER);
+
+    for (i = 0; i < (int)data_len; i++) {
+        sum = 0;
+        history = data + i;
+        for (j = 0; j < (int)order; j++)
+            sum += (FLAC__uint32)qlp_coeff[j] * (FLAC__uint32)(*(--history));
+        data[i] = (FLAC__int32)((FLAC__uint32)residual[i] + (FLAC__uint32)((FLAC__int32)sum >> lp_quantization));
+    }
+}
+
+void FLAC__lpc_restore_signal_wide(const FLAC__int32 residual[], unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int32 data[])
+{
+    int i, j;
+    FLAC__int64 sum;
+    const FLAC__int32 *history;
+
+    FLAC_ASSERT(order > 0);
+    FLAC_ASSERT(order <= FLAC__MAX_LPC_ORDER);
+
+    for (i = 0; i < (int)data_len; i++) {
+        sum = 0;
+        history = data + i;
+        for (j = 0; j < (int)order; j++)
+            sum += (FLAC__int64)qlp_coeff[j] * (FLAC__int64)(*(--history));
+        data[i] = (FLAC__int32)(residual[i] + (sum >> lp_quantization));
+    }
+}
+
+void FLAC__lpc_restore_signal_wide_33bit(const FLAC__int32 residual[], unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int64 data[])
+{
+    int i, j;
+    FLAC__uint64 sum;
+    const FLAC__int64 *history;
+
+    FLAC_ASSERT(order > 0);
+    FLAC_ASSERT(order <= FLAC__MAX_LPC_ORDER);
+
+    for (i = 0; i < (int)data_len; i++) {
+        sum = 0;
+        history = data + i;
+        for (j = 0; j < (int)order; j++)
+            sum += (FLAC__uint64)qlp_coeff[j] * (FLAC__uint64)(*(--history));
+        data[i] = (FLAC__int64)((FLAC__uint64)residual[i] + (FLAC__uint64)((FLAC__int64)sum >> lp_quantization));
+    }
+}
+
+static unsigned bitmath_silog2_(FLAC__uint64 v)
+{
+    unsigned bits = 0;
+
+    while (v) {
+        bits++;
+        v >>= 1;
+    }
+    return bits;
+}
+
+unsigned FLAC__lpc_max_prediction_before_shift_bps(unsigned subframe_bps, const FLAC__int32 qlp_coeff[], unsigned order)
+{
+    /* |sum| <= abs_sum_of_qlp_coeff * 2^(subframe_bps-1), so the signed
+     * accumulator needs subframe_bps + ceil(log2(abs_sum_of_qlp_coeff)) + 1 bits.
+     */
+    FLAC__uint64 abs_sum_of_qlp_coeff = 0;
+    unsigned i;
+
+    for (i = 0; i < order; i++)
+        abs_sum_of_qlp_coeff += (FLAC__uint64)(qlp_coeff[i] < 0 ? -(FLAC__int64)qlp_coeff[i] : qlp_coeff[i]);
+    if (abs_sum_of_qlp_coeff == 0)
+        abs_sum_of_qlp_coeff = 1;
+    return subframe_bps + bitmath_silog2_(abs_sum_of_qlp_coeff - 1) + 1;
+}
+
+unsigned FLAC__lpc_max_residual_bps(unsigned subframe_bps, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization)
+{
+    unsigned predictor_sum_bps = FLAC__lpc_max_prediction_before_shift_bps(subframe_bps, qlp_coeff, order) - lp_quantization;
+
+    if ((int)subframe_bps > (int)predictor_sum_bps)
+        return subframe_bps + 1;
+    else
+        return predictor_sum_bps + 1;
+}
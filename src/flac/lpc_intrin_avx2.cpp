@@ -0,0 +1,98 @@
+#include "private/cpu.h"
+
+#ifdef FLAC__AVX2_SUPPORTED
+
+#include <immintrin.h> /* AVX2 */
+#include "private/lpc.h"
+#include "FLAC/assert.h"
+
+#define U_(x) ((FLAC__uint32)(x))
+
+/*
+ * Same block scheme as lpc_intrin_sse41.cpp with 8 (32-bit) or 4 (64-bit)
+ * lanes. With eight lanes, eight taps per sample are left to the scalar
+ * part, so low orders are handed to the SSE4.1 kernel instead.
+ */
+
+FLAC__SSE_TARGET("avx2")
+void FLAC__lpc_restore_signal_intrin_avx2(const FLAC__int32 residual[], unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int32 data[])
+{
+    __m256i coeff[FLAC__MAX_LPC_ORDER];
+    int i, j, k;
+
+    FLAC_ASSERT(order > 0);
+    FLAC_ASSERT(order <= FLAC__MAX_LPC_ORDER);
+
+    if (order < 12) {
+        FLAC__lpc_restore_signal_intrin_sse41(residual, data_len, qlp_coeff, order, lp_quantization, data);
+        return;
+    }
+
+    for (j = 8; j < (int)order; j++)
+        coeff[j] = _mm256_set1_epi32(qlp_coeff[j]);
+
+    for (i = 0; i + 8 <= (int)data_len; i += 8) {
+        FLAC__uint32 sum[8];
+        __m256i far = _mm256_setzero_si256();
+
+        /* lane k gets the taps of sample i+k that reach before sample i */
+        for (j = 8; j < (int)order; j++)
+            far = _mm256_add_epi32(far, _mm256_mullo_epi32(coeff[j], _mm256_loadu_si256((const __m256i*)(data + i - 1 - j))));
+        _mm256_storeu_si256((__m256i*)sum, far);
+
+        for (k = 0; k < 8; k++) {
+            const FLAC__int32 *history = data + i + k;
+            /* unsigned, so that a damaged frame wraps around like the scalar code */
+            sum[k] += U_(qlp_coeff[0]) * U_(history[-1]) + U_(qlp_coeff[1]) * U_(history[-2]) + U_(qlp_coeff[2]) * U_(history[-3]) + U_(qlp_coeff[3]) * U_(history[-4])
+                    + U_(qlp_coeff[4]) * U_(history[-5]) + U_(qlp_coeff[5]) * U_(history[-6]) + U_(qlp_coeff[6]) * U_(history[-7]) + U_(qlp_coeff[7]) * U_(history[-8]);
+            data[i+k] = (FLAC__int32)(U_(residual[i+k]) + U_((FLAC__int32)sum[k] >> lp_quantization));
+        }
+    }
+
+    if (i < (int)data_len)
+        FLAC__lpc_restore_signal(residual + i, data_len - i, qlp_coeff, order, lp_quantization, data + i);
+}
+
+FLAC__SSE_TARGET("avx2")
+void FLAC__lpc_restore_signal_wide_intrin_avx2(const FLAC__int32 residual[], unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int32 data[])
+{
+    __m256i coeff[FLAC__MAX_LPC_ORDER];
+    int i, j;
+
+    FLAC_ASSERT(order > 0);
+    FLAC_ASSERT(order <= FLAC__MAX_LPC_ORDER);
+
+    if (order < 6) {
+        FLAC__lpc_restore_signal_wide_intrin_sse41(residual, data_len, qlp_coeff, order, lp_quantization, data);
+        return;
+    }
+
+    /* _mm256_mul_epi32() multiplies the sign-extended low halves of the 64-bit lanes */
+    for (j = 4; j < (int)order; j++)
+        coeff[j] = _mm256_set1_epi64x(qlp_coeff[j]);
+
+    for (i = 0; i + 4 <= (int)data_len; i += 4) {
+        FLAC__int64 sum[4];
+        __m256i far = _mm256_setzero_si256();
+
+        for (j = 4; j < (int)order; j++)
+            far = _mm256_add_epi64(far, _mm256_mul_epi32(coeff[j], _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(data + i - 1 - j)))));
+        _mm256_storeu_si256((__m256i*)sum, far);
+
+        sum[0] += (FLAC__int64)qlp_coeff[0] * data[i-1] + (FLAC__int64)qlp_coeff[1] * data[i-2] + (FLAC__int64)qlp_coeff[2] * data[i-3] + (FLAC__int64)qlp_coeff[3] * data[i-4];
+        data[i] = (FLAC__int32)(residual[i] + (sum[0] >> lp_quantization));
+        sum[1] += (FLAC__int64)qlp_coeff[0] * data[i] + (FLAC__int64)qlp_coeff[1] * data[i-1] + (FLAC__int64)qlp_coeff[2] * data[i-2] + (FLAC__int64)qlp_coeff[3] * data[i-3];
+        data[i+1] = (FLAC__int32)(residual[i+1] + (sum[1] >> lp_quantization));
+        sum[2] += (FLAC__int64)qlp_coeff[0] * data[i+1] + (FLAC__int64)qlp_coeff[1] * data[i] + (FLAC__int64)qlp_coeff[2] * data[i-1] + (FLAC__int64)qlp_coeff[3] * data[i-2];
+        data[i+2] = (FLAC__int32)(residual[i+2] + (sum[2] >> lp_quantization));
+        sum[3] += (FLAC__int64)qlp_coeff[0] * data[i+2] + (FLAC__int64)qlp_coeff[1] * data[i+1] + (FLAC__int64)qlp_coeff[2] * data[i] + (FLAC__int64)qlp_coeff[3] * data[i-1];
+        data[i+3] = (FLAC__int32)(residual[i+3] + (sum[3] >> lp_quantization));
+    }
+
+    if (i < (int)data_len)
+        FLAC__lpc_restore_signal_wide(residual + i, data_len - i, qlp_coeff, order, lp_quantization, data + i);
+}
+
+#undef U_
+
+#endif /* FLAC__AVX2_SUPPORTED */
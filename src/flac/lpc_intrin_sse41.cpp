@@ -0,0 +1,132 @@
+#include "private/cpu.h"
+
+#ifdef FLAC__SSE4_1_SUPPORTED
+
+#include <smmintrin.h> /* SSE4.1 */
+#include "private/lpc.h"
+#include "FLAC/assert.h"
+
+/*
+ * The restore filter is recursive, so samples can't simply be computed
+ * side by side. What can be vectorized is the part of each prediction
+ * that only looks far enough back: for a block of K consecutive samples,
+ * taps K..order-1 of all K predictions read only samples from before the
+ * block, so they are summed K lanes at a time. Taps 0..K-1 are then added
+ * one sample at a time, in order, exactly like the scalar loop.
+ *
+ * Integer addition is associative (the 32-bit path never overflows, see
+ * FLAC__lpc_max_prediction_before_shift_bps(), and the 64-bit path is
+ * exact), so the result is bit-identical to the scalar functions. On a
+ * damaged frame the 32-bit sums wrap around, in unsigned arithmetic just
+ * like the scalar code, and the frame then fails its CRC.
+ */
+
+#define U_(x) ((FLAC__uint32)(x))
+
+static inline FLAC__int32 restore_(FLAC__int32 residual, FLAC__uint32 sum, int lp_quantization)
+{
+    return (FLAC__int32)(U_(residual) + U_((FLAC__int32)sum >> lp_quantization));
+}
+
+FLAC__SSE_TARGET("sse4.1")
+void FLAC__lpc_restore_signal_intrin_sse41(const FLAC__int32 residual[], unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int32 data[])
+{
+    __m128i coeff[FLAC__MAX_LPC_ORDER];
+    int i, j;
+
+    FLAC_ASSERT(order > 0);
+    FLAC_ASSERT(order <= FLAC__MAX_LPC_ORDER);
+
+    /* no taps left for the vector part; unrolled, since the generic C loop gets vectorized across the taps */
+    if (order <= 4) {
+        const FLAC__uint32 c0 = U_(qlp_coeff[0]);
+        const FLAC__uint32 c1 = order > 1 ? U_(qlp_coeff[1]) : 0;
+        const FLAC__uint32 c2 = order > 2 ? U_(qlp_coeff[2]) : 0;
+        const FLAC__uint32 c3 = order > 3 ? U_(qlp_coeff[3]) : 0;
+        switch (order) {
+            case 4:
+                for (i = 0; i < (int)data_len; i++)
+                    data[i] = restore_(residual[i], c0 * U_(data[i-1]) + c1 * U_(data[i-2]) + c2 * U_(data[i-3]) + c3 * U_(data[i-4]), lp_quantization);
+                break;
+            case 3:
+                for (i = 0; i < (int)data_len; i++)
+                    data[i] = restore_(residual[i], c0 * U_(data[i-1]) + c1 * U_(data[i-2]) + c2 * U_(data[i-3]), lp_quantization);
+                break;
+            case 2:
+                for (i = 0; i < (int)data_len; i++)
+                    data[i] = restore_(residual[i], c0 * U_(data[i-1]) + c1 * U_(data[i-2]), lp_quantization);
+                break;
+            default:
+                for (i = 0; i < (int)data_len; i++)
+                    data[i] = restore_(residual[i], c0 * U_(data[i-1]), lp_quantization);
+                break;
+        }
+        return;
+    }
+
+    for (j = 4; j < (int)order; j++)
+        coeff[j] = _mm_set1_epi32(qlp_coeff[j]);
+
+    for (i = 0; i + 4 <= (int)data_len; i += 4) {
+        FLAC__uint32 sum[4];
+        __m128i far = _mm_setzero_si128();
+
+        /* lane k gets the taps of sample i+k that reach before sample i */
+        for (j = 4; j < (int)order; j++)
+            far = _mm_add_epi32(far, _mm_mullo_epi32(coeff[j], _mm_loadu_si128((const __m128i*)(data + i - 1 - j))));
+        _mm_storeu_si128((__m128i*)sum, far);
+
+        sum[0] += U_(qlp_coeff[0]) * U_(data[i-1]) + U_(qlp_coeff[1]) * U_(data[i-2]) + U_(qlp_coeff[2]) * U_(data[i-3]) + U_(qlp_coeff[3]) * U_(data[i-4]);
+        data[i] = restore_(residual[i], sum[0], lp_quantization);
+        sum[1] += U_(qlp_coeff[0]) * U_(data[i]) + U_(qlp_coeff[1]) * U_(data[i-1]) + U_(qlp_coeff[2]) * U_(data[i-2]) + U_(qlp_coeff[3]) * U_(data[i-3]);
+        data[i+1] = restore_(residual[i+1], sum[1], lp_quantization);
+        sum[2] += U_(qlp_coeff[0]) * U_(data[i+1]) + U_(qlp_coeff[1]) * U_(data[i]) + U_(qlp_coeff[2]) * U_(data[i-1]) + U_(qlp_coeff[3]) * U_(data[i-2]);
+        data[i+2] = restore_(residual[i+2], sum[2], lp_quantization);
+        sum[3] += U_(qlp_coeff[0]) * U_(data[i+2]) + U_(qlp_coeff[1]) * U_(data[i+1]) + U_(qlp_coeff[2]) * U_(data[i]) + U_(qlp_coeff[3]) * U_(data[i-1]);
+        data[i+3] = restore_(residual[i+3], sum[3], lp_quantization);
+    }
+
+    if (i < (int)data_len)
+        FLAC__lpc_restore_signal(residual + i, data_len - i, qlp_coeff, order, lp_quantization, data + i);
+}
+
+FLAC__SSE_TARGET("sse4.1")
+void FLAC__lpc_restore_signal_wide_intrin_sse41(const FLAC__int32 residual[], unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int32 data[])
+{
+    __m128i coeff[FLAC__MAX_LPC_ORDER];
+    int i, j;
+
+    FLAC_ASSERT(order > 0);
+    FLAC_ASSERT(order <= FLAC__MAX_LPC_ORDER);
+
+    /* with two lanes the vector part only pays off once it has a few taps */
+    if (order <= 4) {
+        FLAC__lpc_restore_signal_wide(residual, data_len, qlp_coeff, order, lp_quantization, data);
+        return;
+    }
+
+    /* _mm_mul_epi32() multiplies the sign-extended low halves of the 64-bit lanes */
+    for (j = 2; j < (int)order; j++)
+        coeff[j] = _mm_set1_epi64x(qlp_coeff[j]);
+
+    for (i = 0; i + 2 <= (int)data_len; i += 2) {
+        FLAC__int64 sum[2];
+        __m128i far = _mm_setzero_si128();
+
+        for (j = 2; j < (int)order; j++)
+            far = _mm_add_epi64(far, _mm_mul_epi32(coeff[j], _mm_cvtepi32_epi64(_mm_loadl_epi64((const __m128i*)(data + i - 1 - j)))));
+        _mm_storeu_si128((__m128i*)sum, far);
+
+        sum[0] += (FLAC__int64)qlp_coeff[0] * data[i-1] + (FLAC__int64)qlp_coeff[1] * data[i-2];
+        data[i] = (FLAC__int32)(residual[i] + (sum[0] >> lp_quantization));
+        sum[1] += (FLAC__int64)qlp_coeff[0] * data[i] + (FLAC__int64)qlp_coeff[1] * data[i-1];
+        data[i+1] = (FLAC__int32)(residual[i+1] + (sum[1] >> lp_quantization));
+    }
+
+    if (i < (int)data_len)
+        FLAC__lpc_restore_signal_wide(residual + i, data_len - i, qlp_coeff, order, lp_quantization, data + i);
+}
+
+#undef U_
+
+#endif /* FLAC__SSE4_1_SUPPORTED */
@@ -0,0 +1,254 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>     // for SIZE_MAX
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "FLAC/assert.h"
+#include "FLAC/mapped_file.h"
+#include "private/format.h"
+#include "private/frame_header.h"
+#include "private/macros.h"
+
+/***********************************************************************
+ *
+ * Private class data
+ *
+ ***********************************************************************/
+
+struct FLAC__MappedFile {
+    FLAC__byte *data;
+    size_t size;
+};
+
+struct FLAC__FrameSpanIterator {
+    const FLAC__byte *data;
+    size_t bytes;
+    size_t position; /* where the search for the next frame starts */
+    FLAC__bool has_stream_info;
+    FLAC__StreamMetadata_StreamInfo stream_info;
+};
+
+/***********************************************************************
+ *
+ * Private class method prototypes
+ *
+ ***********************************************************************/
+
+static FLAC__bool skip_metadata_(FLAC__FrameSpanIterator *iterator);
+
+/***********************************************************************
+ *
+ * Mapped file
+ *
+ ***********************************************************************/
+
+FLAC_API FLAC__MappedFile *FLAC__mapped_file_open(const char *filename, FLAC__MappedFileAccess access)
+{
+    FLAC__MappedFile *file;
+    struct stat st;
+    void *data;
+    int fd, saved_errno;
+
+    FLAC_ASSERT(0 != filename);
+
+    fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return 0;
+    if (fstat(fd, &st) != 0) {
+        saved_errno = errno;
+        close(fd);
+        errno = saved_errno;
+        return 0;
+    }
+    if ((FLAC__uint64)st.st_size > (FLAC__uint64)SIZE_MAX) {
+        close(fd);
+        errno = EFBIG;
+        return 0;
+    }
+
+    file = (FLAC__MappedFile*)calloc(1, sizeof(FLAC__MappedFile));
+    if (file == 0) {
+        close(fd);
+        errno = ENOMEM;
+        return 0;
+    }
+
+    /* mmap() refuses an empty range; an empty file is simply no data */
+    if (st.st_size > 0) {
+        data = mmap(0, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            saved_errno = errno;
+            close(fd);
+            free(file);
+            errno = saved_errno;
+            return 0;
+        }
+        file->data = (FLAC__byte*)data;
+        file->size = (size_t)st.st_size;
+
+        /* the hints are only advice, a kernel that ignores them is fine */
+        if (access == FLAC__MAPPED_FILE_ACCESS_SEQUENTIAL) {
+            (void)madvise(data, file->size, MADV_SEQUENTIAL);
+            (void)madvise(data, file->size, MADV_WILLNEED);
+        }
+        else
+            (void)madvise(data, file->size, MADV_RANDOM);
+    }
+
+    /* the mapping keeps the file referenced */
+    close(fd);
+
+    return file;
+}
+
+FLAC_API void FLAC__mapped_file_close(FLAC__MappedFile *file)
+{
+    if (file == 0)
+        return;
+
+    if (file->data != 0)
+        munmap(file->data, file->size);
+    free(file);
+}
+
+FLAC_API const FLAC__byte *FLAC__mapped_file_get_data(const FLAC__MappedFile *file)
+{
+    FLAC_ASSERT(0 != file);
+    return file->data;
+}
+
+FLAC_API size_t FLAC__mapped_file_get_size(const FLAC__MappedFile *file)
+{
+    FLAC_ASSERT(0 != file);
+    return file->size;
+}
+
+FLAC_API FLAC__bool FLAC__mapped_file_prefetch(const FLAC__MappedFile *file, FLAC__uint64 offset, FLAC__uint64 length)
+{
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start, end;
+
+    FLAC_ASSERT(0 != file);
+
+    if (offset >= file->size || length == 0)
+        return true;
+    end = (size_t)flac_min(offset + length, (FLAC__uint64)file->size);
+    /* madvise() wants a page aligned address */
+    start = (size_t)offset - (size_t)offset % page;
+
+    return madvise(file->data + start, end - start, MADV_WILLNEED) == 0;
+}
+
+/***********************************************************************
+ *
+ * Frame span iterator
+ *
+ ***********************************************************************/
+
+FLAC_API FLAC__FrameSpanIterator *FLAC__frame_span_iterator_new(void)
+{
+    return (FLAC__FrameSpanIterator*)calloc(1, sizeof(FLAC__FrameSpanIterator));
+}
+
+FLAC_API void FLAC__frame_span_iterator_delete(FLAC__FrameSpanIterator *iterator)
+{
+    free(iterator);
+}
+
+FLAC_API FLAC__bool FLAC__frame_span_iterator_init(FLAC__FrameSpanIterator *iterator, const FLAC__byte *data, size_t bytes)
+{
+    FLAC_ASSERT(0 != iterator);
+    FLAC_ASSERT(0 != data || bytes == 0);
+
+    iterator->data = data;
+    iterator->bytes = bytes;
+    iterator->position = 0;
+    iterator->has_stream_info = false;
+
+    return skip_metadata_(iterator);
+}
+
+FLAC_API const FLAC__StreamMetadata_StreamInfo *FLAC__frame_span_iterator_get_stream_info(const FLAC__FrameSpanIterator *iterator)
+{
+    FLAC_ASSERT(0 != iterator);
+    return iterator->has_stream_info ? &iterator->stream_info : 0;
+}
+
+FLAC_API FLAC__bool FLAC__frame_span_iterator_next(FLAC__FrameSpanIterator *iterator, FLAC__FrameSpan *span)
+{
+    const FLAC__StreamMetadata_StreamInfo *stream_info = iterator->has_stream_info ? &iterator->stream_info : 0;
+    FLAC__FrameLocation frame;
+    size_t start, end;
+
+    FLAC_ASSERT(0 != iterator);
+    FLAC_ASSERT(0 != span);
+
+    if (FLAC__frame_header_find_frame(iterator->data + iterator->position, iterator->bytes - iterator->position, /*final=*/true, stream_info, &frame) != FLAC__FRAME_SEARCH_FOUND) {
+        iterator->position = iterator->bytes;
+        return false;
+    }
+    start = iterator->position + frame.start;
+    end = iterator->position + frame.end;
+
+    span->data = iterator->data + start;
+    span->bytes = end - start;
+    span->offset = start;
+    span->crc_ok = frame.crc_ok;
+    span->header = frame.header;
+    span->header.number.sample_number = FLAC__frame_header_get_sample_number(&frame.header, stream_info);
+    span->header.number_type = FLAC__FRAME_NUMBER_TYPE_SAMPLE_NUMBER;
+
+    iterator->position = end;
+    return true;
+}
+
+/***********************************************************************
+ *
+ * Private class methods
+ *
+ ***********************************************************************/
+
+/*
+ * Moves past an ID3v2 tag, the "fLaC" marker and the metadata blocks,
+ * keeping STREAMINFO.
+ */
+FLAC__bool skip_metadata_(FLAC__FrameSpanIterator *iterator)
+{
+    const FLAC__byte *data = iterator->data;
+    const size_t bytes = iterator->bytes;
+    size_t p = 0;
+    FLAC__MetadataWalk walk;
+
+    FLAC__format_metadata_walk_init(&walk);
+    for (;;) {
+        switch (FLAC__format_metadata_walk(&walk, data + p, bytes - p, /*eof=*/true)) {
+            case FLAC__METADATA_WALK_ID3V2:
+            case FLAC__METADATA_WALK_MARKER:
+                p += flac_min(walk.skip, bytes - p);
+                continue;
+            case FLAC__METADATA_WALK_NO_MARKER:
+                /* maybe bare frames */
+                iterator->position = p;
+                return true;
+            case FLAC__METADATA_WALK_BLOCK:
+                break;
+            default:
+                return false;
+        }
+        if (bytes - p - FLAC__STREAM_METADATA_HEADER_LENGTH < walk.length)
+            return false;
+        if (walk.type == FLAC__METADATA_TYPE_STREAMINFO && walk.length >= FLAC__STREAM_METADATA_STREAMINFO_LENGTH) {
+            FLAC__format_unpack_streaminfo(data + p + FLAC__STREAM_METADATA_HEADER_LENGTH, &iterator->stream_info);
+            iterator->has_stream_info = true;
+        }
+        p += walk.skip;
+        if (walk.is_last)
+            break;
+    }
+
+    iterator->position = p;
+    return true;
+}
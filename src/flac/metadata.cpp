@@ -0,0 +1,1072 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>      // for SEEK_SET
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
+#include "FLAC/assert.h"
+#include "FLAC/metadata.h"
+#include "private/format.h"
+#include "private/macros.h"
+
+/***********************************************************************
+ *
+ * Private class data
+ *
+ ***********************************************************************/
+
+/* reads up to this size go through the cache, so the block headers and small bodies usually take one read */
+#define FLAC__METADATA_READ_SIZE (4096u)
+
+/* picture type, MIME type length, ..., description length, ..., width, height, depth, colors, data length */
+#define FLAC__METADATA_PICTURE_MIN_LENGTH (32u)
+
+/* the length field of a block header is 24 bits */
+#define FLAC__METADATA_MAX_BLOCK_LENGTH ((1u << 24) - 1)
+
+/* the chunks of the pread()/pwrite() copy when neither copy_file_range() nor sendfile() will do */
+#define FLAC__METADATA_COPY_SIZE (65536u)
+
+typedef enum {
+    FLAC__METADATA_SOURCE_NONE = 0,
+    FLAC__METADATA_SOURCE_FILE,
+    FLAC__METADATA_SOURCE_MAPPING,
+    FLAC__METADATA_SOURCE_STREAM
+} FLAC__MetadataSource;
+
+typedef struct {
+    unsigned type;
+    FLAC__bool is_last;
+    FLAC__uint64 offset;
+    unsigned length;
+
+    /* the body, if it is in memory: 'owned', or a slice of the mapping */
+    const FLAC__byte *data;
+    FLAC__byte *owned;
+    FLAC__bool eager; /* read with the headers, stays until the next read */
+
+    /* what FLAC__metadata_get_picture() parsed; the MIME type and the description follow each other in 'picture_strings' */
+    FLAC__bool has_picture;
+    FLAC__MetadataPicture picture;
+    char *picture_strings;
+} FLAC__MetadataBlock;
+
+struct FLAC__Metadata {
+    FLAC__MetadataSource source;
+    int fd; /* FLAC__METADATA_SOURCE_FILE, ours */
+    const FLAC__byte *mapping; /* FLAC__METADATA_SOURCE_MAPPING */
+    FLAC__IOHandle handle; /* FLAC__METADATA_SOURCE_STREAM */
+    FLAC__IOCallbacks callbacks;
+    FLAC__uint64 stream_base; /* where the stream was when the read started */
+    FLAC__bool has_size;
+    FLAC__uint64 size;
+
+    /* the last read through the cache, bytes [cache_offset, cache_offset + cache_bytes) */
+    FLAC__byte *cache;
+    FLAC__uint64 cache_offset;
+    size_t cache_bytes;
+
+    FLAC__MetadataBlock *blocks;
+    unsigned num_blocks, blocks_capacity;
+    FLAC__bool has_stream_info;
+    FLAC__StreamMetadata_StreamInfo stream_info;
+    FLAC__uint64 audio_offset;
+
+    /* FLAC__metadata_write() */
+    char *filename; /* what FLAC__metadata_read_file() read */
+    unsigned rewrite_padding;
+    FLAC__bool has_new_vorbis_comment;
+    FLAC__byte *new_vorbis_comment; /* the body to write */
+    unsigned new_vorbis_comment_length;
+};
+
+/***********************************************************************
+ *
+ * Private class method prototypes
+ *
+ ***********************************************************************/
+
+static void reset_(FLAC__Metadata *metadata);
+static void free_block_(FLAC__MetadataBlock *block);
+static FLAC__bool is_lazy_(unsigned type, unsigned length);
+static FLAC__MetadataStatus read_blocks_(FLAC__Metadata *metadata);
+static FLAC__MetadataStatus add_block_(FLAC__Metadata *metadata, unsigned type, FLAC__bool is_last, FLAC__uint64 offset, unsigned length);
+static FLAC__int64 read_at_(FLAC__Metadata *metadata, FLAC__uint64 offset, void *buffer, size_t bytes);
+static FLAC__int64 read_source_(FLAC__Metadata *metadata, FLAC__uint64 offset, void *buffer, size_t bytes);
+static FLAC__uint32 unpack_uint32_(const FLAC__byte *data);
+static void pack_header_(FLAC__byte header[FLAC__STREAM_METADATA_HEADER_LENGTH], FLAC__bool is_last, unsigned type, unsigned length);
+static FLAC__bool is_vorbis_comment_or_padding_(const FLAC__MetadataBlock *block);
+static FLAC__uint64 block_start_(const FLAC__MetadataBlock *block);
+static FLAC__uint64 block_end_(const FLAC__MetadataBlock *block);
+static FLAC__bool fits_(FLAC__uint64 room, FLAC__uint64 bytes);
+static FLAC__MetadataStatus write_in_place_(FLAC__Metadata *metadata, FLAC__bool *written);
+static FLAC__bool write_run_(FLAC__Metadata *metadata, int fd, unsigned first, unsigned last, FLAC__bool with_vorbis_comment);
+static FLAC__MetadataStatus rewrite_(FLAC__Metadata *metadata);
+static FLAC__bool write_all_(int fd, const void *buffer, size_t bytes, FLAC__uint64 *offset);
+static FLAC__bool write_zeros_(int fd, FLAC__uint64 bytes, FLAC__uint64 *offset);
+static FLAC__bool copy_range_(int in_fd, FLAC__uint64 in_offset, int out_fd, FLAC__uint64 bytes, FLAC__uint64 *out_offset);
+
+/***********************************************************************
+ *
+ * Public static class data
+ *
+ ***********************************************************************/
+
+FLAC_API const char * const FLAC__MetadataStatusString[] = {
+    "FLAC__METADATA_OK",
+    "FLAC__METADATA_NOT_FLAC",
+    "FLAC__METADATA_TRUNCATED",
+    "FLAC__METADATA_IO_ERROR",
+    "FLAC__METADATA_MEMORY_ALLOCATION_ERROR",
+    "FLAC__METADATA_NOT_A_FILE"
+};
+
+/***********************************************************************
+ *
+ * Public class constructor/destructor
+ *
+ ***********************************************************************/
+
+FLAC_API FLAC__Metadata *FLAC__metadata_new(void)
+{
+    FLAC__Metadata *metadata;
+
+    metadata = (FLAC__Metadata*)calloc(1, sizeof(FLAC__Metadata));
+    if (metadata == 0)
+        return 0;
+
+    metadata->fd = -1;
+    metadata->rewrite_padding = FLAC__METADATA_DEFAULT_REWRITE_PADDING;
+
+    return metadata;
+}
+
+FLAC_API void FLAC__metadata_delete(FLAC__Metadata *metadata)
+{
+    if (metadata == 0)
+        return;
+
+    reset_(metadata);
+    free(metadata->blocks);
+    free(metadata->cache);
+    free(metadata);
+}
+
+/***********************************************************************
+ *
+ * Public class methods
+ *
+ ***********************************************************************/
+
+FLAC_API FLAC__MetadataStatus FLAC__metadata_read_file(FLAC__Metadata *metadata, const char *filename)
+{
+    struct stat st;
+
+    FLAC_ASSERT(0 != metadata);
+    FLAC_ASSERT(0 != filename);
+
+    reset_(metadata);
+    metadata->fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (metadata->fd < 0)
+        return FLAC__METADATA_IO_ERROR;
+    metadata->source = FLAC__METADATA_SOURCE_FILE;
+    if (fstat(metadata->fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        metadata->has_size = true;
+        metadata->size = (FLAC__uint64)st.st_size;
+        /* only a regular file can be written back */
+        if ((metadata->filename = strdup(filename)) == 0) {
+            reset_(metadata);
+            return FLAC__METADATA_MEMORY_ALLOCATION_ERROR;
+        }
+    }
+    return read_blocks_(metadata);
+}
+
+FLAC_API FLAC__MetadataStatus FLAC__metadata_read_mapped_file(FLAC__Metadata *metadata, const FLAC__MappedFile *file)
+{
+    FLAC_ASSERT(0 != metadata);
+    FLAC_ASSERT(0 != file);
+
+    reset_(metadata);
+    metadata->source = FLAC__METADATA_SOURCE_MAPPING;
+    metadata->mapping = FLAC__mapped_file_get_data(file);
+    metadata->has_size = true;
+    metadata->size = FLAC__mapped_file_get_size(file);
+    return read_blocks_(metadata);
+}
+
+FLAC_API FLAC__MetadataStatus FLAC__metadata_read_stream(FLAC__Metadata *metadata, FLAC__IOHandle handle, FLAC__IOCallbacks callbacks)
+{
+    FLAC__int64 position;
+
+    FLAC_ASSERT(0 != metadata);
+    FLAC_ASSERT(0 != callbacks.read);
+    FLAC_ASSERT(0 != callbacks.seek);
+
+    reset_(metadata);
+    if (callbacks.tell != 0) {
+        if ((position = callbacks.tell(handle)) < 0)
+            return FLAC__METADATA_IO_ERROR;
+        metadata->stream_base = (FLAC__uint64)position;
+    }
+    metadata->source = FLAC__METADATA_SOURCE_STREAM;
+    metadata->handle = handle;
+    metadata->callbacks = callbacks;
+    return read_blocks_(metadata);
+}
+
+FLAC_API const FLAC__StreamMetadata_StreamInfo *FLAC__metadata_get_stream_info(const FLAC__Metadata *metadata)
+{
+    FLAC_ASSERT(0 != metadata);
+
+    return metadata->has_stream_info ? &metadata->stream_info : 0;
+}
+
+FLAC_API FLAC__uint64 FLAC__metadata_get_audio_offset(const FLAC__Metadata *metadata)
+{
+    FLAC_ASSERT(0 != metadata);
+
+    return metadata->audio_offset;
+}
+
+FLAC_API unsigned FLAC__metadata_get_num_blocks(const FLAC__Metadata *metadata)
+{
+    FLAC_ASSERT(0 != metadata);
+
+    return metadata->num_blocks;
+}
+
+FLAC_API int FLAC__metadata_find_block(const FLAC__Metadata *metadata, unsigned type, unsigned start)
+{
+    unsigned i;
+
+    FLAC_ASSERT(0 != metadata);
+
+    for (i = start; i < metadata->num_blocks; i++) {
+        if (metadata->blocks[i].type == type)
+            return (int)i;
+    }
+    return -1;
+}
+
+FLAC_API FLAC__bool FLAC__metadata_get_block_info(const FLAC__Metadata *metadata, unsigned index, FLAC__MetadataBlockInfo *info)
+{
+    const FLAC__MetadataBlock *block;
+
+    FLAC_ASSERT(0 != metadata);
+    FLAC_ASSERT(0 != info);
+
+    if (index >= metadata->num_blocks)
+        return false;
+    block = &metadata->blocks[index];
+    info->type = block->type;
+    info->is_last = block->is_last;
+    info->offset = block->offset;
+    info->length = block->length;
+    info->loaded = block->data != 0;
+    return true;
+}
+
+FLAC_API const FLAC__byte *FLAC__metadata_get_block_data(FLAC__Metadata *metadata, unsigned index)
+{
+    FLAC__MetadataBlock *block;
+
+    FLAC_ASSERT(0 != metadata);
+
+    if (index >= metadata->num_blocks)
+        return 0;
+    block = &metadata->blocks[index];
+    if (block->data != 0)
+        return block->data;
+
+    /* malloc(0) may give NULL, which would read as a failure */
+    block->owned = (FLAC__byte*)malloc(flac_max(block->length, 1u));
+    if (block->owned == 0)
+        return 0;
+    if (read_at_(metadata, block->offset, block->owned, block->length) != (FLAC__int64)block->length) {
+        free(block->owned);
+        block->owned = 0;
+        return 0;
+    }
+    block->data = block->owned;
+    return block->data;
+}
+
+FLAC_API void FLAC__metadata_release_block_data(FLAC__Metadata *metadata, unsigned index)
+{
+    FLAC__MetadataBlock *block;
+
+    FLAC_ASSERT(0 != metadata);
+
+    if (index >= metadata->num_blocks)
+        return;
+    block = &metadata->blocks[index];
+    if (block->eager || metadata->source == FLAC__METADATA_SOURCE_MAPPING)
+        return;
+    free(block->owned);
+    block->owned = 0;
+    block->data = 0;
+}
+
+FLAC_API FLAC__bool FLAC__metadata_read_block(FLAC__Metadata *metadata, unsigned index, unsigned offset, void *buffer, size_t bytes)
+{
+    const FLAC__MetadataBlock *block;
+
+    FLAC_ASSERT(0 != metadata);
+    FLAC_ASSERT(0 != buffer || bytes == 0);
+
+    if (index >= metadata->num_blocks)
+        return false;
+    block = &metadata->blocks[index];
+    if (offset > block->length || bytes > block->length - offset)
+        return false;
+    if (block->data != 0) {
+        memcpy(buffer, block->data + offset, bytes);
+        return true;
+    }
+    return read_at_(metadata, block->offset + offset, buffer, bytes) == (FLAC__int64)bytes;
+}
+
+FLAC_API FLAC__bool FLAC__metadata_get_picture(FLAC__Metadata *metadata, unsigned index, FLAC__MetadataPicture *picture)
+{
+    FLAC__MetadataBlock *block;
+    FLAC__byte field[20];
+    FLAC__uint32 mime_type_length, description_length;
+    unsigned position;
+    char *strings;
+
+    FLAC_ASSERT(0 != metadata);
+    FLAC_ASSERT(0 != picture);
+
+    if (index >= metadata->num_blocks)
+        return false;
+    block = &metadata->blocks[index];
+    if (block->type != FLAC__METADATA_TYPE_PICTURE)
+        return false;
+    if (block->has_picture) {
+        *picture = block->picture;
+        return true;
+    }
+
+    /*
+     * Field by field, so only the fields are read and not the data; a
+     * picture with the usual short strings has them all in the first
+     * read through the cache.
+     */
+    if (block->length < FLAC__METADATA_PICTURE_MIN_LENGTH || !FLAC__metadata_read_block(metadata, index, 0, field, 8))
+        return false;
+    block->picture.type = unpack_uint32_(field);
+    mime_type_length = unpack_uint32_(field + 4);
+    position = 8;
+    if (mime_type_length > block->length - FLAC__METADATA_PICTURE_MIN_LENGTH)
+        return false;
+    if (!FLAC__metadata_read_block(metadata, index, position + mime_type_length, field, 4))
+        return false;
+    description_length = unpack_uint32_(field);
+    if (description_length > block->length - FLAC__METADATA_PICTURE_MIN_LENGTH - mime_type_length)
+        return false;
+
+    strings = (char*)malloc((size_t)mime_type_length + description_length + 2);
+    if (strings == 0)
+        return false;
+    if (!FLAC__metadata_read_block(metadata, index, position, strings, mime_type_length) ||
+        !FLAC__metadata_read_block(metadata, index, position + mime_type_length + 4, strings + mime_type_length + 1, description_length)) {
+        free(strings);
+        return false;
+    }
+    strings[mime_type_length] = '\0';
+    strings[mime_type_length + 1 + description_length] = '\0';
+    position += mime_type_length + 4 + description_length;
+
+    if (!FLAC__metadata_read_block(metadata, index, position, field, 20)) {
+        free(strings);
+        return false;
+    }
+    position += 20;
+    block->picture.width = unpack_uint32_(field);
+    block->picture.height = unpack_uint32_(field + 4);
+    block->picture.depth = unpack_uint32_(field + 8);
+    block->picture.colors = unpack_uint32_(field + 12);
+    block->picture.data_length = unpack_uint32_(field + 16);
+    if (block->picture.data_length > block->length - position) {
+        free(strings);
+        return false;
+    }
+    block->picture.data_offset = block->offset + position;
+    block->picture.mime_type = strings;
+    block->picture.description = strings + mime_type_length + 1;
+    block->picture_strings = strings;
+    block->has_picture = true;
+
+    *picture = block->picture;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__metadata_set_vorbis_comment(FLAC__Metadata *metadata, const char *vendor_string, const char * const entries[], unsigned num_entries)
+{
+    const FLAC__byte *vendor = (const FLAC__byte*)vendor_string, *data;
+    FLAC__uint64 length;
+    size_t vendor_length = 0, entry_length;
+    FLAC__byte *body, *p;
+    unsigned i;
+    int index;
+
+    FLAC_ASSERT(0 != metadata);
+    FLAC_ASSERT(0 != entries || num_entries == 0);
+
+    if (vendor_string != 0)
+        vendor_length = strlen(vendor_string);
+    else if ((index = FLAC__metadata_find_block(metadata, FLAC__METADATA_TYPE_VORBIS_COMMENT, 0)) >= 0) {
+        /* keep the file's vendor string, if it can be made out */
+        data = FLAC__metadata_get_block_data(metadata, (unsigned)index);
+        if (data == 0)
+            return false;
+        if (metadata->blocks[index].length >= 4) {
+            vendor_length = ((size_t)data[3] << 24) | ((size_t)data[2] << 16) | ((size_t)data[1] << 8) | (size_t)data[0];
+            if (vendor_length <= metadata->blocks[index].length - 4)
+                vendor = data + 4;
+            else
+                vendor_length = 0;
+        }
+    }
+
+    length = 4 + (FLAC__uint64)vendor_length + 4;
+    for (i = 0; i < num_entries; i++)
+        length += 4 + (FLAC__uint64)strlen(entries[i]);
+    if (length > FLAC__METADATA_MAX_BLOCK_LENGTH)
+        return false;
+
+    body = (FLAC__byte*)malloc((size_t)length);
+    if (body == 0)
+        return false;
+    p = body;
+#define PACK_LE32_(x) (p[0] = (FLAC__byte)(x), p[1] = (FLAC__byte)((x) >> 8), p[2] = (FLAC__byte)((x) >> 16), p[3] = (FLAC__byte)((x) >> 24), p += 4)
+    PACK_LE32_(vendor_length);
+    if (vendor_length > 0)
+        memcpy(p, vendor, vendor_length);
+    p += vendor_length;
+    PACK_LE32_(num_entries);
+    for (i = 0; i < num_entries; i++) {
+        entry_length = strlen(entries[i]);
+        PACK_LE32_(entry_length);
+        memcpy(p, entries[i], entry_length);
+        p += entry_length;
+    }
+#undef PACK_LE32_
+    FLAC_ASSERT(p == body + length);
+
+    free(metadata->new_vorbis_comment);
+    metadata->new_vorbis_comment = body;
+    metadata->new_vorbis_comment_length = (unsigned)length;
+    metadata->has_new_vorbis_comment = true;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__metadata_set_rewrite_padding(FLAC__Metadata *metadata, unsigned value)
+{
+    FLAC_ASSERT(0 != metadata);
+
+    if (value > FLAC__METADATA_MAX_BLOCK_LENGTH)
+        return false;
+    metadata->rewrite_padding = value;
+    return true;
+}
+
+FLAC_API FLAC__MetadataStatus FLAC__metadata_write(FLAC__Metadata *metadata, FLAC__bool *rewritten)
+{
+    FLAC__MetadataStatus status;
+    FLAC__bool written = false;
+    char *filename;
+
+    FLAC_ASSERT(0 != metadata);
+
+    if (rewritten != 0)
+        *rewritten = false;
+    if (metadata->source != FLAC__METADATA_SOURCE_FILE || metadata->filename == 0 || metadata->num_blocks == 0)
+        return FLAC__METADATA_NOT_A_FILE;
+    if (!metadata->has_new_vorbis_comment)
+        return FLAC__METADATA_OK;
+
+    status = write_in_place_(metadata, &written);
+    if (status == FLAC__METADATA_OK && !written) {
+        status = rewrite_(metadata);
+        written = status == FLAC__METADATA_OK;
+        if (rewritten != 0)
+            *rewritten = written;
+    }
+    if (!written)
+        return status;
+
+    /* what was read is stale now; the read drops the file name with the rest, so it is taken out first */
+    filename = metadata->filename;
+    metadata->filename = 0;
+    if (status == FLAC__METADATA_OK)
+        status = FLAC__metadata_read_file(metadata, filename);
+    else
+        (void)FLAC__metadata_read_file(metadata, filename);
+    free(filename);
+    return status;
+}
+
+/***********************************************************************
+ *
+ * Private class methods
+ *
+ ***********************************************************************/
+
+/* drops the blocks and lets go of the source */
+void reset_(FLAC__Metadata *metadata)
+{
+    unsigned i;
+
+    for (i = 0; i < metadata->num_blocks; i++)
+        free_block_(&metadata->blocks[i]);
+    metadata->num_blocks = 0;
+    free(metadata->filename);
+    metadata->filename = 0;
+    free(metadata->new_vorbis_comment);
+    metadata->new_vorbis_comment = 0;
+    metadata->new_vorbis_comment_length = 0;
+    metadata->has_new_vorbis_comment = false;
+    if (metadata->fd >= 0)
+        close(metadata->fd);
+    metadata->fd = -1;
+    metadata->source = FLAC__METADATA_SOURCE_NONE;
+    metadata->mapping = 0;
+    metadata->handle = 0;
+    memset(&metadata->callbacks, 0, sizeof(metadata->callbacks));
+    metadata->stream_base = 0;
+    metadata->has_size = false;
+    metadata->size = 0;
+    metadata->cache_offset = 0;
+    metadata->cache_bytes = 0;
+    metadata->has_stream_info = false;
+    metadata->audio_offset = 0;
+}
+
+void free_block_(FLAC__MetadataBlock *block)
+{
+    free(block->owned);
+    free(block->picture_strings);
+    memset(block, 0, sizeof(*block));
+}
+
+/* the blocks that are only read when asked for: artwork, padding, whatever an application keeps, and anything large */
+FLAC__bool is_lazy_(unsigned type, unsigned length)
+{
+    return type == FLAC__METADATA_TYPE_PICTURE || type == FLAC__METADATA_TYPE_PADDING || type == FLAC__METADATA_TYPE_APPLICATION ||
+        length > FLAC__METADATA_EAGER_MAX_LENGTH;
+}
+
+/* walks the block headers from the start of the source */
+FLAC__MetadataStatus read_blocks_(FLAC__Metadata *metadata)
+{
+    FLAC__byte header[FLAC__ID3V2_HEADER_LENGTH];
+    FLAC__MetadataStatus status = FLAC__METADATA_OK;
+    FLAC__MetadataWalk walk;
+    FLAC__uint64 position = 0;
+    FLAC__int64 got;
+
+    if (metadata->source != FLAC__METADATA_SOURCE_MAPPING && metadata->cache == 0) {
+        metadata->cache = (FLAC__byte*)malloc(FLAC__METADATA_READ_SIZE);
+        if (metadata->cache == 0) {
+            reset_(metadata);
+            return FLAC__METADATA_MEMORY_ALLOCATION_ERROR;
+        }
+    }
+
+    FLAC__format_metadata_walk_init(&walk);
+    while (status == FLAC__METADATA_OK) {
+        /* enough for anything the walk asks for, so a short read is the end of the source */
+        got = read_at_(metadata, position, header, sizeof(header));
+        if (got < 0) {
+            status = FLAC__METADATA_IO_ERROR;
+            break;
+        }
+        switch (FLAC__format_metadata_walk(&walk, header, (size_t)got, /*eof=*/got < (FLAC__int64)sizeof(header))) {
+            case FLAC__METADATA_WALK_ID3V2:
+            case FLAC__METADATA_WALK_MARKER:
+                position += walk.skip;
+                continue;
+            case FLAC__METADATA_WALK_BLOCK:
+                status = add_block_(metadata, walk.type, walk.is_last, position + FLAC__STREAM_METADATA_HEADER_LENGTH, walk.length);
+                position += walk.skip;
+                break;
+            case FLAC__METADATA_WALK_TRUNCATED:
+                status = FLAC__METADATA_TRUNCATED;
+                break;
+            default:
+                status = FLAC__METADATA_NOT_FLAC;
+                break;
+        }
+        if (walk.is_last)
+            break;
+    }
+
+    if (status == FLAC__METADATA_OK && !metadata->has_stream_info)
+        status = FLAC__METADATA_NOT_FLAC;
+    if (status != FLAC__METADATA_OK) {
+        reset_(metadata);
+        return status;
+    }
+    metadata->audio_offset = position;
+    return FLAC__METADATA_OK;
+}
+
+FLAC__MetadataStatus add_block_(FLAC__Metadata *metadata, unsigned type, FLAC__bool is_last, FLAC__uint64 offset, unsigned length)
+{
+    FLAC__MetadataBlock *block;
+    FLAC__int64 got;
+
+    if (metadata->has_size && (offset > metadata->size || length > metadata->size - offset))
+        return FLAC__METADATA_TRUNCATED;
+    if (type == FLAC__METADATA_TYPE_STREAMINFO && length < FLAC__STREAM_METADATA_STREAMINFO_LENGTH)
+        return FLAC__METADATA_NOT_FLAC;
+
+    if (metadata->num_blocks == metadata->blocks_capacity) {
+        const unsigned capacity = metadata->blocks_capacity == 0 ? 8 : metadata->blocks_capacity * 2;
+        FLAC__MetadataBlock *blocks = (FLAC__MetadataBlock*)realloc(metadata->blocks, sizeof(FLAC__MetadataBlock) * capacity);
+        if (blocks == 0)
+            return FLAC__METADATA_MEMORY_ALLOCATION_ERROR;
+        metadata->blocks = blocks;
+        metadata->blocks_capacity = capacity;
+    }
+    block = &metadata->blocks[metadata->num_blocks++];
+    memset(block, 0, sizeof(*block));
+    block->type = type;
+    block->is_last = is_last;
+    block->offset = offset;
+    block->length = length;
+
+    if (metadata->source == FLAC__METADATA_SOURCE_MAPPING) {
+        /* a slice costs nothing, lazy or not */
+        block->data = metadata->mapping + offset;
+        block->eager = true;
+    }
+    else if (!is_lazy_(type, length)) {
+        block->owned = (FLAC__byte*)malloc(flac_max(length, 1u));
+        if (block->owned == 0)
+            return FLAC__METADATA_MEMORY_ALLOCATION_ERROR;
+        got = read_at_(metadata, offset, block->owned, length);
+        if (got < 0)
+            return FLAC__METADATA_IO_ERROR;
+        if (got != (FLAC__int64)length)
+            return FLAC__METADATA_TRUNCATED;
+        block->data = block->owned;
+        block->eager = true;
+    }
+
+    /* the first STREAMINFO counts, as in the decoder; one that is too long to be read eagerly is still unpacked */
+    if (type == FLAC__METADATA_TYPE_STREAMINFO && !metadata->has_stream_info) {
+        if (block->data != 0)
+            FLAC__format_unpack_streaminfo(block->data, &metadata->stream_info);
+        else {
+            FLAC__byte stream_info[FLAC__STREAM_METADATA_STREAMINFO_LENGTH];
+            got = read_at_(metadata, offset, stream_info, sizeof(stream_info));
+            if (got < 0)
+                return FLAC__METADATA_IO_ERROR;
+            if (got != (FLAC__int64)sizeof(stream_info))
+                return FLAC__METADATA_TRUNCATED;
+            FLAC__format_unpack_streaminfo(stream_info, &metadata->stream_info);
+        }
+        metadata->has_stream_info = true;
+    }
+    return FLAC__METADATA_OK;
+}
+
+/*
+ * Reads 'bytes' bytes at 'offset', fewer if the source ends first.
+ * Returns how many it got, or -1 on a read error. Small reads are served
+ * from the cache, which is refilled with FLAC__METADATA_READ_SIZE bytes
+ * at 'offset' when they are not in it; large ones go straight to the
+ * caller's buffer.
+ */
+FLAC__int64 read_at_(FLAC__Metadata *metadata, FLAC__uint64 offset, void *buffer, size_t bytes)
+{
+    FLAC__int64 got;
+    size_t available;
+
+    if (metadata->source == FLAC__METADATA_SOURCE_MAPPING) {
+        if (offset >= metadata->size)
+            return 0;
+        bytes = (size_t)flac_min((FLAC__uint64)bytes, metadata->size - offset);
+        memcpy(buffer, metadata->mapping + offset, bytes);
+        return (FLAC__int64)bytes;
+    }
+    if (bytes > FLAC__METADATA_READ_SIZE)
+        return read_source_(metadata, offset, buffer, bytes);
+
+    if (offset < metadata->cache_offset || offset + bytes > metadata->cache_offset + metadata->cache_bytes) {
+        metadata->cache_bytes = 0;
+        got = read_source_(metadata, offset, metadata->cache, FLAC__METADATA_READ_SIZE);
+        if (got < 0)
+            return -1;
+        metadata->cache_offset = offset;
+        metadata->cache_bytes = (size_t)got;
+    }
+    available = offset >= metadata->cache_offset + metadata->cache_bytes ? 0 : (size_t)(metadata->cache_offset + metadata->cache_bytes - offset);
+    bytes = flac_min(bytes, available);
+    memcpy(buffer, metadata->cache + (size_t)(offset - metadata->cache_offset), bytes);
+    return (FLAC__int64)bytes;
+}
+
+/* reads straight from the file or the stream, until 'bytes' or the end */
+FLAC__int64 read_source_(FLAC__Metadata *metadata, FLAC__uint64 offset, void *buffer, size_t bytes)
+{
+    FLAC__byte *p = (FLAC__byte*)buffer;
+    size_t done = 0;
+    ssize_t got;
+    size_t count;
+
+    if (metadata->source == FLAC__METADATA_SOURCE_FILE) {
+        while (done < bytes) {
+            got = pread(metadata->fd, p + done, bytes - done, (off_t)(offset + done));
+            if (got < 0 && errno == EINTR)
+                continue;
+            if (got < 0)
+                return -1;
+            if (got == 0)
+                break;
+            done += (size_t)got;
+        }
+        return (FLAC__int64)done;
+    }
+
+    FLAC_ASSERT(metadata->source == FLAC__METADATA_SOURCE_STREAM);
+    if (metadata->callbacks.seek(metadata->handle, (FLAC__int64)(metadata->stream_base + offset), SEEK_SET) != 0)
+        return -1;
+    while (done < bytes) {
+        count = metadata->callbacks.read(p + done, 1, bytes - done, metadata->handle);
+        if (count == 0)
+            break;
+        done += count;
+    }
+    return (FLAC__int64)done;
+}
+
+FLAC__uint32 unpack_uint32_(const FLAC__byte *data)
+{
+    return ((FLAC__uint32)data[0] << 24) | ((FLAC__uint32)data[1] << 16) | ((FLAC__uint32)data[2] << 8) | (FLAC__uint32)data[3];
+}
+
+void pack_header_(FLAC__byte header[FLAC__STREAM_METADATA_HEADER_LENGTH], FLAC__bool is_last, unsigned type, unsigned length)
+{
+    FLAC_ASSERT(length <= FLAC__METADATA_MAX_BLOCK_LENGTH);
+
+    header[0] = (FLAC__byte)((is_last ? 0x80 : 0) | type);
+    header[1] = (FLAC__byte)(length >> 16);
+    header[2] = (FLAC__byte)(length >> 8);
+    header[3] = (FLAC__byte)length;
+}
+
+FLAC__bool is_vorbis_comment_or_padding_(const FLAC__MetadataBlock *block)
+{
+    return block->type == FLAC__METADATA_TYPE_VORBIS_COMMENT || block->type == FLAC__METADATA_TYPE_PADDING;
+}
+
+/* where the block's header starts */
+FLAC__uint64 block_start_(const FLAC__MetadataBlock *block)
+{
+    return block->offset - FLAC__STREAM_METADATA_HEADER_LENGTH;
+}
+
+FLAC__uint64 block_end_(const FLAC__MetadataBlock *block)
+{
+    return block->offset + block->length;
+}
+
+/* a block of 'bytes' bytes, header and all, fills 'room' exactly or leaves enough for the header of a PADDING block */
+FLAC__bool fits_(FLAC__uint64 room, FLAC__uint64 bytes)
+{
+    return room == bytes || room >= bytes + FLAC__STREAM_METADATA_HEADER_LENGTH;
+}
+
+/*
+ * Looks at the runs of VORBIS_COMMENT and PADDING blocks that follow one
+ * another; nothing else has to move to lay out such a run anew. The new
+ * VORBIS_COMMENT goes into the run of the old one if it fits there, else
+ * into the first run it fits in, and the run of the old one becomes all
+ * PADDING. Sets 'written' to false, and returns FLAC__METADATA_OK, if it
+ * fits nowhere.
+ */
+FLAC__MetadataStatus write_in_place_(FLAC__Metadata *metadata, FLAC__bool *written)
+{
+    const FLAC__uint64 bytes = FLAC__STREAM_METADATA_HEADER_LENGTH + (FLAC__uint64)metadata->new_vorbis_comment_length;
+    const int vorbis_comment = FLAC__metadata_find_block(metadata, FLAC__METADATA_TYPE_VORBIS_COMMENT, 0);
+    unsigned first, last, target_first = 0, target_last = 0, old_first = 0, old_last = 0;
+    FLAC__bool found = false, ok;
+    FLAC__uint64 room;
+    int fd;
+
+    *written = false;
+    for (first = 0; first < metadata->num_blocks; first = last + 1) {
+        last = first;
+        if (!is_vorbis_comment_or_padding_(&metadata->blocks[first]))
+            continue;
+        while (last + 1 < metadata->num_blocks && is_vorbis_comment_or_padding_(&metadata->blocks[last + 1]))
+            last++;
+        room = block_end_(&metadata->blocks[last]) - block_start_(&metadata->blocks[first]);
+
+        if (vorbis_comment >= 0 && (unsigned)vorbis_comment >= first && (unsigned)vorbis_comment <= last) {
+            old_first = first;
+            old_last = last;
+            /* its own place beats any other */
+            if (fits_(room, bytes)) {
+                target_first = first;
+                target_last = last;
+                found = true;
+                break;
+            }
+        }
+        else if (!found && fits_(room, bytes)) {
+            target_first = first;
+            target_last = last;
+            found = true;
+        }
+    }
+    if (!found)
+        return FLAC__METADATA_OK;
+
+    fd = open(metadata->filename, O_WRONLY | O_CLOEXEC);
+    if (fd < 0)
+        return FLAC__METADATA_IO_ERROR;
+    *written = true;
+    /* the new block goes in before the old one becomes PADDING; in between the old one comes first and wins */
+    ok = write_run_(metadata, fd, target_first, target_last, /*with_vorbis_comment=*/true);
+    if (ok && vorbis_comment >= 0 && old_first != target_first)
+        ok = write_run_(metadata, fd, old_first, old_last, /*with_vorbis_comment=*/false);
+    if (close(fd) != 0)
+        ok = false;
+    return ok ? FLAC__METADATA_OK : FLAC__METADATA_IO_ERROR;
+}
+
+/*
+ * Lays out the run of blocks first..last anew: the new VORBIS_COMMENT if
+ * asked for, then PADDING up to the end of the run. Only the bytes of the
+ * new PADDING that were not PADDING before are zeroed; the rest is zero
+ * already.
+ */
+FLAC__bool write_run_(FLAC__Metadata *metadata, int fd, unsigned first, unsigned last, FLAC__bool with_vorbis_comment)
+{
+    const FLAC__bool is_last = metadata->blocks[last].is_last;
+    const FLAC__uint64 end = block_end_(&metadata->blocks[last]);
+    FLAC__byte header[FLAC__STREAM_METADATA_HEADER_LENGTH];
+    FLAC__uint64 position = block_start_(&metadata->blocks[first]), body_end, length;
+    unsigned i;
+
+    if (with_vorbis_comment) {
+        body_end = position + FLAC__STREAM_METADATA_HEADER_LENGTH + metadata->new_vorbis_comment_length;
+        pack_header_(header, is_last && body_end == end, FLAC__METADATA_TYPE_VORBIS_COMMENT, metadata->new_vorbis_comment_length);
+        if (!write_all_(fd, header, sizeof(header), &position) || !write_all_(fd, metadata->new_vorbis_comment, metadata->new_vorbis_comment_length, &position))
+            return false;
+    }
+
+    while (position < end) {
+        FLAC_ASSERT(end - position >= FLAC__STREAM_METADATA_HEADER_LENGTH);
+        length = flac_min(end - position - FLAC__STREAM_METADATA_HEADER_LENGTH, (FLAC__uint64)FLAC__METADATA_MAX_BLOCK_LENGTH);
+        body_end = position + FLAC__STREAM_METADATA_HEADER_LENGTH + length;
+        /* more than one block's worth: leave room for the next header */
+        if (body_end < end && end - body_end < FLAC__STREAM_METADATA_HEADER_LENGTH) {
+            length -= FLAC__STREAM_METADATA_HEADER_LENGTH;
+            body_end -= FLAC__STREAM_METADATA_HEADER_LENGTH;
+        }
+        pack_header_(header, is_last && body_end == end, FLAC__METADATA_TYPE_PADDING, (unsigned)length);
+        if (!write_all_(fd, header, sizeof(header), &position))
+            return false;
+
+        /* zero up to each old PADDING body and skip over it; they are in order and do not overlap */
+        for (i = first; i <= last && position < body_end; i++) {
+            const FLAC__MetadataBlock *block = &metadata->blocks[i];
+            if (block->type != FLAC__METADATA_TYPE_PADDING || block_end_(block) <= position)
+                continue;
+            if (block->offset > position && !write_zeros_(fd, flac_min(block->offset, body_end) - position, &position))
+                return false;
+            position = flac_max(position, flac_min(block_end_(block), body_end));
+        }
+        if (position < body_end && !write_zeros_(fd, body_end - position, &position))
+            return false;
+    }
+    return true;
+}
+
+/*
+ * Writes the file anew into a temporary file next to it and renames that
+ * over it: the blocks but PADDING and the old VORBIS_COMMENT, the new
+ * VORBIS_COMMENT where the old one was (or after the first block), then
+ * the new PADDING. The blocks that stay and the audio are copied from
+ * file to file by the kernel.
+ */
+FLAC__MetadataStatus rewrite_(FLAC__Metadata *metadata)
+{
+    const int vorbis_comment = FLAC__metadata_find_block(metadata, FLAC__METADATA_TYPE_VORBIS_COMMENT, 0);
+    const unsigned padding = metadata->rewrite_padding;
+    FLAC__byte header[FLAC__STREAM_METADATA_HEADER_LENGTH];
+    FLAC__uint64 position = 0;
+    FLAC__bool ok;
+    unsigned i, blocks = vorbis_comment < 0 ? 1 : 0, written_blocks = 0;
+    struct stat st;
+    char *temporary;
+    int fd;
+
+    if (!metadata->has_size || fstat(metadata->fd, &st) != 0)
+        return FLAC__METADATA_IO_ERROR;
+    /* a second VORBIS_COMMENT is dropped, there may only be one */
+    for (i = 0; i < metadata->num_blocks; i++) {
+        if (metadata->blocks[i].type != FLAC__METADATA_TYPE_PADDING && (metadata->blocks[i].type != FLAC__METADATA_TYPE_VORBIS_COMMENT || (int)i == vorbis_comment))
+            blocks++;
+    }
+
+    temporary = (char*)malloc(strlen(metadata->filename) + sizeof(".XXXXXX"));
+    if (temporary == 0)
+        return FLAC__METADATA_MEMORY_ALLOCATION_ERROR;
+    strcpy(temporary, metadata->filename);
+    strcat(temporary, ".XXXXXX");
+    fd = mkostemp(temporary, O_CLOEXEC);
+    if (fd < 0) {
+        free(temporary);
+        return FLAC__METADATA_IO_ERROR;
+    }
+
+    /* whatever is before the first block: an ID3v2 tag, the marker */
+    ok = fchmod(fd, st.st_mode & 07777) == 0 && copy_range_(metadata->fd, 0, fd, block_start_(&metadata->blocks[0]), &position);
+
+    for (i = 0; ok && i < metadata->num_blocks; i++) {
+        const FLAC__MetadataBlock *block = &metadata->blocks[i];
+        if (block->type == FLAC__METADATA_TYPE_PADDING || (block->type == FLAC__METADATA_TYPE_VORBIS_COMMENT && (int)i != vorbis_comment))
+            continue;
+        if ((int)i == vorbis_comment) {
+            pack_header_(header, ++written_blocks == blocks && padding == 0, FLAC__METADATA_TYPE_VORBIS_COMMENT, metadata->new_vorbis_comment_length);
+            ok = write_all_(fd, header, sizeof(header), &position) && write_all_(fd, metadata->new_vorbis_comment, metadata->new_vorbis_comment_length, &position);
+            continue;
+        }
+        pack_header_(header, ++written_blocks == blocks && padding == 0, block->type, block->length);
+        ok = write_all_(fd, header, sizeof(header), &position) && copy_range_(metadata->fd, block->offset, fd, block->length, &position);
+        if (ok && i == 0 && vorbis_comment < 0) {
+            pack_header_(header, ++written_blocks == blocks && padding == 0, FLAC__METADATA_TYPE_VORBIS_COMMENT, metadata->new_vorbis_comment_length);
+            ok = write_all_(fd, header, sizeof(header), &position) && write_all_(fd, metadata->new_vorbis_comment, metadata->new_vorbis_comment_length, &position);
+        }
+    }
+    if (ok && padding > 0) {
+        pack_header_(header, /*is_last=*/true, FLAC__METADATA_TYPE_PADDING, padding);
+        ok = write_all_(fd, header, sizeof(header), &position) && write_zeros_(fd, padding, &position);
+    }
+    ok = ok && copy_range_(metadata->fd, metadata->audio_offset, fd, metadata->size - metadata->audio_offset, &position) && fdatasync(fd) == 0;
+
+    if (close(fd) != 0)
+        ok = false;
+    if (ok && rename(temporary, metadata->filename) != 0)
+        ok = false;
+    if (!ok)
+        (void)unlink(temporary);
+    free(temporary);
+    return ok ? FLAC__METADATA_OK : FLAC__METADATA_IO_ERROR;
+}
+
+FLAC__bool write_all_(int fd, const void *buffer, size_t bytes, FLAC__uint64 *offset)
+{
+    const FLAC__byte *p = (const FLAC__byte*)buffer;
+    ssize_t got;
+
+    while (bytes > 0) {
+        got = pwrite(fd, p, bytes, (off_t)*offset);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0)
+            return false;
+        p += got;
+        bytes -= (size_t)got;
+        *offset += (FLAC__uint64)got;
+    }
+    return true;
+}
+
+FLAC__bool write_zeros_(int fd, FLAC__uint64 bytes, FLAC__uint64 *offset)
+{
+    static const FLAC__byte zeros[4096] = { 0 };
+    size_t chunk;
+
+    while (bytes > 0) {
+        chunk = (size_t)flac_min(bytes, (FLAC__uint64)sizeof(zeros));
+        if (!write_all_(fd, zeros, chunk, offset))
+            return false;
+        bytes -= chunk;
+    }
+    return true;
+}
+
+/*
+ * Copies 'bytes' bytes from in_fd at in_offset to out_fd at *out_offset.
+ * copy_file_range() keeps the bytes in the kernel, and on file systems
+ * that share extents does not copy them at all; sendfile() takes over
+ * where it is refused (before 5.3 across file systems, some network file
+ * systems). Only if both refuse are the bytes copied with pread() and
+ * pwrite().
+ */
+FLAC__bool copy_range_(int in_fd, FLAC__uint64 in_offset, int out_fd, FLAC__uint64 bytes, FLAC__uint64 *out_offset)
+{
+    FLAC__byte *buffer;
+    ssize_t got;
+
+#if defined(__linux__)
+    loff_t in = (loff_t)in_offset, out = (loff_t)*out_offset;
+    off_t in_position;
+    FLAC__bool refused = false;
+
+    while (bytes > 0 && !refused) {
+        got = copy_file_range(in_fd, &in, out_fd, &out, (size_t)flac_min(bytes, (FLAC__uint64)0x40000000u), 0);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP))
+            refused = true;
+        else if (got <= 0) /* an error, or the file is shorter than it was */
+            return false;
+        else
+            bytes -= (FLAC__uint64)got;
+    }
+    in_offset = (FLAC__uint64)in;
+    *out_offset = (FLAC__uint64)out;
+
+    /* sendfile() writes at the file position of out_fd */
+    if (bytes > 0 && lseek(out_fd, (off_t)*out_offset, SEEK_SET) >= 0) {
+        in_position = (off_t)in_offset;
+        refused = false;
+        while (bytes > 0 && !refused) {
+            got = sendfile(out_fd, in_fd, &in_position, (size_t)flac_min(bytes, (FLAC__uint64)0x40000000u));
+            if (got < 0 && errno == EINTR)
+                continue;
+            if (got < 0 && (errno == EINVAL || errno == ENOSYS))
+                refused = true;
+            else if (got <= 0)
+                return false;
+            else {
+                bytes -= (FLAC__uint64)got;
+                *out_offset += (FLAC__uint64)got;
+            }
+        }
+        in_offset = (FLAC__uint64)in_position;
+    }
+    if (bytes == 0)
+        return true;
+#endif
+
+    buffer = (FLAC__byte*)malloc(FLAC__METADATA_COPY_SIZE);
+    if (buffer == 0)
+        return false;
+    while (bytes > 0) {
+        got = pread(in_fd, buffer, (size_t)flac_min(bytes, (FLAC__uint64)FLAC__METADATA_COPY_SIZE), (off_t)in_offset);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0 || !write_all_(out_fd, buffer, (size_t)got, out_offset)) {
+            free(buffer);
+            return false;
+        }
+        in_offset += (FLAC__uint64)got;
+        bytes -= (FLAC__uint64)got;
+    }
+    free(buffer);
+    return true;
+}
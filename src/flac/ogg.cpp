@@ -0,0 +1,186 @@
+#include <stdlib.h>
+#include <string.h>
+#include "FLAC/assert.h"
+#include "private/dispatch.h"
+#include "private/macros.h"
+#include "private/ogg.h"
+
+static const FLAC__byte capture_pattern_[4] = { 'O', 'g', 'g', 'S' };
+static const FLAC__byte mapping_packet_type_[5] = { 0x7f, 'F', 'L', 'A', 'C' };
+
+/* where the CRC-32 goes in the page header */
+enum { CHECKSUM_OFFSET_ = 22 };
+
+static FLAC__uint32 unpack_uint32_le_(const FLAC__byte *b)
+{
+    return (FLAC__uint32)b[0] | ((FLAC__uint32)b[1] << 8) | ((FLAC__uint32)b[2] << 16) | ((FLAC__uint32)b[3] << 24);
+}
+
+static void pack_uint32_le_(FLAC__uint32 x, FLAC__byte *b)
+{
+    b[0] = (FLAC__byte)x;
+    b[1] = (FLAC__byte)(x >> 8);
+    b[2] = (FLAC__byte)(x >> 16);
+    b[3] = (FLAC__byte)(x >> 24);
+}
+
+/* the CRC-32 of a page with its checksum field taken as zero */
+static FLAC__uint32 page_checksum_(const FLAC__byte *header, size_t header_bytes, const FLAC__byte *body, size_t body_bytes)
+{
+    static const FLAC__byte zero[4] = { 0, 0, 0, 0 };
+    const FLAC__Dispatch *dispatch = FLAC__dispatch();
+    FLAC__uint32 crc;
+
+    crc = dispatch->crc32_update_block(header, CHECKSUM_OFFSET_, 0);
+    crc = dispatch->crc32_update_block(zero, 4, crc);
+    crc = dispatch->crc32_update_block(header + CHECKSUM_OFFSET_ + 4, header_bytes - CHECKSUM_OFFSET_ - 4, crc);
+    return dispatch->crc32_update_block(body, body_bytes, crc);
+}
+
+FLAC__OggPageParseStatus FLAC__ogg_page_parse(const FLAC__byte *data, size_t bytes, FLAC__OggPage *page)
+{
+    size_t header_bytes, body_bytes;
+    unsigned i;
+
+    if (bytes < FLAC__OGG_PAGE_HEADER_LENGTH)
+        return memcmp(data, capture_pattern_, flac_min(bytes, sizeof(capture_pattern_))) == 0 ? FLAC__OGG_PAGE_PARSE_TRUNCATED : FLAC__OGG_PAGE_PARSE_INVALID;
+    if (memcmp(data, capture_pattern_, sizeof(capture_pattern_)) != 0 || data[4] != 0)
+        return FLAC__OGG_PAGE_PARSE_INVALID;
+
+    page->segments = data[26];
+    header_bytes = FLAC__OGG_PAGE_HEADER_LENGTH + page->segments;
+    if (bytes < header_bytes)
+        return FLAC__OGG_PAGE_PARSE_TRUNCATED;
+    page->lacing = data + FLAC__OGG_PAGE_HEADER_LENGTH;
+    for (i = 0, body_bytes = 0; i < page->segments; i++)
+        body_bytes += page->lacing[i];
+    if (bytes < header_bytes + body_bytes)
+        return FLAC__OGG_PAGE_PARSE_TRUNCATED;
+
+    page->body = data + header_bytes;
+    page->body_bytes = body_bytes;
+    page->length = header_bytes + body_bytes;
+    if (page_checksum_(data, header_bytes, page->body, body_bytes) != unpack_uint32_le_(data + CHECKSUM_OFFSET_))
+        return FLAC__OGG_PAGE_PARSE_INVALID;
+
+    page->flags = data[5];
+    page->granule_position = (FLAC__uint64)unpack_uint32_le_(data + 6) | ((FLAC__uint64)unpack_uint32_le_(data + 10) << 32);
+    page->serial_number = unpack_uint32_le_(data + 14);
+    page->sequence_number = unpack_uint32_le_(data + 18);
+    return FLAC__OGG_PAGE_PARSE_OK;
+}
+
+size_t FLAC__ogg_find_capture_pattern(const FLAC__byte *data, size_t bytes)
+{
+    const FLAC__byte *p = data, *end = data + bytes;
+
+    while (end - p >= (ptrdiff_t)sizeof(capture_pattern_)) {
+        p = (const FLAC__byte*)memchr(p, capture_pattern_[0], (size_t)(end - p) - (sizeof(capture_pattern_) - 1));
+        if (p == 0)
+            break;
+        if (memcmp(p, capture_pattern_, sizeof(capture_pattern_)) == 0)
+            return (size_t)(p - data);
+        p++;
+    }
+    return bytes < sizeof(capture_pattern_) ? 0 : bytes - (sizeof(capture_pattern_) - 1);
+}
+
+FLAC__bool FLAC__ogg_is_mapping_header(const FLAC__byte *packet, size_t bytes)
+{
+    return
+        bytes >= FLAC__OGG_MAPPING_HEADER_LENGTH &&
+        memcmp(packet, mapping_packet_type_, sizeof(mapping_packet_type_)) == 0 &&
+        packet[5] == FLAC__OGG_MAPPING_VERSION_MAJOR;
+}
+
+void FLAC__ogg_page_set_checksum(FLAC__byte *header, size_t header_bytes, const FLAC__byte *body, size_t body_bytes)
+{
+    pack_uint32_le_(page_checksum_(header, header_bytes, body, body_bytes), header + CHECKSUM_OFFSET_);
+}
+
+/***********************************************************************
+ *
+ * Muxer
+ *
+ ***********************************************************************/
+
+/* Writes the page being filled; 'continued' if the next one starts in the middle of a packet. */
+static FLAC__bool write_page_(FLAC__OggMuxer *muxer, FLAC__bool continued, FLAC__OggMuxerWriteFunction write, void *client_data)
+{
+    FLAC__byte *h = muxer->header;
+    const size_t header_bytes = FLAC__OGG_PAGE_HEADER_LENGTH + muxer->segments;
+
+    memcpy(h, capture_pattern_, sizeof(capture_pattern_));
+    h[4] = 0; /* version */
+    h[5] = (FLAC__byte)muxer->flags;
+    pack_uint32_le_((FLAC__uint32)muxer->granule_position, h + 6);
+    pack_uint32_le_((FLAC__uint32)(muxer->granule_position >> 32), h + 10);
+    pack_uint32_le_(muxer->serial_number, h + 14);
+    pack_uint32_le_(muxer->sequence_number, h + 18);
+    h[26] = (FLAC__byte)muxer->segments;
+    FLAC__ogg_page_set_checksum(h, header_bytes, muxer->body, muxer->body_bytes);
+
+    if (!write(h, header_bytes, muxer->body, muxer->body_bytes, client_data))
+        return false;
+
+    muxer->sequence_number++;
+    muxer->flags = continued ? FLAC__OGG_PAGE_CONTINUED : 0;
+    muxer->granule_position = FLAC__OGG_NO_GRANULE;
+    muxer->segments = 0;
+    muxer->body_bytes = 0;
+    return true;
+}
+
+FLAC__bool FLAC__ogg_muxer_init(FLAC__OggMuxer *muxer, FLAC__uint32 serial_number)
+{
+    if (muxer->body == 0) {
+        muxer->body = (FLAC__byte*)malloc(FLAC__OGG_MAX_SEGMENTS * 255u);
+        if (muxer->body == 0)
+            return false;
+    }
+    muxer->serial_number = serial_number;
+    muxer->sequence_number = 0;
+    muxer->granule_position = FLAC__OGG_NO_GRANULE;
+    muxer->flags = FLAC__OGG_PAGE_BOS;
+    muxer->segments = 0;
+    muxer->body_bytes = 0;
+    return true;
+}
+
+void FLAC__ogg_muxer_free(FLAC__OggMuxer *muxer)
+{
+    free(muxer->body);
+    muxer->body = 0;
+}
+
+FLAC__bool FLAC__ogg_muxer_packet(FLAC__OggMuxer *muxer, const FLAC__byte *packet, size_t bytes, FLAC__uint64 granule_position, FLAC__OggMuxerWriteFunction write, void *client_data)
+{
+    size_t n = 0;
+
+    FLAC_ASSERT(0 != muxer->body);
+
+    if (muxer->body_bytes >= FLAC__OGG_MUXER_PAGE_TARGET && !write_page_(muxer, /*continued=*/false, write, client_data))
+        return false;
+
+    /* 255s while the packet lasts, then one value below 255 (maybe 0) ends it */
+    do {
+        if (muxer->segments == FLAC__OGG_MAX_SEGMENTS && !write_page_(muxer, /*continued=*/n == 255, write, client_data))
+            return false;
+        n = flac_min(bytes, (size_t)255);
+        muxer->header[FLAC__OGG_PAGE_HEADER_LENGTH + muxer->segments++] = (FLAC__byte)n;
+        memcpy(muxer->body + muxer->body_bytes, packet, n);
+        muxer->body_bytes += n;
+        packet += n;
+        bytes -= n;
+    } while (n == 255);
+
+    muxer->granule_position = granule_position;
+    return true;
+}
+
+FLAC__bool FLAC__ogg_muxer_flush(FLAC__OggMuxer *muxer, FLAC__bool eos, FLAC__OggMuxerWriteFunction write, void *client_data)
+{
+    if (eos)
+        muxer->flags |= FLAC__OGG_PAGE_EOS;
+    return write_page_(muxer, /*continued=*/false, write, client_data);
+}
@@ -0,0 +1,626 @@
+#include <stdlib.h>
+#include <string.h>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "FLAC/assert.h"
+#include "FLAC/mapped_file.h"
+#include "FLAC/parallel_decoder.h"
+#include "FLAC/stream_decoder.h"
+#include "private/frame_header.h"
+#include "private/macros.h"
+
+/***********************************************************************
+ *
+ * Private class data
+ *
+ ***********************************************************************/
+
+/*
+ * How much PCM a segment should decode to. The stride the stream is cut
+ * at is adjusted until segments come out between a quarter of this and
+ * all of it; that bounds the memory of a task and is still plenty of
+ * work to hand to a thread.
+ */
+#define FLAC__PARALLEL_DECODER_SEGMENT_BYTES (1u << 22)
+
+/* the stride starts out here; audio compresses to about half */
+#define FLAC__PARALLEL_DECODER_STRIDE (1u << 20)
+#define FLAC__PARALLEL_DECODER_MIN_STRIDE (1u << 12)
+#define FLAC__PARALLEL_DECODER_MAX_STRIDE (1u << 24)
+
+/* segments in flight per worker, so a worker never waits for the writer */
+#define FLAC__PARALLEL_DECODER_TASKS_PER_THREAD (4u)
+
+typedef enum {
+    FLAC__PARALLEL_DECODER_TASK_EMPTY = 0,
+    FLAC__PARALLEL_DECODER_TASK_QUEUED, /* waiting for a worker */
+    FLAC__PARALLEL_DECODER_TASK_DECODED /* waiting to be written */
+} FLAC__ParallelDecoderTaskState;
+
+/* a segment: the byte range from one frame start to the next one cut at */
+typedef struct {
+    FLAC__ParallelDecoderTaskState state;
+    const FLAC__byte *data;
+    size_t bytes;
+
+    /* the decoded audio, interleaved at the output resolution */
+    FLAC__byte *pcm;
+    size_t pcm_bytes, pcm_capacity;
+    FLAC__uint64 samples;
+    FLAC__uint64 bad_frames;
+    FLAC__bool damaged; /* bytes that did not decode as frames, e.g. a frame cut off at the end */
+    FLAC__bool memory_error;
+} FLAC__ParallelDecoderTask;
+
+/*
+ * The worker threads and their queue. Like the verifier's, tasks are
+ * queued in ring order, so the queue is just the index of the oldest
+ * queued task and a count.
+ */
+typedef struct {
+    std::mutex mutex;
+    std::condition_variable work_available; /* workers wait here for queued tasks */
+    std::condition_variable task_done; /* the calling thread waits here for the oldest task */
+    unsigned next_queued, num_queued;
+    FLAC__bool shutdown;
+    std::vector<std::thread> threads;
+} FLAC__ParallelDecoderPool;
+
+struct FLAC__ParallelDecoder {
+    /* settings */
+    unsigned num_threads;
+    unsigned bits_per_sample;
+
+    /* per stream */
+    FLAC__StreamMetadata_StreamInfo stream_info;
+    unsigned output_bits_per_sample;
+    size_t frame_bytes; /* the most PCM one frame can decode to */
+    size_t stride;
+    unsigned num_workers; /* 1 when everything runs on the calling thread */
+    FLAC__StreamDecoder **workers;
+    unsigned num_tasks;
+    FLAC__ParallelDecoderTask *tasks;
+    /* only touched by the calling thread */
+    unsigned fill_task; /* the task the next segment goes into */
+    unsigned write_task; /* the oldest task not written yet */
+    unsigned num_pending; /* tasks submitted and not written yet */
+    FLAC__FrameSpanIterator *iterator;
+    FLAC__ParallelDecoderPool *pool;
+};
+
+/***********************************************************************
+ *
+ * Private class method prototypes
+ *
+ ***********************************************************************/
+
+static void decode_stream_(FLAC__ParallelDecoder *decoder, const FLAC__byte *data, size_t bytes, FLAC__ParallelDecoderWriteCallback callback, void *client_data, FLAC__ParallelDecodeResult *result);
+static FLAC__bool start_run_(FLAC__ParallelDecoder *decoder, unsigned num_threads);
+static void finish_run_(FLAC__ParallelDecoder *decoder);
+static FLAC__bool start_threads_(FLAC__ParallelDecoder *decoder);
+static void stop_threads_(FLAC__ParallelDecoder *decoder);
+static void worker_thread_(FLAC__ParallelDecoder *decoder, FLAC__StreamDecoder *worker);
+static size_t next_cut_(FLAC__ParallelDecoder *decoder, const FLAC__byte *data, size_t bytes, size_t start, FLAC__uint64 *start_sample);
+static size_t find_frame_start_(FLAC__ParallelDecoder *decoder, const FLAC__byte *data, size_t bytes, size_t from, FLAC__uint64 *sample);
+static void submit_task_(FLAC__ParallelDecoder *decoder, const FLAC__byte *data, size_t bytes);
+static FLAC__ParallelDecoderTask *wait_task_(FLAC__ParallelDecoder *decoder);
+static void decode_task_(FLAC__ParallelDecoder *decoder, FLAC__StreamDecoder *worker, FLAC__ParallelDecoderTask *task);
+static void error_callback_(const FLAC__StreamDecoder *decoder, FLAC__StreamDecoderErrorStatus status, void *client_data);
+static FLAC__bool grow_task_pcm_(FLAC__ParallelDecoderTask *task, size_t bytes);
+
+/***********************************************************************
+ *
+ * Public static class data
+ *
+ ***********************************************************************/
+
+FLAC_API const char * const FLAC__ParallelDecodeStatusString[] = {
+    "FLAC__PARALLEL_DECODE_OK",
+    "FLAC__PARALLEL_DECODE_FRAME_ERROR",
+    "FLAC__PARALLEL_DECODE_NOT_FLAC",
+    "FLAC__PARALLEL_DECODE_IO_ERROR",
+    "FLAC__PARALLEL_DECODE_ABORTED",
+    "FLAC__PARALLEL_DECODE_MEMORY_ALLOCATION_ERROR"
+};
+
+/***********************************************************************
+ *
+ * Public class methods
+ *
+ ***********************************************************************/
+
+FLAC_API FLAC__ParallelDecoder *FLAC__parallel_decoder_new(void)
+{
+    FLAC__ParallelDecoder *decoder;
+
+    decoder = (FLAC__ParallelDecoder*)calloc(1, sizeof(FLAC__ParallelDecoder));
+    if (decoder == 0)
+        return 0;
+
+    decoder->iterator = FLAC__frame_span_iterator_new();
+    if (decoder->iterator == 0) {
+        free(decoder);
+        return 0;
+    }
+    decoder->num_threads = 0;
+    decoder->bits_per_sample = 0;
+
+    return decoder;
+}
+
+FLAC_API void FLAC__parallel_decoder_delete(FLAC__ParallelDecoder *decoder)
+{
+    if (decoder == 0)
+        return;
+
+    FLAC__frame_span_iterator_delete(decoder->iterator);
+    free(decoder);
+}
+
+FLAC_API FLAC__bool FLAC__parallel_decoder_set_num_threads(FLAC__ParallelDecoder *decoder, unsigned value)
+{
+    FLAC_ASSERT(0 != decoder);
+
+    if (value > FLAC__PARALLEL_DECODER_MAX_THREADS)
+        return false;
+    decoder->num_threads = value;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__parallel_decoder_set_bits_per_sample(FLAC__ParallelDecoder *decoder, unsigned value)
+{
+    FLAC_ASSERT(0 != decoder);
+
+    if (value != 0 && (value < FLAC__MIN_BITS_PER_SAMPLE || value > FLAC__MAX_BITS_PER_SAMPLE))
+        return false;
+    decoder->bits_per_sample = value;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__parallel_decoder_decode_file(FLAC__ParallelDecoder *decoder, const char *filename, FLAC__ParallelDecoderWriteCallback callback, void *client_data, FLAC__ParallelDecodeResult *result)
+{
+    FLAC__ParallelDecodeResult local_result;
+    FLAC__MappedFile *mapping;
+
+    FLAC_ASSERT(0 != decoder);
+    FLAC_ASSERT(0 != filename);
+    FLAC_ASSERT(0 != callback);
+
+    if (result == 0)
+        result = &local_result;
+    memset(result, 0, sizeof(*result));
+
+    mapping = FLAC__mapped_file_open(filename, FLAC__MAPPED_FILE_ACCESS_SEQUENTIAL);
+    if (mapping == 0) {
+        result->status = FLAC__PARALLEL_DECODE_IO_ERROR;
+        return false;
+    }
+    decode_stream_(decoder, FLAC__mapped_file_get_data(mapping), FLAC__mapped_file_get_size(mapping), callback, client_data, result);
+    FLAC__mapped_file_close(mapping);
+    return result->status == FLAC__PARALLEL_DECODE_OK;
+}
+
+FLAC_API FLAC__bool FLAC__parallel_decoder_decode_memory(FLAC__ParallelDecoder *decoder, const FLAC__byte *data, size_t bytes, FLAC__ParallelDecoderWriteCallback callback, void *client_data, FLAC__ParallelDecodeResult *result)
+{
+    FLAC__ParallelDecodeResult local_result;
+
+    FLAC_ASSERT(0 != decoder);
+    FLAC_ASSERT(0 != data || bytes == 0);
+    FLAC_ASSERT(0 != callback);
+
+    if (result == 0)
+        result = &local_result;
+    memset(result, 0, sizeof(*result));
+
+    decode_stream_(decoder, data, bytes, callback, client_data, result);
+    return result->status == FLAC__PARALLEL_DECODE_OK;
+}
+
+/***********************************************************************
+ *
+ * Private class methods
+ *
+ ***********************************************************************/
+
+/*
+ * The calling thread's part: it cuts the stream into segments while
+ * there is a free task for them, and otherwise waits for the oldest
+ * segment to be decoded and writes it. Once the write callback has
+ * asked to stop, the segments still in flight are waited for and
+ * dropped.
+ */
+void decode_stream_(FLAC__ParallelDecoder *decoder, const FLAC__byte *data, size_t bytes, FLAC__ParallelDecoderWriteCallback callback, void *client_data, FLAC__ParallelDecodeResult *result)
+{
+    FLAC__ParallelDecoderTask *task;
+    FLAC__FrameSpan span;
+    FLAC__uint64 start_sample = 0;
+    size_t start, end;
+    unsigned num_threads;
+    FLAC__bool damaged = false, memory_error = false, aborted = false;
+
+    result->status = FLAC__PARALLEL_DECODE_OK;
+
+    if (!FLAC__frame_span_iterator_init(decoder->iterator, data, bytes) || FLAC__frame_span_iterator_get_stream_info(decoder->iterator) == 0) {
+        result->status = FLAC__PARALLEL_DECODE_NOT_FLAC;
+        return;
+    }
+    decoder->stream_info = *FLAC__frame_span_iterator_get_stream_info(decoder->iterator);
+    if (decoder->stream_info.bits_per_sample < FLAC__MIN_BITS_PER_SAMPLE) {
+        result->status = FLAC__PARALLEL_DECODE_NOT_FLAC;
+        return;
+    }
+    decoder->output_bits_per_sample = decoder->bits_per_sample != 0 ? decoder->bits_per_sample : decoder->stream_info.bits_per_sample;
+    decoder->frame_bytes = (size_t)FLAC__MAX_BLOCK_SIZE * decoder->stream_info.channels * ((decoder->output_bits_per_sample + 7) / 8);
+    decoder->stride = FLAC__PARALLEL_DECODER_STRIDE;
+
+    /* the first frame; the sample number the spans give is converted already */
+    if (FLAC__frame_span_iterator_next(decoder->iterator, &span)) {
+        start = span.offset;
+        start_sample = span.header.number.sample_number;
+    }
+    else
+        start = bytes;
+
+    num_threads = decoder->num_threads;
+    if (num_threads == 0) {
+        num_threads = std::thread::hardware_concurrency();
+        if (num_threads == 0)
+            num_threads = 1;
+        num_threads = flac_min(num_threads, FLAC__PARALLEL_DECODER_MAX_THREADS);
+    }
+    if (!start_run_(decoder, num_threads)) {
+        result->status = FLAC__PARALLEL_DECODE_MEMORY_ALLOCATION_ERROR;
+        return;
+    }
+
+    while (1) {
+        while (!aborted && start < bytes && decoder->num_pending < decoder->num_tasks) {
+            end = next_cut_(decoder, data, bytes, start, &start_sample);
+            submit_task_(decoder, data + start, end - start);
+            start = end;
+        }
+        if (decoder->num_pending == 0)
+            break;
+
+        task = wait_task_(decoder);
+        if (!aborted) {
+            result->bad_frames += task->bad_frames;
+            damaged = damaged || task->damaged;
+            memory_error = memory_error || task->memory_error;
+            if (memory_error)
+                aborted = true;
+            else if (task->samples > 0) {
+                result->samples += task->samples;
+                if (!callback(&decoder->stream_info, task->pcm, (size_t)task->samples, client_data)) {
+                    result->status = FLAC__PARALLEL_DECODE_ABORTED;
+                    aborted = true;
+                }
+            }
+        }
+        if (decoder->pool != 0) {
+            std::lock_guard<std::mutex> lock(decoder->pool->mutex);
+            task->state = FLAC__PARALLEL_DECODER_TASK_EMPTY;
+        }
+        else
+            task->state = FLAC__PARALLEL_DECODER_TASK_EMPTY;
+        decoder->write_task = (decoder->write_task + 1) % decoder->num_tasks;
+        decoder->num_pending--;
+    }
+
+    finish_run_(decoder);
+
+    if (memory_error)
+        result->status = FLAC__PARALLEL_DECODE_MEMORY_ALLOCATION_ERROR;
+    else if (result->status == FLAC__PARALLEL_DECODE_OK && (result->bad_frames > 0 || damaged))
+        result->status = FLAC__PARALLEL_DECODE_FRAME_ERROR;
+    /* cut off on a frame boundary */
+    else if (result->status == FLAC__PARALLEL_DECODE_OK && decoder->stream_info.total_samples > 0 && result->samples != decoder->stream_info.total_samples)
+        result->status = FLAC__PARALLEL_DECODE_FRAME_ERROR;
+}
+
+/*
+ * Allocates the tasks and the workers' decoders for a stream and starts
+ * the threads.
+ */
+FLAC__bool start_run_(FLAC__ParallelDecoder *decoder, unsigned num_threads)
+{
+    unsigned i;
+
+    decoder->fill_task = decoder->write_task = decoder->num_pending = 0;
+    decoder->pool = 0;
+
+    decoder->num_workers = num_threads;
+    decoder->num_tasks = num_threads > 1 ? num_threads * FLAC__PARALLEL_DECODER_TASKS_PER_THREAD : 1;
+    decoder->workers = (FLAC__StreamDecoder**)calloc(decoder->num_workers, sizeof(FLAC__StreamDecoder*));
+    decoder->tasks = (FLAC__ParallelDecoderTask*)calloc(decoder->num_tasks, sizeof(FLAC__ParallelDecoderTask));
+    if (decoder->workers == 0 || decoder->tasks == 0) {
+        finish_run_(decoder);
+        return false;
+    }
+    for (i = 0; i < decoder->num_workers; i++) {
+        decoder->workers[i] = FLAC__stream_decoder_new();
+        if (decoder->workers[i] == 0) {
+            finish_run_(decoder);
+            return false;
+        }
+    }
+
+    if (num_threads > 1 && !start_threads_(decoder)) {
+        finish_run_(decoder);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Stops the threads and frees what start_run_() allocated; also cleans
+ * up after a start_run_() that failed half way.
+ */
+void finish_run_(FLAC__ParallelDecoder *decoder)
+{
+    unsigned i;
+
+    stop_threads_(decoder);
+
+    if (decoder->workers != 0) {
+        for (i = 0; i < decoder->num_workers; i++)
+            FLAC__stream_decoder_delete(decoder->workers[i]);
+        free(decoder->workers);
+        decoder->workers = 0;
+    }
+    if (decoder->tasks != 0) {
+        for (i = 0; i < decoder->num_tasks; i++)
+            free(decoder->tasks[i].pcm);
+        free(decoder->tasks);
+        decoder->tasks = 0;
+    }
+}
+
+FLAC__bool start_threads_(FLAC__ParallelDecoder *decoder)
+{
+    unsigned i;
+
+    decoder->pool = new(std::nothrow) FLAC__ParallelDecoderPool();
+    if (decoder->pool == 0)
+        return false;
+    decoder->pool->next_queued = decoder->pool->num_queued = 0;
+    decoder->pool->shutdown = false;
+
+    try {
+        for (i = 0; i < decoder->num_workers; i++)
+            decoder->pool->threads.push_back(std::thread(worker_thread_, decoder, decoder->workers[i]));
+    }
+    catch (const std::system_error &) {
+        stop_threads_(decoder);
+        return false;
+    }
+    catch (const std::bad_alloc &) {
+        stop_threads_(decoder);
+        return false;
+    }
+    return true;
+}
+
+/* by the time this is called every task has been written, so the queue is empty */
+void stop_threads_(FLAC__ParallelDecoder *decoder)
+{
+    FLAC__ParallelDecoderPool *pool = decoder->pool;
+    size_t i;
+
+    if (pool == 0)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->shutdown = true;
+    }
+    pool->work_available.notify_all();
+    for (i = 0; i < pool->threads.size(); i++)
+        pool->threads[i].join();
+    delete pool;
+    decoder->pool = 0;
+}
+
+void worker_thread_(FLAC__ParallelDecoder *decoder, FLAC__StreamDecoder *worker)
+{
+    FLAC__ParallelDecoderPool *pool = decoder->pool;
+    FLAC__ParallelDecoderTask *task;
+    std::unique_lock<std::mutex> lock(pool->mutex);
+
+    while (1) {
+        pool->work_available.wait(lock, [pool] { return pool->shutdown || pool->num_queued > 0; });
+        if (pool->num_queued == 0)
+            return;
+        task = &decoder->tasks[pool->next_queued];
+        pool->next_queued = (pool->next_queued + 1) % decoder->num_tasks;
+        pool->num_queued--;
+
+        lock.unlock();
+        decode_task_(decoder, worker, task);
+        lock.lock();
+
+        task->state = FLAC__PARALLEL_DECODER_TASK_DECODED;
+        pool->task_done.notify_one();
+    }
+}
+
+/*
+ * Where the segment starting at 'start' ends: the first good frame a
+ * stride or more further on. The sample numbers of the two frames say
+ * how much audio lies in between; if that is more than a segment should
+ * hold the stride is halved and the cut made again, if it is much less
+ * the stride is doubled for the next one. The last segment's size comes
+ * from the STREAMINFO total, when there is one.
+ */
+size_t next_cut_(FLAC__ParallelDecoder *decoder, const FLAC__byte *data, size_t bytes, size_t start, FLAC__uint64 *start_sample)
+{
+    const FLAC__uint64 segment_samples = FLAC__PARALLEL_DECODER_SEGMENT_BYTES / (decoder->frame_bytes / FLAC__MAX_BLOCK_SIZE);
+    FLAC__uint64 sample, samples;
+    size_t end;
+
+    while (1) {
+        if (bytes - start <= decoder->stride) {
+            end = bytes;
+            sample = decoder->stream_info.total_samples;
+        }
+        else
+            end = find_frame_start_(decoder, data, bytes, start + decoder->stride, &sample);
+
+        /* numbers that do not go forward (a damaged stream, an unknown total) say nothing */
+        samples = sample > *start_sample ? sample - *start_sample : 0;
+        if (samples > segment_samples && decoder->stride > FLAC__PARALLEL_DECODER_MIN_STRIDE) {
+            decoder->stride /= 2;
+            continue;
+        }
+        if (end < bytes && samples < segment_samples / 4 && decoder->stride < FLAC__PARALLEL_DECODER_MAX_STRIDE)
+            decoder->stride *= 2;
+        *start_sample = sample;
+        return end;
+    }
+}
+
+/*
+ * The first frame at or after 'from' whose header passes its CRC-8 and
+ * whose bytes up to the next header pass the CRC-16; a sync code that
+ * turns up inside a frame has about one chance in 2^24 to pass both.
+ * Returns 'bytes' if there is none, with the STREAMINFO total as the
+ * sample number, as for the end of the stream.
+ */
+size_t find_frame_start_(FLAC__ParallelDecoder *decoder, const FLAC__byte *data, size_t bytes, size_t from, FLAC__uint64 *sample)
+{
+    FLAC__FrameLocation frame;
+
+    while (from < bytes && FLAC__frame_header_find_frame(data + from, bytes - from, /*final=*/true, &decoder->stream_info, &frame) == FLAC__FRAME_SEARCH_FOUND) {
+        if (frame.crc_ok) {
+            *sample = FLAC__frame_header_get_sample_number(&frame.header, &decoder->stream_info);
+            return from + frame.start;
+        }
+        from += frame.end;
+    }
+    *sample = decoder->stream_info.total_samples;
+    return bytes;
+}
+
+/*
+ * Hands a segment over. Without worker threads it is decoded right here;
+ * otherwise it is queued in the next slot of the ring, which the caller
+ * made sure is free.
+ */
+void submit_task_(FLAC__ParallelDecoder *decoder, const FLAC__byte *data, size_t bytes)
+{
+    FLAC__ParallelDecoderPool *pool = decoder->pool;
+    FLAC__ParallelDecoderTask *task = &decoder->tasks[decoder->fill_task];
+
+    FLAC_ASSERT(decoder->num_pending < decoder->num_tasks);
+    FLAC_ASSERT(task->state == FLAC__PARALLEL_DECODER_TASK_EMPTY);
+
+    task->data = data;
+    task->bytes = bytes;
+    decoder->fill_task = (decoder->fill_task + 1) % decoder->num_tasks;
+    decoder->num_pending++;
+
+    if (pool == 0) {
+        decode_task_(decoder, decoder->workers[0], task);
+        task->state = FLAC__PARALLEL_DECODER_TASK_DECODED;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        task->state = FLAC__PARALLEL_DECODER_TASK_QUEUED;
+        pool->num_queued++;
+    }
+    pool->work_available.notify_one();
+}
+
+/* waits for the oldest segment to be decoded */
+FLAC__ParallelDecoderTask *wait_task_(FLAC__ParallelDecoder *decoder)
+{
+    FLAC__ParallelDecoderPool *pool = decoder->pool;
+    FLAC__ParallelDecoderTask *task = &decoder->tasks[decoder->write_task];
+
+    FLAC_ASSERT(decoder->num_pending > 0);
+
+    if (pool != 0) {
+        std::unique_lock<std::mutex> lock(pool->mutex);
+        pool->task_done.wait(lock, [task] { return task->state == FLAC__PARALLEL_DECODER_TASK_DECODED; });
+    }
+    FLAC_ASSERT(task->state == FLAC__PARALLEL_DECODER_TASK_DECODED);
+    return task;
+}
+
+/*
+ * Every frame is decoded straight into the task's PCM, which always has
+ * room for the biggest frame there can be behind what is decoded; the
+ * decoder rejects frames whose channel count is not STREAMINFO's.
+ */
+void decode_task_(FLAC__ParallelDecoder *decoder, FLAC__StreamDecoder *worker, FLAC__ParallelDecoderTask *task)
+{
+    const size_t bytes_per_sample = (decoder->output_bits_per_sample + 7) / 8;
+    FLAC__FrameHeader header;
+    FLAC__uint64 position, decoded = 0;
+
+    task->pcm_bytes = 0;
+    task->samples = 0;
+    task->bad_frames = 0;
+    task->damaged = false;
+    task->memory_error = false;
+
+    (void)FLAC__stream_decoder_set_error_callback(worker, error_callback_, task);
+    if (FLAC__stream_decoder_init_memory_frames(worker, &decoder->stream_info, task->data, task->bytes) != FLAC__STREAM_DECODER_INIT_STATUS_OK) {
+        (void)FLAC__stream_decoder_finish(worker);
+        task->memory_error = true;
+        return;
+    }
+    while (1) {
+        if (!grow_task_pcm_(task, task->pcm_bytes + decoder->frame_bytes)) {
+            task->memory_error = true;
+            break;
+        }
+        if (!FLAC__stream_decoder_decode_frame_interleaved(worker, decoder->output_bits_per_sample, task->pcm + task->pcm_bytes, FLAC__MAX_BLOCK_SIZE, &header))
+            break;
+        FLAC_ASSERT(header.channels == decoder->stream_info.channels);
+        task->pcm_bytes += (size_t)header.blocksize * header.channels * bytes_per_sample;
+        task->samples += header.blocksize;
+        if (FLAC__stream_decoder_get_decode_position(worker, &position))
+            decoded = position;
+    }
+    if (FLAC__stream_decoder_get_state(worker) == FLAC__STREAM_DECODER_MEMORY_ALLOCATION_ERROR)
+        task->memory_error = true;
+    /* a frame cut off at the end of the stream runs into the end without an error */
+    if (decoded < task->bytes)
+        task->damaged = true;
+    (void)FLAC__stream_decoder_finish(worker);
+}
+
+void error_callback_(const FLAC__StreamDecoder *decoder, FLAC__StreamDecoderErrorStatus status, void *client_data)
+{
+    FLAC__ParallelDecoderTask *task = (FLAC__ParallelDecoderTask*)client_data;
+
+    (void)decoder;
+
+    /* bytes that are not a frame are not a frame lost */
+    if (status == FLAC__STREAM_DECODER_ERROR_STATUS_LOST_SYNC)
+        task->damaged = true;
+    else
+        task->bad_frames++;
+}
+
+FLAC__bool grow_task_pcm_(FLAC__ParallelDecoderTask *task, size_t bytes)
+{
+    FLAC__byte *pcm;
+
+    if (bytes <= task->pcm_capacity)
+        return true;
+    /* segments are cut at about the same size, so this settles quickly */
+    bytes = flac_max(bytes, task->pcm_capacity * 2);
+    pcm = (FLAC__byte*)realloc(task->pcm, bytes);
+    if (pcm == 0)
+        return false;
+    task->pcm = pcm;
+    task->pcm_capacity = bytes;
+    return true;
+}
@@ -0,0 +1,53 @@
+#include "private/pcm.h"
+#include "FLAC/assert.h"
+#include "FLAC/format.h"
+
+/***********************************************************************
+ *
+ * Private class method prototypes
+ *
+ ***********************************************************************/
+
+static inline FLAC__uint32 shift_(FLAC__int32 sample, int shift);
+template <unsigned Bytes> static void interleave_(const FLAC__int32 * const buffer[], unsigned channels, unsigned samples, int shift, FLAC__byte pcm[]);
+
+/***********************************************************************
+ *
+ * Public class data
+ *
+ ***********************************************************************/
+
+const FLAC__PcmInterleaveFunction FLAC__pcm_interleave_table[4] = {
+    interleave_<1>,
+    interleave_<2>,
+    interleave_<3>,
+    interleave_<4>
+};
+
+/***********************************************************************
+ *
+ * Private class methods
+ *
+ ***********************************************************************/
+
+FLAC__uint32 shift_(FLAC__int32 sample, int shift)
+{
+    return shift >= 0 ? (FLAC__uint32)sample << shift : (FLAC__uint32)(sample >> -shift);
+}
+
+/* byte by byte, so it is the same on big-endian hosts */
+template <unsigned Bytes>
+void interleave_(const FLAC__int32 * const buffer[], unsigned channels, unsigned samples, int shift, FLAC__byte pcm[])
+{
+    unsigned channel, sample, b;
+
+    FLAC_ASSERT(channels >= 1 && channels <= FLAC__MAX_CHANNELS);
+
+    for (sample = 0; sample < samples; sample++) {
+        for (channel = 0; channel < channels; channel++) {
+            const FLAC__uint32 word = shift_(buffer[channel][sample], shift);
+            for (b = 0; b < Bytes; b++)
+                *pcm++ = (FLAC__byte)(word >> (8 * b));
+        }
+    }
+}
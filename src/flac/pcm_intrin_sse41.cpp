@@ -0,0 +1,155 @@
+#include "private/cpu.h"
+
+#ifdef FLAC__SSE4_1_SUPPORTED
+
+#include <smmintrin.h> /* SSE4.1 */
+#include "private/pcm.h"
+#include "FLAC/assert.h"
+
+/*
+ * Each step takes 16 output samples, as four vectors of four 32-bit
+ * samples in output order: for mono the next 16 samples, for stereo the
+ * next 8 of each channel, interleaved with unpacklo/unpackhi. All four
+ * are shifted, then a byte shuffle per vector keeps the low 'Bytes'
+ * bytes of each sample and moves them to where that vector's samples go
+ * in the 16 * Bytes output bytes:
+ *  - 4 bytes: nothing to drop, the vectors are stored as they are
+ *  - 2 bytes: two vectors fill one 16-byte store
+ *  - 3 bytes: each vector gives 12 bytes, which straddle the three
+ *    16-byte stores; the shuffles put them at their offset within the
+ *    store and the overlapping parts are ORed together
+ *  - 1 byte: four vectors fill one store
+ * The samples left over at the end go through the C kernels.
+ */
+
+/***********************************************************************
+ *
+ * Private class method prototypes
+ *
+ ***********************************************************************/
+
+template <unsigned Bytes> static void interleave_(const FLAC__int32 * const buffer[], unsigned channels, unsigned samples, int shift, FLAC__byte pcm[]);
+template <unsigned Bytes> static inline void store_(const __m128i v[4], FLAC__byte pcm[]);
+
+/***********************************************************************
+ *
+ * Public class data
+ *
+ ***********************************************************************/
+
+const FLAC__PcmInterleaveFunction FLAC__pcm_interleave_intrin_sse41_table[4] = {
+    interleave_<1>,
+    interleave_<2>,
+    interleave_<3>,
+    interleave_<4>
+};
+
+/***********************************************************************
+ *
+ * Private class methods
+ *
+ ***********************************************************************/
+
+template <unsigned Bytes>
+FLAC__SSE_TARGET("sse4.1")
+void interleave_(const FLAC__int32 * const buffer[], unsigned channels, unsigned samples, int shift, FLAC__byte pcm[])
+{
+    /* one of the two is 0 */
+    const __m128i left_shift = _mm_cvtsi32_si128(shift > 0 ? shift : 0);
+    const __m128i right_shift = _mm_cvtsi32_si128(shift < 0 ? -shift : 0);
+    const FLAC__int32 *tail[2];
+    __m128i v[4];
+    unsigned i, k;
+
+    if (channels > 2) {
+        FLAC__pcm_interleave_table[Bytes - 1](buffer, channels, samples, shift, pcm);
+        return;
+    }
+
+    if (channels == 1) {
+        const FLAC__int32 *mono = buffer[0];
+        for (i = 0; i + 16 <= samples; i += 16) {
+            for (k = 0; k < 4; k++)
+                v[k] = _mm_loadu_si128((const __m128i*)(mono + i + 4 * k));
+            for (k = 0; k < 4; k++)
+                v[k] = _mm_sra_epi32(_mm_sll_epi32(v[k], left_shift), right_shift);
+            store_<Bytes>(v, pcm);
+            pcm += 16 * Bytes;
+        }
+    }
+    else {
+        const FLAC__int32 *left = buffer[0], *right = buffer[1];
+        for (i = 0; i + 8 <= samples; i += 8) {
+            const __m128i l0 = _mm_loadu_si128((const __m128i*)(left + i));
+            const __m128i l1 = _mm_loadu_si128((const __m128i*)(left + i + 4));
+            const __m128i r0 = _mm_loadu_si128((const __m128i*)(right + i));
+            const __m128i r1 = _mm_loadu_si128((const __m128i*)(right + i + 4));
+            v[0] = _mm_unpacklo_epi32(l0, r0);
+            v[1] = _mm_unpackhi_epi32(l0, r0);
+            v[2] = _mm_unpacklo_epi32(l1, r1);
+            v[3] = _mm_unpackhi_epi32(l1, r1);
+            for (k = 0; k < 4; k++)
+                v[k] = _mm_sra_epi32(_mm_sll_epi32(v[k], left_shift), right_shift);
+            store_<Bytes>(v, pcm);
+            pcm += 16 * Bytes;
+        }
+    }
+
+    for (k = 0; k < channels; k++)
+        tail[k] = buffer[k] + i;
+    FLAC__pcm_interleave_table[Bytes - 1](tail, channels, samples - i, shift, pcm);
+}
+
+template <>
+FLAC__SSE_TARGET("sse4.1")
+void store_<4>(const __m128i v[4], FLAC__byte pcm[])
+{
+    unsigned k;
+    for (k = 0; k < 4; k++)
+        _mm_storeu_si128((__m128i*)(pcm + 16 * k), v[k]);
+}
+
+template <>
+FLAC__SSE_TARGET("sse4.1")
+void store_<2>(const __m128i v[4], FLAC__byte pcm[])
+{
+    /* the low two bytes of each sample to the low half, then two halves per store */
+    const __m128i low = _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+    _mm_storeu_si128((__m128i*)pcm, _mm_unpacklo_epi64(_mm_shuffle_epi8(v[0], low), _mm_shuffle_epi8(v[1], low)));
+    _mm_storeu_si128((__m128i*)(pcm + 16), _mm_unpacklo_epi64(_mm_shuffle_epi8(v[2], low), _mm_shuffle_epi8(v[3], low)));
+}
+
+template <>
+FLAC__SSE_TARGET("sse4.1")
+void store_<3>(const __m128i v[4], FLAC__byte pcm[])
+{
+    /*
+     * vector k covers output bytes 12k to 12k+11: store 0 gets bytes 0-11
+     * of vector 0 and 0-3 of vector 1, store 1 bytes 4-11 of vector 1 and
+     * 0-7 of vector 2, store 2 bytes 8-11 of vector 2 and all of vector 3
+     */
+    const __m128i v0 = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    const __m128i v1a = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 1, 2, 4);
+    const __m128i v1b = _mm_setr_epi8(5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i v2a = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, 0, 1, 2, 4, 5, 6, 8, 9);
+    const __m128i v2b = _mm_setr_epi8(10, 12, 13, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i v3 = _mm_setr_epi8(-1, -1, -1, -1, 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14);
+    _mm_storeu_si128((__m128i*)pcm, _mm_or_si128(_mm_shuffle_epi8(v[0], v0), _mm_shuffle_epi8(v[1], v1a)));
+    _mm_storeu_si128((__m128i*)(pcm + 16), _mm_or_si128(_mm_shuffle_epi8(v[1], v1b), _mm_shuffle_epi8(v[2], v2a)));
+    _mm_storeu_si128((__m128i*)(pcm + 32), _mm_or_si128(_mm_shuffle_epi8(v[2], v2b), _mm_shuffle_epi8(v[3], v3)));
+}
+
+template <>
+FLAC__SSE_TARGET("sse4.1")
+void store_<1>(const __m128i v[4], FLAC__byte pcm[])
+{
+    /* the low byte of each sample, vector k to bytes 4k to 4k+3 */
+    const __m128i low = _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i b0 = _mm_shuffle_epi8(v[0], low);
+    const __m128i b1 = _mm_slli_si128(_mm_shuffle_epi8(v[1], low), 4);
+    const __m128i b2 = _mm_slli_si128(_mm_shuffle_epi8(v[2], low), 8);
+    const __m128i b3 = _mm_slli_si128(_mm_shuffle_epi8(v[3], low), 12);
+    _mm_storeu_si128((__m128i*)pcm, _mm_or_si128(_mm_or_si128(b0, b1), _mm_or_si128(b2, b3)));
+}
+
+#endif
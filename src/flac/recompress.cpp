@@ -0,0 +1,902 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "FLAC/assert.h"
+#include "FLAC/mapped_file.h"
+#include "FLAC/recompress.h"
+#include "FLAC/stream_decoder.h"
+#include "private/bitwriter.h"
+#include "private/format.h"
+#include "private/frame_header.h"
+#include "private/macros.h"
+#include "private/stream_encoder_framing.h"
+
+/***********************************************************************
+ *
+ * Private class data
+ *
+ ***********************************************************************/
+
+/* the partition sums kept per partition, one per Rice parameter a 32-bit folded residual can need */
+#define FLAC__RECOMPRESS_SUMS (32u)
+
+struct FLAC__Recompressor {
+    /* settings */
+    unsigned max_partition_order;
+
+    /* per stream */
+    const FLAC__byte *data;
+    size_t bytes;
+    FLAC__StreamMetadata_StreamInfo stream_info;
+    size_t audio_offset;
+    size_t streaminfo_offset; /* of the STREAMINFO body */
+    size_t seektable_offset, seektable_length; /* of the SEEKTABLE body; length 0 if there is none */
+    FLAC__byte *seektable; /* the body, patched as it is written */
+    FLAC__IOHandle handle;
+    FLAC__IOCallbacks callbacks;
+    FLAC__int64 output_start; /* where the stream starts in the output, -1 if it cannot seek */
+    FLAC__RecompressResult *result;
+
+    FLAC__StreamDecoder *decoder;
+    FLAC__bool damaged; /* the error callback was called */
+    FLAC__int32 *channel[FLAC__MAX_CHANNELS]; /* the decoded audio */
+    FLAC__int32 *verbatim; /* a verbatim subframe's samples, rebuilt from the decoded audio */
+    FLAC__BitWriter *frame;
+    unsigned min_framesize, max_framesize;
+
+    /* the residual search */
+    FLAC__uint32 *folded;
+    FLAC__uint64 *sums; /* FLAC__RECOMPRESS_SUMS per partition at the largest order */
+    FLAC__uint32 *max_folded; /* per partition */
+    FLAC__EntropyCodingMethod_PartitionedRiceContents partitioned_rice_contents[2];
+
+    /* where each frame was and where it went, relative to the first frame, for the seek points */
+    FLAC__uint64 *old_offsets, *new_offsets;
+    size_t num_offsets, offsets_capacity;
+};
+
+/***********************************************************************
+ *
+ * Private class method prototypes
+ *
+ ***********************************************************************/
+
+static void recompress_stream_(FLAC__Recompressor *recompressor);
+static FLAC__bool read_metadata_(FLAC__Recompressor *recompressor);
+static FLAC__bool write_metadata_(FLAC__Recompressor *recompressor);
+static FLAC__bool update_metadata_(FLAC__Recompressor *recompressor);
+static FLAC__bool start_run_(FLAC__Recompressor *recompressor);
+static void finish_run_(FLAC__Recompressor *recompressor);
+static FLAC__bool recompress_frames_(FLAC__Recompressor *recompressor);
+static FLAC__bool recompress_frame_(FLAC__Recompressor *recompressor, const FLAC__Frame *frame, const FLAC__byte *data, size_t bytes, FLAC__bool *kept);
+static FLAC__bool add_subframe_(FLAC__Recompressor *recompressor, const FLAC__Frame *frame, unsigned channel, FLAC__bool *fits);
+static FLAC__bool rebuild_verbatim_(FLAC__Recompressor *recompressor, const FLAC__Frame *frame, unsigned channel, unsigned subframe_bps);
+static FLAC__EntropyCodingMethodType choose_residual_coding_(FLAC__Recompressor *recompressor, const FLAC__int32 residual[], unsigned blocksize, unsigned predictor_order, FLAC__bool allow_extended, unsigned *partition_order);
+static FLAC__uint64 choose_parameters_(const FLAC__uint64 sums[], const FLAC__uint32 max_folded[], unsigned partition_order, unsigned partition_samples, unsigned predictor_order, unsigned parameter_len, unsigned first_parameter, unsigned last_parameter, FLAC__EntropyCodingMethod_PartitionedRiceContents *contents);
+static FLAC__bool write_(FLAC__Recompressor *recompressor, const FLAC__byte *data, size_t bytes);
+static FLAC__bool add_offset_(FLAC__Recompressor *recompressor, FLAC__uint64 old_offset, FLAC__uint64 new_offset);
+static FLAC__uint64 map_offset_(const FLAC__Recompressor *recompressor, FLAC__uint64 offset);
+static void error_callback_(const FLAC__StreamDecoder *decoder, FLAC__StreamDecoderErrorStatus status, void *client_data);
+static unsigned bitlength_(FLAC__uint32 v);
+static FLAC__uint64 unpack_uint_(const FLAC__byte *b, unsigned bytes);
+static void pack_uint_(FLAC__byte *b, FLAC__uint64 v, unsigned bytes);
+static size_t file_write_callback_(const void *ptr, size_t size, size_t nmemb, FLAC__IOHandle handle);
+static int file_seek_callback_(FLAC__IOHandle handle, FLAC__int64 offset, int whence);
+static FLAC__int64 file_tell_callback_(FLAC__IOHandle handle);
+
+/***********************************************************************
+ *
+ * Public static class data
+ *
+ ***********************************************************************/
+
+FLAC_API const char * const FLAC__RecompressStatusString[] = {
+    "FLAC__RECOMPRESS_OK",
+    "FLAC__RECOMPRESS_FRAME_ERROR",
+    "FLAC__RECOMPRESS_NOT_FLAC",
+    "FLAC__RECOMPRESS_IO_ERROR",
+    "FLAC__RECOMPRESS_MEMORY_ALLOCATION_ERROR"
+};
+
+/***********************************************************************
+ *
+ * Public class methods
+ *
+ ***********************************************************************/
+
+FLAC_API FLAC__Recompressor *FLAC__recompressor_new(void)
+{
+    FLAC__Recompressor *recompressor;
+
+    recompressor = (FLAC__Recompressor*)calloc(1, sizeof(FLAC__Recompressor));
+    if (recompressor == 0)
+        return 0;
+
+    recompressor->decoder = FLAC__stream_decoder_new();
+    recompressor->frame = FLAC__bitwriter_new();
+    if (recompressor->decoder == 0 || recompressor->frame == 0) {
+        FLAC__recompressor_delete(recompressor);
+        return 0;
+    }
+    FLAC__format_entropy_coding_method_partitioned_rice_contents_init(&recompressor->partitioned_rice_contents[0]);
+    FLAC__format_entropy_coding_method_partitioned_rice_contents_init(&recompressor->partitioned_rice_contents[1]);
+    recompressor->max_partition_order = FLAC__SUBSET_MAX_RICE_PARTITION_ORDER;
+
+    return recompressor;
+}
+
+FLAC_API void FLAC__recompressor_delete(FLAC__Recompressor *recompressor)
+{
+    if (recompressor == 0)
+        return;
+
+    FLAC__stream_decoder_delete(recompressor->decoder);
+    FLAC__bitwriter_delete(recompressor->frame);
+    FLAC__format_entropy_coding_method_partitioned_rice_contents_clear(&recompressor->partitioned_rice_contents[0]);
+    FLAC__format_entropy_coding_method_partitioned_rice_contents_clear(&recompressor->partitioned_rice_contents[1]);
+    free(recompressor);
+}
+
+FLAC_API FLAC__bool FLAC__recompressor_set_max_residual_partition_order(FLAC__Recompressor *recompressor, unsigned value)
+{
+    FLAC_ASSERT(0 != recompressor);
+
+    if (value > FLAC__MAX_RICE_PARTITION_ORDER)
+        return false;
+    recompressor->max_partition_order = value;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__recompressor_recompress_file(FLAC__Recompressor *recompressor, const char *input, const char *output, FLAC__RecompressResult *result)
+{
+    FLAC__RecompressResult local_result;
+    FLAC__MappedFile *mapping;
+    FLAC__IOCallbacks callbacks;
+    struct stat input_stat, output_stat;
+    FILE *f;
+
+    FLAC_ASSERT(0 != recompressor);
+    FLAC_ASSERT(0 != input);
+    FLAC_ASSERT(0 != output);
+
+    if (result == 0)
+        result = &local_result;
+    memset(result, 0, sizeof(*result));
+
+    /* truncating the input would pull the pages out from under the mapping */
+    if (stat(input, &input_stat) == 0 && stat(output, &output_stat) == 0 &&
+        input_stat.st_dev == output_stat.st_dev && input_stat.st_ino == output_stat.st_ino) {
+        result->status = FLAC__RECOMPRESS_IO_ERROR;
+        return false;
+    }
+
+    mapping = FLAC__mapped_file_open(input, FLAC__MAPPED_FILE_ACCESS_SEQUENTIAL);
+    if (mapping == 0) {
+        result->status = FLAC__RECOMPRESS_IO_ERROR;
+        return false;
+    }
+    if ((f = fopen(output, "wb")) == 0) {
+        FLAC__mapped_file_close(mapping);
+        result->status = FLAC__RECOMPRESS_IO_ERROR;
+        return false;
+    }
+
+    memset(&callbacks, 0, sizeof(callbacks));
+    callbacks.write = file_write_callback_;
+    callbacks.seek = file_seek_callback_;
+    callbacks.tell = file_tell_callback_;
+    (void)FLAC__recompressor_recompress_memory(recompressor, FLAC__mapped_file_get_data(mapping), FLAC__mapped_file_get_size(mapping), f, callbacks, result);
+
+    if (fclose(f) != 0 && result->status == FLAC__RECOMPRESS_OK)
+        result->status = FLAC__RECOMPRESS_IO_ERROR;
+    FLAC__mapped_file_close(mapping);
+    return result->status == FLAC__RECOMPRESS_OK;
+}
+
+FLAC_API FLAC__bool FLAC__recompressor_recompress_memory(FLAC__Recompressor *recompressor, const FLAC__byte *data, size_t bytes, FLAC__IOHandle handle, FLAC__IOCallbacks callbacks, FLAC__RecompressResult *result)
+{
+    FLAC__RecompressResult local_result;
+
+    FLAC_ASSERT(0 != recompressor);
+    FLAC_ASSERT(0 != data || bytes == 0);
+    FLAC_ASSERT(0 != callbacks.write);
+
+    if (result == 0)
+        result = &local_result;
+    memset(result, 0, sizeof(*result));
+
+    recompressor->data = data;
+    recompressor->bytes = bytes;
+    recompressor->handle = handle;
+    recompressor->callbacks = callbacks;
+    recompressor->result = result;
+    result->bytes_in = bytes;
+
+    recompress_stream_(recompressor);
+    return result->status == FLAC__RECOMPRESS_OK;
+}
+
+/***********************************************************************
+ *
+ * Private class methods
+ *
+ ***********************************************************************/
+
+/*
+ * The metadata goes out first, as it is, then the frames one by one;
+ * the STREAMINFO frame sizes and the seek points are only known at the
+ * end and are written over what went out at the start.
+ */
+void recompress_stream_(FLAC__Recompressor *recompressor)
+{
+    FLAC__RecompressResult *result = recompressor->result;
+
+    result->status = FLAC__RECOMPRESS_OK;
+
+    if (!read_metadata_(recompressor)) {
+        result->status = FLAC__RECOMPRESS_NOT_FLAC;
+        return;
+    }
+    if (!start_run_(recompressor)) {
+        result->status = FLAC__RECOMPRESS_MEMORY_ALLOCATION_ERROR;
+        finish_run_(recompressor);
+        return;
+    }
+
+    recompressor->output_start = -1;
+    if (recompressor->callbacks.seek && recompressor->callbacks.tell)
+        recompressor->output_start = recompressor->callbacks.tell(recompressor->handle);
+
+    if (!write_metadata_(recompressor) || !recompress_frames_(recompressor) || !update_metadata_(recompressor)) {
+        if (result->status == FLAC__RECOMPRESS_OK)
+            result->status = FLAC__RECOMPRESS_IO_ERROR;
+    }
+
+    finish_run_(recompressor);
+}
+
+/*
+ * Finds the blocks that are written over later and the first frame.
+ * Anything before the "fLaC" marker, i.e. an ID3v2 tag, is copied with
+ * the metadata.
+ */
+FLAC__bool read_metadata_(FLAC__Recompressor *recompressor)
+{
+    const FLAC__byte *data = recompressor->data;
+    const size_t bytes = recompressor->bytes;
+    size_t p = 0, body;
+    FLAC__bool has_stream_info = false;
+    FLAC__MetadataWalk walk;
+
+    recompressor->seektable_length = 0;
+
+    FLAC__format_metadata_walk_init(&walk);
+    for (;;) {
+        switch (FLAC__format_metadata_walk(&walk, data + p, bytes - p, /*eof=*/true)) {
+            case FLAC__METADATA_WALK_ID3V2:
+            case FLAC__METADATA_WALK_MARKER:
+                p += flac_min(walk.skip, bytes - p);
+                continue;
+            case FLAC__METADATA_WALK_BLOCK:
+                break;
+            default:
+                return false;
+        }
+        body = p + FLAC__STREAM_METADATA_HEADER_LENGTH;
+        if (bytes - body < walk.length)
+            return false;
+        if (walk.type == FLAC__METADATA_TYPE_STREAMINFO && walk.length >= FLAC__STREAM_METADATA_STREAMINFO_LENGTH && !has_stream_info) {
+            FLAC__format_unpack_streaminfo(data + body, &recompressor->stream_info);
+            recompressor->streaminfo_offset = body;
+            has_stream_info = true;
+        }
+        /* there is only ever one; a second one would be left as it is */
+        else if (walk.type == FLAC__METADATA_TYPE_SEEKTABLE && recompressor->seektable_length == 0) {
+            recompressor->seektable_offset = body;
+            recompressor->seektable_length = walk.length - walk.length % FLAC__STREAM_METADATA_SEEKPOINT_LENGTH;
+        }
+        p += walk.skip;
+        if (walk.is_last)
+            break;
+    }
+
+    recompressor->audio_offset = p;
+    return has_stream_info && recompressor->stream_info.bits_per_sample >= FLAC__MIN_BITS_PER_SAMPLE;
+}
+
+/*
+ * Copies everything up to the first frame. When the output cannot seek
+ * back, the seek points are made placeholders here: their offsets are
+ * not known yet and never will be.
+ */
+FLAC__bool write_metadata_(FLAC__Recompressor *recompressor)
+{
+    const size_t seektable_offset = recompressor->seektable_offset, seektable_length = recompressor->seektable_length;
+    size_t i;
+
+    if (seektable_length == 0)
+        return write_(recompressor, recompressor->data, recompressor->audio_offset);
+
+    memcpy(recompressor->seektable, recompressor->data + seektable_offset, seektable_length);
+    if (recompressor->output_start < 0) {
+        for (i = 0; i < seektable_length; i += FLAC__STREAM_METADATA_SEEKPOINT_LENGTH) {
+            pack_uint_(recompressor->seektable + i, FLAC__STREAM_METADATA_SEEKPOINT_PLACEHOLDER, 8);
+            memset(recompressor->seektable + i + 8, 0, FLAC__STREAM_METADATA_SEEKPOINT_LENGTH - 8);
+        }
+    }
+    return
+        write_(recompressor, recompressor->data, seektable_offset) &&
+        write_(recompressor, recompressor->seektable, seektable_length) &&
+        write_(recompressor, recompressor->data + seektable_offset + seektable_length, recompressor->audio_offset - seektable_offset - seektable_length);
+}
+
+/*
+ * Writes the new frame sizes into STREAMINFO and moves the seek points
+ * to where their frames went, if the output can seek back to them.
+ */
+FLAC__bool update_metadata_(FLAC__Recompressor *recompressor)
+{
+    const FLAC__int64 start = recompressor->output_start;
+    FLAC__byte framesizes[6];
+    FLAC__int64 end;
+    size_t i;
+
+    if (start < 0)
+        return true;
+    end = recompressor->callbacks.tell(recompressor->handle);
+    if (end < 0)
+        return true; /* not seekable after all, leave the metadata as it is */
+
+    if (recompressor->result->frames > 0) {
+        /* frame sizes that do not fit are written as 0, i.e. unknown */
+        pack_uint_(framesizes, recompressor->min_framesize < (1u << FLAC__STREAM_METADATA_STREAMINFO_MIN_FRAME_SIZE_LEN) ? recompressor->min_framesize : 0, 3);
+        pack_uint_(framesizes + 3, recompressor->max_framesize < (1u << FLAC__STREAM_METADATA_STREAMINFO_MAX_FRAME_SIZE_LEN) ? recompressor->max_framesize : 0, 3);
+        /* the block sizes come first */
+        if (recompressor->callbacks.seek(recompressor->handle, start + (FLAC__int64)recompressor->streaminfo_offset + 4, SEEK_SET) != 0 ||
+            recompressor->callbacks.write(framesizes, 1, sizeof(framesizes), recompressor->handle) != sizeof(framesizes))
+            return false;
+    }
+
+    if (recompressor->seektable_length > 0) {
+        for (i = 0; i < recompressor->seektable_length; i += FLAC__STREAM_METADATA_SEEKPOINT_LENGTH) {
+            if (unpack_uint_(recompressor->seektable + i, 8) != FLAC__STREAM_METADATA_SEEKPOINT_PLACEHOLDER)
+                pack_uint_(recompressor->seektable + i + 8, map_offset_(recompressor, unpack_uint_(recompressor->seektable + i + 8, 8)), 8);
+        }
+        if (recompressor->callbacks.seek(recompressor->handle, start + (FLAC__int64)recompressor->seektable_offset, SEEK_SET) != 0 ||
+            recompressor->callbacks.write(recompressor->seektable, 1, recompressor->seektable_length, recompressor->handle) != recompressor->seektable_length)
+            return false;
+    }
+
+    return recompressor->callbacks.seek(recompressor->handle, end, SEEK_SET) == 0;
+}
+
+/*
+ * Sets up the decoder and lays out the buffers for a stream: the
+ * decoded channels at the largest blocksize, and the partition sums at
+ * the largest partition order any frame can use.
+ */
+FLAC__bool start_run_(FLAC__Recompressor *recompressor)
+{
+    const unsigned channels = recompressor->stream_info.channels;
+    const unsigned max_partitions = 1u << recompressor->max_partition_order;
+    unsigned channel;
+
+    recompressor->damaged = false;
+    recompressor->min_framesize = 0;
+    recompressor->max_framesize = 0;
+    recompressor->num_offsets = 0;
+
+    for (channel = 0; channel < channels; channel++) {
+        if ((recompressor->channel[channel] = (FLAC__int32*)malloc(sizeof(FLAC__int32) * FLAC__MAX_BLOCK_SIZE)) == 0)
+            return false;
+    }
+    if (
+        (recompressor->verbatim = (FLAC__int32*)malloc(sizeof(FLAC__int32) * FLAC__MAX_BLOCK_SIZE)) == 0 ||
+        (recompressor->folded = (FLAC__uint32*)malloc(sizeof(FLAC__uint32) * FLAC__MAX_BLOCK_SIZE)) == 0 ||
+        (recompressor->sums = (FLAC__uint64*)malloc(sizeof(FLAC__uint64) * FLAC__RECOMPRESS_SUMS * max_partitions)) == 0 ||
+        (recompressor->max_folded = (FLAC__uint32*)malloc(sizeof(FLAC__uint32) * max_partitions)) == 0 ||
+        (recompressor->seektable_length > 0 && (recompressor->seektable = (FLAC__byte*)malloc(recompressor->seektable_length)) == 0) ||
+        !FLAC__format_entropy_coding_method_partitioned_rice_contents_ensure_size(&recompressor->partitioned_rice_contents[0], recompressor->max_partition_order) ||
+        !FLAC__format_entropy_coding_method_partitioned_rice_contents_ensure_size(&recompressor->partitioned_rice_contents[1], recompressor->max_partition_order) ||
+        !FLAC__bitwriter_init(recompressor->frame, 0)
+    )
+        return false;
+
+    (void)FLAC__stream_decoder_set_error_callback(recompressor->decoder, error_callback_, recompressor);
+    return FLAC__stream_decoder_init_memory_frames(recompressor->decoder, &recompressor->stream_info, recompressor->data + recompressor->audio_offset, recompressor->bytes - recompressor->audio_offset) == FLAC__STREAM_DECODER_INIT_STATUS_OK;
+}
+
+void finish_run_(FLAC__Recompressor *recompressor)
+{
+    unsigned channel;
+
+    (void)FLAC__stream_decoder_finish(recompressor->decoder);
+    for (channel = 0; channel < FLAC__MAX_CHANNELS; channel++) {
+        free(recompressor->channel[channel]);
+        recompressor->channel[channel] = 0;
+    }
+    free(recompressor->verbatim);
+    free(recompressor->folded);
+    free(recompressor->sums);
+    free(recompressor->max_folded);
+    free(recompressor->seektable);
+    free(recompressor->old_offsets);
+    free(recompressor->new_offsets);
+    recompressor->verbatim = 0;
+    recompressor->folded = 0;
+    recompressor->sums = 0;
+    recompressor->max_folded = 0;
+    recompressor->seektable = 0;
+    recompressor->old_offsets = recompressor->new_offsets = 0;
+    recompressor->offsets_capacity = 0;
+    FLAC__bitwriter_free(recompressor->frame);
+}
+
+/*
+ * Decodes the frames in order and writes each one recoded, or as it was.
+ * The decoder only reports a problem through the error callback, before
+ * the next good frame; a damaged stream is given up on there, so every
+ * frame written starts where the one before it ended.
+ */
+FLAC__bool recompress_frames_(FLAC__Recompressor *recompressor)
+{
+    const FLAC__byte *frames = recompressor->data + recompressor->audio_offset;
+    const size_t bytes = recompressor->bytes - recompressor->audio_offset;
+    FLAC__RecompressResult *result = recompressor->result;
+    FLAC__uint64 start = 0, end, written = 0;
+    FLAC__bool kept;
+
+    while (FLAC__stream_decoder_decode_frame(recompressor->decoder, recompressor->channel, FLAC__MAX_BLOCK_SIZE, 0)) {
+        if (recompressor->damaged || !FLAC__stream_decoder_get_decode_position(recompressor->decoder, &end))
+            break;
+        FLAC_ASSERT(start < end && end <= bytes);
+        if (recompressor->seektable_length > 0 && !add_offset_(recompressor, start, written)) {
+            result->status = FLAC__RECOMPRESS_MEMORY_ALLOCATION_ERROR;
+            return false;
+        }
+        if (!recompress_frame_(recompressor, FLAC__stream_decoder_get_frame(recompressor->decoder), frames + start, (size_t)(end - start), &kept))
+            return false;
+        written = result->bytes_out - recompressor->audio_offset;
+        result->frames++;
+        if (kept)
+            result->frames_kept++;
+        start = end;
+    }
+
+    if (FLAC__stream_decoder_get_state(recompressor->decoder) == FLAC__STREAM_DECODER_MEMORY_ALLOCATION_ERROR) {
+        result->status = FLAC__RECOMPRESS_MEMORY_ALLOCATION_ERROR;
+        return false;
+    }
+    /* a frame cut off at the end of the stream runs into the end without an error */
+    if (recompressor->damaged || start != bytes) {
+        result->status = FLAC__RECOMPRESS_FRAME_ERROR;
+        return false;
+    }
+    return true;
+}
+
+/*
+ * The header is copied byte for byte, so the frame keeps its number and
+ * its blocksize and sample rate codes; the subframes are written again
+ * with the residual coding chosen anew, and the footer CRC-16 follows.
+ */
+FLAC__bool recompress_frame_(FLAC__Recompressor *recompressor, const FLAC__Frame *frame, const FLAC__byte *data, size_t bytes, FLAC__bool *kept)
+{
+    FLAC__BitWriter *bw = recompressor->frame;
+    FLAC__FrameHeader header;
+    const FLAC__byte *buffer;
+    size_t frame_bytes;
+    unsigned header_length, channel;
+    FLAC__uint16 crc;
+    FLAC__bool fits = true;
+
+    /* the decoder took it for a frame already */
+    if (FLAC__frame_header_parse(data, bytes, &recompressor->stream_info, &header, &header_length) != FLAC__FRAME_HEADER_PARSE_OK) {
+        recompressor->result->status = FLAC__RECOMPRESS_FRAME_ERROR;
+        return false;
+    }
+
+    FLAC__bitwriter_clear(bw);
+    if (!FLAC__bitwriter_write_byte_block(bw, data, header_length)) {
+        recompressor->result->status = FLAC__RECOMPRESS_MEMORY_ALLOCATION_ERROR;
+        return false;
+    }
+    for (channel = 0; channel < frame->header.channels && fits; channel++) {
+        if (!add_subframe_(recompressor, frame, channel, &fits)) {
+            recompressor->result->status = FLAC__RECOMPRESS_MEMORY_ALLOCATION_ERROR;
+            return false;
+        }
+    }
+    if (fits) {
+        if (
+            !FLAC__bitwriter_zero_pad_to_byte_boundary(bw) ||
+            !FLAC__bitwriter_get_write_crc16(bw, &crc) ||
+            !FLAC__bitwriter_write_raw_uint32(bw, crc, FLAC__FRAME_FOOTER_CRC_LEN) ||
+            !FLAC__bitwriter_get_buffer(bw, &buffer, &frame_bytes)
+        ) {
+            recompressor->result->status = FLAC__RECOMPRESS_MEMORY_ALLOCATION_ERROR;
+            return false;
+        }
+    }
+
+    /* the coding chosen costs no more than the old one at the same partition order, but the old order may have been larger */
+    *kept = !fits || frame_bytes >= bytes;
+    if (*kept) {
+        buffer = data;
+        frame_bytes = bytes;
+    }
+
+    if (recompressor->result->frames == 0 || frame_bytes < recompressor->min_framesize)
+        recompressor->min_framesize = (unsigned)frame_bytes;
+    if (frame_bytes > recompressor->max_framesize)
+        recompressor->max_framesize = (unsigned)frame_bytes;
+    return write_(recompressor, buffer, frame_bytes);
+}
+
+/*
+ * Writes one subframe the way it was coded, with a new residual coding.
+ * *fits is set to false for a verbatim side channel of a 32-bit stream,
+ * whose 33-bit samples the framing cannot write; the frame is kept.
+ */
+FLAC__bool add_subframe_(FLAC__Recompressor *recompressor, const FLAC__Frame *frame, unsigned channel, FLAC__bool *fits)
+{
+    const FLAC__Subframe *subframe = &frame->subframes[channel];
+    const unsigned blocksize = frame->header.blocksize;
+    const FLAC__bool allow_extended = recompressor->stream_info.bits_per_sample > 16;
+    FLAC__BitWriter *bw = recompressor->frame;
+    FLAC__Subframe_Verbatim verbatim;
+    FLAC__Subframe_Fixed fixed;
+    FLAC__Subframe_LPC lpc;
+    FLAC__EntropyCodingMethod *method;
+    unsigned subframe_bps = frame->header.bits_per_sample - subframe->wasted_bits;
+
+    /* the side channel has one bit more */
+    switch (frame->header.channel_assignment) {
+        case FLAC__CHANNEL_ASSIGNMENT_INDEPENDENT:
+            break;
+        case FLAC__CHANNEL_ASSIGNMENT_LEFT_SIDE:
+        case FLAC__CHANNEL_ASSIGNMENT_MID_SIDE:
+            if (channel == 1)
+                subframe_bps++;
+            break;
+        case FLAC__CHANNEL_ASSIGNMENT_RIGHT_SIDE:
+            if (channel == 0)
+                subframe_bps++;
+            break;
+    }
+
+    switch (subframe->type) {
+        case FLAC__SUBFRAME_TYPE_CONSTANT:
+            return FLAC__subframe_add_constant(&subframe->data.constant, subframe_bps, subframe->wasted_bits, bw);
+        case FLAC__SUBFRAME_TYPE_VERBATIM:
+            if (subframe_bps > 32) {
+                *fits = false;
+                return true;
+            }
+            verbatim.data = recompressor->verbatim;
+            if (!rebuild_verbatim_(recompressor, frame, channel, subframe_bps))
+                return false;
+            return FLAC__subframe_add_verbatim(&verbatim, blocksize, subframe_bps, subframe->wasted_bits, bw);
+        case FLAC__SUBFRAME_TYPE_FIXED:
+            fixed = subframe->data.fixed;
+            method = &fixed.entropy_coding_method;
+            method->type = choose_residual_coding_(recompressor, fixed.residual, blocksize, fixed.order, allow_extended || subframe->data.fixed.entropy_coding_method.type == FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2, &method->data.partitioned_rice.order);
+            method->data.partitioned_rice.content = &recompressor->partitioned_rice_contents[0];
+            return FLAC__subframe_add_fixed(&fixed, blocksize - fixed.order, subframe_bps, subframe->wasted_bits, bw);
+        case FLAC__SUBFRAME_TYPE_LPC:
+            lpc = subframe->data.lpc;
+            method = &lpc.entropy_coding_method;
+            method->type = choose_residual_coding_(recompressor, lpc.residual, blocksize, lpc.order, allow_extended || subframe->data.lpc.entropy_coding_method.type == FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2, &method->data.partitioned_rice.order);
+            method->data.partitioned_rice.content = &recompressor->partitioned_rice_contents[0];
+            return FLAC__subframe_add_lpc(&lpc, blocksize - lpc.order, subframe_bps, subframe->wasted_bits, bw);
+        default:
+            FLAC_ASSERT(0);
+            return false;
+    }
+}
+
+/*
+ * The decoder keeps no copy of a verbatim subframe; the samples are
+ * coded the same way again from the decoded channels, as the encoder
+ * coded them: side = left - right, mid = (left + right) >> 1, then the
+ * wasted bits shifted out.
+ */
+FLAC__bool rebuild_verbatim_(FLAC__Recompressor *recompressor, const FLAC__Frame *frame, unsigned channel, unsigned subframe_bps)
+{
+    const FLAC__int32 *left = recompressor->channel[0], *right = recompressor->channel[1];
+    const unsigned blocksize = frame->header.blocksize;
+    const unsigned shift = frame->subframes[channel].wasted_bits;
+    FLAC__int32 *signal = recompressor->verbatim;
+    FLAC__int64 x;
+    unsigned i;
+
+    (void)subframe_bps;
+
+    for (i = 0; i < blocksize; i++) {
+        switch (frame->header.channel_assignment) {
+            case FLAC__CHANNEL_ASSIGNMENT_LEFT_SIDE:
+                x = channel == 0 ? left[i] : (FLAC__int64)left[i] - right[i];
+                break;
+            case FLAC__CHANNEL_ASSIGNMENT_RIGHT_SIDE:
+                x = channel == 1 ? right[i] : (FLAC__int64)left[i] - right[i];
+                break;
+            case FLAC__CHANNEL_ASSIGNMENT_MID_SIDE:
+                x = channel == 0 ? ((FLAC__int64)left[i] + right[i]) >> 1 : (FLAC__int64)left[i] - right[i];
+                break;
+            default:
+                x = recompressor->channel[channel][i];
+                break;
+        }
+        x >>= shift;
+        FLAC_ASSERT(x >= -((FLAC__int64)1 << (subframe_bps - 1)) && x < ((FLAC__int64)1 << (subframe_bps - 1)));
+        signal[i] = (FLAC__int32)x;
+    }
+    return true;
+}
+
+/*
+ * Picks the partition order, the Rice parameters and the escapes that
+ * code the residual in the fewest bits, counted exactly rather than
+ * estimated as the encoder does. The cost of a partition of n folded
+ * residuals u with parameter k is n * (k + 1) + sum(u >> k), so the sums
+ * are all that is needed, and the sums of a partition at one order are
+ * those of its two halves at the next. They are counted once at the
+ * largest order and merged on the way down.
+ *
+ * Not every k needs a sum. The cost falls and then rises as k grows;
+ * with s = sum(u) it still falls while 3 * n * 2^k <= s and no longer
+ * falls once n * 2^k >= s. The mean of a merged partition is between
+ * those of its halves, so the ks that the partitions at the largest
+ * order can want cover those of every order below.
+ *
+ * The choice ends up in partitioned_rice_contents[0].
+ */
+FLAC__EntropyCodingMethodType choose_residual_coding_(FLAC__Recompressor *recompressor, const FLAC__int32 residual[], unsigned blocksize, unsigned predictor_order, FLAC__bool allow_extended, unsigned *partition_order)
+{
+    const unsigned max_order = FLAC__format_get_max_rice_partition_order_from_blocksize_limited_max_and_predictor_order(recompressor->max_partition_order, blocksize, predictor_order);
+    const unsigned max_parameter = FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_ESCAPE_PARAMETER - 1;
+    const unsigned max_extended_parameter = FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2_ESCAPE_PARAMETER - 1;
+    FLAC__EntropyCodingMethod_PartitionedRiceContents *best = &recompressor->partitioned_rice_contents[0];
+    FLAC__EntropyCodingMethod_PartitionedRiceContents *candidate = &recompressor->partitioned_rice_contents[1];
+    FLAC__EntropyCodingMethod_PartitionedRiceContents swap;
+    FLAC__EntropyCodingMethodType type = FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE;
+    FLAC__uint32 *folded = recompressor->folded;
+    FLAC__uint64 *sums = recompressor->sums;
+    FLAC__uint32 *max_folded = recompressor->max_folded;
+    FLAC__uint64 bits, best_bits = (FLAC__uint64)(-1), sum;
+    FLAC__uint32 u, m;
+    unsigned order, partition, partitions, k, first = FLAC__RECOMPRESS_SUMS, last = 0, bitlength, i, j, n, end;
+
+    /* zigzag, as the Rice coder folds them, and the sums for k = 0 that bound the ks wanted */
+    partitions = 1u << max_order;
+    for (partition = 0, j = 0; partition < partitions; partition++) {
+        /* the first partition loses the warmup samples */
+        end = ((partition + 1) * (blocksize >> max_order)) - predictor_order;
+        n = end - j;
+        m = 0;
+        sum = 0;
+        for (i = j; i < end; i++) {
+            u = ((FLAC__uint32)residual[i] << 1) ^ (FLAC__uint32)(residual[i] >> 31);
+            folded[i] = u;
+            m |= u;
+            sum += u;
+        }
+        sums[partition * FLAC__RECOMPRESS_SUMS] = sum;
+        /* only the top bit matters for the escape width, so an or does as well as a max */
+        max_folded[partition] = m;
+        if (n > 0) {
+            for (k = 0; ((FLAC__uint64)3 * n << k) <= sum; k++)
+                ;
+            first = flac_min(first, k);
+            for (; ((FLAC__uint64)n << k) < sum; k++)
+                ;
+            last = flac_max(last, k);
+        }
+        j = end;
+    }
+    /* the search is clamped to the parameters there are; the plain coding always takes part */
+    if (first > last)
+        first = last = 0;
+    first = flac_min(first, max_parameter);
+    last = flac_min(last, allow_extended ? max_extended_parameter : max_parameter);
+
+    for (partition = 0, j = 0; partition < partitions; partition++) {
+        end = ((partition + 1) * (blocksize >> max_order)) - predictor_order;
+        bitlength = bitlength_(max_folded[partition]);
+        for (k = flac_max(first, 1u); k <= last; k++) {
+            sum = 0;
+            /* a 32-bit sum, which vectorizes, if it cannot overflow */
+            if (k < bitlength && bitlength - k + bitlength_(end - j) <= 32) {
+                FLAC__uint32 sum32 = 0;
+                for (i = j; i < end; i++)
+                    sum32 += folded[i] >> k;
+                sum = sum32;
+            }
+            else if (k < bitlength) {
+                for (i = j; i < end; i++)
+                    sum += folded[i] >> k;
+            }
+            sums[partition * FLAC__RECOMPRESS_SUMS + k] = sum;
+        }
+        j = end;
+    }
+
+    for (order = max_order; ; order--) {
+        bits = choose_parameters_(sums, max_folded, order, blocksize >> order, predictor_order, FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_PARAMETER_LEN, flac_min(first, max_parameter), flac_min(last, max_parameter), candidate);
+        if (bits < best_bits) {
+            best_bits = bits;
+            type = FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE;
+            *partition_order = order;
+            swap = *best; *best = *candidate; *candidate = swap;
+        }
+        if (allow_extended) {
+            bits = choose_parameters_(sums, max_folded, order, blocksize >> order, predictor_order, FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2_PARAMETER_LEN, first, last, candidate);
+            if (bits < best_bits) {
+                best_bits = bits;
+                type = FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2;
+                *partition_order = order;
+                swap = *best; *best = *candidate; *candidate = swap;
+            }
+        }
+        if (order == 0)
+            break;
+
+        /* merge pairs of partitions for the next order down */
+        partitions = 1u << (order - 1);
+        for (partition = 0; partition < partitions; partition++) {
+            for (k = first; k <= last; k++)
+                sums[partition * FLAC__RECOMPRESS_SUMS + k] = sums[2 * partition * FLAC__RECOMPRESS_SUMS + k] + sums[(2 * partition + 1) * FLAC__RECOMPRESS_SUMS + k];
+            max_folded[partition] = max_folded[2 * partition] | max_folded[2 * partition + 1];
+        }
+    }
+
+    return type;
+}
+
+/*
+ * Codes each partition at one order in the fewest bits, with a Rice
+ * parameter from first_parameter to last_parameter or escaped to raw
+ * samples, and returns the bits of the whole residual. The cost of a
+ * parameter only ever falls and then rises as it grows, so the search
+ * stops at the first rise.
+ */
+FLAC__uint64 choose_parameters_(const FLAC__uint64 sums[], const FLAC__uint32 max_folded[], unsigned partition_order, unsigned partition_samples, unsigned predictor_order, unsigned parameter_len, unsigned first_parameter, unsigned last_parameter, FLAC__EntropyCodingMethod_PartitionedRiceContents *contents)
+{
+    const unsigned partitions = 1u << partition_order;
+    const FLAC__uint64 *s;
+    FLAC__uint64 bits = 0, best, cost, n;
+    unsigned partition, k, best_k, width;
+
+    for (partition = 0; partition < partitions; partition++) {
+        s = sums + partition * FLAC__RECOMPRESS_SUMS;
+        n = partition == 0 ? partition_samples - predictor_order : partition_samples;
+
+        best = n * (first_parameter + 1) + s[first_parameter];
+        best_k = first_parameter;
+        for (k = first_parameter + 1; k <= last_parameter; k++) {
+            cost = n * (k + 1) + s[k];
+            if (cost >= best)
+                break;
+            best = cost;
+            best_k = k;
+        }
+        contents->parameters[partition] = best_k;
+        contents->raw_bits[partition] = 0;
+
+        /* the signed width of the largest residual; an escape of 0 bits is not written */
+        width = bitlength_(max_folded[partition] >> 1) + 1;
+        if (width < (1u << FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_RAW_LEN) && FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_RAW_LEN + n * width < best) {
+            best = FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_RAW_LEN + n * width;
+            contents->raw_bits[partition] = width;
+        }
+
+        bits += parameter_len + best;
+    }
+    return bits;
+}
+
+FLAC__bool write_(FLAC__Recompressor *recompressor, const FLAC__byte *data, size_t bytes)
+{
+    if (bytes == 0)
+        return true;
+    if (recompressor->callbacks.write(data, 1, bytes, recompressor->handle) != bytes)
+        return false;
+    recompressor->result->bytes_out += bytes;
+    return true;
+}
+
+FLAC__bool add_offset_(FLAC__Recompressor *recompressor, FLAC__uint64 old_offset, FLAC__uint64 new_offset)
+{
+    FLAC__uint64 *offsets;
+    size_t capacity;
+
+    if (recompressor->num_offsets == recompressor->offsets_capacity) {
+        capacity = flac_max(recompressor->offsets_capacity * 2, (size_t)1024);
+        if ((offsets = (FLAC__uint64*)realloc(recompressor->old_offsets, sizeof(FLAC__uint64) * capacity)) == 0)
+            return false;
+        recompressor->old_offsets = offsets;
+        if ((offsets = (FLAC__uint64*)realloc(recompressor->new_offsets, sizeof(FLAC__uint64) * capacity)) == 0)
+            return false;
+        recompressor->new_offsets = offsets;
+        recompressor->offsets_capacity = capacity;
+    }
+    recompressor->old_offsets[recompressor->num_offsets] = old_offset;
+    recompressor->new_offsets[recompressor->num_offsets] = new_offset;
+    recompressor->num_offsets++;
+    return true;
+}
+
+/*
+ * Where the frame a seek point pointed at went. A point that is not at
+ * a frame start goes to the start of the frame it is in.
+ */
+FLAC__uint64 map_offset_(const FLAC__Recompressor *recompressor, FLAC__uint64 offset)
+{
+    size_t low = 0, high = recompressor->num_offsets, middle;
+
+    if (high == 0)
+        return offset;
+    /* the last frame starting at or before offset */
+    while (high - low > 1) {
+        middle = low + (high - low) / 2;
+        if (recompressor->old_offsets[middle] <= offset)
+            low = middle;
+        else
+            high = middle;
+    }
+    return recompressor->new_offsets[low];
+}
+
+void error_callback_(const FLAC__StreamDecoder *decoder, FLAC__StreamDecoderErrorStatus status, void *client_data)
+{
+    FLAC__Recompressor *recompressor = (FLAC__Recompressor*)client_data;
+
+    (void)decoder;
+    (void)status;
+
+    recompressor->damaged = true;
+}
+
+unsigned bitlength_(FLAC__uint32 v)
+{
+    unsigned bits = 0;
+
+    while (v) {
+        bits++;
+        v >>= 1;
+    }
+    return bits;
+}
+
+FLAC__uint64 unpack_uint_(const FLAC__byte *b, unsigned bytes)
+{
+    FLAC__uint64 v = 0;
+
+    while (bytes--)
+        v = (v << 8) | *b++;
+    return v;
+}
+
+void pack_uint_(FLAC__byte *b, FLAC__uint64 v, unsigned bytes)
+{
+    while (bytes--) {
+        b[bytes] = (FLAC__byte)v;
+        v >>= 8;
+    }
+}
+
+size_t file_write_callback_(const void *ptr, size_t size, size_t nmemb, FLAC__IOHandle handle)
+{
+    return fwrite(ptr, size, nmemb, (FILE*)handle);
+}
+
+int file_seek_callback_(FLAC__IOHandle handle, FLAC__int64 offset, int whence)
+{
+    return fseeko((FILE*)handle, (off_t)offset, whence);
+}
+
+FLAC__int64 file_tell_callback_(FLAC__IOHandle handle)
+{
+    return (FLAC__int64)ftello((FILE*)handle);
+}
@@ -0,0 +1,871 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>     // for uintptr_t
+#include <stdio.h>      // for SEEK_CUR
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "FLAC/assert.h"
+#include "FLAC/scan.h"
+#include "private/format.h"
+#include "private/macros.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+/* IORING_FEAT_RW_CUR_POS came with 5.6, as did OPENAT, READ, CLOSE and the probe */
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register) && defined(IORING_FEAT_RW_CUR_POS)
+#define FLAC__HAS_IO_URING 1
+#endif
+#endif
+#endif
+
+/***********************************************************************
+ *
+ * Private class data
+ *
+ ***********************************************************************/
+
+#define FLAC__SCANNER_DEFAULT_QUEUE_DEPTH (64u)
+
+typedef enum {
+    FLAC__SCAN_STEP_METADATA = 0,
+    FLAC__SCAN_STEP_DONE
+} FLAC__ScanStep;
+
+/* where a file is in FLAC__scanner_scan_files() on the io_uring */
+typedef enum {
+    FLAC__SCAN_SLOT_FREE = 0,
+    FLAC__SCAN_SLOT_OPENING,
+    FLAC__SCAN_SLOT_READING,
+    FLAC__SCAN_SLOT_CLOSING
+} FLAC__ScanSlotState;
+
+/*
+ * One file being scanned. The parser only ever looks at a window of the
+ * file, bytes [window_offset, window_offset + window_bytes), and every
+ * read appends to it; when the parser wants bytes past the window it
+ * slides the window up to where it is parsing and asks for read_bytes
+ * more. Whoever drives the file does the reads, which is what lets the
+ * same parser run on callbacks, pread() and an io_uring.
+ */
+typedef struct {
+    FLAC__ScanStep step;
+    FLAC__MetadataWalk walk;
+    FLAC__ScanResult result;
+    FLAC__bool has_stream_info;
+    FLAC__uint64 position; /* where parsing goes on */
+
+    FLAC__byte *window;
+    size_t window_bytes, window_capacity;
+    FLAC__uint64 window_offset;
+    size_t read_bytes; /* what the parser asks for, to go at window + window_bytes */
+    FLAC__bool eof; /* the file ends where the window does */
+
+    /* the VORBIS_COMMENT body the comments point into, and the arrays the result points to */
+    FLAC__byte *vorbis_comment;
+    size_t vorbis_comment_capacity;
+    FLAC__ScanComment *comments;
+    unsigned comments_capacity;
+    FLAC__ScanBlock *pictures;
+    unsigned pictures_capacity;
+
+    /* FLAC__scanner_scan_files() */
+    FLAC__ScanSlotState state;
+    size_t index;
+    int fd;
+} FLAC__ScanFile;
+
+#ifdef FLAC__HAS_IO_URING
+typedef struct {
+    int fd;
+    unsigned entries;
+    unsigned to_submit;
+    void *sq_ring, *cq_ring;
+    size_t sq_ring_bytes, cq_ring_bytes;
+    struct io_uring_sqe *sqes;
+    size_t sqes_bytes;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe *cqes;
+} FLAC__ScanRing;
+#endif
+
+struct FLAC__Scanner {
+    /* settings */
+    unsigned queue_depth;
+    FLAC__bool use_io_uring;
+
+    FLAC__bool used_io_uring;
+    FLAC__ScanFile single; /* FLAC__scanner_scan_stream(), FLAC__scanner_scan_file() and the pread() path */
+    FLAC__ScanFile *slots; /* the files in flight on the io_uring */
+    unsigned num_slots;
+};
+
+/***********************************************************************
+ *
+ * Private class method prototypes
+ *
+ ***********************************************************************/
+
+static void reset_file_(FLAC__ScanFile *file);
+static void free_file_(FLAC__ScanFile *file);
+static void finish_(FLAC__ScanFile *file, FLAC__ScanStatus status);
+static FLAC__bool parse_(FLAC__ScanFile *file);
+static const FLAC__byte *peek_(FLAC__ScanFile *file, size_t bytes, FLAC__ScanStatus short_status);
+static void read_done_(FLAC__ScanFile *file, FLAC__int64 got);
+static FLAC__bool add_picture_(FLAC__ScanFile *file, FLAC__uint64 offset, unsigned length);
+static FLAC__bool parse_vorbis_comment_(FLAC__ScanFile *file, FLAC__uint64 offset, const FLAC__byte *data, unsigned length);
+static void scan_fd_(FLAC__ScanFile *file, int fd);
+static FLAC__bool scan_files_pread_(FLAC__Scanner *scanner, const char * const filenames[], size_t first_file, size_t num_files, FLAC__ScannerCallback callback, void *client_data);
+#ifdef FLAC__HAS_IO_URING
+static FLAC__bool setup_ring_(FLAC__ScanRing *ring, unsigned entries);
+static void teardown_ring_(FLAC__ScanRing *ring);
+static struct io_uring_sqe *get_sqe_(FLAC__ScanRing *ring);
+static int enter_ring_(FLAC__ScanRing *ring, unsigned min_complete);
+static FLAC__bool scan_files_io_uring_(FLAC__Scanner *scanner, const char * const filenames[], size_t num_files, FLAC__ScannerCallback callback, void *client_data, size_t *files_done);
+static void submit_read_(FLAC__ScanRing *ring, FLAC__ScanFile *file, unsigned slot);
+static void submit_close_(FLAC__ScanRing *ring, FLAC__ScanFile *file, unsigned slot);
+#endif
+
+/***********************************************************************
+ *
+ * Public static class data
+ *
+ ***********************************************************************/
+
+FLAC_API const char * const FLAC__ScanStatusString[] = {
+    "FLAC__SCAN_OK",
+    "FLAC__SCAN_NOT_FLAC",
+    "FLAC__SCAN_TRUNCATED",
+    "FLAC__SCAN_IO_ERROR",
+    "FLAC__SCAN_MEMORY_ALLOCATION_ERROR"
+};
+
+/***********************************************************************
+ *
+ * Public class constructor/destructor
+ *
+ ***********************************************************************/
+
+FLAC_API FLAC__Scanner *FLAC__scanner_new(void)
+{
+    FLAC__Scanner *scanner;
+
+    scanner = (FLAC__Scanner*)calloc(1, sizeof(FLAC__Scanner));
+    if (scanner == 0)
+        return 0;
+
+    scanner->queue_depth = FLAC__SCANNER_DEFAULT_QUEUE_DEPTH;
+    scanner->use_io_uring = true;
+    scanner->single.fd = -1;
+
+    return scanner;
+}
+
+FLAC_API void FLAC__scanner_delete(FLAC__Scanner *scanner)
+{
+    unsigned i;
+
+    if (scanner == 0)
+        return;
+
+    free_file_(&scanner->single);
+    for (i = 0; i < scanner->num_slots; i++)
+        free_file_(&scanner->slots[i]);
+    free(scanner->slots);
+    free(scanner);
+}
+
+/***********************************************************************
+ *
+ * Public class methods
+ *
+ ***********************************************************************/
+
+FLAC_API FLAC__bool FLAC__scanner_set_queue_depth(FLAC__Scanner *scanner, unsigned value)
+{
+    FLAC_ASSERT(0 != scanner);
+
+    if (value == 0 || value > FLAC__SCANNER_MAX_QUEUE_DEPTH)
+        return false;
+    scanner->queue_depth = value;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__scanner_set_use_io_uring(FLAC__Scanner *scanner, FLAC__bool value)
+{
+    FLAC_ASSERT(0 != scanner);
+
+    scanner->use_io_uring = value;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__scanner_used_io_uring(const FLAC__Scanner *scanner)
+{
+    FLAC_ASSERT(0 != scanner);
+
+    return scanner->used_io_uring;
+}
+
+FLAC_API FLAC__bool FLAC__scanner_scan_stream(FLAC__Scanner *scanner, FLAC__IOHandle handle, FLAC__IOCallbacks callbacks, FLAC__ScanResult *result)
+{
+    FLAC__ScanFile *file = &scanner->single;
+    FLAC__uint64 stream_position = 0, offset;
+    size_t got, bytes;
+
+    FLAC_ASSERT(0 != scanner);
+    FLAC_ASSERT(0 != callbacks.read);
+    FLAC_ASSERT(0 != result);
+
+    reset_file_(file);
+    while (!parse_(file)) {
+        /* the reads only go forwards; get the stream to where this one starts */
+        offset = file->window_offset + file->window_bytes;
+        if (offset > stream_position && (callbacks.seek == 0 || callbacks.seek(handle, (FLAC__int64)(offset - stream_position), SEEK_CUR) != 0)) {
+            /* not seekable: read the gap into the free end of the window and drop it */
+            while (stream_position < offset) {
+                bytes = (size_t)flac_min((FLAC__uint64)file->read_bytes, offset - stream_position);
+                got = callbacks.read(file->window + file->window_bytes, 1, bytes, handle);
+                if (got == 0)
+                    break;
+                stream_position += got;
+                file->result.bytes_read += got;
+            }
+            if (stream_position < offset) {
+                read_done_(file, 0);
+                continue;
+            }
+        }
+        stream_position = offset;
+
+        got = callbacks.read(file->window + file->window_bytes, 1, file->read_bytes, handle);
+        stream_position += got;
+        read_done_(file, (FLAC__int64)got);
+    }
+
+    *result = file->result;
+    return result->status == FLAC__SCAN_OK;
+}
+
+FLAC_API FLAC__bool FLAC__scanner_scan_file(FLAC__Scanner *scanner, const char *filename, FLAC__ScanResult *result)
+{
+    FLAC__ScanFile *file = &scanner->single;
+    int fd;
+
+    FLAC_ASSERT(0 != scanner);
+    FLAC_ASSERT(0 != filename);
+    FLAC_ASSERT(0 != result);
+
+    reset_file_(file);
+    fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        finish_(file, FLAC__SCAN_IO_ERROR);
+    else {
+        scan_fd_(file, fd);
+        close(fd);
+    }
+
+    *result = file->result;
+    return result->status == FLAC__SCAN_OK;
+}
+
+FLAC_API FLAC__bool FLAC__scanner_scan_files(FLAC__Scanner *scanner, const char * const filenames[], size_t num_files, FLAC__ScannerCallback callback, void *client_data)
+{
+    FLAC__bool all_ok = true;
+    size_t files_done = 0;
+
+    FLAC_ASSERT(0 != scanner);
+    FLAC_ASSERT(0 != filenames || num_files == 0);
+
+    scanner->used_io_uring = false;
+#ifdef FLAC__HAS_IO_URING
+    /* one file is no queue, there is nothing to win over pread() */
+    if (scanner->use_io_uring && num_files > 1) {
+        all_ok = scan_files_io_uring_(scanner, filenames, num_files, callback, client_data, &files_done);
+        if (files_done > 0)
+            scanner->used_io_uring = true;
+    }
+#endif
+    /* no io_uring, or it could not be set up, or it broke down half way */
+    if (files_done < num_files)
+        all_ok = scan_files_pread_(scanner, filenames, files_done, num_files, callback, client_data) && all_ok;
+    return all_ok;
+}
+
+/***********************************************************************
+ *
+ * Private class methods
+ *
+ ***********************************************************************/
+
+void reset_file_(FLAC__ScanFile *file)
+{
+    file->step = FLAC__SCAN_STEP_METADATA;
+    FLAC__format_metadata_walk_init(&file->walk);
+    memset(&file->result, 0, sizeof(file->result));
+    file->has_stream_info = false;
+    file->position = 0;
+    file->window_bytes = 0;
+    file->window_offset = 0;
+    file->read_bytes = 0;
+    file->eof = false;
+}
+
+void free_file_(FLAC__ScanFile *file)
+{
+    free(file->window);
+    free(file->vorbis_comment);
+    free(file->comments);
+    free(file->pictures);
+    file->window = 0;
+    file->vorbis_comment = 0;
+    file->comments = 0;
+    file->pictures = 0;
+    file->window_capacity = file->vorbis_comment_capacity = 0;
+    file->comments_capacity = file->pictures_capacity = 0;
+}
+
+void finish_(FLAC__ScanFile *file, FLAC__ScanStatus status)
+{
+    file->step = FLAC__SCAN_STEP_DONE;
+    file->result.status = status;
+    file->result.comments = file->comments;
+    file->result.pictures = file->pictures;
+    if (status != FLAC__SCAN_OK)
+        file->result.audio_offset = 0;
+}
+
+/*
+ * Parses what is in the window. Returns true when the file is finished
+ * (file->result.status says how), false when it needs file->read_bytes
+ * more bytes appended to the window first.
+ */
+FLAC__bool parse_(FLAC__ScanFile *file)
+{
+    const FLAC__uint64 end = file->window_offset + file->window_bytes;
+    const FLAC__byte *data;
+    size_t bytes;
+    FLAC__uint64 body;
+
+    while (file->step != FLAC__SCAN_STEP_DONE) {
+        /* an ID3v2 tag can move the position past the window */
+        bytes = file->position < end ? (size_t)(end - file->position) : 0;
+        data = bytes > 0 ? file->window + (size_t)(file->position - file->window_offset) : 0;
+
+        switch (FLAC__format_metadata_walk(&file->walk, data, bytes, file->eof)) {
+            case FLAC__METADATA_WALK_NEED_MORE:
+                /* not in the window yet, so this only ever asks for the read */
+                peek_(file, file->walk.need, FLAC__SCAN_NOT_FLAC);
+                return file->step == FLAC__SCAN_STEP_DONE;
+
+            case FLAC__METADATA_WALK_ID3V2:
+            case FLAC__METADATA_WALK_MARKER:
+                file->position += file->walk.skip;
+                break;
+
+            case FLAC__METADATA_WALK_NO_MARKER:
+                finish_(file, FLAC__SCAN_NOT_FLAC);
+                break;
+
+            case FLAC__METADATA_WALK_TRUNCATED:
+                finish_(file, FLAC__SCAN_TRUNCATED);
+                break;
+
+            case FLAC__METADATA_WALK_BLOCK:
+                body = file->position + FLAC__STREAM_METADATA_HEADER_LENGTH;
+
+                /* the blocks that are read stay put until all of them is in the window */
+                if (file->walk.type == FLAC__METADATA_TYPE_STREAMINFO) {
+                    if (file->walk.length < FLAC__STREAM_METADATA_STREAMINFO_LENGTH) {
+                        finish_(file, FLAC__SCAN_NOT_FLAC);
+                        return true;
+                    }
+                    if ((data = peek_(file, FLAC__STREAM_METADATA_HEADER_LENGTH + FLAC__STREAM_METADATA_STREAMINFO_LENGTH, FLAC__SCAN_TRUNCATED)) == 0)
+                        return file->step == FLAC__SCAN_STEP_DONE;
+                    FLAC__format_unpack_streaminfo(data + FLAC__STREAM_METADATA_HEADER_LENGTH, &file->result.stream_info);
+                    file->has_stream_info = true;
+                }
+                else if (file->walk.type == FLAC__METADATA_TYPE_VORBIS_COMMENT && !file->result.has_vorbis_comment) {
+                    if ((data = peek_(file, file->walk.skip, FLAC__SCAN_TRUNCATED)) == 0)
+                        return file->step == FLAC__SCAN_STEP_DONE;
+                    if (!parse_vorbis_comment_(file, body, data + FLAC__STREAM_METADATA_HEADER_LENGTH, file->walk.length)) {
+                        finish_(file, FLAC__SCAN_MEMORY_ALLOCATION_ERROR);
+                        return true;
+                    }
+                }
+                else if (file->walk.type == FLAC__METADATA_TYPE_PICTURE) {
+                    if (!add_picture_(file, body, file->walk.length)) {
+                        finish_(file, FLAC__SCAN_MEMORY_ALLOCATION_ERROR);
+                        return true;
+                    }
+                }
+
+                file->position += file->walk.skip;
+                file->result.num_blocks++;
+                if (file->walk.is_last) {
+                    file->result.audio_offset = file->position;
+                    finish_(file, file->has_stream_info ? FLAC__SCAN_OK : FLAC__SCAN_NOT_FLAC);
+                }
+                break;
+        }
+    }
+    return true;
+}
+
+/*
+ * Points at the 'bytes' bytes at file->position. If they are not all in
+ * the window yet, slides the window up to file->position, keeping what
+ * it already has from there on, sets file->read_bytes and returns NULL.
+ * If the file ends before them, finishes it with 'short_status' instead.
+ */
+const FLAC__byte *peek_(FLAC__ScanFile *file, size_t bytes, FLAC__ScanStatus short_status)
+{
+    const FLAC__uint64 end = file->window_offset + file->window_bytes;
+    size_t keep = 0, want;
+
+    FLAC_ASSERT(file->position >= file->window_offset);
+
+    if (file->position + bytes <= end)
+        return file->window + (size_t)(file->position - file->window_offset);
+    if (file->eof) {
+        finish_(file, short_status);
+        return 0;
+    }
+
+    if (file->position < end) {
+        keep = (size_t)(end - file->position);
+        memmove(file->window, file->window + (size_t)(file->position - file->window_offset), keep);
+    }
+    file->window_offset = file->position;
+    file->window_bytes = keep;
+
+    want = flac_max(bytes, (size_t)FLAC__SCAN_READ_SIZE);
+    if (want > file->window_capacity) {
+        FLAC__byte *window = (FLAC__byte*)realloc(file->window, want);
+        if (window == 0) {
+            finish_(file, FLAC__SCAN_MEMORY_ALLOCATION_ERROR);
+            return 0;
+        }
+        file->window = window;
+        file->window_capacity = want;
+    }
+    file->read_bytes = want - keep;
+    return 0;
+}
+
+/* 'got' bytes were appended to the window: 0 is the end of the file, negative a read error */
+void read_done_(FLAC__ScanFile *file, FLAC__int64 got)
+{
+    FLAC_ASSERT(got <= (FLAC__int64)file->read_bytes);
+
+    if (got < 0)
+        finish_(file, FLAC__SCAN_IO_ERROR);
+    else if (got == 0)
+        file->eof = true;
+    else {
+        file->window_bytes += (size_t)got;
+        file->result.bytes_read += (FLAC__uint64)got;
+    }
+    file->read_bytes = 0;
+}
+
+FLAC__bool add_picture_(FLAC__ScanFile *file, FLAC__uint64 offset, unsigned length)
+{
+    if (file->result.num_pictures == file->pictures_capacity) {
+        const unsigned capacity = file->pictures_capacity == 0 ? 4 : file->pictures_capacity * 2;
+        FLAC__ScanBlock *pictures = (FLAC__ScanBlock*)realloc(file->pictures, sizeof(FLAC__ScanBlock) * capacity);
+        if (pictures == 0)
+            return false;
+        file->pictures = pictures;
+        file->pictures_capacity = capacity;
+    }
+    file->pictures[file->result.num_pictures].offset = offset;
+    file->pictures[file->result.num_pictures].length = length;
+    file->result.num_pictures++;
+    return true;
+}
+
+/*
+ * Copies the body out of the window, which moves on with the next read,
+ * and points the vendor string and the entries into the copy. The lengths
+ * are little-endian, unlike everything else in FLAC.
+ */
+FLAC__bool parse_vorbis_comment_(FLAC__ScanFile *file, FLAC__uint64 offset, const FLAC__byte *data, unsigned length)
+{
+    FLAC__ScanResult *result = &file->result;
+    unsigned p = 0, num_comments, entry_length, i;
+    const FLAC__byte *body;
+
+    if (length > file->vorbis_comment_capacity) {
+        FLAC__byte *copy = (FLAC__byte*)realloc(file->vorbis_comment, length);
+        if (copy == 0)
+            return false;
+        file->vorbis_comment = copy;
+        file->vorbis_comment_capacity = length;
+    }
+    if (length > 0)
+        memcpy(file->vorbis_comment, data, length);
+    body = file->vorbis_comment;
+
+    result->has_vorbis_comment = true;
+    result->vorbis_comment.offset = offset;
+    result->vorbis_comment.length = length;
+    result->vendor_string = "";
+    result->vendor_string_length = 0;
+    result->num_comments = 0;
+
+#define READ_LE32_(q) ((unsigned)body[q] | ((unsigned)body[(q) + 1] << 8) | ((unsigned)body[(q) + 2] << 16) | ((unsigned)body[(q) + 3] << 24))
+    if (length - p < 4)
+        return true;
+    entry_length = READ_LE32_(p);
+    p += 4;
+    if (entry_length > length - p)
+        return true;
+    result->vendor_string = (const char*)body + p;
+    result->vendor_string_length = entry_length;
+    p += entry_length;
+
+    if (length - p < 4)
+        return true;
+    num_comments = READ_LE32_(p);
+    p += 4;
+    for (i = 0; i < num_comments; i++) {
+        if (length - p < 4)
+            break;
+        entry_length = READ_LE32_(p);
+        p += 4;
+        if (entry_length > length - p)
+            break;
+        /* the count is not to be trusted, grow as the entries turn up */
+        if (result->num_comments == file->comments_capacity) {
+            const unsigned capacity = file->comments_capacity == 0 ? 16 : file->comments_capacity * 2;
+            FLAC__ScanComment *comments = (FLAC__ScanComment*)realloc(file->comments, sizeof(FLAC__ScanComment) * capacity);
+            if (comments == 0)
+                return false;
+            file->comments = comments;
+            file->comments_capacity = capacity;
+        }
+        file->comments[result->num_comments].entry = (const char*)body + p;
+        file->comments[result->num_comments].length = entry_length;
+        result->num_comments++;
+        p += entry_length;
+    }
+#undef READ_LE32_
+    return true;
+}
+
+void scan_fd_(FLAC__ScanFile *file, int fd)
+{
+    ssize_t got;
+
+    while (!parse_(file)) {
+        got = pread(fd, file->window + file->window_bytes, file->read_bytes, (off_t)(file->window_offset + file->window_bytes));
+        if (got < 0 && errno == EINTR)
+            continue;
+        read_done_(file, got < 0 ? -1 : (FLAC__int64)got);
+    }
+}
+
+FLAC__bool scan_files_pread_(FLAC__Scanner *scanner, const char * const filenames[], size_t first_file, size_t num_files, FLAC__ScannerCallback callback, void *client_data)
+{
+    FLAC__ScanResult result;
+    FLAC__bool all_ok = true;
+    size_t i;
+
+    for (i = first_file; i < num_files; i++) {
+        if (!FLAC__scanner_scan_file(scanner, filenames[i], &result))
+            all_ok = false;
+        if (callback != 0)
+            callback(filenames[i], i, &result, client_data);
+    }
+    return all_ok;
+}
+
+#ifdef FLAC__HAS_IO_URING
+/*
+ * The ring is driven with the raw system calls, the same way liburing
+ * does it: the kernel and we share the ring indices, so the loads of the
+ * indices the kernel moves are acquires and the stores of ours releases.
+ */
+FLAC__bool setup_ring_(FLAC__ScanRing *ring, unsigned entries)
+{
+    struct io_uring_params params;
+    struct io_uring_probe *probe;
+    const size_t probe_bytes = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    FLAC__bool supported;
+
+    memset(ring, 0, sizeof(*ring));
+    memset(&params, 0, sizeof(params));
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0)
+        return false;
+
+    /* 5.6 or later, for OPENAT, READ and CLOSE */
+    probe = (struct io_uring_probe*)calloc(1, probe_bytes);
+    supported =
+        probe != 0 &&
+        syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PROBE, probe, 256) == 0 &&
+        probe->last_op >= IORING_OP_CLOSE && probe->last_op >= IORING_OP_OPENAT && probe->last_op >= IORING_OP_READ &&
+        (probe->ops[IORING_OP_OPENAT].flags & IO_URING_OP_SUPPORTED) &&
+        (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) &&
+        (probe->ops[IORING_OP_CLOSE].flags & IO_URING_OP_SUPPORTED);
+    free(probe);
+    if (!supported) {
+        close(ring->fd);
+        return false;
+    }
+
+    ring->entries = params.sq_entries;
+    ring->sq_ring_bytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_bytes = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        ring->sq_ring_bytes = ring->cq_ring_bytes = flac_max(ring->sq_ring_bytes, ring->cq_ring_bytes);
+    ring->sq_ring = mmap(0, ring->sq_ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ring == MAP_FAILED) {
+        close(ring->fd);
+        return false;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        ring->cq_ring = ring->sq_ring;
+    else {
+        ring->cq_ring = mmap(0, ring->cq_ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ring == MAP_FAILED) {
+            munmap(ring->sq_ring, ring->sq_ring_bytes);
+            close(ring->fd);
+            return false;
+        }
+    }
+    ring->sqes_bytes = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe*)mmap(0, ring->sqes_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        if (ring->cq_ring != ring->sq_ring)
+            munmap(ring->cq_ring, ring->cq_ring_bytes);
+        munmap(ring->sq_ring, ring->sq_ring_bytes);
+        close(ring->fd);
+        return false;
+    }
+
+    ring->sq_head = (unsigned*)((char*)ring->sq_ring + params.sq_off.head);
+    ring->sq_tail = (unsigned*)((char*)ring->sq_ring + params.sq_off.tail);
+    ring->sq_mask = (unsigned*)((char*)ring->sq_ring + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)((char*)ring->sq_ring + params.sq_off.array);
+    ring->cq_head = (unsigned*)((char*)ring->cq_ring + params.cq_off.head);
+    ring->cq_tail = (unsigned*)((char*)ring->cq_ring + params.cq_off.tail);
+    ring->cq_mask = (unsigned*)((char*)ring->cq_ring + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)((char*)ring->cq_ring + params.cq_off.cqes);
+    return true;
+}
+
+void teardown_ring_(FLAC__ScanRing *ring)
+{
+    munmap(ring->sqes, ring->sqes_bytes);
+    if (ring->cq_ring != ring->sq_ring)
+        munmap(ring->cq_ring, ring->cq_ring_bytes);
+    munmap(ring->sq_ring, ring->sq_ring_bytes);
+    close(ring->fd);
+}
+
+/* every file has at most one operation in flight and the ring has a slot per file, so this never runs out */
+struct io_uring_sqe *get_sqe_(FLAC__ScanRing *ring)
+{
+    const unsigned tail = *ring->sq_tail;
+    const unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+
+    FLAC_ASSERT(tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) < ring->entries);
+
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+    return sqe;
+}
+
+/* hands the filled-in sqes to the kernel and waits for at least 'min_complete' completions; returns 0 or -errno */
+int enter_ring_(FLAC__ScanRing *ring, unsigned min_complete)
+{
+    long submitted;
+
+    for (;;) {
+        submitted = syscall(__NR_io_uring_enter, ring->fd, ring->to_submit, min_complete, IORING_ENTER_GETEVENTS, (void*)0, (size_t)0);
+        if (submitted >= 0) {
+            ring->to_submit -= (unsigned)submitted;
+            if (ring->to_submit == 0)
+                return 0;
+            continue;
+        }
+        if (errno != EINTR && errno != EAGAIN)
+            return -errno;
+    }
+}
+
+void submit_read_(FLAC__ScanRing *ring, FLAC__ScanFile *file, unsigned slot)
+{
+    struct io_uring_sqe *sqe = get_sqe_(ring);
+
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = file->fd;
+    sqe->addr = (FLAC__uint64)(uintptr_t)(file->window + file->window_bytes);
+    sqe->len = (unsigned)file->read_bytes;
+    sqe->off = file->window_offset + file->window_bytes;
+    sqe->user_data = slot;
+    __atomic_store_n(ring->sq_tail, *ring->sq_tail + 1, __ATOMIC_RELEASE);
+    ring->to_submit++;
+    file->state = FLAC__SCAN_SLOT_READING;
+}
+
+void submit_close_(FLAC__ScanRing *ring, FLAC__ScanFile *file, unsigned slot)
+{
+    struct io_uring_sqe *sqe = get_sqe_(ring);
+
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = file->fd;
+    sqe->user_data = slot;
+    __atomic_store_n(ring->sq_tail, *ring->sq_tail + 1, __ATOMIC_RELEASE);
+    ring->to_submit++;
+    file->state = FLAC__SCAN_SLOT_CLOSING;
+}
+
+/*
+ * Keeps up to queue_depth files in flight, each one a chain of an open,
+ * one or more reads and a close on the ring, and reports every file as
+ * soon as its last read is in. If the ring cannot be set up nothing is
+ * done; if it fails later, the files in flight are reported as I/O
+ * errors. The files before *files_done have all been reported; the
+ * caller goes on from there with pread().
+ */
+FLAC__bool scan_files_io_uring_(FLAC__Scanner *scanner, const char * const filenames[], size_t num_files, FLAC__ScannerCallback callback, void *client_data, size_t *files_done)
+{
+    const unsigned depth = (unsigned)flac_min((size_t)scanner->queue_depth, num_files);
+    FLAC__ScanRing ring;
+    FLAC__ScanFile *file;
+    struct io_uring_cqe *cqe;
+    unsigned *free_slots, num_free, in_flight = 0, head, tail, slot, i;
+    size_t next_file = 0;
+    FLAC__bool all_ok = true, broken = false;
+    int res;
+
+    *files_done = 0;
+    if (scanner->num_slots < depth) {
+        FLAC__ScanFile *slots = (FLAC__ScanFile*)realloc(scanner->slots, sizeof(FLAC__ScanFile) * depth);
+        if (slots == 0)
+            return true;
+        memset(slots + scanner->num_slots, 0, sizeof(FLAC__ScanFile) * (depth - scanner->num_slots));
+        scanner->slots = slots;
+        scanner->num_slots = depth;
+    }
+    free_slots = (unsigned*)malloc(sizeof(unsigned) * depth);
+    if (free_slots == 0)
+        return true;
+    if (!setup_ring_(&ring, depth)) {
+        free(free_slots);
+        return true;
+    }
+    for (i = 0; i < depth; i++) {
+        scanner->slots[i].state = FLAC__SCAN_SLOT_FREE;
+        free_slots[i] = depth - 1 - i;
+    }
+    num_free = depth;
+
+    while (!broken && (next_file < num_files || in_flight > 0)) {
+        /* open as many new files as there are free slots */
+        while (num_free > 0 && next_file < num_files) {
+            struct io_uring_sqe *sqe = get_sqe_(&ring);
+            slot = free_slots[--num_free];
+            file = &scanner->slots[slot];
+            reset_file_(file);
+            file->index = next_file++;
+            file->fd = -1;
+            file->state = FLAC__SCAN_SLOT_OPENING;
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = (FLAC__uint64)(uintptr_t)filenames[file->index];
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            sqe->user_data = slot;
+            __atomic_store_n(ring.sq_tail, *ring.sq_tail + 1, __ATOMIC_RELEASE);
+            ring.to_submit++;
+            in_flight++;
+        }
+
+        if (enter_ring_(&ring, /*min_complete=*/1) != 0) {
+            broken = true;
+            break;
+        }
+
+        head = *ring.cq_head;
+        tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            cqe = &ring.cqes[head & *ring.cq_mask];
+            slot = (unsigned)cqe->user_data;
+            res = cqe->res;
+            file = &scanner->slots[slot];
+
+            switch (file->state) {
+                case FLAC__SCAN_SLOT_OPENING:
+                    if (res < 0)
+                        finish_(file, FLAC__SCAN_IO_ERROR);
+                    else
+                        file->fd = res;
+                    break;
+                case FLAC__SCAN_SLOT_READING:
+                    if (res == -EINTR || res == -EAGAIN) {
+                        submit_read_(&ring, file, slot);
+                        continue;
+                    }
+                    read_done_(file, res);
+                    break;
+                case FLAC__SCAN_SLOT_CLOSING:
+                    file->state = FLAC__SCAN_SLOT_FREE;
+                    free_slots[num_free++] = slot;
+                    in_flight--;
+                    continue;
+                default:
+                    FLAC_ASSERT(0);
+                    continue;
+            }
+
+            /* opened or read: parse on, then read more or report and close */
+            if (file->step != FLAC__SCAN_STEP_DONE && !parse_(file)) {
+                submit_read_(&ring, file, slot);
+                continue;
+            }
+            if (file->result.status != FLAC__SCAN_OK)
+                all_ok = false;
+            if (callback != 0)
+                callback(filenames[file->index], file->index, &file->result, client_data);
+            (*files_done)++;
+            if (file->fd >= 0)
+                submit_close_(&ring, file, slot);
+            else {
+                file->state = FLAC__SCAN_SLOT_FREE;
+                free_slots[num_free++] = slot;
+                in_flight--;
+            }
+        }
+        __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    /* closing the ring cancels what is still queued; the files are reported once it is gone */
+    teardown_ring_(&ring);
+    if (broken) {
+        for (i = 0; i < depth; i++) {
+            file = &scanner->slots[i];
+            if (file->state == FLAC__SCAN_SLOT_OPENING || file->state == FLAC__SCAN_SLOT_READING) {
+                if (file->fd >= 0)
+                    close(file->fd);
+                finish_(file, FLAC__SCAN_IO_ERROR);
+                all_ok = false;
+                if (callback != 0)
+                    callback(filenames[file->index], file->index, &file->result, client_data);
+                (*files_done)++;
+            }
+            file->state = FLAC__SCAN_SLOT_FREE;
+        }
+        /* every file up to here is reported, the pread() path takes over from the first one never opened */
+        *files_done = next_file;
+    }
+    free(free_slots);
+    return all_ok;
+}
+#endif
@@ -0,0 +1,651 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "FLAC/assert.h"
+#include "FLAC/mapped_file.h"
+#include "FLAC/seek_index.h"
+#include "private/crc.h"
+#include "private/format.h"
+#include "private/frame_header.h"
+#include "private/macros.h"
+
+/***********************************************************************
+ *
+ * Private static data
+ *
+ ***********************************************************************/
+
+/*
+ * The saved index, all numbers little-endian:
+ * <64> magic, <32> version, <64> stream length, <64> first frame offset,
+ * <32> has STREAMINFO, <32> x 7 min/max blocksize, min/max framesize,
+ * sample rate, channels, bits per sample, <64> total samples, <128> MD5,
+ * <64> number of points, then per point <64> sample number, <64> offset,
+ * <32> frame samples, and finally a <16> CRC-16 of everything before it.
+ */
+static const FLAC__byte FILE_MAGIC_[8] = { 'f', 'L', 'a', 'C', 'S', 'I', 'D', 'X' };
+static const unsigned FILE_VERSION_ = 1;
+static const size_t FILE_HEADER_LENGTH_ = 8 + 4 + 8 + 8 + 4 + 7 * 4 + 8 + 16 + 8;
+static const size_t FILE_POINT_LENGTH_ = 8 + 8 + 4;
+
+/* the initial size of the window a callback stream is scanned through; it grows for larger frames */
+static const size_t SCAN_WINDOW_SIZE_ = 64 * 1024;
+
+/***********************************************************************
+ *
+ * Private class data
+ *
+ ***********************************************************************/
+
+struct FLAC__SeekIndex {
+    FLAC__StreamMetadata_SeekPoint *points;
+    size_t num_points, capacity;
+    FLAC__uint64 first_frame_offset;
+    /* the size of the stream, 0 if it was not read to the end */
+    FLAC__uint64 stream_length;
+    FLAC__bool has_stream_info;
+    FLAC__StreamMetadata_StreamInfo stream_info;
+};
+
+/*
+ * What the index is built from: a window onto the stream. In memory the
+ * window is the whole stream; through callbacks it is a buffer that is
+ * refilled and grown as needed.
+ */
+typedef struct {
+    const FLAC__byte *data;
+    size_t bytes; /* the size of the window */
+    size_t position; /* the read position in the window */
+    FLAC__uint64 offset; /* the stream offset of data[0] */
+    FLAC__bool eof; /* the window holds the rest of the stream */
+    FLAC__bool memory_error;
+    /* callbacks only */
+    FLAC__byte *buffer;
+    size_t capacity;
+    FLAC__IOHandle handle;
+    const FLAC__IOCallbacks *callbacks;
+} Source_;
+
+/***********************************************************************
+ *
+ * Private class method prototypes
+ *
+ ***********************************************************************/
+
+static FLAC__bool build_(FLAC__SeekIndex *index, Source_ *source);
+static FLAC__bool read_metadata_(FLAC__SeekIndex *index, Source_ *source, FLAC__bool read_seektable);
+static FLAC__bool scan_frames_(FLAC__SeekIndex *index, Source_ *source);
+static FLAC__bool append_point_(FLAC__SeekIndex *index, FLAC__uint64 sample_number, FLAC__uint64 stream_offset, unsigned frame_samples);
+static FLAC__bool source_fill_(Source_ *source, size_t bytes);
+static FLAC__bool source_skip_(Source_ *source, FLAC__uint64 bytes);
+static FLAC__bool stream_info_equal_(const FLAC__StreamMetadata_StreamInfo *a, const FLAC__StreamMetadata_StreamInfo *b);
+static void pack_uint_(FLAC__byte *b, FLAC__uint64 val, unsigned bytes);
+static FLAC__uint64 unpack_uint_(const FLAC__byte *b, unsigned bytes);
+
+/***********************************************************************
+ *
+ * Class constructor/destructor
+ *
+ ***********************************************************************/
+
+FLAC_API FLAC__SeekIndex *FLAC__seek_index_new(void)
+{
+    return (FLAC__SeekIndex*)calloc(1, sizeof(FLAC__SeekIndex));
+}
+
+FLAC_API void FLAC__seek_index_delete(FLAC__SeekIndex *index)
+{
+    if (index == 0)
+        return;
+
+    free(index->points);
+    free(index);
+}
+
+/***********************************************************************
+ *
+ * Public class methods
+ *
+ ***********************************************************************/
+
+FLAC_API FLAC__bool FLAC__seek_index_build(FLAC__SeekIndex *index, FLAC__IOHandle handle, FLAC__IOCallbacks callbacks)
+{
+    Source_ source;
+    FLAC__bool ok;
+
+    FLAC_ASSERT(0 != index);
+
+    if (callbacks.read == 0)
+        return false;
+
+    memset(&source, 0, sizeof(source));
+    source.capacity = SCAN_WINDOW_SIZE_;
+    source.buffer = (FLAC__byte*)malloc(source.capacity);
+    if (source.buffer == 0)
+        return false;
+    source.data = source.buffer;
+    source.handle = handle;
+    source.callbacks = &callbacks;
+
+    ok = build_(index, &source);
+
+    free(source.buffer);
+    return ok;
+}
+
+FLAC_API FLAC__bool FLAC__seek_index_build_memory(FLAC__SeekIndex *index, const FLAC__byte *data, size_t bytes)
+{
+    Source_ source;
+
+    FLAC_ASSERT(0 != index);
+    FLAC_ASSERT(0 != data || bytes == 0);
+
+    memset(&source, 0, sizeof(source));
+    source.data = data;
+    source.bytes = bytes;
+    source.eof = true;
+
+    return build_(index, &source);
+}
+
+FLAC_API FLAC__bool FLAC__seek_index_save(const FLAC__SeekIndex *index, const char *filename)
+{
+    const FLAC__StreamMetadata_StreamInfo *info = &index->stream_info;
+    const size_t length = FILE_HEADER_LENGTH_ + index->num_points * FILE_POINT_LENGTH_ + 2;
+    const size_t temp_size = strlen(filename) + sizeof(".XXXXXX");
+    FLAC__byte *buffer, *b;
+    char *temp_filename;
+    struct stat st;
+    FILE *f;
+    size_t i;
+    int fd;
+    FLAC__bool ok;
+
+    FLAC_ASSERT(0 != index);
+    FLAC_ASSERT(0 != filename);
+
+    buffer = (FLAC__byte*)malloc(length);
+    temp_filename = (char*)malloc(temp_size);
+    if (buffer == 0 || temp_filename == 0) {
+        free(buffer);
+        free(temp_filename);
+        return false;
+    }
+
+    b = buffer;
+    memcpy(b, FILE_MAGIC_, sizeof(FILE_MAGIC_)); b += sizeof(FILE_MAGIC_);
+    pack_uint_(b, FILE_VERSION_, 4); b += 4;
+    pack_uint_(b, index->stream_length, 8); b += 8;
+    pack_uint_(b, index->first_frame_offset, 8); b += 8;
+    pack_uint_(b, index->has_stream_info, 4); b += 4;
+    pack_uint_(b, info->min_blocksize, 4); b += 4;
+    pack_uint_(b, info->max_blocksize, 4); b += 4;
+    pack_uint_(b, info->min_framesize, 4); b += 4;
+    pack_uint_(b, info->max_framesize, 4); b += 4;
+    pack_uint_(b, info->sample_rate, 4); b += 4;
+    pack_uint_(b, info->channels, 4); b += 4;
+    pack_uint_(b, info->bits_per_sample, 4); b += 4;
+    pack_uint_(b, info->total_samples, 8); b += 8;
+    memcpy(b, info->md5sum, 16); b += 16;
+    pack_uint_(b, index->num_points, 8); b += 8;
+    for (i = 0; i < index->num_points; i++) {
+        pack_uint_(b, index->points[i].sample_number, 8); b += 8;
+        pack_uint_(b, index->points[i].stream_offset, 8); b += 8;
+        pack_uint_(b, index->points[i].frame_samples, 4); b += 4;
+    }
+    pack_uint_(b, FLAC__crc16(buffer, (unsigned)(b - buffer)), 2); b += 2;
+    FLAC_ASSERT((size_t)(b - buffer) == length);
+
+    /*
+     * write it aside and rename it into place, so no reader ever sees half
+     * an index; the name is unique, so two processes saving the same index
+     * do not write into each other's file. The index keeps the mode of the
+     * one it replaces, mkstemp()'s 0600 would hide it from other users.
+     */
+    snprintf(temp_filename, temp_size, "%s.XXXXXX", filename);
+    ok = false;
+    if ((fd = mkstemp(temp_filename)) >= 0) {
+        if (fchmod(fd, stat(filename, &st) == 0 ? (st.st_mode & 07777) : 0644) != 0 || (f = fdopen(fd, "wb")) == 0)
+            close(fd);
+        else {
+            ok = fwrite(buffer, 1, length, f) == length;
+            ok = (fclose(f) == 0) && ok;
+            ok = ok && rename(temp_filename, filename) == 0;
+        }
+        if (!ok)
+            remove(temp_filename);
+    }
+
+    free(buffer);
+    free(temp_filename);
+    return ok;
+}
+
+FLAC_API FLAC__bool FLAC__seek_index_load(FLAC__SeekIndex *index, const char *filename)
+{
+    FLAC__StreamMetadata_StreamInfo info;
+    FLAC__StreamMetadata_SeekPoint *points = 0;
+    FLAC__uint64 stream_length, first_frame_offset, num_points;
+    FLAC__bool has_stream_info;
+    FLAC__byte *buffer = 0;
+    const FLAC__byte *b;
+    long length;
+    size_t i;
+    FILE *f;
+
+    FLAC_ASSERT(0 != index);
+    FLAC_ASSERT(0 != filename);
+
+    if ((f = fopen(filename, "rb")) == 0)
+        return false;
+    if (fseek(f, 0, SEEK_END) != 0 || (length = ftell(f)) < 0 || fseek(f, 0, SEEK_SET) != 0 ||
+        (size_t)length < FILE_HEADER_LENGTH_ + 2 ||
+        (buffer = (FLAC__byte*)malloc((size_t)length)) == 0 ||
+        fread(buffer, 1, (size_t)length, f) != (size_t)length) {
+        fclose(f);
+        free(buffer);
+        return false;
+    }
+    fclose(f);
+
+    b = buffer;
+    if (memcmp(b, FILE_MAGIC_, sizeof(FILE_MAGIC_)) != 0 || unpack_uint_(b + 8, 4) != FILE_VERSION_ ||
+        FLAC__crc16(buffer, (unsigned)length - 2) != unpack_uint_(buffer + length - 2, 2))
+        goto bad;
+    b += sizeof(FILE_MAGIC_) + 4;
+    stream_length = unpack_uint_(b, 8); b += 8;
+    first_frame_offset = unpack_uint_(b, 8); b += 8;
+    has_stream_info = unpack_uint_(b, 4) ? true : false; b += 4;
+    info.min_blocksize = (unsigned)unpack_uint_(b, 4); b += 4;
+    info.max_blocksize = (unsigned)unpack_uint_(b, 4); b += 4;
+    info.min_framesize = (unsigned)unpack_uint_(b, 4); b += 4;
+    info.max_framesize = (unsigned)unpack_uint_(b, 4); b += 4;
+    info.sample_rate = (unsigned)unpack_uint_(b, 4); b += 4;
+    info.channels = (unsigned)unpack_uint_(b, 4); b += 4;
+    info.bits_per_sample = (unsigned)unpack_uint_(b, 4); b += 4;
+    info.total_samples = unpack_uint_(b, 8); b += 8;
+    memcpy(info.md5sum, b, 16); b += 16;
+    num_points = unpack_uint_(b, 8); b += 8;
+    if (num_points != ((size_t)length - FILE_HEADER_LENGTH_ - 2) / FILE_POINT_LENGTH_ ||
+        FILE_HEADER_LENGTH_ + num_points * FILE_POINT_LENGTH_ + 2 != (size_t)length)
+        goto bad;
+
+    if (num_points > 0 && (points = (FLAC__StreamMetadata_SeekPoint*)malloc(sizeof(FLAC__StreamMetadata_SeekPoint) * num_points)) == 0)
+        goto bad;
+    for (i = 0; i < num_points; i++) {
+        points[i].sample_number = unpack_uint_(b, 8); b += 8;
+        points[i].stream_offset = unpack_uint_(b, 8); b += 8;
+        points[i].frame_samples = (unsigned)unpack_uint_(b, 4); b += 4;
+        /* the lookup depends on the order */
+        if (i > 0 && points[i].sample_number <= points[i - 1].sample_number)
+            goto bad;
+    }
+    free(buffer);
+
+    free(index->points);
+    index->points = points;
+    index->num_points = index->capacity = (size_t)num_points;
+    index->stream_length = stream_length;
+    index->first_frame_offset = first_frame_offset;
+    index->has_stream_info = has_stream_info;
+    index->stream_info = info;
+    return true;
+
+bad:
+    free(points);
+    free(buffer);
+    return false;
+}
+
+FLAC_API FLAC__bool FLAC__seek_index_open(FLAC__SeekIndex *index, const char *filename)
+{
+    FLAC__MappedFile *file;
+    FLAC__SeekIndex current;
+    Source_ source;
+    char *index_filename;
+    FLAC__bool ok;
+
+    FLAC_ASSERT(0 != index);
+    FLAC_ASSERT(0 != filename);
+
+    index_filename = (char*)malloc(strlen(filename) + sizeof(FLAC__SEEK_INDEX_FILE_SUFFIX));
+    if (index_filename == 0)
+        return false;
+    sprintf(index_filename, "%s%s", filename, FLAC__SEEK_INDEX_FILE_SUFFIX);
+
+    if ((file = FLAC__mapped_file_open(filename, FLAC__MAPPED_FILE_ACCESS_SEQUENTIAL)) == 0) {
+        free(index_filename);
+        return false;
+    }
+
+    /* what the file looks like now; only the metadata is read */
+    memset(&current, 0, sizeof(current));
+    memset(&source, 0, sizeof(source));
+    source.data = FLAC__mapped_file_get_data(file);
+    source.bytes = FLAC__mapped_file_get_size(file);
+    source.eof = true;
+    ok = read_metadata_(&current, &source, /*read_seektable=*/false);
+
+    if (ok) {
+        /* the frames have not moved and the audio is the same: the saved index still fits */
+        const FLAC__bool fits =
+            FLAC__seek_index_load(index, index_filename) &&
+            index->stream_length == FLAC__mapped_file_get_size(file) &&
+            index->first_frame_offset == current.first_frame_offset &&
+            index->has_stream_info == current.has_stream_info &&
+            (!current.has_stream_info || stream_info_equal_(&index->stream_info, &current.stream_info));
+
+        if (!fits) {
+            ok = FLAC__seek_index_build_memory(index, FLAC__mapped_file_get_data(file), FLAC__mapped_file_get_size(file));
+            if (ok)
+                (void)FLAC__seek_index_save(index, index_filename);
+        }
+    }
+
+    FLAC__mapped_file_close(file);
+    free(index_filename);
+    return ok;
+}
+
+FLAC_API const FLAC__StreamMetadata_StreamInfo *FLAC__seek_index_get_stream_info(const FLAC__SeekIndex *index)
+{
+    FLAC_ASSERT(0 != index);
+    return index->has_stream_info ? &index->stream_info : 0;
+}
+
+FLAC_API FLAC__uint64 FLAC__seek_index_get_first_frame_offset(const FLAC__SeekIndex *index)
+{
+    FLAC_ASSERT(0 != index);
+    return index->first_frame_offset;
+}
+
+FLAC_API const FLAC__StreamMetadata_SeekPoint *FLAC__seek_index_get_points(const FLAC__SeekIndex *index, size_t *num_points)
+{
+    FLAC_ASSERT(0 != index);
+    FLAC_ASSERT(0 != num_points);
+
+    *num_points = index->num_points;
+    return index->points;
+}
+
+FLAC_API FLAC__bool FLAC__seek_index_lookup(const FLAC__SeekIndex *index, FLAC__uint64 sample, FLAC__StreamMetadata_SeekPoint *point)
+{
+    size_t lo = 0, hi, mid;
+
+    FLAC_ASSERT(0 != index);
+    FLAC_ASSERT(0 != point);
+
+    /* the first point after 'sample', the one before it is the answer */
+    hi = index->num_points;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (index->points[mid].sample_number <= sample)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == 0)
+        return false;
+    *point = index->points[lo - 1];
+    return true;
+}
+
+/***********************************************************************
+ *
+ * Private class methods
+ *
+ ***********************************************************************/
+
+/*
+ * A SEEKTABLE with usable points is taken as is; otherwise every frame
+ * is found by a scan and becomes a point.
+ */
+FLAC__bool build_(FLAC__SeekIndex *index, Source_ *source)
+{
+    index->num_points = 0;
+    index->first_frame_offset = 0;
+    index->stream_length = 0;
+    index->has_stream_info = false;
+
+    if (!read_metadata_(index, source, /*read_seektable=*/true)) {
+        index->num_points = 0;
+        return false;
+    }
+    if (index->num_points > 0)
+        return true;
+
+    if (!scan_frames_(index, source)) {
+        index->num_points = 0;
+        return false;
+    }
+    index->stream_length = source->offset + source->bytes;
+    return true;
+}
+
+FLAC__bool read_metadata_(FLAC__SeekIndex *index, Source_ *source, FLAC__bool read_seektable)
+{
+    FLAC__StreamMetadata_SeekPoint point;
+    FLAC__MetadataWalk walk;
+    const FLAC__byte *b;
+    FLAC__uint64 length;
+    unsigned i;
+
+    FLAC__format_metadata_walk_init(&walk);
+    for (;;) {
+        switch (FLAC__format_metadata_walk(&walk, source->data + source->position, source->bytes - source->position, source->eof)) {
+            case FLAC__METADATA_WALK_NEED_MORE:
+                /* at the end of the stream eof is set and the walk finishes */
+                if (!source_fill_(source, walk.need) && source->memory_error)
+                    return false;
+                continue;
+            case FLAC__METADATA_WALK_ID3V2:
+            case FLAC__METADATA_WALK_MARKER:
+                if (!source_skip_(source, walk.skip))
+                    return false;
+                continue;
+            case FLAC__METADATA_WALK_NO_MARKER:
+                /* maybe bare frames */
+                index->first_frame_offset = source->offset + source->position;
+                return true;
+            case FLAC__METADATA_WALK_BLOCK:
+                break;
+            default:
+                return false;
+        }
+        length = walk.length;
+        source->position += FLAC__STREAM_METADATA_HEADER_LENGTH;
+
+        if (walk.type == FLAC__METADATA_TYPE_STREAMINFO && length >= FLAC__STREAM_METADATA_STREAMINFO_LENGTH) {
+            if (!source_fill_(source, FLAC__STREAM_METADATA_STREAMINFO_LENGTH))
+                return false;
+            FLAC__format_unpack_streaminfo(source->data + source->position, &index->stream_info);
+            index->has_stream_info = true;
+        }
+        else if (walk.type == FLAC__METADATA_TYPE_SEEKTABLE && read_seektable) {
+            const unsigned num_points = (unsigned)(length / FLAC__STREAM_METADATA_SEEKPOINT_LENGTH);
+            for (i = 0; i < num_points; i++) {
+                if (!source_fill_(source, FLAC__STREAM_METADATA_SEEKPOINT_LENGTH))
+                    return false;
+                b = source->data + source->position;
+                /* big-endian, unlike the saved index */
+                point.sample_number = ((FLAC__uint64)b[0] << 56) | ((FLAC__uint64)b[1] << 48) | ((FLAC__uint64)b[2] << 40) | ((FLAC__uint64)b[3] << 32) |
+                    ((FLAC__uint64)b[4] << 24) | ((FLAC__uint64)b[5] << 16) | ((FLAC__uint64)b[6] << 8) | (FLAC__uint64)b[7];
+                point.stream_offset = ((FLAC__uint64)b[8] << 56) | ((FLAC__uint64)b[9] << 48) | ((FLAC__uint64)b[10] << 40) | ((FLAC__uint64)b[11] << 32) |
+                    ((FLAC__uint64)b[12] << 24) | ((FLAC__uint64)b[13] << 16) | ((FLAC__uint64)b[14] << 8) | (FLAC__uint64)b[15];
+                point.frame_samples = ((unsigned)b[16] << 8) | b[17];
+                source->position += FLAC__STREAM_METADATA_SEEKPOINT_LENGTH;
+                length -= FLAC__STREAM_METADATA_SEEKPOINT_LENGTH;
+                /* placeholders are skipped, and so is anything out of order */
+                if (point.sample_number == FLAC__STREAM_METADATA_SEEKPOINT_PLACEHOLDER)
+                    continue;
+                if (index->num_points > 0 &&
+                    (point.sample_number <= index->points[index->num_points - 1].sample_number ||
+                     point.stream_offset < index->points[index->num_points - 1].stream_offset))
+                    continue;
+                if (!append_point_(index, point.sample_number, point.stream_offset, point.frame_samples))
+                    return false;
+            }
+        }
+        if (!source_skip_(source, length))
+            return false;
+        if (walk.is_last)
+            break;
+    }
+
+    index->first_frame_offset = source->offset + source->position;
+    return true;
+}
+
+/*
+ * One pass over the frames, parsing headers and checking CRCs only.
+ * Damaged frames are left out; the decoder would drop them anyway.
+ */
+FLAC__bool scan_frames_(FLAC__SeekIndex *index, Source_ *source)
+{
+    const FLAC__StreamMetadata_StreamInfo *stream_info = index->has_stream_info ? &index->stream_info : 0;
+    FLAC__FrameLocation frame;
+    FLAC__uint64 sample_number;
+
+    while (1) {
+        switch (FLAC__frame_header_find_frame(source->data + source->position, source->bytes - source->position, source->eof, stream_info, &frame)) {
+            case FLAC__FRAME_SEARCH_FOUND:
+                sample_number = FLAC__frame_header_get_sample_number(&frame.header, stream_info);
+                if (frame.crc_ok && (index->num_points == 0 || sample_number > index->points[index->num_points - 1].sample_number)) {
+                    if (!append_point_(index, sample_number, source->offset + source->position + frame.start - index->first_frame_offset, frame.header.blocksize))
+                        return false;
+                }
+                source->position += frame.end;
+                break;
+            case FLAC__FRAME_SEARCH_NEED_MORE:
+                source->position += frame.start;
+                /* at the end of the stream this sets eof and the next search is the final one */
+                if (!source_fill_(source, source->bytes - source->position + 1) && source->memory_error)
+                    return false;
+                break;
+            default:
+                return true;
+        }
+    }
+}
+
+FLAC__bool append_point_(FLAC__SeekIndex *index, FLAC__uint64 sample_number, FLAC__uint64 stream_offset, unsigned frame_samples)
+{
+    if (index->num_points == index->capacity) {
+        const size_t capacity = index->capacity ? index->capacity * 2 : 256;
+        FLAC__StreamMetadata_SeekPoint *points = (FLAC__StreamMetadata_SeekPoint*)realloc(index->points, sizeof(FLAC__StreamMetadata_SeekPoint) * capacity);
+        if (points == 0)
+            return false;
+        index->points = points;
+        index->capacity = capacity;
+    }
+    index->points[index->num_points].sample_number = sample_number;
+    index->points[index->num_points].stream_offset = stream_offset;
+    index->points[index->num_points].frame_samples = frame_samples;
+    index->num_points++;
+    return true;
+}
+
+/*
+ * Makes sure the window holds at least 'bytes' bytes past the read
+ * position, reading more through the callbacks if it has to. false if
+ * the stream ends first (eof is set then) or memory ran out.
+ */
+FLAC__bool source_fill_(Source_ *source, size_t bytes)
+{
+    size_t n;
+
+    if (source->bytes - source->position >= bytes)
+        return true;
+    if (source->eof)
+        return false;
+
+    /* drop what has been read */
+    source->offset += source->position;
+    source->bytes -= source->position;
+    memmove(source->buffer, source->buffer + source->position, source->bytes);
+    source->position = 0;
+
+    if (bytes > source->capacity) {
+        const size_t capacity = flac_max(bytes, source->capacity * 2);
+        FLAC__byte *buffer = (FLAC__byte*)realloc(source->buffer, capacity);
+        if (buffer == 0) {
+            source->memory_error = true;
+            return false;
+        }
+        source->buffer = buffer;
+        source->capacity = capacity;
+    }
+    source->data = source->buffer;
+
+    while (source->bytes < bytes) {
+        n = source->callbacks->read(source->buffer + source->bytes, 1, source->capacity - source->bytes, source->handle);
+        if (n == 0) {
+            source->eof = true;
+            return false;
+        }
+        source->bytes += n;
+    }
+    return true;
+}
+
+FLAC__bool source_skip_(Source_ *source, FLAC__uint64 bytes)
+{
+    size_t n;
+
+    if (bytes <= source->bytes - source->position) {
+        source->position += (size_t)bytes;
+        return true;
+    }
+    if (source->eof)
+        return false;
+
+    /* past the window: seek over the rest if we can */
+    bytes -= source->bytes - source->position;
+    source->offset += source->bytes;
+    source->bytes = source->position = 0;
+    if (source->callbacks->seek && source->callbacks->seek(source->handle, (FLAC__int64)bytes, SEEK_CUR) == 0) {
+        source->offset += bytes;
+        return true;
+    }
+
+    while (bytes > 0) {
+        if (!source_fill_(source, 1))
+            return false;
+        n = (size_t)flac_min(bytes, (FLAC__uint64)(source->bytes - source->position));
+        source->position += n;
+        bytes -= n;
+    }
+    return true;
+}
+
+FLAC__bool stream_info_equal_(const FLAC__StreamMetadata_StreamInfo *a, const FLAC__StreamMetadata_StreamInfo *b)
+{
+    return
+        a->min_blocksize == b->min_blocksize && a->max_blocksize == b->max_blocksize &&
+        a->min_framesize == b->min_framesize && a->max_framesize == b->max_framesize &&
+        a->sample_rate == b->sample_rate && a->channels == b->channels &&
+        a->bits_per_sample == b->bits_per_sample && a->total_samples == b->total_samples &&
+        memcmp(a->md5sum, b->md5sum, 16) == 0;
+}
+
+void pack_uint_(FLAC__byte *b, FLAC__uint64 val, unsigned bytes)
+{
+    unsigned i;
+
+    for (i = 0; i < bytes; i++) {
+        b[i] = (FLAC__byte)(val & 0xff);
+        val >>= 8;
+    }
+}
+
+FLAC__uint64 unpack_uint_(const FLAC__byte *b, unsigned bytes)
+{
+    FLAC__uint64 val = 0;
+    unsigned i;
+
+    for (i = bytes; i > 0; i--)
+        val = (val << 8) | b[i - 1];
+    return val;
+}
@@ -0,0 +1,130 @@
+#include <math.h>
+#include "private/stereo.h"
+#include "FLAC/assert.h"
+
+#ifndef M_LN2
+/* math.h in VC++ doesn't seem to have this (how Microsoft is that?) */
+#define M_LN2 0.69314718055994530942
+#endif
+
+/***********************************************************************
+ *
+ * Private class method prototypes
+ *
+ ***********************************************************************/
+
+static inline FLAC__uint64 abs_difference_(FLAC__int64 x0, FLAC__int64 x1);
+static double estimate_bits_(FLAC__uint64 abs_residual_sum, unsigned data_len);
+static void restore_left_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len);
+static void restore_right_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len);
+static void restore_mid_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len);
+
+/***********************************************************************
+ *
+ * Public class data
+ *
+ ***********************************************************************/
+
+const FLAC__StereoRestoreFunction FLAC__stereo_restore_table[4] = {
+    0, restore_left_side_, restore_right_side_, restore_mid_side_
+};
+
+/***********************************************************************
+ *
+ * Public class methods
+ *
+ ***********************************************************************/
+
+void FLAC__stereo_decorrelate(const FLAC__int32 left[], const FLAC__int32 right[], unsigned data_len, FLAC__int32 mid[], FLAC__int32 side[], FLAC__uint64 abs_residual_sum[FLAC__STEREO_SIGNALS])
+{
+    FLAC__uint64 sum[FLAC__STEREO_SIGNALS] = { 0, 0, 0, 0 };
+    unsigned i;
+
+    for (i = 0; i < data_len; i++) {
+        mid[i] = (left[i] + right[i]) >> 1; /* NOTE: not the same as 'mid = (left + right) / 2' ! */
+        side[i] = left[i] - right[i];
+    }
+    for (i = 1; i < data_len; i++) {
+        sum[FLAC__STEREO_SIGNAL_LEFT] += abs_difference_(left[i], left[i-1]);
+        sum[FLAC__STEREO_SIGNAL_RIGHT] += abs_difference_(right[i], right[i-1]);
+        sum[FLAC__STEREO_SIGNAL_MID] += abs_difference_(mid[i], mid[i-1]);
+        sum[FLAC__STEREO_SIGNAL_SIDE] += abs_difference_(side[i], side[i-1]);
+    }
+    for (i = 0; i < FLAC__STEREO_SIGNALS; i++)
+        abs_residual_sum[i] = sum[i];
+}
+
+FLAC__ChannelAssignment FLAC__stereo_estimate_channel_assignment(const FLAC__uint64 abs_residual_sum[FLAC__STEREO_SIGNALS], unsigned data_len)
+{
+    double bits[FLAC__STEREO_SIGNALS], assignment_bits[4], min_bits;
+    FLAC__ChannelAssignment best = FLAC__CHANNEL_ASSIGNMENT_INDEPENDENT;
+    unsigned i;
+
+    for (i = 0; i < FLAC__STEREO_SIGNALS; i++)
+        bits[i] = estimate_bits_(abs_residual_sum[i], data_len);
+
+    assignment_bits[FLAC__CHANNEL_ASSIGNMENT_INDEPENDENT] = bits[FLAC__STEREO_SIGNAL_LEFT] + bits[FLAC__STEREO_SIGNAL_RIGHT];
+    assignment_bits[FLAC__CHANNEL_ASSIGNMENT_LEFT_SIDE] = bits[FLAC__STEREO_SIGNAL_LEFT] + bits[FLAC__STEREO_SIGNAL_SIDE];
+    assignment_bits[FLAC__CHANNEL_ASSIGNMENT_RIGHT_SIDE] = bits[FLAC__STEREO_SIGNAL_RIGHT] + bits[FLAC__STEREO_SIGNAL_SIDE];
+    assignment_bits[FLAC__CHANNEL_ASSIGNMENT_MID_SIDE] = bits[FLAC__STEREO_SIGNAL_MID] + bits[FLAC__STEREO_SIGNAL_SIDE];
+
+    min_bits = assignment_bits[FLAC__CHANNEL_ASSIGNMENT_INDEPENDENT];
+    for (i = 1; i < 4; i++) {
+        if (assignment_bits[i] < min_bits) {
+            best = (FLAC__ChannelAssignment)i;
+            min_bits = assignment_bits[i];
+        }
+    }
+    return best;
+}
+
+/***********************************************************************
+ *
+ * Private class methods
+ *
+ ***********************************************************************/
+
+/* the residual of the order 1 fixed predictor */
+FLAC__uint64 abs_difference_(FLAC__int64 x0, FLAC__int64 x1)
+{
+    const FLAC__int64 difference = x0 - x1;
+    return (FLAC__uint64)(difference < 0 ? -difference : difference);
+}
+
+/* the same estimate as FLAC__fixed_compute_best_predictor(), in bits for the whole block */
+double estimate_bits_(FLAC__uint64 abs_residual_sum, unsigned data_len)
+{
+    double bits_per_sample;
+
+    if (abs_residual_sum == 0 || data_len == 0)
+        return 0.0;
+    bits_per_sample = log(M_LN2 * (double)abs_residual_sum / (double)data_len) / M_LN2;
+    return bits_per_sample > 0.0 ? bits_per_sample * data_len : 0.0;
+}
+
+// right = left - side
+void restore_left_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len)
+{
+    unsigned i;
+    for (i = 0; i < data_len; i++)
+        channel1[i] = (FLAC__int32)((FLAC__uint32)channel0[i] - (FLAC__uint32)channel1[i]);
+}
+
+// left = side + right
+void restore_right_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len)
+{
+    unsigned i;
+    for (i = 0; i < data_len; i++)
+        channel0[i] = (FLAC__int32)((FLAC__uint32)channel0[i] + (FLAC__uint32)channel1[i]);
+}
+
+void restore_mid_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len)
+{
+    unsigned i;
+    for (i = 0; i < data_len; i++) {
+        const FLAC__uint32 side = (FLAC__uint32)channel1[i];
+        const FLAC__uint32 mid = ((FLAC__uint32)channel0[i] << 1) | (side & 1); /* i.e. if 'side' is odd... */
+        channel0[i] = (FLAC__int32)(mid + side) >> 1;
+        channel1[i] = (FLAC__int32)(mid - side) >> 1;
+    }
+}
@@ -0,0 +1,146 @@
+#include "private/cpu.h"
+
+#ifdef FLAC__AVX2_SUPPORTED
+
+#include <immintrin.h> /* AVX2 */
+#include "private/stereo.h"
+#include "FLAC/assert.h"
+
+/*
+ * Same as stereo_intrin_sse41.cpp with eight lanes.
+ */
+
+/***********************************************************************
+ *
+ * Private class method prototypes
+ *
+ ***********************************************************************/
+
+static void restore_left_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len);
+static void restore_right_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len);
+static void restore_mid_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len);
+static inline __m256i abs_difference_(__m256i x0, __m256i x1);
+static inline __m256i add_widened_(__m256i sum, __m256i x);
+
+/***********************************************************************
+ *
+ * Public class data
+ *
+ ***********************************************************************/
+
+const FLAC__StereoRestoreFunction FLAC__stereo_restore_intrin_avx2_table[4] = {
+    0, restore_left_side_, restore_right_side_, restore_mid_side_
+};
+
+/***********************************************************************
+ *
+ * Public class methods
+ *
+ ***********************************************************************/
+
+FLAC__SSE_TARGET("avx2")
+void FLAC__stereo_decorrelate_intrin_avx2(const FLAC__int32 left[], const FLAC__int32 right[], unsigned data_len, FLAC__int32 mid[], FLAC__int32 side[], FLAC__uint64 abs_residual_sum[FLAC__STEREO_SIGNALS])
+{
+    __m256i sum[FLAC__STEREO_SIGNALS];
+    FLAC__uint64 lanes[4], tail[FLAC__STEREO_SIGNALS];
+    unsigned i, k;
+
+    if (data_len < 1 + 8) {
+        FLAC__stereo_decorrelate(left, right, data_len, mid, side, abs_residual_sum);
+        return;
+    }
+
+    for (k = 0; k < FLAC__STEREO_SIGNALS; k++)
+        sum[k] = _mm256_setzero_si256();
+    mid[0] = (left[0] + right[0]) >> 1;
+    side[0] = left[0] - right[0];
+
+    /* the history of mid and side is computed again from left and right, rather than read back from what was just stored */
+    for (i = 1; i + 8 <= data_len; i += 8) {
+        const __m256i l0 = _mm256_loadu_si256((const __m256i*)(left + i));
+        const __m256i l1 = _mm256_loadu_si256((const __m256i*)(left + i - 1));
+        const __m256i r0 = _mm256_loadu_si256((const __m256i*)(right + i));
+        const __m256i r1 = _mm256_loadu_si256((const __m256i*)(right + i - 1));
+        const __m256i m0 = _mm256_srai_epi32(_mm256_add_epi32(l0, r0), 1);
+        const __m256i s0 = _mm256_sub_epi32(l0, r0);
+
+        _mm256_storeu_si256((__m256i*)(mid + i), m0);
+        _mm256_storeu_si256((__m256i*)(side + i), s0);
+
+        sum[FLAC__STEREO_SIGNAL_LEFT] = add_widened_(sum[FLAC__STEREO_SIGNAL_LEFT], abs_difference_(l0, l1));
+        sum[FLAC__STEREO_SIGNAL_RIGHT] = add_widened_(sum[FLAC__STEREO_SIGNAL_RIGHT], abs_difference_(r0, r1));
+        sum[FLAC__STEREO_SIGNAL_MID] = add_widened_(sum[FLAC__STEREO_SIGNAL_MID], abs_difference_(m0, _mm256_srai_epi32(_mm256_add_epi32(l1, r1), 1)));
+        sum[FLAC__STEREO_SIGNAL_SIDE] = add_widened_(sum[FLAC__STEREO_SIGNAL_SIDE], abs_difference_(s0, _mm256_sub_epi32(l1, r1)));
+    }
+
+    /* the leftover samples, with one sample of history */
+    FLAC__stereo_decorrelate(left + i - 1, right + i - 1, data_len - i + 1, mid + i - 1, side + i - 1, tail);
+    for (k = 0; k < FLAC__STEREO_SIGNALS; k++) {
+        _mm256_storeu_si256((__m256i*)lanes, sum[k]);
+        abs_residual_sum[k] = lanes[0] + lanes[1] + lanes[2] + lanes[3] + tail[k];
+    }
+}
+
+/***********************************************************************
+ *
+ * Private class methods
+ *
+ ***********************************************************************/
+
+/* |x0 - x1|, below 2^31 for input up to FLAC__STEREO_MAX_SIMD_DECORRELATE_BPS */
+FLAC__SSE_TARGET("avx2")
+__m256i abs_difference_(__m256i x0, __m256i x1)
+{
+    return _mm256_abs_epi32(_mm256_sub_epi32(x0, x1));
+}
+
+/* adds the eight non-negative 32-bit lanes of x to the four 64-bit lanes of sum */
+FLAC__SSE_TARGET("avx2")
+__m256i add_widened_(__m256i sum, __m256i x)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    return _mm256_add_epi64(sum, _mm256_add_epi64(_mm256_unpacklo_epi32(x, zero), _mm256_unpackhi_epi32(x, zero)));
+}
+
+FLAC__SSE_TARGET("avx2")
+void restore_left_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len)
+{
+    unsigned i;
+
+    for (i = 0; i + 8 <= data_len; i += 8) {
+        const __m256i left = _mm256_loadu_si256((const __m256i*)(channel0 + i));
+        const __m256i side = _mm256_loadu_si256((const __m256i*)(channel1 + i));
+        _mm256_storeu_si256((__m256i*)(channel1 + i), _mm256_sub_epi32(left, side));
+    }
+    FLAC__stereo_restore_table[FLAC__CHANNEL_ASSIGNMENT_LEFT_SIDE](channel0 + i, channel1 + i, data_len - i);
+}
+
+FLAC__SSE_TARGET("avx2")
+void restore_right_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len)
+{
+    unsigned i;
+
+    for (i = 0; i + 8 <= data_len; i += 8) {
+        const __m256i side = _mm256_loadu_si256((const __m256i*)(channel0 + i));
+        const __m256i right = _mm256_loadu_si256((const __m256i*)(channel1 + i));
+        _mm256_storeu_si256((__m256i*)(channel0 + i), _mm256_add_epi32(side, right));
+    }
+    FLAC__stereo_restore_table[FLAC__CHANNEL_ASSIGNMENT_RIGHT_SIDE](channel0 + i, channel1 + i, data_len - i);
+}
+
+FLAC__SSE_TARGET("avx2")
+void restore_mid_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len)
+{
+    const __m256i one = _mm256_set1_epi32(1);
+    unsigned i;
+
+    for (i = 0; i + 8 <= data_len; i += 8) {
+        const __m256i side = _mm256_loadu_si256((const __m256i*)(channel1 + i));
+        const __m256i mid = _mm256_or_si256(_mm256_slli_epi32(_mm256_loadu_si256((const __m256i*)(channel0 + i)), 1), _mm256_and_si256(side, one));
+        _mm256_storeu_si256((__m256i*)(channel0 + i), _mm256_srai_epi32(_mm256_add_epi32(mid, side), 1));
+        _mm256_storeu_si256((__m256i*)(channel1 + i), _mm256_srai_epi32(_mm256_sub_epi32(mid, side), 1));
+    }
+    FLAC__stereo_restore_table[FLAC__CHANNEL_ASSIGNMENT_MID_SIDE](channel0 + i, channel1 + i, data_len - i);
+}
+
+#endif
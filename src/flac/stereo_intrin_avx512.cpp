@@ -0,0 +1,84 @@
+#include "private/cpu.h"
+
+#ifdef FLAC__AVX512_SUPPORTED
+
+#include <immintrin.h> /* AVX-512F */
+#include "private/stereo.h"
+#include "FLAC/assert.h"
+
+/*
+ * Same as the restore kernels in stereo_intrin_avx2.cpp with sixteen
+ * lanes. Only decoding gets these: the encoder's decorrelation also sums
+ * the residuals, which the AVX2 kernel already does at memory speed.
+ */
+
+/***********************************************************************
+ *
+ * Private class method prototypes
+ *
+ ***********************************************************************/
+
+static void restore_left_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len);
+static void restore_right_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len);
+static void restore_mid_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len);
+
+/***********************************************************************
+ *
+ * Public class data
+ *
+ ***********************************************************************/
+
+const FLAC__StereoRestoreFunction FLAC__stereo_restore_intrin_avx512_table[4] = {
+    0, restore_left_side_, restore_right_side_, restore_mid_side_
+};
+
+/***********************************************************************
+ *
+ * Private class methods
+ *
+ ***********************************************************************/
+
+FLAC__SSE_TARGET("avx512f")
+void restore_left_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len)
+{
+    unsigned i;
+
+    for (i = 0; i + 16 <= data_len; i += 16) {
+        const __m512i left = _mm512_loadu_si512((const void*)(channel0 + i));
+        const __m512i side = _mm512_loadu_si512((const void*)(channel1 + i));
+        _mm512_storeu_si512((void*)(channel1 + i), _mm512_sub_epi32(left, side));
+    }
+    FLAC__stereo_restore_table[FLAC__CHANNEL_ASSIGNMENT_LEFT_SIDE](channel0 + i, channel1 + i, data_len - i);
+}
+
+FLAC__SSE_TARGET("avx512f")
+void restore_right_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len)
+{
+    unsigned i;
+
+    for (i = 0; i + 16 <= data_len; i += 16) {
+        const __m512i side = _mm512_loadu_si512((const void*)(channel0 + i));
+        const __m512i right = _mm512_loadu_si512((const void*)(channel1 + i));
+        _mm512_storeu_si512((void*)(channel0 + i), _mm512_add_epi32(side, right));
+    }
+    FLAC__stereo_restore_table[FLAC__CHANNEL_ASSIGNMENT_RIGHT_SIDE](channel0 + i, channel1 + i, data_len - i);
+}
+
+FLAC__SSE_TARGET("avx512f")
+void restore_mid_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len)
+{
+    const __m512i one = _mm512_set1_epi32(1);
+    /* the zero-masked shifts: the plain ones start from an undefined vector, which GCC warns about */
+    const __mmask16 all = (__mmask16)0xffff;
+    unsigned i;
+
+    for (i = 0; i + 16 <= data_len; i += 16) {
+        const __m512i side = _mm512_loadu_si512((const void*)(channel1 + i));
+        const __m512i mid = _mm512_or_si512(_mm512_maskz_slli_epi32(all, _mm512_loadu_si512((const void*)(channel0 + i)), 1), _mm512_and_si512(side, one));
+        _mm512_storeu_si512((void*)(channel0 + i), _mm512_maskz_srai_epi32(all, _mm512_add_epi32(mid, side), 1));
+        _mm512_storeu_si512((void*)(channel1 + i), _mm512_maskz_srai_epi32(all, _mm512_sub_epi32(mid, side), 1));
+    }
+    FLAC__stereo_restore_table[FLAC__CHANNEL_ASSIGNMENT_MID_SIDE](channel0 + i, channel1 + i, data_len - i);
+}
+
+#endif
@@ -0,0 +1,148 @@
+#include "private/cpu.h"
+
+#ifdef FLAC__SSE4_1_SUPPORTED
+
+#include <smmintrin.h> /* SSE4.1 */
+#include "private/stereo.h"
+#include "FLAC/assert.h"
+
+/*
+ * Both directions are independent from sample to sample, so four
+ * samples are simply done side by side; the few left over at the end go
+ * through the C functions. The results are bit-identical to them.
+ */
+
+/***********************************************************************
+ *
+ * Private class method prototypes
+ *
+ ***********************************************************************/
+
+static void restore_left_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len);
+static void restore_right_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len);
+static void restore_mid_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len);
+static inline __m128i abs_difference_(__m128i x0, __m128i x1);
+static inline __m128i add_widened_(__m128i sum, __m128i x);
+
+/***********************************************************************
+ *
+ * Public class data
+ *
+ ***********************************************************************/
+
+const FLAC__StereoRestoreFunction FLAC__stereo_restore_intrin_sse41_table[4] = {
+    0, restore_left_side_, restore_right_side_, restore_mid_side_
+};
+
+/***********************************************************************
+ *
+ * Public class methods
+ *
+ ***********************************************************************/
+
+FLAC__SSE_TARGET("sse4.1")
+void FLAC__stereo_decorrelate_intrin_sse41(const FLAC__int32 left[], const FLAC__int32 right[], unsigned data_len, FLAC__int32 mid[], FLAC__int32 side[], FLAC__uint64 abs_residual_sum[FLAC__STEREO_SIGNALS])
+{
+    __m128i sum[FLAC__STEREO_SIGNALS];
+    FLAC__uint64 lanes[2], tail[FLAC__STEREO_SIGNALS];
+    unsigned i, k;
+
+    if (data_len < 1 + 4) {
+        FLAC__stereo_decorrelate(left, right, data_len, mid, side, abs_residual_sum);
+        return;
+    }
+
+    for (k = 0; k < FLAC__STEREO_SIGNALS; k++)
+        sum[k] = _mm_setzero_si128();
+    mid[0] = (left[0] + right[0]) >> 1;
+    side[0] = left[0] - right[0];
+
+    /* the history of mid and side is computed again from left and right, rather than read back from what was just stored */
+    for (i = 1; i + 4 <= data_len; i += 4) {
+        const __m128i l0 = _mm_loadu_si128((const __m128i*)(left + i));
+        const __m128i l1 = _mm_loadu_si128((const __m128i*)(left + i - 1));
+        const __m128i r0 = _mm_loadu_si128((const __m128i*)(right + i));
+        const __m128i r1 = _mm_loadu_si128((const __m128i*)(right + i - 1));
+        const __m128i m0 = _mm_srai_epi32(_mm_add_epi32(l0, r0), 1);
+        const __m128i s0 = _mm_sub_epi32(l0, r0);
+
+        _mm_storeu_si128((__m128i*)(mid + i), m0);
+        _mm_storeu_si128((__m128i*)(side + i), s0);
+
+        sum[FLAC__STEREO_SIGNAL_LEFT] = add_widened_(sum[FLAC__STEREO_SIGNAL_LEFT], abs_difference_(l0, l1));
+        sum[FLAC__STEREO_SIGNAL_RIGHT] = add_widened_(sum[FLAC__STEREO_SIGNAL_RIGHT], abs_difference_(r0, r1));
+        sum[FLAC__STEREO_SIGNAL_MID] = add_widened_(sum[FLAC__STEREO_SIGNAL_MID], abs_difference_(m0, _mm_srai_epi32(_mm_add_epi32(l1, r1), 1)));
+        sum[FLAC__STEREO_SIGNAL_SIDE] = add_widened_(sum[FLAC__STEREO_SIGNAL_SIDE], abs_difference_(s0, _mm_sub_epi32(l1, r1)));
+    }
+
+    /* the leftover samples, with one sample of history */
+    FLAC__stereo_decorrelate(left + i - 1, right + i - 1, data_len - i + 1, mid + i - 1, side + i - 1, tail);
+    for (k = 0; k < FLAC__STEREO_SIGNALS; k++) {
+        _mm_storeu_si128((__m128i*)lanes, sum[k]);
+        abs_residual_sum[k] = lanes[0] + lanes[1] + tail[k];
+    }
+}
+
+/***********************************************************************
+ *
+ * Private class methods
+ *
+ ***********************************************************************/
+
+/* |x0 - x1|, below 2^31 for input up to FLAC__STEREO_MAX_SIMD_DECORRELATE_BPS */
+FLAC__SSE_TARGET("sse4.1")
+__m128i abs_difference_(__m128i x0, __m128i x1)
+{
+    return _mm_abs_epi32(_mm_sub_epi32(x0, x1));
+}
+
+/* adds the four non-negative 32-bit lanes of x to the two 64-bit lanes of sum */
+FLAC__SSE_TARGET("sse4.1")
+__m128i add_widened_(__m128i sum, __m128i x)
+{
+    const __m128i zero = _mm_setzero_si128();
+    return _mm_add_epi64(sum, _mm_add_epi64(_mm_unpacklo_epi32(x, zero), _mm_unpackhi_epi32(x, zero)));
+}
+
+FLAC__SSE_TARGET("sse4.1")
+void restore_left_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len)
+{
+    unsigned i;
+
+    for (i = 0; i + 4 <= data_len; i += 4) {
+        const __m128i left = _mm_loadu_si128((const __m128i*)(channel0 + i));
+        const __m128i side = _mm_loadu_si128((const __m128i*)(channel1 + i));
+        _mm_storeu_si128((__m128i*)(channel1 + i), _mm_sub_epi32(left, side));
+    }
+    FLAC__stereo_restore_table[FLAC__CHANNEL_ASSIGNMENT_LEFT_SIDE](channel0 + i, channel1 + i, data_len - i);
+}
+
+FLAC__SSE_TARGET("sse4.1")
+void restore_right_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len)
+{
+    unsigned i;
+
+    for (i = 0; i + 4 <= data_len; i += 4) {
+        const __m128i side = _mm_loadu_si128((const __m128i*)(channel0 + i));
+        const __m128i right = _mm_loadu_si128((const __m128i*)(channel1 + i));
+        _mm_storeu_si128((__m128i*)(channel0 + i), _mm_add_epi32(side, right));
+    }
+    FLAC__stereo_restore_table[FLAC__CHANNEL_ASSIGNMENT_RIGHT_SIDE](channel0 + i, channel1 + i, data_len - i);
+}
+
+FLAC__SSE_TARGET("sse4.1")
+void restore_mid_side_(FLAC__int32 channel0[], FLAC__int32 channel1[], unsigned data_len)
+{
+    const __m128i one = _mm_set1_epi32(1);
+    unsigned i;
+
+    for (i = 0; i + 4 <= data_len; i += 4) {
+        const __m128i side = _mm_loadu_si128((const __m128i*)(channel1 + i));
+        const __m128i mid = _mm_or_si128(_mm_slli_epi32(_mm_loadu_si128((const __m128i*)(channel0 + i)), 1), _mm_and_si128(side, one));
+        _mm_storeu_si128((__m128i*)(channel0 + i), _mm_srai_epi32(_mm_add_epi32(mid, side), 1));
+        _mm_storeu_si128((__m128i*)(channel1 + i), _mm_srai_epi32(_mm_sub_epi32(mid, side), 1));
+    }
+    FLAC__stereo_restore_table[FLAC__CHANNEL_ASSIGNMENT_MID_SIDE](channel0 + i, channel1 + i, data_len - i);
+}
+
+#endif
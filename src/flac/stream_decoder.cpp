@@ -0,0 +1,2370 @@
+#include <stdio.h>      // for SEEK_CUR
+#include <stdlib.h>
+#include <string.h>
+#include "FLAC/assert.h"
+#include "FLAC/stream_decoder.h"
+#include "private/arena.h"
+#include "private/bitreader.h"
+#include "private/crc.h"
+#include "private/dispatch.h"
+#include "private/fixed.h"
+#include "private/format.h"
+#include "private/frame_header.h"
+#include "private/lpc.h"
+#include "private/macros.h"
+#include "private/ogg.h"
+#include "private/pcm.h"
+#include "private/stereo.h"
+
+/***********************************************************************
+ *
+ * Private static data
+ *
+ ***********************************************************************/
+
+static const FLAC__byte ID3V2_TAG_[3] = { 'I', 'D', '3' };
+
+/* what a push decoder made of the bytes it has */
+typedef enum {
+    PUSH_STEP_NEED_MORE = 0, /* nothing more can be done until more bytes arrive */
+    PUSH_STEP_PROGRESS,
+    PUSH_STEP_FATAL /* the decoder state says why */
+} PushStep;
+
+/***********************************************************************
+ *
+ * Private class method prototypes
+ *
+ ***********************************************************************/
+
+static void set_defaults_(FLAC__StreamDecoder *decoder);
+static FLAC__uint64 get_position_(const FLAC__StreamDecoder *decoder);
+static FLAC__StreamDecoderInitStatus init_stream_(FLAC__StreamDecoder *decoder, FLAC__BitReaderReadCallback read_callback);
+static FLAC__bool allocate_scratch_(FLAC__StreamDecoder *decoder, unsigned size, unsigned channels, unsigned bits_per_sample);
+static void layout_scratch_(FLAC__StreamDecoder *decoder, unsigned size, unsigned channels, unsigned order, FLAC__bool side, FLAC__bool planar_output);
+static FLAC__bool find_metadata_(FLAC__StreamDecoder *decoder);
+static FLAC__bool read_metadata_(FLAC__StreamDecoder *decoder);
+static FLAC__bool read_metadata_streaminfo_(FLAC__StreamDecoder *decoder, unsigned length);
+static FLAC__bool skip_metadata_block_(FLAC__StreamDecoder *decoder, unsigned length);
+static FLAC__bool skip_id3v2_tag_(FLAC__StreamDecoder *decoder);
+static FLAC__bool frame_sync_(FLAC__StreamDecoder *decoder);
+static FLAC__bool read_frame_(FLAC__StreamDecoder *decoder, FLAC__bool *got_a_frame, FLAC__int32 * const buffer[], unsigned capacity);
+static FLAC__bool trim_seek_frame_(FLAC__StreamDecoder *decoder, FLAC__int32 * const buffer[]);
+static FLAC__bool read_frame_header_(FLAC__StreamDecoder *decoder);
+static FLAC__bool read_subframe_(FLAC__StreamDecoder *decoder, unsigned channel, unsigned bps, FLAC__int32 *output);
+static FLAC__bool read_subframe_constant_(FLAC__StreamDecoder *decoder, unsigned channel, unsigned bps, FLAC__int32 *out32, FLAC__int64 *out64);
+static FLAC__bool read_subframe_fixed_(FLAC__StreamDecoder *decoder, unsigned channel, unsigned bps, const unsigned order, FLAC__int32 *out32, FLAC__int64 *out64);
+static FLAC__bool read_subframe_lpc_(FLAC__StreamDecoder *decoder, unsigned channel, unsigned bps, const unsigned order, FLAC__int32 *out32, FLAC__int64 *out64);
+static FLAC__bool read_subframe_verbatim_(FLAC__StreamDecoder *decoder, unsigned channel, unsigned bps, FLAC__int32 *out32, FLAC__int64 *out64);
+static FLAC__bool read_entropy_coding_method_(FLAC__StreamDecoder *decoder, unsigned channel, unsigned predictor_order, FLAC__EntropyCodingMethod *method);
+static FLAC__bool read_residual_partitioned_rice_(FLAC__StreamDecoder *decoder, unsigned predictor_order, unsigned partition_order, FLAC__EntropyCodingMethod_PartitionedRiceContents *partitioned_rice_contents, FLAC__int32 *residual, FLAC__bool is_extended);
+static FLAC__bool read_zero_padding_(FLAC__StreamDecoder *decoder);
+static void undo_channel_coding_(FLAC__StreamDecoder *decoder, FLAC__int32 * const buffer[]);
+static void send_error_to_client_(const FLAC__StreamDecoder *decoder, FLAC__StreamDecoderErrorStatus status);
+static FLAC__bool read_callback_(FLAC__byte buffer[], size_t *bytes, void *client_data);
+static FLAC__bool end_of_memory_callback_(FLAC__byte buffer[], size_t *bytes, void *client_data);
+static FLAC__bool ogg_read_callback_(FLAC__byte buffer[], size_t *bytes, void *client_data);
+static FLAC__bool ogg_refill_(FLAC__StreamDecoder *decoder);
+static FLAC__bool reserve_push_buffer_(FLAC__StreamDecoder *decoder, size_t bytes);
+static void push_consume_(FLAC__StreamDecoder *decoder, const FLAC__byte **data, size_t *bytes, size_t n);
+static PushStep push_metadata_(FLAC__StreamDecoder *decoder, const FLAC__byte **data, size_t *bytes);
+static PushStep push_frame_(FLAC__StreamDecoder *decoder, const FLAC__byte **data, size_t *bytes);
+static PushStep push_candidate_(FLAC__StreamDecoder *decoder, const FLAC__byte **data, size_t *bytes, size_t p);
+static PushStep push_decode_frame_(FLAC__StreamDecoder *decoder, const FLAC__byte **data, size_t *bytes, size_t end);
+
+/***********************************************************************
+ *
+ * Private class data
+ *
+ ***********************************************************************/
+
+struct FLAC__StreamDecoder {
+    FLAC__StreamDecoderState state;
+
+    FLAC__IOHandle handle;
+    FLAC__IOCallbacks callbacks;
+    FLAC__StreamDecoderErrorCallback error_callback;
+    void *client_data;
+
+    /* the bit buffer, allocated once and reused across streams */
+    FLAC__BitReader *input;
+    /* the stream position of the next byte the read callback will deliver */
+    FLAC__uint64 stream_offset;
+    /* set when decoding from memory instead of through the callbacks */
+    const FLAC__byte *memory;
+    size_t memory_bytes;
+    /* the decode position of the first frame, where seek index offsets count from */
+    FLAC__uint64 first_frame_offset;
+    /* set by a seek: frames before the target are dropped, the one holding it is trimmed */
+    FLAC__bool seek_pending;
+    FLAC__uint64 seek_target;
+
+    /*
+     * push mode: the bytes pushed and not used up yet (a frame being
+     * assembled always starts at push_buffer[0]) and how far the frame
+     * has been looked at; the positions are relative to the frame start
+     */
+    FLAC__bool push;
+    FLAC__StreamDecoderFrameCallback frame_callback;
+    void *frame_client_data;
+    FLAC__byte *push_buffer;
+    size_t push_bytes, push_capacity;
+    size_t push_skip; /* bytes to drop as they arrive: an ID3v2 tag, a metadata block */
+    FLAC__MetadataWalk push_walk; /* where the metadata is up to */
+    FLAC__bool push_in_frame; /* a valid frame header has been found */
+    unsigned push_header_length;
+    unsigned push_crc; /* the CRC-16 of the frame bytes before push_scan */
+    size_t push_scan;
+    size_t push_tried; /* the last end that was decoded and ran out of data */
+    size_t push_resync; /* the first valid frame header inside the frame, 0 if none */
+    size_t push_pending; /* the first possible frame header the data stopped in, 0 if none */
+    size_t push_bound; /* past this the frame is damaged */
+    FLAC__bool push_lost_sync; /* LOST_SYNC has been reported for the bytes being skipped */
+    FLAC__bool push_final; /* no more bytes will come, see FLAC__stream_decoder_push_end_of_stream() */
+
+    /*
+     * push mode and FLAC__stream_decoder_decode_frame_interleaved() decode
+     * into planar_output, carved out of 'scratch' with the rest
+     */
+    FLAC__bool interleaved;
+    FLAC__int32 *planar_output[FLAC__MAX_CHANNELS];
+
+    /*
+     * Ogg FLAC: pages are parsed out of a window, the client's memory or
+     * ogg_buffer refilled through the read callback, and the bodies of
+     * the FLAC stream's pages go to the bit reader as its memory source;
+     * stream_offset counts the bytes handed over, so positions are
+     * offsets into the native stream
+     */
+    FLAC__bool ogg;
+    const FLAC__byte *ogg_window;
+    size_t ogg_window_bytes, ogg_pos;
+    FLAC__byte *ogg_buffer; /* FLAC__OGG_MAX_PAGE_BYTES * 2, kept across streams */
+    FLAC__bool ogg_have_serial; /* the first FLAC BOS page has been found */
+    FLAC__uint32 ogg_serial;
+    FLAC__bool ogg_eos;
+
+    FLAC__bool has_stream_info;
+    FLAC__StreamMetadata_StreamInfo stream_info;
+
+    /*
+     * per-channel scratch, all in one block; sized from STREAMINFO, never
+     * reallocated per frame, and kept for the next stream
+     */
+    FLAC__Arena scratch;
+    unsigned output_capacity, output_channels;
+    FLAC__int32 *residual[FLAC__MAX_CHANNELS];
+    FLAC__EntropyCodingMethod_PartitionedRiceContents partitioned_rice_contents[FLAC__MAX_CHANNELS];
+    /* the side channel of a 32-bit stereo stream needs 33 bits; only laid out for such streams */
+    FLAC__int64 *side_subframe;
+    FLAC__bool side_subframe_in_use;
+
+    FLAC__Frame frame;
+    FLAC__uint64 samples_decoded;
+    FLAC__byte header_warmup[2]; /* contains the sync code and reserved bits */
+    FLAC__byte lookahead; /* temp storage when we need to look ahead one byte in the stream */
+    FLAC__bool cached; /* true if there is a byte in lookahead */
+
+    /* the kernels for this machine; the local_ ones below are copied out of it */
+    const FLAC__Dispatch *dispatch;
+    FLAC__bool (*local_bitreader_read_rice_signed_block)(FLAC__BitReader *br, int vals[], unsigned nvals, unsigned parameter);
+    /*
+     * these are the LPC restore routines used for this stream; 32-bit
+     * accumulation is only safe when the prediction cannot overflow.
+     */
+    void (*local_lpc_restore_signal)(const FLAC__int32 residual[], unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int32 data[]);
+    void (*local_lpc_restore_signal_64bit)(const FLAC__int32 residual[], unsigned data_len, const FLAC__int32 qlp_coeff[], unsigned order, int lp_quantization, FLAC__int32 data[]);
+    /* undoes the stereo channel coding when the side channel fits in 32 bits, indexed by the channel assignment */
+    const FLAC__StereoRestoreFunction *local_stereo_restore;
+    /* indexed by the bytes per output sample minus one */
+    const FLAC__PcmInterleaveFunction *local_pcm_interleave;
+};
+
+/***********************************************************************
+ *
+ * Public static class data
+ *
+ ***********************************************************************/
+
+FLAC_API const char * const FLAC__StreamDecoderStateString[] = {
+    "FLAC__STREAM_DECODER_SEARCH_FOR_METADATA",
+    "FLAC__STREAM_DECODER_READ_METADATA",
+    "FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC",
+    "FLAC__STREAM_DECODER_READ_FRAME",
+    "FLAC__STREAM_DECODER_END_OF_STREAM",
+    "FLAC__STREAM_DECODER_SEEK_ERROR",
+    "FLAC__STREAM_DECODER_ABORTED",
+    "FLAC__STREAM_DECODER_MEMORY_ALLOCATION_ERROR",
+    "FLAC__STREAM_DECODER_UNINITIALIZED"
+};
+
+FLAC_API const char * const FLAC__StreamDecoderInitStatusString[] = {
+    "FLAC__STREAM_DECODER_INIT_STATUS_OK",
+    "FLAC__STREAM_DECODER_INIT_STATUS_INVALID_CALLBACKS",
+    "FLAC__STREAM_DECODER_INIT_STATUS_MEMORY_ALLOCATION_ERROR",
+    "FLAC__STREAM_DECODER_INIT_STATUS_ALREADY_INITIALIZED"
+};
+
+FLAC_API const char * const FLAC__StreamDecoderErrorStatusString[] = {
+    "FLAC__STREAM_DECODER_ERROR_STATUS_LOST_SYNC",
+    "FLAC__STREAM_DECODER_ERROR_STATUS_BAD_HEADER",
+    "FLAC__STREAM_DECODER_ERROR_STATUS_FRAME_CRC_MISMATCH",
+    "FLAC__STREAM_DECODER_ERROR_STATUS_UNPARSEABLE_STREAM"
+};
+
+/***********************************************************************
+ *
+ * Class constructor/destructor
+ *
+ ***********************************************************************/
+
+FLAC_API FLAC__StreamDecoder *FLAC__stream_decoder_new(void)
+{
+    FLAC__StreamDecoder *decoder;
+
+    decoder = (FLAC__StreamDecoder*)calloc(1, sizeof(FLAC__StreamDecoder));
+    if (decoder == 0)
+        return 0;
+
+    decoder->input = FLAC__bitreader_new();
+    if (decoder->input == 0) {
+        free(decoder);
+        return 0;
+    }
+    FLAC__arena_init(&decoder->scratch);
+
+    set_defaults_(decoder);
+
+    decoder->state = FLAC__STREAM_DECODER_UNINITIALIZED;
+
+    return decoder;
+}
+
+FLAC_API void FLAC__stream_decoder_delete(FLAC__StreamDecoder *decoder)
+{
+    if (decoder == 0)
+        return;
+
+    (void)FLAC__stream_decoder_finish(decoder);
+
+    FLAC__bitreader_delete(decoder->input);
+
+    FLAC__arena_free(&decoder->scratch);
+    free(decoder->push_buffer);
+    free(decoder->ogg_buffer);
+
+    free(decoder);
+}
+
+/***********************************************************************
+ *
+ * Public class methods
+ *
+ ***********************************************************************/
+
+FLAC_API FLAC__StreamDecoderInitStatus FLAC__stream_decoder_init(FLAC__StreamDecoder *decoder, FLAC__IOHandle handle, FLAC__IOCallbacks callbacks)
+{
+    FLAC_ASSERT(0 != decoder);
+
+    if (decoder->state != FLAC__STREAM_DECODER_UNINITIALIZED)
+        return FLAC__STREAM_DECODER_INIT_STATUS_ALREADY_INITIALIZED;
+
+    if (callbacks.read == 0)
+        return FLAC__STREAM_DECODER_INIT_STATUS_INVALID_CALLBACKS;
+
+    decoder->handle = handle;
+    decoder->callbacks = callbacks;
+
+    decoder->stream_offset = 0;
+    if (callbacks.tell) {
+        const FLAC__int64 pos = callbacks.tell(handle);
+        if (pos > 0)
+            decoder->stream_offset = (FLAC__uint64)pos;
+    }
+
+    return init_stream_(decoder, read_callback_);
+}
+
+FLAC_API FLAC__StreamDecoderInitStatus FLAC__stream_decoder_init_memory(FLAC__StreamDecoder *decoder, const FLAC__byte *data, size_t bytes)
+{
+    FLAC__StreamDecoderInitStatus status;
+
+    FLAC_ASSERT(0 != decoder);
+
+    if (decoder->state != FLAC__STREAM_DECODER_UNINITIALIZED)
+        return FLAC__STREAM_DECODER_INIT_STATUS_ALREADY_INITIALIZED;
+
+    if (data == 0 && bytes > 0)
+        return FLAC__STREAM_DECODER_INIT_STATUS_INVALID_CALLBACKS;
+
+    decoder->memory = data;
+    decoder->memory_bytes = bytes;
+    decoder->stream_offset = 0;
+
+    status = init_stream_(decoder, end_of_memory_callback_);
+    if (status == FLAC__STREAM_DECODER_INIT_STATUS_OK)
+        FLAC__bitreader_set_source(decoder->input, data, bytes);
+    return status;
+}
+
+FLAC_API FLAC__StreamDecoderInitStatus FLAC__stream_decoder_init_memory_frames(FLAC__StreamDecoder *decoder, const FLAC__StreamMetadata_StreamInfo *stream_info, const FLAC__byte *data, size_t bytes)
+{
+    FLAC__StreamDecoderInitStatus status;
+
+    status = FLAC__stream_decoder_init_memory(decoder, data, bytes);
+    if (status != FLAC__STREAM_DECODER_INIT_STATUS_OK)
+        return status;
+
+    if (stream_info != 0) {
+        decoder->stream_info = *stream_info;
+        decoder->has_stream_info = true;
+        if (!allocate_scratch_(decoder, stream_info->max_blocksize, stream_info->channels, stream_info->bits_per_sample))
+            return FLAC__STREAM_DECODER_INIT_STATUS_MEMORY_ALLOCATION_ERROR;
+    }
+    /* no metadata, the frames start right away */
+    decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+    return FLAC__STREAM_DECODER_INIT_STATUS_OK;
+}
+
+FLAC_API FLAC__StreamDecoderInitStatus FLAC__stream_decoder_init_ogg(FLAC__StreamDecoder *decoder, FLAC__IOHandle handle, FLAC__IOCallbacks callbacks)
+{
+    FLAC__StreamDecoderInitStatus status;
+
+    FLAC_ASSERT(0 != decoder);
+
+    if (decoder->state != FLAC__STREAM_DECODER_UNINITIALIZED)
+        return FLAC__STREAM_DECODER_INIT_STATUS_ALREADY_INITIALIZED;
+
+    if (callbacks.read == 0)
+        return FLAC__STREAM_DECODER_INIT_STATUS_INVALID_CALLBACKS;
+
+    /* room for a page that starts just before the end of the last read */
+    if (decoder->ogg_buffer == 0) {
+        decoder->ogg_buffer = (FLAC__byte*)malloc(2 * FLAC__OGG_MAX_PAGE_BYTES);
+        if (decoder->ogg_buffer == 0)
+            return FLAC__STREAM_DECODER_INIT_STATUS_MEMORY_ALLOCATION_ERROR;
+    }
+
+    decoder->handle = handle;
+    decoder->callbacks = callbacks;
+    decoder->stream_offset = 0;
+
+    status = init_stream_(decoder, ogg_read_callback_);
+    if (status != FLAC__STREAM_DECODER_INIT_STATUS_OK)
+        return status;
+
+    decoder->ogg = true;
+    decoder->ogg_window = decoder->ogg_buffer;
+    return FLAC__STREAM_DECODER_INIT_STATUS_OK;
+}
+
+FLAC_API FLAC__StreamDecoderInitStatus FLAC__stream_decoder_init_ogg_memory(FLAC__StreamDecoder *decoder, const FLAC__byte *data, size_t bytes)
+{
+    FLAC__StreamDecoderInitStatus status;
+
+    FLAC_ASSERT(0 != decoder);
+
+    if (decoder->state != FLAC__STREAM_DECODER_UNINITIALIZED)
+        return FLAC__STREAM_DECODER_INIT_STATUS_ALREADY_INITIALIZED;
+
+    if (data == 0 && bytes > 0)
+        return FLAC__STREAM_DECODER_INIT_STATUS_INVALID_CALLBACKS;
+
+    decoder->stream_offset = 0;
+
+    status = init_stream_(decoder, ogg_read_callback_);
+    if (status != FLAC__STREAM_DECODER_INIT_STATUS_OK)
+        return status;
+
+    decoder->ogg = true;
+    decoder->ogg_window = data;
+    decoder->ogg_window_bytes = bytes;
+    return FLAC__STREAM_DECODER_INIT_STATUS_OK;
+}
+
+FLAC_API FLAC__StreamDecoderInitStatus FLAC__stream_decoder_init_push(FLAC__StreamDecoder *decoder, FLAC__StreamDecoderFrameCallback callback, void *client_data)
+{
+    FLAC__StreamDecoderInitStatus status;
+
+    FLAC_ASSERT(0 != decoder);
+
+    if (decoder->state != FLAC__STREAM_DECODER_UNINITIALIZED)
+        return FLAC__STREAM_DECODER_INIT_STATUS_ALREADY_INITIALIZED;
+
+    if (callback == 0)
+        return FLAC__STREAM_DECODER_INIT_STATUS_INVALID_CALLBACKS;
+
+    /* every frame is decoded out of memory, the bytes pushed so far */
+    decoder->stream_offset = 0;
+    status = init_stream_(decoder, end_of_memory_callback_);
+    if (status != FLAC__STREAM_DECODER_INIT_STATUS_OK)
+        return status;
+
+    decoder->push = true;
+    decoder->frame_callback = callback;
+    decoder->frame_client_data = client_data;
+    FLAC__format_metadata_walk_init(&decoder->push_walk);
+    return FLAC__STREAM_DECODER_INIT_STATUS_OK;
+}
+
+FLAC_API FLAC__bool FLAC__stream_decoder_push(FLAC__StreamDecoder *decoder, const FLAC__byte *data, size_t bytes)
+{
+    const FLAC__byte *window;
+    size_t window_bytes, skip;
+    PushStep step;
+
+    FLAC_ASSERT(0 != decoder);
+    FLAC_ASSERT(0 != data || bytes == 0);
+
+    if (!decoder->push)
+        return false;
+    switch (decoder->state) {
+        case FLAC__STREAM_DECODER_SEARCH_FOR_METADATA:
+        case FLAC__STREAM_DECODER_READ_METADATA:
+        case FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC:
+            break;
+        default:
+            return false;
+    }
+
+    /* what is being skipped is dropped without being buffered; nothing is buffered while skipping */
+    skip = flac_min(decoder->push_skip, bytes);
+    decoder->push_skip -= skip;
+    data += skip;
+    bytes -= skip;
+    if (bytes == 0)
+        return true;
+
+    /* with nothing left over from the last push, work straight out of the caller's bytes */
+    if (decoder->push_bytes > 0) {
+        if (!reserve_push_buffer_(decoder, decoder->push_bytes + bytes))
+            return false;
+        memcpy(decoder->push_buffer + decoder->push_bytes, data, bytes);
+        decoder->push_bytes += bytes;
+        window = decoder->push_buffer;
+        window_bytes = decoder->push_bytes;
+    }
+    else {
+        window = data;
+        window_bytes = bytes;
+    }
+
+    do {
+        if (decoder->state == FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC)
+            step = push_frame_(decoder, &window, &window_bytes);
+        else
+            step = push_metadata_(decoder, &window, &window_bytes);
+    } while (step == PUSH_STEP_PROGRESS);
+
+    /* keep the start of the next frame (or metadata block) for the next push */
+    if (window_bytes > 0 && window != decoder->push_buffer) {
+        if (decoder->push_bytes > 0)
+            memmove(decoder->push_buffer, window, window_bytes);
+        else {
+            if (!reserve_push_buffer_(decoder, window_bytes))
+                return false;
+            memcpy(decoder->push_buffer, window, window_bytes);
+        }
+    }
+    decoder->push_bytes = window_bytes;
+
+    return step != PUSH_STEP_FATAL;
+}
+
+FLAC_API FLAC__bool FLAC__stream_decoder_push_end_of_stream(FLAC__StreamDecoder *decoder)
+{
+    const FLAC__byte *window;
+    size_t window_bytes;
+    PushStep step;
+
+    FLAC_ASSERT(0 != decoder);
+
+    if (!decoder->push)
+        return false;
+    switch (decoder->state) {
+        case FLAC__STREAM_DECODER_SEARCH_FOR_METADATA:
+        case FLAC__STREAM_DECODER_READ_METADATA:
+        case FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC:
+            break;
+        default:
+            return false;
+    }
+
+    /* what is left over ends where it ends: the last frame, or bytes that are not a frame */
+    decoder->push_final = true;
+    window = decoder->push_buffer;
+    window_bytes = decoder->push_bytes;
+    do {
+        if (decoder->state == FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC)
+            step = push_frame_(decoder, &window, &window_bytes);
+        else
+            step = push_metadata_(decoder, &window, &window_bytes);
+    } while (step == PUSH_STEP_PROGRESS);
+
+    decoder->push_bytes = 0;
+    decoder->push_in_frame = false;
+    if (step == PUSH_STEP_FATAL)
+        return false;
+    decoder->state = FLAC__STREAM_DECODER_END_OF_STREAM;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_decoder_finish(FLAC__StreamDecoder *decoder)
+{
+    FLAC_ASSERT(0 != decoder);
+
+    if (decoder->state == FLAC__STREAM_DECODER_UNINITIALIZED)
+        return true;
+
+    /* keep the bit buffer and the scratch arrays for the next stream */
+    FLAC__bitreader_clear(decoder->input);
+
+    set_defaults_(decoder);
+
+    decoder->state = FLAC__STREAM_DECODER_UNINITIALIZED;
+
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_decoder_set_error_callback(FLAC__StreamDecoder *decoder, FLAC__StreamDecoderErrorCallback callback, void *client_data)
+{
+    FLAC_ASSERT(0 != decoder);
+
+    if (decoder->state != FLAC__STREAM_DECODER_UNINITIALIZED)
+        return false;
+    decoder->error_callback = callback;
+    decoder->client_data = client_data;
+    return true;
+}
+
+FLAC_API FLAC__StreamDecoderState FLAC__stream_decoder_get_state(const FLAC__StreamDecoder *decoder)
+{
+    FLAC_ASSERT(0 != decoder);
+    return decoder->state;
+}
+
+FLAC_API const char *FLAC__stream_decoder_get_resolved_state_string(const FLAC__StreamDecoder *decoder)
+{
+    return FLAC__StreamDecoderStateString[decoder->state];
+}
+
+FLAC_API const FLAC__StreamMetadata_StreamInfo *FLAC__stream_decoder_get_stream_info(const FLAC__StreamDecoder *decoder)
+{
+    FLAC_ASSERT(0 != decoder);
+    return decoder->has_stream_info ? &decoder->stream_info : 0;
+}
+
+FLAC_API FLAC__bool FLAC__stream_decoder_get_decode_position(const FLAC__StreamDecoder *decoder, FLAC__uint64 *position)
+{
+    FLAC_ASSERT(0 != decoder);
+    FLAC_ASSERT(0 != position);
+
+    if (decoder->state == FLAC__STREAM_DECODER_UNINITIALIZED)
+        return false;
+
+    *position = get_position_(decoder);
+    return true;
+}
+
+FLAC_API const FLAC__Frame *FLAC__stream_decoder_get_frame(const FLAC__StreamDecoder *decoder)
+{
+    FLAC_ASSERT(0 != decoder);
+    return &decoder->frame;
+}
+
+FLAC_API FLAC__bool FLAC__stream_decoder_process_until_end_of_metadata(FLAC__StreamDecoder *decoder)
+{
+    FLAC_ASSERT(0 != decoder);
+
+    if (decoder->push)
+        return false;
+
+    while (1) {
+        switch (decoder->state) {
+            case FLAC__STREAM_DECODER_SEARCH_FOR_METADATA:
+                if (!find_metadata_(decoder))
+                    return false; /* above function sets the status for us */
+                break;
+            case FLAC__STREAM_DECODER_READ_METADATA:
+                if (!read_metadata_(decoder))
+                    return false; /* above function sets the status for us */
+                break;
+            case FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC:
+            case FLAC__STREAM_DECODER_READ_FRAME:
+                return true;
+            default:
+                return false;
+        }
+    }
+}
+
+FLAC_API FLAC__bool FLAC__stream_decoder_decode_frame(FLAC__StreamDecoder *decoder, FLAC__int32 * const buffer[], unsigned capacity, FLAC__FrameHeader *header)
+{
+    FLAC__bool got_a_frame;
+
+    FLAC_ASSERT(0 != decoder);
+    FLAC_ASSERT(0 != buffer);
+
+    if (decoder->push)
+        return false;
+
+    while (1) {
+        switch (decoder->state) {
+            case FLAC__STREAM_DECODER_SEARCH_FOR_METADATA:
+                if (!find_metadata_(decoder))
+                    return false; /* above function sets the status for us */
+                break;
+            case FLAC__STREAM_DECODER_READ_METADATA:
+                if (!read_metadata_(decoder))
+                    return false; /* above function sets the status for us */
+                break;
+            case FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC:
+                if (!frame_sync_(decoder))
+                    return false; /* above function sets the status for us */
+                break;
+            case FLAC__STREAM_DECODER_READ_FRAME:
+                if (!read_frame_(decoder, &got_a_frame, buffer, capacity))
+                    return false; /* above function sets the status for us */
+                if (got_a_frame && (!decoder->seek_pending || trim_seek_frame_(decoder, buffer))) {
+                    if (header)
+                        *header = decoder->frame.header;
+                    return true;
+                }
+                break;
+            default:
+                return false;
+        }
+    }
+}
+
+FLAC_API FLAC__bool FLAC__stream_decoder_decode_frame_interleaved(FLAC__StreamDecoder *decoder, unsigned bits_per_sample, FLAC__byte pcm[], unsigned capacity, FLAC__FrameHeader *header)
+{
+    FLAC__FrameHeader frame_header;
+
+    FLAC_ASSERT(0 != decoder);
+    FLAC_ASSERT(0 != pcm);
+
+    if (bits_per_sample < FLAC__MIN_BITS_PER_SAMPLE || bits_per_sample > FLAC__MAX_BITS_PER_SAMPLE)
+        return false;
+
+    /* the frames go to planar_output first, laid out by read_frame_() from now on */
+    decoder->interleaved = true;
+    if (!FLAC__stream_decoder_decode_frame(decoder, decoder->planar_output, capacity, &frame_header))
+        return false;
+    (void)FLAC__stream_decoder_interleave(decoder, decoder->planar_output, &frame_header, bits_per_sample, pcm);
+    if (header)
+        *header = frame_header;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_decoder_interleave(const FLAC__StreamDecoder *decoder, const FLAC__int32 * const buffer[], const FLAC__FrameHeader *header, unsigned bits_per_sample, FLAC__byte pcm[])
+{
+    FLAC_ASSERT(0 != decoder);
+    FLAC_ASSERT(0 != buffer);
+    FLAC_ASSERT(0 != header);
+    FLAC_ASSERT(0 != pcm);
+
+    if (bits_per_sample < FLAC__MIN_BITS_PER_SAMPLE || bits_per_sample > FLAC__MAX_BITS_PER_SAMPLE)
+        return false;
+
+    decoder->local_pcm_interleave[(bits_per_sample + 7) / 8 - 1](buffer, header->channels, header->blocksize, (int)bits_per_sample - (int)header->bits_per_sample, pcm);
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_decoder_seek_absolute(FLAC__StreamDecoder *decoder, const FLAC__SeekIndex *index, FLAC__uint64 sample)
+{
+    FLAC__StreamMetadata_SeekPoint point;
+    FLAC__uint64 target;
+
+    FLAC_ASSERT(0 != decoder);
+    FLAC_ASSERT(0 != index);
+
+    /* the seek index offsets are into the native stream, which is not where Ogg pages are */
+    if (decoder->push || decoder->ogg)
+        return false;
+
+    switch (decoder->state) {
+        case FLAC__STREAM_DECODER_SEARCH_FOR_METADATA:
+        case FLAC__STREAM_DECODER_READ_METADATA:
+            if (!FLAC__stream_decoder_process_until_end_of_metadata(decoder))
+                return false;
+            break;
+        case FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC:
+        case FLAC__STREAM_DECODER_READ_FRAME:
+        case FLAC__STREAM_DECODER_END_OF_STREAM:
+        case FLAC__STREAM_DECODER_SEEK_ERROR:
+            break;
+        default:
+            return false;
+    }
+
+    if (decoder->has_stream_info && decoder->stream_info.total_samples > 0 && sample >= decoder->stream_info.total_samples)
+        return false;
+    if (decoder->memory == 0 && decoder->callbacks.seek == 0)
+        return false;
+
+    /* without a point at or before the sample, start from the first frame */
+    if (!FLAC__seek_index_lookup(index, sample, &point))
+        point.stream_offset = 0;
+    target = decoder->first_frame_offset + point.stream_offset;
+
+    if (decoder->memory != 0) {
+        if (target > decoder->memory_bytes) {
+            decoder->state = FLAC__STREAM_DECODER_SEEK_ERROR;
+            return false;
+        }
+        FLAC__bitreader_clear(decoder->input);
+        FLAC__bitreader_set_source(decoder->input, decoder->memory + target, decoder->memory_bytes - (size_t)target);
+    }
+    else {
+        /* stream_offset is where the handle is, so this works without a tell callback too */
+        if (decoder->callbacks.seek(decoder->handle, (FLAC__int64)(target - decoder->stream_offset), SEEK_CUR) != 0) {
+            decoder->state = FLAC__STREAM_DECODER_SEEK_ERROR;
+            return false;
+        }
+        FLAC__bitreader_clear(decoder->input);
+        decoder->stream_offset = target;
+    }
+
+    decoder->cached = false;
+    decoder->seek_pending = true;
+    decoder->seek_target = sample;
+    decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+    return true;
+}
+
+/***********************************************************************
+ *
+ * Private class methods
+ *
+ ***********************************************************************/
+
+void set_defaults_(FLAC__StreamDecoder *decoder)
+{
+    decoder->handle = 0;
+    memset(&decoder->callbacks, 0, sizeof(decoder->callbacks));
+    decoder->memory = 0;
+    decoder->memory_bytes = 0;
+    decoder->has_stream_info = false;
+    decoder->samples_decoded = 0;
+    decoder->cached = false;
+    decoder->side_subframe_in_use = false;
+    decoder->first_frame_offset = 0;
+    decoder->seek_pending = false;
+    decoder->push = false;
+    decoder->interleaved = false;
+    decoder->frame_callback = 0;
+    decoder->frame_client_data = 0;
+    decoder->push_bytes = 0;
+    decoder->push_skip = 0;
+    decoder->push_in_frame = false;
+    decoder->push_lost_sync = false;
+    decoder->push_final = false;
+    decoder->ogg = false;
+    decoder->ogg_window = 0;
+    decoder->ogg_window_bytes = 0;
+    decoder->ogg_pos = 0;
+    decoder->ogg_have_serial = false;
+    decoder->ogg_eos = false;
+}
+
+/* the stream position of the next byte the decoder will consume */
+FLAC__uint64 get_position_(const FLAC__StreamDecoder *decoder)
+{
+    /* the bitreader may still hold bytes the read callback already delivered */
+    FLAC__uint64 position = decoder->stream_offset - FLAC__bitreader_get_input_bits_unconsumed(decoder->input) / 8;
+    if (decoder->memory != 0)
+        position += decoder->memory_bytes - FLAC__bitreader_get_source_bytes_left(decoder->input);
+    else if (decoder->ogg)
+        position -= FLAC__bitreader_get_source_bytes_left(decoder->input);
+    return position;
+}
+
+/*
+ * The part of initialization shared by the callback and the memory
+ * sources; the source itself has been set up by the caller.
+ */
+FLAC__StreamDecoderInitStatus init_stream_(FLAC__StreamDecoder *decoder, FLAC__BitReaderReadCallback read_callback)
+{
+    /* the bit buffer survives FLAC__stream_decoder_finish(), only allocate it the first time */
+    if (!FLAC__bitreader_init(decoder->input, read_callback, decoder)) {
+        decoder->state = FLAC__STREAM_DECODER_MEMORY_ALLOCATION_ERROR;
+        return FLAC__STREAM_DECODER_INIT_STATUS_MEMORY_ALLOCATION_ERROR;
+    }
+
+    /*
+     * set the function pointers for this CPU
+     */
+    decoder->dispatch = FLAC__dispatch();
+    decoder->local_bitreader_read_rice_signed_block = decoder->dispatch->bitreader_read_rice_signed_block;
+    decoder->local_lpc_restore_signal = decoder->dispatch->lpc_restore_signal;
+    decoder->local_lpc_restore_signal_64bit = decoder->dispatch->lpc_restore_signal_wide;
+    decoder->local_stereo_restore = decoder->dispatch->stereo_restore;
+    decoder->local_pcm_interleave = decoder->dispatch->pcm_interleave;
+
+    decoder->has_stream_info = false;
+    decoder->samples_decoded = 0;
+    decoder->cached = false;
+    decoder->first_frame_offset = 0;
+    decoder->seek_pending = false;
+
+    decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_METADATA;
+
+    return FLAC__STREAM_DECODER_INIT_STATUS_OK;
+}
+
+/*
+ * Makes sure the scratch holds frames of 'size' samples and 'channels'
+ * channels. Called once when STREAMINFO has been read; frames only come
+ * back here if they are larger than STREAMINFO claimed. Everything is
+ * laid out again in one block then, so nothing in the scratch may be in
+ * use.
+ */
+FLAC__bool allocate_scratch_(FLAC__StreamDecoder *decoder, unsigned size, unsigned channels, unsigned bits_per_sample)
+{
+    /* once laid out, the side channel and the planar output stay */
+    const FLAC__bool side = (channels == 2 && bits_per_sample == 32) || decoder->side_subframe != 0;
+    const FLAC__bool planar_output = decoder->push || decoder->interleaved || decoder->planar_output[0] != 0;
+    unsigned order;
+
+    if (size <= decoder->output_capacity && channels <= decoder->output_channels &&
+        (!side || decoder->side_subframe != 0) && (!planar_output || decoder->planar_output[0] != 0))
+        return true;
+
+    size = flac_max(size, decoder->output_capacity);
+    size = flac_max(size, FLAC__MIN_BLOCK_SIZE);
+    channels = flac_max(channels, decoder->output_channels);
+
+    /* a partition has at least one sample, so 2^order <= blocksize */
+    for (order = 0; order < FLAC__MAX_RICE_PARTITION_ORDER && (2u << order) <= size; order++)
+        ;
+
+    FLAC__arena_begin_count(&decoder->scratch);
+    layout_scratch_(decoder, size, channels, order, side, planar_output);
+    if (!FLAC__arena_reserve(&decoder->scratch, decoder->scratch.used)) {
+        /* counting cleared the pointers, so there is nothing to decode into */
+        decoder->output_capacity = decoder->output_channels = 0;
+        decoder->state = FLAC__STREAM_DECODER_MEMORY_ALLOCATION_ERROR;
+        return false;
+    }
+    layout_scratch_(decoder, size, channels, order, side, planar_output);
+
+    decoder->output_capacity = size;
+    decoder->output_channels = channels;
+
+    return true;
+}
+
+/* Carves the scratch out of decoder->scratch, or counts it, see private/arena.h. */
+void layout_scratch_(FLAC__StreamDecoder *decoder, unsigned size, unsigned channels, unsigned order, FLAC__bool side, FLAC__bool planar_output)
+{
+    FLAC__Arena *arena = &decoder->scratch;
+    unsigned i;
+
+    for (i = 0; i < channels; i++) {
+        decoder->residual[i] = (FLAC__int32*)FLAC__arena_carve(arena, sizeof(FLAC__int32) * size);
+        decoder->partitioned_rice_contents[i].parameters = (unsigned*)FLAC__arena_carve(arena, sizeof(unsigned) * (1u << order));
+        decoder->partitioned_rice_contents[i].raw_bits = (unsigned*)FLAC__arena_carve(arena, sizeof(unsigned) * (1u << order));
+        decoder->partitioned_rice_contents[i].capacity_by_order = order;
+        /* frames are decoded into the client's buffers, except in push mode and for interleaved output */
+        decoder->planar_output[i] = planar_output ? (FLAC__int32*)FLAC__arena_carve(arena, sizeof(FLAC__int32) * size) : 0;
+    }
+    decoder->side_subframe = side ? (FLAC__int64*)FLAC__arena_carve(arena, sizeof(FLAC__int64) * size) : 0;
+}
+
+FLAC__bool find_metadata_(FLAC__StreamDecoder *decoder)
+{
+    FLAC__uint32 x;
+    unsigned i, id;
+    FLAC__bool first = true;
+
+    FLAC_ASSERT(FLAC__bitreader_is_consumed_byte_aligned(decoder->input));
+
+    for (i = id = 0; i < 4; ) {
+        if (decoder->cached) {
+            x = (FLAC__uint32)decoder->lookahead;
+            decoder->cached = false;
+        }
+        else {
+            if (!FLAC__bitreader_read_raw_uint32(decoder->input, &x, 8))
+                return false; /* read_callback_ sets the state for us */
+        }
+        if (x == FLACT__STREAM_SYNC_STRING[i]) {
+            first = true;
+            i++;
+            id = 0;
+            continue;
+        }
+
+        if (id >= 3)
+            return false;
+
+        if (x == ID3V2_TAG_[id]) {
+            id++;
+            i = 0;
+            if (id == 3) {
+                if (!skip_id3v2_tag_(decoder))
+                    return false; /* skip_id3v2_tag_ sets the state for us */
+            }
+            continue;
+        }
+        id = 0;
+        if (x == 0xff) { /* MAGIC NUMBER for the first 8 frame sync bits */
+            decoder->header_warmup[0] = (FLAC__byte)x;
+            if (!FLAC__bitreader_read_raw_uint32(decoder->input, &x, 8))
+                return false; /* read_callback_ sets the state for us */
+
+            /* we have to check if we just read two 0xff's in a row; the second may actually be the beginning of the sync code */
+            /* else we have to check if the second byte is the end of a sync code */
+            if (x == 0xff) { /* MAGIC NUMBER for the first 8 frame sync bits */
+                decoder->lookahead = (FLAC__byte)x;
+                decoder->cached = true;
+            }
+            else if (x >> 1 == 0x7c) { /* MAGIC NUMBER for the last 6 sync bits and reserved 7th bit */
+                /* a raw stream of frames without the "fLaC" marker and metadata */
+                decoder->header_warmup[1] = (FLAC__byte)x;
+                decoder->first_frame_offset = get_position_(decoder) - 2;
+                decoder->state = FLAC__STREAM_DECODER_READ_FRAME;
+                return true;
+            }
+        }
+        i = 0;
+        if (first) {
+            send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_LOST_SYNC);
+            first = false;
+        }
+    }
+
+    decoder->state = FLAC__STREAM_DECODER_READ_METADATA;
+    return true;
+}
+
+FLAC__bool read_metadata_(FLAC__StreamDecoder *decoder)
+{
+    FLAC__bool is_last;
+    FLAC__uint32 x, type, length;
+
+    FLAC_ASSERT(FLAC__bitreader_is_consumed_byte_aligned(decoder->input));
+
+    if (!FLAC__bitreader_read_raw_uint32(decoder->input, &x, FLAC__STREAM_METADATA_IS_LAST_LEN))
+        return false; /* read_callback_ sets the state for us */
+    is_last = x ? true : false;
+
+    if (!FLAC__bitreader_read_raw_uint32(decoder->input, &type, FLAC__STREAM_METADATA_TYPE_LEN))
+        return false; /* read_callback_ sets the state for us */
+
+    if (!FLAC__bitreader_read_raw_uint32(decoder->input, &length, FLAC__STREAM_METADATA_LENGTH_LEN))
+        return false; /* read_callback_ sets the state for us */
+
+    if (type == FLAC__METADATA_TYPE_STREAMINFO) {
+        if (!read_metadata_streaminfo_(decoder, length))
+            return false;
+        decoder->has_stream_info = true;
+    }
+    else {
+        // 其它的metadata暂时不需要，直接跳过
+        if (!skip_metadata_block_(decoder, length))
+            return false;
+    }
+
+    if (is_last) {
+        if (decoder->has_stream_info && !allocate_scratch_(decoder, decoder->stream_info.max_blocksize, decoder->stream_info.channels, decoder->stream_info.bits_per_sample))
+            return false;
+        decoder->first_frame_offset = get_position_(decoder);
+        decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+    }
+
+    return true;
+}
+
+FLAC__bool read_metadata_streaminfo_(FLAC__StreamDecoder *decoder, unsigned length)
+{
+    FLAC__StreamMetadata_StreamInfo *info = &decoder->stream_info;
+    FLAC__uint32 x;
+    unsigned bits, used_bits = 0;
+
+    if (length < FLAC__STREAM_METADATA_STREAMINFO_LENGTH) {
+        send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_UNPARSEABLE_STREAM);
+        decoder->state = FLAC__STREAM_DECODER_ABORTED;
+        return false;
+    }
+
+    bits = FLAC__STREAM_METADATA_STREAMINFO_MIN_BLOCK_SIZE_LEN;
+    if (!FLAC__bitreader_read_raw_uint32(decoder->input, &x, bits))
+        return false; /* read_callback_ sets the state for us */
+    info->min_blocksize = x;
+    used_bits += bits;
+
+    bits = FLAC__STREAM_METADATA_STREAMINFO_MAX_BLOCK_SIZE_LEN;
+    if (!FLAC__bitreader_read_raw_uint32(decoder->input, &x, bits))
+        return false; /* read_callback_ sets the state for us */
+    info->max_blocksize = x;
+    used_bits += bits;
+
+    bits = FLAC__STREAM_METADATA_STREAMINFO_MIN_FRAME_SIZE_LEN;
+    if (!FLAC__bitreader_read_raw_uint32(decoder->input, &x, bits))
+        return false; /* read_callback_ sets the state for us */
+    info->min_framesize = x;
+    used_bits += bits;
+
+    bits = FLAC__STREAM_METADATA_STREAMINFO_MAX_FRAME_SIZE_LEN;
+    if (!FLAC__bitreader_read_raw_uint32(decoder->input, &x, bits))
+        return false; /* read_callback_ sets the state for us */
+    info->max_framesize = x;
+    used_bits += bits;
+
+    bits = FLAC__STREAM_METADATA_STREAMINFO_SAMPLE_RATE_LEN;
+    if (!FLAC__bitreader_read_raw_uint32(decoder->input, &x, bits))
+        return false; /* read_callback_ sets the state for us */
+    info->sample_rate = x;
+    used_bits += bits;
+
+    bits = FLAC__STREAM_METADATA_STREAMINFO_CHANNELS_LEN;
+    if (!FLAC__bitreader_read_raw_uint32(decoder->input, &x, bits))
+        return false; /* read_callback_ sets the state for us */
+    info->channels = x + 1;
+    used_bits += bits;
+
+    bits = FLAC__STREAM_METADATA_STREAMINFO_BITS_PER_SAMPLE_LEN;
+    if (!FLAC__bitreader_read_raw_uint32(decoder->input, &x, bits))
+        return false; /* read_callback_ sets the state for us */
+    info->bits_per_sample = x + 1;
+    used_bits += bits;
+
+    bits = FLAC__STREAM_METADATA_STREAMINFO_TOTAL_SAMPLES_LEN;
+    if (!FLAC__bitreader_read_raw_uint64(decoder->input, &info->total_samples, bits))
+        return false; /* read_callback_ sets the state for us */
+    used_bits += bits;
+
+    if (!FLAC__bitreader_read_byte_block_aligned_no_crc(decoder->input, info->md5sum, 16))
+        return false; /* read_callback_ sets the state for us */
+    used_bits += 16 * 8;
+
+    /* skip the rest of the block */
+    FLAC_ASSERT(used_bits % 8 == 0);
+    return skip_metadata_block_(decoder, length - used_bits / 8);
+}
+
+/*
+ * Skips a metadata block we have no use for. Large blocks (embedded
+ * pictures, padding) are seeked over when the client gave us a seek
+ * callback instead of being pulled through the bit buffer.
+ */
+FLAC__bool skip_metadata_block_(FLAC__StreamDecoder *decoder, unsigned length)
+{
+    const unsigned buffered = FLAC__bitreader_get_input_bits_unconsumed(decoder->input) / 8;
+
+    FLAC_ASSERT(FLAC__bitreader_is_consumed_byte_aligned(decoder->input));
+
+    /* in memory there is nothing to read, just move the source past the block */
+    if (length > buffered && decoder->memory != 0) {
+        const size_t left = FLAC__bitreader_get_source_bytes_left(decoder->input);
+        const size_t skip = length - buffered;
+        if (skip <= left) {
+            FLAC__bitreader_clear(decoder->input);
+            FLAC__bitreader_set_source(decoder->input, decoder->memory + (decoder->memory_bytes - left) + skip, left - skip);
+            return true;
+        }
+        /* truncated, fall through and let the read hit the end */
+    }
+
+    if (length > buffered && decoder->callbacks.seek) {
+        const FLAC__int64 skip = (FLAC__int64)(length - buffered);
+        if (decoder->callbacks.seek(decoder->handle, skip, SEEK_CUR) == 0) {
+            FLAC__bitreader_clear(decoder->input);
+            decoder->stream_offset += (FLAC__uint64)skip;
+            return true;
+        }
+        /* not seekable after all, fall through and read past it */
+    }
+
+    return FLAC__bitreader_skip_byte_block_aligned_no_crc(decoder->input, length);
+}
+
+FLAC__bool skip_id3v2_tag_(FLAC__StreamDecoder *decoder)
+{
+    FLAC__uint32 x;
+    unsigned i, skip;
+
+    /* skip the version and flags bytes */
+    if (!FLAC__bitreader_skip_byte_block_aligned_no_crc(decoder->input, 3))
+        return false; /* read_callback_ sets the state for us */
+    /* get the size (in bytes) to skip */
+    skip = 0;
+    for (i = 0; i < 4; i++) {
+        if (!FLAC__bitreader_read_raw_uint32(decoder->input, &x, 8))
+            return false; /* read_callback_ sets the state for us */
+        skip <<= 7;
+        skip |= (x & 0x7f);
+    }
+    /* skip the rest of the tag */
+    return skip_metadata_block_(decoder, skip);
+}
+
+FLAC__bool frame_sync_(FLAC__StreamDecoder *decoder)
+{
+    FLAC__uint32 x;
+    FLAC__bool first = true;
+
+    /* make sure we're byte aligned */
+    if (!FLAC__bitreader_is_consumed_byte_aligned(decoder->input)) {
+        if (!FLAC__bitreader_read_raw_uint32(decoder->input, &x, FLAC__bitreader_bits_left_for_byte_alignment(decoder->input)))
+            return false; /* read_callback_ sets the state for us */
+    }
+
+    while (1) {
+        if (decoder->cached) {
+            x = (FLAC__uint32)decoder->lookahead;
+            decoder->cached = false;
+        }
+        else {
+            if (!FLAC__bitreader_read_raw_uint32(decoder->input, &x, 8))
+                return false; /* read_callback_ sets the state for us */
+        }
+        if (x == 0xff) { /* MAGIC NUMBER for the first 8 frame sync bits */
+            decoder->header_warmup[0] = (FLAC__byte)x;
+            if (!FLAC__bitreader_read_raw_uint32(decoder->input, &x, 8))
+                return false; /* read_callback_ sets the state for us */
+
+            /* we have to check if we just read two 0xff's in a row; the second may actually be the beginning of the sync code */
+            /* else we have to check if the second byte is the end of a sync code */
+            if (x == 0xff) { /* MAGIC NUMBER for the first 8 frame sync bits */
+                decoder->lookahead = (FLAC__byte)x;
+                decoder->cached = true;
+            }
+            else if (x >> 1 == 0x7c) { /* MAGIC NUMBER for the last 6 sync bits and reserved 7th bit */
+                decoder->header_warmup[1] = (FLAC__byte)x;
+                decoder->state = FLAC__STREAM_DECODER_READ_FRAME;
+                return true;
+            }
+        }
+        if (first) {
+            send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_LOST_SYNC);
+            first = false;
+        }
+    }
+}
+
+FLAC__bool read_frame_(FLAC__StreamDecoder *decoder, FLAC__bool *got_a_frame, FLAC__int32 * const buffer[], unsigned capacity)
+{
+    unsigned channel;
+    unsigned frame_crc; /* the one we calculate from the input stream */
+    FLAC__uint32 x;
+    FLAC__StreamDecoderState state;
+
+    *got_a_frame = false;
+
+    /* init the CRC */
+    frame_crc = 0;
+    frame_crc = FLAC__CRC16_UPDATE(decoder->header_warmup[0], frame_crc);
+    frame_crc = FLAC__CRC16_UPDATE(decoder->header_warmup[1], frame_crc);
+    FLAC__bitreader_reset_read_crc16(decoder->input, (FLAC__uint16)frame_crc);
+
+    if (!read_frame_header_(decoder))
+        return false;
+    if (decoder->state == FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC) /* means we didn't sync on a valid header */
+        return true;
+
+    /* the client's buffers are sized from STREAMINFO; we can't silently truncate */
+    if (decoder->frame.header.blocksize > capacity) {
+        decoder->state = FLAC__STREAM_DECODER_ABORTED;
+        return false;
+    }
+    if (!allocate_scratch_(decoder, decoder->frame.header.blocksize, decoder->frame.header.channels, decoder->frame.header.bits_per_sample))
+        return false;
+
+    /*
+     * Buffer the frame at the largest an encoder would make it, every
+     * subframe verbatim with its side channel bit, the longest wasted
+     * bits run and the footer, so the reads below don't call back for
+     * more. Near the end of the stream there is less than that; whatever
+     * came in stays buffered and the reads ask for the rest as before.
+     */
+    state = decoder->state;
+    if (!FLAC__bitreader_reserve(decoder->input, decoder->frame.header.channels * ((decoder->frame.header.bits_per_sample + 1) * (decoder->frame.header.blocksize + 1) + 8) + 7 + FLAC__FRAME_FOOTER_CRC_LEN))
+        decoder->state = state;
+
+    decoder->side_subframe_in_use = false;
+    for (channel = 0; channel < decoder->frame.header.channels; channel++) {
+        /*
+         * first figure the correct bits-per-sample of the subframe
+         */
+        unsigned bps = decoder->frame.header.bits_per_sample;
+        switch (decoder->frame.header.channel_assignment) {
+            case FLAC__CHANNEL_ASSIGNMENT_INDEPENDENT:
+                /* no adjustment needed */
+                break;
+            case FLAC__CHANNEL_ASSIGNMENT_LEFT_SIDE:
+                FLAC_ASSERT(decoder->frame.header.channels == 2);
+                if (channel == 1)
+                    bps++;
+                break;
+            case FLAC__CHANNEL_ASSIGNMENT_RIGHT_SIDE:
+                FLAC_ASSERT(decoder->frame.header.channels == 2);
+                if (channel == 0)
+                    bps++;
+                break;
+            case FLAC__CHANNEL_ASSIGNMENT_MID_SIDE:
+                FLAC_ASSERT(decoder->frame.header.channels == 2);
+                if (channel == 1)
+                    bps++;
+                break;
+            default:
+                FLAC_ASSERT(0);
+        }
+        /*
+         * now read it
+         */
+        if (!read_subframe_(decoder, channel, bps, buffer[channel]))
+            return false;
+        if (decoder->state != FLAC__STREAM_DECODER_READ_FRAME) /* means bad sync or got corruption */
+            return true;
+    }
+    if (!read_zero_padding_(decoder))
+        return false;
+    if (decoder->state != FLAC__STREAM_DECODER_READ_FRAME) /* means bad sync or got corruption (i.e. "zero bits" were not all zeroes) */
+        return true;
+
+    /*
+     * Read the frame CRC-16 from the footer and check
+     */
+    frame_crc = FLAC__bitreader_get_read_crc16(decoder->input);
+    if (!FLAC__bitreader_read_raw_uint32(decoder->input, &x, FLAC__FRAME_FOOTER_CRC_LEN))
+        return false; /* read_callback_ sets the state for us */
+    if (frame_crc != x) {
+        /* Bad frame, never hand it to the client */
+        send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_FRAME_CRC_MISMATCH);
+        decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+        return true;
+    }
+    decoder->frame.footer.crc = (FLAC__uint16)x;
+
+    /* Undo any special channel coding */
+    undo_channel_coding_(decoder, buffer);
+
+    FLAC_ASSERT(decoder->frame.header.number_type == FLAC__FRAME_NUMBER_TYPE_SAMPLE_NUMBER);
+    decoder->samples_decoded = decoder->frame.header.number.sample_number + decoder->frame.header.blocksize;
+
+    *got_a_frame = true;
+    decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+
+    return true;
+}
+
+/*
+ * The first frame decoded after a seek: drops it if it ends before the
+ * target, else moves the target sample to the front of the buffers.
+ * Returns false if the frame is to be dropped.
+ */
+FLAC__bool trim_seek_frame_(FLAC__StreamDecoder *decoder, FLAC__int32 * const buffer[])
+{
+    FLAC__FrameHeader *header = &decoder->frame.header;
+    unsigned channel, skip;
+
+    if (header->number.sample_number + header->blocksize <= decoder->seek_target)
+        return false;
+
+    /* a frame starting past the target (the index missed it) is returned as is */
+    if (header->number.sample_number < decoder->seek_target) {
+        skip = (unsigned)(decoder->seek_target - header->number.sample_number);
+        for (channel = 0; channel < header->channels; channel++)
+            memmove(buffer[channel], buffer[channel] + skip, sizeof(FLAC__int32) * (header->blocksize - skip));
+        header->blocksize -= skip;
+        header->number.sample_number = decoder->seek_target;
+    }
+    decoder->seek_pending = false;
+    return true;
+}
+
+FLAC__bool read_frame_header_(FLAC__StreamDecoder *decoder)
+{
+    FLAC__FrameHeader *header = &decoder->frame.header;
+    FLAC__uint32 x;
+    FLAC__uint64 xx;
+    unsigned i, blocksize_hint = 0, sample_rate_hint = 0;
+    FLAC__byte crc8, raw_header[FLAC__FRAME_HEADER_MAX_LENGTH];
+    unsigned raw_header_len;
+    FLAC__bool is_unparseable = false;
+
+    FLAC_ASSERT(FLAC__bitreader_is_consumed_byte_aligned(decoder->input));
+
+    /* init the raw header with the saved bits from synchronization */
+    raw_header[0] = decoder->header_warmup[0];
+    raw_header[1] = decoder->header_warmup[1];
+    raw_header_len = 2;
+
+    /* check to make sure that reserved bit is 0 */
+    if (raw_header[1] & 0x02) /* MAGIC NUMBER */
+        is_unparseable = true;
+
+    /*
+     * Note that along the way as we read the header, we look for a sync
+     * code inside.  If we find one it would indicate that our original
+     * sync was bad since there cannot be a sync code in a valid header.
+     *
+     * Three kinds of things can go wrong when reading the frame header:
+     *  1) We may have sync'ed incorrectly and not landed on a frame header.
+     *     If we don't find a sync code, it can end up looking like we read
+     *     a valid but unparseable header, until getting to the frame header
+     *     CRC.  Even then we could get a false positive on the CRC.
+     *  2) We may have sync'ed correctly but on an unparseable frame (from a
+     *     future encoder).
+     *  3) We may be on a damaged frame which appears valid but unparseable.
+     *
+     * For all these reasons, we try and read a complete frame header as
+     * long as it seems valid, even if unparseable, up until the frame
+     * header CRC.
+     */
+
+    /*
+     * read in the raw header as bytes so we can CRC it, and parse it on the way
+     */
+    for (i = 0; i < 2; i++) {
+        if (!FLAC__bitreader_read_raw_uint32(decoder->input, &x, 8))
+            return false; /* read_callback_ sets the state for us */
+        if (x == 0xff) { /* MAGIC NUMBER for the first 8 frame sync bits */
+            /* if we get here it means our original sync was erroneous since the sync code cannot appear in the header */
+            decoder->lookahead = (FLAC__byte)x;
+            decoder->cached = true;
+            send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_BAD_HEADER);
+            decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+            return true;
+        }
+        raw_header[raw_header_len++] = (FLAC__byte)x;
+    }
+
+    // <4> Block size in inter-channel samples
+    switch (x = raw_header[2] >> 4) {
+        case 0:
+            is_unparseable = true;
+            break;
+        case 1:
+            header->blocksize = 192;
+            break;
+        case 2:
+        case 3:
+        case 4:
+        case 5:
+            header->blocksize = 576 << (x - 2);
+            break;
+        case 6:
+        case 7:
+            blocksize_hint = x;
+            break;
+        case 8:
+        case 9:
+        case 10:
+        case 11:
+        case 12:
+        case 13:
+        case 14:
+        case 15:
+            header->blocksize = 256 << (x - 8);
+            break;
+        default:
+            FLAC_ASSERT(0);
+            break;
+    }
+
+    // <4> Sample rate
+    switch (x = raw_header[2] & 0x0f) {
+        case 0:
+            if (decoder->has_stream_info)
+                header->sample_rate = decoder->stream_info.sample_rate;
+            else
+                is_unparseable = true;
+            break;
+        case 1:
+            header->sample_rate = 88200;
+            break;
+        case 2:
+            header->sample_rate = 176400;
+            break;
+        case 3:
+            header->sample_rate = 192000;
+            break;
+        case 4:
+            header->sample_rate = 8000;
+            break;
+        case 5:
+            header->sample_rate = 16000;
+            break;
+        case 6:
+            header->sample_rate = 22050;
+            break;
+        case 7:
+            header->sample_rate = 24000;
+            break;
+        case 8:
+            header->sample_rate = 32000;
+            break;
+        case 9:
+            header->sample_rate = 44100;
+            break;
+        case 10:
+            header->sample_rate = 48000;
+            break;
+        case 11:
+            header->sample_rate = 96000;
+            break;
+        case 12:
+        case 13:
+        case 14:
+            sample_rate_hint = x;
+            break;
+        case 15:
+            send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_BAD_HEADER);
+            decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+            return true;
+        default:
+            FLAC_ASSERT(0);
+    }
+
+    // <4> Channel assignment
+    x = (unsigned)(raw_header[3] >> 4);
+    if (x & 8) {
+        header->channels = 2;
+        switch (x & 7) {
+            case 0:
+                header->channel_assignment = FLAC__CHANNEL_ASSIGNMENT_LEFT_SIDE;
+                break;
+            case 1:
+                header->channel_assignment = FLAC__CHANNEL_ASSIGNMENT_RIGHT_SIDE;
+                break;
+            case 2:
+                header->channel_assignment = FLAC__CHANNEL_ASSIGNMENT_MID_SIDE;
+                break;
+            default:
+                is_unparseable = true;
+                break;
+        }
+    }
+    else {
+        header->channels = (unsigned)x + 1;
+        header->channel_assignment = FLAC__CHANNEL_ASSIGNMENT_INDEPENDENT;
+    }
+
+    // <3> Sample size in bits
+    switch (x = (unsigned)(raw_header[3] & 0x0e) >> 1) {
+        case 0:
+            if (decoder->has_stream_info)
+                header->bits_per_sample = decoder->stream_info.bits_per_sample;
+            else
+                is_unparseable = true;
+            break;
+        case 1:
+            header->bits_per_sample = 8;
+            break;
+        case 2:
+            header->bits_per_sample = 12;
+            break;
+        case 4:
+            header->bits_per_sample = 16;
+            break;
+        case 5:
+            header->bits_per_sample = 20;
+            break;
+        case 6:
+            header->bits_per_sample = 24;
+            break;
+        case 7:
+            header->bits_per_sample = 32;
+            break;
+        case 3:
+            is_unparseable = true;
+            break;
+        default:
+            FLAC_ASSERT(0);
+            break;
+    }
+
+    /* check to make sure that reserved bit is 0 */
+    if (raw_header[3] & 0x01) /* MAGIC NUMBER */
+        is_unparseable = true;
+
+    /* read the frame's starting sample number (or frame number as the case may be) */
+    if (raw_header[1] & 0x01) { /* this will be true if the blocking strategy is variable */
+        if (!FLAC__bitreader_read_utf8_uint64(decoder->input, &xx, raw_header, &raw_header_len))
+            return false; /* read_callback_ sets the state for us */
+        if (xx == FLAC__U64L(0xffffffffffffffff)) { /* i.e. non-UTF8 code... */
+            decoder->lookahead = raw_header[raw_header_len - 1]; /* back up as much as we can */
+            decoder->cached = true;
+            send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_BAD_HEADER);
+            decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+            return true;
+        }
+        header->number_type = FLAC__FRAME_NUMBER_TYPE_SAMPLE_NUMBER;
+        header->number.sample_number = xx;
+    }
+    else { /* fixed blocksize */
+        if (!FLAC__bitreader_read_utf8_uint32(decoder->input, &x, raw_header, &raw_header_len))
+            return false; /* read_callback_ sets the state for us */
+        if (x == 0xffffffff) { /* i.e. non-UTF8 code... */
+            decoder->lookahead = raw_header[raw_header_len - 1]; /* back up as much as we can */
+            decoder->cached = true;
+            send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_BAD_HEADER);
+            decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+            return true;
+        }
+        header->number_type = FLAC__FRAME_NUMBER_TYPE_FRAME_NUMBER;
+        header->number.frame_number = x;
+    }
+
+    if (blocksize_hint) {
+        if (!FLAC__bitreader_read_raw_uint32(decoder->input, &x, 8))
+            return false; /* read_callback_ sets the state for us */
+        raw_header[raw_header_len++] = (FLAC__byte)x;
+        if (blocksize_hint == 7) {
+            FLAC__uint32 _x;
+            if (!FLAC__bitreader_read_raw_uint32(decoder->input, &_x, 8))
+                return false; /* read_callback_ sets the state for us */
+            raw_header[raw_header_len++] = (FLAC__byte)_x;
+            x = (x << 8) | _x;
+        }
+        header->blocksize = x + 1;
+        if (header->blocksize > FLAC__MAX_BLOCK_SIZE)
+            is_unparseable = true;
+    }
+
+    if (sample_rate_hint) {
+        if (!FLAC__bitreader_read_raw_uint32(decoder->input, &x, 8))
+            return false; /* read_callback_ sets the state for us */
+        raw_header[raw_header_len++] = (FLAC__byte)x;
+        if (sample_rate_hint != 12) {
+            FLAC__uint32 _x;
+            if (!FLAC__bitreader_read_raw_uint32(decoder->input, &_x, 8))
+                return false; /* read_callback_ sets the state for us */
+            raw_header[raw_header_len++] = (FLAC__byte)_x;
+            x = (x << 8) | _x;
+        }
+        if (sample_rate_hint == 12)
+            header->sample_rate = x * 1000;
+        else if (sample_rate_hint == 13)
+            header->sample_rate = x;
+        else
+            header->sample_rate = x * 10;
+    }
+
+    /* read the CRC-8 byte */
+    if (!FLAC__bitreader_read_raw_uint32(decoder->input, &x, 8))
+        return false; /* read_callback_ sets the state for us */
+    crc8 = (FLAC__byte)x;
+
+    if (FLAC__crc8(raw_header, raw_header_len) != crc8) {
+        send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_BAD_HEADER);
+        decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+        return true;
+    }
+    header->crc = crc8;
+
+    /* the client sized its buffer array from STREAMINFO */
+    if (decoder->has_stream_info && header->channels != decoder->stream_info.channels)
+        is_unparseable = true;
+
+    /* calculate the sample number from the frame number if needed */
+    if (header->number_type == FLAC__FRAME_NUMBER_TYPE_FRAME_NUMBER) {
+        x = header->number.frame_number;
+        header->number_type = FLAC__FRAME_NUMBER_TYPE_SAMPLE_NUMBER;
+        if (decoder->has_stream_info && decoder->stream_info.min_blocksize == decoder->stream_info.max_blocksize)
+            header->number.sample_number = (FLAC__uint64)decoder->stream_info.min_blocksize * (FLAC__uint64)x;
+        else
+            /* can only get here if the stream has invalid frame numbering or no STREAMINFO, so assume it's not the last (possibly short) frame */
+            header->number.sample_number = (FLAC__uint64)header->blocksize * (FLAC__uint64)x;
+    }
+
+    if (is_unparseable) {
+        send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_UNPARSEABLE_STREAM);
+        decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+        return true;
+    }
+
+    return true;
+}
+
+FLAC__bool read_subframe_(FLAC__StreamDecoder *decoder, unsigned channel, unsigned bps, FLAC__int32 *output)
+{
+    FLAC__uint32 x;
+    FLAC__bool wasted_bits;
+    FLAC__int32 *out32 = output;
+    FLAC__int64 *out64 = 0;
+    unsigned i;
+
+    /* the side channel of a 32-bit stream is 33 bits wide and can't go into the client's buffer */
+    if (bps > 32) {
+        /* allocate_scratch_() laid it out for the frame */
+        FLAC_ASSERT(0 != decoder->side_subframe);
+        out32 = 0;
+        out64 = decoder->side_subframe;
+        decoder->side_subframe_in_use = true;
+    }
+
+    if (!FLAC__bitreader_read_raw_uint32(decoder->input, &x, 8)) /* MAGIC NUMBER */
+        return false; /* read_callback_ sets the state for us */
+
+    wasted_bits = (x & 1);
+    x &= 0xfe;
+
+    if (wasted_bits) {
+        unsigned u;
+        if (!FLAC__bitreader_read_unary_unsigned(decoder->input, &u))
+            return false; /* read_callback_ sets the state for us */
+        decoder->frame.subframes[channel].wasted_bits = u + 1;
+        if (decoder->frame.subframes[channel].wasted_bits >= bps) {
+            send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_LOST_SYNC);
+            decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+            return true;
+        }
+        bps -= decoder->frame.subframes[channel].wasted_bits;
+    }
+    else
+        decoder->frame.subframes[channel].wasted_bits = 0;
+
+    /*
+     * Lots of magic numbers here
+     */
+    if (x & 0x80) {
+        send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_LOST_SYNC);
+        decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+        return true;
+    }
+    else if (x == 0) {
+        if (!read_subframe_constant_(decoder, channel, bps, out32, out64))
+            return false;
+    }
+    else if (x == 2) {
+        if (!read_subframe_verbatim_(decoder, channel, bps, out32, out64))
+            return false;
+    }
+    else if (x < 16) {
+        send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_UNPARSEABLE_STREAM);
+        decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+        return true;
+    }
+    else if (x <= 24) {
+        if (!read_subframe_fixed_(decoder, channel, bps, (x >> 1) & 7, out32, out64))
+            return false;
+        if (decoder->state != FLAC__STREAM_DECODER_READ_FRAME) /* means bad sync or got corruption */
+            return true;
+    }
+    else if (x < 64) {
+        send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_UNPARSEABLE_STREAM);
+        decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+        return true;
+    }
+    else {
+        if (!read_subframe_lpc_(decoder, channel, bps, ((x >> 1) & 31) + 1, out32, out64))
+            return false;
+        if (decoder->state != FLAC__STREAM_DECODER_READ_FRAME) /* means bad sync or got corruption */
+            return true;
+    }
+
+    if (wasted_bits) {
+        x = decoder->frame.subframes[channel].wasted_bits;
+        if (out32) {
+            for (i = 0; i < decoder->frame.header.blocksize; i++)
+                out32[i] = (FLAC__int32)((FLAC__uint32)out32[i] << x);
+        }
+        else {
+            for (i = 0; i < decoder->frame.header.blocksize; i++)
+                out64[i] = (FLAC__int64)((FLAC__uint64)out64[i] << x);
+        }
+    }
+
+    return true;
+}
+
+FLAC__bool read_subframe_constant_(FLAC__StreamDecoder *decoder, unsigned channel, unsigned bps, FLAC__int32 *out32, FLAC__int64 *out64)
+{
+    FLAC__Subframe_Constant *subframe = &decoder->frame.subframes[channel].data.constant;
+    FLAC__int64 x;
+    unsigned i;
+
+    decoder->frame.subframes[channel].type = FLAC__SUBFRAME_TYPE_CONSTANT;
+
+    if (!FLAC__bitreader_read_raw_int64(decoder->input, &x, bps))
+        return false; /* read_callback_ sets the state for us */
+
+    subframe->value = x;
+
+    /* decode the subframe */
+    if (out32) {
+        for (i = 0; i < decoder->frame.header.blocksize; i++)
+            out32[i] = (FLAC__int32)x;
+    }
+    else {
+        for (i = 0; i < decoder->frame.header.blocksize; i++)
+            out64[i] = x;
+    }
+
+    return true;
+}
+
+FLAC__bool read_subframe_fixed_(FLAC__StreamDecoder *decoder, unsigned channel, unsigned bps, const unsigned order, FLAC__int32 *out32, FLAC__int64 *out64)
+{
+    FLAC__Subframe_Fixed *subframe = &decoder->frame.subframes[channel].data.fixed;
+    unsigned u;
+
+    decoder->frame.subframes[channel].type = FLAC__SUBFRAME_TYPE_FIXED;
+
+    subframe->residual = decoder->residual[channel];
+    subframe->order = order;
+
+    /* read warm-up samples */
+    if (order > 0 && !FLAC__bitreader_read_raw_int64_block(decoder->input, subframe->warmup, order, bps))
+        return false; /* read_callback_ sets the state for us */
+
+    /* read entropy coding method info */
+    if (!read_entropy_coding_method_(decoder, channel, order, &subframe->entropy_coding_method))
+        return false;
+    if (decoder->state != FLAC__STREAM_DECODER_READ_FRAME)
+        return true;
+
+    /* decode the subframe */
+    if (out32) {
+        for (u = 0; u < order; u++)
+            out32[u] = (FLAC__int32)subframe->warmup[u];
+        if (bps + order <= 32)
+            FLAC__fixed_restore_signal_table[order](decoder->residual[channel], decoder->frame.header.blocksize - order, out32 + order);
+        else
+            FLAC__fixed_restore_signal_wide_table[order](decoder->residual[channel], decoder->frame.header.blocksize - order, out32 + order);
+    }
+    else {
+        for (u = 0; u < order; u++)
+            out64[u] = subframe->warmup[u];
+        FLAC__fixed_restore_signal_wide_33bit_table[order](decoder->residual[channel], decoder->frame.header.blocksize - order, out64 + order);
+    }
+
+    return true;
+}
+
+FLAC__bool read_subframe_lpc_(FLAC__StreamDecoder *decoder, unsigned channel, unsigned bps, const unsigned order, FLAC__int32 *out32, FLAC__int64 *out64)
+{
+    FLAC__Subframe_LPC *subframe = &decoder->frame.subframes[channel].data.lpc;
+    FLAC__int32 i32;
+    FLAC__uint32 u32;
+    unsigned u;
+
+    decoder->frame.subframes[channel].type = FLAC__SUBFRAME_TYPE_LPC;
+
+    subframe->residual = decoder->residual[channel];
+    subframe->order = order;
+
+    /* read warm-up samples */
+    if (order > 0 && !FLAC__bitreader_read_raw_int64_block(decoder->input, subframe->warmup, order, bps))
+        return false; /* read_callback_ sets the state for us */
+
+    /* read qlp coeff precision */
+    if (!FLAC__bitreader_read_raw_uint32(decoder->input, &u32, FLAC__SUBFRAME_LPC_QLP_COEFF_PRECISION_LEN))
+        return false; /* read_callback_ sets the state for us */
+    if (u32 == (1u << FLAC__SUBFRAME_LPC_QLP_COEFF_PRECISION_LEN) - 1) {
+        send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_LOST_SYNC);
+        decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+        return true;
+    }
+    subframe->qlp_coeff_precision = u32 + 1;
+
+    /* read qlp shift */
+    if (!FLAC__bitreader_read_raw_int32(decoder->input, &i32, FLAC__SUBFRAME_LPC_QLP_SHIFT_LEN))
+        return false; /* read_callback_ sets the state for us */
+    if (i32 < 0) {
+        send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_LOST_SYNC);
+        decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+        return true;
+    }
+    subframe->quantization_level = i32;
+
+    /* read quantized lp coefficiencts */
+    if (!FLAC__bitreader_read_raw_int32_block(decoder->input, subframe->qlp_coeff, order, subframe->qlp_coeff_precision))
+        return false; /* read_callback_ sets the state for us */
+
+    /* read entropy coding method info */
+    if (!read_entropy_coding_method_(decoder, channel, order, &subframe->entropy_coding_method))
+        return false;
+    if (decoder->state != FLAC__STREAM_DECODER_READ_FRAME)
+        return true;
+
+    /* decode the subframe */
+    if (out32) {
+        for (u = 0; u < order; u++)
+            out32[u] = (FLAC__int32)subframe->warmup[u];
+        if (FLAC__lpc_max_prediction_before_shift_bps(bps, subframe->qlp_coeff, order) <= 32)
+            decoder->local_lpc_restore_signal(decoder->residual[channel], decoder->frame.header.blocksize - order, subframe->qlp_coeff, order, subframe->quantization_level, out32 + order);
+        else
+            decoder->local_lpc_restore_signal_64bit(decoder->residual[channel], decoder->frame.header.blocksize - order, subframe->qlp_coeff, order, subframe->quantization_level, out32 + order);
+    }
+    else {
+        for (u = 0; u < order; u++)
+            out64[u] = subframe->warmup[u];
+        FLAC__lpc_restore_signal_wide_33bit(decoder->residual[channel], decoder->frame.header.blocksize - order, subframe->qlp_coeff, order, subframe->quantization_level, out64 + order);
+    }
+
+    return true;
+}
+
+FLAC__bool read_subframe_verbatim_(FLAC__StreamDecoder *decoder, unsigned channel, unsigned bps, FLAC__int32 *out32, FLAC__int64 *out64)
+{
+    FLAC__Subframe_Verbatim *subframe = &decoder->frame.subframes[channel].data.verbatim;
+
+    decoder->frame.subframes[channel].type = FLAC__SUBFRAME_TYPE_VERBATIM;
+
+    /* the samples are shifted and channel-decoded in place later, so there is nothing to point at */
+    subframe->data = 0;
+
+    if (out32) {
+        if (!FLAC__bitreader_read_raw_int32_block(decoder->input, out32, decoder->frame.header.blocksize, bps))
+            return false; /* read_callback_ sets the state for us */
+    }
+    else {
+        if (!FLAC__bitreader_read_raw_int64_block(decoder->input, out64, decoder->frame.header.blocksize, bps))
+            return false; /* read_callback_ sets the state for us */
+    }
+
+    return true;
+}
+
+FLAC__bool read_entropy_coding_method_(FLAC__StreamDecoder *decoder, unsigned channel, unsigned predictor_order, FLAC__EntropyCodingMethod *method)
+{
+    const unsigned blocksize = decoder->frame.header.blocksize;
+    FLAC__uint32 u32;
+    unsigned partition_order;
+
+    if (!FLAC__bitreader_read_raw_uint32(decoder->input, &u32, FLAC__ENTROPY_CODING_METHOD_TYPE_LEN))
+        return false; /* read_callback_ sets the state for us */
+    if (u32 > FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2) {
+        send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_UNPARSEABLE_STREAM);
+        decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+        return true;
+    }
+    method->type = (FLAC__EntropyCodingMethodType)u32;
+
+    if (!FLAC__bitreader_read_raw_uint32(decoder->input, &u32, FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_ORDER_LEN))
+        return false; /* read_callback_ sets the state for us */
+    partition_order = u32;
+
+    /* invalid predictor and partition orders mean the stream is corrupt */
+    if (
+        (partition_order == 0 && blocksize < predictor_order) ||
+        (partition_order > 0 && (
+            (blocksize >> partition_order) << partition_order != blocksize ||
+            (blocksize >> partition_order) < predictor_order
+        ))
+    ) {
+        send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_LOST_SYNC);
+        decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+        return true;
+    }
+    FLAC_ASSERT(partition_order <= decoder->partitioned_rice_contents[channel].capacity_by_order);
+
+    method->data.partitioned_rice.order = partition_order;
+    method->data.partitioned_rice.content = &decoder->partitioned_rice_contents[channel];
+
+    return read_residual_partitioned_rice_(
+        decoder,
+        predictor_order,
+        partition_order,
+        &decoder->partitioned_rice_contents[channel],
+        decoder->residual[channel],
+        method->type == FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2
+    );
+}
+
+FLAC__bool read_residual_partitioned_rice_(FLAC__StreamDecoder *decoder, unsigned predictor_order, unsigned partition_order, FLAC__EntropyCodingMethod_PartitionedRiceContents *partitioned_rice_contents, FLAC__int32 *residual, FLAC__bool is_extended)
+{
+    FLAC__uint32 rice_parameter;
+    unsigned partition, sample, u;
+    const unsigned partitions = 1u << partition_order;
+    const unsigned partition_samples = decoder->frame.header.blocksize >> partition_order;
+    const unsigned plen = is_extended ? FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2_PARAMETER_LEN : FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_PARAMETER_LEN;
+    const unsigned pesc = is_extended ? FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2_ESCAPE_PARAMETER : FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_ESCAPE_PARAMETER;
+
+    sample = 0;
+    for (partition = 0; partition < partitions; partition++) {
+        if (!FLAC__bitreader_read_raw_uint32(decoder->input, &rice_parameter, plen))
+            return false; /* read_callback_ sets the state for us */
+        partitioned_rice_contents->parameters[partition] = rice_parameter;
+        u = (partition == 0) ? partition_samples - predictor_order : partition_samples;
+        if (rice_parameter < pesc) {
+            partitioned_rice_contents->raw_bits[partition] = 0;
+            if (!decoder->local_bitreader_read_rice_signed_block(decoder->input, (int*)residual + sample, u, rice_parameter))
+                return false; /* read_callback_ sets the state for us */
+            sample += u;
+        }
+        else {
+            // escape: 每个残差用rice_parameter位原样存储
+            if (!FLAC__bitreader_read_raw_uint32(decoder->input, &rice_parameter, FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_RAW_LEN))
+                return false; /* read_callback_ sets the state for us */
+            partitioned_rice_contents->raw_bits[partition] = rice_parameter;
+            if (rice_parameter == 0) {
+                memset(residual + sample, 0, sizeof(FLAC__int32) * u);
+                sample += u;
+            }
+            else {
+                if (!FLAC__bitreader_read_raw_int32_block(decoder->input, residual + sample, u, rice_parameter))
+                    return false; /* read_callback_ sets the state for us */
+                sample += u;
+            }
+        }
+    }
+
+    return true;
+}
+
+FLAC__bool read_zero_padding_(FLAC__StreamDecoder *decoder)
+{
+    if (!FLAC__bitreader_is_consumed_byte_aligned(decoder->input)) {
+        FLAC__uint32 zero = 0;
+        if (!FLAC__bitreader_read_raw_uint32(decoder->input, &zero, FLAC__bitreader_bits_left_for_byte_alignment(decoder->input)))
+            return false; /* read_callback_ sets the state for us */
+        if (zero != 0) {
+            send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_LOST_SYNC);
+            decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+        }
+    }
+    return true;
+}
+
+/*
+ * Channel 0 and 1 are in the client's buffers, except for a 33-bit side
+ * channel which was decoded into side_subframe.
+ */
+void undo_channel_coding_(FLAC__StreamDecoder *decoder, FLAC__int32 * const buffer[])
+{
+    const unsigned blocksize = decoder->frame.header.blocksize;
+    const FLAC__int64 *side = decoder->side_subframe;
+    unsigned i;
+
+    if (decoder->frame.header.channel_assignment == FLAC__CHANNEL_ASSIGNMENT_INDEPENDENT)
+        return;
+    if (!decoder->side_subframe_in_use) {
+        decoder->local_stereo_restore[decoder->frame.header.channel_assignment](buffer[0], buffer[1], blocksize);
+        return;
+    }
+
+    switch (decoder->frame.header.channel_assignment) {
+        case FLAC__CHANNEL_ASSIGNMENT_LEFT_SIDE:
+            // right = left - side
+            for (i = 0; i < blocksize; i++)
+                buffer[1][i] = (FLAC__int32)((FLAC__int64)buffer[0][i] - side[i]);
+            break;
+        case FLAC__CHANNEL_ASSIGNMENT_RIGHT_SIDE:
+            // left = side + right
+            for (i = 0; i < blocksize; i++)
+                buffer[0][i] = (FLAC__int32)(side[i] + (FLAC__int64)buffer[1][i]);
+            break;
+        case FLAC__CHANNEL_ASSIGNMENT_MID_SIDE:
+            // mid的最低位在编码时丢掉了，和side的最低位相同
+            for (i = 0; i < blocksize; i++) {
+                FLAC__int64 mid = buffer[0][i];
+                mid = (FLAC__int64)((FLAC__uint64)mid << 1) | (side[i] & 1); /* i.e. if 'side' is odd... */
+                buffer[0][i] = (FLAC__int32)((mid + side[i]) >> 1);
+                buffer[1][i] = (FLAC__int32)((mid - side[i]) >> 1);
+            }
+            break;
+        default:
+            FLAC_ASSERT(0);
+            break;
+    }
+}
+
+void send_error_to_client_(const FLAC__StreamDecoder *decoder, FLAC__StreamDecoderErrorStatus status)
+{
+    if (decoder->error_callback)
+        decoder->error_callback(decoder, status, decoder->client_data);
+}
+
+FLAC__bool read_callback_(FLAC__byte buffer[], size_t *bytes, void *client_data)
+{
+    FLAC__StreamDecoder *decoder = (FLAC__StreamDecoder *)client_data;
+
+    if (decoder->callbacks.eof && decoder->callbacks.eof(decoder->handle)) {
+        *bytes = 0;
+        decoder->state = FLAC__STREAM_DECODER_END_OF_STREAM;
+        return false;
+    }
+    else if (*bytes > 0) {
+        *bytes = decoder->callbacks.read(buffer, 1, *bytes, decoder->handle);
+        if (*bytes == 0) {
+            /* a short read of nothing is an end of stream (or an error we can't tell apart) */
+            decoder->state = FLAC__STREAM_DECODER_END_OF_STREAM;
+            return false;
+        }
+        decoder->stream_offset += *bytes;
+        return true;
+    }
+    else
+        return false;
+}
+
+FLAC__bool end_of_memory_callback_(FLAC__byte buffer[], size_t *bytes, void *client_data)
+{
+    FLAC__StreamDecoder *decoder = (FLAC__StreamDecoder *)client_data;
+
+    (void)buffer;
+    *bytes = 0;
+    decoder->state = FLAC__STREAM_DECODER_END_OF_STREAM;
+    return false;
+}
+
+/*
+ * Hands the bit reader the body of the next page of the FLAC stream as
+ * its memory source, without copying it, and returns no bytes of its
+ * own; the reader then goes on from the new source. Pages of other
+ * logical streams and pages that fail their CRC are stepped over; the
+ * frame that loses bytes to a bad page fails its CRC-16 and the decoder
+ * resyncs as it would in a native stream.
+ */
+FLAC__bool ogg_read_callback_(FLAC__byte buffer[], size_t *bytes, void *client_data)
+{
+    FLAC__StreamDecoder *decoder = (FLAC__StreamDecoder *)client_data;
+    FLAC__OggPage page;
+    FLAC__OggPageParseStatus status;
+    const FLAC__byte *body;
+    size_t body_bytes;
+
+    (void)buffer;
+    *bytes = 0;
+
+    while (!decoder->ogg_eos) {
+        status = FLAC__ogg_page_parse(decoder->ogg_window + decoder->ogg_pos, decoder->ogg_window_bytes - decoder->ogg_pos, &page);
+        if (status == FLAC__OGG_PAGE_PARSE_TRUNCATED) {
+            if (ogg_refill_(decoder))
+                continue;
+            if (decoder->ogg_pos == decoder->ogg_window_bytes) {
+                decoder->ogg_eos = true;
+                continue;
+            }
+            /* no more is coming, so a page that claims to be longer is damaged */
+        }
+        if (status != FLAC__OGG_PAGE_PARSE_OK) {
+            decoder->ogg_pos += 1 + FLAC__ogg_find_capture_pattern(decoder->ogg_window + decoder->ogg_pos + 1, decoder->ogg_window_bytes - decoder->ogg_pos - 1);
+            continue;
+        }
+        decoder->ogg_pos += page.length;
+
+        body = page.body;
+        body_bytes = page.body_bytes;
+        if (!decoder->ogg_have_serial) {
+            /* the first packet of the stream is alone on its page */
+            if (!(page.flags & FLAC__OGG_PAGE_BOS) || !FLAC__ogg_is_mapping_header(body, body_bytes))
+                continue;
+            decoder->ogg_have_serial = true;
+            decoder->ogg_serial = page.serial_number;
+            body += FLAC__OGG_MAPPING_HEADER_LENGTH;
+            body_bytes -= FLAC__OGG_MAPPING_HEADER_LENGTH;
+        }
+        else if (page.serial_number != decoder->ogg_serial)
+            continue;
+
+        /* a chained stream after this one is not decoded */
+        if (page.flags & FLAC__OGG_PAGE_EOS)
+            decoder->ogg_eos = true;
+        if (body_bytes > 0) {
+            FLAC__bitreader_set_source(decoder->input, body, body_bytes);
+            decoder->stream_offset += body_bytes;
+            return true;
+        }
+    }
+
+    decoder->state = FLAC__STREAM_DECODER_END_OF_STREAM;
+    return false;
+}
+
+/*
+ * Moves what is left of the window to the front of ogg_buffer and reads
+ * more behind it; false at the end of the data. The bit reader is done
+ * with the window by now, its source runs out before it asks for more.
+ */
+FLAC__bool ogg_refill_(FLAC__StreamDecoder *decoder)
+{
+    size_t left, got;
+
+    if (decoder->ogg_window != decoder->ogg_buffer)
+        return false; /* memory: there is no more */
+
+    left = decoder->ogg_window_bytes - decoder->ogg_pos;
+    memmove(decoder->ogg_buffer, decoder->ogg_buffer + decoder->ogg_pos, left);
+    decoder->ogg_pos = 0;
+    decoder->ogg_window_bytes = left;
+
+    if (decoder->callbacks.eof && decoder->callbacks.eof(decoder->handle))
+        return false;
+    got = decoder->callbacks.read(decoder->ogg_buffer + left, 1, 2 * FLAC__OGG_MAX_PAGE_BYTES - left, decoder->handle);
+    decoder->ogg_window_bytes += got;
+    return got > 0;
+}
+
+FLAC__bool reserve_push_buffer_(FLAC__StreamDecoder *decoder, size_t bytes)
+{
+    FLAC__byte *buffer;
+    size_t capacity;
+
+    if (bytes <= decoder->push_capacity)
+        return true;
+
+    capacity = flac_max(bytes, 2 * decoder->push_capacity);
+    buffer = (FLAC__byte*)realloc(decoder->push_buffer, capacity);
+    if (buffer == 0) {
+        decoder->state = FLAC__STREAM_DECODER_MEMORY_ALLOCATION_ERROR;
+        return false;
+    }
+    decoder->push_buffer = buffer;
+    decoder->push_capacity = capacity;
+    return true;
+}
+
+/*
+ * Moves the window past the first n bytes of the stream; what of them
+ * has not arrived yet is dropped when it does.
+ */
+void push_consume_(FLAC__StreamDecoder *decoder, const FLAC__byte **data, size_t *bytes, size_t n)
+{
+    const size_t now = flac_min(n, *bytes);
+
+    *data += now;
+    *bytes -= now;
+    decoder->push_skip = n - now;
+    decoder->stream_offset += n;
+}
+
+/*
+ * The metadata of a pushed stream: an ID3v2 tag is skipped, then after
+ * the "fLaC" marker STREAMINFO is kept and the other blocks skipped. A
+ * stream that starts with anything else is taken to be bare frames.
+ */
+PushStep push_metadata_(FLAC__StreamDecoder *decoder, const FLAC__byte **data, size_t *bytes)
+{
+    FLAC__MetadataWalk *walk = &decoder->push_walk;
+
+    switch (FLAC__format_metadata_walk(walk, *data, *bytes, decoder->push_final)) {
+        case FLAC__METADATA_WALK_ID3V2:
+            push_consume_(decoder, data, bytes, walk->skip);
+            return PUSH_STEP_PROGRESS;
+        case FLAC__METADATA_WALK_MARKER:
+            push_consume_(decoder, data, bytes, walk->skip);
+            decoder->state = FLAC__STREAM_DECODER_READ_METADATA;
+            return PUSH_STEP_PROGRESS;
+        case FLAC__METADATA_WALK_NO_MARKER:
+            /* a raw stream of frames without the "fLaC" marker and metadata */
+            decoder->first_frame_offset = decoder->stream_offset;
+            decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+            return PUSH_STEP_PROGRESS;
+        case FLAC__METADATA_WALK_BLOCK:
+            break;
+        default:
+            /* more to come, or the stream ended inside a block header */
+            return PUSH_STEP_NEED_MORE;
+    }
+
+    if (walk->type == FLAC__METADATA_TYPE_STREAMINFO) {
+        if (walk->length < FLAC__STREAM_METADATA_STREAMINFO_LENGTH) {
+            send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_UNPARSEABLE_STREAM);
+            decoder->state = FLAC__STREAM_DECODER_ABORTED;
+            return PUSH_STEP_FATAL;
+        }
+        /* the header is looked at again when the rest has come */
+        if (*bytes < walk->skip)
+            return PUSH_STEP_NEED_MORE;
+        FLAC__format_unpack_streaminfo(*data + FLAC__STREAM_METADATA_HEADER_LENGTH, &decoder->stream_info);
+        decoder->has_stream_info = true;
+    }
+    push_consume_(decoder, data, bytes, walk->skip);
+
+    if (walk->is_last) {
+        if (decoder->has_stream_info) {
+            if (!allocate_scratch_(decoder, decoder->stream_info.max_blocksize, decoder->stream_info.channels, decoder->stream_info.bits_per_sample))
+                return PUSH_STEP_FATAL;
+        }
+        decoder->first_frame_offset = decoder->stream_offset;
+        decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+    }
+    return PUSH_STEP_PROGRESS;
+}
+
+/*
+ * Finds the next frame header, then walks the frame with its running
+ * CRC-16 up to the end of the data. Each byte is looked at once, over
+ * as many pushes as the frame takes; the frame is decoded where its CRC
+ * comes out 0, or where the next valid frame header sits in case it is
+ * damaged. After FLAC__stream_decoder_push_end_of_stream() the end of
+ * the data is the end of the frame.
+ */
+PushStep push_frame_(FLAC__StreamDecoder *decoder, const FLAC__byte **data, size_t *bytes)
+{
+    const FLAC__StreamMetadata_StreamInfo *stream_info = decoder->has_stream_info ? &decoder->stream_info : 0;
+    const FLAC__byte *b = *data;
+    FLAC__FrameHeader header;
+    FLAC__FrameHeaderParseStatus status = FLAC__FRAME_HEADER_PARSE_TRUNCATED;
+    unsigned header_length;
+    PushStep step;
+    size_t p, pending;
+
+    if (!decoder->push_in_frame) {
+        for (p = 0; ; p++) {
+            p += decoder->dispatch->frame_header_find_sync(b + p, *bytes - p);
+            if (p + 1 >= *bytes) {
+                /* a 0xff in the last byte may be the start of a sync code, unless nothing follows */
+                p = (*bytes > 0 && b[*bytes - 1] == 0xff && !decoder->push_final) ? *bytes - 1 : *bytes;
+                break;
+            }
+            status = FLAC__frame_header_parse(b + p, *bytes - p, stream_info, &header, &header_length);
+            if (status == FLAC__FRAME_HEADER_PARSE_OK || (status == FLAC__FRAME_HEADER_PARSE_TRUNCATED && !decoder->push_final))
+                break;
+        }
+        if (p > 0) {
+            if (!decoder->push_lost_sync) {
+                send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_LOST_SYNC);
+                decoder->push_lost_sync = true;
+            }
+            push_consume_(decoder, data, bytes, p);
+            return PUSH_STEP_PROGRESS;
+        }
+        if (*bytes < 2 || status != FLAC__FRAME_HEADER_PARSE_OK)
+            return PUSH_STEP_NEED_MORE;
+
+        /* the output has to be in place before the first try, a frame must not move it */
+        if (!allocate_scratch_(decoder, header.blocksize, header.channels, header.bits_per_sample))
+            return PUSH_STEP_FATAL;
+        decoder->push_in_frame = true;
+        decoder->push_header_length = header_length;
+        decoder->push_crc = decoder->dispatch->crc16_update_block(b, header_length, 0);
+        decoder->push_scan = header_length;
+        decoder->push_tried = 0;
+        decoder->push_resync = 0;
+        decoder->push_pending = 0;
+        decoder->push_bound = FLAC__frame_header_max_frame_bytes(&header, stream_info);
+    }
+
+    /* the headers the data stopped in last time; the CRC has walked past them already */
+    if (decoder->push_pending != 0) {
+        pending = decoder->push_pending;
+        decoder->push_pending = 0;
+        for (p = pending; p < decoder->push_scan; p++) {
+            if (b[p] == 0xff) {
+                step = push_candidate_(decoder, data, bytes, p);
+                if (step != PUSH_STEP_NEED_MORE)
+                    return step;
+            }
+        }
+    }
+
+    for (p = decoder->push_scan; ; p++) {
+        /* the CRC of everything before p is 0: p is the end, unless this is the one in 65536 that isn't */
+        if (decoder->push_crc == 0 && p > decoder->push_header_length && p != decoder->push_tried) {
+            step = push_decode_frame_(decoder, data, bytes, p);
+            if (step != PUSH_STEP_NEED_MORE)
+                return step;
+        }
+        if (p == *bytes)
+            break;
+        if (b[p] == 0xff) {
+            step = push_candidate_(decoder, data, bytes, p);
+            if (step != PUSH_STEP_NEED_MORE)
+                return step;
+        }
+        /* a damaged frame that does not even decode up to the next header; give up at the bound */
+        if (p >= decoder->push_bound && decoder->push_resync != 0) {
+            send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_FRAME_CRC_MISMATCH);
+            decoder->push_in_frame = false;
+            push_consume_(decoder, data, bytes, decoder->push_resync);
+            return PUSH_STEP_PROGRESS;
+        }
+        decoder->push_crc = FLAC__CRC16_UPDATE(b[p], decoder->push_crc);
+        decoder->push_scan = p + 1;
+    }
+
+    if (decoder->push_final) {
+        /* the stream ends in the middle of this frame, or the frame is damaged */
+        if (p != decoder->push_tried) {
+            step = push_decode_frame_(decoder, data, bytes, p);
+            if (step != PUSH_STEP_NEED_MORE)
+                return step;
+        }
+        send_error_to_client_(decoder, FLAC__STREAM_DECODER_ERROR_STATUS_FRAME_CRC_MISMATCH);
+        decoder->push_in_frame = false;
+        push_consume_(decoder, data, bytes, decoder->push_resync != 0 ? decoder->push_resync : *bytes);
+        return PUSH_STEP_PROGRESS;
+    }
+    return PUSH_STEP_NEED_MORE;
+}
+
+/*
+ * A sync code at p inside the frame being walked: if a valid header
+ * follows, the frame may end there. A header the data stops in is
+ * looked at again when more arrives.
+ */
+PushStep push_candidate_(FLAC__StreamDecoder *decoder, const FLAC__byte **data, size_t *bytes, size_t p)
+{
+    const FLAC__byte *b = *data;
+    FLAC__FrameHeader header;
+    FLAC__FrameHeaderParseStatus status;
+    unsigned header_length;
+    PushStep step;
+
+    if (p + 1 == *bytes)
+        status = FLAC__FRAME_HEADER_PARSE_TRUNCATED;
+    else if (!FLAC__frame_header_is_sync(b + p))
+        return PUSH_STEP_NEED_MORE;
+    else
+        status = FLAC__frame_header_parse(b + p, *bytes - p, decoder->has_stream_info ? &decoder->stream_info : 0, &header, &header_length);
+
+    if (status == FLAC__FRAME_HEADER_PARSE_TRUNCATED) {
+        if (decoder->push_pending == 0 && !decoder->push_final)
+            decoder->push_pending = p;
+    }
+    else if (status == FLAC__FRAME_HEADER_PARSE_OK) {
+        /* the next frame, unless the header is a fake in the audio; a damaged frame fails here */
+        if (p != decoder->push_tried) {
+            step = push_decode_frame_(decoder, data, bytes, p);
+            if (step != PUSH_STEP_NEED_MORE)
+                return step;
+        }
+        if (decoder->push_resync == 0)
+            decoder->push_resync = p;
+    }
+    return PUSH_STEP_NEED_MORE;
+}
+
+/*
+ * Decodes the frame at the front of the window as if it ended at 'end'.
+ * If it runs out of data first, the frame goes on and nothing changes.
+ */
+PushStep push_decode_frame_(FLAC__StreamDecoder *decoder, const FLAC__byte **data, size_t *bytes, size_t end)
+{
+    const FLAC__byte *b = *data;
+    FLAC__bool got_a_frame;
+    size_t unused;
+
+    /* the sync code is consumed by the search, as in frame_sync_() */
+    decoder->header_warmup[0] = b[0];
+    decoder->header_warmup[1] = b[1];
+    FLAC__bitreader_clear(decoder->input);
+    FLAC__bitreader_set_source(decoder->input, b + 2, end - 2);
+    decoder->state = FLAC__STREAM_DECODER_READ_FRAME;
+
+    if (!read_frame_(decoder, &got_a_frame, decoder->planar_output, decoder->output_capacity)) {
+        if (decoder->state != FLAC__STREAM_DECODER_END_OF_STREAM)
+            return PUSH_STEP_FATAL; /* read_frame_ sets the state for us */
+        decoder->state = FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC;
+        decoder->push_tried = end;
+        return PUSH_STEP_NEED_MORE;
+    }
+    FLAC_ASSERT(decoder->state == FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC);
+
+    decoder->push_in_frame = false;
+    if (!got_a_frame) {
+        /* damaged, read_frame_ has reported it; the next frame is searched for after 'end' */
+        push_consume_(decoder, data, bytes, end);
+        return PUSH_STEP_PROGRESS;
+    }
+
+    unused = FLAC__bitreader_get_source_bytes_left(decoder->input) + FLAC__bitreader_get_input_bits_unconsumed(decoder->input) / 8;
+    FLAC__bitreader_clear(decoder->input);
+    push_consume_(decoder, data, bytes, end - unused);
+    decoder->push_lost_sync = false;
+
+    if (!decoder->frame_callback(decoder, &decoder->frame.header, decoder->planar_output, decoder->frame_client_data)) {
+        decoder->state = FLAC__STREAM_DECODER_ABORTED;
+        return PUSH_STEP_FATAL;
+    }
+    return PUSH_STEP_PROGRESS;
+}
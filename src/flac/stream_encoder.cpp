@@ -0,0 +1,2104 @@
+#include <stdio.h>      // for SEEK_SET
+#include <stdlib.h>
+#include <string.h>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "FLAC/assert.h"
+#include "FLAC/stream_encoder.h"
+#include "private/arena.h"
+#include "private/bitwriter.h"
+#include "private/dispatch.h"
+#include "private/fixed.h"
+#include "private/float.h"
+#include "private/format.h"
+#include "private/lpc.h"
+#include "private/macros.h"
+#include "private/md5.h"
+#include "private/ogg.h"
+#include "private/stereo.h"
+#include "private/stream_encoder_framing.h"
+#include "private/window.h"
+
+/***********************************************************************
+ *
+ * Private class data
+ *
+ ***********************************************************************/
+
+/* the mid and side signals of a stereo frame live after the input channels */
+#define FLAC__STREAM_ENCODER_MID_CHANNEL (FLAC__MAX_CHANNELS)
+#define FLAC__STREAM_ENCODER_SIDE_CHANNEL (FLAC__MAX_CHANNELS + 1)
+#define FLAC__STREAM_ENCODER_MAX_SIGNALS (FLAC__MAX_CHANNELS + 2)
+
+/* the two signals each stereo channel assignment codes, in frame order */
+static const unsigned assignment_signals_[4][2] = {
+    { 0, 1 },
+    { 0, FLAC__STREAM_ENCODER_SIDE_CHANNEL },
+    { FLAC__STREAM_ENCODER_SIDE_CHANNEL, 1 },
+    { FLAC__STREAM_ENCODER_MID_CHANNEL, FLAC__STREAM_ENCODER_SIDE_CHANNEL }
+};
+
+/* the LPC window is a tukey(0.5) */
+static const FLAC__real FLAC__STREAM_ENCODER_TUKEY_P = 0.5f;
+
+/*
+ * Variable blocksize: a block is measured in this many units, and two
+ * neighbouring units whose levels differ by more than the ratio are a
+ * transient. At most FLAC__STREAM_ENCODER_MAX_SPLITS of them are tried as
+ * split points, so a block becomes at most FLAC__STREAM_ENCODER_MAX_FRAMES
+ * frames.
+ */
+#define FLAC__STREAM_ENCODER_VARIABLE_BLOCKSIZE_UNITS (16u)
+#define FLAC__STREAM_ENCODER_MAX_SPLITS (4u)
+#define FLAC__STREAM_ENCODER_MAX_FRAMES (FLAC__STREAM_ENCODER_MAX_SPLITS + 1)
+static const double FLAC__STREAM_ENCODER_TRANSIENT_RATIO = 4.0;
+
+typedef struct {
+    FLAC__bool do_mid_side_stereo;
+    unsigned blocksize;
+    unsigned max_lpc_order;
+    unsigned min_residual_partition_order;
+    unsigned max_residual_partition_order;
+    FLAC__bool do_exhaustive_model_search;
+    unsigned search_effort;
+} CompressionLevels;
+
+static const CompressionLevels compression_levels_[] = {
+    { false, 1152,  0, 0, 3, false, 0 },
+    { true , 1152,  0, 0, 3, false, 0 },
+    { true , 1152,  0, 0, 3, false, 0 },
+    { false, 4096,  6, 0, 4, false, 0 },
+    { true , 4096,  8, 0, 4, false, 0 },
+    { true , 4096,  8, 0, 5, false, 0 },
+    { true , 4096,  8, 0, 6, false, 1 },
+    { true , 4096, 12, 0, 6, false, 2 },
+    { true , 4096, 12, 0, 6, true , 3 }
+};
+
+/*
+ * How far the adaptive search walks away from the estimated best LPC
+ * order and from the default coefficient precision: it gives up on a
+ * direction after this many steps in a row that are no smaller. 0 tries
+ * the estimate only.
+ */
+typedef struct {
+    unsigned order_patience;
+    unsigned precision_patience;
+    FLAC__bool all_fixed_orders; /* the fixed residuals are cheap, just try them all */
+} SearchEffort;
+
+static const SearchEffort search_efforts_[FLAC__STREAM_ENCODER_MAX_SEARCH_EFFORT + 1] = {
+    { 0, 0, false },
+    { 1, 0, false },
+    { 2, 1, true  },
+    { 3, 2, true  }
+};
+
+/*
+ * The bounds the frame search is compiled for. FormatLimits are the
+ * format's own and are always safe; SubsetLimits are the streamable
+ * subset's up to 48kHz, which FLAC__stream_encoder_init() has checked
+ * the settings against before choosing them. With the limits known at
+ * compile time the search arrays shrink to fit and the LPC residual goes
+ * straight to the kernel of its order.
+ */
+struct FormatLimits {
+    enum {
+        max_blocksize = FLAC__MAX_BLOCK_SIZE,
+        max_lpc_order = FLAC__MAX_LPC_ORDER,
+        max_partition_order = FLAC__MAX_RICE_PARTITION_ORDER
+    };
+};
+
+struct SubsetLimits {
+    enum {
+        max_blocksize = FLAC__SUBSET_MAX_BLOCK_SIZE_48000Hz,
+        max_lpc_order = FLAC__SUBSET_MAX_LPC_ORDER_48000HZ,
+        max_partition_order = FLAC__SUBSET_MAX_RICE_PARTITION_ORDER
+    };
+};
+
+/*
+ * A frame moves through the task ring in order:
+ * EMPTY -> (filled by process()) -> QUEUED -> (compressed by a worker)
+ * -> ENCODED -> (hashed, in frame order) -> DONE -> (written, in frame
+ * order) -> EMPTY.
+ */
+typedef enum {
+    FLAC__STREAM_ENCODER_TASK_EMPTY = 0,
+    FLAC__STREAM_ENCODER_TASK_QUEUED,
+    FLAC__STREAM_ENCODER_TASK_ENCODED,
+    FLAC__STREAM_ENCODER_TASK_DONE
+} FLAC__StreamEncoderTaskState;
+
+/*
+ * The search state of one signal: two candidate subframes, the best one
+ * so far and the one being tried, each with its own residual and Rice
+ * parameters, so keeping the winner is only a swap of 'best'.
+ */
+typedef struct {
+    FLAC__Subframe subframe[2];
+    FLAC__int32 *residual[2];
+    FLAC__EntropyCodingMethod_PartitionedRiceContents partitioned_rice_contents[2];
+    /* the signal with the wasted bits shifted out, when there are any */
+    FLAC__int32 *shifted;
+    unsigned best;
+    unsigned bits; /* the estimated size of subframe[best] */
+    unsigned subframe_bps;
+} FLAC__StreamEncoderSubframeWorkspace;
+
+/*
+ * Everything needed to compress one frame. A worker only touches the
+ * task it took, so tasks need no locking besides their state.
+ */
+typedef struct {
+    FLAC__StreamEncoderTaskState state;
+    FLAC__bool ok;
+    FLAC__uint32 frame_number;
+    FLAC__uint64 sample_number; /* of the first sample in the block */
+    unsigned blocksize; /* the samples in this block; only the last block can be short */
+    FLAC__int32 *signal[FLAC__STREAM_ENCODER_MAX_SIGNALS];
+    FLAC__StreamEncoderSubframeWorkspace workspace[FLAC__STREAM_ENCODER_MAX_SIGNALS];
+    FLAC__EntropyCodingMethod_PartitionedRiceContents partitioned_rice_contents_extra[2];
+    FLAC__uint64 *abs_residual_partition_sums;
+    FLAC__real *window;
+    unsigned window_len; /* the blocksize 'window' was computed for */
+    FLAC__real *windowed_signal;
+    FLAC__BitWriter *frame;
+    /* variable blocksize: the block's frames back to back, each one built in 'frame' first */
+    FLAC__BitWriter *frames;
+    unsigned num_frames;
+    unsigned frame_blocksize[FLAC__STREAM_ENCODER_MAX_FRAMES];
+    size_t frame_bytes[FLAC__STREAM_ENCODER_MAX_FRAMES];
+} FLAC__StreamEncoderTask;
+
+/*
+ * The worker threads and their queue. Tasks are queued in ring order, so
+ * the queue is just the index of the oldest queued task and a count.
+ */
+struct FLAC__StreamEncoderThreadPool {
+    std::mutex mutex;
+    std::condition_variable work_available; /* workers wait here for queued tasks */
+    std::condition_variable task_done; /* the writer waits here for the oldest task */
+    unsigned next_queued, num_queued;
+    FLAC__bool hashing; /* a worker is running the MD5 */
+    FLAC__bool shutdown;
+    std::vector<std::thread> workers;
+};
+
+struct FLAC__StreamEncoder {
+    FLAC__StreamEncoderState state;
+
+    /* settings */
+    unsigned num_threads;
+    unsigned channels;
+    unsigned bits_per_sample;
+    unsigned sample_rate;
+    unsigned blocksize;
+    FLAC__bool variable_blocksize;
+    FLAC__bool do_mid_side_stereo;
+    unsigned max_lpc_order;
+    unsigned qlp_coeff_precision;
+    FLAC__bool do_qlp_coeff_prec_search;
+    FLAC__bool do_exhaustive_model_search;
+    unsigned search_effort;
+    unsigned min_residual_partition_order;
+    unsigned max_residual_partition_order;
+    FLAC__uint64 total_samples_estimate;
+    FLAC__bool do_md5;
+    FLAC__bool streamable_subset;
+    long ogg_serial_number;
+
+    FLAC__IOHandle handle;
+    FLAC__IOCallbacks callbacks;
+    /*
+     * the stream offset of the STREAMINFO body, or -1 if it cannot be
+     * rewritten; for Ogg FLAC the offset of the first page, which holds it
+     */
+    FLAC__int64 streaminfo_offset;
+    /* Ogg FLAC: every write goes through the muxer, the first page is kept to be rewritten */
+    FLAC__bool ogg;
+    FLAC__OggMuxer ogg_muxer;
+    FLAC__byte ogg_first_page[FLAC__OGG_PAGE_HEADER_LENGTH + 1 + FLAC__OGG_MAPPING_HEADER_LENGTH + FLAC__STREAM_SYNC_LENGTH + FLAC__STREAM_METADATA_HEADER_LENGTH + FLAC__STREAM_METADATA_STREAMINFO_LENGTH];
+    size_t ogg_first_page_bytes;
+    FLAC__StreamMetadata_StreamInfo stream_info;
+    FLAC__MD5Context md5context;
+
+    /* resolved at init from the settings */
+    unsigned resolved_qlp_coeff_precision;
+    unsigned rice_parameter_limit;
+    unsigned variable_unit; /* the samples in one unit of a block, see split_block_() */
+    FLAC__bool (*process_frame)(const FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task);
+    const FLAC__Dispatch *dispatch; /* the kernels for this machine */
+    FLAC__StereoDecorrelateFunction local_stereo_decorrelate;
+
+    /* the task ring; a single task when encoding on the calling thread */
+    FLAC__Arena scratch; /* holds the ring and all of its buffers, kept across streams */
+    unsigned num_tasks;
+    FLAC__StreamEncoderTask *tasks;
+    unsigned fill_task; /* the task process() is filling */
+    unsigned fill_samples; /* the samples in it so far */
+    unsigned write_task; /* the oldest task not yet written */
+    unsigned hash_task; /* the oldest task not yet hashed */
+    FLAC__uint32 next_frame_number;
+    FLAC__uint64 next_sample_number;
+    FLAC__uint64 samples_written;
+    /* variable blocksize: the block sizes written so far, the last frame's is only known not to be last when the next comes */
+    unsigned min_blocksize_written, max_blocksize_written, last_blocksize_written;
+
+    FLAC__StreamEncoderThreadPool *pool;
+};
+
+/***********************************************************************
+ *
+ * Private class method prototypes
+ *
+ ***********************************************************************/
+
+static void set_defaults_(FLAC__StreamEncoder *encoder);
+static FLAC__bool allocate_tasks_(FLAC__StreamEncoder *encoder);
+static void layout_tasks_(FLAC__StreamEncoder *encoder);
+static void layout_partitioned_rice_contents_(FLAC__Arena *arena, FLAC__EntropyCodingMethod_PartitionedRiceContents *object, unsigned max_partition_order);
+static void free_tasks_(FLAC__StreamEncoder *encoder);
+static FLAC__bool start_threads_(FLAC__StreamEncoder *encoder);
+static void stop_threads_(FLAC__StreamEncoder *encoder);
+static void worker_thread_(FLAC__StreamEncoder *encoder);
+static void hash_tasks_(FLAC__StreamEncoder *encoder, std::unique_lock<std::mutex> &lock);
+static FLAC__bool hash_task_(FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task);
+static FLAC__bool submit_task_(FLAC__StreamEncoder *encoder);
+static FLAC__bool write_finished_tasks_(FLAC__StreamEncoder *encoder, FLAC__bool drain);
+static FLAC__bool write_task_(FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task);
+static FLAC__bool write_bitbuffer_(FLAC__StreamEncoder *encoder, FLAC__BitWriter *bw, FLAC__uint64 granule_position);
+static FLAC__bool write_bytes_(FLAC__StreamEncoder *encoder, const FLAC__byte *buffer, size_t bytes, FLAC__uint64 granule_position);
+static FLAC__bool write_ogg_page_(const FLAC__byte *header, size_t header_bytes, const FLAC__byte *body, size_t body_bytes, void *client_data);
+static FLAC__bool update_metadata_(FLAC__StreamEncoder *encoder);
+template <class Limits> static FLAC__bool process_frame_(const FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task);
+template <class Limits> static unsigned split_block_(const FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task, unsigned bounds[]);
+template <class Limits> static unsigned analyze_frame_(const FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task, unsigned offset, unsigned blocksize, FLAC__ChannelAssignment *channel_assignment);
+static FLAC__bool add_frame_(const FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task, unsigned offset, unsigned blocksize, FLAC__ChannelAssignment channel_assignment, FLAC__BitWriter *bw);
+template <class Limits> static void process_subframe_(const FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task, unsigned offset, unsigned blocksize, unsigned bits_per_sample, unsigned channel);
+static FLAC__bool add_subframe_(const FLAC__StreamEncoderSubframeWorkspace *workspace, unsigned blocksize, FLAC__BitWriter *bw);
+static unsigned evaluate_constant_subframe_(const FLAC__int32 signal, unsigned subframe_bps, FLAC__Subframe *subframe);
+template <class Limits> static unsigned evaluate_fixed_subframe_(const FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task, const FLAC__int32 signal[], FLAC__int32 residual[], FLAC__EntropyCodingMethod_PartitionedRiceContents *partitioned_rice_contents, unsigned blocksize, unsigned subframe_bps, unsigned order, FLAC__Subframe *subframe);
+template <class Limits> static unsigned evaluate_lpc_subframe_(const FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task, const FLAC__int32 signal[], FLAC__int32 residual[], FLAC__EntropyCodingMethod_PartitionedRiceContents *partitioned_rice_contents, const double lp_coeff[], unsigned blocksize, unsigned subframe_bps, unsigned order, unsigned qlp_coeff_precision, FLAC__Subframe *subframe);
+template <class Limits> static void search_lpc_(const FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task, FLAC__StreamEncoderSubframeWorkspace *workspace, const FLAC__int32 signal[], unsigned blocksize, const double lp_coeff[][FLAC__MAX_LPC_ORDER], const double lpc_error[], unsigned max_lpc_order);
+template <class Limits> static unsigned try_lpc_subframe_(const FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task, FLAC__StreamEncoderSubframeWorkspace *workspace, const FLAC__int32 signal[], const double lp_coeff[], unsigned blocksize, unsigned order, unsigned qlp_coeff_precision);
+static unsigned evaluate_verbatim_subframe_(const FLAC__int32 signal[], unsigned blocksize, unsigned subframe_bps, FLAC__Subframe *subframe);
+template <class Limits> static unsigned find_best_partition_order_(const FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task, const FLAC__int32 residual[], unsigned residual_samples, unsigned predictor_order, FLAC__EntropyCodingMethod *best_ecm);
+static void precompute_partition_info_sums_(const FLAC__int32 residual[], FLAC__uint64 abs_residual_partition_sums[], unsigned residual_samples, unsigned predictor_order, unsigned min_partition_order, unsigned max_partition_order);
+static FLAC__bool set_partitioned_rice_(const FLAC__uint64 abs_residual_partition_sums[], unsigned residual_samples, unsigned predictor_order, unsigned rice_parameter_limit, unsigned partition_order, FLAC__EntropyCodingMethod_PartitionedRiceContents *partitioned_rice_contents, unsigned *bits);
+static unsigned get_wasted_bits_(const FLAC__int32 signal[], unsigned samples);
+
+/***********************************************************************
+ *
+ * Public static class data
+ *
+ ***********************************************************************/
+
+FLAC_API const char * const FLAC__StreamEncoderStateString[] = {
+    "FLAC__STREAM_ENCODER_OK",
+    "FLAC__STREAM_ENCODER_UNINITIALIZED",
+    "FLAC__STREAM_ENCODER_CLIENT_ERROR",
+    "FLAC__STREAM_ENCODER_FRAMING_ERROR",
+    "FLAC__STREAM_ENCODER_MEMORY_ALLOCATION_ERROR"
+};
+
+FLAC_API const char * const FLAC__StreamEncoderInitStatusString[] = {
+    "FLAC__STREAM_ENCODER_INIT_STATUS_OK",
+    "FLAC__STREAM_ENCODER_INIT_STATUS_ENCODER_ERROR",
+    "FLAC__STREAM_ENCODER_INIT_STATUS_INVALID_CALLBACKS",
+    "FLAC__STREAM_ENCODER_INIT_STATUS_INVALID_NUMBER_OF_CHANNELS",
+    "FLAC__STREAM_ENCODER_INIT_STATUS_INVALID_BITS_PER_SAMPLE",
+    "FLAC__STREAM_ENCODER_INIT_STATUS_INVALID_SAMPLE_RATE",
+    "FLAC__STREAM_ENCODER_INIT_STATUS_INVALID_BLOCK_SIZE",
+    "FLAC__STREAM_ENCODER_INIT_STATUS_INVALID_MAX_LPC_ORDER",
+    "FLAC__STREAM_ENCODER_INIT_STATUS_INVALID_QLP_COEFF_PRECISION",
+    "FLAC__STREAM_ENCODER_INIT_STATUS_BLOCK_SIZE_TOO_SMALL_FOR_LPC_ORDER",
+    "FLAC__STREAM_ENCODER_INIT_STATUS_NOT_STREAMABLE",
+    "FLAC__STREAM_ENCODER_INIT_STATUS_MEMORY_ALLOCATION_ERROR",
+    "FLAC__STREAM_ENCODER_INIT_STATUS_ALREADY_INITIALIZED"
+};
+
+/***********************************************************************
+ *
+ * Class constructor/destructor
+ *
+ ***********************************************************************/
+
+FLAC_API FLAC__StreamEncoder *FLAC__stream_encoder_new(void)
+{
+    FLAC__StreamEncoder *encoder;
+
+    encoder = (FLAC__StreamEncoder*)calloc(1, sizeof(FLAC__StreamEncoder));
+    if (encoder == 0)
+        return 0;
+
+    FLAC__arena_init(&encoder->scratch);
+    set_defaults_(encoder);
+
+    encoder->state = FLAC__STREAM_ENCODER_UNINITIALIZED;
+
+    return encoder;
+}
+
+FLAC_API void FLAC__stream_encoder_delete(FLAC__StreamEncoder *encoder)
+{
+    if (encoder == 0)
+        return;
+
+    (void)FLAC__stream_encoder_finish(encoder);
+
+    FLAC__arena_free(&encoder->scratch);
+    FLAC__ogg_muxer_free(&encoder->ogg_muxer);
+    free(encoder);
+}
+
+/***********************************************************************
+ *
+ * Public class methods
+ *
+ ***********************************************************************/
+
+FLAC_API FLAC__StreamEncoderInitStatus FLAC__stream_encoder_init(FLAC__StreamEncoder *encoder, FLAC__IOHandle handle, FLAC__IOCallbacks callbacks)
+{
+    FLAC__BitWriter *bw;
+    FLAC__bool ok;
+
+    FLAC_ASSERT(0 != encoder);
+
+    if (encoder->state != FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return FLAC__STREAM_ENCODER_INIT_STATUS_ALREADY_INITIALIZED;
+
+    if (callbacks.write == 0)
+        return FLAC__STREAM_ENCODER_INIT_STATUS_INVALID_CALLBACKS;
+
+    if (encoder->channels == 0 || encoder->channels > FLAC__MAX_CHANNELS)
+        return FLAC__STREAM_ENCODER_INIT_STATUS_INVALID_NUMBER_OF_CHANNELS;
+
+    if (encoder->bits_per_sample < FLAC__MIN_BITS_PER_SAMPLE || encoder->bits_per_sample > FLAC__MAX_BITS_PER_SAMPLE)
+        return FLAC__STREAM_ENCODER_INIT_STATUS_INVALID_BITS_PER_SAMPLE;
+
+    if (!FLAC__format_sample_rate_is_valid(encoder->sample_rate))
+        return FLAC__STREAM_ENCODER_INIT_STATUS_INVALID_SAMPLE_RATE;
+
+    if (encoder->blocksize < FLAC__MIN_BLOCK_SIZE || encoder->blocksize > FLAC__MAX_BLOCK_SIZE)
+        return FLAC__STREAM_ENCODER_INIT_STATUS_INVALID_BLOCK_SIZE;
+
+    if (encoder->max_lpc_order > FLAC__MAX_LPC_ORDER)
+        return FLAC__STREAM_ENCODER_INIT_STATUS_INVALID_MAX_LPC_ORDER;
+
+    if (encoder->blocksize < encoder->max_lpc_order)
+        return FLAC__STREAM_ENCODER_INIT_STATUS_BLOCK_SIZE_TOO_SMALL_FOR_LPC_ORDER;
+
+    if (encoder->streamable_subset) {
+        if (!FLAC__format_sample_rate_is_subset(encoder->sample_rate))
+            return FLAC__STREAM_ENCODER_INIT_STATUS_NOT_STREAMABLE;
+        if (encoder->bits_per_sample != 8 && encoder->bits_per_sample != 12 && encoder->bits_per_sample != 16 && encoder->bits_per_sample != 20 && encoder->bits_per_sample != 24 && encoder->bits_per_sample != 32)
+            return FLAC__STREAM_ENCODER_INIT_STATUS_NOT_STREAMABLE;
+        if (!FLAC__format_blocksize_is_subset(encoder->blocksize, encoder->sample_rate))
+            return FLAC__STREAM_ENCODER_INIT_STATUS_NOT_STREAMABLE;
+        if (encoder->sample_rate <= 48000 && encoder->max_lpc_order > FLAC__SUBSET_MAX_LPC_ORDER_48000HZ)
+            return FLAC__STREAM_ENCODER_INIT_STATUS_NOT_STREAMABLE;
+        if (encoder->max_residual_partition_order > FLAC__SUBSET_MAX_RICE_PARTITION_ORDER)
+            return FLAC__STREAM_ENCODER_INIT_STATUS_NOT_STREAMABLE;
+    }
+
+    /* the subset limits only get tighter than the format's up to 48kHz */
+    if (encoder->streamable_subset && encoder->sample_rate <= 48000)
+        encoder->process_frame = process_frame_<SubsetLimits>;
+    else
+        encoder->process_frame = process_frame_<FormatLimits>;
+
+    /*
+     * set the function pointers for this CPU; the SIMD kernels only cover
+     * up to FLAC__STEREO_MAX_SIMD_DECORRELATE_BPS
+     */
+    encoder->dispatch = FLAC__dispatch();
+    if (encoder->bits_per_sample <= FLAC__STEREO_MAX_SIMD_DECORRELATE_BPS)
+        encoder->local_stereo_decorrelate = encoder->dispatch->stereo_decorrelate;
+    else
+        encoder->local_stereo_decorrelate = FLAC__stereo_decorrelate;
+
+    if (encoder->qlp_coeff_precision == 0) {
+        /* pick a precision by blocksize and bits-per-sample, as the reference encoder does */
+        if (encoder->bits_per_sample < 16)
+            encoder->resolved_qlp_coeff_precision = flac_max(FLAC__MIN_QLP_COEFF_PRECISION, 2 + encoder->bits_per_sample / 2);
+        else if (encoder->bits_per_sample == 16) {
+            if (encoder->blocksize <= 192)
+                encoder->resolved_qlp_coeff_precision = 7;
+            else if (encoder->blocksize <= 384)
+                encoder->resolved_qlp_coeff_precision = 8;
+            else if (encoder->blocksize <= 576)
+                encoder->resolved_qlp_coeff_precision = 9;
+            else if (encoder->blocksize <= 1152)
+                encoder->resolved_qlp_coeff_precision = 10;
+            else if (encoder->blocksize <= 2304)
+                encoder->resolved_qlp_coeff_precision = 11;
+            else if (encoder->blocksize <= 4608)
+                encoder->resolved_qlp_coeff_precision = 12;
+            else
+                encoder->resolved_qlp_coeff_precision = 13;
+        }
+        else {
+            if (encoder->blocksize <= 384)
+                encoder->resolved_qlp_coeff_precision = FLAC__MAX_QLP_COEFF_PRECISION - 2;
+            else if (encoder->blocksize <= 1152)
+                encoder->resolved_qlp_coeff_precision = FLAC__MAX_QLP_COEFF_PRECISION - 1;
+            else
+                encoder->resolved_qlp_coeff_precision = FLAC__MAX_QLP_COEFF_PRECISION;
+        }
+    }
+    else if (encoder->qlp_coeff_precision < FLAC__MIN_QLP_COEFF_PRECISION || encoder->qlp_coeff_precision > FLAC__MAX_QLP_COEFF_PRECISION)
+        return FLAC__STREAM_ENCODER_INIT_STATUS_INVALID_QLP_COEFF_PRECISION;
+    else
+        encoder->resolved_qlp_coeff_precision = encoder->qlp_coeff_precision;
+
+    if (encoder->min_residual_partition_order > encoder->max_residual_partition_order)
+        encoder->min_residual_partition_order = encoder->max_residual_partition_order;
+
+    /* 4-bit Rice parameters are enough up to 16 bits-per-sample */
+    encoder->rice_parameter_limit = encoder->bits_per_sample > 16 ? FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2_ESCAPE_PARAMETER : FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_ESCAPE_PARAMETER;
+
+    /* every frame but the last is at least one unit, and a unit is never below the format's minimum */
+    encoder->variable_unit = flac_max(encoder->blocksize / FLAC__STREAM_ENCODER_VARIABLE_BLOCKSIZE_UNITS, FLAC__MIN_BLOCK_SIZE);
+
+    if (encoder->num_threads == 0) {
+        encoder->num_threads = std::thread::hardware_concurrency();
+        if (encoder->num_threads == 0)
+            encoder->num_threads = 1;
+        encoder->num_threads = flac_min(encoder->num_threads, FLAC__STREAM_ENCODER_MAX_THREADS);
+    }
+
+    encoder->handle = handle;
+    encoder->callbacks = callbacks;
+
+    /* two tasks per worker keep the workers busy while the writer waits for the oldest one */
+    encoder->num_tasks = encoder->num_threads > 1 ? 2 * encoder->num_threads : 1;
+    encoder->fill_task = encoder->fill_samples = 0;
+    encoder->write_task = encoder->hash_task = 0;
+    encoder->next_frame_number = 0;
+    encoder->next_sample_number = 0;
+    encoder->samples_written = 0;
+    encoder->min_blocksize_written = encoder->max_blocksize_written = encoder->last_blocksize_written = 0;
+    if (!allocate_tasks_(encoder)) {
+        free_tasks_(encoder);
+        return FLAC__STREAM_ENCODER_INIT_STATUS_MEMORY_ALLOCATION_ERROR;
+    }
+
+    memset(&encoder->stream_info, 0, sizeof(encoder->stream_info));
+    /* with a variable blocksize, the bounds until finish() knows the sizes that were used */
+    encoder->stream_info.min_blocksize = encoder->variable_blocksize ? flac_min(encoder->variable_unit, encoder->blocksize) : encoder->blocksize;
+    encoder->stream_info.max_blocksize = encoder->blocksize;
+    encoder->stream_info.min_framesize = 0; /* we don't know this yet; have to fill it in later */
+    encoder->stream_info.max_framesize = 0; /* we don't know this yet; have to fill it in later */
+    encoder->stream_info.sample_rate = encoder->sample_rate;
+    encoder->stream_info.channels = encoder->channels;
+    encoder->stream_info.bits_per_sample = encoder->bits_per_sample;
+    encoder->stream_info.total_samples = encoder->total_samples_estimate; /* we will replace this later with the real total */
+    if (encoder->do_md5)
+        FLAC__MD5Init(&encoder->md5context);
+
+    /*
+     * write the stream header; STREAMINFO can only be updated later if we
+     * know where it went
+     */
+    encoder->streaminfo_offset = -1;
+    if (callbacks.seek && callbacks.tell) {
+        const FLAC__int64 pos = callbacks.tell(handle);
+        if (pos >= 0)
+            encoder->streaminfo_offset = encoder->ogg ? pos : pos + FLAC__STREAM_SYNC_LENGTH + FLAC__STREAM_METADATA_HEADER_LENGTH;
+    }
+    if (encoder->ogg) {
+        if (!FLAC__ogg_muxer_init(&encoder->ogg_muxer, (FLAC__uint32)encoder->ogg_serial_number)) {
+            free_tasks_(encoder);
+            encoder->ogg = false;
+            return FLAC__STREAM_ENCODER_INIT_STATUS_MEMORY_ALLOCATION_ERROR;
+        }
+        encoder->ogg_first_page_bytes = 0;
+    }
+
+    encoder->state = FLAC__STREAM_ENCODER_OK;
+
+    /* the first task's bitwriter is free until the first frame, borrow it */
+    bw = encoder->tasks[0].frame;
+    FLAC__bitwriter_clear(bw);
+    ok = true;
+    if (encoder->ogg) {
+        /* the mapping header goes in front, in the same packet; one more header packet follows, VORBIS_COMMENT */
+        ok =
+            FLAC__bitwriter_write_raw_uint32(bw, 0x7f, 8) &&
+            FLAC__bitwriter_write_raw_uint32(bw, ((FLAC__uint32)'F' << 24) | ((FLAC__uint32)'L' << 16) | ((FLAC__uint32)'A' << 8) | 'C', 32) &&
+            FLAC__bitwriter_write_raw_uint32(bw, FLAC__OGG_MAPPING_VERSION_MAJOR, 8) &&
+            FLAC__bitwriter_write_raw_uint32(bw, FLAC__OGG_MAPPING_VERSION_MINOR, 8) &&
+            FLAC__bitwriter_write_raw_uint32(bw, 1, 16);
+    }
+    ok = ok &&
+        FLAC__bitwriter_write_raw_uint32(bw, FLAC__STREAM_SYNC, FLAC__STREAM_SYNC_LEN) &&
+        FLAC__add_metadata_block_streaminfo(&encoder->stream_info, /*is_last=*/!encoder->ogg, bw);
+    if (!ok) {
+        encoder->state = FLAC__STREAM_ENCODER_FRAMING_ERROR;
+        (void)FLAC__stream_encoder_finish(encoder);
+        return FLAC__STREAM_ENCODER_INIT_STATUS_ENCODER_ERROR;
+    }
+    if (!write_bitbuffer_(encoder, bw, /*granule_position=*/0)) {
+        (void)FLAC__stream_encoder_finish(encoder);
+        return FLAC__STREAM_ENCODER_INIT_STATUS_ENCODER_ERROR;
+    }
+    /* the first packet is alone on the first page */
+    if (encoder->ogg && !FLAC__ogg_muxer_flush(&encoder->ogg_muxer, /*eos=*/false, write_ogg_page_, encoder)) {
+        encoder->state = FLAC__STREAM_ENCODER_CLIENT_ERROR;
+        (void)FLAC__stream_encoder_finish(encoder);
+        return FLAC__STREAM_ENCODER_INIT_STATUS_ENCODER_ERROR;
+    }
+    /* the mapping wants VORBIS_COMMENT next, as a packet of its own; the audio starts on a fresh page after it */
+    if (encoder->ogg) {
+        FLAC__bitwriter_clear(bw);
+        if (!FLAC__add_metadata_block_vorbis_comment(FLAC__VENDOR_STRING, /*is_last=*/true, bw)) {
+            encoder->state = FLAC__STREAM_ENCODER_FRAMING_ERROR;
+            (void)FLAC__stream_encoder_finish(encoder);
+            return FLAC__STREAM_ENCODER_INIT_STATUS_ENCODER_ERROR;
+        }
+        if (!write_bitbuffer_(encoder, bw, /*granule_position=*/0)) {
+            (void)FLAC__stream_encoder_finish(encoder);
+            return FLAC__STREAM_ENCODER_INIT_STATUS_ENCODER_ERROR;
+        }
+        if (!FLAC__ogg_muxer_flush(&encoder->ogg_muxer, /*eos=*/false, write_ogg_page_, encoder)) {
+            encoder->state = FLAC__STREAM_ENCODER_CLIENT_ERROR;
+            (void)FLAC__stream_encoder_finish(encoder);
+            return FLAC__STREAM_ENCODER_INIT_STATUS_ENCODER_ERROR;
+        }
+    }
+
+    if (encoder->num_threads > 1 && !start_threads_(encoder)) {
+        encoder->state = FLAC__STREAM_ENCODER_MEMORY_ALLOCATION_ERROR;
+        (void)FLAC__stream_encoder_finish(encoder);
+        return FLAC__STREAM_ENCODER_INIT_STATUS_ENCODER_ERROR;
+    }
+
+    return FLAC__STREAM_ENCODER_INIT_STATUS_OK;
+}
+
+FLAC_API FLAC__StreamEncoderInitStatus FLAC__stream_encoder_init_ogg(FLAC__StreamEncoder *encoder, FLAC__IOHandle handle, FLAC__IOCallbacks callbacks)
+{
+    FLAC__StreamEncoderInitStatus status;
+
+    FLAC_ASSERT(0 != encoder);
+
+    if (encoder->state != FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return FLAC__STREAM_ENCODER_INIT_STATUS_ALREADY_INITIALIZED;
+
+    /* FLAC__stream_encoder_init() does the rest; finish() clears the flag again */
+    encoder->ogg = true;
+    status = FLAC__stream_encoder_init(encoder, handle, callbacks);
+    if (status != FLAC__STREAM_ENCODER_INIT_STATUS_OK)
+        encoder->ogg = false;
+    return status;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_finish(FLAC__StreamEncoder *encoder)
+{
+    FLAC__bool error = false;
+
+    FLAC_ASSERT(0 != encoder);
+
+    if (encoder->state == FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return true;
+
+    /* the last block is usually short */
+    if (encoder->state == FLAC__STREAM_ENCODER_OK && encoder->fill_samples > 0) {
+        if (!submit_task_(encoder))
+            error = true;
+    }
+
+    /* write (or, after an error, drop) everything still in flight, then stop the workers */
+    if (encoder->pool != 0) {
+        if (!write_finished_tasks_(encoder, /*drain=*/true))
+            error = true;
+        stop_threads_(encoder);
+    }
+
+    if (encoder->do_md5)
+        FLAC__MD5Final(encoder->stream_info.md5sum, &encoder->md5context);
+
+    if (encoder->state == FLAC__STREAM_ENCODER_OK && encoder->ogg) {
+        if (!FLAC__ogg_muxer_flush(&encoder->ogg_muxer, /*eos=*/true, write_ogg_page_, encoder)) {
+            encoder->state = FLAC__STREAM_ENCODER_CLIENT_ERROR;
+            error = true;
+        }
+    }
+
+    if (encoder->state == FLAC__STREAM_ENCODER_OK) {
+        encoder->stream_info.total_samples = encoder->samples_written;
+        /* the minimum leaves out the last frame, so it is only known if there was more than one */
+        if (encoder->variable_blocksize && encoder->min_blocksize_written > 0) {
+            encoder->stream_info.min_blocksize = encoder->min_blocksize_written;
+            encoder->stream_info.max_blocksize = encoder->max_blocksize_written;
+        }
+        if (!update_metadata_(encoder))
+            error = true;
+    }
+    else
+        error = true;
+
+    free_tasks_(encoder);
+    encoder->ogg = false;
+
+    encoder->handle = 0;
+    memset(&encoder->callbacks, 0, sizeof(encoder->callbacks));
+
+    encoder->state = FLAC__STREAM_ENCODER_UNINITIALIZED;
+
+    return !error;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_set_num_threads(FLAC__StreamEncoder *encoder, unsigned value)
+{
+    FLAC_ASSERT(0 != encoder);
+    if (encoder->state != FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return false;
+    if (value > FLAC__STREAM_ENCODER_MAX_THREADS)
+        return false;
+    encoder->num_threads = value;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_set_channels(FLAC__StreamEncoder *encoder, unsigned value)
+{
+    FLAC_ASSERT(0 != encoder);
+    if (encoder->state != FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return false;
+    encoder->channels = value;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_set_bits_per_sample(FLAC__StreamEncoder *encoder, unsigned value)
+{
+    FLAC_ASSERT(0 != encoder);
+    if (encoder->state != FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return false;
+    encoder->bits_per_sample = value;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_set_sample_rate(FLAC__StreamEncoder *encoder, unsigned value)
+{
+    FLAC_ASSERT(0 != encoder);
+    if (encoder->state != FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return false;
+    encoder->sample_rate = value;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_set_compression_level(FLAC__StreamEncoder *encoder, unsigned value)
+{
+    const CompressionLevels *level;
+
+    FLAC_ASSERT(0 != encoder);
+    if (encoder->state != FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return false;
+    if (value >= sizeof(compression_levels_) / sizeof(compression_levels_[0]))
+        value = sizeof(compression_levels_) / sizeof(compression_levels_[0]) - 1;
+    level = &compression_levels_[value];
+    encoder->do_mid_side_stereo = level->do_mid_side_stereo;
+    encoder->blocksize = level->blocksize;
+    encoder->max_lpc_order = level->max_lpc_order;
+    encoder->qlp_coeff_precision = 0;
+    encoder->do_qlp_coeff_prec_search = false;
+    encoder->do_exhaustive_model_search = level->do_exhaustive_model_search;
+    encoder->search_effort = level->search_effort;
+    encoder->min_residual_partition_order = level->min_residual_partition_order;
+    encoder->max_residual_partition_order = level->max_residual_partition_order;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_set_blocksize(FLAC__StreamEncoder *encoder, unsigned value)
+{
+    FLAC_ASSERT(0 != encoder);
+    if (encoder->state != FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return false;
+    encoder->blocksize = value;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_set_variable_blocksize(FLAC__StreamEncoder *encoder, FLAC__bool value)
+{
+    FLAC_ASSERT(0 != encoder);
+    if (encoder->state != FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return false;
+    encoder->variable_blocksize = value;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_set_do_mid_side_stereo(FLAC__StreamEncoder *encoder, FLAC__bool value)
+{
+    FLAC_ASSERT(0 != encoder);
+    if (encoder->state != FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return false;
+    encoder->do_mid_side_stereo = value;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_set_max_lpc_order(FLAC__StreamEncoder *encoder, unsigned value)
+{
+    FLAC_ASSERT(0 != encoder);
+    if (encoder->state != FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return false;
+    encoder->max_lpc_order = value;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_set_qlp_coeff_precision(FLAC__StreamEncoder *encoder, unsigned value)
+{
+    FLAC_ASSERT(0 != encoder);
+    if (encoder->state != FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return false;
+    encoder->qlp_coeff_precision = value;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_set_do_qlp_coeff_prec_search(FLAC__StreamEncoder *encoder, FLAC__bool value)
+{
+    FLAC_ASSERT(0 != encoder);
+    if (encoder->state != FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return false;
+    encoder->do_qlp_coeff_prec_search = value;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_set_do_exhaustive_model_search(FLAC__StreamEncoder *encoder, FLAC__bool value)
+{
+    FLAC_ASSERT(0 != encoder);
+    if (encoder->state != FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return false;
+    encoder->do_exhaustive_model_search = value;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_set_search_effort(FLAC__StreamEncoder *encoder, unsigned value)
+{
+    FLAC_ASSERT(0 != encoder);
+    if (encoder->state != FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return false;
+    if (value > FLAC__STREAM_ENCODER_MAX_SEARCH_EFFORT)
+        return false;
+    encoder->search_effort = value;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_set_min_residual_partition_order(FLAC__StreamEncoder *encoder, unsigned value)
+{
+    FLAC_ASSERT(0 != encoder);
+    if (encoder->state != FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return false;
+    encoder->min_residual_partition_order = flac_min(value, FLAC__MAX_RICE_PARTITION_ORDER);
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_set_max_residual_partition_order(FLAC__StreamEncoder *encoder, unsigned value)
+{
+    FLAC_ASSERT(0 != encoder);
+    if (encoder->state != FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return false;
+    encoder->max_residual_partition_order = flac_min(value, FLAC__MAX_RICE_PARTITION_ORDER);
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_set_total_samples_estimate(FLAC__StreamEncoder *encoder, FLAC__uint64 value)
+{
+    FLAC_ASSERT(0 != encoder);
+    if (encoder->state != FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return false;
+    encoder->total_samples_estimate = value;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_set_do_md5(FLAC__StreamEncoder *encoder, FLAC__bool value)
+{
+    FLAC_ASSERT(0 != encoder);
+    if (encoder->state != FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return false;
+    encoder->do_md5 = value;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_set_streamable_subset(FLAC__StreamEncoder *encoder, FLAC__bool value)
+{
+    FLAC_ASSERT(0 != encoder);
+    if (encoder->state != FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return false;
+    encoder->streamable_subset = value;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_set_ogg_serial_number(FLAC__StreamEncoder *encoder, long value)
+{
+    FLAC_ASSERT(0 != encoder);
+    if (encoder->state != FLAC__STREAM_ENCODER_UNINITIALIZED)
+        return false;
+    encoder->ogg_serial_number = value;
+    return true;
+}
+
+FLAC_API FLAC__StreamEncoderState FLAC__stream_encoder_get_state(const FLAC__StreamEncoder *encoder)
+{
+    FLAC_ASSERT(0 != encoder);
+    return encoder->state;
+}
+
+FLAC_API const char *FLAC__stream_encoder_get_resolved_state_string(const FLAC__StreamEncoder *encoder)
+{
+    return FLAC__StreamEncoderStateString[encoder->state];
+}
+
+FLAC_API unsigned FLAC__stream_encoder_get_num_threads(const FLAC__StreamEncoder *encoder)
+{
+    FLAC_ASSERT(0 != encoder);
+    return encoder->num_threads;
+}
+
+FLAC_API const FLAC__StreamMetadata_StreamInfo *FLAC__stream_encoder_get_stream_info(const FLAC__StreamEncoder *encoder)
+{
+    FLAC_ASSERT(0 != encoder);
+    return &encoder->stream_info;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_process(FLAC__StreamEncoder *encoder, const FLAC__int32 * const buffer[], unsigned samples)
+{
+    unsigned i, j = 0, n;
+    FLAC__StreamEncoderTask *task;
+
+    FLAC_ASSERT(0 != encoder);
+
+    if (encoder->state != FLAC__STREAM_ENCODER_OK)
+        return false;
+
+    while (j < samples) {
+        /* submit_task_() only moves on to a task that is empty */
+        task = &encoder->tasks[encoder->fill_task];
+        n = flac_min(encoder->blocksize - encoder->fill_samples, samples - j);
+        for (i = 0; i < encoder->channels; i++)
+            memcpy(task->signal[i] + encoder->fill_samples, buffer[i] + j, sizeof(FLAC__int32) * n);
+        encoder->fill_samples += n;
+        j += n;
+
+        if (encoder->fill_samples == encoder->blocksize && !submit_task_(encoder))
+            return false; /* submit_task_ sets the state for us */
+    }
+
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__stream_encoder_process_interleaved(FLAC__StreamEncoder *encoder, const FLAC__int32 buffer[], unsigned samples)
+{
+    unsigned i, j = 0, k, n, channel;
+    const unsigned channels = encoder->channels;
+    FLAC__StreamEncoderTask *task;
+
+    FLAC_ASSERT(0 != encoder);
+
+    if (encoder->state != FLAC__STREAM_ENCODER_OK)
+        return false;
+
+    while (j < samples) {
+        task = &encoder->tasks[encoder->fill_task];
+        n = flac_min(encoder->blocksize - encoder->fill_samples, samples - j);
+        for (channel = 0; channel < channels; channel++) {
+            FLAC__int32 *signal = task->signal[channel] + encoder->fill_samples;
+            const FLAC__int32 *in = buffer + (size_t)j * channels + channel;
+            for (i = 0, k = 0; i < n; i++, k += channels)
+                signal[i] = in[k];
+        }
+        encoder->fill_samples += n;
+        j += n;
+
+        if (encoder->fill_samples == encoder->blocksize && !submit_task_(encoder))
+            return false; /* submit_task_ sets the state for us */
+    }
+
+    return true;
+}
+
+/***********************************************************************
+ *
+ * Private class methods
+ *
+ ***********************************************************************/
+
+void set_defaults_(FLAC__StreamEncoder *encoder)
+{
+    FLAC_ASSERT(0 != encoder);
+
+    encoder->num_threads = 1;
+    encoder->channels = 2;
+    encoder->bits_per_sample = 16;
+    encoder->sample_rate = 44100;
+    encoder->total_samples_estimate = 0;
+    encoder->do_md5 = true;
+    encoder->streamable_subset = false;
+    encoder->variable_blocksize = false;
+    encoder->ogg_serial_number = 0;
+    (void)FLAC__stream_encoder_set_compression_level(encoder, 5);
+
+    encoder->handle = 0;
+    memset(&encoder->callbacks, 0, sizeof(encoder->callbacks));
+    encoder->pool = 0;
+    encoder->tasks = 0;
+    encoder->num_tasks = 0;
+}
+
+/*
+ * Lays every task's buffers out in encoder->scratch for the configured
+ * blocksize, so that compressing a frame never allocates (the bitwriter
+ * only grows if a frame comes out larger than verbatim, which cannot
+ * happen). The block is kept by FLAC__stream_encoder_finish(), so the
+ * next stream with the same settings allocates nothing but its
+ * bitwriters.
+ */
+FLAC__bool allocate_tasks_(FLAC__StreamEncoder *encoder)
+{
+    unsigned t;
+
+    FLAC__arena_begin_count(&encoder->scratch);
+    layout_tasks_(encoder);
+    if (!FLAC__arena_reserve(&encoder->scratch, encoder->scratch.used))
+        return false;
+    layout_tasks_(encoder);
+
+    for (t = 0; t < encoder->num_tasks; t++) {
+        FLAC__StreamEncoderTask *task = &encoder->tasks[t];
+
+        task->state = FLAC__STREAM_ENCODER_TASK_EMPTY;
+        task->window_len = 0;
+        if ((task->frame = FLAC__bitwriter_new()) == 0)
+            return false;
+        /* verbatim is the worst case, plus the headers */
+        if (!FLAC__bitwriter_init(task->frame, (size_t)encoder->blocksize * encoder->channels * ((encoder->bits_per_sample + 8) / 8) + 1024))
+            return false;
+        if (encoder->variable_blocksize) {
+            if ((task->frames = FLAC__bitwriter_new()) == 0)
+                return false;
+            if (!FLAC__bitwriter_init(task->frames, (size_t)encoder->blocksize * encoder->channels * ((encoder->bits_per_sample + 8) / 8) + 1024 * FLAC__STREAM_ENCODER_MAX_FRAMES))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/* Carves the task ring out of encoder->scratch, or counts it, see private/arena.h. */
+void layout_tasks_(FLAC__StreamEncoder *encoder)
+{
+    FLAC__Arena *arena = &encoder->scratch;
+    const unsigned blocksize = encoder->blocksize;
+    const unsigned signals = (encoder->channels == 2 && encoder->do_mid_side_stereo) ? FLAC__STREAM_ENCODER_MAX_SIGNALS : encoder->channels;
+    FLAC__StreamEncoderTask counted;
+    unsigned t, i, j;
+
+    encoder->tasks = (FLAC__StreamEncoderTask*)FLAC__arena_carve(arena, sizeof(FLAC__StreamEncoderTask) * encoder->num_tasks);
+    if (encoder->tasks != 0)
+        memset(encoder->tasks, 0, sizeof(FLAC__StreamEncoderTask) * encoder->num_tasks);
+
+    for (t = 0; t < encoder->num_tasks; t++) {
+        /* while counting there are no tasks yet to hold the (NULL) pointers */
+        FLAC__StreamEncoderTask *task = encoder->tasks != 0 ? &encoder->tasks[t] : &counted;
+
+        for (i = 0; i < FLAC__STREAM_ENCODER_MAX_SIGNALS; i++) {
+            FLAC__StreamEncoderSubframeWorkspace *workspace = &task->workspace[i];
+            /* unused input channels keep NULL buffers */
+            if (i < encoder->channels || (signals == FLAC__STREAM_ENCODER_MAX_SIGNALS && i >= FLAC__MAX_CHANNELS)) {
+                task->signal[i] = (FLAC__int32*)FLAC__arena_carve(arena, sizeof(FLAC__int32) * blocksize);
+                workspace->shifted = (FLAC__int32*)FLAC__arena_carve(arena, sizeof(FLAC__int32) * blocksize);
+                for (j = 0; j < 2; j++) {
+                    workspace->residual[j] = (FLAC__int32*)FLAC__arena_carve(arena, sizeof(FLAC__int32) * blocksize);
+                    layout_partitioned_rice_contents_(arena, &workspace->partitioned_rice_contents[j], encoder->max_residual_partition_order);
+                }
+            }
+        }
+        for (j = 0; j < 2; j++)
+            layout_partitioned_rice_contents_(arena, &task->partitioned_rice_contents_extra[j], encoder->max_residual_partition_order);
+        /* the partition sums of every order from max down to 0 */
+        task->abs_residual_partition_sums = (FLAC__uint64*)FLAC__arena_carve(arena, sizeof(FLAC__uint64) * (2u << encoder->max_residual_partition_order));
+        if (encoder->max_lpc_order > 0) {
+            task->window = (FLAC__real*)FLAC__arena_carve(arena, sizeof(FLAC__real) * blocksize);
+            task->windowed_signal = (FLAC__real*)FLAC__arena_carve(arena, sizeof(FLAC__real) * blocksize);
+        }
+    }
+}
+
+void layout_partitioned_rice_contents_(FLAC__Arena *arena, FLAC__EntropyCodingMethod_PartitionedRiceContents *object, unsigned max_partition_order)
+{
+    object->parameters = (unsigned*)FLAC__arena_carve(arena, sizeof(unsigned) * (1u << max_partition_order));
+    object->raw_bits = (unsigned*)FLAC__arena_carve(arena, sizeof(unsigned) * (1u << max_partition_order));
+    object->capacity_by_order = max_partition_order;
+}
+
+/* The buffers stay in encoder->scratch for the next stream; only the bitwriters go. */
+void free_tasks_(FLAC__StreamEncoder *encoder)
+{
+    unsigned t;
+
+    if (encoder->tasks == 0)
+        return;
+
+    for (t = 0; t < encoder->num_tasks; t++) {
+        if (encoder->tasks[t].frame != 0)
+            FLAC__bitwriter_delete(encoder->tasks[t].frame);
+        if (encoder->tasks[t].frames != 0)
+            FLAC__bitwriter_delete(encoder->tasks[t].frames);
+    }
+    encoder->tasks = 0;
+    encoder->num_tasks = 0;
+}
+
+FLAC__bool start_threads_(FLAC__StreamEncoder *encoder)
+{
+    unsigned i;
+
+    encoder->pool = new(std::nothrow) FLAC__StreamEncoderThreadPool();
+    if (encoder->pool == 0)
+        return false;
+    encoder->pool->next_queued = encoder->pool->num_queued = 0;
+    encoder->pool->hashing = false;
+    encoder->pool->shutdown = false;
+
+    try {
+        for (i = 0; i < encoder->num_threads; i++)
+            encoder->pool->workers.push_back(std::thread(worker_thread_, encoder));
+    }
+    catch (const std::system_error &) {
+        stop_threads_(encoder);
+        return false;
+    }
+    catch (const std::bad_alloc &) {
+        stop_threads_(encoder);
+        return false;
+    }
+    return true;
+}
+
+void stop_threads_(FLAC__StreamEncoder *encoder)
+{
+    FLAC__StreamEncoderThreadPool *pool = encoder->pool;
+    size_t i;
+
+    if (pool == 0)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->shutdown = true;
+    }
+    pool->work_available.notify_all();
+    for (i = 0; i < pool->workers.size(); i++)
+        pool->workers[i].join();
+    delete pool;
+    encoder->pool = 0;
+}
+
+void worker_thread_(FLAC__StreamEncoder *encoder)
+{
+    FLAC__StreamEncoderThreadPool *pool = encoder->pool;
+    FLAC__StreamEncoderTask *task;
+    std::unique_lock<std::mutex> lock(pool->mutex);
+
+    while (1) {
+        pool->work_available.wait(lock, [pool] { return pool->shutdown || pool->num_queued > 0; });
+        /* finish the queue before honoring a shutdown */
+        if (pool->num_queued == 0)
+            return;
+        task = &encoder->tasks[pool->next_queued];
+        pool->next_queued = (pool->next_queued + 1) % encoder->num_tasks;
+        pool->num_queued--;
+
+        lock.unlock();
+        task->ok = encoder->process_frame(encoder, task);
+        lock.lock();
+
+        task->state = FLAC__STREAM_ENCODER_TASK_ENCODED;
+        hash_tasks_(encoder, lock);
+    }
+}
+
+/*
+ * The MD5 has to see the frames in order. Whichever worker finds the
+ * oldest unhashed frame encoded takes the job and keeps hashing until
+ * it runs into a frame that is not encoded yet; the others go back to
+ * compressing.
+ */
+void hash_tasks_(FLAC__StreamEncoder *encoder, std::unique_lock<std::mutex> &lock)
+{
+    FLAC__StreamEncoderThreadPool *pool = encoder->pool;
+    FLAC__StreamEncoderTask *task;
+
+    if (pool->hashing)
+        return;
+    pool->hashing = true;
+    while (encoder->tasks[encoder->hash_task].state == FLAC__STREAM_ENCODER_TASK_ENCODED) {
+        task = &encoder->tasks[encoder->hash_task];
+        lock.unlock();
+        if (task->ok)
+            task->ok = hash_task_(encoder, task);
+        lock.lock();
+        task->state = FLAC__STREAM_ENCODER_TASK_DONE;
+        encoder->hash_task = (encoder->hash_task + 1) % encoder->num_tasks;
+        pool->task_done.notify_all();
+    }
+    pool->hashing = false;
+}
+
+FLAC__bool hash_task_(FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task)
+{
+    if (!encoder->do_md5)
+        return true;
+    return FLAC__MD5Accumulate(&encoder->md5context, task->signal, encoder->channels, task->blocksize, (encoder->bits_per_sample + 7) / 8);
+}
+
+/*
+ * Hands the task being filled over for compression. Without worker
+ * threads it is compressed, hashed and written right here; otherwise it
+ * is queued and the finished frames are written, waiting for the task
+ * to be filled next if it is still in flight.
+ */
+FLAC__bool submit_task_(FLAC__StreamEncoder *encoder)
+{
+    FLAC__StreamEncoderTask *task = &encoder->tasks[encoder->fill_task];
+    FLAC__StreamEncoderThreadPool *pool = encoder->pool;
+
+    task->blocksize = encoder->fill_samples;
+    task->frame_number = encoder->next_frame_number++;
+    task->sample_number = encoder->next_sample_number;
+    encoder->next_sample_number += task->blocksize;
+    encoder->fill_samples = 0;
+
+    if (pool == 0) {
+        task->ok = encoder->process_frame(encoder, task) && hash_task_(encoder, task);
+        return write_task_(encoder, task);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        task->state = FLAC__STREAM_ENCODER_TASK_QUEUED;
+        pool->num_queued++;
+    }
+    pool->work_available.notify_one();
+    encoder->fill_task = (encoder->fill_task + 1) % encoder->num_tasks;
+
+    return write_finished_tasks_(encoder, /*drain=*/false);
+}
+
+/*
+ * The in-order writer. Writes every finished frame from the oldest one
+ * on, stopping at the first one still in flight unless 'drain' is set or
+ * it is the task process() needs to fill next.
+ */
+FLAC__bool write_finished_tasks_(FLAC__StreamEncoder *encoder, FLAC__bool drain)
+{
+    FLAC__StreamEncoderThreadPool *pool = encoder->pool;
+    FLAC__StreamEncoderTask *task;
+    FLAC__bool ok = true;
+    std::unique_lock<std::mutex> lock(pool->mutex);
+
+    while (1) {
+        task = &encoder->tasks[encoder->write_task];
+        if (task->state == FLAC__STREAM_ENCODER_TASK_EMPTY)
+            break; /* nothing in flight */
+        if (task->state != FLAC__STREAM_ENCODER_TASK_DONE) {
+            if (!drain && encoder->tasks[encoder->fill_task].state == FLAC__STREAM_ENCODER_TASK_EMPTY)
+                break;
+            pool->task_done.wait(lock);
+            continue;
+        }
+
+        lock.unlock();
+        /* after an error the remaining frames are only dropped */
+        if (encoder->state == FLAC__STREAM_ENCODER_OK)
+            ok = write_task_(encoder, task) && ok;
+        lock.lock();
+        task->state = FLAC__STREAM_ENCODER_TASK_EMPTY;
+        encoder->write_task = (encoder->write_task + 1) % encoder->num_tasks;
+    }
+
+    return ok && encoder->state == FLAC__STREAM_ENCODER_OK;
+}
+
+FLAC__bool write_task_(FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task)
+{
+    size_t bytes;
+    const FLAC__byte *buffer;
+    unsigned f;
+
+    if (!task->ok) {
+        encoder->state = FLAC__STREAM_ENCODER_FRAMING_ERROR;
+        return false;
+    }
+
+    if (!FLAC__bitwriter_get_buffer(encoder->variable_blocksize ? task->frames : task->frame, &buffer, &bytes)) {
+        encoder->state = FLAC__STREAM_ENCODER_FRAMING_ERROR;
+        return false;
+    }
+
+    /* one packet per frame for Ogg FLAC */
+    for (f = 0; f < task->num_frames; f++) {
+        const unsigned blocksize = task->frame_blocksize[f];
+
+        bytes = task->frame_bytes[f];
+        if (!write_bytes_(encoder, buffer, bytes, encoder->samples_written + blocksize))
+            return false; /* write_bytes_ sets the state for us */
+        buffer += bytes;
+
+        /* keep the STREAMINFO statistics */
+        encoder->samples_written += blocksize;
+        if (encoder->stream_info.min_framesize == 0 || bytes < encoder->stream_info.min_framesize)
+            encoder->stream_info.min_framesize = (unsigned)bytes;
+        if (bytes > encoder->stream_info.max_framesize)
+            encoder->stream_info.max_framesize = (unsigned)bytes;
+        if (encoder->last_blocksize_written > 0 && (encoder->min_blocksize_written == 0 || encoder->last_blocksize_written < encoder->min_blocksize_written))
+            encoder->min_blocksize_written = encoder->last_blocksize_written;
+        encoder->max_blocksize_written = flac_max(encoder->max_blocksize_written, blocksize);
+        encoder->last_blocksize_written = blocksize;
+    }
+
+    return true;
+}
+
+/* For Ogg FLAC the bytes are one packet, ending at 'granule_position'. */
+FLAC__bool write_bitbuffer_(FLAC__StreamEncoder *encoder, FLAC__BitWriter *bw, FLAC__uint64 granule_position)
+{
+    const FLAC__byte *buffer;
+    size_t bytes;
+
+    FLAC_ASSERT(FLAC__bitwriter_is_byte_aligned(bw));
+
+    if (!FLAC__bitwriter_get_buffer(bw, &buffer, &bytes)) {
+        encoder->state = FLAC__STREAM_ENCODER_MEMORY_ALLOCATION_ERROR;
+        return false;
+    }
+
+    return write_bytes_(encoder, buffer, bytes, granule_position);
+}
+
+FLAC__bool write_bytes_(FLAC__StreamEncoder *encoder, const FLAC__byte *buffer, size_t bytes, FLAC__uint64 granule_position)
+{
+    if (encoder->ogg) {
+        if (!FLAC__ogg_muxer_packet(&encoder->ogg_muxer, buffer, bytes, granule_position, write_ogg_page_, encoder)) {
+            encoder->state = FLAC__STREAM_ENCODER_CLIENT_ERROR;
+            return false;
+        }
+    }
+    else if (encoder->callbacks.write(buffer, 1, bytes, encoder->handle) != bytes) {
+        encoder->state = FLAC__STREAM_ENCODER_CLIENT_ERROR;
+        return false;
+    }
+
+    return true;
+}
+
+FLAC__bool write_ogg_page_(const FLAC__byte *header, size_t header_bytes, const FLAC__byte *body, size_t body_bytes, void *client_data)
+{
+    FLAC__StreamEncoder *encoder = (FLAC__StreamEncoder*)client_data;
+
+    /* keep the first page, update_metadata_() rewrites it with the final STREAMINFO */
+    if (encoder->ogg_first_page_bytes == 0 && header_bytes + body_bytes == sizeof(encoder->ogg_first_page)) {
+        memcpy(encoder->ogg_first_page, header, header_bytes);
+        memcpy(encoder->ogg_first_page + header_bytes, body, body_bytes);
+        encoder->ogg_first_page_bytes = header_bytes + body_bytes;
+    }
+
+    return
+        encoder->callbacks.write(header, 1, header_bytes, encoder->handle) == header_bytes &&
+        encoder->callbacks.write(body, 1, body_bytes, encoder->handle) == body_bytes;
+}
+
+/*
+ * Puts the final total samples, frame sizes and MD5 into the STREAMINFO
+ * written at init, if the output can seek back to it.
+ */
+FLAC__bool update_metadata_(FLAC__StreamEncoder *encoder)
+{
+    FLAC__BitWriter *bw;
+    const FLAC__byte *buffer;
+    size_t bytes;
+    FLAC__int64 end;
+    FLAC__bool ok;
+
+    if (encoder->streaminfo_offset < 0)
+        return true;
+
+    end = encoder->callbacks.tell(encoder->handle);
+    if (end < 0)
+        return true; /* not seekable after all, leave STREAMINFO as it is */
+
+    bw = FLAC__bitwriter_new();
+    if (bw == 0)
+        return false;
+    ok =
+        FLAC__bitwriter_init(bw, FLAC__STREAM_METADATA_STREAMINFO_LENGTH) &&
+        FLAC__add_streaminfo_body(&encoder->stream_info, bw) &&
+        FLAC__bitwriter_get_buffer(bw, &buffer, &bytes);
+    if (ok && encoder->ogg) {
+        /* STREAMINFO is at the end of the first page, whose CRC changes with it */
+        FLAC__byte *page = encoder->ogg_first_page;
+        FLAC_ASSERT(encoder->ogg_first_page_bytes == sizeof(encoder->ogg_first_page));
+        memcpy(page + sizeof(encoder->ogg_first_page) - bytes, buffer, bytes);
+        FLAC__ogg_page_set_checksum(page, FLAC__OGG_PAGE_HEADER_LENGTH + 1, page + FLAC__OGG_PAGE_HEADER_LENGTH + 1, sizeof(encoder->ogg_first_page) - FLAC__OGG_PAGE_HEADER_LENGTH - 1);
+        buffer = page;
+        bytes = sizeof(encoder->ogg_first_page);
+    }
+    if (ok) {
+        ok =
+            encoder->callbacks.seek(encoder->handle, encoder->streaminfo_offset, SEEK_SET) == 0 &&
+            encoder->callbacks.write(buffer, 1, bytes, encoder->handle) == bytes &&
+            encoder->callbacks.seek(encoder->handle, end, SEEK_SET) == 0;
+        if (!ok)
+            encoder->state = FLAC__STREAM_ENCODER_CLIENT_ERROR;
+    }
+    FLAC__bitwriter_delete(bw);
+
+    return ok;
+}
+
+/*
+ * Compresses the task's block into task->frame, or with a variable
+ * blocksize into the frames split_block_() picks, one after the other in
+ * task->frames. Only reads the encoder's settings, so any number of these
+ * can run at once on different tasks.
+ */
+template <class Limits>
+FLAC__bool process_frame_(const FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task)
+{
+    FLAC__ChannelAssignment channel_assignment;
+    unsigned bounds[FLAC__STREAM_ENCODER_MAX_FRAMES + 1], f;
+    const FLAC__byte *buffer;
+    size_t bytes;
+
+    FLAC_ASSERT(task->blocksize > 0);
+
+    if (!encoder->variable_blocksize) {
+        (void)analyze_frame_<Limits>(encoder, task, 0, task->blocksize, &channel_assignment);
+        if (!add_frame_(encoder, task, 0, task->blocksize, channel_assignment, task->frame) || !FLAC__bitwriter_get_buffer(task->frame, &buffer, &bytes))
+            return false;
+        task->num_frames = 1;
+        task->frame_blocksize[0] = task->blocksize;
+        task->frame_bytes[0] = bytes;
+        return true;
+    }
+
+    task->num_frames = split_block_<Limits>(encoder, task, bounds);
+    FLAC__bitwriter_clear(task->frames);
+    for (f = 0; f < task->num_frames; f++) {
+        const unsigned blocksize = bounds[f + 1] - bounds[f];
+
+        (void)analyze_frame_<Limits>(encoder, task, bounds[f], blocksize, &channel_assignment);
+        if (!add_frame_(encoder, task, bounds[f], blocksize, channel_assignment, task->frame) || !FLAC__bitwriter_get_buffer(task->frame, &buffer, &bytes))
+            return false;
+        if (!FLAC__bitwriter_write_byte_block(task->frames, buffer, (unsigned)bytes))
+            return false;
+        task->frame_blocksize[f] = blocksize;
+        task->frame_bytes[f] = bytes;
+    }
+    return true;
+}
+
+/* a frame header and footer with a sample number of a few bytes and a block size of 16 bits, near enough for comparing splits */
+#define FRAME_OVERHEAD_BITS_ (14u * 8u)
+
+/*
+ * Picks the frames a block is cut into with a variable blocksize and
+ * returns how many; frame f runs from bounds[f] to bounds[f + 1].
+ *
+ * The block is measured in units of encoder->variable_unit samples (the
+ * last one also takes the remainder): the level of a unit is the mean
+ * absolute difference between consecutive samples, over the input
+ * channels. Where two neighbouring levels differ by more than
+ * FLAC__STREAM_ENCODER_TRANSIENT_RATIO there is a transient. A block
+ * without one is a single frame, and costs nothing but the measurement.
+ * Otherwise the strongest FLAC__STREAM_ENCODER_MAX_SPLITS transients are
+ * the candidate split points, and a dynamic-programming search over the
+ * frames between any two of them (or the ends of the block) keeps the
+ * split with the smallest estimated size; at most 15 frames are
+ * estimated. The whole block is one of the candidates, so the split is
+ * never estimated to be larger than not splitting.
+ */
+template <class Limits>
+unsigned split_block_(const FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task, unsigned bounds[])
+{
+    const unsigned blocksize = task->blocksize;
+    const unsigned unit = encoder->variable_unit;
+    const unsigned units = flac_min(blocksize / unit, FLAC__STREAM_ENCODER_VARIABLE_BLOCKSIZE_UNITS);
+    double level[FLAC__STREAM_ENCODER_VARIABLE_BLOCKSIZE_UNITS], strength[FLAC__STREAM_ENCODER_VARIABLE_BLOCKSIZE_UNITS];
+    unsigned points[FLAC__STREAM_ENCODER_MAX_SPLITS + 2], num_points, best_from[FLAC__STREAM_ENCODER_MAX_SPLITS + 2];
+    FLAC__uint64 best_bits[FLAC__STREAM_ENCODER_MAX_SPLITS + 2];
+    FLAC__ChannelAssignment channel_assignment;
+    unsigned k, i, j, channel, frames;
+
+    bounds[0] = 0;
+    bounds[1] = blocksize;
+    if (units < 2)
+        return 1;
+
+    for (k = 0; k < units; k++) {
+        const unsigned start = k * unit, end = k + 1 == units ? blocksize : start + unit;
+        FLAC__uint64 sum = 0;
+
+        for (channel = 0; channel < encoder->channels; channel++) {
+            const FLAC__int32 *signal = task->signal[channel];
+            for (i = flac_max(start, 1u); i < end; i++)
+                sum += (FLAC__uint64)(signal[i] >= signal[i - 1] ? (FLAC__int64)signal[i] - signal[i - 1] : (FLAC__int64)signal[i - 1] - signal[i]);
+        }
+        /* the 1 keeps silence and the last bit of dither from looking like transients */
+        level[k] = (double)sum / (double)(end - start) + 1.0;
+    }
+
+    /* strength[k] is the transient between units k - 1 and k, 0 if it is too weak to be one */
+    for (k = 1; k < units; k++) {
+        const double ratio = level[k] > level[k - 1] ? level[k] / level[k - 1] : level[k - 1] / level[k];
+        strength[k] = ratio >= FLAC__STREAM_ENCODER_TRANSIENT_RATIO ? ratio : 0.0;
+    }
+
+    /* the strongest ones, ties to the earlier, then back in block order */
+    num_points = 0;
+    points[num_points++] = 0;
+    while (num_points <= FLAC__STREAM_ENCODER_MAX_SPLITS) {
+        unsigned strongest = 0;
+        for (k = 1; k < units; k++)
+            if (strength[k] > 0.0 && (strongest == 0 || strength[k] > strength[strongest]))
+                strongest = k;
+        if (strongest == 0)
+            break;
+        strength[strongest] = 0.0;
+        for (i = num_points; points[i - 1] > strongest * unit; i--)
+            points[i] = points[i - 1];
+        points[i] = strongest * unit;
+        num_points++;
+    }
+    if (num_points == 1)
+        return 1;
+    points[num_points++] = blocksize;
+
+    /* best_bits[j] is the smallest estimate for the block up to points[j], its last frame starting at points[best_from[j]] */
+    best_bits[0] = 0;
+    for (j = 1; j < num_points; j++) {
+        best_bits[j] = 0;
+        for (i = 0; i < j; i++) {
+            const FLAC__uint64 bits = best_bits[i] + FRAME_OVERHEAD_BITS_ + analyze_frame_<Limits>(encoder, task, points[i], points[j] - points[i], &channel_assignment);
+            /* ties go to the longer frame */
+            if (i == 0 || bits < best_bits[j]) {
+                best_bits[j] = bits;
+                best_from[j] = i;
+            }
+        }
+    }
+
+    /* walk back from the end of the block */
+    frames = 0;
+    for (j = num_points - 1; j > 0; j = best_from[j])
+        frames++;
+    bounds[frames] = blocksize;
+    for (j = num_points - 1, k = frames; j > 0; j = best_from[j])
+        bounds[--k] = points[best_from[j]];
+    FLAC_ASSERT(bounds[0] == 0);
+    return frames;
+}
+
+/*
+ * Searches the subframes of the frame of 'blocksize' samples at 'offset'
+ * in the task's block and picks the stereo channel assignment, leaving
+ * the subframes in the task's workspaces for add_frame_(). Returns the
+ * estimated size of the subframes in bits.
+ */
+template <class Limits>
+unsigned analyze_frame_(const FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task, unsigned offset, unsigned blocksize, FLAC__ChannelAssignment *channel_assignment)
+{
+    const FLAC__bool do_mid_side = encoder->do_mid_side_stereo && encoder->channels == 2 && encoder->bits_per_sample < 32;
+    FLAC__uint64 abs_residual_sum[FLAC__STEREO_SIGNALS];
+    unsigned channel, i, bits;
+
+    /* below 32 bits-per-sample mid and side fit in 32 bits */
+    if (do_mid_side)
+        encoder->local_stereo_decorrelate(task->signal[0] + offset, task->signal[1] + offset, blocksize, task->signal[FLAC__STREAM_ENCODER_MID_CHANNEL] + offset, task->signal[FLAC__STREAM_ENCODER_SIDE_CHANNEL] + offset, abs_residual_sum);
+
+    *channel_assignment = FLAC__CHANNEL_ASSIGNMENT_INDEPENDENT;
+    if (!do_mid_side) {
+        bits = 0;
+        for (channel = 0; channel < encoder->channels; channel++) {
+            process_subframe_<Limits>(encoder, task, offset, blocksize, encoder->bits_per_sample, channel);
+            bits += task->workspace[channel].bits;
+        }
+    }
+    else if (encoder->search_effort == 0 && !encoder->do_exhaustive_model_search) {
+        /* only the two signals of the assignment the residual sums point at are compressed */
+        *channel_assignment = FLAC__stereo_estimate_channel_assignment(abs_residual_sum, blocksize);
+        bits = 0;
+        for (i = 0; i < 2; i++) {
+            channel = assignment_signals_[*channel_assignment][i];
+            process_subframe_<Limits>(encoder, task, offset, blocksize, encoder->bits_per_sample + (channel == FLAC__STREAM_ENCODER_SIDE_CHANNEL ? 1 : 0), channel);
+            bits += task->workspace[channel].bits;
+        }
+    }
+    else {
+        unsigned assignment_bits[4];
+
+        for (channel = 0; channel < encoder->channels; channel++)
+            process_subframe_<Limits>(encoder, task, offset, blocksize, encoder->bits_per_sample, channel);
+        process_subframe_<Limits>(encoder, task, offset, blocksize, encoder->bits_per_sample, FLAC__STREAM_ENCODER_MID_CHANNEL);
+        process_subframe_<Limits>(encoder, task, offset, blocksize, encoder->bits_per_sample + 1, FLAC__STREAM_ENCODER_SIDE_CHANNEL);
+
+        assignment_bits[FLAC__CHANNEL_ASSIGNMENT_INDEPENDENT] = task->workspace[0].bits + task->workspace[1].bits;
+        assignment_bits[FLAC__CHANNEL_ASSIGNMENT_LEFT_SIDE] = task->workspace[0].bits + task->workspace[FLAC__STREAM_ENCODER_SIDE_CHANNEL].bits;
+        assignment_bits[FLAC__CHANNEL_ASSIGNMENT_RIGHT_SIDE] = task->workspace[1].bits + task->workspace[FLAC__STREAM_ENCODER_SIDE_CHANNEL].bits;
+        assignment_bits[FLAC__CHANNEL_ASSIGNMENT_MID_SIDE] = task->workspace[FLAC__STREAM_ENCODER_MID_CHANNEL].bits + task->workspace[FLAC__STREAM_ENCODER_SIDE_CHANNEL].bits;
+
+        /* ties go to the lower assignment, so the choice is deterministic */
+        bits = assignment_bits[FLAC__CHANNEL_ASSIGNMENT_INDEPENDENT];
+        for (i = 1; i < 4; i++) {
+            if (assignment_bits[i] < bits) {
+                *channel_assignment = (FLAC__ChannelAssignment)i;
+                bits = assignment_bits[i];
+            }
+        }
+    }
+
+    return bits;
+}
+
+/* Writes the frame analyze_frame_() left in the workspaces into 'bw', from the start. */
+FLAC__bool add_frame_(const FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task, unsigned offset, unsigned blocksize, FLAC__ChannelAssignment channel_assignment, FLAC__BitWriter *bw)
+{
+    FLAC__FrameHeader frame_header;
+    unsigned channel;
+    FLAC__uint16 crc;
+
+    frame_header.blocksize = blocksize;
+    frame_header.sample_rate = encoder->sample_rate;
+    frame_header.channels = encoder->channels;
+    frame_header.channel_assignment = channel_assignment;
+    frame_header.bits_per_sample = encoder->bits_per_sample;
+    if (encoder->variable_blocksize) {
+        frame_header.number_type = FLAC__FRAME_NUMBER_TYPE_SAMPLE_NUMBER;
+        frame_header.number.sample_number = task->sample_number + offset;
+    }
+    else {
+        frame_header.number_type = FLAC__FRAME_NUMBER_TYPE_FRAME_NUMBER;
+        frame_header.number.frame_number = task->frame_number;
+    }
+
+    FLAC__bitwriter_clear(bw);
+    if (!FLAC__frame_add_header(&frame_header, bw))
+        return false;
+
+    switch (channel_assignment) {
+        case FLAC__CHANNEL_ASSIGNMENT_INDEPENDENT:
+            for (channel = 0; channel < encoder->channels; channel++)
+                if (!add_subframe_(&task->workspace[channel], blocksize, bw))
+                    return false;
+            break;
+        case FLAC__CHANNEL_ASSIGNMENT_LEFT_SIDE:
+            if (!add_subframe_(&task->workspace[0], blocksize, bw) || !add_subframe_(&task->workspace[FLAC__STREAM_ENCODER_SIDE_CHANNEL], blocksize, bw))
+                return false;
+            break;
+        case FLAC__CHANNEL_ASSIGNMENT_RIGHT_SIDE:
+            if (!add_subframe_(&task->workspace[FLAC__STREAM_ENCODER_SIDE_CHANNEL], blocksize, bw) || !add_subframe_(&task->workspace[1], blocksize, bw))
+                return false;
+            break;
+        case FLAC__CHANNEL_ASSIGNMENT_MID_SIDE:
+            if (!add_subframe_(&task->workspace[FLAC__STREAM_ENCODER_MID_CHANNEL], blocksize, bw) || !add_subframe_(&task->workspace[FLAC__STREAM_ENCODER_SIDE_CHANNEL], blocksize, bw))
+                return false;
+            break;
+    }
+
+    /* zero-pad the frame to a byte boundary, then the CRC-16 of everything so far */
+    if (!FLAC__bitwriter_zero_pad_to_byte_boundary(bw))
+        return false;
+    if (!FLAC__bitwriter_get_write_crc16(bw, &crc))
+        return false;
+    if (!FLAC__bitwriter_write_raw_uint32(bw, crc, FLAC__FRAME_FOOTER_CRC_LEN))
+        return false;
+
+    return true;
+}
+
+/*
+ * Searches the subframe types for the 'blocksize' samples of one signal
+ * at 'offset' and leaves the smallest in task->workspace[channel].
+ */
+template <class Limits>
+void process_subframe_(const FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task, unsigned offset, unsigned blocksize, unsigned bits_per_sample, unsigned channel)
+{
+    FLAC__StreamEncoderSubframeWorkspace *workspace = &task->workspace[channel];
+    const FLAC__int32 *signal = task->signal[channel] + offset;
+    unsigned subframe_bps, wasted_bits, candidate_bits, i;
+    unsigned guess_fixed_order, min_fixed_order, max_fixed_order, fixed_order;
+    float fixed_residual_bits_per_sample[FLAC__MAX_FIXED_ORDER + 1];
+    FLAC__bool is_constant;
+
+    FLAC_ASSERT(blocksize <= Limits::max_blocksize);
+
+    /* the wasted bits are shifted into a copy, the input must stay intact for the MD5 */
+    wasted_bits = get_wasted_bits_(signal, blocksize);
+    if (wasted_bits > 0) {
+        for (i = 0; i < blocksize; i++)
+            workspace->shifted[i] = signal[i] >> wasted_bits;
+        signal = workspace->shifted;
+    }
+    subframe_bps = bits_per_sample - wasted_bits;
+    workspace->subframe_bps = subframe_bps;
+
+    /* verbatim is always possible and is the bound to beat */
+    workspace->best = 0;
+    workspace->bits = evaluate_verbatim_subframe_(signal, blocksize, subframe_bps, &workspace->subframe[0]);
+    workspace->subframe[0].wasted_bits = wasted_bits;
+
+    is_constant = true;
+    for (i = 1; i < blocksize; i++) {
+        if (signal[i] != signal[0]) {
+            is_constant = false;
+            break;
+        }
+    }
+    if (is_constant) {
+        candidate_bits = evaluate_constant_subframe_(signal[0], subframe_bps, &workspace->subframe[!workspace->best]);
+        if (candidate_bits < workspace->bits) {
+            workspace->best = !workspace->best;
+            workspace->bits = candidate_bits;
+        }
+        workspace->subframe[workspace->best].wasted_bits = wasted_bits;
+        workspace->bits += wasted_bits;
+        return;
+    }
+
+    if (blocksize <= FLAC__MAX_FIXED_ORDER) {
+        workspace->bits += wasted_bits;
+        return;
+    }
+
+    /* the residual of a fixed predictor can be 'order' bits wider than the signal */
+    max_fixed_order = flac_min(FLAC__MAX_FIXED_ORDER, 32 - subframe_bps);
+    guess_fixed_order = FLAC__fixed_compute_best_predictor(signal + FLAC__MAX_FIXED_ORDER, blocksize - FLAC__MAX_FIXED_ORDER, fixed_residual_bits_per_sample);
+    guess_fixed_order = flac_min(guess_fixed_order, max_fixed_order);
+    if (encoder->do_exhaustive_model_search || search_efforts_[encoder->search_effort].all_fixed_orders)
+        min_fixed_order = 0;
+    else
+        min_fixed_order = max_fixed_order = guess_fixed_order;
+
+    for (fixed_order = min_fixed_order; fixed_order <= max_fixed_order; fixed_order++) {
+        /* the estimate says the residual is no smaller than the signal, don't bother */
+        if (fixed_residual_bits_per_sample[fixed_order] >= (float)subframe_bps)
+            continue;
+        candidate_bits = evaluate_fixed_subframe_<Limits>(encoder, task, signal, workspace->residual[!workspace->best], &workspace->partitioned_rice_contents[!workspace->best], blocksize, subframe_bps, fixed_order, &workspace->subframe[!workspace->best]);
+        if (candidate_bits < workspace->bits) {
+            workspace->best = !workspace->best;
+            workspace->bits = candidate_bits;
+        }
+    }
+
+    if (encoder->max_lpc_order > 0 && blocksize > encoder->max_lpc_order) {
+        double autoc[Limits::max_lpc_order + 1];
+        double lp_coeff[Limits::max_lpc_order][FLAC__MAX_LPC_ORDER];
+        double lpc_error[Limits::max_lpc_order];
+        unsigned max_lpc_order = flac_min(encoder->max_lpc_order, (unsigned)Limits::max_lpc_order), lpc_order;
+        unsigned min_qlp_coeff_precision, max_qlp_coeff_precision, qlp_coeff_precision;
+
+        /* the window only depends on the length, so it is kept between frames */
+        if (task->window_len != blocksize) {
+            FLAC__window_tukey(task->window, (FLAC__int32)blocksize, FLAC__STREAM_ENCODER_TUKEY_P);
+            task->window_len = blocksize;
+        }
+        FLAC__lpc_window_data(signal, task->window, task->windowed_signal, blocksize);
+        encoder->dispatch->lpc_compute_autocorrelation(task->windowed_signal, blocksize, max_lpc_order + 1, autoc);
+
+        /* if autoc[0] == 0.0, the signal is constant and we usually won't get here, but it can happen */
+        if (autoc[0] != 0.0) {
+            FLAC__lpc_compute_lp_coefficients(autoc, &max_lpc_order, lp_coeff, lpc_error);
+            if (encoder->do_exhaustive_model_search) {
+                if (encoder->do_qlp_coeff_prec_search) {
+                    min_qlp_coeff_precision = FLAC__MIN_QLP_COEFF_PRECISION;
+                    max_qlp_coeff_precision = FLAC__MAX_QLP_COEFF_PRECISION;
+                }
+                else
+                    min_qlp_coeff_precision = max_qlp_coeff_precision = encoder->resolved_qlp_coeff_precision;
+
+                for (lpc_order = 1; lpc_order <= max_lpc_order; lpc_order++) {
+                    const double lpc_residual_bits_per_sample = FLAC__lpc_compute_expected_bits_per_residual_sample(lpc_error[lpc_order - 1], blocksize - lpc_order);
+                    if (lpc_residual_bits_per_sample >= (double)subframe_bps)
+                        continue; /* don't even try */
+                    for (qlp_coeff_precision = min_qlp_coeff_precision; qlp_coeff_precision <= max_qlp_coeff_precision; qlp_coeff_precision++)
+                        (void)try_lpc_subframe_<Limits>(encoder, task, workspace, signal, lp_coeff[lpc_order - 1], blocksize, lpc_order, qlp_coeff_precision);
+                }
+            }
+            else
+                search_lpc_<Limits>(encoder, task, workspace, signal, blocksize, lp_coeff, lpc_error, max_lpc_order);
+        }
+    }
+
+    workspace->subframe[workspace->best].wasted_bits = wasted_bits;
+    workspace->bits += wasted_bits;
+}
+
+FLAC__bool add_subframe_(const FLAC__StreamEncoderSubframeWorkspace *workspace, unsigned blocksize, FLAC__BitWriter *bw)
+{
+    const FLAC__Subframe *subframe = &workspace->subframe[workspace->best];
+
+    switch (subframe->type) {
+        case FLAC__SUBFRAME_TYPE_CONSTANT:
+            return FLAC__subframe_add_constant(&subframe->data.constant, workspace->subframe_bps, subframe->wasted_bits, bw);
+        case FLAC__SUBFRAME_TYPE_FIXED:
+            return FLAC__subframe_add_fixed(&subframe->data.fixed, blocksize - subframe->data.fixed.order, workspace->subframe_bps, subframe->wasted_bits, bw);
+        case FLAC__SUBFRAME_TYPE_LPC:
+            return FLAC__subframe_add_lpc(&subframe->data.lpc, blocksize - subframe->data.lpc.order, workspace->subframe_bps, subframe->wasted_bits, bw);
+        case FLAC__SUBFRAME_TYPE_VERBATIM:
+            return FLAC__subframe_add_verbatim(&subframe->data.verbatim, blocksize, workspace->subframe_bps, subframe->wasted_bits, bw);
+        default:
+            FLAC_ASSERT(0);
+            return false;
+    }
+}
+
+/* the estimates below leave out the wasted bits, which every candidate pays the same */
+#define SUBFRAME_HEADER_BITS_ (FLAC__SUBFRAME_ZERO_PAD_LEN + FLAC__SUBFRAME_TYPE_LEN + FLAC__SUBFRAME_WASTED_BITS_FLAG_LEN)
+
+unsigned evaluate_constant_subframe_(const FLAC__int32 signal, unsigned subframe_bps, FLAC__Subframe *subframe)
+{
+    subframe->type = FLAC__SUBFRAME_TYPE_CONSTANT;
+    subframe->data.constant.value = signal;
+
+    return SUBFRAME_HEADER_BITS_ + subframe_bps;
+}
+
+template <class Limits>
+unsigned evaluate_fixed_subframe_(const FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task, const FLAC__int32 signal[], FLAC__int32 residual[], FLAC__EntropyCodingMethod_PartitionedRiceContents *partitioned_rice_contents, unsigned blocksize, unsigned subframe_bps, unsigned order, FLAC__Subframe *subframe)
+{
+    const unsigned residual_samples = blocksize - order;
+    unsigned i, residual_bits;
+
+    /* 32-bit intermediates are enough while the residual fits */
+    if (subframe_bps + order + 1 <= 32)
+        FLAC__fixed_compute_residual(signal + order, residual_samples, order, residual);
+    else
+        FLAC__fixed_compute_residual_wide(signal + order, residual_samples, order, residual);
+
+    subframe->type = FLAC__SUBFRAME_TYPE_FIXED;
+    subframe->data.fixed.entropy_coding_method.type = FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE;
+    subframe->data.fixed.entropy_coding_method.data.partitioned_rice.content = partitioned_rice_contents;
+    subframe->data.fixed.residual = residual;
+
+    residual_bits = find_best_partition_order_<Limits>(encoder, task, residual, residual_samples, order, &subframe->data.fixed.entropy_coding_method);
+
+    subframe->data.fixed.order = order;
+    for (i = 0; i < order; i++)
+        subframe->data.fixed.warmup[i] = signal[i];
+
+    return SUBFRAME_HEADER_BITS_ + order * subframe_bps + residual_bits;
+}
+
+/* returns 0 if the coefficients are unusable */
+template <class Limits>
+unsigned evaluate_lpc_subframe_(const FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task, const FLAC__int32 signal[], FLAC__int32 residual[], FLAC__EntropyCodingMethod_PartitionedRiceContents *partitioned_rice_contents, const double lp_coeff[], unsigned blocksize, unsigned subframe_bps, unsigned order, unsigned qlp_coeff_precision, FLAC__Subframe *subframe)
+{
+    FLAC__int32 qlp_coeff[FLAC__MAX_LPC_ORDER];
+    const unsigned residual_samples = blocksize - order;
+    unsigned i, residual_bits;
+    int quantization;
+
+    if (FLAC__lpc_quantize_coefficients(lp_coeff, order, qlp_coeff_precision, qlp_coeff, &quantization) != 0)
+        return 0; /* this is a hack to indicate to the caller that we can't do lp at this order on this subframe */
+
+    FLAC_ASSERT(order <= Limits::max_lpc_order);
+
+    if (FLAC__lpc_max_prediction_before_shift_bps(subframe_bps, qlp_coeff, order) <= 32 && FLAC__lpc_max_residual_bps(subframe_bps, qlp_coeff, order, quantization) <= 32) {
+        /* the first test is a constant, the subset build never looks at the order */
+        if (Limits::max_lpc_order <= FLAC__SUBSET_MAX_LPC_ORDER_48000HZ || order <= FLAC__SUBSET_MAX_LPC_ORDER_48000HZ)
+            encoder->dispatch->lpc_compute_residual[order](signal + order, residual_samples, qlp_coeff, quantization, residual);
+        else
+            FLAC__lpc_compute_residual_from_qlp_coefficients(signal + order, residual_samples, qlp_coeff, order, quantization, residual);
+    }
+    else if (!FLAC__lpc_compute_residual_from_qlp_coefficients_limit_residual(signal + order, residual_samples, qlp_coeff, order, quantization, residual))
+        return 0;
+
+    subframe->type = FLAC__SUBFRAME_TYPE_LPC;
+    subframe->data.lpc.entropy_coding_method.type = FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE;
+    subframe->data.lpc.entropy_coding_method.data.partitioned_rice.content = partitioned_rice_contents;
+    subframe->data.lpc.residual = residual;
+
+    residual_bits = find_best_partition_order_<Limits>(encoder, task, residual, residual_samples, order, &subframe->data.lpc.entropy_coding_method);
+
+    subframe->data.lpc.order = order;
+    subframe->data.lpc.qlp_coeff_precision = qlp_coeff_precision;
+    memcpy(subframe->data.lpc.qlp_coeff, qlp_coeff, sizeof(FLAC__int32) * FLAC__MAX_LPC_ORDER);
+    subframe->data.lpc.quantization_level = quantization;
+    for (i = 0; i < order; i++)
+        subframe->data.lpc.warmup[i] = signal[i];
+
+    return SUBFRAME_HEADER_BITS_ + FLAC__SUBFRAME_LPC_QLP_COEFF_PRECISION_LEN + FLAC__SUBFRAME_LPC_QLP_SHIFT_LEN + order * (qlp_coeff_precision + subframe_bps) + residual_bits;
+}
+
+/*
+ * The adaptive LPC search. The Levinson-Durbin recursion already gives
+ * the prediction error of every order, hence an estimate of each order's
+ * residual size without computing any residual; the order with the best
+ * estimate is where the search starts. From there it walks to lower and
+ * higher orders, then to coarser and finer coefficient precisions, for
+ * as long as the subframe keeps getting smaller, tolerating the effort's
+ * patience in steps that do not. Only the candidates on the way get a
+ * residual, and each is sized from its partition sums, not encoded.
+ */
+template <class Limits>
+void search_lpc_(const FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task, FLAC__StreamEncoderSubframeWorkspace *workspace, const FLAC__int32 signal[], unsigned blocksize, const double lp_coeff[][FLAC__MAX_LPC_ORDER], const double lpc_error[], unsigned max_lpc_order)
+{
+    const SearchEffort *effort = &search_efforts_[encoder->search_effort];
+    const unsigned default_precision = encoder->resolved_qlp_coeff_precision;
+    unsigned guess, best_order, bits, best_bits, misses;
+    int order, precision, direction;
+
+    guess = FLAC__lpc_compute_best_order(lpc_error, max_lpc_order, blocksize, workspace->subframe_bps + default_precision);
+    if (FLAC__lpc_compute_expected_bits_per_residual_sample(lpc_error[guess - 1], blocksize - guess) >= (double)workspace->subframe_bps)
+        return; /* not even the best order looks worth it */
+
+    best_order = guess;
+    best_bits = try_lpc_subframe_<Limits>(encoder, task, workspace, signal, lp_coeff[guess - 1], blocksize, guess, default_precision);
+    for (direction = -1; direction <= 1 && effort->order_patience > 0; direction += 2) {
+        misses = 0;
+        for (order = (int)guess + direction; order >= 1 && order <= (int)max_lpc_order && misses < effort->order_patience; order += direction) {
+            bits = try_lpc_subframe_<Limits>(encoder, task, workspace, signal, lp_coeff[order - 1], blocksize, (unsigned)order, default_precision);
+            if (bits < best_bits) {
+                best_bits = bits;
+                best_order = (unsigned)order;
+                misses = 0;
+            }
+            else
+                misses++;
+        }
+    }
+
+    if (encoder->do_qlp_coeff_prec_search) {
+        for (precision = (int)FLAC__MIN_QLP_COEFF_PRECISION; precision <= (int)FLAC__MAX_QLP_COEFF_PRECISION; precision++) {
+            if ((unsigned)precision != default_precision)
+                (void)try_lpc_subframe_<Limits>(encoder, task, workspace, signal, lp_coeff[best_order - 1], blocksize, best_order, (unsigned)precision);
+        }
+        return;
+    }
+    for (direction = -1; direction <= 1 && effort->precision_patience > 0; direction += 2) {
+        misses = 0;
+        for (precision = (int)default_precision + direction; precision >= (int)FLAC__MIN_QLP_COEFF_PRECISION && precision <= (int)FLAC__MAX_QLP_COEFF_PRECISION && misses < effort->precision_patience; precision += direction) {
+            bits = try_lpc_subframe_<Limits>(encoder, task, workspace, signal, lp_coeff[best_order - 1], blocksize, best_order, (unsigned)precision);
+            if (bits < best_bits) {
+                best_bits = bits;
+                misses = 0;
+            }
+            else
+                misses++;
+        }
+    }
+}
+
+/*
+ * Evaluates one LPC candidate into the spare subframe and keeps it if
+ * it beats the best so far. Returns its size, UINT32_MAX if unusable.
+ */
+template <class Limits>
+unsigned try_lpc_subframe_(const FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task, FLAC__StreamEncoderSubframeWorkspace *workspace, const FLAC__int32 signal[], const double lp_coeff[], unsigned blocksize, unsigned order, unsigned qlp_coeff_precision)
+{
+    const unsigned spare = !workspace->best;
+    const unsigned bits = evaluate_lpc_subframe_<Limits>(encoder, task, signal, workspace->residual[spare], &workspace->partitioned_rice_contents[spare], lp_coeff, blocksize, workspace->subframe_bps, order, qlp_coeff_precision, &workspace->subframe[spare]);
+
+    if (bits == 0)
+        return UINT32_MAX;
+    if (bits < workspace->bits) {
+        workspace->best = spare;
+        workspace->bits = bits;
+    }
+    return bits;
+}
+
+unsigned evaluate_verbatim_subframe_(const FLAC__int32 signal[], unsigned blocksize, unsigned subframe_bps, FLAC__Subframe *subframe)
+{
+    subframe->type = FLAC__SUBFRAME_TYPE_VERBATIM;
+    subframe->data.verbatim.data = signal;
+
+    return SUBFRAME_HEADER_BITS_ + blocksize * subframe_bps;
+}
+
+/*
+ * Tries every partition order from the largest down, reusing the sums of
+ * the larger order for the smaller one, and leaves the best parameters
+ * in best_ecm's contents. Returns the estimated size of the residual.
+ */
+template <class Limits>
+unsigned find_best_partition_order_(const FLAC__StreamEncoder *encoder, FLAC__StreamEncoderTask *task, const FLAC__int32 residual[], unsigned residual_samples, unsigned predictor_order, FLAC__EntropyCodingMethod *best_ecm)
+{
+    const unsigned blocksize = residual_samples + predictor_order;
+    unsigned residual_bits, best_residual_bits = 0;
+    unsigned best_parameters_index = 0;
+    unsigned best_partition_order = 0;
+    unsigned min_partition_order, max_partition_order, sum, partition;
+    int partition_order;
+
+    max_partition_order = FLAC__format_get_max_rice_partition_order_from_blocksize_limited_max_and_predictor_order(flac_min(encoder->max_residual_partition_order, (unsigned)Limits::max_partition_order), blocksize, predictor_order);
+    min_partition_order = flac_min(encoder->min_residual_partition_order, max_partition_order);
+
+    precompute_partition_info_sums_(residual, task->abs_residual_partition_sums, residual_samples, predictor_order, min_partition_order, max_partition_order);
+
+    for (partition_order = (int)max_partition_order, sum = 0; partition_order >= (int)min_partition_order; partition_order--) {
+        if (!set_partitioned_rice_(task->abs_residual_partition_sums + sum, residual_samples, predictor_order, encoder->rice_parameter_limit, (unsigned)partition_order, &task->partitioned_rice_contents_extra[!best_parameters_index], &residual_bits)) {
+            FLAC_ASSERT(best_residual_bits != 0);
+            break;
+        }
+        sum += 1u << partition_order;
+        if (best_residual_bits == 0 || residual_bits < best_residual_bits) {
+            best_residual_bits = residual_bits;
+            best_parameters_index = !best_parameters_index;
+            best_partition_order = (unsigned)partition_order;
+        }
+    }
+
+    best_ecm->data.partitioned_rice.order = best_partition_order;
+
+    {
+        /*
+         * We are allowed to de-const the pointer based on our special
+         * knowledge; it is const to the outside world.
+         */
+        FLAC__EntropyCodingMethod_PartitionedRiceContents *prc = (FLAC__EntropyCodingMethod_PartitionedRiceContents*)best_ecm->data.partitioned_rice.content;
+        const unsigned partitions = 1u << best_partition_order;
+
+        /* save best parameters and raw_bits */
+        memcpy(prc->parameters, task->partitioned_rice_contents_extra[best_parameters_index].parameters, sizeof(unsigned) * partitions);
+        memset(prc->raw_bits, 0, sizeof(unsigned) * partitions);
+
+        /* parameters of 15 and up need the 5-bit fields of RICE2 */
+        for (partition = 0; partition < partitions; partition++) {
+            if (prc->parameters[partition] >= FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_ESCAPE_PARAMETER) {
+                best_ecm->type = FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2;
+                best_residual_bits += partitions;
+                break;
+            }
+        }
+    }
+
+    return best_residual_bits;
+}
+
+void precompute_partition_info_sums_(const FLAC__int32 residual[], FLAC__uint64 abs_residual_partition_sums[], unsigned residual_samples, unsigned predictor_order, unsigned min_partition_order, unsigned max_partition_order)
+{
+    const unsigned default_partition_samples = (residual_samples + predictor_order) >> max_partition_order;
+    unsigned partitions = 1u << max_partition_order;
+
+    FLAC_ASSERT(default_partition_samples > predictor_order);
+
+    /* first do max_partition_order */
+    {
+        unsigned partition, residual_sample, end = (unsigned)(-(int)predictor_order);
+        FLAC__uint64 abs_residual_partition_sum;
+
+        for (partition = residual_sample = 0; partition < partitions; partition++) {
+            end += default_partition_samples;
+            abs_residual_partition_sum = 0;
+            for ( ; residual_sample < end; residual_sample++)
+                abs_residual_partition_sum += (FLAC__uint64)(residual[residual_sample] < 0 ? -(FLAC__int64)residual[residual_sample] : residual[residual_sample]);
+            abs_residual_partition_sums[partition] = abs_residual_partition_sum;
+        }
+    }
+
+    /* now merge partitions for lower orders */
+    {
+        unsigned from_partition = 0, to_partition = partitions;
+        int partition_order;
+        for (partition_order = (int)max_partition_order - 1; partition_order >= (int)min_partition_order; partition_order--) {
+            unsigned i;
+            partitions >>= 1;
+            for (i = 0; i < partitions; i++) {
+                abs_residual_partition_sums[to_partition++] =
+                    abs_residual_partition_sums[from_partition] +
+                    abs_residual_partition_sums[from_partition + 1];
+                from_partition += 2;
+            }
+        }
+    }
+}
+
+static inline FLAC__uint64 count_rice_bits_in_partition_(const unsigned rice_parameter, const unsigned partition_samples, const FLAC__uint64 abs_residual_partition_sum)
+{
+    return
+        FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_PARAMETER_LEN +
+        (1 + rice_parameter) * (FLAC__uint64)partition_samples + /* 1 for unary stop bit + rice_parameter for the binary portion */
+        (
+            rice_parameter ?
+                (abs_residual_partition_sum >> (rice_parameter - 1)) /* rice_parameter-1 because the real coder sign-folds instead of using a sign bit */
+                : (abs_residual_partition_sum << 1) /* can't shift by negative number, so reverse */
+        )
+        - (partition_samples >> 1);
+        /* -(partition_samples>>1) to subtract out extra contributions to the abs_residual_partition_sum.
+         * The actual number of bits used is closer to the sum(for all i in the partition) of  abs(residual[i])>>(rice_parameter-1)
+         * By using the abs_residual_partition sum, we also add in bits in the LSBs that would normally be shifted out.
+         * So the subtraction term tries to guess how many extra bits were contributed.
+         * If the LSBs are randomly distributed, this should average to 0.5 extra bits per sample.
+         */
+}
+
+FLAC__bool set_partitioned_rice_(const FLAC__uint64 abs_residual_partition_sums[], unsigned residual_samples, unsigned predictor_order, unsigned rice_parameter_limit, unsigned partition_order, FLAC__EntropyCodingMethod_PartitionedRiceContents *partitioned_rice_contents, unsigned *bits)
+{
+    unsigned rice_parameter, partition_bits;
+    unsigned best_partition_bits;
+    FLAC__uint64 bits_ = FLAC__ENTROPY_CODING_METHOD_TYPE_LEN + FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_ORDER_LEN;
+    unsigned *parameters;
+    const unsigned partitions = 1u << partition_order;
+    unsigned partition, partition_samples;
+    const unsigned default_partition_samples = (residual_samples + predictor_order) >> partition_order;
+    FLAC__uint64 mean, k;
+
+    FLAC_ASSERT(rice_parameter_limit <= FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2_ESCAPE_PARAMETER);
+    FLAC_ASSERT(partitioned_rice_contents->capacity_by_order >= partition_order);
+
+    parameters = partitioned_rice_contents->parameters;
+
+    for (partition = 0; partition < partitions; partition++) {
+        partition_samples = default_partition_samples;
+        if (partition == 0) {
+            if (partition_samples <= predictor_order)
+                return false;
+            partition_samples -= predictor_order;
+        }
+        mean = abs_residual_partition_sums[partition];
+        /* we are basically calculating the size in bits of the
+         * average residual magnitude in the partition:
+         *   rice_parameter = floor(log2(mean/partition_samples))
+         * 'mean' is not a good name for the variable, it is
+         * actually the sum of magnitudes of all residual values
+         * in the partition, so the actual mean is
+         * mean/partition_samples
+         */
+        for (rice_parameter = 0, k = partition_samples; k < mean; rice_parameter++, k <<= 1)
+            ;
+        if (rice_parameter >= rice_parameter_limit)
+            rice_parameter = rice_parameter_limit - 1;
+
+        best_partition_bits = (unsigned)flac_min(count_rice_bits_in_partition_(rice_parameter, partition_samples, mean), (FLAC__uint64)UINT32_MAX);
+        partition_bits = best_partition_bits;
+        parameters[partition] = rice_parameter;
+        bits_ += partition_bits;
+    }
+
+    *bits = (unsigned)flac_min(bits_, (FLAC__uint64)UINT32_MAX);
+    return true;
+}
+
+unsigned get_wasted_bits_(const FLAC__int32 signal[], unsigned samples)
+{
+    unsigned i, shift;
+    FLAC__int32 x = 0;
+
+    for (i = 0; i < samples && !(x & 1); i++)
+        x |= signal[i];
+
+    if (x == 0) {
+        shift = 0;
+    }
+    else {
+        for (shift = 0; !(x & 1); shift++)
+            x >>= 1;
+    }
+
+    return shift;
+}
@@ -0,0 +1,398 @@
+#include <string.h>
+#include "private/stream_encoder_framing.h"
+#include "private/crc.h"
+#include "FLAC/assert.h"
+
+static FLAC__bool add_uint32_little_endian_(FLAC__BitWriter *bw, FLAC__uint32 val);
+static FLAC__bool add_entropy_coding_method_(FLAC__BitWriter *bw, const FLAC__EntropyCodingMethod *method);
+static FLAC__bool add_residual_partitioned_rice_(FLAC__BitWriter *bw, const FLAC__int32 residual[], const unsigned residual_samples, const unsigned predictor_order, const unsigned rice_parameters[], const unsigned raw_bits[], const unsigned partition_order, const FLAC__bool is_extended);
+
+FLAC__bool FLAC__add_metadata_block_streaminfo(const FLAC__StreamMetadata_StreamInfo *stream_info, FLAC__bool is_last, FLAC__BitWriter *bw)
+{
+    if (!FLAC__bitwriter_write_raw_uint32(bw, is_last, FLAC__STREAM_METADATA_IS_LAST_LEN))
+        return false;
+    if (!FLAC__bitwriter_write_raw_uint32(bw, FLAC__METADATA_TYPE_STREAMINFO, FLAC__STREAM_METADATA_TYPE_LEN))
+        return false;
+    if (!FLAC__bitwriter_write_raw_uint32(bw, FLAC__STREAM_METADATA_STREAMINFO_LENGTH, FLAC__STREAM_METADATA_LENGTH_LEN))
+        return false;
+
+    return FLAC__add_streaminfo_body(stream_info, bw);
+}
+
+FLAC__bool FLAC__add_metadata_block_vorbis_comment(const char *vendor_string, FLAC__bool is_last, FLAC__BitWriter *bw)
+{
+    const FLAC__uint32 vendor_length = (FLAC__uint32)strlen(vendor_string);
+
+    if (!FLAC__bitwriter_write_raw_uint32(bw, is_last, FLAC__STREAM_METADATA_IS_LAST_LEN))
+        return false;
+    if (!FLAC__bitwriter_write_raw_uint32(bw, FLAC__METADATA_TYPE_VORBIS_COMMENT, FLAC__STREAM_METADATA_TYPE_LEN))
+        return false;
+    /* the vendor string and the number of comments, each with a 32-bit length or count */
+    if (!FLAC__bitwriter_write_raw_uint32(bw, 4 + vendor_length + 4, FLAC__STREAM_METADATA_LENGTH_LEN))
+        return false;
+
+    if (!add_uint32_little_endian_(bw, vendor_length))
+        return false;
+    if (!FLAC__bitwriter_write_byte_block(bw, (const FLAC__byte*)vendor_string, vendor_length))
+        return false;
+    if (!add_uint32_little_endian_(bw, 0))
+        return false;
+
+    return true;
+}
+
+FLAC__bool FLAC__add_streaminfo_body(const FLAC__StreamMetadata_StreamInfo *stream_info, FLAC__BitWriter *bw)
+{
+    FLAC_ASSERT(stream_info->min_blocksize < (1u << FLAC__STREAM_METADATA_STREAMINFO_MIN_BLOCK_SIZE_LEN));
+    FLAC_ASSERT(stream_info->max_blocksize < (1u << FLAC__STREAM_METADATA_STREAMINFO_MAX_BLOCK_SIZE_LEN));
+    FLAC_ASSERT(stream_info->channels > 0 && stream_info->channels <= FLAC__MAX_CHANNELS);
+    FLAC_ASSERT(stream_info->bits_per_sample > 0 && stream_info->bits_per_sample <= FLAC__MAX_BITS_PER_SAMPLE);
+
+    if (!FLAC__bitwriter_write_raw_uint32(bw, stream_info->min_blocksize, FLAC__STREAM_METADATA_STREAMINFO_MIN_BLOCK_SIZE_LEN))
+        return false;
+    if (!FLAC__bitwriter_write_raw_uint32(bw, stream_info->max_blocksize, FLAC__STREAM_METADATA_STREAMINFO_MAX_BLOCK_SIZE_LEN))
+        return false;
+    /* frame sizes that do not fit are written as 0, i.e. unknown */
+    if (!FLAC__bitwriter_write_raw_uint32(bw, stream_info->min_framesize < (1u << FLAC__STREAM_METADATA_STREAMINFO_MIN_FRAME_SIZE_LEN) ? stream_info->min_framesize : 0, FLAC__STREAM_METADATA_STREAMINFO_MIN_FRAME_SIZE_LEN))
+        return false;
+    if (!FLAC__bitwriter_write_raw_uint32(bw, stream_info->max_framesize < (1u << FLAC__STREAM_METADATA_STREAMINFO_MAX_FRAME_SIZE_LEN) ? stream_info->max_framesize : 0, FLAC__STREAM_METADATA_STREAMINFO_MAX_FRAME_SIZE_LEN))
+        return false;
+    if (!FLAC__bitwriter_write_raw_uint32(bw, stream_info->sample_rate, FLAC__STREAM_METADATA_STREAMINFO_SAMPLE_RATE_LEN))
+        return false;
+    if (!FLAC__bitwriter_write_raw_uint32(bw, stream_info->channels - 1, FLAC__STREAM_METADATA_STREAMINFO_CHANNELS_LEN))
+        return false;
+    if (!FLAC__bitwriter_write_raw_uint32(bw, stream_info->bits_per_sample - 1, FLAC__STREAM_METADATA_STREAMINFO_BITS_PER_SAMPLE_LEN))
+        return false;
+    /* a total that does not fit in 36 bits is written as 0, i.e. unknown */
+    if (!FLAC__bitwriter_write_raw_uint64(bw, stream_info->total_samples < (FLAC__uint64)1 << FLAC__STREAM_METADATA_STREAMINFO_TOTAL_SAMPLES_LEN ? stream_info->total_samples : 0, FLAC__STREAM_METADATA_STREAMINFO_TOTAL_SAMPLES_LEN))
+        return false;
+    if (!FLAC__bitwriter_write_byte_block(bw, stream_info->md5sum, 16))
+        return false;
+
+    return true;
+}
+
+FLAC__bool FLAC__frame_add_header(const FLAC__FrameHeader *header, FLAC__BitWriter *bw)
+{
+    unsigned u, blocksize_hint, sample_rate_hint;
+    FLAC__byte crc;
+
+    FLAC_ASSERT(FLAC__bitwriter_is_byte_aligned(bw));
+
+    if (!FLAC__bitwriter_write_raw_uint32(bw, FLAC__FRAME_HEADER_SYNC, FLAC__FRAME_HEADER_SYNC_LEN))
+        return false;
+
+    if (!FLAC__bitwriter_write_raw_uint32(bw, 0, FLAC__FRAME_HEADER_RESERVED_LEN))
+        return false;
+
+    if (!FLAC__bitwriter_write_raw_uint32(bw, (header->number_type == FLAC__FRAME_NUMBER_TYPE_FRAME_NUMBER) ? 0 : 1, FLAC__FRAME_HEADER_BLOCKING_STRATEGY_LEN))
+        return false;
+
+    FLAC_ASSERT(header->blocksize > 0 && header->blocksize <= FLAC__MAX_BLOCK_SIZE);
+    /* when this assertion holds true, any legal blocksize can be expressed in the frame header */
+    FLAC_ASSERT(FLAC__MAX_BLOCK_SIZE <= 65535u);
+    blocksize_hint = 0;
+    switch (header->blocksize) {
+        case   192: u = 1; break;
+        case   576: u = 2; break;
+        case  1152: u = 3; break;
+        case  2304: u = 4; break;
+        case  4608: u = 5; break;
+        case   256: u = 8; break;
+        case   512: u = 9; break;
+        case  1024: u = 10; break;
+        case  2048: u = 11; break;
+        case  4096: u = 12; break;
+        case  8192: u = 13; break;
+        case 16384: u = 14; break;
+        case 32768: u = 15; break;
+        default:
+            if (header->blocksize <= 0x100)
+                blocksize_hint = u = 6;
+            else
+                blocksize_hint = u = 7;
+            break;
+    }
+    if (!FLAC__bitwriter_write_raw_uint32(bw, u, FLAC__FRAME_HEADER_BLOCK_SIZE_LEN))
+        return false;
+
+    FLAC_ASSERT(FLAC__format_sample_rate_is_valid(header->sample_rate));
+    sample_rate_hint = 0;
+    switch (header->sample_rate) {
+        case  88200: u = 1; break;
+        case 176400: u = 2; break;
+        case 192000: u = 3; break;
+        case   8000: u = 4; break;
+        case  16000: u = 5; break;
+        case  22050: u = 6; break;
+        case  24000: u = 7; break;
+        case  32000: u = 8; break;
+        case  44100: u = 9; break;
+        case  48000: u = 10; break;
+        case  96000: u = 11; break;
+        default:
+            if (header->sample_rate <= 255000 && header->sample_rate % 1000 == 0)
+                sample_rate_hint = u = 12;
+            else if (header->sample_rate <= 0xffff)
+                sample_rate_hint = u = 13;
+            else if (header->sample_rate % 10 == 0 && header->sample_rate / 10 <= 0xffff)
+                sample_rate_hint = u = 14;
+            else
+                u = 0; /* get it from STREAMINFO */
+            break;
+    }
+    if (!FLAC__bitwriter_write_raw_uint32(bw, u, FLAC__FRAME_HEADER_SAMPLE_RATE_LEN))
+        return false;
+
+    FLAC_ASSERT(header->channels > 0 && header->channels <= (1u << FLAC__STREAM_METADATA_STREAMINFO_CHANNELS_LEN) && header->channels <= FLAC__MAX_CHANNELS);
+    switch (header->channel_assignment) {
+        case FLAC__CHANNEL_ASSIGNMENT_INDEPENDENT:
+            u = header->channels - 1;
+            break;
+        case FLAC__CHANNEL_ASSIGNMENT_LEFT_SIDE:
+            FLAC_ASSERT(header->channels == 2);
+            u = 8;
+            break;
+        case FLAC__CHANNEL_ASSIGNMENT_RIGHT_SIDE:
+            FLAC_ASSERT(header->channels == 2);
+            u = 9;
+            break;
+        case FLAC__CHANNEL_ASSIGNMENT_MID_SIDE:
+            FLAC_ASSERT(header->channels == 2);
+            u = 10;
+            break;
+        default:
+            FLAC_ASSERT(0);
+            return false;
+    }
+    if (!FLAC__bitwriter_write_raw_uint32(bw, u, FLAC__FRAME_HEADER_CHANNEL_ASSIGNMENT_LEN))
+        return false;
+
+    FLAC_ASSERT(header->bits_per_sample > 0 && header->bits_per_sample <= (1u << FLAC__STREAM_METADATA_STREAMINFO_BITS_PER_SAMPLE_LEN));
+    switch (header->bits_per_sample) {
+        case 8 : u = 1; break;
+        case 12: u = 2; break;
+        case 16: u = 4; break;
+        case 20: u = 5; break;
+        case 24: u = 6; break;
+        case 32: u = 7; break;
+        default: u = 0; break;
+    }
+    if (!FLAC__bitwriter_write_raw_uint32(bw, u, FLAC__FRAME_HEADER_BITS_PER_SAMPLE_LEN))
+        return false;
+
+    if (!FLAC__bitwriter_write_raw_uint32(bw, 0, FLAC__FRAME_HEADER_ZERO_PAD_LEN))
+        return false;
+
+    if (header->number_type == FLAC__FRAME_NUMBER_TYPE_FRAME_NUMBER) {
+        if (!FLAC__bitwriter_write_utf8_uint32(bw, header->number.frame_number))
+            return false;
+    }
+    else {
+        if (!FLAC__bitwriter_write_utf8_uint64(bw, header->number.sample_number))
+            return false;
+    }
+
+    if (blocksize_hint)
+        if (!FLAC__bitwriter_write_raw_uint32(bw, header->blocksize - 1, (blocksize_hint == 6) ? 8 : 16))
+            return false;
+
+    switch (sample_rate_hint) {
+        case 12:
+            if (!FLAC__bitwriter_write_raw_uint32(bw, header->sample_rate / 1000, 8))
+                return false;
+            break;
+        case 13:
+            if (!FLAC__bitwriter_write_raw_uint32(bw, header->sample_rate, 16))
+                return false;
+            break;
+        case 14:
+            if (!FLAC__bitwriter_write_raw_uint32(bw, header->sample_rate / 10, 16))
+                return false;
+            break;
+    }
+
+    /* write the CRC; the header is the first thing in the frame's bitwriter */
+    if (!FLAC__bitwriter_get_write_crc8(bw, &crc))
+        return false;
+    if (!FLAC__bitwriter_write_raw_uint32(bw, crc, FLAC__FRAME_HEADER_CRC_LEN))
+        return false;
+
+    return true;
+}
+
+FLAC__bool FLAC__subframe_add_constant(const FLAC__Subframe_Constant *subframe, unsigned subframe_bps, unsigned wasted_bits, FLAC__BitWriter *bw)
+{
+    FLAC__bool ok;
+
+    ok =
+        FLAC__bitwriter_write_raw_uint32(bw, FLAC__SUBFRAME_TYPE_CONSTANT_BYTE_ALIGNED_MASK | (wasted_bits ? 1 : 0), FLAC__SUBFRAME_ZERO_PAD_LEN + FLAC__SUBFRAME_TYPE_LEN + FLAC__SUBFRAME_WASTED_BITS_FLAG_LEN) &&
+        (wasted_bits ? FLAC__bitwriter_write_unary_unsigned(bw, wasted_bits - 1) : true) &&
+        FLAC__bitwriter_write_raw_int64(bw, subframe->value, subframe_bps);
+
+    return ok;
+}
+
+FLAC__bool FLAC__subframe_add_fixed(const FLAC__Subframe_Fixed *subframe, unsigned residual_samples, unsigned subframe_bps, unsigned wasted_bits, FLAC__BitWriter *bw)
+{
+    unsigned i;
+
+    if (!FLAC__bitwriter_write_raw_uint32(bw, FLAC__SUBFRAME_TYPE_FIXED_BYTE_ALIGNED_MASK | (subframe->order << 1) | (wasted_bits ? 1 : 0), FLAC__SUBFRAME_ZERO_PAD_LEN + FLAC__SUBFRAME_TYPE_LEN + FLAC__SUBFRAME_WASTED_BITS_FLAG_LEN))
+        return false;
+    if (wasted_bits)
+        if (!FLAC__bitwriter_write_unary_unsigned(bw, wasted_bits - 1))
+            return false;
+
+    for (i = 0; i < subframe->order; i++)
+        if (!FLAC__bitwriter_write_raw_int64(bw, subframe->warmup[i], subframe_bps))
+            return false;
+
+    if (!add_entropy_coding_method_(bw, &subframe->entropy_coding_method))
+        return false;
+    switch (subframe->entropy_coding_method.type) {
+        case FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE:
+        case FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2:
+            if (!add_residual_partitioned_rice_(
+                bw,
+                subframe->residual,
+                residual_samples,
+                subframe->order,
+                subframe->entropy_coding_method.data.partitioned_rice.content->parameters,
+                subframe->entropy_coding_method.data.partitioned_rice.content->raw_bits,
+                subframe->entropy_coding_method.data.partitioned_rice.order,
+                /*is_extended=*/subframe->entropy_coding_method.type == FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2
+            ))
+                return false;
+            break;
+        default:
+            FLAC_ASSERT(0);
+    }
+
+    return true;
+}
+
+FLAC__bool FLAC__subframe_add_lpc(const FLAC__Subframe_LPC *subframe, unsigned residual_samples, unsigned subframe_bps, unsigned wasted_bits, FLAC__BitWriter *bw)
+{
+    unsigned i;
+
+    if (!FLAC__bitwriter_write_raw_uint32(bw, FLAC__SUBFRAME_TYPE_LPC_BYTE_ALIGNED_MASK | ((subframe->order - 1) << 1) | (wasted_bits ? 1 : 0), FLAC__SUBFRAME_ZERO_PAD_LEN + FLAC__SUBFRAME_TYPE_LEN + FLAC__SUBFRAME_WASTED_BITS_FLAG_LEN))
+        return false;
+    if (wasted_bits)
+        if (!FLAC__bitwriter_write_unary_unsigned(bw, wasted_bits - 1))
+            return false;
+
+    for (i = 0; i < subframe->order; i++)
+        if (!FLAC__bitwriter_write_raw_int64(bw, subframe->warmup[i], subframe_bps))
+            return false;
+
+    if (!FLAC__bitwriter_write_raw_uint32(bw, subframe->qlp_coeff_precision - 1, FLAC__SUBFRAME_LPC_QLP_COEFF_PRECISION_LEN))
+        return false;
+    if (!FLAC__bitwriter_write_raw_int32(bw, subframe->quantization_level, FLAC__SUBFRAME_LPC_QLP_SHIFT_LEN))
+        return false;
+    for (i = 0; i < subframe->order; i++)
+        if (!FLAC__bitwriter_write_raw_int32(bw, subframe->qlp_coeff[i], subframe->qlp_coeff_precision))
+            return false;
+
+    if (!add_entropy_coding_method_(bw, &subframe->entropy_coding_method))
+        return false;
+    switch (subframe->entropy_coding_method.type) {
+        case FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE:
+        case FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2:
+            if (!add_residual_partitioned_rice_(
+                bw,
+                subframe->residual,
+                residual_samples,
+                subframe->order,
+                subframe->entropy_coding_method.data.partitioned_rice.content->parameters,
+                subframe->entropy_coding_method.data.partitioned_rice.content->raw_bits,
+                subframe->entropy_coding_method.data.partitioned_rice.order,
+                /*is_extended=*/subframe->entropy_coding_method.type == FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2
+            ))
+                return false;
+            break;
+        default:
+            FLAC_ASSERT(0);
+    }
+
+    return true;
+}
+
+FLAC__bool FLAC__subframe_add_verbatim(const FLAC__Subframe_Verbatim *subframe, unsigned samples, unsigned subframe_bps, unsigned wasted_bits, FLAC__BitWriter *bw)
+{
+    unsigned i;
+    const FLAC__int32 *signal = subframe->data;
+
+    if (!FLAC__bitwriter_write_raw_uint32(bw, FLAC__SUBFRAME_TYPE_VERBATIM_BYTE_ALIGNED_MASK | (wasted_bits ? 1 : 0), FLAC__SUBFRAME_ZERO_PAD_LEN + FLAC__SUBFRAME_TYPE_LEN + FLAC__SUBFRAME_WASTED_BITS_FLAG_LEN))
+        return false;
+    if (wasted_bits)
+        if (!FLAC__bitwriter_write_unary_unsigned(bw, wasted_bits - 1))
+            return false;
+
+    for (i = 0; i < samples; i++)
+        if (!FLAC__bitwriter_write_raw_int32(bw, signal[i], subframe_bps))
+            return false;
+
+    return true;
+}
+
+FLAC__bool add_entropy_coding_method_(FLAC__BitWriter *bw, const FLAC__EntropyCodingMethod *method)
+{
+    if (!FLAC__bitwriter_write_raw_uint32(bw, method->type, FLAC__ENTROPY_CODING_METHOD_TYPE_LEN))
+        return false;
+    switch (method->type) {
+        case FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE:
+        case FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2:
+            if (!FLAC__bitwriter_write_raw_uint32(bw, method->data.partitioned_rice.order, FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_ORDER_LEN))
+                return false;
+            break;
+        default:
+            FLAC_ASSERT(0);
+    }
+    return true;
+}
+
+FLAC__bool add_residual_partitioned_rice_(FLAC__BitWriter *bw, const FLAC__int32 residual[], const unsigned residual_samples, const unsigned predictor_order, const unsigned rice_parameters[], const unsigned raw_bits[], const unsigned partition_order, const FLAC__bool is_extended)
+{
+    const unsigned plen = is_extended ? FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2_PARAMETER_LEN : FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_PARAMETER_LEN;
+    const unsigned pesc = is_extended ? FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE2_ESCAPE_PARAMETER : FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_ESCAPE_PARAMETER;
+    unsigned i, j, k = 0, k_last = 0;
+    unsigned partition_samples;
+    const unsigned default_partition_samples = (residual_samples + predictor_order) >> partition_order;
+
+    for (i = 0; i < (1u << partition_order); i++) {
+        partition_samples = default_partition_samples;
+        /* the first partition loses the warmup samples */
+        if (i == 0)
+            partition_samples -= predictor_order;
+        k += partition_samples;
+        if (raw_bits[i] == 0) {
+            if (!FLAC__bitwriter_write_raw_uint32(bw, rice_parameters[i], plen))
+                return false;
+            if (!FLAC__bitwriter_write_rice_signed_block(bw, residual + k_last, k - k_last, rice_parameters[i]))
+                return false;
+        }
+        else {
+            if (!FLAC__bitwriter_write_raw_uint32(bw, pesc, plen))
+                return false;
+            if (!FLAC__bitwriter_write_raw_uint32(bw, raw_bits[i], FLAC__ENTROPY_CODING_METHOD_PARTITIONED_RICE_RAW_LEN))
+                return false;
+            for (j = k_last; j < k; j++)
+                if (!FLAC__bitwriter_write_raw_int32(bw, residual[j], raw_bits[i]))
+                    return false;
+        }
+        k_last = k;
+    }
+    return true;
+}
+
+/* the lengths and counts in VORBIS_COMMENT are little-endian, unlike the rest of FLAC */
+FLAC__bool add_uint32_little_endian_(FLAC__BitWriter *bw, FLAC__uint32 val)
+{
+    unsigned i;
+
+    for (i = 0; i < 4; i++, val >>= 8) {
+        if (!FLAC__bitwriter_write_raw_uint32(bw, val & 0xff, 8))
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "FLAC/parallel_decoder.h"
+
+// 把一个FLAC文件多线程解码成裸PCM：交错、小端、有符号
+//
+//   flac-decode [-j threads] [-b bits] file.flac [out.raw]
+//   flac-decode -j 0 long.flac - | sox -t raw -r 96000 -e signed -b 24 -c 2 - out.wav
+//
+// 不给输出文件或者给"-"就写到stdout；格式（采样率、声道数、位深）打印到stderr
+// 退出码：0正常，1解码出错或有坏帧，2参数错误
+
+typedef struct {
+    FILE *out;
+    unsigned bits_per_sample;
+    FLAC__bool format_printed;
+} Output;
+
+static void usage_(void)
+{
+    fprintf(stderr,
+        "usage: flac-decode [-j threads] [-b bits] file.flac [out.raw]\n"
+        "  -j threads  decode on this many threads, 0 for one per CPU (default 0)\n"
+        "  -b bits     write samples of this many bits (default: the stream's)\n"
+        "  out.raw     where to write the PCM, - or nothing for stdout\n");
+}
+
+static FLAC__bool write_(const FLAC__StreamMetadata_StreamInfo *stream_info, const FLAC__byte pcm[], size_t samples, void *client_data)
+{
+    Output *output = (Output*)client_data;
+    const unsigned bits_per_sample = output->bits_per_sample != 0 ? output->bits_per_sample : stream_info->bits_per_sample;
+    const size_t bytes = samples * stream_info->channels * ((bits_per_sample + 7) / 8);
+
+    if (!output->format_printed) {
+        fprintf(stderr, "flac-decode: %u Hz, %u channels, %u bits\n", stream_info->sample_rate, stream_info->channels, bits_per_sample);
+        output->format_printed = true;
+    }
+    return fwrite(pcm, 1, bytes, output->out) == bytes;
+}
+
+int main(int argc, char **argv)
+{
+    FLAC__ParallelDecoder *decoder;
+    FLAC__ParallelDecodeResult result;
+    Output output = { 0, 0, false };
+    const char *input = 0, *output_name = 0;
+    unsigned num_threads = 0;
+    int arg;
+
+    for (arg = 1; arg < argc; arg++) {
+        if (strcmp(argv[arg], "-j") == 0 && arg + 1 < argc)
+            num_threads = (unsigned)strtoul(argv[++arg], 0, 10);
+        else if (strcmp(argv[arg], "-b") == 0 && arg + 1 < argc)
+            output.bits_per_sample = (unsigned)strtoul(argv[++arg], 0, 10);
+        else if (argv[arg][0] == '-' && argv[arg][1] != '\0') {
+            usage_();
+            return 2;
+        }
+        else if (input == 0)
+            input = argv[arg];
+        else if (output_name == 0)
+            output_name = argv[arg];
+        else {
+            usage_();
+            return 2;
+        }
+    }
+    if (input == 0) {
+        usage_();
+        return 2;
+    }
+
+    decoder = FLAC__parallel_decoder_new();
+    if (decoder == 0) {
+        fprintf(stderr, "flac-decode: out of memory\n");
+        return 1;
+    }
+    if (!FLAC__parallel_decoder_set_num_threads(decoder, num_threads)) {
+        fprintf(stderr, "flac-decode: at most %u threads\n", FLAC__PARALLEL_DECODER_MAX_THREADS);
+        FLAC__parallel_decoder_delete(decoder);
+        return 2;
+    }
+    if (!FLAC__parallel_decoder_set_bits_per_sample(decoder, output.bits_per_sample)) {
+        fprintf(stderr, "flac-decode: bits must be %u to %u\n", FLAC__MIN_BITS_PER_SAMPLE, FLAC__MAX_BITS_PER_SAMPLE);
+        FLAC__parallel_decoder_delete(decoder);
+        return 2;
+    }
+
+    if (output_name == 0 || strcmp(output_name, "-") == 0)
+        output.out = stdout;
+    else if ((output.out = fopen(output_name, "wb")) == 0) {
+        fprintf(stderr, "flac-decode: cannot open %s\n", output_name);
+        FLAC__parallel_decoder_delete(decoder);
+        return 1;
+    }
+
+    (void)FLAC__parallel_decoder_decode_file(decoder, input, write_, &output, &result);
+    FLAC__parallel_decoder_delete(decoder);
+
+    if (fflush(output.out) != 0 && result.status == FLAC__PARALLEL_DECODE_OK)
+        result.status = FLAC__PARALLEL_DECODE_ABORTED;
+    if (output.out != stdout)
+        fclose(output.out);
+
+    if (result.status == FLAC__PARALLEL_DECODE_FRAME_ERROR)
+        fprintf(stderr, "flac-decode: %s: %llu bad frames dropped, %llu samples written\n", input, (unsigned long long)result.bad_frames, (unsigned long long)result.samples);
+    else if (result.status == FLAC__PARALLEL_DECODE_ABORTED)
+        fprintf(stderr, "flac-decode: write error\n");
+    else if (result.status != FLAC__PARALLEL_DECODE_OK)
+        fprintf(stderr, "flac-decode: %s: %s\n", input, FLAC__ParallelDecodeStatusString[result.status] + strlen("FLAC__PARALLEL_DECODE_"));
+    return result.status == FLAC__PARALLEL_DECODE_OK ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "FLAC/recompress.h"
+
+// 不重新分析，只重新编码残差：保留每个subframe的预测器，重新选分区阶数、Rice参数和escape
+//
+//   flac-recompress [-r order] in.flac out.flac
+//   for f in old/*.flac; do flac-recompress "$f" "new/${f#old/}"; done
+//
+// 解码出来的音频逐位不变；变不小的帧原样拷贝。大小和原样保留的帧数打印到stderr
+// 退出码：0正常，1出错（输出文件会被删掉），2参数错误
+
+static void usage_(void)
+{
+    fprintf(stderr,
+        "usage: flac-recompress [-r order] in.flac out.flac\n"
+        "  -r order  try residual partition orders up to this, 0 to %u (default %u)\n"
+        "  out.flac  where to write the stream, not in.flac\n",
+        FLAC__MAX_RICE_PARTITION_ORDER, FLAC__SUBSET_MAX_RICE_PARTITION_ORDER);
+}
+
+int main(int argc, char **argv)
+{
+    FLAC__Recompressor *recompressor;
+    FLAC__RecompressResult result;
+    const char *input = 0, *output = 0;
+    unsigned max_partition_order = FLAC__SUBSET_MAX_RICE_PARTITION_ORDER;
+    int arg;
+
+    for (arg = 1; arg < argc; arg++) {
+        if (strcmp(argv[arg], "-r") == 0 && arg + 1 < argc)
+            max_partition_order = (unsigned)strtoul(argv[++arg], 0, 10);
+        else if (argv[arg][0] == '-' && argv[arg][1] != '\0') {
+            usage_();
+            return 2;
+        }
+        else if (input == 0)
+            input = argv[arg];
+        else if (output == 0)
+            output = argv[arg];
+        else {
+            usage_();
+            return 2;
+        }
+    }
+    if (input == 0 || output == 0) {
+        usage_();
+        return 2;
+    }
+
+    recompressor = FLAC__recompressor_new();
+    if (recompressor == 0) {
+        fprintf(stderr, "flac-recompress: out of memory\n");
+        return 1;
+    }
+    if (!FLAC__recompressor_set_max_residual_partition_order(recompressor, max_partition_order)) {
+        fprintf(stderr, "flac-recompress: order must be 0 to %u\n", FLAC__MAX_RICE_PARTITION_ORDER);
+        FLAC__recompressor_delete(recompressor);
+        return 2;
+    }
+
+    (void)FLAC__recompressor_recompress_file(recompressor, input, output, &result);
+    FLAC__recompressor_delete(recompressor);
+
+    if (result.status != FLAC__RECOMPRESS_OK) {
+        fprintf(stderr, "flac-recompress: %s: %s\n", input, FLAC__RecompressStatusString[result.status] + strlen("FLAC__RECOMPRESS_"));
+        /* a half-written stream is no use; the output was never the input */
+        if (result.status != FLAC__RECOMPRESS_IO_ERROR || result.bytes_out > 0)
+            remove(output);
+        return 1;
+    }
+    fprintf(stderr, "flac-recompress: %s: %llu -> %llu bytes (%.2f%%), %llu of %llu frames kept\n",
+        input, (unsigned long long)result.bytes_in, (unsigned long long)result.bytes_out,
+        result.bytes_in > 0 ? 100.0 * (double)result.bytes_out / (double)result.bytes_in : 100.0,
+        (unsigned long long)result.frames_kept, (unsigned long long)result.frames);
+    return 0;
+}
@@ -0,0 +1,768 @@
+#include <stdlib.h>
+#include <string.h>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "FLAC/assert.h"
+#include "FLAC/mapped_file.h"
+#include "FLAC/stream_decoder.h"
+#include "FLAC/verify.h"
+#include "private/macros.h"
+#include "private/md5.h"
+
+/***********************************************************************
+ *
+ * Private class data
+ *
+ ***********************************************************************/
+
+/*
+ * A segment is closed once its frames decode to this many bytes of
+ * audio; that bounds the memory of a task however well the frames
+ * compress, and is still plenty of work to hand to a thread.
+ */
+#define FLAC__VERIFIER_SEGMENT_BYTES (1u << 20)
+
+/* segments in flight per worker, so a worker never waits for the reader */
+#define FLAC__VERIFIER_TASKS_PER_THREAD (4u)
+
+typedef enum {
+    FLAC__VERIFIER_TASK_EMPTY = 0,
+    FLAC__VERIFIER_TASK_QUEUED, /* waiting for a worker */
+    FLAC__VERIFIER_TASK_DECODED /* waiting to be hashed */
+} FLAC__VerifierTaskState;
+
+/* a file being checked */
+typedef struct {
+    FLAC__bool in_use;
+    size_t index; /* in the caller's list */
+    const char *filename;
+    FLAC__MappedFile *mapping; /* NULL for a stream in memory */
+    FLAC__StreamMetadata_StreamInfo stream_info;
+    FLAC__VerifyStatus status; /* set by the reader when the file cannot be checked at all */
+
+    /* written by the reader only */
+    FLAC__uint64 frames;
+    FLAC__uint64 crc_errors;
+    FLAC__uint64 bytes;
+    FLAC__bool split_done;
+
+    /* written by the worker holding 'hashing' only */
+    FLAC__MD5Context md5context;
+    FLAC__uint64 samples;
+    FLAC__uint64 decode_errors;
+    FLAC__bool memory_error;
+
+    /* under the pool mutex */
+    unsigned num_pending; /* tasks not yet hashed */
+    unsigned next_seq; /* the sequence number of the next task submitted */
+    unsigned hash_seq; /* the sequence number of the next task to hash */
+    unsigned hash_task; /* where in the ring that task is */
+    FLAC__bool hashing;
+} FLAC__VerifierFile;
+
+/* a segment: a run of whole frames of one file that all passed their CRCs */
+typedef struct {
+    FLAC__VerifierTaskState state;
+    FLAC__VerifierFile *file;
+    unsigned seq;
+    const FLAC__byte *data;
+    size_t bytes;
+    unsigned frames;
+    unsigned max_blocksize;
+
+    /* the decoded audio in the MD5 byte layout */
+    FLAC__byte *audio;
+    size_t audio_bytes, audio_capacity;
+    FLAC__uint64 samples;
+    unsigned decoded_frames;
+    FLAC__bool memory_error;
+} FLAC__VerifierTask;
+
+/* what a thread needs to decode a segment */
+typedef struct {
+    FLAC__StreamDecoder *decoder;
+    FLAC__int32 *signal[FLAC__MAX_CHANNELS];
+    unsigned capacity;
+} FLAC__VerifierWorker;
+
+/*
+ * The worker threads and their queue. Like the encoder's, tasks are
+ * queued in ring order, so the queue is just the index of the oldest
+ * queued task and a count.
+ */
+typedef struct {
+    std::mutex mutex;
+    std::condition_variable work_available; /* workers wait here for queued tasks */
+    std::condition_variable task_done; /* the reader waits here for a free task or file */
+    std::mutex callback_mutex; /* one callback at a time */
+    unsigned next_queued, num_queued;
+    FLAC__bool shutdown;
+    std::vector<std::thread> threads;
+} FLAC__VerifierPool;
+
+struct FLAC__Verifier {
+    /* settings */
+    unsigned num_threads;
+
+    /* per run */
+    unsigned num_workers; /* 1 when everything runs on the calling thread */
+    FLAC__VerifierWorker *workers;
+    unsigned num_tasks;
+    FLAC__VerifierTask *tasks;
+    unsigned fill_task; /* the task the reader fills next */
+    unsigned num_files;
+    FLAC__VerifierFile *files;
+    FLAC__FrameSpanIterator *iterator;
+    FLAC__VerifyResult *results;
+    FLAC__VerifierCallback callback;
+    void *client_data;
+    FLAC__bool all_ok;
+    FLAC__VerifierPool *pool;
+};
+
+/***********************************************************************
+ *
+ * Private class method prototypes
+ *
+ ***********************************************************************/
+
+static FLAC__bool start_run_(FLAC__Verifier *verifier, unsigned num_threads, FLAC__VerifyResult *results, FLAC__VerifierCallback callback, void *client_data);
+static void finish_run_(FLAC__Verifier *verifier);
+static FLAC__bool start_threads_(FLAC__Verifier *verifier);
+static void stop_threads_(FLAC__Verifier *verifier);
+static void worker_thread_(FLAC__Verifier *verifier, FLAC__VerifierWorker *worker);
+static FLAC__VerifierFile *begin_file_(FLAC__Verifier *verifier, size_t index, const char *filename);
+static void split_file_(FLAC__Verifier *verifier, FLAC__VerifierFile *file, const FLAC__byte *data, size_t bytes);
+static FLAC__bool submit_task_(FLAC__Verifier *verifier, FLAC__VerifierFile *file, const FLAC__byte *data, size_t bytes, unsigned frames, unsigned max_blocksize);
+static void hash_tasks_(FLAC__Verifier *verifier, FLAC__VerifierFile *file, std::unique_lock<std::mutex> &lock);
+static void decode_task_(FLAC__VerifierWorker *worker, FLAC__VerifierTask *task);
+static void hash_task_(FLAC__VerifierTask *task);
+static void finish_file_(FLAC__Verifier *verifier, FLAC__VerifierFile *file);
+static FLAC__bool grow_task_audio_(FLAC__VerifierTask *task, size_t bytes);
+
+/***********************************************************************
+ *
+ * Public static class data
+ *
+ ***********************************************************************/
+
+FLAC_API const char * const FLAC__VerifyStatusString[] = {
+    "FLAC__VERIFY_OK",
+    "FLAC__VERIFY_FRAME_ERROR",
+    "FLAC__VERIFY_MD5_MISMATCH",
+    "FLAC__VERIFY_SAMPLE_COUNT_MISMATCH",
+    "FLAC__VERIFY_NOT_FLAC",
+    "FLAC__VERIFY_IO_ERROR",
+    "FLAC__VERIFY_MEMORY_ALLOCATION_ERROR"
+};
+
+/***********************************************************************
+ *
+ * Single streams
+ *
+ ***********************************************************************/
+
+FLAC_API FLAC__bool FLAC__verify_file(const char *filename, FLAC__VerifyResult *result)
+{
+    FLAC__Verifier *verifier;
+    FLAC__bool ok;
+
+    FLAC_ASSERT(0 != filename);
+    FLAC_ASSERT(0 != result);
+
+    verifier = FLAC__verifier_new();
+    if (verifier == 0) {
+        memset(result, 0, sizeof(*result));
+        result->status = FLAC__VERIFY_MEMORY_ALLOCATION_ERROR;
+        return false;
+    }
+    (void)FLAC__verifier_set_num_threads(verifier, 1);
+    ok = FLAC__verifier_verify_files(verifier, &filename, 1, result, /*callback=*/0, /*client_data=*/0);
+    FLAC__verifier_delete(verifier);
+    return ok;
+}
+
+FLAC_API FLAC__bool FLAC__verify_memory(const FLAC__byte *data, size_t bytes, FLAC__VerifyResult *result)
+{
+    FLAC__Verifier *verifier;
+    FLAC__VerifierFile *file;
+    FLAC__bool ok;
+
+    FLAC_ASSERT(0 != data || bytes == 0);
+    FLAC_ASSERT(0 != result);
+
+    memset(result, 0, sizeof(*result));
+    verifier = FLAC__verifier_new();
+    if (verifier == 0 || !start_run_(verifier, /*num_threads=*/1, result, /*callback=*/0, /*client_data=*/0)) {
+        FLAC__verifier_delete(verifier);
+        result->status = FLAC__VERIFY_MEMORY_ALLOCATION_ERROR;
+        return false;
+    }
+
+    file = begin_file_(verifier, 0, /*filename=*/0);
+    split_file_(verifier, file, data, bytes);
+
+    finish_run_(verifier);
+    ok = verifier->all_ok;
+    FLAC__verifier_delete(verifier);
+    return ok;
+}
+
+/***********************************************************************
+ *
+ * Verifier
+ *
+ ***********************************************************************/
+
+FLAC_API FLAC__Verifier *FLAC__verifier_new(void)
+{
+    FLAC__Verifier *verifier;
+
+    verifier = (FLAC__Verifier*)calloc(1, sizeof(FLAC__Verifier));
+    if (verifier == 0)
+        return 0;
+
+    verifier->iterator = FLAC__frame_span_iterator_new();
+    if (verifier->iterator == 0) {
+        free(verifier);
+        return 0;
+    }
+    verifier->num_threads = 0;
+
+    return verifier;
+}
+
+FLAC_API void FLAC__verifier_delete(FLAC__Verifier *verifier)
+{
+    if (verifier == 0)
+        return;
+
+    FLAC__frame_span_iterator_delete(verifier->iterator);
+    free(verifier);
+}
+
+FLAC_API FLAC__bool FLAC__verifier_set_num_threads(FLAC__Verifier *verifier, unsigned value)
+{
+    FLAC_ASSERT(0 != verifier);
+
+    if (value > FLAC__VERIFIER_MAX_THREADS)
+        return false;
+    verifier->num_threads = value;
+    return true;
+}
+
+FLAC_API FLAC__bool FLAC__verifier_verify_files(FLAC__Verifier *verifier, const char * const filenames[], size_t num_files, FLAC__VerifyResult results[], FLAC__VerifierCallback callback, void *client_data)
+{
+    FLAC__VerifierFile *file;
+    FLAC__MappedFile *mapping;
+    unsigned num_threads;
+    size_t i;
+
+    FLAC_ASSERT(0 != verifier);
+    FLAC_ASSERT(0 != filenames || num_files == 0);
+
+    num_threads = verifier->num_threads;
+    if (num_threads == 0) {
+        num_threads = std::thread::hardware_concurrency();
+        if (num_threads == 0)
+            num_threads = 1;
+        num_threads = flac_min(num_threads, FLAC__VERIFIER_MAX_THREADS);
+    }
+
+    if (!start_run_(verifier, num_threads, results, callback, client_data)) {
+        for (i = 0; results != 0 && i < num_files; i++) {
+            memset(&results[i], 0, sizeof(results[i]));
+            results[i].status = FLAC__VERIFY_MEMORY_ALLOCATION_ERROR;
+        }
+        return num_files == 0;
+    }
+
+    /* the reader: this thread maps every file and cuts it into segments for the workers */
+    for (i = 0; i < num_files; i++) {
+        file = begin_file_(verifier, i, filenames[i]);
+        mapping = FLAC__mapped_file_open(filenames[i], FLAC__MAPPED_FILE_ACCESS_SEQUENTIAL);
+        if (mapping == 0) {
+            file->status = FLAC__VERIFY_IO_ERROR;
+            split_file_(verifier, file, 0, 0);
+            continue;
+        }
+        file->mapping = mapping;
+        split_file_(verifier, file, FLAC__mapped_file_get_data(mapping), FLAC__mapped_file_get_size(mapping));
+    }
+
+    finish_run_(verifier);
+    return verifier->all_ok;
+}
+
+/***********************************************************************
+ *
+ * Private class methods
+ *
+ ***********************************************************************/
+
+/*
+ * Allocates the tasks, the file slots and the workers' decoders for a
+ * run and starts the threads. A file only holds its slot while it has
+ * tasks in flight, so one slot more than there are tasks is enough.
+ */
+FLAC__bool start_run_(FLAC__Verifier *verifier, unsigned num_threads, FLAC__VerifyResult *results, FLAC__VerifierCallback callback, void *client_data)
+{
+    unsigned i;
+
+    verifier->results = results;
+    verifier->callback = callback;
+    verifier->client_data = client_data;
+    verifier->all_ok = true;
+    verifier->fill_task = 0;
+    verifier->pool = 0;
+
+    verifier->num_workers = num_threads;
+    verifier->num_tasks = num_threads > 1 ? num_threads * FLAC__VERIFIER_TASKS_PER_THREAD : 1;
+    verifier->num_files = verifier->num_tasks + 1;
+    verifier->workers = (FLAC__VerifierWorker*)calloc(verifier->num_workers, sizeof(FLAC__VerifierWorker));
+    verifier->tasks = (FLAC__VerifierTask*)calloc(verifier->num_tasks, sizeof(FLAC__VerifierTask));
+    verifier->files = (FLAC__VerifierFile*)calloc(verifier->num_files, sizeof(FLAC__VerifierFile));
+    if (verifier->workers == 0 || verifier->tasks == 0 || verifier->files == 0) {
+        finish_run_(verifier);
+        return false;
+    }
+    for (i = 0; i < verifier->num_workers; i++) {
+        verifier->workers[i].decoder = FLAC__stream_decoder_new();
+        if (verifier->workers[i].decoder == 0) {
+            finish_run_(verifier);
+            return false;
+        }
+    }
+
+    if (num_threads > 1 && !start_threads_(verifier)) {
+        finish_run_(verifier);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Waits for the files still in flight, stops the threads and frees what
+ * start_run_() allocated; also cleans up after a start_run_() that failed
+ * half way.
+ */
+void finish_run_(FLAC__Verifier *verifier)
+{
+    unsigned i, channel;
+
+    stop_threads_(verifier);
+
+    if (verifier->workers != 0) {
+        for (i = 0; i < verifier->num_workers; i++) {
+            FLAC__stream_decoder_delete(verifier->workers[i].decoder);
+            for (channel = 0; channel < FLAC__MAX_CHANNELS; channel++)
+                free(verifier->workers[i].signal[channel]);
+        }
+        free(verifier->workers);
+        verifier->workers = 0;
+    }
+    if (verifier->tasks != 0) {
+        for (i = 0; i < verifier->num_tasks; i++)
+            free(verifier->tasks[i].audio);
+        free(verifier->tasks);
+        verifier->tasks = 0;
+    }
+    free(verifier->files);
+    verifier->files = 0;
+}
+
+FLAC__bool start_threads_(FLAC__Verifier *verifier)
+{
+    unsigned i;
+
+    verifier->pool = new(std::nothrow) FLAC__VerifierPool();
+    if (verifier->pool == 0)
+        return false;
+    verifier->pool->next_queued = verifier->pool->num_queued = 0;
+    verifier->pool->shutdown = false;
+
+    try {
+        for (i = 0; i < verifier->num_workers; i++)
+            verifier->pool->threads.push_back(std::thread(worker_thread_, verifier, &verifier->workers[i]));
+    }
+    catch (const std::system_error &) {
+        stop_threads_(verifier);
+        return false;
+    }
+    catch (const std::bad_alloc &) {
+        stop_threads_(verifier);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Every task is finished by the time the queue runs dry, and the last
+ * one finished finishes its file, so joining the workers waits for all
+ * the files.
+ */
+void stop_threads_(FLAC__Verifier *verifier)
+{
+    FLAC__VerifierPool *pool = verifier->pool;
+    size_t i;
+
+    if (pool == 0)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->shutdown = true;
+    }
+    pool->work_available.notify_all();
+    for (i = 0; i < pool->threads.size(); i++)
+        pool->threads[i].join();
+    delete pool;
+    verifier->pool = 0;
+}
+
+void worker_thread_(FLAC__Verifier *verifier, FLAC__VerifierWorker *worker)
+{
+    FLAC__VerifierPool *pool = verifier->pool;
+    FLAC__VerifierTask *task;
+    std::unique_lock<std::mutex> lock(pool->mutex);
+
+    while (1) {
+        pool->work_available.wait(lock, [pool] { return pool->shutdown || pool->num_queued > 0; });
+        /* finish the queue before honoring a shutdown */
+        if (pool->num_queued == 0)
+            return;
+        task = &verifier->tasks[pool->next_queued];
+        pool->next_queued = (pool->next_queued + 1) % verifier->num_tasks;
+        pool->num_queued--;
+
+        lock.unlock();
+        decode_task_(worker, task);
+        lock.lock();
+
+        task->state = FLAC__VERIFIER_TASK_DECODED;
+        hash_tasks_(verifier, task->file, lock);
+    }
+}
+
+/*
+ * Takes a free file slot, waiting for one if every slot has a file in
+ * flight.
+ */
+FLAC__VerifierFile *begin_file_(FLAC__Verifier *verifier, size_t index, const char *filename)
+{
+    FLAC__VerifierPool *pool = verifier->pool;
+    FLAC__VerifierFile *file = 0;
+    unsigned i;
+
+    if (pool != 0) {
+        std::unique_lock<std::mutex> lock(pool->mutex);
+        while (1) {
+            for (i = 0; i < verifier->num_files && file == 0; i++) {
+                if (!verifier->files[i].in_use)
+                    file = &verifier->files[i];
+            }
+            if (file != 0)
+                break;
+            pool->task_done.wait(lock);
+        }
+        file->in_use = true;
+    }
+    else {
+        /* without threads every file is finished before the next one starts */
+        file = &verifier->files[0];
+        FLAC_ASSERT(!file->in_use);
+    }
+
+    memset(file, 0, sizeof(*file));
+    file->in_use = true;
+    file->index = index;
+    file->filename = filename;
+    file->status = FLAC__VERIFY_OK;
+    FLAC__MD5Init(&file->md5context);
+    return file;
+}
+
+/*
+ * The reader's part of a file. Walking the frame spans checks every
+ * frame's CRC-8 and CRC-16 without decoding, and runs through the file
+ * front to back, which is the order the mapping reads ahead in. Runs of
+ * good frames become tasks; a damaged frame or garbage between frames
+ * ends a run, so the decoders only ever see frames known to be intact.
+ */
+void split_file_(FLAC__Verifier *verifier, FLAC__VerifierFile *file, const FLAC__byte *data, size_t bytes)
+{
+    FLAC__FrameSpan span;
+    const FLAC__byte *start = 0, *end = 0;
+    unsigned frames = 0, max_blocksize = 0, bytes_per_sample;
+    size_t audio_bytes = 0;
+    FLAC__bool ok = true;
+
+    file->bytes = bytes;
+
+    if (file->status == FLAC__VERIFY_OK) {
+        if (!FLAC__frame_span_iterator_init(verifier->iterator, data, bytes) || FLAC__frame_span_iterator_get_stream_info(verifier->iterator) == 0)
+            file->status = FLAC__VERIFY_NOT_FLAC;
+        else
+            file->stream_info = *FLAC__frame_span_iterator_get_stream_info(verifier->iterator);
+    }
+
+    if (file->status == FLAC__VERIFY_OK) {
+        bytes_per_sample = (file->stream_info.bits_per_sample + 7) / 8;
+        while (ok && FLAC__frame_span_iterator_next(verifier->iterator, &span)) {
+            file->frames++;
+            if (!span.crc_ok || span.data != end) {
+                if (frames > 0)
+                    ok = submit_task_(verifier, file, start, (size_t)(end - start), frames, max_blocksize);
+                frames = 0;
+                max_blocksize = 0;
+                audio_bytes = 0;
+                if (!span.crc_ok) {
+                    file->crc_errors++;
+                    end = 0;
+                    continue;
+                }
+                start = span.data;
+            }
+            end = span.data + span.bytes;
+            frames++;
+            max_blocksize = flac_max(max_blocksize, span.header.blocksize);
+            audio_bytes += (size_t)span.header.blocksize * span.header.channels * bytes_per_sample;
+            if (audio_bytes >= FLAC__VERIFIER_SEGMENT_BYTES) {
+                ok = submit_task_(verifier, file, start, (size_t)(end - start), frames, max_blocksize);
+                frames = 0;
+                max_blocksize = 0;
+                audio_bytes = 0;
+                end = 0;
+            }
+        }
+        if (ok && frames > 0)
+            ok = submit_task_(verifier, file, start, (size_t)(end - start), frames, max_blocksize);
+    }
+
+    /* the last of the file's tasks to be hashed finishes it, unless they are all hashed already */
+    if (verifier->pool != 0) {
+        std::unique_lock<std::mutex> lock(verifier->pool->mutex);
+        file->split_done = true;
+        if (file->num_pending > 0 || file->hashing)
+            return;
+    }
+    else
+        file->split_done = true;
+    finish_file_(verifier, file);
+}
+
+/*
+ * Hands a segment over. Without worker threads it is decoded and hashed
+ * right here; otherwise it goes into the next slot of the ring, waiting
+ * for the slot to be free.
+ */
+FLAC__bool submit_task_(FLAC__Verifier *verifier, FLAC__VerifierFile *file, const FLAC__byte *data, size_t bytes, unsigned frames, unsigned max_blocksize)
+{
+    FLAC__VerifierPool *pool = verifier->pool;
+    FLAC__VerifierTask *task = &verifier->tasks[verifier->fill_task];
+
+    if (pool != 0) {
+        std::unique_lock<std::mutex> lock(pool->mutex);
+        pool->task_done.wait(lock, [task] { return task->state == FLAC__VERIFIER_TASK_EMPTY; });
+    }
+
+    task->file = file;
+    task->data = data;
+    task->bytes = bytes;
+    task->frames = frames;
+    task->max_blocksize = max_blocksize;
+
+    if (pool == 0) {
+        decode_task_(&verifier->workers[0], task);
+        hash_task_(task);
+        return !file->memory_error;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        if (file->num_pending == 0)
+            file->hash_task = verifier->fill_task;
+        task->seq = file->next_seq++;
+        file->num_pending++;
+        task->state = FLAC__VERIFIER_TASK_QUEUED;
+        pool->num_queued++;
+    }
+    pool->work_available.notify_one();
+    verifier->fill_task = (verifier->fill_task + 1) % verifier->num_tasks;
+    return true;
+}
+
+/*
+ * The MD5 of a file has to see its segments in order. Whichever worker
+ * finds the oldest unhashed segment of the file decoded takes the job
+ * and keeps hashing until it runs into one that is not decoded yet; the
+ * others go back to decoding. Different files are hashed at the same
+ * time. A file's segments sit next to each other in the ring, but the
+ * slot after the last one hashed may not have been filled yet, so it is
+ * checked to really be the file's next segment.
+ */
+void hash_tasks_(FLAC__Verifier *verifier, FLAC__VerifierFile *file, std::unique_lock<std::mutex> &lock)
+{
+    FLAC__VerifierPool *pool = verifier->pool;
+    FLAC__VerifierTask *task;
+
+    if (file->hashing)
+        return;
+    file->hashing = true;
+    while (file->num_pending > 0) {
+        task = &verifier->tasks[file->hash_task];
+        if (task->state != FLAC__VERIFIER_TASK_DECODED || task->file != file || task->seq != file->hash_seq)
+            break;
+        lock.unlock();
+        hash_task_(task);
+        lock.lock();
+        task->state = FLAC__VERIFIER_TASK_EMPTY;
+        file->hash_seq++;
+        file->hash_task = (file->hash_task + 1) % verifier->num_tasks;
+        file->num_pending--;
+        pool->task_done.notify_all();
+    }
+    file->hashing = false;
+
+    if (file->num_pending == 0 && file->split_done) {
+        lock.unlock();
+        finish_file_(verifier, file);
+        lock.lock();
+    }
+}
+
+void decode_task_(FLAC__VerifierWorker *worker, FLAC__VerifierTask *task)
+{
+    const FLAC__StreamMetadata_StreamInfo *stream_info = &task->file->stream_info;
+    FLAC__FrameHeader header;
+    unsigned channel;
+    size_t bytes;
+
+    task->audio_bytes = 0;
+    task->samples = 0;
+    task->decoded_frames = 0;
+    task->memory_error = false;
+
+    /* the frames passed their CRCs, so their headers are what the spans said */
+    if (worker->capacity < task->max_blocksize) {
+        for (channel = 0; channel < FLAC__MAX_CHANNELS; channel++) {
+            FLAC__int32 *signal = (FLAC__int32*)realloc(worker->signal[channel], sizeof(FLAC__int32) * task->max_blocksize);
+            if (signal == 0) {
+                task->memory_error = true;
+                return;
+            }
+            worker->signal[channel] = signal;
+        }
+        worker->capacity = task->max_blocksize;
+    }
+
+    if (FLAC__stream_decoder_init_memory_frames(worker->decoder, stream_info, task->data, task->bytes) != FLAC__STREAM_DECODER_INIT_STATUS_OK) {
+        (void)FLAC__stream_decoder_finish(worker->decoder);
+        task->memory_error = true;
+        return;
+    }
+    while (FLAC__stream_decoder_decode_frame(worker->decoder, worker->signal, worker->capacity, &header)) {
+        bytes = (size_t)header.blocksize * header.channels * ((header.bits_per_sample + 7) / 8);
+        if (!grow_task_audio_(task, task->audio_bytes + bytes)) {
+            task->memory_error = true;
+            break;
+        }
+        FLAC__MD5FormatInput(task->audio + task->audio_bytes, worker->signal, header.channels, header.blocksize, (header.bits_per_sample + 7) / 8);
+        task->audio_bytes += bytes;
+        task->samples += header.blocksize;
+        task->decoded_frames++;
+    }
+    if (FLAC__stream_decoder_get_state(worker->decoder) == FLAC__STREAM_DECODER_MEMORY_ALLOCATION_ERROR)
+        task->memory_error = true;
+    (void)FLAC__stream_decoder_finish(worker->decoder);
+}
+
+/* only ever called by the one thread hashing the task's file */
+void hash_task_(FLAC__VerifierTask *task)
+{
+    FLAC__VerifierFile *file = task->file;
+
+    FLAC__MD5Update(&file->md5context, task->audio, task->audio_bytes);
+    file->samples += task->samples;
+    /* a frame with good CRCs can still fail to decode, e.g. a reserved subframe type */
+    if (task->decoded_frames < task->frames)
+        file->decode_errors += task->frames - task->decoded_frames;
+    if (task->memory_error)
+        file->memory_error = true;
+}
+
+/*
+ * Called once all of the file's tasks are hashed; gives the verdict and
+ * frees the slot.
+ */
+void finish_file_(FLAC__Verifier *verifier, FLAC__VerifierFile *file)
+{
+    static const FLAC__byte no_md5[16] = { 0 };
+    FLAC__VerifyResult result;
+    FLAC__byte digest[16];
+
+    FLAC__MD5Final(digest, &file->md5context);
+
+    memset(&result, 0, sizeof(result));
+    result.frames = file->frames;
+    result.bad_frames = file->crc_errors + file->decode_errors;
+    result.samples = file->samples;
+    result.bytes = file->bytes;
+    result.md5_checked = file->status == FLAC__VERIFY_OK && memcmp(file->stream_info.md5sum, no_md5, 16) != 0;
+
+    if (file->status != FLAC__VERIFY_OK)
+        result.status = file->status;
+    else if (file->memory_error)
+        result.status = FLAC__VERIFY_MEMORY_ALLOCATION_ERROR;
+    else if (result.bad_frames > 0)
+        result.status = FLAC__VERIFY_FRAME_ERROR;
+    else if (file->stream_info.total_samples > 0 && result.samples != file->stream_info.total_samples)
+        result.status = FLAC__VERIFY_SAMPLE_COUNT_MISMATCH;
+    else if (result.md5_checked && memcmp(digest, file->stream_info.md5sum, 16) != 0)
+        result.status = FLAC__VERIFY_MD5_MISMATCH;
+    else
+        result.status = FLAC__VERIFY_OK;
+
+    FLAC__mapped_file_close(file->mapping);
+    file->mapping = 0;
+
+    {
+        /* files finish on any thread */
+        std::unique_lock<std::mutex> lock;
+        if (verifier->pool != 0)
+            lock = std::unique_lock<std::mutex>(verifier->pool->callback_mutex);
+        if (verifier->results != 0)
+            verifier->results[file->index] = result;
+        if (verifier->callback != 0)
+            verifier->callback(file->filename, file->index, &result, verifier->client_data);
+        if (result.status != FLAC__VERIFY_OK)
+            verifier->all_ok = false;
+    }
+
+    if (verifier->pool != 0) {
+        std::lock_guard<std::mutex> lock(verifier->pool->mutex);
+        file->in_use = false;
+        verifier->pool->task_done.notify_all();
+    }
+    else
+        file->in_use = false;
+}
+
+FLAC__bool grow_task_audio_(FLAC__VerifierTask *task, size_t bytes)
+{
+    FLAC__byte *audio;
+
+    if (bytes <= task->audio_capacity)
+        return true;
+    /* segments are cut at about the same size, so this settles quickly */
+    bytes = flac_max(bytes, task->audio_capacity * 2);
+    audio = (FLAC__byte*)realloc(task->audio, bytes);
+    if (audio == 0)
+        return false;
+    task->audio = audio;
+    task->audio_capacity = bytes;
+    return true;
+}
@@ -0,0 +1,46 @@
+#include <math.h>
+#include "private/window.h"
+#include "FLAC/assert.h"
+
+#ifndef M_PI
+/* math.h in VC++ doesn't seem to have this (how Microsoft is that?) */
+#define M_PI 3.14159265358979323846
+#endif
+
+void FLAC__window_rectangle(FLAC__real *window, const FLAC__int32 L)
+{
+    FLAC__int32 n;
+
+    for (n = 0; n < L; n++)
+        window[n] = 1.0f;
+}
+
+void FLAC__window_hann(FLAC__real *window, const FLAC__int32 L)
+{
+    const FLAC__int32 N = L - 1;
+    FLAC__int32 n;
+
+    for (n = 0; n < L; n++)
+        window[n] = (FLAC__real)(0.5f - 0.5f * cos(2.0f * M_PI * n / N));
+}
+
+void FLAC__window_tukey(FLAC__real *window, const FLAC__int32 L, const FLAC__real p)
+{
+    if (p <= 0.0)
+        FLAC__window_rectangle(window, L);
+    else if (p >= 1.0)
+        FLAC__window_hann(window, L);
+    else {
+        const FLAC__int32 Np = (FLAC__int32)(p / 2.0f * L) - 1;
+        FLAC__int32 n;
+        /* start with rectangle... */
+        FLAC__window_rectangle(window, L);
+        /* ...replace ends with hann */
+        if (Np > 0) {
+            for (n = 0; n <= Np; n++) {
+                window[n] = (FLAC__real)(0.5f - 0.5f * cos(M_PI * n / Np));
+                window[L - Np - 1 + n] = (FLAC__real)(0.5f - 0.5f * cos(M_PI * (n + Np) / Np));
+            }
+        }
+    }
+}